@@ -11,6 +11,11 @@
 //
 
 #include "pdfio-private.h"
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#  include <immintrin.h>
+#  define HAVE_AESNI 1			// Use AES-NI instructions when available
+#  define AESNI_TARGET __attribute__((target("aes,sse2")))
+#endif // __GNUC__ && (__x86_64__ || __i386__)
 
 
 //
@@ -88,6 +93,10 @@ static void	InvShiftRows(state_t *state);
 static void	Cipher(state_t *state, const _pdfio_aes_t *ctx);
 static void	InvCipher(state_t *state, const _pdfio_aes_t *ctx);
 static void	XorWithIv(uint8_t *buf, const uint8_t *Iv);
+#ifdef HAVE_AESNI
+static size_t	aesni_decrypt(_pdfio_aes_t *ctx, uint8_t *outbuffer, const uint8_t *inbuffer, size_t len) AESNI_TARGET;
+static size_t	aesni_encrypt(_pdfio_aes_t *ctx, uint8_t *outbuffer, const uint8_t *inbuffer, size_t len) AESNI_TARGET;
+#endif // HAVE_AESNI
 
 
 //
@@ -177,6 +186,12 @@ _pdfioCryptoAESDecrypt(
   size_t	outbytes = 0;		// Output bytes
 
 
+#ifdef HAVE_AESNI
+  // Use the AES-NI instructions when the CPU supports them...
+  if (_pdfio_crypto_accel && __builtin_cpu_supports("aes"))
+    return (aesni_decrypt(ctx, outbuffer, inbuffer, len));
+#endif // HAVE_AESNI
+
   if (inbuffer != outbuffer)
   {
     // Not the most efficient, but we can optimize later - the sample AES code
@@ -221,6 +236,12 @@ _pdfioCryptoAESEncrypt(
   if (len == 0)
     return (0);
 
+#ifdef HAVE_AESNI
+  // Use the AES-NI instructions when the CPU supports them...
+  if (_pdfio_crypto_accel && __builtin_cpu_supports("aes"))
+    return (aesni_encrypt(ctx, outbuffer, inbuffer, len));
+#endif // HAVE_AESNI
+
   if (inbuffer != outbuffer)
   {
     // Not the most efficient, but we can optimize later - the sample AES code
@@ -517,3 +538,121 @@ XorWithIv(uint8_t *buf, const uint8_t *Iv)
   *buf++ ^= *Iv++;
   *buf++ ^= *Iv++;
 }
+
+
+#ifdef HAVE_AESNI
+//
+// 'aesni_decrypt()' - Decrypt a block of bytes with AES-NI.
+//
+// The decryption round keys are derived from the encryption round keys using
+// the AESIMC instruction ("equivalent inverse cipher").  Each input block is
+// loaded before the output is stored, so the buffers can overlap.
+//
+
+static size_t				// O - Number of bytes in output buffer
+aesni_decrypt(
+    _pdfio_aes_t  *ctx,			// I - AES context
+    uint8_t       *outbuffer,		// I - Output buffer
+    const uint8_t *inbuffer,		// I - Input buffer
+    size_t        len)			// I - Number of bytes to decrypt
+{
+  size_t	i,			// Looping var
+		rounds = ctx->round_size,
+					// Number of rounds
+		outbytes = 0;		// Output bytes
+  __m128i	rk[15],			// Decryption round keys
+		iv,			// Current IV
+		next_iv,		// Next IV
+		block;			// Current block
+
+
+  rk[0] = _mm_loadu_si128((const __m128i *)(ctx->round_key + 16 * rounds));
+  for (i = 1; i < rounds; i ++)
+    rk[i] = _mm_aesimc_si128(_mm_loadu_si128((const __m128i *)(ctx->round_key + 16 * (rounds - i))));
+  rk[rounds] = _mm_loadu_si128((const __m128i *)ctx->round_key);
+
+  iv = _mm_loadu_si128((const __m128i *)ctx->iv);
+
+  while (len > 15)
+  {
+    next_iv = _mm_loadu_si128((const __m128i *)inbuffer);
+    block   = _mm_xor_si128(next_iv, rk[0]);
+
+    for (i = 1; i < rounds; i ++)
+      block = _mm_aesdec_si128(block, rk[i]);
+
+    block = _mm_aesdeclast_si128(block, rk[rounds]);
+
+    _mm_storeu_si128((__m128i *)outbuffer, _mm_xor_si128(block, iv));
+
+    iv        = next_iv;
+    inbuffer  += 16;
+    outbuffer += 16;
+    len       -= 16;
+    outbytes  += 16;
+  }
+
+  _mm_storeu_si128((__m128i *)ctx->iv, iv);
+
+  return (outbytes);
+}
+
+
+//
+// 'aesni_encrypt()' - Encrypt a block of bytes with AES-NI.
+//
+
+static size_t				// O - Number of bytes in output buffer
+aesni_encrypt(
+    _pdfio_aes_t  *ctx,			// I - AES context
+    uint8_t       *outbuffer,		// I - Output buffer
+    const uint8_t *inbuffer,		// I - Input buffer
+    size_t        len)			// I - Number of bytes to encrypt
+{
+  size_t	i,			// Looping var
+		rounds = ctx->round_size,
+					// Number of rounds
+		outbytes = 0;		// Output bytes
+  __m128i	rk[15],			// Encryption round keys
+		block;			// Current block/IV
+  uint8_t	temp[16];		// Padded final block
+
+
+  for (i = 0; i <= rounds; i ++)
+    rk[i] = _mm_loadu_si128((const __m128i *)(ctx->round_key + 16 * i));
+
+  block = _mm_loadu_si128((const __m128i *)ctx->iv);
+
+  while (len > 0)
+  {
+    if (len < 16)
+    {
+      // Pad the final buffer with (16 - len)...
+      memcpy(temp, inbuffer, len);
+      memset(temp + len, (int)(16 - len), 16 - len);
+
+      inbuffer = temp;
+      len      = 16;
+    }
+
+    block = _mm_xor_si128(block, _mm_loadu_si128((const __m128i *)inbuffer));
+    block = _mm_xor_si128(block, rk[0]);
+
+    for (i = 1; i < rounds; i ++)
+      block = _mm_aesenc_si128(block, rk[i]);
+
+    block = _mm_aesenclast_si128(block, rk[rounds]);
+
+    _mm_storeu_si128((__m128i *)outbuffer, block);
+
+    inbuffer  += 16;
+    outbuffer += 16;
+    len       -= 16;
+    outbytes  += 16;
+  }
+
+  _mm_storeu_si128((__m128i *)ctx->iv, block);
+
+  return (outbytes);
+}
+#endif // HAVE_AESNI
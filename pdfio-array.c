@@ -62,7 +62,7 @@ pdfioArrayAppendBinary(
   v.type                 = PDFIO_VALTYPE_BINARY;
   v.value.binary.datalen = valuelen;
 
-  if ((v.value.binary.data = (unsigned char *)malloc(valuelen)) == NULL)
+  if ((v.value.binary.data = (unsigned char *)_pdfioFileAlloc(a->pdf, valuelen)) == NULL)
   {
     _pdfioFileError(a->pdf, "Unable to allocate memory for binary string - %s", strerror(errno));
     return (false);
@@ -70,13 +70,7 @@ pdfioArrayAppendBinary(
 
   memcpy(v.value.binary.data, value, valuelen);
 
-  if (!append_value(a, &v))
-  {
-    free(v.value.binary.data);
-    return (false);
-  }
-
-  return (true);
+  return (append_value(a, &v));
 }
 
 //
@@ -269,7 +263,7 @@ pdfioArrayCopy(pdfio_file_t  *pdf,	// I - PDF file
     return (NULL);
 
   // Pre-allocate the values array to make this a little faster...
-  if ((na->values = (_pdfio_value_t *)malloc(a->num_values * sizeof(_pdfio_value_t))) == NULL)
+  if ((na->values = (_pdfio_value_t *)_pdfioFileAlloc(pdf, a->num_values * sizeof(_pdfio_value_t))) == NULL)
     return (NULL);			// Let pdfioFileClose do the cleanup...
 
   na->alloc_values = a->num_values;
@@ -302,27 +296,11 @@ pdfioArrayCreate(pdfio_file_t *pdf)	// I - PDF file
   if (!pdf)
     return (NULL);
 
-  if ((a = (pdfio_array_t *)calloc(1, sizeof(pdfio_array_t))) == NULL)
+  if ((a = (pdfio_array_t *)_pdfioFileAlloc(pdf, sizeof(pdfio_array_t))) == NULL)
     return (NULL);
 
   a->pdf = pdf;
 
-  if (pdf->num_arrays >= pdf->alloc_arrays)
-  {
-    pdfio_array_t **temp = realloc(pdf->arrays, (pdf->alloc_arrays + 16) * sizeof(pdfio_array_t *));
-
-    if (!temp)
-    {
-      free(a);
-      return (NULL);
-    }
-
-    pdf->arrays       = temp;
-    pdf->alloc_arrays += 16;
-  }
-
-  pdf->arrays[pdf->num_arrays ++] = a;
-
   return (a);
 }
 
@@ -373,27 +351,6 @@ _pdfioArrayDebug(pdfio_array_t *a,	// I - Array
 }
 
 
-//
-// '_pdfioArrayDelete()' - Free the memory used by an array.
-//
-
-void
-_pdfioArrayDelete(pdfio_array_t *a)	// I - Array
-{
-  size_t	i;			// Looping var
-
-
-  for (i = 0; i < a->num_values; i ++)
-  {
-    if (a->values[i].type == PDFIO_VALTYPE_BINARY)
-      free(a->values[i].value.binary.data);
-  }
-
-  free(a->values);
-  free(a);
-}
-
-
 //
 // 'pdfioArrayGetArray()' - Get an array value from an array.
 //
@@ -648,9 +605,6 @@ pdfioArrayRemove(pdfio_array_t *a,	// I - Array
   if (!a || n >= a->num_values)
     return (false);
 
-  if (a->values[n].type == PDFIO_VALTYPE_BINARY)
-    free(a->values[n].value.binary.data);
-
   a->num_values --;
   if (n < a->num_values)
     memmove(a->values + n, a->values + n + 1, (a->num_values - n) * sizeof(_pdfio_value_t));
@@ -691,6 +645,9 @@ _pdfioArrayWrite(pdfio_array_t *a,	// I - Array
 //
 // 'append_value()' - Append a value.
 //
+// The values array is allocated from the PDF file's memory blocks and doubles
+// in size as needed.
+//
 
 static bool				// O - `true` on success, `false` otherwise
 append_value(pdfio_array_t  *a,		// I - Array
@@ -698,13 +655,21 @@ append_value(pdfio_array_t  *a,		// I - Array
 {
   if (a->num_values >= a->alloc_values)
   {
-    _pdfio_value_t *temp = (_pdfio_value_t *)realloc(a->values, (a->alloc_values + 16) * sizeof(_pdfio_value_t));
+    size_t	alloc_values = a->alloc_values ? 2 * a->alloc_values : 16;
+					// New number of values
+    _pdfio_value_t *temp = (_pdfio_value_t *)_pdfioFileAlloc(a->pdf, alloc_values * sizeof(_pdfio_value_t));
+					// New values array
 
     if (!temp)
       return (false);
 
+    if (a->num_values > 0)
+      memcpy(temp, a->values, a->num_values * sizeof(_pdfio_value_t));
+
+    _pdfioFileFree(a->pdf, a->values);
+
     a->values       = temp;
-    a->alloc_values += 16;
+    a->alloc_values = alloc_values;
   }
 
   a->values[a->num_values ++] = *v;
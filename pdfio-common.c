@@ -14,11 +14,60 @@
 // Local functions...
 //
 
+static bool	cache_fetch(pdfio_file_t *pdf, off_t offset, size_t count);
+static _pdfio_cblock_t *cache_find(_pdfio_cache_t *cache, off_t offset);
+static ssize_t	cache_read(pdfio_file_t *pdf, off_t offset, void *buffer, size_t bytes);
 static bool	fill_buffer(pdfio_file_t *pdf);
 static ssize_t	read_buffer(pdfio_file_t *pdf, char *buffer, size_t bytes);
 static bool	write_buffer(pdfio_file_t *pdf, const void *buffer, size_t bytes);
 
 
+//
+// '_pdfioFileBeginRead()' - Start reading existing data from a PDF file being updated.
+//
+// When appending an incremental update, the file buffer is normally used for
+// writing.  This function writes any buffered data and switches the buffer to
+// reading until `_pdfioFileEndRead` is called.  Nothing is done (and
+// `false` is returned) if the file is not being updated or is already being
+// read.
+//
+
+bool					// O - `true` if switched to reading, `false` otherwise
+_pdfioFileBeginRead(pdfio_file_t *pdf)	// I - PDF file
+{
+  if (!pdf->update || pdf->mode == _PDFIO_MODE_READ || !_pdfioFileFlush(pdf))
+    return (false);
+
+  pdf->update_pos = pdf->bufpos;
+  pdf->mode       = _PDFIO_MODE_READ;
+  pdf->bufptr     = NULL;
+  pdf->bufend     = NULL;
+
+  return (true);
+}
+
+
+//
+// '_pdfioFileBeginSpool()' - Start writing to the spool buffer.
+//
+// Data written after this call is appended to the spool buffer instead of the
+// PDF file, and `_pdfioFileTell` returns the offset within the spool buffer.
+//
+
+bool					// O - `true` on success, `false` on failure
+_pdfioFileBeginSpool(pdfio_file_t *pdf)	// I - PDF file
+{
+  if (pdf->spooling || !_pdfioFileFlush(pdf))
+    return (false);
+
+  pdf->spooling     = true;
+  pdf->spool_bufpos = pdf->bufpos;
+  pdf->bufpos       = (off_t)pdf->spoollen;
+
+  return (true);
+}
+
+
 //
 // '_pdfioFileConsume()' - Consume bytes from the file.
 //
@@ -40,11 +89,45 @@ _pdfioFileConsume(pdfio_file_t *pdf,	// I - PDF file
 }
 
 
+//
+// '_pdfioFileCreateCache()' - Create the block cache for an input callback.
+//
+
+bool					// O - `true` on success, `false` on failure
+_pdfioFileCreateCache(pdfio_file_t *pdf)// I - PDF file
+{
+  _pdfio_cache_t	*cache;		// Block cache
+  size_t		i;		// Looping var
+
+
+  if ((cache = (_pdfio_cache_t *)calloc(1, sizeof(_pdfio_cache_t))) == NULL)
+  {
+    _pdfioFileError(pdf, "Unable to allocate memory for input cache.");
+    return (false);
+  }
+
+  for (i = 0; i < _PDFIO_CACHE_BLOCKS; i ++)
+    cache->blocks[i].offset = -1;
+
+  cache->next_offset = -1;
+
+#ifdef _WIN32
+  InitializeCriticalSection(&cache->mutex);
+#else
+  pthread_mutex_init(&cache->mutex, NULL);
+#endif // _WIN32
+
+  pdf->cache = cache;
+
+  return (true);
+}
+
+
 //
 // '_pdfioFileDefaultError()' - Default error callback.
 //
 // The default error callback writes the error message to stderr and returns
-// `false` to halt.
+// `false` to halt.  The "pdf" argument is `NULL` for font errors.
 //
 
 bool					// O - `false` to stop
@@ -55,7 +138,10 @@ _pdfioFileDefaultError(
 {
   (void)data;
 
-  fprintf(stderr, "%s: %s\n", pdf->filename, message);
+  if (pdf)
+    fprintf(stderr, "%s: %s\n", pdf->filename, message);
+  else
+    fprintf(stderr, "pdfio: %s\n", message);
 
   return (false);
 }
@@ -84,6 +170,79 @@ _pdfioFileError(pdfio_file_t *pdf,	// I - PDF file
 }
 
 
+//
+// '_pdfioFileDeleteCache()' - Free the block cache for an input callback.
+//
+
+void
+_pdfioFileDeleteCache(pdfio_file_t *pdf)// I - PDF file
+{
+  _pdfio_cache_t	*cache = pdf->cache;
+					// Block cache
+  size_t		i;		// Looping var
+
+
+  if (!cache)
+    return;
+
+  for (i = 0; i < _PDFIO_CACHE_BLOCKS; i ++)
+    free(cache->blocks[i].data);
+
+  free(cache->run);
+
+#ifdef _WIN32
+  DeleteCriticalSection(&cache->mutex);
+#else
+  pthread_mutex_destroy(&cache->mutex);
+#endif // _WIN32
+
+  free(cache);
+
+  pdf->cache = NULL;
+}
+
+
+//
+// '_pdfioFileEndRead()' - Stop reading existing data from a PDF file being updated.
+//
+
+void
+_pdfioFileEndRead(pdfio_file_t *pdf)	// I - PDF file
+{
+  // Restore the write position at the end of the file...
+  if (lseek(pdf->fd, pdf->update_pos, SEEK_SET) < 0)
+    _pdfioFileError(pdf, "Unable to seek within file - %s", strerror(errno));
+
+  pdf->mode   = _PDFIO_MODE_WRITE;
+  pdf->buffer = pdf->localbuf;
+  pdf->bufptr = pdf->buffer;
+  pdf->bufend = pdf->buffer + sizeof(pdf->localbuf);
+  pdf->bufpos = pdf->update_pos;
+}
+
+
+//
+// '_pdfioFileEndSpool()' - Stop writing to the spool buffer.
+//
+
+bool					// O - `true` on success, `false` on failure
+_pdfioFileEndSpool(pdfio_file_t *pdf)	// I - PDF file
+{
+  bool	ret;				// Return value
+
+
+  if (!pdf->spooling)
+    return (false);
+
+  ret = _pdfioFileFlush(pdf);
+
+  pdf->spooling = false;
+  pdf->bufpos   = pdf->spool_bufpos;
+
+  return (ret);
+}
+
+
 //
 // '_pdfioFileFlush()' - Flush any pending write data.
 //
@@ -188,6 +347,28 @@ _pdfioFileGets(pdfio_file_t *pdf,	// I - PDF file
 }
 
 
+//
+// '_pdfioFileLock()' - Lock the shared state of a PDF file.
+//
+// This function does nothing unless concurrent reading has been enabled with
+// @link pdfioFileSetConcurrent@.  Locks are recursive, so a thread that holds
+// the lock can lock it again.
+//
+
+void
+_pdfioFileLock(pdfio_file_t *pdf)	// I - PDF file
+{
+  if (!pdf->concurrent)
+    return;
+
+#ifdef _WIN32
+  EnterCriticalSection(&pdf->mutex);
+#else
+  pthread_mutex_lock(&pdf->mutex);
+#endif // _WIN32
+}
+
+
 //
 // '_pdfioFilePeek()' - Peek at upcoming data in a PDF file.
 //
@@ -208,7 +389,7 @@ _pdfioFilePeek(pdfio_file_t *pdf,	// I - PDF file
       return (-1);
   }
 
-  if ((total = pdf->bufend - pdf->bufptr) < (ssize_t)bytes && total < (ssize_t)(sizeof(pdf->buffer) / 2))
+  if ((total = pdf->bufend - pdf->bufptr) < (ssize_t)bytes && total < (ssize_t)(sizeof(pdf->localbuf) / 2) && !pdf->memdata)
   {
     // Yes, try reading more...
     ssize_t	rbytes;			// Bytes read
@@ -221,13 +402,7 @@ _pdfioFilePeek(pdfio_file_t *pdf,	// I - PDF file
     pdf->bufend = pdf->buffer + total;
 
     // Read until we have bytes or a non-recoverable error...
-    while ((rbytes = read(pdf->fd, pdf->bufend, sizeof(pdf->buffer) - (size_t)total)) < 0)
-    {
-      if (errno != EINTR && errno != EAGAIN)
-	break;
-    }
-
-    if (rbytes > 0)
+    if ((rbytes = read_buffer(pdf, pdf->bufend, sizeof(pdf->localbuf) - (size_t)total)) > 0)
     {
       // Expand the buffer...
       pdf->bufend += rbytes;
@@ -246,6 +421,83 @@ _pdfioFilePeek(pdfio_file_t *pdf,	// I - PDF file
 }
 
 
+//
+// '_pdfioFilePrefetch()' - Speculatively read data from an input callback.
+//
+// This function fetches any data in the specified range that is not already
+// in the block cache, using as few calls to the input callback as possible.
+// Nothing is done for files that are not read using an input callback.
+//
+
+void
+_pdfioFilePrefetch(pdfio_file_t *pdf,	// I - PDF file
+                   off_t        offset,	// I - Offset from beginning of file
+                   size_t       bytes)	// I - Number of bytes
+{
+  _pdfio_cache_t	*cache = pdf->cache;
+					// Block cache
+  _pdfio_cblock_t	*block;		// Current block
+  off_t			end,		// End of range
+			first;		// First missing block in run
+  size_t		count;		// Number of missing blocks in run
+
+
+  if (!cache || offset < 0 || offset >= pdf->input_size)
+    return;
+
+  // Limit the prefetch to half of the cache so it doesn't push out the data
+  // being read...
+  if (bytes > (_PDFIO_CACHE_BLOCKS / 2 * _PDFIO_CACHE_BLOCK))
+    bytes = _PDFIO_CACHE_BLOCKS / 2 * _PDFIO_CACHE_BLOCK;
+
+  if ((end = offset + (off_t)bytes) > pdf->input_size)
+    end = pdf->input_size;
+
+  PDFIO_DEBUG("_pdfioFilePrefetch(pdf=%p, offset=%ld, bytes=%lu)\n", pdf, (long)offset, (unsigned long)bytes);
+
+#ifdef _WIN32
+  EnterCriticalSection(&cache->mutex);
+#else
+  pthread_mutex_lock(&cache->mutex);
+#endif // _WIN32
+
+  // Fetch each run of missing blocks...
+  for (offset -= offset % _PDFIO_CACHE_BLOCK, first = -1, count = 0; offset < end; offset += _PDFIO_CACHE_BLOCK)
+  {
+    if ((block = cache_find(cache, offset)) != NULL)
+    {
+      block->used = ++ cache->counter;
+
+      if (count && !cache_fetch(pdf, first, count))
+        break;
+
+      count = 0;
+    }
+    else if (count == 0)
+    {
+      first = offset;
+      count = 1;
+    }
+    else if (++ count == _PDFIO_CACHE_RUN)
+    {
+      if (!cache_fetch(pdf, first, count))
+        break;
+
+      count = 0;
+    }
+  }
+
+  if (count)
+    cache_fetch(pdf, first, count);
+
+#ifdef _WIN32
+  LeaveCriticalSection(&cache->mutex);
+#else
+  pthread_mutex_unlock(&cache->mutex);
+#endif // _WIN32
+}
+
+
 //
 // '_pdfioFilePrintf()' - Write a formatted string to a PDF file.
 //
@@ -312,7 +564,7 @@ _pdfioFileRead(pdfio_file_t *pdf,	// I - PDF file
     }
 
     // Nothing buffered...
-    if (bytes > 1024)
+    if (bytes > 1024 && !pdf->memdata)
     {
       // Advance current position in file as needed...
       if (pdf->bufend)
@@ -347,6 +599,152 @@ _pdfioFileRead(pdfio_file_t *pdf,	// I - PDF file
 }
 
 
+//
+// '_pdfioFileReadAt()' - Read from a PDF file at the specified offset.
+//
+// This function reads data without using or changing the current position in
+// the file, allowing streams in different threads to read concurrently.
+//
+
+ssize_t					// O - Number of bytes read or `-1` on error
+_pdfioFileReadAt(pdfio_file_t *pdf,	// I - PDF file
+                 off_t        offset,	// I - Offset from beginning of file
+                 void         *buffer,	// I - Read buffer
+                 size_t       bytes)	// I - Number of bytes to read
+{
+  ssize_t	rbytes;			// Bytes read
+
+
+  if (offset < 0)
+    return (-1);
+
+  if (pdf->memdata)
+  {
+    // Copy from memory...
+    if (offset >= (off_t)pdf->memsize)
+      return (0);
+
+    if (bytes > (pdf->memsize - (size_t)offset))
+      bytes = pdf->memsize - (size_t)offset;
+
+    memcpy(buffer, pdf->memdata + offset, bytes);
+
+    return ((ssize_t)bytes);
+  }
+  else if (pdf->input_cb)
+  {
+    // Read through the block cache...
+    return (cache_read(pdf, offset, buffer, bytes));
+  }
+
+#ifdef _WIN32
+  // No pread, so seek and read while holding the lock...
+  bool	reading;			// Switched to reading?
+
+  _pdfioFileLock(pdf);
+
+  reading = _pdfioFileBeginRead(pdf);
+
+  if (_pdfioFileSeek(pdf, offset, SEEK_SET) == offset)
+    rbytes = _pdfioFileRead(pdf, buffer, bytes);
+  else
+    rbytes = -1;
+
+  if (reading)
+    _pdfioFileEndRead(pdf);
+
+  _pdfioFileUnlock(pdf);
+
+#else
+  // Read from the file at the specified offset...
+  _pdfioFileSpan(pdf, PDFIO_SPAN_READ, true);
+
+  while ((rbytes = pread(pdf->fd, buffer, bytes, offset)) < 0)
+  {
+    // Stop if we have an error that shouldn't be retried...
+    if (errno != EINTR && errno != EAGAIN)
+      break;
+  }
+
+  _pdfioFileSpan(pdf, PDFIO_SPAN_READ, false);
+
+  if (rbytes < 0)
+  {
+    // Hard error...
+    _pdfioFileError(pdf, "Unable to read from file - %s", strerror(errno));
+  }
+  else
+  {
+    // Update the statistics, which are shared with other threads...
+    _pdfioFileLock(pdf);
+    pdf->stats.reads ++;
+    pdf->stats.bytes_read += (size_t)rbytes;
+    _pdfioFileUnlock(pdf);
+  }
+#endif // _WIN32
+
+  return (rbytes);
+}
+
+
+//
+// '_pdfioFileReadMapped()' - Read from a memory-mapped PDF file without copying.
+//
+// This function returns a pointer to up to "bytes" bytes of file data at the
+// current position and advances the position past them.  The "bytes" argument
+// is updated with the number of bytes available.  `NULL` is returned if the
+// file data is not in memory or if there is no more data.
+//
+
+const char *				// O  - Pointer to file data or `NULL` if none
+_pdfioFileReadMapped(
+    pdfio_file_t *pdf,			// I  - PDF file
+    size_t       *bytes)		// IO - Maximum/actual number of bytes
+{
+  const char	*data;			// Pointer to file data
+  size_t	avail;			// Available bytes
+
+
+  if (!pdf->memdata || !pdf->bufptr || pdf->bufptr >= pdf->bufend)
+    return (NULL);
+
+  data  = pdf->bufptr;
+  avail = (size_t)(pdf->bufend - pdf->bufptr);
+
+  if (*bytes > avail)
+    *bytes = avail;
+
+  pdf->bufptr += *bytes;
+
+  return (data);
+}
+
+
+//
+// '_pdfioFileReadMappedAt()' - Read from a memory-mapped PDF file at the specified offset without copying.
+//
+// This function returns a pointer to up to "bytes" bytes of file data at the
+// specified offset.  The "bytes" argument is updated with the number of bytes
+// available.  `NULL` is returned if the file data is not in memory or if the
+// offset is at or past the end of the file.
+//
+
+const char *				// O  - Pointer to file data or `NULL` if none
+_pdfioFileReadMappedAt(
+    pdfio_file_t *pdf,			// I  - PDF file
+    off_t        offset,		// I  - Offset from beginning of file
+    size_t       *bytes)		// IO - Maximum/actual number of bytes
+{
+  if (!pdf->memdata || offset < 0 || offset >= (off_t)pdf->memsize)
+    return (NULL);
+
+  if (*bytes > (pdf->memsize - (size_t)offset))
+    *bytes = pdf->memsize - (size_t)offset;
+
+  return (pdf->memdata + offset);
+}
+
+
 //
 // '_pdfioFileSeek()' - Seek within a PDF file.
 //
@@ -365,7 +763,25 @@ _pdfioFileSeek(pdfio_file_t *pdf,	// I - PDF file
     whence = SEEK_SET;
   }
 
-  if (pdf->mode == _PDFIO_MODE_READ)
+  if (pdf->memdata)
+  {
+    // Reading from memory, just move the pointer...
+    if (whence == SEEK_END)
+      offset += (off_t)pdf->memsize;
+
+    if (offset < 0)
+      offset = 0;
+    else if (offset > (off_t)pdf->memsize)
+      offset = (off_t)pdf->memsize;
+
+    pdf->buffer = (char *)pdf->memdata;
+    pdf->bufpos = 0;
+    pdf->bufptr = pdf->buffer + offset;
+    pdf->bufend = pdf->buffer + pdf->memsize;
+
+    return (offset);
+  }
+  else if (pdf->mode == _PDFIO_MODE_READ)
   {
     // Reading, see if we already have the data we need...
     if (whence != SEEK_END && offset >= pdf->bufpos && pdf->bufend && offset < (pdf->bufpos + pdf->bufend - pdf->buffer))
@@ -397,10 +813,32 @@ _pdfioFileSeek(pdfio_file_t *pdf,	// I - PDF file
     pdf->bufptr = pdf->buffer;
   }
 
+  if (pdf->input_cb)
+  {
+    // Reading with an input callback, just move the position...
+    if (whence == SEEK_END)
+      offset += pdf->input_size;
+
+    if (offset < 0)
+      offset = 0;
+    else if (offset > pdf->input_size)
+      offset = pdf->input_size;
+
+    pdf->input_pos = pdf->bufpos = offset;
+
+    return (offset);
+  }
+
   // Seek within the file...
+  _pdfioFileSpan(pdf, PDFIO_SPAN_SEEK, true);
+
   if ((offset = lseek(pdf->fd, offset, whence)) < 0 && whence == SEEK_END && errno == EINVAL)
     offset = lseek(pdf->fd, 0, SEEK_SET);
 
+  _pdfioFileSpan(pdf, PDFIO_SPAN_SEEK, false);
+
+  pdf->stats.seeks ++;
+
   if (offset < 0)
   {
     _pdfioFileError(pdf, "Unable to seek within file - %s", strerror(errno));
@@ -416,6 +854,20 @@ _pdfioFileSeek(pdfio_file_t *pdf,	// I - PDF file
 }
 
 
+//
+// '_pdfioFileSpan()' - Report the beginning or end of a traced operation.
+//
+
+void
+_pdfioFileSpan(pdfio_file_t *pdf,	// I - PDF file
+               pdfio_span_t span,	// I - Operation
+               bool         begin)	// I - `true` at the beginning, `false` at the end
+{
+  if (pdf->span_cb)
+    (pdf->span_cb)(pdf, span, begin, pdf->span_data);
+}
+
+
 //
 // '_pdfioFileTell()' - Return the offset within a PDF file.
 //
@@ -430,6 +882,24 @@ _pdfioFileTell(pdfio_file_t *pdf)	// I - PDF file
 }
 
 
+//
+// '_pdfioFileUnlock()' - Unlock the shared state of a PDF file.
+//
+
+void
+_pdfioFileUnlock(pdfio_file_t *pdf)	// I - PDF file
+{
+  if (!pdf->concurrent)
+    return;
+
+#ifdef _WIN32
+  LeaveCriticalSection(&pdf->mutex);
+#else
+  pthread_mutex_unlock(&pdf->mutex);
+#endif // _WIN32
+}
+
+
 //
 // '_pdfioFileWrite()' - Write to a PDF file.
 //
@@ -446,7 +916,7 @@ _pdfioFileWrite(pdfio_file_t *pdf,	// I - PDF file
     if (!_pdfioFileFlush(pdf))
       return (false);
 
-    if (bytes >= sizeof(pdf->buffer))
+    if (bytes >= sizeof(pdf->localbuf))
     {
       // Write directly...
       if (!write_buffer(pdf, buffer, bytes))
@@ -466,6 +936,219 @@ _pdfioFileWrite(pdfio_file_t *pdf,	// I - PDF file
 }
 
 
+//
+// 'cache_fetch()' - Read blocks into the input cache.
+//
+// The cache mutex must be held by the caller.
+//
+
+static bool				// O - `true` on success, `false` on error
+cache_fetch(pdfio_file_t *pdf,		// I - PDF file
+            off_t        offset,	// I - Offset of first block
+            size_t       count)		// I - Number of blocks
+{
+  _pdfio_cache_t	*cache = pdf->cache;
+					// Block cache
+  _pdfio_cblock_t	*block,		// Current block
+			*victim;	// Block to replace
+  size_t		bytes,		// Bytes to read
+			total,		// Total bytes read
+			length;		// Length of current block
+  ssize_t		rbytes;		// Bytes read this time
+  size_t		i;		// Looping var
+
+
+  PDFIO_DEBUG("cache_fetch(pdf=%p, offset=%ld, count=%lu)\n", pdf, (long)offset, (unsigned long)count);
+
+  if (!cache->run && (cache->run = (unsigned char *)malloc(_PDFIO_CACHE_RUN * _PDFIO_CACHE_BLOCK)) == NULL)
+  {
+    _pdfioFileError(pdf, "Unable to allocate memory for input cache.");
+    return (false);
+  }
+
+  // Read the blocks with as few callbacks as possible...
+  if (count > _PDFIO_CACHE_RUN)
+    count = _PDFIO_CACHE_RUN;
+
+  if ((bytes = count * _PDFIO_CACHE_BLOCK) > (size_t)(pdf->input_size - offset))
+    bytes = (size_t)(pdf->input_size - offset);
+
+  for (total = 0; total < bytes; total += (size_t)rbytes)
+  {
+    _pdfioFileSpan(pdf, PDFIO_SPAN_READ, true);
+    rbytes = (pdf->input_cb)(pdf->input_ctx, offset + (off_t)total, cache->run + total, bytes - total);
+    _pdfioFileSpan(pdf, PDFIO_SPAN_READ, false);
+
+    if (rbytes < 0)
+    {
+      _pdfioFileError(pdf, "Unable to read from file.");
+      return (false);
+    }
+    else if (rbytes == 0)
+    {
+      break;
+    }
+
+    pdf->stats.reads ++;
+    pdf->stats.bytes_read += (size_t)rbytes;
+  }
+
+  if (total == 0)
+  {
+    _pdfioFileError(pdf, "Unexpected end of file.");
+    return (false);
+  }
+
+  // Copy the data to the least recently used blocks...
+  for (i = 0; i < total; i += _PDFIO_CACHE_BLOCK)
+  {
+    for (block = cache->blocks, victim = block; block < (cache->blocks + _PDFIO_CACHE_BLOCKS); block ++)
+    {
+      if (block->offset < 0)
+      {
+        victim = block;
+        break;
+      }
+      else if (block->used < victim->used)
+      {
+        victim = block;
+      }
+    }
+
+    if (!victim->data && (victim->data = (unsigned char *)malloc(_PDFIO_CACHE_BLOCK)) == NULL)
+    {
+      _pdfioFileError(pdf, "Unable to allocate memory for input cache.");
+      return (false);
+    }
+
+    if ((length = total - i) > _PDFIO_CACHE_BLOCK)
+      length = _PDFIO_CACHE_BLOCK;
+
+    memcpy(victim->data, cache->run + i, length);
+
+    victim->offset = offset + (off_t)i;
+    victim->length = length;
+    victim->used   = ++ cache->counter;
+  }
+
+  cache->next_offset = offset + (off_t)total;
+
+  return (true);
+}
+
+
+//
+// 'cache_find()' - Find a block in the input cache.
+//
+
+static _pdfio_cblock_t *		// O - Block or `NULL` if not cached
+cache_find(_pdfio_cache_t *cache,	// I - Block cache
+           off_t          offset)	// I - Offset of block
+{
+  _pdfio_cblock_t	*block;		// Current block
+  size_t		i;		// Looping var
+
+
+  for (i = _PDFIO_CACHE_BLOCKS, block = cache->blocks; i > 0; i --, block ++)
+  {
+    if (block->offset == offset)
+      return (block);
+  }
+
+  return (NULL);
+}
+
+
+//
+// 'cache_read()' - Read data through the input cache.
+//
+// Adjacent missing blocks are fetched with a single call to the input
+// callback, and sequential reads fetch additional blocks ahead of the current
+// position.
+//
+
+static ssize_t				// O - Number of bytes read or `-1` on error
+cache_read(pdfio_file_t *pdf,		// I - PDF file
+           off_t        offset,		// I - Offset from beginning of file
+           void         *buffer,	// I - Read buffer
+           size_t       bytes)		// I - Number of bytes to read
+{
+  _pdfio_cache_t	*cache = pdf->cache;
+					// Block cache
+  _pdfio_cblock_t	*block;		// Current block
+  unsigned char		*bufptr = (unsigned char *)buffer;
+					// Pointer into buffer
+  off_t			boffset,	// Offset of current block
+			next;		// Offset of next block
+  size_t		count,		// Number of blocks to fetch
+			skip,		// Bytes to skip in block
+			length,		// Bytes to copy from block
+			total = 0;	// Total bytes read
+  bool			error = false;	// Did an error occur?
+
+
+  if (offset >= pdf->input_size)
+    return (0);
+
+  if (bytes > (size_t)(pdf->input_size - offset))
+    bytes = (size_t)(pdf->input_size - offset);
+
+#ifdef _WIN32
+  EnterCriticalSection(&cache->mutex);
+#else
+  pthread_mutex_lock(&cache->mutex);
+#endif // _WIN32
+
+  while (total < bytes)
+  {
+    boffset = offset - offset % _PDFIO_CACHE_BLOCK;
+
+    if ((block = cache_find(cache, boffset)) == NULL)
+    {
+      // Coalesce the missing blocks needed for this read...
+      for (count = 1, next = boffset + _PDFIO_CACHE_BLOCK; count < _PDFIO_CACHE_RUN && next < (offset + (off_t)(bytes - total)) && !cache_find(cache, next); count ++, next += _PDFIO_CACHE_BLOCK);
+
+      // Read ahead when continuing from the last fetch...
+      if (boffset == cache->next_offset)
+      {
+        for (; count < _PDFIO_CACHE_AHEAD && next < pdf->input_size && !cache_find(cache, next); count ++, next += _PDFIO_CACHE_BLOCK);
+      }
+
+      if (!cache_fetch(pdf, boffset, count) || (block = cache_find(cache, boffset)) == NULL)
+      {
+        error = true;
+        break;
+      }
+    }
+
+    block->used = ++ cache->counter;
+
+    if ((skip = (size_t)(offset - boffset)) >= block->length)
+      break;
+
+    if ((length = block->length - skip) > (bytes - total))
+      length = bytes - total;
+
+    memcpy(bufptr, block->data + skip, length);
+
+    bufptr += length;
+    offset += (off_t)length;
+    total  += length;
+  }
+
+#ifdef _WIN32
+  LeaveCriticalSection(&cache->mutex);
+#else
+  pthread_mutex_unlock(&cache->mutex);
+#endif // _WIN32
+
+  if (error && total == 0)
+    return (-1);
+  else
+    return ((ssize_t)total);
+}
+
+
 //
 // 'fill_buffer()' - Fill the read buffer in a PDF file.
 //
@@ -476,12 +1159,18 @@ fill_buffer(pdfio_file_t *pdf)		// I - PDF file
   ssize_t	bytes;			// Bytes read...
 
 
+  // Memory-mapped files are always fully "buffered"...
+  if (pdf->memdata)
+    return (false);
+
   // Advance current position in file as needed...
   if (pdf->bufend)
     pdf->bufpos += pdf->bufend - pdf->buffer;
 
   // Try reading from the file...
-  if ((bytes = read_buffer(pdf, pdf->buffer, sizeof(pdf->buffer))) <= 0)
+  pdf->stats.buffer_fills ++;
+
+  if ((bytes = read_buffer(pdf, pdf->buffer, sizeof(pdf->localbuf))) <= 0)
   {
     // EOF or hard error...
     pdf->bufptr = pdf->bufend = NULL;
@@ -509,7 +1198,22 @@ read_buffer(pdfio_file_t *pdf,		// I - PDF file
   ssize_t	rbytes;			// Bytes read...
 
 
+  // Memory-mapped files have nothing left to read...
+  if (pdf->memdata)
+    return (0);
+
+  if (pdf->input_cb)
+  {
+    // Read through the block cache...
+    if ((rbytes = cache_read(pdf, pdf->input_pos, buffer, bytes)) > 0)
+      pdf->input_pos += rbytes;
+
+    return (rbytes);
+  }
+
   // Read from the file...
+  _pdfioFileSpan(pdf, PDFIO_SPAN_READ, true);
+
   while ((rbytes = read(pdf->fd, buffer, bytes)) < 0)
   {
     // Stop if we have an error that shouldn't be retried...
@@ -517,11 +1221,18 @@ read_buffer(pdfio_file_t *pdf,		// I - PDF file
       break;
   }
 
+  _pdfioFileSpan(pdf, PDFIO_SPAN_READ, false);
+
   if (rbytes < 0)
   {
     // Hard error...
     _pdfioFileError(pdf, "Unable to read from file - %s", strerror(errno));
   }
+  else
+  {
+    pdf->stats.reads ++;
+    pdf->stats.bytes_read += (size_t)rbytes;
+  }
 
   return (rbytes);
 }
@@ -541,20 +1252,56 @@ write_buffer(pdfio_file_t *pdf,		// I - PDF file
   ssize_t	wbytes;			// Bytes written...
 
 
-  if (pdf->output_cb)
+  if (pdf->spooling)
+  {
+    // Write to the spool buffer...
+    if (bytes > (pdf->spoolalloc - pdf->spoollen))
+    {
+      size_t	spoolalloc = pdf->spoolalloc ? pdf->spoolalloc : 65536;
+					// New size of spool buffer
+      char	*spool;			// New spool buffer
+
+      while (spoolalloc < (pdf->spoollen + bytes))
+        spoolalloc *= 2;
+
+      if ((spool = (char *)realloc(pdf->spool, spoolalloc)) == NULL)
+      {
+        _pdfioFileError(pdf, "Unable to allocate memory for spool buffer - %s", strerror(errno));
+        return (false);
+      }
+
+      pdf->spool      = spool;
+      pdf->spoolalloc = spoolalloc;
+    }
+
+    memcpy(pdf->spool + pdf->spoollen, buffer, bytes);
+    pdf->spoollen += bytes;
+  }
+  else if (pdf->output_cb)
   {
     // Write to a stream...
-    if ((pdf->output_cb)(pdf->output_ctx, buffer, bytes) < 0)
+    bool	status;			// Write status
+
+    _pdfioFileSpan(pdf, PDFIO_SPAN_WRITE, true);
+    status = (pdf->output_cb)(pdf->output_ctx, buffer, bytes) >= 0;
+    _pdfioFileSpan(pdf, PDFIO_SPAN_WRITE, false);
+
+    if (!status)
     {
       _pdfioFileError(pdf, "Unable to write to output callback.");
       return (false);
     }
+
+    pdf->stats.writes ++;
+    pdf->stats.bytes_written += bytes;
   }
   else
   {
     // Write to the file...
     while (bytes > 0)
     {
+      _pdfioFileSpan(pdf, PDFIO_SPAN_WRITE, true);
+
       while ((wbytes = write(pdf->fd, bufptr, bytes)) < 0)
       {
 	// Stop if we have an error that shouldn't be retried...
@@ -562,6 +1309,8 @@ write_buffer(pdfio_file_t *pdf,		// I - PDF file
 	  break;
       }
 
+      _pdfioFileSpan(pdf, PDFIO_SPAN_WRITE, false);
+
       if (wbytes < 0)
       {
 	// Hard error...
@@ -569,6 +1318,9 @@ write_buffer(pdfio_file_t *pdf,		// I - PDF file
 	return (false);
       }
 
+      pdf->stats.writes ++;
+      pdf->stats.bytes_written += (size_t)wbytes;
+
       bufptr += wbytes;
       bytes  -= (size_t)wbytes;
     }
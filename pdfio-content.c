@@ -12,6 +12,7 @@
 #include "pdfio-base-font-widths.h"
 #include "ttf.h"
 #include <math.h>
+#include <sys/stat.h>
 #ifndef M_PI
 #  define M_PI	3.14159265358979323846264338327950288
 #endif // M_PI
@@ -35,6 +36,11 @@
 #define _PDFIO_PNG_TYPE_GRAYA	4	// Grayscale + alpha
 #define _PDFIO_PNG_TYPE_RGBA	6	// RGB + alpha
 
+#define _PDFIO_SCAN_BUFSIZE	65536	// Size of content scanner read buffer
+#define _PDFIO_SCAN_DELIM_CHARS	"<>(){}[]/%"
+					// Delimiter characters in content streams
+#define _PDFIO_SCAN_MAX_DEPTH	32	// Maximum array/dictionary nesting in content streams
+
 static int	_pdfio_cp1252[] =	// CP1252-specific character mapping
 {
   0x20AC,
@@ -76,19 +82,114 @@ static int	_pdfio_cp1252[] =	// CP1252-specific character mapping
 // Local types...
 //
 
-typedef pdfio_obj_t *(*_pdfio_image_func_t)(pdfio_dict_t *dict, int fd);
+typedef struct _pdfio_isrc_s		// Image file data source
+{
+  int		fd;			// File descriptor or `-1`
+  pdfio_input_cb_t input_cb;		// Input callback, if any
+  void		*input_ctx;		// Input callback context
+  const unsigned char *data;		// Image file data in memory, if any
+  size_t	datalen;		// Length of image file data
+  off_t		offset;			// Current offset for callback/memory
+} _pdfio_isrc_t;
+
+typedef pdfio_obj_t *(*_pdfio_image_func_t)(pdfio_dict_t *dict, _pdfio_isrc_t *src);
+
+struct _pdfio_font_s			// Shared TrueType/OpenType font
+{
+  char		*filename;		// Font filename
+  pdfio_error_cb_t error_cb;		// Error callback
+  void		*error_data;		// Error callback data
+  unsigned char	*data;			// Font file data
+  size_t	datalen;		// Length of font file data
+  unsigned char	*flate;			// Compressed font file data, if any
+  size_t	flatelen;		// Length of compressed font file data
+  ttf_t		*ttf;			// TrueType font data
+  uint8_t	digest[32];		// SHA-256 digest of font file data
+  _pdfio_mutex_t widths_mutex;		// Mutex for cached widths
+  float		*widths[256];		// Cached widths of BMP characters in 1000ths, 256 per block
+};
+
+typedef struct _pdfio_pbuf_s		// Buffered path/geometry output
+{
+  pdfio_stream_t *st;			// Content stream
+  int		digits,			// Significant digits for numbers
+		decimals;		// Decimal places for numbers
+  bool		error;			// Did a write fail?
+  char		*bufptr,		// Pointer into buffer
+		*bufend;		// End of buffer
+  char		buffer[8192];		// Output buffer
+} _pdfio_pbuf_t;
+
+typedef struct _pdfio_scan_s		// Content stream scanner
+{
+  pdfio_obj_t	*page;			// Page object
+  size_t	num_streams,		// Number of content streams
+		cur_stream;		// Next content stream
+  pdfio_stream_t *st;			// Current content stream
+  bool		error;			// Did an error occur?
+  unsigned char	*bufptr,		// Pointer into buffer
+		*bufend;		// End of buffer
+  size_t	num_operands,		// Number of operands
+		alloc_operands;		// Allocated operands
+  pdfio_operand_t *operands;		// Operand stack
+  size_t	*offsets;		// Offsets of operand data in text buffer
+  char		*text;			// Name/string/image data for operands
+  size_t	textlen,		// Length of text buffer
+		textsize;		// Allocated size of text buffer
+  size_t	depth,			// Array/dictionary nesting depth
+		nesting[_PDFIO_SCAN_MAX_DEPTH];
+					// Operand indices of open arrays/dictionaries
+  unsigned char	buffer[_PDFIO_SCAN_BUFSIZE];
+					// Read buffer
+} _pdfio_scan_t;
+
+typedef struct _pdfio_twidths_s		// Character widths for measuring text
+{
+  pdfio_font_t	*font;			// TrueType font data, if any
+  const short	*base;			// Base font widths, if any
+  bool		cp1252;			// Map characters to CP1252?
+} _pdfio_twidths_t;
 
 
 //
 // Local functions...
 //
 
-static pdfio_obj_t	*copy_jpeg(pdfio_dict_t *dict, int fd);
-static pdfio_obj_t	*copy_png(pdfio_dict_t *dict, int fd);
+static bool		add_subset_font(pdfio_file_t *pdf, pdfio_obj_t *font_obj, pdfio_obj_t *type2_obj, pdfio_obj_t *file_obj, pdfio_obj_t *cid2gid_obj);
+static pdfio_obj_t	*copy_image(pdfio_file_t *pdf, _pdfio_isrc_t *src, const char *filename, bool interpolate);
+static pdfio_obj_t	*copy_jpeg(pdfio_dict_t *dict, _pdfio_isrc_t *src);
+static pdfio_obj_t	*copy_png(pdfio_dict_t *dict, _pdfio_isrc_t *src);
 static bool		create_cp1252(pdfio_file_t *pdf);
+static pdfio_obj_t	*create_font_obj(pdfio_file_t *pdf, pdfio_font_t *font, bool unicode);
+static void		font_error_cb(pdfio_font_t *font, const char *message);
+static bool		get_file_digest(int fd, const char *type, const char *filename, unsigned param, uint8_t *digest);
+static bool		get_text_widths(pdfio_obj_t *font, bool unicode, _pdfio_twidths_t *tw);
+static bool		image_copy(_pdfio_isrc_t *src, pdfio_stream_t *st, size_t length, unsigned *crc);
+static ssize_t		image_read(_pdfio_isrc_t *src, void *buffer, size_t bytes);
+static bool		image_rewind(_pdfio_isrc_t *src);
+static bool		load_font(pdfio_font_t *font, int fd, const char *filename, bool compress, ttf_err_cb_t err_cb, void *err_data);
+static double		measure_text(_pdfio_twidths_t *tw, const char *s, const char *end);
+static pdfio_font_t	*new_font(void);
+static bool		pbuf_flush(_pdfio_pbuf_t *pb);
+static void		pbuf_init(_pdfio_pbuf_t *pb, pdfio_stream_t *st);
+static void		pbuf_number(_pdfio_pbuf_t *pb, double number);
+static void		pbuf_point(_pdfio_pbuf_t *pb, pdfio_matrix_t m, double x, double y);
+static void		pbuf_puts(_pdfio_pbuf_t *pb, const char *s);
+static void		release_text_widths(_pdfio_twidths_t *tw);
+static pdfio_operand_t	*scan_add_operand(_pdfio_scan_t *scan, pdfio_valtype_t type);
+static bool		scan_add_text(_pdfio_scan_t *scan, int ch);
+static bool		scan_close_nesting(_pdfio_scan_t *scan, pdfio_valtype_t type, int ch);
+static bool		scan_end_text(_pdfio_scan_t *scan);
+static int		scan_fill(_pdfio_scan_t *scan);
+static int		scan_getc(_pdfio_scan_t *scan);
+static bool		scan_inline_image(_pdfio_scan_t *scan);
+static bool		scan_number(const char *s, double *number);
+static bool		scan_open_nesting(_pdfio_scan_t *scan, pdfio_valtype_t type);
+static int		text_getc(const char **s, const char *end);
 static void		ttf_error_cb(pdfio_file_t *pdf, const char *message);
 static unsigned		update_png_crc(unsigned crc, const unsigned char *buffer, size_t length);
-static bool		write_string(pdfio_stream_t *st, bool unicode, const char *s, bool *newline);
+static bool		write_string(pdfio_stream_t *st, bool unicode, const char *s, size_t len, bool *newline);
+static bool		write_subset_font(pdfio_file_t *pdf, _pdfio_subfont_t *subfont, size_t num_chars, const int *chars);
 
 
 //
@@ -437,6 +538,56 @@ pdfioContentDrawImage(
 }
 
 
+//
+// 'pdfioContentDrawMarkers()' - Draw a marker at each point in an array.
+//
+// This function draws the form or image XObject "name" at each of the
+// "num_points" points in the "points" array, for example to draw the markers
+// of a scatter plot.  The marker is drawn with its origin at the point, so the
+// marker content is typically centered on 0,0.  The marker is only written to
+// the PDF file once and each point is a short reference to it.
+//
+// If "m" is not `NULL`, the points are transformed by that matrix, which is
+// useful for mapping data values to page coordinates.  The markers themselves
+// are not transformed.
+//
+// The object name must be part of the page dictionary resources, typically
+// using the @link pdfioFileCreateFormObj@ and @link pdfioPageDictAddImage@
+// functions.
+//
+
+bool					// O - `true` on success, `false` on failure
+pdfioContentDrawMarkers(
+    pdfio_stream_t      *st,		// I - Stream
+    const char          *name,		// I - Marker name
+    size_t              num_points,	// I - Number of points
+    const pdfio_point_t *points,	// I - Points
+    pdfio_matrix_t      m)		// I - Transform matrix or `NULL` for none
+{
+  _pdfio_pbuf_t	pb;			// Output buffer
+  char		op[256];		// Marker operator
+
+
+  // Range check input...
+  if (!st || !name || !points || num_points == 0)
+    return (false);
+
+  snprintf(op, sizeof(op), "cm/%s Do Q\n", name);
+
+  // Draw each marker...
+  pbuf_init(&pb, st);
+
+  for (; num_points > 0; num_points --, points ++)
+  {
+    pbuf_puts(&pb, "q 1 0 0 1 ");
+    pbuf_point(&pb, m, points->x, points->y);
+    pbuf_puts(&pb, op);
+  }
+
+  return (pbuf_flush(&pb));
+}
+
+
 //
 // 'pdfioContentFill()' - Fill the current path.
 //
@@ -625,6 +776,65 @@ pdfioContentPathMoveTo(
 }
 
 
+//
+// 'pdfioContentPathPolygon()' - Add a closed polygon to the current path.
+//
+// This function adds a closed subpath connecting the "num_points" points in
+// the "points" array with straight lines.  If "m" is not `NULL`, the points
+// are transformed by that matrix.
+//
+
+bool					// O - `true` on success, `false` on failure
+pdfioContentPathPolygon(
+    pdfio_stream_t      *st,		// I - Stream
+    size_t              num_points,	// I - Number of points
+    const pdfio_point_t *points,	// I - Points
+    pdfio_matrix_t      m)		// I - Transform matrix or `NULL` for none
+{
+  return (pdfioContentPathPolyline(st, num_points, points, m) && pdfioStreamPuts(st, "h\n"));
+}
+
+
+//
+// 'pdfioContentPathPolyline()' - Add connected straight lines to the current path.
+//
+// This function starts a new subpath at the first point in the "points" array
+// and adds straight lines to each of the remaining points, for example to draw
+// a line chart.  If "m" is not `NULL`, the points are transformed by that
+// matrix, which is useful for mapping data values to page coordinates without
+// also scaling the line width.
+//
+
+bool					// O - `true` on success, `false` on failure
+pdfioContentPathPolyline(
+    pdfio_stream_t      *st,		// I - Stream
+    size_t              num_points,	// I - Number of points
+    const pdfio_point_t *points,	// I - Points
+    pdfio_matrix_t      m)		// I - Transform matrix or `NULL` for none
+{
+  _pdfio_pbuf_t	pb;			// Output buffer
+
+
+  // Range check input...
+  if (!st || !points || num_points == 0)
+    return (false);
+
+  // Add the lines...
+  pbuf_init(&pb, st);
+
+  pbuf_point(&pb, m, points->x, points->y);
+  pbuf_puts(&pb, "m\n");
+
+  for (num_points --, points ++; num_points > 0; num_points --, points ++)
+  {
+    pbuf_point(&pb, m, points->x, points->y);
+    pbuf_puts(&pb, "l\n");
+  }
+
+  return (pbuf_flush(&pb));
+}
+
+
 //
 // 'pdfioContentPathRect()' - Add a rectangle to the current path.
 //
@@ -641,6 +851,67 @@ pdfioContentPathRect(
 }
 
 
+//
+// 'pdfioContentPathRects()' - Add rectangles to the current path.
+//
+// This function adds the "num_rects" rectangles in the "rects" array to the
+// current path, for example to draw the bars of a bar chart.  If "m" is not
+// `NULL`, the rectangle corners are transformed by that matrix.
+//
+
+bool					// O - `true` on success, `false` on failure
+pdfioContentPathRects(
+    pdfio_stream_t     *st,		// I - Stream
+    size_t             num_rects,	// I - Number of rectangles
+    const pdfio_rect_t *rects,		// I - Rectangles
+    pdfio_matrix_t     m)		// I - Transform matrix or `NULL` for none
+{
+  _pdfio_pbuf_t	pb;			// Output buffer
+
+
+  // Range check input...
+  if (!st || !rects || num_rects == 0)
+    return (false);
+
+  // Add the rectangles...
+  pbuf_init(&pb, st);
+
+  for (; num_rects > 0; num_rects --, rects ++)
+  {
+    if (!m)
+    {
+      pbuf_number(&pb, rects->x1);
+      pbuf_number(&pb, rects->y1);
+      pbuf_number(&pb, rects->x2 - rects->x1);
+      pbuf_number(&pb, rects->y2 - rects->y1);
+      pbuf_puts(&pb, "re\n");
+    }
+    else if (m[0][1] == 0.0 && m[1][0] == 0.0)
+    {
+      // Scaled and/or translated rectangle...
+      pbuf_point(&pb, m, rects->x1, rects->y1);
+      pbuf_number(&pb, m[0][0] * (rects->x2 - rects->x1));
+      pbuf_number(&pb, m[1][1] * (rects->y2 - rects->y1));
+      pbuf_puts(&pb, "re\n");
+    }
+    else
+    {
+      // Rotated or skewed rectangle...
+      pbuf_point(&pb, m, rects->x1, rects->y1);
+      pbuf_puts(&pb, "m\n");
+      pbuf_point(&pb, m, rects->x2, rects->y1);
+      pbuf_puts(&pb, "l\n");
+      pbuf_point(&pb, m, rects->x2, rects->y2);
+      pbuf_puts(&pb, "l\n");
+      pbuf_point(&pb, m, rects->x1, rects->y2);
+      pbuf_puts(&pb, "l\nh\n");
+    }
+  }
+
+  return (pbuf_flush(&pb));
+}
+
+
 //
 // 'pdfioContentRestore()' - Restore a previous graphics state.
 //
@@ -1038,6 +1309,55 @@ pdfioContentStroke(pdfio_stream_t *st)	// I - Stream
 }
 
 
+//
+// '_pdfioContentSubsetFonts()' - Write the data for subset fonts.
+//
+// This function writes the font file, CIDToGIDMap, and width array for each
+// font that was created with the `PDFIO_OPTION_SUBSET_FONTS` option, using the
+// Unicode characters that have been shown with the text functions.
+//
+
+bool					// O - `true` on success, `false` on failure
+_pdfioContentSubsetFonts(
+    pdfio_file_t *pdf)			// I - PDF file
+{
+  bool		ret = true;		// Return value
+  size_t	i;			// Looping var
+  _pdfio_subfont_t *subfont;		// Current font
+  int		ch,			// Current character
+		*chars;			// Characters used
+  size_t	num_chars = 0;		// Number of characters used
+
+
+  if (pdf->num_subfonts == 0)
+    return (true);
+
+  // Build a sorted list of the characters that are used...
+  if ((chars = (int *)malloc(65536 * sizeof(int))) == NULL)
+  {
+    _pdfioFileError(pdf, "Unable to allocate memory for font subset.");
+    return (false);
+  }
+
+  for (ch = 0; ch < 65536; ch ++)
+  {
+    if (pdf->used_chars[ch / 8] & (1 << (ch & 7)))
+      chars[num_chars ++] = ch;
+  }
+
+  // Then write each of the fonts...
+  for (i = pdf->num_subfonts, subfont = pdf->subfonts; i > 0; i --, subfont ++)
+  {
+    if (!write_subset_font(pdf, subfont, num_chars, chars))
+      ret = false;
+  }
+
+  free(chars);
+
+  return (ret);
+}
+
+
 //
 // 'pdfioContentTextBegin()' - Begin a text block.
 //
@@ -1075,121 +1395,20 @@ pdfioContentTextMeasure(
     const char  *s,			// I - UTF-8 string
     double      size)			// I - Font size/height
 {
-  const char	*basefont;		// Base font name
-  ttf_t		*ttf = (ttf_t *)_pdfioObjGetExtension(font);
-					// TrueType font data
-  ttf_rect_t	extents;		// Text extents
-  int		ch;			// Unicode character
-  char		temp[1024],		// Temporary string
-		*tempptr;		// Pointer into temporary string
-
-
-  if (!ttf && (basefont = pdfioDictGetName(pdfioObjGetDict(font), "BaseFont")) != NULL)
-  {
-    // Measure the width using the compiled-in base font tables...
-    const short	*widths;		// Widths
-    int		width = 0;		// Current width
-
-    if (strcmp(basefont, "Symbol") && strcmp(basefont, "Zapf-Dingbats"))
-    {
-      // Map non-CP1282 characters to '?', everything else as-is...
-      tempptr = temp;
-
-      while (*s && tempptr < (temp + sizeof(temp) - 3))
-      {
-	if ((*s & 0xe0) == 0xc0)
-	{
-	  // Two-byte UTF-8
-	  ch = ((s[0] & 0x1f) << 6) | (s[1] & 0x3f);
-	  s += 2;
-	}
-	else if ((*s & 0xf0) == 0xe0)
-	{
-	  // Three-byte UTF-8
-	  ch = ((s[0] & 0x0f) << 12) | ((s[1] & 0x3f) << 6) | (s[2] & 0x3f);
-	  s += 3;
-	}
-	else if ((*s & 0xf8) == 0xf0)
-	{
-	  // Four-byte UTF-8
-	  ch = ((s[0] & 0x07) << 18) | ((s[1] & 0x3f) << 12) | ((s[2] & 0x3f) << 6) | (s[3] & 0x3f);
-	  s += 4;
-	}
-	else
-	{
-	  ch = *s++;
-	}
-
-	if (ch > 255)
-	{
-	  // Try mapping from Unicode to CP1252...
-	  size_t i;			// Looping var
-
-	  for (i = 0; i < (sizeof(_pdfio_cp1252) / sizeof(_pdfio_cp1252[0])); i ++)
-	  {
-	    if (ch == _pdfio_cp1252[i])
-	      break;
-	  }
-
-	  if (i < (sizeof(_pdfio_cp1252) / sizeof(_pdfio_cp1252[0])))
-	    ch = (int)(i + 0x80);	// Extra characters from 0x80 to 0x9f
-	  else
-	    ch = '?';			// Unsupported chars map to ?
-	}
-
-	*tempptr++ = (char)ch;
-      }
+  _pdfio_twidths_t tw;			// Character widths
+  double	width;			// Width of string
 
-      *tempptr = '\0';
-      s        = temp;
-    }
-
-    // Choose the appropriate table...
-    if (!strcmp(basefont, "Courier"))
-      widths = courier_widths;
-    else if (!strcmp(basefont, "Courier-Bold"))
-      widths = courier_bold_widths;
-    else if (!strcmp(basefont, "Courier-BoldOblique"))
-      widths = courier_boldoblique_widths;
-    else if (!strcmp(basefont, "Courier-Oblique"))
-      widths = courier_oblique_widths;
-    else if (!strcmp(basefont, "Helvetica"))
-      widths = helvetica_widths;
-    else if (!strcmp(basefont, "Helvetica-Bold"))
-      widths = helvetica_bold_widths;
-    else if (!strcmp(basefont, "Helvetica-BoldOblique"))
-      widths = helvetica_boldoblique_widths;
-    else if (!strcmp(basefont, "Helvetica-Oblique"))
-      widths = helvetica_oblique_widths;
-    else if (!strcmp(basefont, "Symbol"))
-      widths = symbol_widths;
-    else if (!strcmp(basefont, "Times-Bold"))
-      widths = times_bold_widths;
-    else if (!strcmp(basefont, "Times-BoldItalic"))
-      widths = times_bolditalic_widths;
-    else if (!strcmp(basefont, "Times-Italic"))
-      widths = times_italic_widths;
-    else if (!strcmp(basefont, "Times-Roman"))
-      widths = times_roman_widths;
-    else if (!strcmp(basefont, "ZapfDingbats"))
-      widths = zapfdingbats_widths;
-    else
-      return (0.0);
 
-    // Calculate the width using the corresponding table...
-    while (*s)
-    {
-      width += widths[*s & 255];
-      s ++;
-    }
+  // Range check input...
+  if (!s || !get_text_widths(font, /*unicode*/true, &tw))
+    return (0.0);
 
-    return (size * 0.001 * width);
-  }
+  // Measure the string using the cached widths...
+  width = size * 0.001 * measure_text(&tw, s, s + strlen(s));
 
-  // If we get here then we need to measure using the TrueType library...
-  ttfGetExtents(ttf, (float)size, s, &extents);
+  release_text_widths(&tw);
 
-  return (extents.right - extents.left);
+  return (width);
 }
 
 
@@ -1284,7 +1503,7 @@ pdfioContentTextNewLineShow(
   }
 
   // Write the string...
-  if (!write_string(st, unicode, s, &newline))
+  if (!write_string(st, unicode, s, strlen(s), &newline))
     return (false);
 
   // Draw it...
@@ -1345,7 +1564,7 @@ pdfioContentTextShow(
 
 
   // Write the string...
-  if (!write_string(st, unicode, s, &newline))
+  if (!write_string(st, unicode, s, strlen(s), &newline))
     return (false);
 
   // Draw it...
@@ -1382,7 +1601,7 @@ pdfioContentTextShowf(
   va_end(ap);
 
   // Write the string...
-  if (!write_string(st, unicode, buffer, &newline))
+  if (!write_string(st, unicode, buffer, strlen(buffer), &newline))
     return (false);
 
   // Draw it...
@@ -1426,7 +1645,7 @@ pdfioContentTextShowJustified(
 
     if (fragments[i])
     {
-      if (!write_string(st, unicode, fragments[i], NULL))
+      if (!write_string(st, unicode, fragments[i], strlen(fragments[i]), NULL))
         return (false);
     }
   }
@@ -1435,6 +1654,170 @@ pdfioContentTextShowJustified(
 }
 
 
+//
+// 'pdfioContentTextShowParagraph()' - Break a paragraph into lines and show it.
+//
+// This function measures the UTF-8 encoded string "s" using the widths of the
+// font object "font" at the font size "size", breaks it into lines no wider
+// than "width" at spaces, and shows each line in a PDF content stream.  The
+// string is measured in a single pass using the font's cached character
+// widths.  Newlines in the string end the current line.
+//
+// The "align" argument specifies whether lines are aligned on the left
+// (`PDFIO_TEXTALIGN_LEFT`), centered (`PDFIO_TEXTALIGN_CENTER`), aligned on the
+// right (`PDFIO_TEXTALIGN_RIGHT`), or justified to the full width
+// (`PDFIO_TEXTALIGN_JUSTIFY`) - the last line of a justified paragraph and
+// lines that end with a newline are aligned on the left.
+//
+// The text is shown starting at the current text position with the current
+// font, which must be "font" at "size", and each additional line is started
+// using the current text leading set with @link pdfioContentSetTextLeading@.
+// Character and word spacing are not included in the measurements.  The
+// "unicode" argument has the same meaning as for @link pdfioContentTextShow@.
+// The number of lines that were shown is returned in "num_lines" if it is
+// not `NULL`.
+//
+
+bool					// O - `true` on success, `false` on failure
+pdfioContentTextShowParagraph(
+    pdfio_stream_t    *st,		// I - Stream
+    pdfio_obj_t       *font,		// I - Font object
+    bool              unicode,		// I - Unicode text?
+    double            size,		// I - Font size
+    double            width,		// I - Maximum line width
+    pdfio_textalign_t align,		// I - Line alignment
+    const char        *s,		// I - UTF-8 string
+    size_t            *num_lines)	// O - Number of lines shown or `NULL`
+{
+  bool		ret = true;		// Return value
+  _pdfio_twidths_t tw;			// Character widths
+  const char	*ptr,			// Pointer into string
+		*start,			// Start of line
+		*end,			// End of line
+		*spaces,		// End of spaces before word
+		*word,			// End of word
+		*frag;			// Start of text fragment
+  double	maxwidth,		// Maximum line width in 1000ths
+		linewidth,		// Width of line in 1000ths
+		spacewidth,		// Width of spaces in 1000ths
+		wordwidth,		// Width of word in 1000ths
+		offset;			// Alignment/justification offset
+  size_t	lines = 0,		// Number of lines
+		gaps;			// Number of gaps between words
+
+
+  // Range check input...
+  if (num_lines)
+    *num_lines = 0;
+
+  if (!st || !s || size <= 0.0 || width <= 0.0 || !get_text_widths(font, unicode, &tw))
+    return (false);
+
+  maxwidth = 1000.0 * width / size;
+
+  // Break the string into lines...
+  for (ptr = s; *ptr && ret;)
+  {
+    // Add words to the line until one doesn't fit...
+    for (start = end = ptr, linewidth = 0.0, gaps = 0;;)
+    {
+      for (spaces = ptr; *spaces == ' '; spaces ++);
+      for (word = spaces; *word && *word != ' ' && *word != '\n'; word ++);
+
+      if (word == spaces)
+      {
+        // No more words on this line...
+        ptr = spaces;
+        break;
+      }
+
+      spacewidth = measure_text(&tw, ptr, spaces);
+      wordwidth  = measure_text(&tw, spaces, word);
+
+      if (end > start && (linewidth + spacewidth + wordwidth) > maxwidth)
+      {
+        // Start the next line with this word...
+        ptr = spaces;
+        break;
+      }
+
+      if (end > start)
+        gaps ++;
+
+      linewidth += spacewidth + wordwidth;
+      end       = ptr = word;
+    }
+
+    // Move to the next line as needed...
+    if (lines > 0 && !pdfioStreamPuts(st, "T*\n"))
+    {
+      ret = false;
+      break;
+    }
+
+    lines ++;
+
+    // Show the line...
+    if (end > start)
+    {
+      offset = maxwidth - linewidth;
+
+      if (align == PDFIO_TEXTALIGN_JUSTIFY && gaps > 0 && offset > 0.0 && *ptr && *ptr != '\n')
+      {
+        // Spread the extra space over the gaps between words...
+        offset /= gaps;
+
+        if (!pdfioStreamPuts(st, "["))
+        {
+          ret = false;
+          break;
+        }
+
+        for (frag = start, spaces = start; ret && spaces < end;)
+        {
+          // Find the start of the next word after a gap...
+          for (; spaces < end && *spaces == ' '; spaces ++);
+          for (; spaces < end && *spaces != ' '; spaces ++);
+          for (word = spaces; word < end && *word == ' '; word ++);
+
+          if (!write_string(st, unicode, frag, (size_t)(word - frag), NULL) || (word < end && !pdfioStreamPrintf(st, "%g", -offset)))
+            ret = false;
+
+          frag = spaces = word;
+        }
+
+        if (ret && !pdfioStreamPuts(st, "]TJ\n"))
+          ret = false;
+      }
+      else if ((align == PDFIO_TEXTALIGN_CENTER || align == PDFIO_TEXTALIGN_RIGHT) && offset > 0.0)
+      {
+        // Offset the line from the left side...
+        if (align == PDFIO_TEXTALIGN_CENTER)
+          offset *= 0.5;
+
+        if (!pdfioStreamPrintf(st, "[%g", -offset) || !write_string(st, unicode, start, (size_t)(end - start), NULL) || !pdfioStreamPuts(st, "]TJ\n"))
+          ret = false;
+      }
+      else if (!write_string(st, unicode, start, (size_t)(end - start), NULL) || !pdfioStreamPuts(st, "Tj\n"))
+      {
+        ret = false;
+      }
+    }
+
+    // Skip the newline at the end of the line, if any...
+    if (*ptr == '\n')
+      ptr ++;
+  }
+
+  release_text_widths(&tw);
+
+  if (num_lines)
+    *num_lines = lines;
+
+  return (ret);
+}
+
+
 //
 // 'pdfioFileCreateBaseFontObj()' - Create one of the base 14 PDF fonts.
 //
@@ -1501,6 +1884,13 @@ pdfioFileCreateFontObjFromBase(
 // or to only support the Windows CP1252 (ISO-8859-1 with additional
 // characters such as the Euro symbol) subset of Unicode.
 //
+// Embedding the same font file again with the same "unicode" value returns the
+// existing font object.
+//
+// When the `PDFIO_OPTION_SUBSET_FONTS` option is set and "unicode" is `true`,
+// only the glyphs for the characters shown using the Unicode text functions are
+// embedded, and the font data is written when the PDF file is closed.
+//
 
 pdfio_obj_t *				// O - Font object
 pdfioFileCreateFontObjFromFile(
@@ -1508,20 +1898,11 @@ pdfioFileCreateFontObjFromFile(
     const char   *filename,		// I - Filename
     bool         unicode)		// I - Force Unicode
 {
-  ttf_t		*font;			// TrueType font
-  ttf_rect_t	bounds;			// Font bounds
-  pdfio_dict_t	*dict,			// Font dictionary
-		*desc,			// Font descriptor
-		*file;			// Font file dictionary
-  pdfio_obj_t	*obj = NULL,		// Font object
-		*desc_obj,		// Font descriptor object
-		*file_obj;		// Font file object
-  const char	*basefont;		// Base font name
-  pdfio_array_t	*bbox;			// Font bounding box array
-  pdfio_stream_t *st;			// Font stream
-  int		fd = -1;		// File
-  unsigned char	buffer[16384];		// Read buffer
-  ssize_t	bytes;			// Bytes read
+  pdfio_font_t	*font;			// Font
+  pdfio_obj_t	*obj;			// Font object
+  int		fd;			// File
+  bool		cache;			// Cache the font object?
+  uint8_t	digest[32];		// Font file digest
 
 
   // Range check input...
@@ -1540,336 +1921,157 @@ pdfioFileCreateFontObjFromFile(
     return (NULL);
   }
 
-  if ((font = ttfCreate(filename, 0, (ttf_err_cb_t)ttf_error_cb, pdf)) == NULL)
+  // See if we have already embedded this font...
+  if ((cache = get_file_digest(fd, "font", filename, unicode, digest)) && (obj = _pdfioFileFindHashedObj(pdf, digest)) != NULL)
   {
     close(fd);
-    return (NULL);
+    return (obj);
   }
 
-  // Create the font file dictionary and object...
-  if ((file = pdfioDictCreate(pdf)) == NULL)
-    goto done;
-
-  pdfioDictSetName(file, "Filter", "FlateDecode");
-
-  if ((file_obj = pdfioFileCreateObj(pdf, file)) == NULL)
-    goto done;
-
-  if ((st = pdfioObjCreateStream(file_obj, PDFIO_FILTER_FLATE)) == NULL)
-    goto done;
+  // Load the font and create the font object...
+  if ((font = new_font()) == NULL)
+  {
+    _pdfioFileError(pdf, "Unable to allocate memory for font.");
+    close(fd);
+    return (NULL);
+  }
 
-  while ((bytes = read(fd, buffer, sizeof(buffer))) > 0)
+  if (!load_font(font, fd, filename, false, (ttf_err_cb_t)ttf_error_cb, pdf))
   {
-    if (!pdfioStreamWrite(st, buffer, (size_t)bytes))
-    {
-      pdfioStreamClose(st);
-      goto done;
-    }
+    close(fd);
+    pdfioFontDelete(font);
+    return (NULL);
   }
 
   close(fd);
-  fd = -1;
-  pdfioStreamClose(st);
 
-  // Create the font descriptor dictionary and object...
-  if ((bbox = pdfioArrayCreate(pdf)) == NULL)
-    goto done;
-
-  ttfGetBounds(font, &bounds);
-
-  pdfioArrayAppendNumber(bbox, bounds.left);
-  pdfioArrayAppendNumber(bbox, bounds.bottom);
-  pdfioArrayAppendNumber(bbox, bounds.right);
-  pdfioArrayAppendNumber(bbox, bounds.top);
-
-  if ((desc = pdfioDictCreate(pdf)) == NULL)
-    goto done;
-
-  basefont = pdfioStringCreate(pdf, ttfGetPostScriptName(font));
-
-  pdfioDictSetName(desc, "Type", "FontDescriptor");
-  pdfioDictSetName(desc, "FontName", basefont);
-  pdfioDictSetObj(desc, "FontFile2", file_obj);
-  pdfioDictSetNumber(desc, "Flags", ttfIsFixedPitch(font) ? 0x21 : 0x20);
-  pdfioDictSetArray(desc, "FontBBox", bbox);
-  pdfioDictSetNumber(desc, "ItalicAngle", ttfGetItalicAngle(font));
-  pdfioDictSetNumber(desc, "Ascent", ttfGetAscent(font));
-  pdfioDictSetNumber(desc, "Descent", ttfGetDescent(font));
-  pdfioDictSetNumber(desc, "CapHeight", ttfGetCapHeight(font));
-  pdfioDictSetNumber(desc, "XHeight", ttfGetXHeight(font));
-  // Note: No TrueType value exists for this but PDF requires it, so we
-  // calculate a generic value from 50 to 250 based on the weight...
-  pdfioDictSetNumber(desc, "StemV", ttfGetWeight(font) / 4 + 25);
-
-  if ((desc_obj = pdfioFileCreateObj(pdf, desc)) == NULL)
-    goto done;
-
-  pdfioObjClose(desc_obj);
-
-  if (unicode)
+  if ((obj = create_font_obj(pdf, font, unicode)) == NULL)
   {
-    // Unicode (CID) font...
-    pdfio_dict_t	*cid2gid,	// CIDToGIDMap dictionary
-			*to_unicode;	// ToUnicode dictionary
-    pdfio_obj_t		*cid2gid_obj,	// CIDToGIDMap object
-			*to_unicode_obj;// ToUnicode object
-    size_t		i,		// Looping var
-			start,		// Start character
-			num_cmap;	// Number of CMap entries
-    const int		*cmap;		// CMap entries
-    int			min_glyph,	// First glyph
-			max_glyph;	// Last glyph
-    unsigned short	glyphs[65536];	// Glyph to Unicode mapping
-    unsigned char	*bufptr,	// Pointer into buffer
-			*bufend;	// End of buffer
-    pdfio_dict_t	*type2;		// CIDFontType2 font dictionary
-    pdfio_obj_t		*type2_obj;	// CIDFontType2 font object
-    pdfio_array_t	*descendants;	// Decendant font list
-    pdfio_dict_t	*sidict;	// CIDSystemInfo dictionary
-    pdfio_array_t	*w_array,	// Width array
-			*temp_array;	// Temporary width sub-array
-    int			w0, w1;		// Widths
-
-    // Create a CIDSystemInfo mapping to Adobe UCS2 v0 (Unicode)
-    if ((sidict = pdfioDictCreate(pdf)) == NULL)
-      goto done;
-
-    pdfioDictSetString(sidict, "Registry", "Adobe");
-    pdfioDictSetString(sidict, "Ordering", "Identity");
-    pdfioDictSetNumber(sidict, "Supplement", 0);
-
-    // Create a CIDToGIDMap object for the Unicode font...
-    if ((cid2gid = pdfioDictCreate(pdf)) == NULL)
-      goto done;
-
-#ifndef DEBUG
-    pdfioDictSetName(cid2gid, "Filter", "FlateDecode");
-#endif // !DEBUG
-
-    if ((cid2gid_obj = pdfioFileCreateObj(pdf, cid2gid)) == NULL)
-      goto done;
-
-#ifdef DEBUG
-    if ((st = pdfioObjCreateStream(cid2gid_obj, PDFIO_FILTER_NONE)) == NULL)
-#else
-    if ((st = pdfioObjCreateStream(cid2gid_obj, PDFIO_FILTER_FLATE)) == NULL)
-#endif // DEBUG
-      goto done;
-
-    cmap      = ttfGetCMap(font, &num_cmap);
-    min_glyph = 65536;
-    max_glyph = 0;
-    memset(glyphs, 0, sizeof(glyphs));
-
-    PDFIO_DEBUG("pdfioFileCreateFontObjFromFile: num_cmap=%u\n", (unsigned)num_cmap);
-
-    for (i = 0, bufptr = buffer, bufend = buffer + sizeof(buffer); i < num_cmap; i ++)
-    {
-      PDFIO_DEBUG("pdfioFileCreateFontObjFromFile: cmap[%u]=%d\n", (unsigned)i, cmap[i]);
-      if (cmap[i] < 0)
-      {
-        // Map undefined glyph to .notdef...
-        *bufptr++ = 0;
-        *bufptr++ = 0;
-      }
-      else
-      {
-        // Map to specified glyph...
-        *bufptr++ = (unsigned char)(cmap[i] >> 8);
-        *bufptr++ = (unsigned char)(cmap[i] & 255);
-
-        glyphs[cmap[i]] = (unsigned short)i;
-        if (cmap[i] < min_glyph)
-          min_glyph = cmap[i];
-        if (cmap[i] > max_glyph)
-          max_glyph = cmap[i];
-      }
-
-      if (bufptr >= bufend)
-      {
-        // Flush buffer...
-        if (!pdfioStreamWrite(st, buffer, (size_t)(bufptr - buffer)))
-        {
-	  pdfioStreamClose(st);
-	  goto done;
-        }
-
-        bufptr = buffer;
-      }
-    }
-
-    if (bufptr > buffer)
-    {
-      // Flush buffer...
-      if (!pdfioStreamWrite(st, buffer, (size_t)(bufptr - buffer)))
-      {
-	pdfioStreamClose(st);
-	goto done;
-      }
-    }
-
-    pdfioStreamClose(st);
-
-    // ToUnicode mapping object
-    to_unicode = pdfioDictCreate(pdf);
-    pdfioDictSetName(to_unicode, "Type", "CMap");
-    pdfioDictSetName(to_unicode, "CMapName", "Adobe-Identity-UCS2");
-    pdfioDictSetDict(to_unicode, "CIDSystemInfo", sidict);
-
-#ifndef DEBUG
-    pdfioDictSetName(to_unicode, "Filter", "FlateDecode");
-#endif // !DEBUG
-
-    if ((to_unicode_obj = pdfioFileCreateObj(pdf, to_unicode)) == NULL)
-      goto done;
-
-#ifdef DEBUG
-    if ((st = pdfioObjCreateStream(to_unicode_obj, PDFIO_FILTER_NONE)) == NULL)
-#else
-    if ((st = pdfioObjCreateStream(to_unicode_obj, PDFIO_FILTER_FLATE)) == NULL)
-#endif // DEBUG
-      goto done;
-
-    pdfioStreamPuts(st,
-		    "stream\n"
-		    "/CIDInit /ProcSet findresource begin\n"
-		    "12 dict begin\n"
-		    "begincmap\n"
-		    "/CIDSystemInfo<<\n"
-		    "/Registry (Adobe)\n"
-		    "/Ordering (UCS2)\n"
-		    "/Supplement 0\n"
-		    ">> def\n"
-		    "/CMapName /Adobe-Identity-UCS2 def\n"
-		    "/CMapType 2 def\n"
-		    "1 begincodespacerange\n"
-		    "<0000> <FFFF>\n"
-		    "endcodespacerange\n"
-		    "1 beginbfrange\n"
-		    "<0000> <FFFF> <0000>\n"
-                    "endbfrange\n"
-                    "endcmap\n"
-                    "CMapName currentdict /CMap defineresource pop\n"
-                    "end\n"
-                    "end\n");
-
-    pdfioStreamClose(st);
-
-    // Create a CIDFontType2 dictionary for the Unicode font...
-    if ((type2 = pdfioDictCreate(pdf)) == NULL)
-      goto done;
-
-    // Width array
-    if ((w_array = pdfioArrayCreate(pdf)) == NULL)
-      goto done;
-
-    for (start = 0, w0 = ttfGetWidth(font, 0), w1 = 0, i = 1; i < 65536; start = i, w0 = w1, i ++)
-    {
-      while (i < 65536 && (w1 = ttfGetWidth(font, (int)i)) == w0)
-        i ++;
+    pdfioFontDelete(font);
+    return (NULL);
+  }
 
-      if ((i - start) > 1)
-      {
-        // Encode a repeating sequence...
-        pdfioArrayAppendNumber(w_array, start);
-        pdfioArrayAppendNumber(w_array, i - 1);
-        pdfioArrayAppendNumber(w_array, w0);
-      }
-      else
-      {
-        // Encode a non-repeating sequence...
-        pdfioArrayAppendNumber(w_array, start);
+  _pdfioObjSetExtension(obj, font, (_pdfio_extfree_t)pdfioFontDelete);
 
-        if ((temp_array = pdfioArrayCreate(pdf)) == NULL)
-	  goto done;
+  if (cache)
+    _pdfioFileAddHashedObj(pdf, obj, digest);
 
-        pdfioArrayAppendNumber(temp_array, w0);
-        for (w0 = w1, i ++; i < 65536; w0 = w1, i ++)
-        {
-          if ((w1 = ttfGetWidth(font, (int)i)) == w0 && i < 65535)
-            break;
+  return (obj);
+}
 
-	  pdfioArrayAppendNumber(temp_array, w0);
-        }
 
-        if (i == 65536)
-	  pdfioArrayAppendNumber(temp_array, w0);
-	else
-	  i --;
+//
+// 'pdfioFileCreateFontObjFromFont()' - Add a shared font object to a PDF file.
+//
+// This function embeds a TrueType/OpenType font that was loaded using
+// @link pdfioFontCreate@ into a PDF file.  The "unicode" parameter has the
+// same meaning as for @link pdfioFileCreateFontObjFromFile@.  Embedding the
+// same font again with the same "unicode" value returns the existing font
+// object.
+//
+// The font must not be deleted until the PDF file is closed.
+//
 
-        pdfioArrayAppendArray(w_array, temp_array);
-      }
-    }
+pdfio_obj_t *				// O - Font object
+pdfioFileCreateFontObjFromFont(
+    pdfio_file_t *pdf,			// I - PDF file
+    pdfio_font_t *font,			// I - Font
+    bool         unicode)		// I - Force Unicode
+{
+  pdfio_obj_t	*obj;			// Font object
+  _pdfio_sha256_t ctx;			// SHA-256 context
+  uint8_t	digest[32];		// Font digest
+  static const char *types[2] = { "font-cp1252", "font-unicode" };
+					// Digest prefixes
 
-    // Then the dictionary for the CID base font...
-    pdfioDictSetName(type2, "Type", "Font");
-    pdfioDictSetName(type2, "Subtype", "CIDFontType2");
-    pdfioDictSetName(type2, "BaseFont", basefont);
-    pdfioDictSetDict(type2, "CIDSystemInfo", sidict);
-    pdfioDictSetObj(type2, "CIDToGIDMap", cid2gid_obj);
-    pdfioDictSetObj(type2, "FontDescriptor", desc_obj);
-    pdfioDictSetArray(type2, "W", w_array);
 
-    if ((type2_obj = pdfioFileCreateObj(pdf, type2)) == NULL)
-      goto done;
+  // Range check input...
+  if (!pdf)
+    return (NULL);
 
-    pdfioObjClose(type2_obj);
+  if (!font)
+  {
+    _pdfioFileError(pdf, "No TrueType/OpenType font specified.");
+    return (NULL);
+  }
 
-    // Create a Type 0 font object...
-    if ((descendants = pdfioArrayCreate(pdf)) == NULL)
-      goto done;
+  // See if we have already embedded this font...
+  _pdfioCryptoSHA256Init(&ctx);
+  _pdfioCryptoSHA256Append(&ctx, (const uint8_t *)types[unicode], strlen(types[unicode]) + 1);
+  _pdfioCryptoSHA256Append(&ctx, font->digest, sizeof(font->digest));
+  _pdfioCryptoSHA256Finish(&ctx, digest);
 
-    pdfioArrayAppendObj(descendants, type2_obj);
+  if ((obj = _pdfioFileFindHashedObj(pdf, digest)) != NULL)
+    return (obj);
 
-    if ((dict = pdfioDictCreate(pdf)) == NULL)
-      goto done;
+  // Create the font object, the font data is owned by the caller...
+  if ((obj = create_font_obj(pdf, font, unicode)) == NULL)
+    return (NULL);
 
-    pdfioDictSetName(dict, "Type", "Font");
-    pdfioDictSetName(dict, "Subtype", "Type0");
-    pdfioDictSetName(dict, "BaseFont", basefont);
-    pdfioDictSetArray(dict, "DescendantFonts", descendants);
-    pdfioDictSetName(dict, "Encoding", "Identity-H");
-    pdfioDictSetObj(dict, "ToUnicode", to_unicode_obj);
+  _pdfioObjSetExtension(obj, font, NULL);
+  _pdfioFileAddHashedObj(pdf, obj, digest);
 
-    if ((obj = pdfioFileCreateObj(pdf, dict)) != NULL)
-      pdfioObjClose(obj);
-  }
-  else
-  {
-    // Simple (CP1282 or custom encoding) 8-bit font...
-    if (ttfGetMaxChar(font) >= 255 && !pdf->cp1252_obj && !create_cp1252(pdf))
-      goto done;
+  return (obj);
+}
 
-    // Create a TrueType font object...
-    if ((dict = pdfioDictCreate(pdf)) == NULL)
-      goto done;
 
-    pdfioDictSetName(dict, "Type", "Font");
-    pdfioDictSetName(dict, "Subtype", "TrueType");
-    pdfioDictSetName(dict, "BaseFont", basefont);
-    if (ttfGetMaxChar(font) >= 255)
-      pdfioDictSetObj(dict, "Encoding", pdf->cp1252_obj);
+//
+// 'pdfioFileCreateFormObj()' - Add a form object.
+//
+// This function creates a form XObject, which is a reusable piece of page
+// content such as a chart marker, logo, or letterhead:
+//
+// ```
+// pdfio_rect_t bbox = { -3.0, -3.0, 3.0, 3.0 };
+// pdfio_obj_t *marker = pdfioFileCreateFormObj(pdf, &bbox, NULL);
+// pdfio_stream_t *st = pdfioObjCreateStream(marker, PDFIO_FILTER_FLATE);
+//
+// pdfioContentPathRect(st, -2.0, -2.0, 4.0, 4.0);
+// pdfioContentFill(st, false);
+// pdfioStreamClose(st);
+// ```
+//
+// The "bbox" argument specifies the bounding box of the form content and the
+// "resources" argument, if not `NULL`, specifies the fonts, images, and other
+// resources used by the form content.  After writing the form content, add
+// the form object to the page dictionary using @link pdfioPageDictAddImage@
+// and draw it using @link pdfioContentDrawImage@ or
+// @link pdfioContentDrawMarkers@.
+//
 
-    pdfioDictSetObj(dict, "FontDescriptor", desc_obj);
+pdfio_obj_t *				// O - Object
+pdfioFileCreateFormObj(
+    pdfio_file_t *pdf,			// I - PDF file
+    pdfio_rect_t *bbox,			// I - Bounding box
+    pdfio_dict_t *resources)		// I - Resource dictionary or `NULL` for none
+{
+  pdfio_dict_t	*dict;			// Form dictionary
 
-    if ((obj = pdfioFileCreateObj(pdf, dict)) != NULL)
-      pdfioObjClose(obj);
-  }
 
-  done:
+  // Range check input...
+  if (!pdf || !bbox)
+    return (NULL);
 
-  if (fd >= 0)
-    close(fd);
+  // Create the form dictionary...
+  if ((dict = pdfioDictCreate(pdf)) == NULL)
+    return (NULL);
 
-  _pdfioObjSetExtension(obj, font, (_pdfio_extfree_t)ttfDelete);
+  pdfioDictSetName(dict, "Type", "XObject");
+  pdfioDictSetName(dict, "Subtype", "Form");
+  pdfioDictSetRect(dict, "BBox", bbox);
+  if (resources)
+    pdfioDictSetDict(dict, "Resources", resources);
 
-  return (obj);
+  return (pdfioFileCreateObj(pdf, dict));
 }
 
 
 //
 // 'pdfioFileCreateICCObjFromFile()' - Add an ICC profile object to a PDF file.
 //
+// If the same ICC profile file was already added with the same number of
+// colors, the existing object is returned.
+//
 
 pdfio_obj_t *				// O - Object
 pdfioFileCreateICCObjFromFile(
@@ -1883,6 +2085,8 @@ pdfioFileCreateICCObjFromFile(
   int		fd;			// File
   unsigned char	buffer[16384];		// Read buffer
   ssize_t	bytes;			// Bytes read
+  bool		cache;			// Cache the ICC profile object?
+  uint8_t	digest[32];		// ICC profile file digest
 
 
   // Range check input...
@@ -1908,6 +2112,13 @@ pdfioFileCreateICCObjFromFile(
     return (NULL);
   }
 
+  // See if we have already embedded this ICC profile...
+  if ((cache = get_file_digest(fd, "icc", filename, (unsigned)num_colors, digest)) && (obj = _pdfioFileFindHashedObj(pdf, digest)) != NULL)
+  {
+    close(fd);
+    return (obj);
+  }
+
   // Create the ICC profile object...
   if ((dict = pdfioDictCreate(pdf)) == NULL)
   {
@@ -1943,19 +2154,254 @@ pdfioFileCreateICCObjFromFile(
   close(fd);
   pdfioStreamClose(st);
 
+  if (cache)
+    _pdfioFileAddHashedObj(pdf, obj, digest);
+
   return (obj);
 }
 
 
 //
-// 'pdfioFileCreateImageObjFromData()' - Add image object(s) to a PDF file from memory.
+// 'pdfioFileCreateImageObjFromCallback()' - Add image object(s) to a PDF file using a callback.
 //
-// This function creates image object(s) in a PDF file from a data buffer in
-// memory.  The "data" parameter points to the image data as 8-bit color values.
-// The "width" and "height" parameters specify the image dimensions.  The
-// "num_colors" parameter specifies the number of color components (`1` for
-// grayscale, `3` for RGB, and `4` for CMYK) and the "alpha" parameter specifies
-// whether each color tuple is followed by an alpha value.  The "color_data"
+// This function creates image object(s) in a PDF file from lines of image data
+// that are provided by a callback function, for example when decoding or
+// generating a large image that should not be held in memory.  The "cb"
+// parameter specifies the callback that is called once for each line "y"
+// from `0` to "height" - 1 and must copy "linelen" bytes of 8-bit color values
+// (and alpha values when "alpha" is `true`) to the "line" buffer.  The
+// callback returns `true` to continue or `false` to stop on an error.  The
+// other parameters are the same as for @link pdfioFileCreateImageObjFromData@.
+//
+// Only one line of image data is held in memory.  When creating an image with
+// alpha, the "soft mask" image object is compressed in memory at the same time
+// as the primary image is written and then written to the PDF file.
+//
+// Note: Unlike @link pdfioFileCreateImageObjFromData@, images created by this
+// function are not checked against previously added images.
+//
+
+pdfio_obj_t *				// O - Object
+pdfioFileCreateImageObjFromCallback(
+    pdfio_file_t     *pdf,		// I - PDF file
+    pdfio_image_cb_t cb,		// I - Image line callback
+    void             *cb_data,		// I - Callback data
+    size_t           width,		// I - Width of image
+    size_t           height,		// I - Height of image
+    size_t           num_colors,	// I - Number of colors
+    pdfio_array_t    *color_data,	// I - Colorspace data or `NULL` for default
+    bool             alpha,		// I - `true` if lines contain an alpha channel
+    bool             interpolate)	// I - Interpolate image data?
+{
+  bool			ret = true;	// Return value
+  pdfio_dict_t		*dict,		// Image dictionary
+			*decode;	// DecodeParms dictionary
+  pdfio_obj_t		*obj,		// Image object
+			*mask_obj = NULL;
+					// Mask image object, if any
+  pdfio_stream_t	*st,		// Image stream
+			*mask_st = NULL;// Mask image stream, if any
+  size_t		x, y,		// X and Y position in image
+			bpp,		// Bytes per pixel
+			linelen;	// Line length
+  unsigned char		*line = NULL,	// Current line from callback
+			*cline = NULL,	// Color values for current line
+			*mline = NULL,	// Mask values for current line
+			*lineptr,	// Pointer into line
+			*clineptr,	// Pointer into color values
+			*mlineptr;	// Pointer into mask values
+  static const char	*defcolors[] =	// Default ColorSpace values
+  {
+    NULL,
+    "DeviceGray",
+    NULL,
+    "DeviceRGB",
+    "DeviceCMYK"
+  };
+
+
+  // Range check input...
+  if (!pdf || !cb || !width || !height || num_colors < 1 || num_colors == 2 || num_colors > 4)
+    return (NULL);
+
+  bpp     = alpha ? num_colors + 1 : num_colors;
+  linelen = bpp * width;
+
+  // Allocate memory for one line of data...
+  if ((line = malloc(linelen)) == NULL)
+  {
+    _pdfioFileError(pdf, "Unable to allocate memory for image data.");
+    return (NULL);
+  }
+
+  if (alpha && ((cline = malloc(num_colors * width)) == NULL || (mline = malloc(width)) == NULL))
+  {
+    _pdfioFileError(pdf, "Unable to allocate memory for image data.");
+    free(line);
+    free(cline);
+    return (NULL);
+  }
+
+  // Start a mask image, as needed...
+  if (alpha)
+  {
+    // Create the image mask dictionary...
+    if ((dict = pdfioDictCreate(pdf)) == NULL)
+      goto error;
+
+    pdfioDictSetName(dict, "Type", "XObject");
+    pdfioDictSetName(dict, "Subtype", "Image");
+    pdfioDictSetNumber(dict, "Width", width);
+    pdfioDictSetNumber(dict, "Height", height);
+    pdfioDictSetNumber(dict, "BitsPerComponent", 8);
+    pdfioDictSetName(dict, "ColorSpace", "DeviceGray");
+    pdfioDictSetName(dict, "Filter", "FlateDecode");
+
+    if ((decode = pdfioDictCreate(pdf)) == NULL)
+      goto error;
+
+    pdfioDictSetNumber(decode, "BitsPerComponent", 8);
+    pdfioDictSetNumber(decode, "Colors", 1);
+    pdfioDictSetNumber(decode, "Columns", width);
+    pdfioDictSetNumber(decode, "Predictor", _PDFIO_PREDICTOR_PNG_AUTO);
+    pdfioDictSetDict(dict, "DecodeParms", decode);
+
+    // Create the mask object and a deferred stream so the mask is compressed
+    // while the primary image is being written...
+    if ((mask_obj = pdfioFileCreateObj(pdf, dict)) == NULL)
+      goto error;
+
+    if ((mask_st = _pdfioStreamCreate(mask_obj, NULL, PDFIO_FILTER_FLATE, true)) == NULL)
+      goto error;
+  }
+
+  // Now create the image...
+  if ((dict = pdfioDictCreate(pdf)) == NULL)
+    goto error;
+
+  pdfioDictSetName(dict, "Type", "XObject");
+  pdfioDictSetName(dict, "Subtype", "Image");
+  pdfioDictSetBoolean(dict, "Interpolate", interpolate);
+  pdfioDictSetNumber(dict, "Width", width);
+  pdfioDictSetNumber(dict, "Height", height);
+  pdfioDictSetNumber(dict, "BitsPerComponent", 8);
+  pdfioDictSetName(dict, "Filter", "FlateDecode");
+
+  if (color_data)
+    pdfioDictSetArray(dict, "ColorSpace", color_data);
+  else
+    pdfioDictSetName(dict, "ColorSpace", defcolors[num_colors]);
+
+  if (mask_obj)
+    pdfioDictSetObj(dict, "SMask", mask_obj);
+
+  if ((decode = pdfioDictCreate(pdf)) == NULL)
+    goto error;
+
+  pdfioDictSetNumber(decode, "BitsPerComponent", 8);
+  pdfioDictSetNumber(decode, "Colors", num_colors);
+  pdfioDictSetNumber(decode, "Columns", width);
+  pdfioDictSetNumber(decode, "Predictor", _PDFIO_PREDICTOR_PNG_AUTO);
+  pdfioDictSetDict(dict, "DecodeParms", decode);
+
+  if ((obj = pdfioFileCreateObj(pdf, dict)) == NULL)
+    goto error;
+
+  if ((st = pdfioObjCreateStream(obj, PDFIO_FILTER_FLATE)) == NULL)
+    goto error;
+
+  // Write each line...
+  for (y = 0; y < height; y ++)
+  {
+    if (!(cb)(cb_data, y, line, linelen))
+    {
+      _pdfioFileError(pdf, "Unable to get line %lu of image data.", (unsigned long)y);
+      ret = false;
+      break;
+    }
+
+    if (alpha)
+    {
+      // Split the color and alpha values...
+      switch (num_colors)
+      {
+	case 1 :
+	    for (x = width, lineptr = line, clineptr = cline, mlineptr = mline; x > 0; x --)
+	    {
+	      *clineptr++ = *lineptr++;
+	      *mlineptr++ = *lineptr++;
+	    }
+	    break;
+	case 3 :
+	    for (x = width, lineptr = line, clineptr = cline, mlineptr = mline; x > 0; x --)
+	    {
+	      *clineptr++ = *lineptr++;
+	      *clineptr++ = *lineptr++;
+	      *clineptr++ = *lineptr++;
+	      *mlineptr++ = *lineptr++;
+	    }
+	    break;
+	case 4 :
+	    for (x = width, lineptr = line, clineptr = cline, mlineptr = mline; x > 0; x --)
+	    {
+	      *clineptr++ = *lineptr++;
+	      *clineptr++ = *lineptr++;
+	      *clineptr++ = *lineptr++;
+	      *clineptr++ = *lineptr++;
+	      *mlineptr++ = *lineptr++;
+	    }
+	    break;
+      }
+
+      if (!pdfioStreamWrite(st, cline, num_colors * width) || !pdfioStreamWrite(mask_st, mline, width))
+      {
+        ret = false;
+        break;
+      }
+    }
+    else if (!pdfioStreamWrite(st, line, linelen))
+    {
+      ret = false;
+      break;
+    }
+  }
+
+  // Close the image stream and then write the mask image, if any...
+  if (!pdfioStreamClose(st))
+    ret = false;
+
+  if (mask_st && !pdfioStreamClose(mask_st))
+    ret = false;
+
+  free(line);
+  free(cline);
+  free(mline);
+
+  return (ret ? obj : NULL);
+
+  // If we get here there was an error...
+  error:
+
+  if (mask_st)
+    pdfioStreamClose(mask_st);
+
+  free(line);
+  free(cline);
+  free(mline);
+
+  return (NULL);
+}
+
+
+//
+// 'pdfioFileCreateImageObjFromData()' - Add image object(s) to a PDF file from memory.
+//
+// This function creates image object(s) in a PDF file from a data buffer in
+// memory.  The "data" parameter points to the image data as 8-bit color values.
+// The "width" and "height" parameters specify the image dimensions.  The
+// "num_colors" parameter specifies the number of color components (`1` for
+// grayscale, `3` for RGB, and `4` for CMYK) and the "alpha" parameter specifies
+// whether each color tuple is followed by an alpha value.  The "color_data"
 // parameter specifies an optional color space array for the image - if `NULL`,
 // the image is encoded in the corresponding device color space.  The
 // "interpolate" parameter specifies whether to interpolate when scaling the
@@ -1964,6 +2410,9 @@ pdfioFileCreateICCObjFromFile(
 // Note: When creating an image object with alpha, a second image object is
 // created to hold the "soft mask" data for the primary image.
 //
+// Image data that matches a previous call (same pixels, dimensions, and color
+// space) reuses the existing image object.
+//
 
 pdfio_obj_t *				// O - Object
 pdfioFileCreateImageObjFromData(
@@ -1988,6 +2437,9 @@ pdfioFileCreateImageObjFromData(
   const unsigned char	*dataptr;	// Pointer into image data
   unsigned char		*line = NULL,	// Current line
 			*lineptr;	// Pointer into line
+  _pdfio_sha256_t	ctx;		// SHA-256 context
+  uint8_t		digest[32];	// Image data digest
+  char			params[256];	// Image parameters
   static const char	*defcolors[] =	// Default ColorSpace values
   {
     NULL,
@@ -2002,10 +2454,33 @@ pdfioFileCreateImageObjFromData(
   if (!pdf || !data || !width || !height || num_colors < 1 || num_colors == 2 || num_colors > 4)
     return (NULL);
 
-  // Allocate memory for one line of data...
   bpp     = alpha ? num_colors + 1 : num_colors;
   linelen = num_colors * width;
 
+  // See if we have already embedded this image...
+  snprintf(params, sizeof(params), "image-data %lu %lu %lu %d %d", (unsigned long)width, (unsigned long)height, (unsigned long)num_colors, alpha, interpolate);
+
+  _pdfioCryptoSHA256Init(&ctx);
+  _pdfioCryptoSHA256Append(&ctx, (uint8_t *)params, strlen(params) + 1);
+
+  if (color_data)
+  {
+    _pdfio_value_t	value;		// ColorSpace value
+
+    value.type        = PDFIO_VALTYPE_ARRAY;
+    value.value.array = color_data;
+
+    if (!_pdfioValueDigest(pdf, &value, &ctx))
+      return (NULL);
+  }
+
+  _pdfioCryptoSHA256Append(&ctx, data, width * height * bpp);
+  _pdfioCryptoSHA256Finish(&ctx, digest);
+
+  if ((obj = _pdfioFileFindHashedObj(pdf, digest)) != NULL)
+    return (obj);
+
+  // Allocate memory for one line of data...
   if ((line = malloc(linelen)) == NULL)
     return (NULL);
 
@@ -2153,6 +2628,8 @@ pdfioFileCreateImageObjFromData(
   free(line);
   pdfioStreamClose(st);
 
+  _pdfioFileAddHashedObj(pdf, obj, digest);
+
   return (obj);
 }
 
@@ -2169,6 +2646,9 @@ pdfioFileCreateImageObjFromData(
 // > without interlacing or alpha.  Transparency (masking) based on color/index
 // > is supported.
 //
+// Adding the same unchanged file again with the same "interpolate" value
+// returns the existing image object.
+//
 
 pdfio_obj_t *				// O - Object
 pdfioFileCreateImageObjFromFile(
@@ -2176,11 +2656,10 @@ pdfioFileCreateImageObjFromFile(
     const char   *filename,		// I - Filename
     bool         interpolate)		// I - Interpolate image data?
 {
-  pdfio_dict_t	*dict;			// Image dictionary
   pdfio_obj_t	*obj;			// Image object
-  int		fd;			// File
-  unsigned char	buffer[32];		// Read buffer
-  _pdfio_image_func_t copy_func = NULL;	// Image copy function
+  _pdfio_isrc_t	src;			// Image file source
+  bool		cache;			// Cache the image object?
+  uint8_t	digest[32];		// Image file digest
 
 
   // Range check input...
@@ -2188,125 +2667,301 @@ pdfioFileCreateImageObjFromFile(
     return (NULL);
 
   // Try opening the file...
-  if ((fd = open(filename, O_RDONLY | O_BINARY)) < 0)
-  {
-    _pdfioFileError(pdf, "Unable to open image file '%s': %s", filename, strerror(errno));
-    return (NULL);
-  }
-
-  // Read the file header to determine the file format...
-  if (read(fd, buffer, sizeof(buffer)) < (ssize_t)sizeof(buffer))
-  {
-    _pdfioFileError(pdf, "Unable to read header from image file '%s'.", filename);
-    close(fd);
-    return (NULL);
-  }
-
-  lseek(fd, 0, SEEK_SET);
+  memset(&src, 0, sizeof(src));
 
-  if (!memcmp(buffer, "\211PNG\015\012\032\012\000\000\000\015IHDR", 16))
-  {
-    // PNG image...
-    copy_func = copy_png;
-  }
-  else if (!memcmp(buffer, "\377\330\377", 3))
-  {
-   // JPEG image...
-    copy_func = copy_jpeg;
-  }
-  else
+  if ((src.fd = open(filename, O_RDONLY | O_BINARY)) < 0)
   {
-    // Something else that isn't supported...
-    _pdfioFileError(pdf, "Unsupported image file '%s'.", filename);
-    close(fd);
+    _pdfioFileError(pdf, "Unable to open image file '%s': %s", filename, strerror(errno));
     return (NULL);
   }
 
-  // Create the base image dictionary the copy the file into an object...
-  if ((dict = pdfioDictCreate(pdf)) == NULL)
+  // See if we have already embedded this image...
+  if ((cache = get_file_digest(src.fd, "image", filename, interpolate, digest)) && (obj = _pdfioFileFindHashedObj(pdf, digest)) != NULL)
   {
-    close(fd);
-    return (NULL);
+    close(src.fd);
+    return (obj);
   }
 
-  pdfioDictSetName(dict, "Type", "XObject");
-  pdfioDictSetName(dict, "Subtype", "Image");
-  pdfioDictSetBoolean(dict, "Interpolate", interpolate);
-
-  obj = (copy_func)(dict, fd);
+  // Copy the file into an object...
+  obj = copy_image(pdf, &src, filename, interpolate);
 
   // Close the file and return the object...
-  close(fd);
+  close(src.fd);
+
+  if (obj && cache)
+    _pdfioFileAddHashedObj(pdf, obj, digest);
 
   return (obj);
 }
 
 
 //
-// 'pdfioImageGetBytesPerLine()' - Get the number of bytes to read for each line.
+// 'pdfioFileCreateImageObjFromIO()' - Add an image object to a PDF file using a read callback.
+//
+// This function creates an image object in a PDF file from a JPEG or PNG file
+// that is read using the "input_cb" function, for example to copy an image
+// from a network connection or archive without writing it to a temporary file.
+// The callback is called with the "input_ctx" pointer, the offset in the
+// image file, and a buffer to fill - it returns the number of bytes read, `0`
+// at the end of the file, or `-1` on error.  The image file is read from the
+// beginning up to two times.  The "interpolate" parameter specifies whether
+// to interpolate when scaling the image on the page.
+//
+// The same limitations as @link pdfioFileCreateImageObjFromFile@ apply, and
+// images added using this function are not checked against previously added
+// images.
 //
 
-size_t					// O - Number of bytes per line
-pdfioImageGetBytesPerLine(
-    pdfio_obj_t *obj)			// I - Image object
+pdfio_obj_t *				// O - Object
+pdfioFileCreateImageObjFromIO(
+    pdfio_file_t     *pdf,		// I - PDF file
+    pdfio_input_cb_t input_cb,		// I - Read callback
+    void             *input_ctx,	// I - Read callback context
+    bool             interpolate)	// I - Interpolate image data?
 {
-  pdfio_dict_t	*params;		// DecodeParms value
-  int		width,			// Width of image
-		bpc,			// BitsPerComponent of image
-		colors;			// Number of colors in image
-
-
-  if (!obj || obj->value.type != PDFIO_VALTYPE_DICT)
-    return (0);
-
-  params = pdfioDictGetDict(obj->value.value.dict, "DecodeParms");
-  bpc    = (int)pdfioDictGetNumber(params, "BitsPerComponent");
-  colors = (int)pdfioDictGetNumber(params, "Colors");
-  width  = (int)pdfioDictGetNumber(params, "Columns");
-
-  if (width == 0)
-    width = (int)pdfioDictGetNumber(obj->value.value.dict, "Width");
+  _pdfio_isrc_t	src;			// Image file source
 
-  if (bpc == 0)
-  {
-    if ((bpc = (int)pdfioDictGetNumber(obj->value.value.dict, "BitsPerComponent")) == 0)
-      bpc = 8;
-  }
 
-  if (colors == 0)
-  {
-    const char	*cs_name;		// ColorSpace name
-    pdfio_array_t *cs_array;		// ColorSpace array
+  // Range check input...
+  if (!pdf || !input_cb)
+    return (NULL);
 
-    if ((cs_name = pdfioDictGetName(obj->value.value.dict, "ColorSpace")) == NULL)
-    {
-      if ((cs_array = pdfioDictGetArray(obj->value.value.dict, "ColorSpace")) != NULL)
-        cs_name = pdfioArrayGetName(cs_array, 0);
-    }
+  // Copy the image into an object...
+  memset(&src, 0, sizeof(src));
 
-    if (!cs_name || strstr(cs_name, "RGB"))
-      colors = 3;
-    else if (strstr(cs_name, "CMYK"))
-      colors = 4;
-    else
-      colors = 1;
-  }
+  src.fd        = -1;
+  src.input_cb  = input_cb;
+  src.input_ctx = input_ctx;
 
-  return ((size_t)((width * colors * bpc + 7) / 8));
+  return (copy_image(pdf, &src, NULL, interpolate));
 }
 
 
 //
-// 'pdfioImageGetHeight()' - Get the height of an image object.
+// 'pdfioFileCreateImageObjFromMemory()' - Add an image object to a PDF file from a JPEG or PNG file in memory.
+//
+// This function creates an image object in a PDF file from a JPEG or PNG file
+// that has been loaded into memory.  The "data" and "datalen" parameters
+// specify the image file data, which is copied directly into the image object,
+// while the "interpolate" parameter specifies whether to interpolate when
+// scaling the image on the page.
+//
+// The same limitations as @link pdfioFileCreateImageObjFromFile@ apply.
+// Adding the same image file data again with the same "interpolate" value
+// returns the existing image object.
 //
 
-double					// O - Height in lines
-pdfioImageGetHeight(pdfio_obj_t *obj)	// I - Image object
+pdfio_obj_t *				// O - Object
+pdfioFileCreateImageObjFromMemory(
+    pdfio_file_t *pdf,			// I - PDF file
+    const void   *data,			// I - Image file data
+    size_t       datalen,		// I - Length of image file data
+    bool         interpolate)		// I - Interpolate image data?
 {
-  if (obj)
-    return (pdfioDictGetNumber(obj->value.value.dict, "Height"));
-  else
-    return (0.0);
+  pdfio_obj_t		*obj;		// Image object
+  _pdfio_isrc_t		src;		// Image file source
+  _pdfio_sha256_t	ctx;		// SHA-256 context
+  char			params[64];	// Image parameters
+  uint8_t		digest[32];	// Image file digest
+
+
+  // Range check input...
+  if (!pdf || !data || !datalen)
+    return (NULL);
+
+  // See if we have already embedded this image...
+  snprintf(params, sizeof(params), "image-memory %d", interpolate);
+
+  _pdfioCryptoSHA256Init(&ctx);
+  _pdfioCryptoSHA256Append(&ctx, (uint8_t *)params, strlen(params) + 1);
+  _pdfioCryptoSHA256Append(&ctx, data, datalen);
+  _pdfioCryptoSHA256Finish(&ctx, digest);
+
+  if ((obj = _pdfioFileFindHashedObj(pdf, digest)) != NULL)
+    return (obj);
+
+  // Copy the image into an object...
+  memset(&src, 0, sizeof(src));
+
+  src.fd      = -1;
+  src.data    = (const unsigned char *)data;
+  src.datalen = datalen;
+
+  if ((obj = copy_image(pdf, &src, NULL, interpolate)) != NULL)
+    _pdfioFileAddHashedObj(pdf, obj, digest);
+
+  return (obj);
+}
+
+
+//
+// 'pdfioFontCreate()' - Load a TrueType/OpenType font for use with many PDF files.
+//
+// This function loads a TrueType/OpenType font file into memory and parses its
+// metrics so that it can be embedded in any number of PDF files using
+// @link pdfioFileCreateFontObjFromFont@ without reading or parsing the font
+// file again.  The font data is also compressed once so that copies of the
+// whole font are written without compressing it again.
+//
+// The font does not change after it is loaded, so it can be used by multiple
+// threads at the same time.  Errors are reported using the "error_cb"
+// callback - if `NULL`, errors are written to the standard error file.
+//
+// > Note: The font is not associated with a PDF file, so the "pdf" argument of
+// > the error callback is `NULL` for errors reported by this function.
+//
+
+pdfio_font_t *				// O - Font or `NULL` on error
+pdfioFontCreate(
+    const char       *filename,		// I - Filename
+    pdfio_error_cb_t error_cb,		// I - Error callback or `NULL` for default
+    void             *error_data)	// I - Error callback data
+{
+  pdfio_font_t	*font;			// Font
+  int		fd;			// File
+  _pdfio_sha256_t ctx;			// SHA-256 context
+
+
+  // Range check input...
+  if (!filename)
+    return (NULL);
+
+  // Allocate memory for the font...
+  if ((font = new_font()) == NULL)
+    return (NULL);
+
+  font->error_cb   = error_cb;
+  font->error_data = error_data;
+
+  if ((font->filename = strdup(filename)) == NULL)
+  {
+    pdfioFontDelete(font);
+    return (NULL);
+  }
+
+  // Load the font...
+  if ((fd = open(filename, O_RDONLY | O_BINARY)) < 0)
+  {
+    char	message[1024];		// Error message
+
+    snprintf(message, sizeof(message), "Unable to open font file '%s': %s", filename, strerror(errno));
+    font_error_cb(font, message);
+    pdfioFontDelete(font);
+    return (NULL);
+  }
+
+  if (!load_font(font, fd, filename, true, (ttf_err_cb_t)font_error_cb, font))
+  {
+    close(fd);
+    pdfioFontDelete(font);
+    return (NULL);
+  }
+
+  close(fd);
+
+  // Compute the digest of the font data so that PDF files only embed one copy
+  // of the font...
+  _pdfioCryptoSHA256Init(&ctx);
+  _pdfioCryptoSHA256Append(&ctx, font->data, font->datalen);
+  _pdfioCryptoSHA256Finish(&ctx, font->digest);
+
+  return (font);
+}
+
+
+//
+// 'pdfioFontDelete()' - Free the memory used by a font.
+//
+
+void
+pdfioFontDelete(pdfio_font_t *font)	// I - Font
+{
+  size_t	i;			// Looping var
+
+
+  if (!font)
+    return;
+
+  for (i = 0; i < (sizeof(font->widths) / sizeof(font->widths[0])); i ++)
+    free(font->widths[i]);
+
+#ifdef _WIN32
+  DeleteCriticalSection(&font->widths_mutex);
+#else
+  pthread_mutex_destroy(&font->widths_mutex);
+#endif // _WIN32
+
+  ttfDelete(font->ttf);
+  free(font->filename);
+  free(font->data);
+  free(font->flate);
+  free(font);
+}
+
+
+//
+// 'pdfioImageGetBytesPerLine()' - Get the number of bytes to read for each line.
+//
+
+size_t					// O - Number of bytes per line
+pdfioImageGetBytesPerLine(
+    pdfio_obj_t *obj)			// I - Image object
+{
+  pdfio_dict_t	*dict,			// Image dictionary
+		*params;		// DecodeParms value
+  int		width,			// Width of image
+		bpc,			// BitsPerComponent of image
+		colors;			// Number of colors in image
+
+
+  if ((dict = _pdfioObjGetDict(obj)) == NULL)
+    return (0);
+
+  params = pdfioDictGetDict(dict, "DecodeParms");
+  bpc    = (int)pdfioDictGetNumber(params, "BitsPerComponent");
+  colors = (int)pdfioDictGetNumber(params, "Colors");
+  width  = (int)pdfioDictGetNumber(params, "Columns");
+
+  if (width == 0)
+    width = (int)pdfioDictGetNumber(dict, "Width");
+
+  if (bpc == 0)
+  {
+    if ((bpc = (int)pdfioDictGetNumber(dict, "BitsPerComponent")) == 0)
+      bpc = 8;
+  }
+
+  if (colors == 0)
+  {
+    const char	*cs_name;		// ColorSpace name
+    pdfio_array_t *cs_array;		// ColorSpace array
+
+    if ((cs_name = pdfioDictGetName(dict, "ColorSpace")) == NULL)
+    {
+      if ((cs_array = pdfioDictGetArray(dict, "ColorSpace")) != NULL)
+        cs_name = pdfioArrayGetName(cs_array, 0);
+    }
+
+    if (!cs_name || strstr(cs_name, "RGB"))
+      colors = 3;
+    else if (strstr(cs_name, "CMYK"))
+      colors = 4;
+    else
+      colors = 1;
+  }
+
+  return ((size_t)((width * colors * bpc + 7) / 8));
+}
+
+
+//
+// 'pdfioImageGetHeight()' - Get the height of an image object.
+//
+
+double					// O - Height in lines
+pdfioImageGetHeight(pdfio_obj_t *obj)	// I - Image object
+{
+  return (pdfioDictGetNumber(_pdfioObjGetDict(obj), "Height"));
 }
 
 
@@ -2317,10 +2972,7 @@ pdfioImageGetHeight(pdfio_obj_t *obj)	// I - Image object
 double					// O - Width in columns
 pdfioImageGetWidth(pdfio_obj_t *obj)	// I - Image object
 {
-  if (obj)
-    return (pdfioDictGetNumber(obj->value.value.dict, "Width"));
-  else
-    return (0.0);
+  return (pdfioDictGetNumber(_pdfioObjGetDict(obj), "Width"));
 }
 
 
@@ -2465,508 +3117,1033 @@ pdfioPageDictAddImage(
 
 
 //
-// 'copy_jpeg()' - Copy a JPEG image.
+// 'pdfioPageScanContent()' - Scan the content streams of a page.
+//
+// This function reads and parses the decoded content streams of a page,
+// calling the supplied function "cb" for each operator:
+//
+// ```
+// bool
+// my_scan_cb(void *cb_data, const char *op, size_t num_operands,
+//            const pdfio_operand_t *operands)
+// {
+// ... "op" contains the operator name, "operands" the parsed operands ...
+// ... return true to continue or false to stop ...
+// }
+// ```
+//
+// Numbers, names, strings, booleans, and null values are passed with the
+// `PDFIO_VALTYPE_NUMBER`, `PDFIO_VALTYPE_NAME`, `PDFIO_VALTYPE_STRING`,
+// `PDFIO_VALTYPE_BOOLEAN`, and `PDFIO_VALTYPE_NULL` types.  Literal and
+// hexadecimal strings are decoded, and the "length" member holds the number of
+// bytes in the string.  Arrays and dictionaries are passed as a
+// `PDFIO_VALTYPE_ARRAY` or `PDFIO_VALTYPE_DICT` operand whose "length" member
+// holds the number of operands that follow it and belong to it - for example,
+// the `TJ` operator receives a single array operand followed by its strings
+// and numbers.
+//
+// Inline images are reported as a single "BI" operator whose operands are the
+// image dictionary keys and values, followed by a `PDFIO_VALTYPE_BINARY`
+// operand with the image data.
+//
+// The operands and their data are only valid until the callback returns.  The
+// streams are read in large blocks and the operand stack is reused, so no
+// memory is allocated per token.
 //
 
-static pdfio_obj_t *			// O - Object or `NULL` on error
-copy_jpeg(pdfio_dict_t *dict,		// I - Dictionary
-          int          fd)		// I - File descriptor
+bool					// O - `true` on success, `false` on error
+pdfioPageScanContent(
+    pdfio_obj_t     *page,		// I - Page object
+    pdfio_scan_cb_t cb,			// I - Callback function
+    void            *cb_data)		// I - Callback data
 {
-  pdfio_obj_t	*obj;			// Object
-  pdfio_stream_t *st;			// Stream for JPEG data
-  ssize_t	bytes;			// Bytes read
-  unsigned char	buffer[16384],		// Read buffer
-		*bufptr,		// Pointer into buffer
-		*bufend;		// End of buffer
-  size_t	length;			// Length of chunk
-  unsigned	width = 0,		// Width in columns
-		height = 0,		// Height in lines
-		num_colors = 0;		// Number of colors
+  _pdfio_scan_t	*scan;			// Content scanner
+  int		ch;			// Current character
+  char		token[256],		// Operator/number token
+		*tokptr;		// Pointer into token
+  const char	*op;			// Operator name
+  pdfio_operand_t *operand;		// Current operand
+  size_t	i;			// Looping var
+  int		nibble;			// First nibble of hex string byte
+  int		parens;			// Parenthesis nesting level
+  bool		in_image = false,	// In an inline image?
+		stop = false,		// Callback asked to stop?
+		ret;			// Return value
 
 
-  // Scan the file for a SOFn marker, then we can get the dimensions...
-  bytes = read(fd, buffer, sizeof(buffer));
+  // Range check input...
+  if (!page || !cb)
+    return (false);
 
-  for (bufptr = buffer + 2, bufend = buffer + bytes; bufptr < bufend;)
+  if ((scan = (_pdfio_scan_t *)calloc(1, sizeof(_pdfio_scan_t))) == NULL)
   {
-    if (*bufptr == 0xff)
-    {
-      bufptr ++;
+    _pdfioFileError(page->pdf, "Unable to allocate memory for content scanner.");
+    return (false);
+  }
 
-      if (bufptr >= bufend)
-      {
-       /*
-	* If we are at the end of the current buffer, re-fill and continue...
-	*/
+  scan->page        = page;
+  scan->num_streams = pdfioPageGetNumStreams(page);
 
-	if ((bytes = read(fd, buffer, sizeof(buffer))) <= 0)
-	  break;
+  // Parse the content streams...
+  while (!scan->error && !stop && (ch = scan_getc(scan)) != EOF)
+  {
+    if (!ch || isspace(ch))
+      continue;
 
-	bufptr = buffer;
-	bufend = buffer + bytes;
-      }
+    switch (ch)
+    {
+      case '%' : // Comment
+          while ((ch = scan_getc(scan)) != EOF && ch != '\n' && ch != '\r');
+          break;
 
-      if (*bufptr == 0xff)
-	continue;
+      case '/' : // Name
+          if (!scan_add_operand(scan, PDFIO_VALTYPE_NAME))
+            break;
 
-      if ((bufptr + 16) >= bufend)
-      {
-       /*
-	* Read more of the marker...
-	*/
+          while ((ch = scan_getc(scan)) != EOF && ch && !isspace(ch))
+          {
+            if (strchr(_PDFIO_SCAN_DELIM_CHARS, ch))
+            {
+              scan->bufptr --;
+              break;
+            }
+            else if (ch == '#')
+            {
+              // Hex-escaped character...
+              int hi, lo;		// High and low nibbles
+
+              if ((hi = scan_getc(scan)) == EOF || !isxdigit(hi))
+              {
+                if (hi != EOF)
+                  scan->bufptr --;
+              }
+              else if ((lo = scan_getc(scan)) == EOF || !isxdigit(lo))
+              {
+                if (!scan_add_text(scan, ch))
+                  break;
+
+                ch = hi;
+
+                if (lo != EOF)
+                  scan->bufptr --;
+              }
+              else
+              {
+                ch = ((isdigit(hi) ? hi - '0' : tolower(hi) - 'a' + 10) << 4) | (isdigit(lo) ? lo - '0' : tolower(lo) - 'a' + 10);
+              }
+            }
 
-	bytes = bufend - bufptr;
+            if (!scan_add_text(scan, ch))
+              break;
+          }
 
-	memmove(buffer, bufptr, (size_t)bytes);
-	bufptr = buffer;
-	bufend = buffer + bytes;
+          scan_end_text(scan);
+          break;
 
-	if ((bytes = read(fd, bufend, sizeof(buffer) - (size_t)bytes)) <= 0)
-	  break;
+      case '(' : // Literal string
+          if (!scan_add_operand(scan, PDFIO_VALTYPE_STRING))
+            break;
 
-	bufend += bytes;
-      }
+          for (parens = 0; (ch = scan_getc(scan)) != EOF;)
+          {
+            if (ch == '\\')
+            {
+              // Escaped character...
+              switch (ch = scan_getc(scan))
+              {
+                case EOF :
+                    continue;
+
+                case '\r' : // Line continuation
+                    if ((ch = scan_getc(scan)) != '\n' && ch != EOF)
+                      scan->bufptr --;
+                    continue;
+
+                case '\n' : // Line continuation
+                    continue;
+
+                case '0' : // Octal character escape
+                case '1' :
+                case '2' :
+                case '3' :
+                case '4' :
+                case '5' :
+                case '6' :
+                case '7' :
+                    for (ch -= '0', i = 0; i < 2; i ++)
+                    {
+                      int tch = scan_getc(scan);
+					// Next character
+
+                      if (tch >= '0' && tch <= '7')
+                      {
+                        ch = (ch << 3) | (tch - '0');
+                      }
+                      else
+                      {
+                        if (tch != EOF)
+                          scan->bufptr --;
+                        break;
+                      }
+                    }
+                    ch &= 255;
+                    break;
 
-      length = (size_t)((bufptr[1] << 8) | bufptr[2]);
+                case 'n' :
+                    ch = '\n';
+                    break;
 
-      PDFIO_DEBUG("copy_jpeg: JPEG X'FF%02X' (length %u)\n", *bufptr, (unsigned)length);
+                case 'r' :
+                    ch = '\r';
+                    break;
 
-      if ((*bufptr >= 0xc0 && *bufptr <= 0xc3) || (*bufptr >= 0xc5 && *bufptr <= 0xc7) || (*bufptr >= 0xc9 && *bufptr <= 0xcb) || (*bufptr >= 0xcd && *bufptr <= 0xcf))
-      {
-        // SOFn marker, look for dimensions...
-        if (bufptr[3] != 8)
-        {
-          _pdfioFileError(dict->pdf, "Unable to load %d-bit JPEG image.", bufptr[3]);
-          return (NULL);
-        }
+                case 't' :
+                    ch = '\t';
+                    break;
 
-	width      = (unsigned)((bufptr[6] << 8) | bufptr[7]);
-	height     = (unsigned)((bufptr[4] << 8) | bufptr[5]);
-	num_colors = bufptr[8];
-	break;
-      }
+                case 'b' :
+                    ch = '\b';
+                    break;
 
-      // Skip past this marker...
-      bufptr ++;
-      bytes = bufend - bufptr;
+                case 'f' :
+                    ch = '\f';
+                    break;
 
-      while (length >= (size_t)bytes)
-      {
-	length -= (size_t)bytes;
+                default :
+                    // Ignore backslash per PDF spec...
+                    break;
+              }
+            }
+            else if (ch == '(')
+            {
+              // Keep track of parenthesis
+              parens ++;
+            }
+            else if (ch == ')')
+            {
+              if (parens == 0)
+                break;
 
-	if ((bytes = read(fd, buffer, sizeof(buffer))) <= 0)
-	  break;
+              parens --;
+            }
+            else if (ch == '\r')
+            {
+              // Unescaped CR and CR LF are read as LF...
+              if ((ch = scan_getc(scan)) != '\n' && ch != EOF)
+                scan->bufptr --;
 
-	bufptr = buffer;
-	bufend = buffer + bytes;
-      }
+              ch = '\n';
+            }
 
-      if (length > (size_t)bytes)
-	break;
+            if (!scan_add_text(scan, ch))
+              break;
+          }
 
-      bufptr += length;
-    }
-  }
+          if (ch != ')' && !scan->error)
+          {
+            _pdfioFileError(page->pdf, "Unterminated string literal.");
+            scan->error = true;
+          }
 
-  if (width == 0 || height == 0 || (num_colors != 1 && num_colors != 3))
-    return (NULL);
+          scan_end_text(scan);
+          break;
 
-  // Create the image object...
-  pdfioDictSetNumber(dict, "Width", width);
-  pdfioDictSetNumber(dict, "Height", height);
-  pdfioDictSetNumber(dict, "BitsPerComponent", 8);
-  pdfioDictSetArray(dict, "ColorSpace", pdfioArrayCreateColorFromStandard(dict->pdf, num_colors, PDFIO_CS_SRGB));
-  pdfioDictSetName(dict, "Filter", "DCTDecode");
+      case '<' : // Hex string or dictionary
+          if ((ch = scan_getc(scan)) == '<')
+          {
+            scan_open_nesting(scan, PDFIO_VALTYPE_DICT);
+            break;
+          }
 
-  obj = pdfioFileCreateObj(dict->pdf, dict);
-  st  = pdfioObjCreateStream(obj, PDFIO_FILTER_NONE);
+          if (!scan_add_operand(scan, PDFIO_VALTYPE_STRING))
+            break;
 
-  // Copy the file to a stream...
-  lseek(fd, 0, SEEK_SET);
+          for (nibble = -1; ch != EOF && ch != '>'; ch = scan_getc(scan))
+          {
+            if (isxdigit(ch))
+            {
+              int digit = isdigit(ch) ? ch - '0' : tolower(ch) - 'a' + 10;
+					// Hex digit value
 
-  while ((bytes = read(fd, buffer, sizeof(buffer))) > 0)
-  {
-    if (!pdfioStreamWrite(st, buffer, (size_t)bytes))
-      return (NULL);
-  }
-
-  if (!pdfioStreamClose(st))
-    return (NULL);
+              if (nibble < 0)
+              {
+                nibble = digit << 4;
+              }
+              else
+              {
+                if (!scan_add_text(scan, nibble | digit))
+                  break;
 
-  return (obj);
-}
+                nibble = -1;
+              }
+            }
+            else if (ch && !isspace(ch))
+            {
+              _pdfioFileError(page->pdf, "Bad hex string.");
+              scan->error = true;
+              break;
+            }
+          }
 
+          if (ch == EOF && !scan->error)
+          {
+            _pdfioFileError(page->pdf, "Unterminated hex string.");
+            scan->error = true;
+          }
+          else if (nibble >= 0)
+          {
+            // Odd number of hex digits, final digit is the high nibble...
+            scan_add_text(scan, nibble);
+          }
 
-//
-// 'copy_png()' - Copy a PNG image.
-//
+          scan_end_text(scan);
+          break;
 
-static pdfio_obj_t *			// O - Object or `NULL` on error
-copy_png(pdfio_dict_t *dict,		// I - Dictionary
-         int          fd)		// I - File descriptor
-{
-  pdfio_obj_t	*obj = NULL;		// Object
-  pdfio_stream_t *st = NULL;		// Stream for PNG data
-  pdfio_dict_t	*decode = NULL;		// Parameters for PNG decode
-  ssize_t	bytes;			// Bytes read
-  unsigned char	buffer[16384];		// Read buffer
-  unsigned	i,			// Looping var
-		length,			// Length
-		type,			// Chunk code
-		crc,			// CRC-32
-		temp,			// Temporary value
-		width = 0,		// Width
-		height = 0;		// Height
-  unsigned char	bit_depth = 0,		// Bit depth
-		color_type = 0;		// Color type
-  double	gamma = 2.2,		// Gamma value
-		wx = 0.0, wy = 0.0,	// White point chromacity
-		rx = 0.0, ry = 0.0,	// Red chromacity
-		gx = 0.0, gy = 0.0,	// Green chromacity
-		bx = 0.0, by = 0.0;	// Blue chromacity
-  pdfio_array_t	*mask = NULL;		// Color masking array
+      case '>' : // End of dictionary
+          if ((ch = scan_getc(scan)) != '>')
+          {
+            _pdfioFileError(page->pdf, "Unexpected '>' in content stream.");
+            scan->error = true;
+          }
+          else
+          {
+            scan_close_nesting(scan, PDFIO_VALTYPE_DICT, '>');
+          }
+          break;
 
+      case '[' : // Start of array
+          scan_open_nesting(scan, PDFIO_VALTYPE_ARRAY);
+          break;
 
-  // Read the file header...
-  if (read(fd, buffer, 8) != 8)
-    return (NULL);
+      case ']' : // End of array
+          scan_close_nesting(scan, PDFIO_VALTYPE_ARRAY, ']');
+          break;
 
-  // Then read chunks until we have the image data...
-  while (read(fd, buffer, 8) == 8)
-  {
-    // Get the chunk length and type values...
-    length = (unsigned)((buffer[0] << 24) | (buffer[1] << 16) | (buffer[2] << 8) | buffer[3]);
-    type   = (unsigned)((buffer[4] << 24) | (buffer[5] << 16) | (buffer[6] << 8) | buffer[7]);
-    crc    = update_png_crc(0xffffffff, buffer + 4, 4);
+      case ')' :
+      case '{' :
+      case '}' :
+          _pdfioFileError(page->pdf, "Unexpected '%c' in content stream.", ch);
+          scan->error = true;
+          break;
 
-    switch (type)
-    {
-      case _PDFIO_PNG_CHUNK_IDAT : // Image data
-          if (!width || !height)
-          {
-            _pdfioFileError(dict->pdf, "Image data seen in PNG file before header.");
-            return (NULL);
-	  }
+      default : // Number, keyword, or operator
+          tokptr    = token;
+          *tokptr++ = (char)ch;
 
-          if (!st)
+          while ((ch = scan_getc(scan)) != EOF && ch && !isspace(ch))
           {
-	    PDFIO_DEBUG("copy_png: wx=%g, wy=%g, rx=%g, ry=%g, gx=%g, gy=%g, bx=%g, by=%g\n", wx, wy, rx, ry, gx, gy, bx, by);
-	    PDFIO_DEBUG("copy_png: gamma=%g\n", gamma);
-
-            if (!pdfioDictGetArray(dict, "ColorSpace"))
+            if (strchr(_PDFIO_SCAN_DELIM_CHARS, ch))
             {
-              PDFIO_DEBUG("copy_png: Adding %s ColorSpace value.\n", color_type == _PDFIO_PNG_TYPE_GRAY ? "CalGray" : "CalRGB");
-
-	      if (wx != 0.0)
-		pdfioDictSetArray(dict, "ColorSpace", pdfioArrayCreateColorFromPrimaries(dict->pdf, color_type == _PDFIO_PNG_TYPE_GRAY ? 1 : 3, gamma, wx, wy, rx, ry, gx, gy, bx, by));
-              else
-		pdfioDictSetArray(dict, "ColorSpace", pdfioArrayCreateColorFromStandard(dict->pdf, color_type == _PDFIO_PNG_TYPE_GRAY ? 1 : 3, PDFIO_CS_SRGB));
+              scan->bufptr --;
+              break;
+            }
+            else if (tokptr >= (token + sizeof(token) - 1))
+            {
+              _pdfioFileError(page->pdf, "Token too large.");
+              scan->error = true;
+              break;
             }
 
-	    obj = pdfioFileCreateObj(dict->pdf, dict);
-
-	    if ((st = pdfioObjCreateStream(obj, PDFIO_FILTER_NONE)) == NULL)
-	    {
-	      pdfioObjClose(obj);
-	      return (NULL);
-	    }
+            *tokptr++ = (char)ch;
           }
 
-          while (length > 0)
-          {
-            if (length > sizeof(buffer))
-              bytes = (ssize_t)sizeof(buffer);
-	    else
-	      bytes = (ssize_t)length;
+          *tokptr = '\0';
 
-            if ((bytes = read(fd, buffer, (size_t)bytes)) <= 0)
-	    {
-	      pdfioStreamClose(st);
-	      _pdfioFileError(dict->pdf, "Early end-of-file in image file.");
-	      return (NULL);
-	    }
+          if (scan->error)
+            break;
 
-            crc = update_png_crc(crc, buffer, (size_t)bytes);
+          if ((token[0] >= '0' && token[0] <= '9') || token[0] == '-' || token[0] == '+' || token[0] == '.')
+          {
+            // Number...
+            if ((operand = scan_add_operand(scan, PDFIO_VALTYPE_NUMBER)) == NULL)
+              break;
 
-            if (!pdfioStreamWrite(st, buffer, (size_t)bytes))
+            if (!scan_number(token, &operand->value.number))
             {
-	      pdfioStreamClose(st);
-	      _pdfioFileError(dict->pdf, "Unable to copy image data.");
-	      return (NULL);
+              _pdfioFileError(page->pdf, "Bad number '%s' in content stream.", token);
+              scan->error = true;
             }
-
-            length -= bytes;
+            break;
           }
-          break;
-
-      case _PDFIO_PNG_CHUNK_IEND : // Image end
-          if (st)
+          else if (!strcmp(token, "true") || !strcmp(token, "false"))
           {
-            pdfioStreamClose(st);
-            return (obj);
+            // Boolean...
+            if ((operand = scan_add_operand(scan, PDFIO_VALTYPE_BOOLEAN)) != NULL)
+              operand->value.boolean = token[0] == 't';
+            break;
           }
-          break;
-
-      case _PDFIO_PNG_CHUNK_IHDR : // Image header
-          if (st)
+          else if (!strcmp(token, "null"))
           {
-	    pdfioStreamClose(st);
-	    _pdfioFileError(dict->pdf, "Unexpected image header.");
-	    return (NULL);
+            // Null...
+            scan_add_operand(scan, PDFIO_VALTYPE_NULL);
+            break;
           }
 
-          if (length != 13)
+          // Operator...
+          op = token;
+
+          if (scan->depth)
           {
-	    _pdfioFileError(dict->pdf, "Early end-of-file in image file.");
-	    return (NULL);
+            _pdfioFileError(page->pdf, "Unterminated array or dictionary before '%s' operator.", token);
+            scan->error = true;
+            break;
           }
-
-          if (read(fd, buffer, length) != length)
+          else if (!strcmp(token, "BI"))
           {
-	    _pdfioFileError(dict->pdf, "Early end-of-file in image file.");
-	    return (NULL);
+            // Start of inline image, collect the image dictionary...
+            in_image           = true;
+            scan->num_operands = 0;
+            scan->textlen      = 0;
+            break;
           }
+          else if (!strcmp(token, "ID"))
+          {
+            // Inline image data, report as a single "BI" operator...
+            if (!in_image)
+            {
+              _pdfioFileError(page->pdf, "Unexpected 'ID' operator in content stream.");
+              scan->error = true;
+              break;
+            }
+            else if (!scan_inline_image(scan))
+            {
+              break;
+            }
 
-	  crc        = update_png_crc(crc, buffer, length);
-	  width      = (unsigned)((buffer[0] << 24) | (buffer[1] << 16) | (buffer[2] << 8) | buffer[3]);
-	  height     = (unsigned)((buffer[4] << 24) | (buffer[5] << 16) | (buffer[6] << 8) | buffer[7]);
-	  bit_depth  = buffer[8];
-	  color_type = buffer[9];
-
-	  if (width == 0 || height == 0 || (bit_depth != 1 && bit_depth != 2 && bit_depth != 4 && bit_depth != 8 && bit_depth != 16) || (color_type != _PDFIO_PNG_TYPE_GRAY && color_type != _PDFIO_PNG_TYPE_RGB && color_type != _PDFIO_PNG_TYPE_INDEXED) || buffer[10] || buffer[11] || buffer[12])
-	  {
-	    _pdfioFileError(dict->pdf, "Unsupported PNG image.");
-	    return (NULL);
-	  }
-
-	  pdfioDictSetNumber(dict, "Width", width);
-	  pdfioDictSetNumber(dict, "Height", height);
-	  pdfioDictSetNumber(dict, "BitsPerComponent", bit_depth);
-	  pdfioDictSetName(dict, "Filter", "FlateDecode");
-
-	  if ((decode = pdfioDictCreate(dict->pdf)) == NULL)
-	    return (NULL);
-
-	  pdfioDictSetNumber(decode, "BitsPerComponent", bit_depth);
-	  pdfioDictSetNumber(decode, "Colors", color_type == _PDFIO_PNG_TYPE_RGB ? 3 : 1);
-	  pdfioDictSetNumber(decode, "Columns", width);
-	  pdfioDictSetNumber(decode, "Predictor", _PDFIO_PREDICTOR_PNG_AUTO);
-	  pdfioDictSetDict(dict, "DecodeParms", decode);
-          break;
-
-      case _PDFIO_PNG_CHUNK_PLTE : // Palette
-          if (length == 0 || (length % 3) != 0 || length > 768)
+            in_image = false;
+            op       = "BI";
+          }
+          else if (in_image)
           {
-	    pdfioStreamClose(st);
-	    _pdfioFileError(dict->pdf, "Invalid color palette.");
-	    return (NULL);
+            _pdfioFileError(page->pdf, "Unexpected '%s' operator in inline image.", token);
+            scan->error = true;
+            break;
           }
 
-          if (read(fd, buffer, length) != length)
+          // Point the name/string/image operands at their data and report
+          // the operator...
+          for (i = scan->num_operands, operand = scan->operands; i > 0; i --, operand ++)
           {
-	    _pdfioFileError(dict->pdf, "Early end-of-file in image file.");
-	    return (NULL);
+            if (operand->type == PDFIO_VALTYPE_NAME)
+              operand->value.name = scan->text + scan->offsets[operand - scan->operands];
+            else if (operand->type == PDFIO_VALTYPE_STRING)
+              operand->value.string = scan->text + scan->offsets[operand - scan->operands];
+            else if (operand->type == PDFIO_VALTYPE_BINARY)
+              operand->value.binary = (unsigned char *)scan->text + scan->offsets[operand - scan->operands];
           }
 
-	  crc = update_png_crc(crc, buffer, length);
-
-          PDFIO_DEBUG("copy_png: Adding Indexed ColorSpace value.\n");
+          if (!(cb)(cb_data, op, scan->num_operands, scan->operands))
+            stop = true;
 
-          pdfioDictSetArray(dict, "ColorSpace", pdfioArrayCreateColorFromPalette(dict->pdf, length / 3, buffer));
+          scan->num_operands = 0;
+          scan->textlen      = 0;
           break;
+    }
+  }
 
-      case _PDFIO_PNG_CHUNK_cHRM : // Cromacities and white point
-          if (length != 32)
-          {
-	    _pdfioFileError(dict->pdf, "Early end-of-file in image file.");
-	    return (NULL);
-          }
+  // Free memory and return...
+  if (scan->st)
+    pdfioStreamClose(scan->st);
 
-          if (read(fd, buffer, length) != length)
-          {
-	    _pdfioFileError(dict->pdf, "Early end-of-file in image file.");
-	    return (NULL);
-          }
+  ret = !scan->error;
 
-	  crc = update_png_crc(crc, buffer, length);
+  free(scan->operands);
+  free(scan->offsets);
+  free(scan->text);
+  free(scan);
 
-          wx = 0.00001 * ((buffer[0] << 24) | (buffer[1] << 16) | (buffer[2] << 8) | buffer[3]);
-          wy = 0.00001 * ((buffer[4] << 24) | (buffer[5] << 16) | (buffer[6] << 8) | buffer[7]);
-          rx = 0.00001 * ((buffer[8] << 24) | (buffer[9] << 16) | (buffer[10] << 8) | buffer[11]);
-          ry = 0.00001 * ((buffer[12] << 24) | (buffer[13] << 16) | (buffer[14] << 8) | buffer[15]);
-          gx = 0.00001 * ((buffer[16] << 24) | (buffer[17] << 16) | (buffer[18] << 8) | buffer[19]);
-          gy = 0.00001 * ((buffer[20] << 24) | (buffer[21] << 16) | (buffer[22] << 8) | buffer[23]);
-          bx = 0.00001 * ((buffer[24] << 24) | (buffer[25] << 16) | (buffer[26] << 8) | buffer[27]);
-          by = 0.00001 * ((buffer[28] << 24) | (buffer[29] << 16) | (buffer[30] << 8) | buffer[31]);
-          break;
+  return (ret);
+}
 
-      case _PDFIO_PNG_CHUNK_gAMA : // Gamma correction
-          if (length != 4)
-          {
-	    _pdfioFileError(dict->pdf, "Early end-of-file in image file.");
-	    return (NULL);
-          }
 
-          if (read(fd, buffer, length) != length)
-          {
-	    _pdfioFileError(dict->pdf, "Early end-of-file in image file.");
-	    return (NULL);
-          }
+//
+// 'add_subset_font()' - Add a font that is subset when the file is closed.
+//
 
-	  crc = update_png_crc(crc, buffer, length);
+static bool				// O - `true` on success, `false` on failure
+add_subset_font(
+    pdfio_file_t *pdf,			// I - PDF file
+    pdfio_obj_t  *font_obj,		// I - Type0 font object
+    pdfio_obj_t  *type2_obj,		// I - CIDFontType2 font object
+    pdfio_obj_t  *file_obj,		// I - Font file object
+    pdfio_obj_t  *cid2gid_obj)		// I - CIDToGIDMap object
+{
+  _pdfio_subfont_t	*subfont;	// New font
 
-          gamma = 10000.0 / ((buffer[0] << 24) | (buffer[1] << 16) | (buffer[2] << 8) | buffer[3]);
-          break;
 
-      case _PDFIO_PNG_CHUNK_tRNS : // Transparency information
-          switch (color_type)
-          {
-            case _PDFIO_PNG_TYPE_INDEXED :
-		if (length > 256)
-		{
-		  _pdfioFileError(dict->pdf, "Bad transparency chunk in image file.");
-		  return (NULL);
-		}
+  // Allocate the character bitmap and font array as needed...
+  if (!pdf->used_chars && (pdf->used_chars = (uint8_t *)calloc(1, 65536 / 8)) == NULL)
+  {
+    _pdfioFileError(pdf, "Unable to allocate memory for font subset.");
+    return (false);
+  }
 
-		if (read(fd, buffer, length) != length)
-		{
-		  _pdfioFileError(dict->pdf, "Early end-of-file in image file.");
-		  return (NULL);
-		}
+  if (pdf->num_subfonts >= pdf->alloc_subfonts)
+  {
+    if ((subfont = (_pdfio_subfont_t *)realloc(pdf->subfonts, (pdf->alloc_subfonts + 8) * sizeof(_pdfio_subfont_t))) == NULL)
+    {
+      _pdfioFileError(pdf, "Unable to allocate memory for font subset.");
+      return (false);
+    }
 
-                for (i = 0; i < length; i ++)
-                {
-                  if (!buffer[i])
-                    break;
-                }
+    pdf->alloc_subfonts += 8;
+    pdf->subfonts       = subfont;
+  }
 
-                if (i < length)
-                {
-                  if ((mask = pdfioArrayCreate(dict->pdf)) == NULL)
-                    return (NULL);
+  // Add the font...
+  subfont = pdf->subfonts + pdf->num_subfonts;
+  pdf->num_subfonts ++;
 
-                  pdfioArrayAppendNumber(mask, i);
+  subfont->font_obj    = font_obj;
+  subfont->type2_obj   = type2_obj;
+  subfont->file_obj    = file_obj;
+  subfont->cid2gid_obj = cid2gid_obj;
 
-		  for (i ++; i < length; i ++)
-		  {
-		    if (buffer[i])
-		      break;
-		  }
+  return (true);
+}
 
-		  pdfioArrayAppendNumber(mask, i - 1);
-		}
-		break;
 
-	    case _PDFIO_PNG_TYPE_GRAY :
-		if (length != 2)
-		{
-		  _pdfioFileError(dict->pdf, "Bad transparency chunk in image file.");
-		  return (NULL);
-		}
+//
+// 'copy_image()' - Copy a JPEG or PNG image file into an image object.
+//
 
-		if (read(fd, buffer, length) != length)
-		{
-		  _pdfioFileError(dict->pdf, "Early end-of-file in image file.");
-		  return (NULL);
-		}
+static pdfio_obj_t *			// O - Object or `NULL` on error
+copy_image(pdfio_file_t  *pdf,		// I - PDF file
+           _pdfio_isrc_t *src,		// I - Image file source
+           const char    *filename,	// I - Filename or `NULL` if not a file
+           bool          interpolate)	// I - Interpolate image data?
+{
+  pdfio_dict_t	*dict;			// Image dictionary
+  unsigned char	buffer[32];		// Read buffer
+  _pdfio_image_func_t copy_func = NULL;	// Image copy function
 
-		if ((mask = pdfioArrayCreate(dict->pdf)) == NULL)
-		  return (NULL);
 
-		pdfioArrayAppendNumber(mask, buffer[1]);
-		pdfioArrayAppendNumber(mask, buffer[1]);
-	        break;
-	    case _PDFIO_PNG_TYPE_RGB :
-		if (length != 6)
-		{
-		  _pdfioFileError(dict->pdf, "Bad transparency chunk in image file.");
-		  return (NULL);
-		}
+  // Read the file header to determine the file format...
+  if (image_read(src, buffer, sizeof(buffer)) < (ssize_t)sizeof(buffer) || !image_rewind(src))
+  {
+    if (filename)
+      _pdfioFileError(pdf, "Unable to read header from image file '%s'.", filename);
+    else
+      _pdfioFileError(pdf, "Unable to read header from image file.");
 
-		if (read(fd, buffer, length) != length)
-		{
-		  _pdfioFileError(dict->pdf, "Early end-of-file in image file.");
-		  return (NULL);
-		}
+    return (NULL);
+  }
 
-		if ((mask = pdfioArrayCreate(dict->pdf)) == NULL)
-		  return (NULL);
+  if (!memcmp(buffer, "\211PNG\015\012\032\012\000\000\000\015IHDR", 16))
+  {
+    // PNG image...
+    copy_func = copy_png;
+  }
+  else if (!memcmp(buffer, "\377\330\377", 3))
+  {
+   // JPEG image...
+    copy_func = copy_jpeg;
+  }
+  else
+  {
+    // Something else that isn't supported...
+    if (filename)
+      _pdfioFileError(pdf, "Unsupported image file '%s'.", filename);
+    else
+      _pdfioFileError(pdf, "Unsupported image file.");
 
-		pdfioArrayAppendNumber(mask, buffer[1]);
-		pdfioArrayAppendNumber(mask, buffer[3]);
-		pdfioArrayAppendNumber(mask, buffer[5]);
-		pdfioArrayAppendNumber(mask, buffer[1]);
-		pdfioArrayAppendNumber(mask, buffer[3]);
-		pdfioArrayAppendNumber(mask, buffer[5]);
-	        break;
-	  }
+    return (NULL);
+  }
 
-	  crc = update_png_crc(crc, buffer, length);
+  // Create the base image dictionary the copy the file into an object...
+  if ((dict = pdfioDictCreate(pdf)) == NULL)
+    return (NULL);
 
-          if (mask)
-            pdfioDictSetArray(dict, "Mask", mask);
-          break;
+  pdfioDictSetName(dict, "Type", "XObject");
+  pdfioDictSetName(dict, "Subtype", "Image");
+  pdfioDictSetBoolean(dict, "Interpolate", interpolate);
 
-      default : // Something else
-          while (length > 0)
-          {
-            if (length > sizeof(buffer))
-              bytes = (ssize_t)sizeof(buffer);
-	    else
-	      bytes = (ssize_t)length;
+  return ((copy_func)(dict, src));
+}
 
-            if ((bytes = read(fd, buffer, (size_t)bytes)) <= 0)
-	    {
-	      pdfioStreamClose(st);
-	      _pdfioFileError(dict->pdf, "Early end-of-file in image file.");
-	      return (NULL);
-	    }
 
-            crc    = update_png_crc(crc, buffer, (size_t)bytes);
-            length -= bytes;
-          }
-          break;
-    }
+//
+// 'copy_jpeg()' - Copy a JPEG image.
+//
 
-    // Verify the CRC...
-    crc ^= 0xffffffff;
+static pdfio_obj_t *			// O - Object or `NULL` on error
+copy_jpeg(pdfio_dict_t  *dict,		// I - Dictionary
+          _pdfio_isrc_t *src)		// I - Image file source
+{
+  pdfio_obj_t	*obj;			// Object
+  pdfio_stream_t *st;			// Stream for JPEG data
+  ssize_t	bytes;			// Bytes read
+  unsigned char	buffer[16384],		// Read buffer
+		*bufptr,		// Pointer into buffer
+		*bufend;		// End of buffer
+  size_t	length;			// Length of chunk
+  unsigned	width = 0,		// Width in columns
+		height = 0,		// Height in lines
+		num_colors = 0;		// Number of colors
 
-    if (read(fd, buffer, 4) != 4)
-    {
-      pdfioStreamClose(st);
-      _pdfioFileError(dict->pdf, "Unable to read CRC.");
-      return (NULL);
-    }
 
-    temp = (unsigned)((buffer[0] << 24) | (buffer[1] << 16) | (buffer[2] << 8) | buffer[3]);
-    if (temp != crc)
+  // Scan the file for a SOFn marker, then we can get the dimensions...
+  bytes = image_read(src, buffer, sizeof(buffer));
+
+  for (bufptr = buffer + 2, bufend = buffer + bytes; bufptr < bufend;)
+  {
+    if (*bufptr == 0xff)
     {
-      pdfioStreamClose(st);
-      _pdfioFileError(dict->pdf, "Bad CRC (0x%08x != 0x%08x).", temp, crc);
-      return (NULL);
+      bufptr ++;
+
+      if (bufptr >= bufend)
+      {
+       /*
+	* If we are at the end of the current buffer, re-fill and continue...
+	*/
+
+	if ((bytes = image_read(src, buffer, sizeof(buffer))) <= 0)
+	  break;
+
+	bufptr = buffer;
+	bufend = buffer + bytes;
+      }
+
+      if (*bufptr == 0xff)
+	continue;
+
+      if ((bufptr + 16) >= bufend)
+      {
+       /*
+	* Read more of the marker...
+	*/
+
+	bytes = bufend - bufptr;
+
+	memmove(buffer, bufptr, (size_t)bytes);
+	bufptr = buffer;
+	bufend = buffer + bytes;
+
+	if ((bytes = image_read(src, bufend, sizeof(buffer) - (size_t)bytes)) <= 0)
+	  break;
+
+	bufend += bytes;
+      }
+
+      length = (size_t)((bufptr[1] << 8) | bufptr[2]);
+
+      PDFIO_DEBUG("copy_jpeg: JPEG X'FF%02X' (length %u)\n", *bufptr, (unsigned)length);
+
+      if ((*bufptr >= 0xc0 && *bufptr <= 0xc3) || (*bufptr >= 0xc5 && *bufptr <= 0xc7) || (*bufptr >= 0xc9 && *bufptr <= 0xcb) || (*bufptr >= 0xcd && *bufptr <= 0xcf))
+      {
+        // SOFn marker, look for dimensions...
+        if (bufptr[3] != 8)
+        {
+          _pdfioFileError(dict->pdf, "Unable to load %d-bit JPEG image.", bufptr[3]);
+          return (NULL);
+        }
+
+	width      = (unsigned)((bufptr[6] << 8) | bufptr[7]);
+	height     = (unsigned)((bufptr[4] << 8) | bufptr[5]);
+	num_colors = bufptr[8];
+	break;
+      }
+
+      // Skip past this marker...
+      bufptr ++;
+      bytes = bufend - bufptr;
+
+      while (length >= (size_t)bytes)
+      {
+	length -= (size_t)bytes;
+
+	if ((bytes = image_read(src, buffer, sizeof(buffer))) <= 0)
+	  break;
+
+	bufptr = buffer;
+	bufend = buffer + bytes;
+      }
+
+      if (length > (size_t)bytes)
+	break;
+
+      bufptr += length;
     }
   }
 
-  return (NULL);
+  if (width == 0 || height == 0 || (num_colors != 1 && num_colors != 3))
+    return (NULL);
+
+  // Create the image object...
+  pdfioDictSetNumber(dict, "Width", width);
+  pdfioDictSetNumber(dict, "Height", height);
+  pdfioDictSetNumber(dict, "BitsPerComponent", 8);
+  pdfioDictSetArray(dict, "ColorSpace", pdfioArrayCreateColorFromStandard(dict->pdf, num_colors, PDFIO_CS_SRGB));
+  pdfioDictSetName(dict, "Filter", "DCTDecode");
+
+  obj = pdfioFileCreateObj(dict->pdf, dict);
+  st  = pdfioObjCreateStream(obj, PDFIO_FILTER_NONE);
+
+  // Copy the file to a stream...
+  if (!image_rewind(src) || !image_copy(src, st, SIZE_MAX, NULL))
+  {
+    pdfioStreamClose(st);
+    return (NULL);
+  }
+
+  if (!pdfioStreamClose(st))
+    return (NULL);
+
+  return (obj);
 }
 
 
 //
-// 'create_cp1252()' - Create the CP1252 font encoding object.
+// 'copy_png()' - Copy a PNG image.
 //
 
-static bool				// O - `true` on success, `false` on failure
-create_cp1252(pdfio_file_t *pdf)	// I - PDF file
+static pdfio_obj_t *			// O - Object or `NULL` on error
+copy_png(pdfio_dict_t  *dict,		// I - Dictionary
+         _pdfio_isrc_t *src)		// I - Image file source
 {
-  int		ch;			// Current character
-  bool		chindex;		// Need character index?
-  pdfio_dict_t	*cp1252_dict;		// Encoding dictionary
-  pdfio_array_t	*cp1252_array;		// Differences array
-  static const char * const cp1252[] =	// Glyphs for CP1252 encoding
+  pdfio_obj_t	*obj = NULL;		// Object
+  pdfio_stream_t *st = NULL;		// Stream for PNG data
+  pdfio_dict_t	*decode = NULL;		// Parameters for PNG decode
+  ssize_t	bytes;			// Bytes read
+  unsigned char	buffer[16384];		// Read buffer
+  unsigned	i,			// Looping var
+		length,			// Length
+		type,			// Chunk code
+		crc,			// CRC-32
+		temp,			// Temporary value
+		width = 0,		// Width
+		height = 0;		// Height
+  unsigned char	bit_depth = 0,		// Bit depth
+		color_type = 0;		// Color type
+  double	gamma = 2.2,		// Gamma value
+		wx = 0.0, wy = 0.0,	// White point chromacity
+		rx = 0.0, ry = 0.0,	// Red chromacity
+		gx = 0.0, gy = 0.0,	// Green chromacity
+		bx = 0.0, by = 0.0;	// Blue chromacity
+  pdfio_array_t	*mask = NULL;		// Color masking array
+
+
+  // Read the file header...
+  if (image_read(src, buffer, 8) != 8)
+    return (NULL);
+
+  // Then read chunks until we have the image data...
+  while (image_read(src, buffer, 8) == 8)
   {
-    "space",
-    "exclam",
-    "quotedbl",
+    // Get the chunk length and type values...
+    length = (unsigned)((buffer[0] << 24) | (buffer[1] << 16) | (buffer[2] << 8) | buffer[3]);
+    type   = (unsigned)((buffer[4] << 24) | (buffer[5] << 16) | (buffer[6] << 8) | buffer[7]);
+    crc    = update_png_crc(0xffffffff, buffer + 4, 4);
+
+    switch (type)
+    {
+      case _PDFIO_PNG_CHUNK_IDAT : // Image data
+          if (!width || !height)
+          {
+            _pdfioFileError(dict->pdf, "Image data seen in PNG file before header.");
+            return (NULL);
+	  }
+
+          if (!st)
+          {
+	    PDFIO_DEBUG("copy_png: wx=%g, wy=%g, rx=%g, ry=%g, gx=%g, gy=%g, bx=%g, by=%g\n", wx, wy, rx, ry, gx, gy, bx, by);
+	    PDFIO_DEBUG("copy_png: gamma=%g\n", gamma);
+
+            if (!pdfioDictGetArray(dict, "ColorSpace"))
+            {
+              PDFIO_DEBUG("copy_png: Adding %s ColorSpace value.\n", color_type == _PDFIO_PNG_TYPE_GRAY ? "CalGray" : "CalRGB");
+
+	      if (wx != 0.0)
+		pdfioDictSetArray(dict, "ColorSpace", pdfioArrayCreateColorFromPrimaries(dict->pdf, color_type == _PDFIO_PNG_TYPE_GRAY ? 1 : 3, gamma, wx, wy, rx, ry, gx, gy, bx, by));
+              else
+		pdfioDictSetArray(dict, "ColorSpace", pdfioArrayCreateColorFromStandard(dict->pdf, color_type == _PDFIO_PNG_TYPE_GRAY ? 1 : 3, PDFIO_CS_SRGB));
+            }
+
+	    obj = pdfioFileCreateObj(dict->pdf, dict);
+
+	    if ((st = pdfioObjCreateStream(obj, PDFIO_FILTER_NONE)) == NULL)
+	    {
+	      pdfioObjClose(obj);
+	      return (NULL);
+	    }
+          }
+
+          if (!image_copy(src, st, length, &crc))
+	  {
+	    pdfioStreamClose(st);
+	    _pdfioFileError(dict->pdf, "Unable to copy image data.");
+	    return (NULL);
+	  }
+          break;
+
+      case _PDFIO_PNG_CHUNK_IEND : // Image end
+          if (st)
+          {
+            pdfioStreamClose(st);
+            return (obj);
+          }
+          break;
+
+      case _PDFIO_PNG_CHUNK_IHDR : // Image header
+          if (st)
+          {
+	    pdfioStreamClose(st);
+	    _pdfioFileError(dict->pdf, "Unexpected image header.");
+	    return (NULL);
+          }
+
+          if (length != 13)
+          {
+	    _pdfioFileError(dict->pdf, "Early end-of-file in image file.");
+	    return (NULL);
+          }
+
+          if (image_read(src, buffer, length) != length)
+          {
+	    _pdfioFileError(dict->pdf, "Early end-of-file in image file.");
+	    return (NULL);
+          }
+
+	  crc        = update_png_crc(crc, buffer, length);
+	  width      = (unsigned)((buffer[0] << 24) | (buffer[1] << 16) | (buffer[2] << 8) | buffer[3]);
+	  height     = (unsigned)((buffer[4] << 24) | (buffer[5] << 16) | (buffer[6] << 8) | buffer[7]);
+	  bit_depth  = buffer[8];
+	  color_type = buffer[9];
+
+	  if (width == 0 || height == 0 || (bit_depth != 1 && bit_depth != 2 && bit_depth != 4 && bit_depth != 8 && bit_depth != 16) || (color_type != _PDFIO_PNG_TYPE_GRAY && color_type != _PDFIO_PNG_TYPE_RGB && color_type != _PDFIO_PNG_TYPE_INDEXED) || buffer[10] || buffer[11] || buffer[12])
+	  {
+	    _pdfioFileError(dict->pdf, "Unsupported PNG image.");
+	    return (NULL);
+	  }
+
+	  pdfioDictSetNumber(dict, "Width", width);
+	  pdfioDictSetNumber(dict, "Height", height);
+	  pdfioDictSetNumber(dict, "BitsPerComponent", bit_depth);
+	  pdfioDictSetName(dict, "Filter", "FlateDecode");
+
+	  if ((decode = pdfioDictCreate(dict->pdf)) == NULL)
+	    return (NULL);
+
+	  pdfioDictSetNumber(decode, "BitsPerComponent", bit_depth);
+	  pdfioDictSetNumber(decode, "Colors", color_type == _PDFIO_PNG_TYPE_RGB ? 3 : 1);
+	  pdfioDictSetNumber(decode, "Columns", width);
+	  pdfioDictSetNumber(decode, "Predictor", _PDFIO_PREDICTOR_PNG_AUTO);
+	  pdfioDictSetDict(dict, "DecodeParms", decode);
+          break;
+
+      case _PDFIO_PNG_CHUNK_PLTE : // Palette
+          if (length == 0 || (length % 3) != 0 || length > 768)
+          {
+	    pdfioStreamClose(st);
+	    _pdfioFileError(dict->pdf, "Invalid color palette.");
+	    return (NULL);
+          }
+
+          if (image_read(src, buffer, length) != length)
+          {
+	    _pdfioFileError(dict->pdf, "Early end-of-file in image file.");
+	    return (NULL);
+          }
+
+	  crc = update_png_crc(crc, buffer, length);
+
+          PDFIO_DEBUG("copy_png: Adding Indexed ColorSpace value.\n");
+
+          pdfioDictSetArray(dict, "ColorSpace", pdfioArrayCreateColorFromPalette(dict->pdf, length / 3, buffer));
+          break;
+
+      case _PDFIO_PNG_CHUNK_cHRM : // Cromacities and white point
+          if (length != 32)
+          {
+	    _pdfioFileError(dict->pdf, "Early end-of-file in image file.");
+	    return (NULL);
+          }
+
+          if (image_read(src, buffer, length) != length)
+          {
+	    _pdfioFileError(dict->pdf, "Early end-of-file in image file.");
+	    return (NULL);
+          }
+
+	  crc = update_png_crc(crc, buffer, length);
+
+          wx = 0.00001 * ((buffer[0] << 24) | (buffer[1] << 16) | (buffer[2] << 8) | buffer[3]);
+          wy = 0.00001 * ((buffer[4] << 24) | (buffer[5] << 16) | (buffer[6] << 8) | buffer[7]);
+          rx = 0.00001 * ((buffer[8] << 24) | (buffer[9] << 16) | (buffer[10] << 8) | buffer[11]);
+          ry = 0.00001 * ((buffer[12] << 24) | (buffer[13] << 16) | (buffer[14] << 8) | buffer[15]);
+          gx = 0.00001 * ((buffer[16] << 24) | (buffer[17] << 16) | (buffer[18] << 8) | buffer[19]);
+          gy = 0.00001 * ((buffer[20] << 24) | (buffer[21] << 16) | (buffer[22] << 8) | buffer[23]);
+          bx = 0.00001 * ((buffer[24] << 24) | (buffer[25] << 16) | (buffer[26] << 8) | buffer[27]);
+          by = 0.00001 * ((buffer[28] << 24) | (buffer[29] << 16) | (buffer[30] << 8) | buffer[31]);
+          break;
+
+      case _PDFIO_PNG_CHUNK_gAMA : // Gamma correction
+          if (length != 4)
+          {
+	    _pdfioFileError(dict->pdf, "Early end-of-file in image file.");
+	    return (NULL);
+          }
+
+          if (image_read(src, buffer, length) != length)
+          {
+	    _pdfioFileError(dict->pdf, "Early end-of-file in image file.");
+	    return (NULL);
+          }
+
+	  crc = update_png_crc(crc, buffer, length);
+
+          gamma = 10000.0 / ((buffer[0] << 24) | (buffer[1] << 16) | (buffer[2] << 8) | buffer[3]);
+          break;
+
+      case _PDFIO_PNG_CHUNK_tRNS : // Transparency information
+          switch (color_type)
+          {
+            case _PDFIO_PNG_TYPE_INDEXED :
+		if (length > 256)
+		{
+		  _pdfioFileError(dict->pdf, "Bad transparency chunk in image file.");
+		  return (NULL);
+		}
+
+		if (image_read(src, buffer, length) != length)
+		{
+		  _pdfioFileError(dict->pdf, "Early end-of-file in image file.");
+		  return (NULL);
+		}
+
+                for (i = 0; i < length; i ++)
+                {
+                  if (!buffer[i])
+                    break;
+                }
+
+                if (i < length)
+                {
+                  if ((mask = pdfioArrayCreate(dict->pdf)) == NULL)
+                    return (NULL);
+
+                  pdfioArrayAppendNumber(mask, i);
+
+		  for (i ++; i < length; i ++)
+		  {
+		    if (buffer[i])
+		      break;
+		  }
+
+		  pdfioArrayAppendNumber(mask, i - 1);
+		}
+		break;
+
+	    case _PDFIO_PNG_TYPE_GRAY :
+		if (length != 2)
+		{
+		  _pdfioFileError(dict->pdf, "Bad transparency chunk in image file.");
+		  return (NULL);
+		}
+
+		if (image_read(src, buffer, length) != length)
+		{
+		  _pdfioFileError(dict->pdf, "Early end-of-file in image file.");
+		  return (NULL);
+		}
+
+		if ((mask = pdfioArrayCreate(dict->pdf)) == NULL)
+		  return (NULL);
+
+		pdfioArrayAppendNumber(mask, buffer[1]);
+		pdfioArrayAppendNumber(mask, buffer[1]);
+	        break;
+	    case _PDFIO_PNG_TYPE_RGB :
+		if (length != 6)
+		{
+		  _pdfioFileError(dict->pdf, "Bad transparency chunk in image file.");
+		  return (NULL);
+		}
+
+		if (image_read(src, buffer, length) != length)
+		{
+		  _pdfioFileError(dict->pdf, "Early end-of-file in image file.");
+		  return (NULL);
+		}
+
+		if ((mask = pdfioArrayCreate(dict->pdf)) == NULL)
+		  return (NULL);
+
+		pdfioArrayAppendNumber(mask, buffer[1]);
+		pdfioArrayAppendNumber(mask, buffer[3]);
+		pdfioArrayAppendNumber(mask, buffer[5]);
+		pdfioArrayAppendNumber(mask, buffer[1]);
+		pdfioArrayAppendNumber(mask, buffer[3]);
+		pdfioArrayAppendNumber(mask, buffer[5]);
+	        break;
+	  }
+
+	  crc = update_png_crc(crc, buffer, length);
+
+          if (mask)
+            pdfioDictSetArray(dict, "Mask", mask);
+          break;
+
+      default : // Something else
+          while (length > 0)
+          {
+            if (length > sizeof(buffer))
+              bytes = (ssize_t)sizeof(buffer);
+	    else
+	      bytes = (ssize_t)length;
+
+            if ((bytes = image_read(src, buffer, (size_t)bytes)) <= 0)
+	    {
+	      pdfioStreamClose(st);
+	      _pdfioFileError(dict->pdf, "Early end-of-file in image file.");
+	      return (NULL);
+	    }
+
+            crc    = update_png_crc(crc, buffer, (size_t)bytes);
+            length -= bytes;
+          }
+          break;
+    }
+
+    // Verify the CRC...
+    crc ^= 0xffffffff;
+
+    if (image_read(src, buffer, 4) != 4)
+    {
+      pdfioStreamClose(st);
+      _pdfioFileError(dict->pdf, "Unable to read CRC.");
+      return (NULL);
+    }
+
+    temp = (unsigned)((buffer[0] << 24) | (buffer[1] << 16) | (buffer[2] << 8) | buffer[3]);
+    if (temp != crc)
+    {
+      pdfioStreamClose(st);
+      _pdfioFileError(dict->pdf, "Bad CRC (0x%08x != 0x%08x).", temp, crc);
+      return (NULL);
+    }
+  }
+
+  return (NULL);
+}
+
+
+//
+// 'create_cp1252()' - Create the CP1252 font encoding object.
+//
+
+static bool				// O - `true` on success, `false` on failure
+create_cp1252(pdfio_file_t *pdf)	// I - PDF file
+{
+  int		ch;			// Current character
+  bool		chindex;		// Need character index?
+  pdfio_dict_t	*cp1252_dict;		// Encoding dictionary
+  pdfio_array_t	*cp1252_array;		// Differences array
+  static const char * const cp1252[] =	// Glyphs for CP1252 encoding
+  {
+    "space",
+    "exclam",
+    "quotedbl",
     "numbersign",
     "dollar",
     "percent",
@@ -3191,42 +4368,1399 @@ create_cp1252(pdfio_file_t *pdf)	// I - PDF file
   };
 
 
-  if ((cp1252_dict = pdfioDictCreate(pdf)) == NULL || (cp1252_array = pdfioArrayCreate(pdf)) == NULL)
+  if ((cp1252_dict = pdfioDictCreate(pdf)) == NULL || (cp1252_array = pdfioArrayCreate(pdf)) == NULL)
+    return (false);
+
+  for (ch = 0, chindex = true; ch < (int)(sizeof(cp1252) / sizeof(cp1252[0])); ch ++)
+  {
+    if (cp1252[ch][0])
+    {
+      // Add this character...
+      if (chindex)
+      {
+	// Add the initial index...
+	pdfioArrayAppendNumber(cp1252_array, ch + 32);
+	chindex = false;
+      }
+
+      pdfioArrayAppendName(cp1252_array, cp1252[ch]);
+    }
+    else
+    {
+      // Flag that we need a new index...
+      chindex = true;
+    }
+  }
+
+  pdfioDictSetName(cp1252_dict, "Type", "Encoding");
+  pdfioDictSetArray(cp1252_dict, "Differences", cp1252_array);
+
+  if ((pdf->cp1252_obj = pdfioFileCreateObj(pdf, cp1252_dict)) == NULL)
+    return (false);
+
+  pdfioObjClose(pdf->cp1252_obj);
+
+  return (true);
+}
+
+
+//
+// 'create_font_obj()' - Create a font object from a TrueType/OpenType font.
+//
+
+static pdfio_obj_t *			// O - Font object or `NULL` on error
+create_font_obj(pdfio_file_t *pdf,	// I - PDF file
+                pdfio_font_t *font,	// I - Font
+                bool         unicode)	// I - Force Unicode
+{
+  ttf_t		*ttf = font->ttf;	// TrueType font data
+  ttf_rect_t	bounds;			// Font bounds
+  pdfio_dict_t	*dict,			// Font dictionary
+		*desc,			// Font descriptor
+		*file;			// Font file dictionary
+  pdfio_obj_t	*obj = NULL,		// Font object
+		*desc_obj,		// Font descriptor object
+		*file_obj;		// Font file object
+  const char	*basefont;		// Base font name
+  pdfio_array_t	*bbox;			// Font bounding box array
+  pdfio_stream_t *st;			// Font stream
+  unsigned char	buffer[16384];		// Write buffer
+  bool		subset;			// Subset the font when the file is closed?
+
+
+  subset = unicode && (pdf->options & PDFIO_OPTION_SUBSET_FONTS);
+
+  // Create the font file dictionary and object...
+  if ((file = pdfioDictCreate(pdf)) == NULL)
+    goto done;
+
+  pdfioDictSetName(file, "Filter", "FlateDecode");
+
+  if ((file_obj = pdfioFileCreateObj(pdf, file)) == NULL)
+    goto done;
+
+  if (!subset)
+  {
+    // Copy the whole font file, subset fonts are written by pdfioFileClose.
+    // Shared fonts may already have compressed data that is copied as-is...
+    if ((st = pdfioObjCreateStream(file_obj, font->flate ? PDFIO_FILTER_NONE : PDFIO_FILTER_FLATE)) == NULL)
+      goto done;
+
+    if (!pdfioStreamWrite(st, font->flate ? font->flate : font->data, font->flate ? font->flatelen : font->datalen))
+    {
+      pdfioStreamClose(st);
+      goto done;
+    }
+
+    pdfioStreamClose(st);
+  }
+
+  // Create the font descriptor dictionary and object...
+  if ((bbox = pdfioArrayCreate(pdf)) == NULL)
+    goto done;
+
+  ttfGetBounds(ttf, &bounds);
+
+  pdfioArrayAppendNumber(bbox, bounds.left);
+  pdfioArrayAppendNumber(bbox, bounds.bottom);
+  pdfioArrayAppendNumber(bbox, bounds.right);
+  pdfioArrayAppendNumber(bbox, bounds.top);
+
+  if ((desc = pdfioDictCreate(pdf)) == NULL)
+    goto done;
+
+  if (subset)
+  {
+    // Prefix the font name with a unique subset tag ("ABCDEF+FontName")...
+    char	tagname[256];		// Subset font name
+    size_t	tagnum,			// Tag number
+		taglen;			// Tag length
+
+    for (taglen = 0, tagnum = file_obj->number; taglen < 6; taglen ++, tagnum /= 26)
+      tagname[5 - taglen] = (char)('A' + tagnum % 26);
+
+    snprintf(tagname + 6, sizeof(tagname) - 6, "+%s", ttfGetPostScriptName(ttf));
+
+    basefont = pdfioStringCreate(pdf, tagname);
+  }
+  else
+  {
+    basefont = pdfioStringCreate(pdf, ttfGetPostScriptName(ttf));
+  }
+
+  pdfioDictSetName(desc, "Type", "FontDescriptor");
+  pdfioDictSetName(desc, "FontName", basefont);
+  pdfioDictSetObj(desc, "FontFile2", file_obj);
+  pdfioDictSetNumber(desc, "Flags", ttfIsFixedPitch(ttf) ? 0x21 : 0x20);
+  pdfioDictSetArray(desc, "FontBBox", bbox);
+  pdfioDictSetNumber(desc, "ItalicAngle", ttfGetItalicAngle(ttf));
+  pdfioDictSetNumber(desc, "Ascent", ttfGetAscent(ttf));
+  pdfioDictSetNumber(desc, "Descent", ttfGetDescent(ttf));
+  pdfioDictSetNumber(desc, "CapHeight", ttfGetCapHeight(ttf));
+  pdfioDictSetNumber(desc, "XHeight", ttfGetXHeight(ttf));
+  // Note: No TrueType value exists for this but PDF requires it, so we
+  // calculate a generic value from 50 to 250 based on the weight...
+  pdfioDictSetNumber(desc, "StemV", ttfGetWeight(ttf) / 4 + 25);
+
+  if ((desc_obj = pdfioFileCreateObj(pdf, desc)) == NULL)
+    goto done;
+
+  pdfioObjClose(desc_obj);
+
+  if (unicode)
+  {
+    // Unicode (CID) font...
+    pdfio_dict_t	*cid2gid,	// CIDToGIDMap dictionary
+			*to_unicode;	// ToUnicode dictionary
+    pdfio_obj_t		*cid2gid_obj,	// CIDToGIDMap object
+			*to_unicode_obj;// ToUnicode object
+    size_t		i,		// Looping var
+			start,		// Start character
+			num_cmap;	// Number of CMap entries
+    const int		*cmap;		// CMap entries
+    int			min_glyph,	// First glyph
+			max_glyph;	// Last glyph
+    unsigned short	glyphs[65536];	// Glyph to Unicode mapping
+    unsigned char	*bufptr,	// Pointer into buffer
+			*bufend;	// End of buffer
+    pdfio_dict_t	*type2;		// CIDFontType2 font dictionary
+    pdfio_obj_t		*type2_obj;	// CIDFontType2 font object
+    pdfio_array_t	*descendants;	// Decendant font list
+    pdfio_dict_t	*sidict;	// CIDSystemInfo dictionary
+    pdfio_array_t	*w_array,	// Width array
+			*temp_array;	// Temporary width sub-array
+    int			w0, w1;		// Widths
+
+    // Create a CIDSystemInfo mapping to Adobe UCS2 v0 (Unicode)
+    if ((sidict = pdfioDictCreate(pdf)) == NULL)
+      goto done;
+
+    pdfioDictSetString(sidict, "Registry", "Adobe");
+    pdfioDictSetString(sidict, "Ordering", "Identity");
+    pdfioDictSetNumber(sidict, "Supplement", 0);
+
+    // Create a CIDToGIDMap object for the Unicode font...
+    if ((cid2gid = pdfioDictCreate(pdf)) == NULL)
+      goto done;
+
+#ifndef DEBUG
+    pdfioDictSetName(cid2gid, "Filter", "FlateDecode");
+#endif // !DEBUG
+
+    if ((cid2gid_obj = pdfioFileCreateObj(pdf, cid2gid)) == NULL)
+      goto done;
+
+    if (subset)
+    {
+      // The CIDToGIDMap is written when the file is closed...
+    }
+    else
+    {
+#ifdef DEBUG
+      if ((st = pdfioObjCreateStream(cid2gid_obj, PDFIO_FILTER_NONE)) == NULL)
+#else
+      if ((st = pdfioObjCreateStream(cid2gid_obj, PDFIO_FILTER_FLATE)) == NULL)
+#endif // DEBUG
+        goto done;
+
+      cmap      = ttfGetCMap(ttf, &num_cmap);
+      min_glyph = 65536;
+      max_glyph = 0;
+      memset(glyphs, 0, sizeof(glyphs));
+
+      PDFIO_DEBUG("pdfioFileCreateFontObjFromFile: num_cmap=%u\n", (unsigned)num_cmap);
+
+      for (i = 0, bufptr = buffer, bufend = buffer + sizeof(buffer); i < num_cmap; i ++)
+      {
+        PDFIO_DEBUG("pdfioFileCreateFontObjFromFile: cmap[%u]=%d\n", (unsigned)i, cmap[i]);
+        if (cmap[i] < 0)
+        {
+          // Map undefined glyph to .notdef...
+          *bufptr++ = 0;
+          *bufptr++ = 0;
+        }
+        else
+        {
+          // Map to specified glyph...
+          *bufptr++ = (unsigned char)(cmap[i] >> 8);
+          *bufptr++ = (unsigned char)(cmap[i] & 255);
+
+          glyphs[cmap[i]] = (unsigned short)i;
+          if (cmap[i] < min_glyph)
+            min_glyph = cmap[i];
+          if (cmap[i] > max_glyph)
+            max_glyph = cmap[i];
+        }
+
+        if (bufptr >= bufend)
+        {
+          // Flush buffer...
+          if (!pdfioStreamWrite(st, buffer, (size_t)(bufptr - buffer)))
+          {
+	    pdfioStreamClose(st);
+	    goto done;
+          }
+
+          bufptr = buffer;
+        }
+      }
+
+      if (bufptr > buffer)
+      {
+        // Flush buffer...
+        if (!pdfioStreamWrite(st, buffer, (size_t)(bufptr - buffer)))
+        {
+	  pdfioStreamClose(st);
+	  goto done;
+        }
+      }
+
+      pdfioStreamClose(st);
+    }
+
+    // ToUnicode mapping object
+    to_unicode = pdfioDictCreate(pdf);
+    pdfioDictSetName(to_unicode, "Type", "CMap");
+    pdfioDictSetName(to_unicode, "CMapName", "Adobe-Identity-UCS2");
+    pdfioDictSetDict(to_unicode, "CIDSystemInfo", sidict);
+
+#ifndef DEBUG
+    pdfioDictSetName(to_unicode, "Filter", "FlateDecode");
+#endif // !DEBUG
+
+    if ((to_unicode_obj = pdfioFileCreateObj(pdf, to_unicode)) == NULL)
+      goto done;
+
+#ifdef DEBUG
+    if ((st = pdfioObjCreateStream(to_unicode_obj, PDFIO_FILTER_NONE)) == NULL)
+#else
+    if ((st = pdfioObjCreateStream(to_unicode_obj, PDFIO_FILTER_FLATE)) == NULL)
+#endif // DEBUG
+      goto done;
+
+    pdfioStreamPuts(st,
+		    "stream\n"
+		    "/CIDInit /ProcSet findresource begin\n"
+		    "12 dict begin\n"
+		    "begincmap\n"
+		    "/CIDSystemInfo<<\n"
+		    "/Registry (Adobe)\n"
+		    "/Ordering (UCS2)\n"
+		    "/Supplement 0\n"
+		    ">> def\n"
+		    "/CMapName /Adobe-Identity-UCS2 def\n"
+		    "/CMapType 2 def\n"
+		    "1 begincodespacerange\n"
+		    "<0000> <FFFF>\n"
+		    "endcodespacerange\n"
+		    "1 beginbfrange\n"
+		    "<0000> <FFFF> <0000>\n"
+                    "endbfrange\n"
+                    "endcmap\n"
+                    "CMapName currentdict /CMap defineresource pop\n"
+                    "end\n"
+                    "end\n");
+
+    pdfioStreamClose(st);
+
+    // Create a CIDFontType2 dictionary for the Unicode font...
+    if ((type2 = pdfioDictCreate(pdf)) == NULL)
+      goto done;
+
+    if (subset)
+    {
+      // The width array is written when the file is closed...
+      w_array = NULL;
+    }
+    else
+    {
+      // Width array
+      if ((w_array = pdfioArrayCreate(pdf)) == NULL)
+        goto done;
+
+      for (start = 0, w0 = ttfGetWidth(ttf, 0), w1 = 0, i = 1; i < 65536; start = i, w0 = w1, i ++)
+      {
+        while (i < 65536 && (w1 = ttfGetWidth(ttf, (int)i)) == w0)
+          i ++;
+
+        if ((i - start) > 1)
+        {
+          // Encode a repeating sequence...
+          pdfioArrayAppendNumber(w_array, start);
+          pdfioArrayAppendNumber(w_array, i - 1);
+          pdfioArrayAppendNumber(w_array, w0);
+        }
+        else
+        {
+          // Encode a non-repeating sequence...
+          pdfioArrayAppendNumber(w_array, start);
+
+          if ((temp_array = pdfioArrayCreate(pdf)) == NULL)
+	    goto done;
+
+          pdfioArrayAppendNumber(temp_array, w0);
+          for (w0 = w1, i ++; i < 65536; w0 = w1, i ++)
+          {
+            if ((w1 = ttfGetWidth(ttf, (int)i)) == w0 && i < 65535)
+              break;
+
+	    pdfioArrayAppendNumber(temp_array, w0);
+          }
+
+          if (i == 65536)
+	    pdfioArrayAppendNumber(temp_array, w0);
+	  else
+	    i --;
+
+          pdfioArrayAppendArray(w_array, temp_array);
+        }
+      }
+    }
+
+    // Then the dictionary for the CID base font...
+    pdfioDictSetName(type2, "Type", "Font");
+    pdfioDictSetName(type2, "Subtype", "CIDFontType2");
+    pdfioDictSetName(type2, "BaseFont", basefont);
+    pdfioDictSetDict(type2, "CIDSystemInfo", sidict);
+    pdfioDictSetObj(type2, "CIDToGIDMap", cid2gid_obj);
+    pdfioDictSetObj(type2, "FontDescriptor", desc_obj);
+    if (w_array)
+      pdfioDictSetArray(type2, "W", w_array);
+
+    if ((type2_obj = pdfioFileCreateObj(pdf, type2)) == NULL)
+      goto done;
+
+    if (!subset)
+      pdfioObjClose(type2_obj);
+
+    // Create a Type 0 font object...
+    if ((descendants = pdfioArrayCreate(pdf)) == NULL)
+      goto done;
+
+    pdfioArrayAppendObj(descendants, type2_obj);
+
+    if ((dict = pdfioDictCreate(pdf)) == NULL)
+      goto done;
+
+    pdfioDictSetName(dict, "Type", "Font");
+    pdfioDictSetName(dict, "Subtype", "Type0");
+    pdfioDictSetName(dict, "BaseFont", basefont);
+    pdfioDictSetArray(dict, "DescendantFonts", descendants);
+    pdfioDictSetName(dict, "Encoding", "Identity-H");
+    pdfioDictSetObj(dict, "ToUnicode", to_unicode_obj);
+
+    if ((obj = pdfioFileCreateObj(pdf, dict)) != NULL)
+    {
+      pdfioObjClose(obj);
+
+      if (subset && !add_subset_font(pdf, obj, type2_obj, file_obj, cid2gid_obj))
+        obj = NULL;
+    }
+  }
+  else
+  {
+    // Simple (CP1282 or custom encoding) 8-bit font...
+    if (ttfGetMaxChar(ttf) >= 255 && !pdf->cp1252_obj && !create_cp1252(pdf))
+      goto done;
+
+    // Create a TrueType font object...
+    if ((dict = pdfioDictCreate(pdf)) == NULL)
+      goto done;
+
+    pdfioDictSetName(dict, "Type", "Font");
+    pdfioDictSetName(dict, "Subtype", "TrueType");
+    pdfioDictSetName(dict, "BaseFont", basefont);
+    if (ttfGetMaxChar(ttf) >= 255)
+      pdfioDictSetObj(dict, "Encoding", pdf->cp1252_obj);
+
+    pdfioDictSetObj(dict, "FontDescriptor", desc_obj);
+
+    if ((obj = pdfioFileCreateObj(pdf, dict)) != NULL)
+      pdfioObjClose(obj);
+  }
+
+  done:
+
+  return (obj);
+}
+
+
+//
+// 'font_error_cb()' - Relay a message for a shared font.
+//
+
+static void
+font_error_cb(pdfio_font_t *font,	// I - Font
+              const char   *message)	// I - Error message
+{
+  if (font->error_cb)
+    (font->error_cb)(NULL, message, font->error_data);
+  else
+    _pdfioFileDefaultError(NULL, message, NULL);
+}
+
+
+//
+// 'get_file_digest()' - Compute a digest for the identity of a file.
+//
+// The digest covers the resource type, filename, parameter, device, inode,
+// size, and modification time of the file so that the same file is only
+// embedded once in a PDF file.
+//
+
+static bool				// O - `true` on success, `false` if the file cannot be identified
+get_file_digest(int          fd,	// I - File descriptor
+                const char   *type,	// I - Resource type
+                const char   *filename,	// I - Filename
+                unsigned     param,	// I - Resource parameter
+                uint8_t      *digest)	// O - SHA-256 digest
+{
+  struct stat		fileinfo;	// File information
+  _pdfio_sha256_t	ctx;		// SHA-256 context
+  char			identity[256];	// File identity
+
+
+  if (fstat(fd, &fileinfo))
+    return (false);
+
+  snprintf(identity, sizeof(identity), "%s %u %lu %lu %lu %ld", type, param, (unsigned long)fileinfo.st_dev, (unsigned long)fileinfo.st_ino, (unsigned long)fileinfo.st_size, (long)fileinfo.st_mtime);
+
+  _pdfioCryptoSHA256Init(&ctx);
+  _pdfioCryptoSHA256Append(&ctx, (uint8_t *)identity, strlen(identity) + 1);
+  _pdfioCryptoSHA256Append(&ctx, (const uint8_t *)filename, strlen(filename));
+  _pdfioCryptoSHA256Finish(&ctx, digest);
+
+  return (true);
+}
+
+
+//
+// 'get_text_widths()' - Get the character widths for a font object.
+//
+// The cached widths of a TrueType/OpenType font are locked until
+// @code release_text_widths@ is called.
+//
+
+static bool				// O - `true` on success, `false` if the font cannot be measured
+get_text_widths(
+    pdfio_obj_t      *font,		// I - Font object
+    bool             unicode,		// I - Unicode text?
+    _pdfio_twidths_t *tw)		// O - Character widths
+{
+  const char	*basefont;		// Base font name
+
+
+  memset(tw, 0, sizeof(_pdfio_twidths_t));
+
+  if (!font)
+    return (false);
+
+  if ((tw->font = (pdfio_font_t *)_pdfioObjGetExtension(font)) != NULL && tw->font->ttf)
+  {
+    // Use the TrueType font widths, which are cached as they are used...
+    tw->cp1252 = !unicode;
+
+#ifdef _WIN32
+    EnterCriticalSection(&tw->font->widths_mutex);
+#else
+    pthread_mutex_lock(&tw->font->widths_mutex);
+#endif // _WIN32
+
+    return (true);
+  }
+
+  tw->font   = NULL;
+  tw->cp1252 = true;
+
+  if ((basefont = pdfioDictGetName(pdfioObjGetDict(font), "BaseFont")) == NULL)
+    return (false);
+
+  // Choose the appropriate compiled-in base font table...
+  if (!strcmp(basefont, "Courier"))
+    tw->base = courier_widths;
+  else if (!strcmp(basefont, "Courier-Bold"))
+    tw->base = courier_bold_widths;
+  else if (!strcmp(basefont, "Courier-BoldOblique"))
+    tw->base = courier_boldoblique_widths;
+  else if (!strcmp(basefont, "Courier-Oblique"))
+    tw->base = courier_oblique_widths;
+  else if (!strcmp(basefont, "Helvetica"))
+    tw->base = helvetica_widths;
+  else if (!strcmp(basefont, "Helvetica-Bold"))
+    tw->base = helvetica_bold_widths;
+  else if (!strcmp(basefont, "Helvetica-BoldOblique"))
+    tw->base = helvetica_boldoblique_widths;
+  else if (!strcmp(basefont, "Helvetica-Oblique"))
+    tw->base = helvetica_oblique_widths;
+  else if (!strcmp(basefont, "Symbol"))
+    tw->base = symbol_widths;
+  else if (!strcmp(basefont, "Times-Bold"))
+    tw->base = times_bold_widths;
+  else if (!strcmp(basefont, "Times-BoldItalic"))
+    tw->base = times_bolditalic_widths;
+  else if (!strcmp(basefont, "Times-Italic"))
+    tw->base = times_italic_widths;
+  else if (!strcmp(basefont, "Times-Roman"))
+    tw->base = times_roman_widths;
+  else if (!strcmp(basefont, "ZapfDingbats"))
+    tw->base = zapfdingbats_widths;
+  else
+    return (false);
+
+  return (true);
+}
+
+
+//
+// 'image_copy()' - Copy image file data to a stream.
+//
+
+static bool				// O - `true` on success, `false` on error
+image_copy(_pdfio_isrc_t  *src,		// I - Image file source
+           pdfio_stream_t *st,		// I - Image stream
+           size_t         length,	// I - Number of bytes or `SIZE_MAX` for the rest of the file
+           unsigned       *crc)		// IO - PNG CRC-32 or `NULL` for none
+{
+  ssize_t	bytes;			// Bytes read
+  unsigned char	buffer[16384];		// Copy buffer
+
+
+  if (src->data)
+  {
+    // Write image data in memory directly to the stream...
+    size_t	remaining = src->datalen - (size_t)src->offset;
+					// Remaining bytes
+
+    if (length == SIZE_MAX)
+      length = remaining;
+    else if (length > remaining)
+      return (false);
+
+    if (crc)
+      *crc = update_png_crc(*crc, src->data + src->offset, length);
+
+    if (!pdfioStreamWrite(st, src->data + src->offset, length))
+      return (false);
+
+    src->offset += (off_t)length;
+
+    return (true);
+  }
+
+  while (length > 0)
+  {
+    if ((bytes = image_read(src, buffer, length > sizeof(buffer) ? sizeof(buffer) : length)) < 0)
+      return (false);
+    else if (bytes == 0)
+      return (length == SIZE_MAX);
+
+    if (crc)
+      *crc = update_png_crc(*crc, buffer, (size_t)bytes);
+
+    if (!pdfioStreamWrite(st, buffer, (size_t)bytes))
+      return (false);
+
+    if (length != SIZE_MAX)
+      length -= (size_t)bytes;
+  }
+
+  return (true);
+}
+
+
+//
+// 'image_read()' - Read image file data.
+//
+// This function only returns fewer bytes than requested at the end of the
+// file.
+//
+
+static ssize_t				// O - Number of bytes read or `-1` on error
+image_read(_pdfio_isrc_t *src,		// I - Image file source
+           void          *buffer,	// I - Read buffer
+           size_t        bytes)		// I - Number of bytes to read
+{
+  unsigned char	*bufptr = (unsigned char *)buffer;
+					// Pointer into buffer
+  ssize_t	rbytes;			// Bytes read
+
+
+  if (src->data)
+  {
+    // Copy from memory...
+    if (bytes > (src->datalen - (size_t)src->offset))
+      bytes = src->datalen - (size_t)src->offset;
+
+    memcpy(buffer, src->data + src->offset, bytes);
+    src->offset += (off_t)bytes;
+
+    return ((ssize_t)bytes);
+  }
+
+  while (bytes > 0)
+  {
+    if (src->input_cb)
+    {
+      if ((rbytes = (src->input_cb)(src->input_ctx, src->offset, bufptr, bytes)) > 0)
+        src->offset += rbytes;
+    }
+    else
+    {
+      rbytes = read(src->fd, bufptr, bytes);
+    }
+
+    if (rbytes < 0)
+    {
+      if (errno == EINTR || errno == EAGAIN)
+        continue;
+
+      return (-1);
+    }
+    else if (rbytes == 0)
+    {
+      break;
+    }
+
+    bufptr += rbytes;
+    bytes  -= (size_t)rbytes;
+  }
+
+  return ((ssize_t)(bufptr - (unsigned char *)buffer));
+}
+
+
+//
+// 'image_rewind()' - Go back to the beginning of the image file.
+//
+
+static bool				// O - `true` on success, `false` on error
+image_rewind(_pdfio_isrc_t *src)	// I - Image file source
+{
+  src->offset = 0;
+
+  if (src->fd >= 0)
+    return (lseek(src->fd, 0, SEEK_SET) == 0);
+
+  return (true);
+}
+
+
+//
+// 'load_font()' - Load a TrueType/OpenType font file into memory.
+//
+
+static bool				// O - `true` on success, `false` on error
+load_font(pdfio_font_t *font,		// I - Font
+          int          fd,		// I - File descriptor
+          const char   *filename,	// I - Filename
+          bool         compress,	// I - Compress the font data?
+          ttf_err_cb_t err_cb,		// I - Error callback
+          void         *err_data)	// I - Error callback data
+{
+  struct stat	fileinfo;		// File information
+  ssize_t	bytes;			// Bytes read
+  size_t	total;			// Total bytes read
+  uLongf	flatelen;		// Length of compressed data
+  char		message[1024];		// Error message
+
+
+  // Read the font file...
+  if (fstat(fd, &fileinfo) || fileinfo.st_size <= 0)
+  {
+    snprintf(message, sizeof(message), "Unable to get size of font file '%s'.", filename);
+    (err_cb)(err_data, message);
+    return (false);
+  }
+
+  font->datalen = (size_t)fileinfo.st_size;
+
+  if ((font->data = (unsigned char *)malloc(font->datalen)) == NULL)
+  {
+    snprintf(message, sizeof(message), "Unable to allocate memory for font file '%s'.", filename);
+    (err_cb)(err_data, message);
+    return (false);
+  }
+
+  for (total = 0; total < font->datalen; total += (size_t)bytes)
+  {
+    if ((bytes = read(fd, font->data + total, font->datalen - total)) <= 0)
+    {
+      snprintf(message, sizeof(message), "Unable to read font file '%s'.", filename);
+      (err_cb)(err_data, message);
+      return (false);
+    }
+  }
+
+  // Parse the font...
+  if ((font->ttf = ttfCreateData(font->data, font->datalen, 0, err_cb, err_data)) == NULL)
+    return (false);
+
+  // Compress the font data as needed...
+  if (compress)
+  {
+    flatelen = compressBound((uLong)font->datalen);
+
+    if ((font->flate = (unsigned char *)malloc((size_t)flatelen)) == NULL || compress2(font->flate, &flatelen, font->data, (uLong)font->datalen, 9) != Z_OK)
+    {
+      // Fall back to compressing the font data for each PDF file...
+      free(font->flate);
+      font->flate = NULL;
+    }
+    else
+    {
+      font->flatelen = (size_t)flatelen;
+    }
+  }
+
+  return (true);
+}
+
+
+//
+// 'measure_char()' - Get the width of a TrueType/OpenType character in 1000ths.
+//
+// Widths of characters in the Basic Multilingual Plane are cached in blocks of
+// 256 characters the first time a character in the block is measured.  The
+// caller must hold the font's widths mutex.
+//
+
+static double				// O - Width in 1000ths
+measure_char(pdfio_font_t *font,	// I - Font
+             int          ch)		// I - Unicode character
+{
+  float		*widths;		// Cached widths
+  int		i,			// Looping var
+		cch;			// Current character
+  char		temp[5],		// UTF-8 character
+		*tempptr;		// Pointer into UTF-8 character
+  ttf_rect_t	extents;		// Character extents
+
+
+  if (ch < 65536 && (widths = font->widths[ch >> 8]) != NULL)
+    return (widths[ch & 255]);
+
+  if (ch < 65536 && (widths = (float *)calloc(256, sizeof(float))) != NULL)
+  {
+    // Measure the widths of all characters in this block...
+    for (i = 0, cch = ch & ~255; i < 256; i ++, cch ++)
+    {
+      tempptr = temp;
+
+      if (cch == 0)
+        continue;
+      else if (cch < 0x80)
+      {
+        *tempptr++ = (char)cch;
+      }
+      else if (cch < 0x800)
+      {
+        *tempptr++ = (char)(0xc0 | (cch >> 6));
+        *tempptr++ = (char)(0x80 | (cch & 0x3f));
+      }
+      else
+      {
+        *tempptr++ = (char)(0xe0 | (cch >> 12));
+        *tempptr++ = (char)(0x80 | ((cch >> 6) & 0x3f));
+        *tempptr++ = (char)(0x80 | (cch & 0x3f));
+      }
+
+      *tempptr = '\0';
+
+      if (ttfGetExtents(font->ttf, 1000.0f, temp, &extents))
+        widths[i] = extents.right - extents.left;
+    }
+
+    font->widths[ch >> 8] = widths;
+
+    return (widths[ch & 255]);
+  }
+
+  // Measure characters outside the BMP directly...
+  temp[0] = (char)(0xf0 | ((ch >> 18) & 0x07));
+  temp[1] = (char)(0x80 | ((ch >> 12) & 0x3f));
+  temp[2] = (char)(0x80 | ((ch >> 6) & 0x3f));
+  temp[3] = (char)(0x80 | (ch & 0x3f));
+  temp[4] = '\0';
+
+  if (ch >= 65536 && ttfGetExtents(font->ttf, 1000.0f, temp, &extents))
+    return (extents.right - extents.left);
+  else
+    return (0.0);
+}
+
+
+//
+// 'measure_text()' - Measure a UTF-8 string in 1000ths.
+//
+// Control characters are ignored.  When the font uses the CP1252 encoding,
+// characters that cannot be represented are measured as '?'.
+//
+
+static double				// O - Width in 1000ths
+measure_text(_pdfio_twidths_t *tw,	// I - Character widths
+             const char       *s,	// I - Start of string
+             const char       *end)	// I - End of string
+{
+  int		ch;			// Unicode character
+  size_t	i;			// Looping var
+  double	width = 0.0;		// Width of string
+
+
+  while (s < end && *s)
+  {
+    if ((ch = text_getc(&s, end)) < ' ')
+      continue;
+
+    if (tw->cp1252 && ch > 255)
+    {
+      // Try mapping from Unicode to CP1252...
+      for (i = 0; i < (sizeof(_pdfio_cp1252) / sizeof(_pdfio_cp1252[0])); i ++)
+      {
+        if (ch == _pdfio_cp1252[i])
+          break;
+      }
+
+      if (i >= (sizeof(_pdfio_cp1252) / sizeof(_pdfio_cp1252[0])))
+        ch = '?';			// Unsupported chars map to ?
+      else if (tw->base)
+        ch = (int)(i + 0x80);		// Extra characters from 0x80 to 0x9f
+    }
+
+    if (tw->base)
+      width += tw->base[ch & 255];
+    else if (tw->font)
+      width += measure_char(tw->font, ch);
+  }
+
+  return (width);
+}
+
+
+//
+// 'new_font()' - Allocate a new font.
+//
+
+static pdfio_font_t *			// O - Font or `NULL` on error
+new_font(void)
+{
+  pdfio_font_t	*font;			// Font
+
+
+  if ((font = (pdfio_font_t *)calloc(1, sizeof(pdfio_font_t))) == NULL)
+    return (NULL);
+
+#ifdef _WIN32
+  InitializeCriticalSection(&font->widths_mutex);
+#else
+  pthread_mutex_init(&font->widths_mutex, NULL);
+#endif // _WIN32
+
+  return (font);
+}
+
+
+//
+// 'pbuf_flush()' - Write buffered path data to the content stream.
+//
+
+static bool				// O - `true` on success, `false` on failure
+pbuf_flush(_pdfio_pbuf_t *pb)		// I - Output buffer
+{
+  if (pb->bufptr > pb->buffer && !pb->error)
+  {
+    if (!pdfioStreamWrite(pb->st, pb->buffer, (size_t)(pb->bufptr - pb->buffer)))
+      pb->error = true;
+  }
+
+  pb->bufptr = pb->buffer;
+
+  return (!pb->error);
+}
+
+
+//
+// 'pbuf_init()' - Initialize a path output buffer.
+//
+// Numbers use the same significant digits and decimal places as
+// @link pdfioStreamPrintf@ does for "%g".
+//
+
+static void
+pbuf_init(_pdfio_pbuf_t  *pb,		// I - Output buffer
+          pdfio_stream_t *st)		// I - Content stream
+{
+  pb->st     = st;
+  pb->error  = false;
+  pb->bufptr = pb->buffer;
+  pb->bufend = pb->buffer + sizeof(pb->buffer);
+
+  if (st->pdf->precision == PDFIO_PRECISION_SHORTEST)
+  {
+    pb->digits   = 17;
+    pb->decimals = -1;
+  }
+  else if (st->pdf->precision >= 0)
+  {
+    pb->digits   = 17;
+    pb->decimals = st->pdf->precision;
+  }
+  else
+  {
+    pb->digits   = 6;
+    pb->decimals = 17;
+  }
+}
+
+
+//
+// 'pbuf_number()' - Add a number and a trailing space to a path output buffer.
+//
+
+static void
+pbuf_number(_pdfio_pbuf_t *pb,		// I - Output buffer
+            double        number)	// I - Number
+{
+  // Numbers with an integer part of more than 17 digits can be up to 310
+  // characters long and the shortest form of very small numbers up to 345
+  // characters, so flush early...
+  if ((pb->bufend - pb->bufptr) < 360)
+    pbuf_flush(pb);
+
+  pb->bufptr += _pdfio_dtostr(pb->bufptr, (size_t)(pb->bufend - pb->bufptr), number, pb->digits, pb->decimals);
+  *(pb->bufptr)++ = ' ';
+}
+
+
+//
+// 'pbuf_point()' - Add a transformed point to a path output buffer.
+//
+
+static void
+pbuf_point(_pdfio_pbuf_t  *pb,		// I - Output buffer
+           pdfio_matrix_t m,		// I - Transform matrix or `NULL` for none
+           double         x,		// I - X position
+           double         y)		// I - Y position
+{
+  if (m)
+  {
+    pbuf_number(pb, m[0][0] * x + m[1][0] * y + m[2][0]);
+    pbuf_number(pb, m[0][1] * x + m[1][1] * y + m[2][1]);
+  }
+  else
+  {
+    pbuf_number(pb, x);
+    pbuf_number(pb, y);
+  }
+}
+
+
+//
+// 'pbuf_puts()' - Add a string to a path output buffer.
+//
+
+static void
+pbuf_puts(_pdfio_pbuf_t *pb,		// I - Output buffer
+          const char    *s)		// I - String
+{
+  size_t	len = strlen(s);	// Length of string
+
+
+  if (len > (size_t)(pb->bufend - pb->bufptr))
+  {
+    pbuf_flush(pb);
+
+    if (len > sizeof(pb->buffer))
+    {
+      // Write long strings directly...
+      if (!pb->error && !pdfioStreamWrite(pb->st, s, len))
+        pb->error = true;
+      return;
+    }
+  }
+
+  memcpy(pb->bufptr, s, len);
+  pb->bufptr += len;
+}
+
+
+//
+// 'release_text_widths()' - Release the character widths for a font object.
+//
+
+static void
+release_text_widths(
+    _pdfio_twidths_t *tw)		// I - Character widths
+{
+  if (!tw->font)
+    return;
+
+#ifdef _WIN32
+  LeaveCriticalSection(&tw->font->widths_mutex);
+#else
+  pthread_mutex_unlock(&tw->font->widths_mutex);
+#endif // _WIN32
+
+  tw->font = NULL;
+}
+
+
+//
+// 'scan_add_operand()' - Add an operand to the content scanner's stack.
+//
+
+static pdfio_operand_t *		// O - New operand or `NULL` on error
+scan_add_operand(
+    _pdfio_scan_t   *scan,		// I - Content scanner
+    pdfio_valtype_t type)		// I - Operand type
+{
+  pdfio_operand_t	*operand;	// New operand
+
+
+  if (scan->num_operands >= scan->alloc_operands)
+  {
+    // Expand the operand stack...
+    size_t		alloc_operands = scan->alloc_operands ? 2 * scan->alloc_operands : 32;
+					// New size of stack
+    pdfio_operand_t	*operands;	// New operands
+    size_t		*offsets;	// New offsets
+
+    if ((operands = (pdfio_operand_t *)realloc(scan->operands, alloc_operands * sizeof(pdfio_operand_t))) == NULL)
+    {
+      _pdfioFileError(scan->page->pdf, "Unable to allocate memory for content stream operands.");
+      scan->error = true;
+      return (NULL);
+    }
+
+    scan->operands = operands;
+
+    if ((offsets = (size_t *)realloc(scan->offsets, alloc_operands * sizeof(size_t))) == NULL)
+    {
+      _pdfioFileError(scan->page->pdf, "Unable to allocate memory for content stream operands.");
+      scan->error = true;
+      return (NULL);
+    }
+
+    scan->offsets        = offsets;
+    scan->alloc_operands = alloc_operands;
+  }
+
+  scan->offsets[scan->num_operands] = scan->textlen;
+
+  operand = scan->operands + scan->num_operands;
+  scan->num_operands ++;
+
+  memset(operand, 0, sizeof(pdfio_operand_t));
+  operand->type = type;
+
+  return (operand);
+}
+
+
+//
+// 'scan_add_text()' - Add a character to the content scanner's text buffer.
+//
+
+static bool				// O - `true` on success, `false` on error
+scan_add_text(_pdfio_scan_t *scan,	// I - Content scanner
+              int           ch)		// I - Character
+{
+  if (scan->textlen >= scan->textsize)
+  {
+    // Expand the text buffer...
+    size_t	textsize = scan->textsize ? 2 * scan->textsize : 1024;
+					// New size of text buffer
+    char	*text;			// New text buffer
+
+    if ((text = (char *)realloc(scan->text, textsize)) == NULL)
+    {
+      _pdfioFileError(scan->page->pdf, "Unable to allocate memory for content stream operands.");
+      scan->error = true;
+      return (false);
+    }
+
+    scan->text     = text;
+    scan->textsize = textsize;
+  }
+
+  scan->text[scan->textlen ++] = (char)ch;
+
+  return (true);
+}
+
+
+//
+// 'scan_close_nesting()' - Close an array or dictionary operand.
+//
+
+static bool				// O - `true` on success, `false` on error
+scan_close_nesting(
+    _pdfio_scan_t   *scan,		// I - Content scanner
+    pdfio_valtype_t type,		// I - Array or dictionary type
+    int             ch)			// I - Closing character for errors
+{
+  size_t	start;			// Index of array/dictionary operand
+
+
+  if (!scan->depth || scan->operands[scan->nesting[scan->depth - 1]].type != type)
+  {
+    _pdfioFileError(scan->page->pdf, "Unexpected '%c' in content stream.", ch);
+    scan->error = true;
     return (false);
+  }
 
-  for (ch = 0, chindex = true; ch < (int)(sizeof(cp1252) / sizeof(cp1252[0])); ch ++)
+  start = scan->nesting[-- scan->depth];
+
+  scan->operands[start].length = scan->num_operands - start - 1;
+
+  return (true);
+}
+
+
+//
+// 'scan_end_text()' - Finish the name/string/image data of the last operand.
+//
+
+static bool				// O - `true` on success, `false` on error
+scan_end_text(_pdfio_scan_t *scan)	// I - Content scanner
+{
+  if (scan->error || !scan->num_operands)
+    return (false);
+
+  scan->operands[scan->num_operands - 1].length = scan->textlen - scan->offsets[scan->num_operands - 1];
+
+  return (scan_add_text(scan, '\0'));
+}
+
+
+//
+// 'scan_fill()' - Read the next block of page content.
+//
+// Each character returned comes from the read buffer so that the caller can
+// push it back with `scan->bufptr --`.  A space is returned between content
+// streams since operators cannot span streams.
+//
+
+static int				// O - Next character or `EOF`
+scan_fill(_pdfio_scan_t *scan)		// I - Content scanner
+{
+  ssize_t	bytes;			// Bytes read
+
+
+  for (;;)
   {
-    if (cp1252[ch][0])
+    if (scan->st)
     {
-      // Add this character...
-      if (chindex)
+      if ((bytes = pdfioStreamRead(scan->st, scan->buffer, sizeof(scan->buffer))) > 0)
       {
-	// Add the initial index...
-	pdfioArrayAppendNumber(cp1252_array, ch + 32);
-	chindex = false;
+        scan->bufptr = scan->buffer;
+        scan->bufend = scan->buffer + bytes;
+
+        return (*(scan->bufptr)++);
       }
 
-      pdfioArrayAppendName(cp1252_array, cp1252[ch]);
+      pdfioStreamClose(scan->st);
+      scan->st = NULL;
+
+      if (bytes < 0)
+      {
+        _pdfioFileError(scan->page->pdf, "Unable to read page content stream.");
+        scan->error = true;
+        return (EOF);
+      }
+
+      scan->buffer[0] = ' ';
+      scan->bufptr    = scan->buffer;
+      scan->bufend    = scan->buffer + 1;
+
+      return (*(scan->bufptr)++);
     }
-    else
+
+    if (scan->cur_stream >= scan->num_streams)
+      return (EOF);
+
+    if ((scan->st = pdfioPageOpenStream(scan->page, scan->cur_stream ++, true)) == NULL)
     {
-      // Flag that we need a new index...
-      chindex = true;
+      _pdfioFileError(scan->page->pdf, "Unable to open page content stream %u.", (unsigned)scan->cur_stream);
+      scan->error = true;
+      return (EOF);
     }
   }
+}
 
-  pdfioDictSetName(cp1252_dict, "Type", "Encoding");
-  pdfioDictSetArray(cp1252_dict, "Differences", cp1252_array);
 
-  if ((pdf->cp1252_obj = pdfioFileCreateObj(pdf, cp1252_dict)) == NULL)
+//
+// 'scan_getc()' - Get the next character of page content.
+//
+
+static int				// O - Next character or `EOF`
+scan_getc(_pdfio_scan_t *scan)		// I - Content scanner
+{
+  if (scan->bufptr < scan->bufend)
+    return (*(scan->bufptr)++);
+  else
+    return (scan_fill(scan));
+}
+
+
+//
+// 'scan_inline_image()' - Read the data for an inline image.
+//
+// The "ID" operator is followed by a single whitespace character and the image
+// data, which is terminated by whitespace and the "EI" operator.
+//
+
+static bool				// O - `true` on success, `false` on error
+scan_inline_image(_pdfio_scan_t *scan)	// I - Content scanner
+{
+  int		ch;			// Current character
+  size_t	start;			// Start of image data, less 1
+  bool		found = false;		// Found the end of the data?
+
+
+  if (!scan_add_operand(scan, PDFIO_VALTYPE_BINARY))
     return (false);
 
-  pdfioObjClose(pdf->cp1252_obj);
+  // The whitespace after "ID" was consumed with the operator, add it back so
+  // that empty image data is recognized...
+  start = scan->textlen;
+
+  if (!scan_add_text(scan, ' '))
+    return (false);
+
+  while ((ch = scan_getc(scan)) != EOF)
+  {
+    if (!scan_add_text(scan, ch))
+      return (false);
+
+    if (ch == 'I' && (scan->textlen - start) >= 3 && scan->text[scan->textlen - 2] == 'E' && isspace(scan->text[scan->textlen - 3] & 255))
+    {
+      // Possible end of data, "EI" must be followed by whitespace or a
+      // delimiter...
+      if ((ch = scan_getc(scan)) == EOF || !ch || isspace(ch))
+      {
+        found = true;
+        break;
+      }
+      else if (strchr(_PDFIO_SCAN_DELIM_CHARS, ch))
+      {
+        scan->bufptr --;
+        found = true;
+        break;
+      }
+
+      if (!scan_add_text(scan, ch))
+        return (false);
+    }
+  }
+
+  if (scan->error)
+    return (false);
+
+  if (!found)
+  {
+    _pdfioFileError(scan->page->pdf, "Unterminated inline image.");
+    scan->error = true;
+    return (false);
+  }
+
+  // Strip the trailing whitespace and "EI" from the data...
+  if ((scan->textlen -= 3) <= start)
+    scan->textlen = start + 1;
+
+  scan->offsets[scan->num_operands - 1] = start + 1;
+
+  return (scan_end_text(scan));
+}
+
+
+//
+// 'scan_number()' - Convert a number token to a value without using the locale.
+//
+
+static bool				// O - `true` on success, `false` if not a number
+scan_number(const char *s,		// I - Token
+            double     *number)		// O - Number value
+{
+  const char	*end;			// End of number
+
+
+  *number = _pdfio_strtod(s, &end);
+
+  return (end > s && !*end);
+}
+
+
+//
+// 'scan_open_nesting()' - Open an array or dictionary operand.
+//
+
+static bool				// O - `true` on success, `false` on error
+scan_open_nesting(
+    _pdfio_scan_t   *scan,		// I - Content scanner
+    pdfio_valtype_t type)		// I - Array or dictionary type
+{
+  if (scan->depth >= _PDFIO_SCAN_MAX_DEPTH)
+  {
+    _pdfioFileError(scan->page->pdf, "Too many nested arrays or dictionaries in content stream.");
+    scan->error = true;
+    return (false);
+  }
+
+  if (!scan_add_operand(scan, type))
+    return (false);
+
+  scan->nesting[scan->depth ++] = scan->num_operands - 1;
 
   return (true);
 }
 
 
+//
+// 'text_getc()' - Get the next Unicode character from a UTF-8 string.
+//
+// Invalid UTF-8 sequences are returned one byte at a time.
+//
+
+static int				// O - Unicode character
+text_getc(const char **s,		// IO - Pointer into string
+          const char *end)		// I  - End of string
+{
+  const unsigned char *ptr = (const unsigned char *)*s;
+					// Pointer into string
+  size_t	len = (size_t)(end - *s);
+					// Remaining bytes
+  int		ch;			// Unicode character
+
+
+  if ((ptr[0] & 0xe0) == 0xc0 && len >= 2 && (ptr[1] & 0xc0) == 0x80)
+  {
+    // Two-byte UTF-8
+    ch = ((ptr[0] & 0x1f) << 6) | (ptr[1] & 0x3f);
+    *s += 2;
+  }
+  else if ((ptr[0] & 0xf0) == 0xe0 && len >= 3 && (ptr[1] & 0xc0) == 0x80 && (ptr[2] & 0xc0) == 0x80)
+  {
+    // Three-byte UTF-8
+    ch = ((ptr[0] & 0x0f) << 12) | ((ptr[1] & 0x3f) << 6) | (ptr[2] & 0x3f);
+    *s += 3;
+  }
+  else if ((ptr[0] & 0xf8) == 0xf0 && len >= 4 && (ptr[1] & 0xc0) == 0x80 && (ptr[2] & 0xc0) == 0x80 && (ptr[3] & 0xc0) == 0x80)
+  {
+    // Four-byte UTF-8
+    ch = ((ptr[0] & 0x07) << 18) | ((ptr[1] & 0x3f) << 12) | ((ptr[2] & 0x3f) << 6) | (ptr[3] & 0x3f);
+    *s += 4;
+  }
+  else
+  {
+    // ASCII or invalid UTF-8...
+    ch = ptr[0];
+    *s += 1;
+  }
+
+  return (ch);
+}
+
+
 //
 // 'ttf_error_cb()' - Relay a message from the TTF functions.
 //
@@ -3268,10 +5802,12 @@ static bool				// O - `true` on success, `false` otherwise
 write_string(pdfio_stream_t *st,	// I - Stream
              bool           unicode,	// I - Unicode text?
              const char     *s,		// I - String
+             size_t         len,	// I - Length of string
              bool           *newline)	// O - Ends with a newline?
 {
   int		ch;			// Unicode character
-  const char	*ptr;			// Pointer into string
+  const char	*ptr,			// Pointer into string
+		*end = s + len;		// End of string
 
 
   // Start the string...
@@ -3279,7 +5815,7 @@ write_string(pdfio_stream_t *st,	// I - Stream
     return (false);
 
   // Loop through the string, handling UTF-8 as needed...
-  for (ptr = s; *ptr; ptr ++)
+  for (ptr = s; ptr < end && *ptr; ptr ++)
   {
     if ((*ptr & 0xe0) == 0xc0)
     {
@@ -3309,6 +5845,10 @@ write_string(pdfio_stream_t *st,	// I - Stream
 
     if (unicode)
     {
+      // Track characters for subset fonts...
+      if (st->pdf->used_chars && ch < 65536)
+        st->pdf->used_chars[ch / 8] |= (uint8_t)(1 << (ch & 7));
+
       // Write a two-byte character...
       if (!pdfioStreamPrintf(st, "%04X", ch))
 	return (false);
@@ -3356,3 +5896,146 @@ write_string(pdfio_stream_t *st,	// I - Stream
 
   return (pdfioStreamPuts(st, unicode ? ">" : ")"));
 }
+
+
+//
+// 'write_subset_font()' - Write the data for a subset font.
+//
+// Glyph numbers are preserved in the subset font, so the CIDToGIDMap only
+// needs to cover the characters that are used.  The width array likewise only
+// lists the widths of the characters that are used.
+//
+
+static bool				// O - `true` on success, `false` on failure
+write_subset_font(
+    pdfio_file_t     *pdf,		// I - PDF file
+    _pdfio_subfont_t *subfont,		// I - Font
+    size_t           num_chars,		// I - Number of characters used
+    const int        *chars)		// I - Characters used, sorted
+{
+  pdfio_font_t	*fontdata;		// Font data
+  ttf_t		*font;			// TrueType font
+  const int	*cmap;			// CMap entries
+  size_t	i,			// Looping var
+		num_cmap;		// Number of CMap entries
+  int		ch,			// Current character
+		last_ch,		// Last character in width array
+		max_ch;			// Last character in CIDToGIDMap
+  unsigned char	*data,			// Subset font data
+		buffer[8192],		// Write buffer
+		*bufptr,		// Pointer into buffer
+		*bufend;		// End of buffer
+  size_t	datalen;		// Length of subset font data
+  pdfio_stream_t *st;			// Stream
+  pdfio_array_t	*w_array,		// Width array
+		*temp_array = NULL;	// Width sub-array
+  bool		ret;			// Return value
+
+
+  if ((fontdata = (pdfio_font_t *)_pdfioObjGetExtension(subfont->font_obj)) == NULL)
+    return (false);
+
+  font = fontdata->ttf;
+
+  // Write the font file...
+  if ((data = ttfCopySubset(font, num_chars, chars, &datalen)) == NULL)
+    return (false);
+
+  if ((st = pdfioObjCreateStream(subfont->file_obj, PDFIO_FILTER_FLATE)) == NULL)
+  {
+    free(data);
+    return (false);
+  }
+
+  ret = pdfioStreamWrite(st, data, datalen);
+  free(data);
+
+  if (!pdfioStreamClose(st) || !ret)
+    return (false);
+
+  // Write the CIDToGIDMap for the characters that are used...
+  cmap   = ttfGetCMap(font, &num_cmap);
+  max_ch = num_chars > 0 ? chars[num_chars - 1] : 0;
+
+  if ((size_t)max_ch >= num_cmap)
+    max_ch = num_cmap > 0 ? (int)num_cmap - 1 : 0;
+
+#ifdef DEBUG
+  if ((st = pdfioObjCreateStream(subfont->cid2gid_obj, PDFIO_FILTER_NONE)) == NULL)
+#else
+  if ((st = pdfioObjCreateStream(subfont->cid2gid_obj, PDFIO_FILTER_FLATE)) == NULL)
+#endif // DEBUG
+    return (false);
+
+  for (i = 0, ch = 0, bufptr = buffer, bufend = buffer + sizeof(buffer); ch <= max_ch; ch ++)
+  {
+    if (i < num_chars && chars[i] == ch)
+    {
+      // Map to the specified glyph...
+      i ++;
+
+      if ((size_t)ch < num_cmap && cmap[ch] >= 0)
+      {
+	*bufptr++ = (unsigned char)(cmap[ch] >> 8);
+	*bufptr++ = (unsigned char)(cmap[ch] & 255);
+      }
+      else
+      {
+	*bufptr++ = 0;
+	*bufptr++ = 0;
+      }
+    }
+    else
+    {
+      // Map unused characters to .notdef...
+      *bufptr++ = 0;
+      *bufptr++ = 0;
+    }
+
+    if (bufptr >= bufend)
+    {
+      // Flush buffer...
+      if (!pdfioStreamWrite(st, buffer, (size_t)(bufptr - buffer)))
+      {
+        pdfioStreamClose(st);
+        return (false);
+      }
+
+      bufptr = buffer;
+    }
+  }
+
+  if (bufptr > buffer && !pdfioStreamWrite(st, buffer, (size_t)(bufptr - buffer)))
+  {
+    pdfioStreamClose(st);
+    return (false);
+  }
+
+  if (!pdfioStreamClose(st))
+    return (false);
+
+  // Write the widths of the characters that are used, grouping consecutive
+  // characters as "c [w1 w2 ... wn]"...
+  if ((w_array = pdfioArrayCreate(pdf)) == NULL)
+    return (false);
+
+  for (i = 0, last_ch = -2; i < num_chars; i ++)
+  {
+    if (chars[i] != last_ch + 1)
+    {
+      pdfioArrayAppendNumber(w_array, chars[i]);
+
+      if ((temp_array = pdfioArrayCreate(pdf)) == NULL)
+        return (false);
+
+      pdfioArrayAppendArray(w_array, temp_array);
+    }
+
+    pdfioArrayAppendNumber(temp_array, ttfGetWidth(font, chars[i]));
+    last_ch = chars[i];
+  }
+
+  pdfioDictSetArray(pdfioObjGetDict(subfont->type2_obj), "W", w_array);
+
+  return (pdfioObjClose(subfont->type2_obj));
+}
@@ -26,6 +26,12 @@ typedef enum pdfio_cs_e			// Standard color spaces
   PDFIO_CS_SRGB				// sRGB
 } pdfio_cs_t;
 
+typedef struct _pdfio_font_s pdfio_font_t;
+					// Shared TrueType/OpenType font
+
+typedef bool (*pdfio_image_cb_t)(void *cb_data, size_t y, unsigned char *line, size_t linelen);
+					// Image line callback for pdfioFileCreateImageObjFromCallback
+
 typedef enum pdfio_linecap_e		// Line capping modes
 {
   PDFIO_LINECAP_BUTT,			// Butt ends
@@ -42,6 +48,37 @@ typedef enum pdfio_linejoin_e		// Line joining modes
 
 typedef double pdfio_matrix_t[3][2];	// Transform matrix
 
+typedef struct pdfio_operand_s		// Content stream operand
+{
+  pdfio_valtype_t	type;		// Operand type
+  size_t		length;		// Length of string/binary data or number of array/dictionary operands that follow
+  union
+  {
+    bool		boolean;	// Boolean value
+    const unsigned char	*binary;	// Inline image data
+    const char		*name;		// Name value
+    double		number;		// Number value
+    const char		*string;	// String value (nul-terminated)
+  }			value;		// Value union
+} pdfio_operand_t;
+
+typedef struct pdfio_point_s		// Point for path functions
+{
+  double	x;			// X coordinate
+  double	y;			// Y coordinate
+} pdfio_point_t;
+
+typedef bool (*pdfio_scan_cb_t)(void *cb_data, const char *op, size_t num_operands, const pdfio_operand_t *operands);
+					// Content stream operator callback for pdfioPageScanContent
+
+typedef enum pdfio_textalign_e		// Text alignment for pdfioContentTextShowParagraph
+{
+  PDFIO_TEXTALIGN_LEFT,			// Align lines on the left
+  PDFIO_TEXTALIGN_CENTER,		// Center lines
+  PDFIO_TEXTALIGN_RIGHT,		// Align lines on the right
+  PDFIO_TEXTALIGN_JUSTIFY		// Justify lines to the full width
+} pdfio_textalign_t;
+
 typedef enum pdfio_textrendering_e	// Text rendering modes
 {
   PDFIO_TEXTRENDERING_FILL,		// Fill text
@@ -70,6 +107,7 @@ extern pdfio_array_t	*pdfioArrayCreateColorFromStandard(pdfio_file_t *pdf, size_
 // PDF content drawing functions...
 extern bool		pdfioContentClip(pdfio_stream_t *st, bool even_odd) _PDFIO_PUBLIC;
 extern bool		pdfioContentDrawImage(pdfio_stream_t *st, const char *name, double x, double y, double w, double h) _PDFIO_PUBLIC;
+extern bool		pdfioContentDrawMarkers(pdfio_stream_t *st, const char *name, size_t num_points, const pdfio_point_t *points, pdfio_matrix_t m) _PDFIO_PUBLIC;
 extern bool		pdfioContentFill(pdfio_stream_t *st, bool even_odd) _PDFIO_PUBLIC;
 extern bool		pdfioContentFillAndStroke(pdfio_stream_t *st, bool even_odd) _PDFIO_PUBLIC;
 extern bool		pdfioContentMatrixConcat(pdfio_stream_t *st, pdfio_matrix_t m) _PDFIO_PUBLIC;
@@ -83,7 +121,10 @@ extern bool		pdfioContentPathCurve23(pdfio_stream_t *st, double x2, double y2, d
 extern bool		pdfioContentPathEnd(pdfio_stream_t *st) _PDFIO_PUBLIC;
 extern bool		pdfioContentPathLineTo(pdfio_stream_t *st, double x, double y) _PDFIO_PUBLIC;
 extern bool		pdfioContentPathMoveTo(pdfio_stream_t *st, double x, double y) _PDFIO_PUBLIC;
+extern bool		pdfioContentPathPolygon(pdfio_stream_t *st, size_t num_points, const pdfio_point_t *points, pdfio_matrix_t m) _PDFIO_PUBLIC;
+extern bool		pdfioContentPathPolyline(pdfio_stream_t *st, size_t num_points, const pdfio_point_t *points, pdfio_matrix_t m) _PDFIO_PUBLIC;
 extern bool		pdfioContentPathRect(pdfio_stream_t *st, double x, double y, double width, double height) _PDFIO_PUBLIC;
+extern bool		pdfioContentPathRects(pdfio_stream_t *st, size_t num_rects, const pdfio_rect_t *rects, pdfio_matrix_t m) _PDFIO_PUBLIC;
 extern bool		pdfioContentRestore(pdfio_stream_t *st) _PDFIO_PUBLIC;
 extern bool		pdfioContentSave(pdfio_stream_t *st) _PDFIO_PUBLIC;
 extern bool		pdfioContentSetDashPattern(pdfio_stream_t *st, double phase, double on, double off) _PDFIO_PUBLIC;
@@ -125,13 +166,23 @@ extern bool		pdfioContentTextNextLine(pdfio_stream_t *st) _PDFIO_PUBLIC;
 extern bool		pdfioContentTextShow(pdfio_stream_t *st, bool unicode, const char *s) _PDFIO_PUBLIC;
 extern bool		pdfioContentTextShowf(pdfio_stream_t *st, bool unicode, const char *format, ...) _PDFIO_PUBLIC _PDFIO_FORMAT(3,4);
 extern bool		pdfioContentTextShowJustified(pdfio_stream_t *st, bool unicode, size_t num_fragments, const double *offsets, const char * const *fragments) _PDFIO_PUBLIC;
+extern bool		pdfioContentTextShowParagraph(pdfio_stream_t *st, pdfio_obj_t *font, bool unicode, double size, double width, pdfio_textalign_t align, const char *s, size_t *num_lines) _PDFIO_PUBLIC;
 
 // Resource helpers...
 extern pdfio_obj_t	*pdfioFileCreateFontObjFromBase(pdfio_file_t *pdf, const char *name) _PDFIO_PUBLIC;
 extern pdfio_obj_t	*pdfioFileCreateFontObjFromFile(pdfio_file_t *pdf, const char *filename, bool unicode) _PDFIO_PUBLIC;
+extern pdfio_obj_t	*pdfioFileCreateFontObjFromFont(pdfio_file_t *pdf, pdfio_font_t *font, bool unicode) _PDFIO_PUBLIC;
+extern pdfio_obj_t	*pdfioFileCreateFormObj(pdfio_file_t *pdf, pdfio_rect_t *bbox, pdfio_dict_t *resources) _PDFIO_PUBLIC;
 extern pdfio_obj_t	*pdfioFileCreateICCObjFromFile(pdfio_file_t *pdf, const char *filename, size_t num_colors) _PDFIO_PUBLIC;
+extern pdfio_obj_t	*pdfioFileCreateImageObjFromCallback(pdfio_file_t *pdf, pdfio_image_cb_t cb, void *cb_data, size_t width, size_t height, size_t num_colors, pdfio_array_t *color_data, bool alpha, bool interpolate) _PDFIO_PUBLIC;
 extern pdfio_obj_t	*pdfioFileCreateImageObjFromData(pdfio_file_t *pdf, const unsigned char *data, size_t width, size_t height, size_t num_colors, pdfio_array_t *color_data, bool alpha, bool interpolate) _PDFIO_PUBLIC;
 extern pdfio_obj_t	*pdfioFileCreateImageObjFromFile(pdfio_file_t *pdf, const char *filename, bool interpolate) _PDFIO_PUBLIC;
+extern pdfio_obj_t	*pdfioFileCreateImageObjFromIO(pdfio_file_t *pdf, pdfio_input_cb_t input_cb, void *input_ctx, bool interpolate) _PDFIO_PUBLIC;
+extern pdfio_obj_t	*pdfioFileCreateImageObjFromMemory(pdfio_file_t *pdf, const void *data, size_t datalen, bool interpolate) _PDFIO_PUBLIC;
+
+// Shared font functions...
+extern pdfio_font_t	*pdfioFontCreate(const char *filename, pdfio_error_cb_t error_cb, void *error_data) _PDFIO_PUBLIC;
+extern void		pdfioFontDelete(pdfio_font_t *font) _PDFIO_PUBLIC;
 
 // Image object helpers...
 extern size_t		pdfioImageGetBytesPerLine(pdfio_obj_t *obj) _PDFIO_PUBLIC;
@@ -143,6 +194,9 @@ extern bool		pdfioPageDictAddColorSpace(pdfio_dict_t *dict, const char *name, pd
 extern bool		pdfioPageDictAddFont(pdfio_dict_t *dict, const char *name, pdfio_obj_t *obj) _PDFIO_PUBLIC;
 extern bool		pdfioPageDictAddImage(pdfio_dict_t *dict, const char *name, pdfio_obj_t *obj) _PDFIO_PUBLIC;
 
+// Page content scanning functions...
+extern bool		pdfioPageScanContent(pdfio_obj_t *page, pdfio_scan_cb_t cb, void *cb_data) _PDFIO_PUBLIC;
+
 
 #  ifdef __cplusplus
 }
@@ -79,6 +79,14 @@
 //   TODO: document V6+R6 handler
 //
 
+//
+// Globals...
+//
+
+bool		_pdfio_crypto_accel = true;
+					// Use AES-NI/SHA-NI instructions when available?
+
+
 //
 // Local globals...
 //
@@ -99,6 +107,7 @@ static uint8_t pdf_passpad[32] =	// Padding for passwords
 static void	decrypt_user_key(pdfio_encryption_t encryption, const uint8_t *file_key, uint8_t user_key[32]);
 static void	encrypt_user_key(pdfio_encryption_t encryption, const uint8_t *file_key, uint8_t user_key[32]);
 static void	make_file_key(pdfio_encryption_t encryption, pdfio_permission_t permissions, const unsigned char *file_id, size_t file_idlen, const uint8_t *user_pad, const uint8_t *owner_key, uint8_t file_key[16]);
+static void	make_object_key(pdfio_file_t *pdf, pdfio_obj_t *obj, const uint8_t *file_key, uint8_t obj_key[16]);
 static void	make_owner_key(pdfio_encryption_t encryption, const uint8_t *owner_pad, const uint8_t *user_pad, uint8_t owner_key[32]);
 static void	make_user_key(const unsigned char *file_id, size_t file_idlen, uint8_t user_key[32]);
 static void	pad_password(const char *password, uint8_t pad[32]);
@@ -406,9 +415,7 @@ _pdfioCryptoMakeReader(
      uint8_t             *iv,		// I  - Buffer for initialization vector
      size_t              *ivlen)	// IO - Size of initialization vector
 {
-  uint8_t	data[21];		// Key data
-  _pdfio_md5_t	md5;			// MD5 state
-  uint8_t	digest[16];		// MD5 digest value
+  uint8_t	digest[16];		// Object key
 #if PDFIO_OBJ_CRYPT
   pdfio_array_t	*id_array;		// Object ID array
   unsigned char	*id_value;		// Object ID value
@@ -487,20 +494,8 @@ _pdfioCryptoMakeReader(
         return (NULL);
 
     case PDFIO_ENCRYPTION_RC4_40 :
-	// Copy the key data for the MD5 hash.
-	memcpy(data, file_key, 16);
-	data[16] = (uint8_t)obj->number;
-	data[17] = (uint8_t)(obj->number >> 8);
-	data[18] = (uint8_t)(obj->number >> 16);
-	data[19] = (uint8_t)obj->generation;
-	data[20] = (uint8_t)(obj->generation >> 8);
-
-        // Hash it...
-        _pdfioCryptoMD5Init(&md5);
-	_pdfioCryptoMD5Append(&md5, data, sizeof(data));
-	_pdfioCryptoMD5Finish(&md5, digest);
-
-        // Initialize the RC4 context using 40 bits of the digest...
+        // Initialize the RC4 context using 40 bits of the object key...
+        make_object_key(pdf, obj, file_key, digest);
 	_pdfioCryptoRC4Init(&ctx->rc4, digest, 5);
 	*ivlen = 0;
 	return ((_pdfio_crypto_cb_t)_pdfioCryptoRC4Crypt);
@@ -514,22 +509,9 @@ _pdfioCryptoMakeReader(
         }
 
     case PDFIO_ENCRYPTION_RC4_128 :
-	// Copy the key data for the MD5 hash.
-	memcpy(data, file_key, 16);
-	data[16] = (uint8_t)obj->number;
-	data[17] = (uint8_t)(obj->number >> 8);
-	data[18] = (uint8_t)(obj->number >> 16);
-	data[19] = (uint8_t)obj->generation;
-	data[20] = (uint8_t)(obj->generation >> 8);
-
-        // Hash it...
-        _pdfioCryptoMD5Init(&md5);
-	_pdfioCryptoMD5Append(&md5, data, sizeof(data));
-	if (pdf->encryption == PDFIO_ENCRYPTION_AES_128)
-	  _pdfioCryptoMD5Append(&md5, (const uint8_t *)"sAlT", 4);
-	_pdfioCryptoMD5Finish(&md5, digest);
-
-        // Initialize the RC4/AES context using the digest...
+        // Initialize the RC4/AES context using the object key...
+        make_object_key(pdf, obj, file_key, digest);
+
         if (pdf->encryption == PDFIO_ENCRYPTION_RC4_128)
         {
 	  *ivlen = 0;
@@ -558,9 +540,7 @@ _pdfioCryptoMakeWriter(
      uint8_t             *iv,		// I  - Buffer for initialization vector
      size_t              *ivlen)	// IO - Size of initialization vector
 {
-  uint8_t	data[21];		/* Key data */
-  _pdfio_md5_t	md5;			/* MD5 state */
-  uint8_t	digest[16];		/* MD5 digest value */
+  uint8_t	digest[16];		// Object key
 
 
   PDFIO_DEBUG("_pdfioCryptoMakeWriter(pdf=%p, obj=%p(%d), ctx=%p, iv=%p, ivlen=%p(%d))\n", pdf, obj, (int)obj->number, ctx, iv, ivlen, (int)*ivlen);
@@ -580,22 +560,9 @@ _pdfioCryptoMakeWriter(
 
     case PDFIO_ENCRYPTION_RC4_128 :
     case PDFIO_ENCRYPTION_AES_128 :
-	// Copy the key data for the MD5 hash.
-	memcpy(data, pdf->file_key, sizeof(pdf->file_key));
-	data[16] = (uint8_t)obj->number;
-	data[17] = (uint8_t)(obj->number >> 8);
-	data[18] = (uint8_t)(obj->number >> 16);
-	data[19] = (uint8_t)obj->generation;
-	data[20] = (uint8_t)(obj->generation >> 8);
-
-        // Hash it...
-        _pdfioCryptoMD5Init(&md5);
-	_pdfioCryptoMD5Append(&md5, data, sizeof(data));
-	if (pdf->encryption == PDFIO_ENCRYPTION_AES_128)
-	  _pdfioCryptoMD5Append(&md5, (const uint8_t *)"sAlT", 4);
-	_pdfioCryptoMD5Finish(&md5, digest);
-
-        // Initialize the RC4/AES context using the digest...
+        make_object_key(pdf, obj, pdf->file_key, digest);
+
+        // Initialize the RC4/AES context using the object key...
         if (pdf->encryption == PDFIO_ENCRYPTION_RC4_128)
         {
 	  *ivlen = 0;
@@ -613,6 +580,26 @@ _pdfioCryptoMakeWriter(
 }
 
 
+//
+// '_pdfioCryptoSetAccel()' - Enable or disable the AES-NI/SHA-NI code paths.
+//
+// This is used by the unit tests to run the portable AES and SHA-256 code on
+// CPUs that support the accelerated instructions.  The previous setting is
+// returned.
+//
+
+bool					// O - Previous setting
+_pdfioCryptoSetAccel(bool accel)	// I - `true` to use AES-NI/SHA-NI when available, `false` to use the portable code
+{
+  bool	prev = _pdfio_crypto_accel;	// Previous setting
+
+
+  _pdfio_crypto_accel = accel;
+
+  return (prev);
+}
+
+
 //
 // '_pdfioCryptoUnlock()' - Unlock an encrypted PDF.
 //
@@ -1006,6 +993,64 @@ make_file_key(
 }
 
 
+//
+// 'make_object_key()' - Make the RC4/AES encryption key for an object.
+//
+// The key only depends on the file key and the object number and generation,
+// so the key for the default file key is cached in the object and reused for
+// every string and stream in the object.
+//
+
+static void
+make_object_key(
+    pdfio_file_t  *pdf,			// I - PDF file
+    pdfio_obj_t   *obj,			// I - Object
+    const uint8_t *file_key,		// I - File key
+    uint8_t       obj_key[16])		// O - Object key
+{
+  bool		cache = file_key == pdf->file_key;
+					// Cache the object key?
+  uint8_t	data[21];		// Key data
+  _pdfio_md5_t	md5;			// MD5 state
+
+
+  if (cache)
+  {
+    _pdfioFileLock(pdf);
+
+    if (obj->have_key)
+    {
+      memcpy(obj_key, obj->key, sizeof(obj->key));
+      _pdfioFileUnlock(pdf);
+      return;
+    }
+  }
+
+  // Copy the key data for the MD5 hash.
+  memcpy(data, file_key, 16);
+  data[16] = (uint8_t)obj->number;
+  data[17] = (uint8_t)(obj->number >> 8);
+  data[18] = (uint8_t)(obj->number >> 16);
+  data[19] = (uint8_t)obj->generation;
+  data[20] = (uint8_t)(obj->generation >> 8);
+
+  // Hash it...
+  _pdfioCryptoMD5Init(&md5);
+  _pdfioCryptoMD5Append(&md5, data, sizeof(data));
+  if (pdf->encryption == PDFIO_ENCRYPTION_AES_128)
+    _pdfioCryptoMD5Append(&md5, (const uint8_t *)"sAlT", 4);
+  _pdfioCryptoMD5Finish(&md5, obj_key);
+
+  if (cache)
+  {
+    memcpy(obj->key, obj_key, sizeof(obj->key));
+    obj->have_key = true;
+
+    _pdfioFileUnlock(pdf);
+  }
+}
+
+
 //
 // 'make_owner_key()' - Generate the (encrypted) owner key...
 //
@@ -14,7 +14,8 @@
 // Local functions...
 //
 
-static int	compare_pairs(_pdfio_pair_t *a, _pdfio_pair_t *b);
+static _pdfio_pair_t	*find_pair(pdfio_dict_t *dict, const char *key);
+static void		hash_pair(pdfio_dict_t *dict, size_t n);
 
 
 //
@@ -26,8 +27,7 @@ pdfioDictClear(pdfio_dict_t *dict,	// I - Dictionary
                const char   *key)	// I - Key
 {
   size_t	idx;			// Index into pairs
-  _pdfio_pair_t	*pair,			// Current pair
-		pkey;			// Search key
+  _pdfio_pair_t	*pair;			// Current pair
 
 
   PDFIO_DEBUG("pdfioDictClear(dict=%p, key=\"%s\")\n", dict, key);
@@ -36,24 +36,21 @@ pdfioDictClear(pdfio_dict_t *dict,	// I - Dictionary
     return (false);
 
   // See if the key is already set...
-  if (dict->num_pairs > 0)
+  if ((pair = find_pair(dict, key)) != NULL)
   {
-    pkey.key = key;
+    // Yes, remove it and discard the hash index since pairs have moved...
+    idx = (size_t)(pair - dict->pairs);
+    dict->num_pairs --;
 
-    if ((pair = (_pdfio_pair_t *)bsearch(&pkey, dict->pairs, dict->num_pairs, sizeof(_pdfio_pair_t), (int (*)(const void *, const void *))compare_pairs)) != NULL)
-    {
-      // Yes, remove it...
-      if (pair->value.type == PDFIO_VALTYPE_BINARY)
-        free(pair->value.value.binary.data);
+    if (idx < dict->num_pairs)
+      memmove(pair, pair + 1, (dict->num_pairs - idx) * sizeof(_pdfio_pair_t));
 
-      idx = (size_t)(pair - dict->pairs);
-      dict->num_pairs --;
+    _pdfioFileFree(dict->pdf, dict->hash);
 
-      if (idx < dict->num_pairs)
-        memmove(pair, pair + 1, (dict->num_pairs - idx) * sizeof(_pdfio_pair_t));
+    dict->hash       = NULL;
+    dict->alloc_hash = 0;
 
-      return (true);
-    }
+    return (true);
   }
 
   return (false);
@@ -82,7 +79,7 @@ pdfioDictCopy(pdfio_file_t *pdf,	// I - PDF file
     return (NULL);
 
   // Pre-allocate the pairs array to make this a little faster...
-  if ((ndict->pairs = (_pdfio_pair_t *)malloc(dict->num_pairs * sizeof(_pdfio_pair_t))) == NULL)
+  if ((ndict->pairs = (_pdfio_pair_t *)_pdfioFileAlloc(pdf, dict->num_pairs * sizeof(_pdfio_pair_t))) == NULL)
     return (NULL);			// Let pdfioFileClose do the cleanup...
 
   ndict->alloc_pairs = dict->num_pairs;
@@ -99,8 +96,7 @@ pdfioDictCopy(pdfio_file_t *pdf,	// I - PDF file
       v.type = PDFIO_VALTYPE_NUMBER;
       if (lenobj)
       {
-        if (lenobj->value.type == PDFIO_VALTYPE_NONE)
-          _pdfioObjLoad(lenobj);
+        _pdfioObjLoad(lenobj);
 
 	v.value.number = lenobj->value.value.number;
       }
@@ -140,27 +136,11 @@ pdfioDictCreate(pdfio_file_t *pdf)	// I - PDF file
   if (!pdf)
     return (NULL);
 
-  if ((dict = (pdfio_dict_t *)calloc(1, sizeof(pdfio_dict_t))) == NULL)
+  if ((dict = (pdfio_dict_t *)_pdfioFileAlloc(pdf, sizeof(pdfio_dict_t))) == NULL)
     return (NULL);
 
   dict->pdf = pdf;
 
-  if (pdf->num_dicts >= pdf->alloc_dicts)
-  {
-    pdfio_dict_t **temp = (pdfio_dict_t **)realloc(pdf->dicts, (pdf->alloc_dicts + 16) * sizeof(pdfio_dict_t *));
-
-    if (!temp)
-    {
-      free(dict);
-      return (NULL);
-    }
-
-    pdf->dicts       = temp;
-    pdf->alloc_dicts += 16;
-  }
-
-  pdf->dicts[pdf->num_dicts ++] = dict;
-
   return (dict);
 }
 
@@ -212,31 +192,6 @@ _pdfioDictDebug(pdfio_dict_t *dict,	// I - Dictionary
 }
 
 
-//
-// '_pdfioDictDelete()' - Free the memory used by a dictionary.
-//
-
-void
-_pdfioDictDelete(pdfio_dict_t *dict)	// I - Dictionary
-{
-  if (dict)
-  {
-    size_t	i;			// Looping var
-    _pdfio_pair_t *pair;		// Current pair
-
-    for (i = dict->num_pairs, pair = dict->pairs; i > 0; i --, pair ++)
-    {
-      if (pair->value.type == PDFIO_VALTYPE_BINARY)
-        free(pair->value.value.binary.data);
-    }
-
-    free(dict->pairs);
-  }
-
-  free(dict);
-}
-
-
 //
 // 'pdfioDictGetArray()' - Get a key array value from a dictionary.
 //
@@ -594,7 +549,6 @@ pdfioDictGetString(pdfio_dict_t *dict,	// I - Dictionary
       temp[value->value.binary.datalen] = '\0';
     }
 
-    free(value->value.binary.data);
     value->type         = PDFIO_VALTYPE_STRING;
     value->value.string = pdfioStringCreate(dict->pdf, temp);
 
@@ -630,8 +584,7 @@ _pdfio_value_t *			// O - Value or `NULL` on error
 _pdfioDictGetValue(pdfio_dict_t *dict,	// I - Dictionary
                    const char   *key)	// I - Key
 {
-  _pdfio_pair_t	temp,			// Search key
-		*match;			// Matching key pair
+  _pdfio_pair_t	*match;			// Matching key pair
 
 
   PDFIO_DEBUG("_pdfioDictGetValue(dict=%p, key=\"%s\")\n", dict, key);
@@ -642,9 +595,7 @@ _pdfioDictGetValue(pdfio_dict_t *dict,	// I - Dictionary
     return (NULL);
   }
 
-  temp.key = key;
-
-  if ((match = bsearch(&temp, dict->pairs, dict->num_pairs, sizeof(_pdfio_pair_t), (int (*)(const void *, const void *))compare_pairs)) != NULL)
+  if ((match = find_pair(dict, key)) != NULL)
   {
     PDFIO_DEBUG("_pdfioDictGetValue: Match, returning ");
     PDFIO_DEBUG_VALUE(&(match->value));
@@ -811,18 +762,12 @@ pdfioDictSetBinary(
   temp.type                 = PDFIO_VALTYPE_BINARY;
   temp.value.binary.datalen = valuelen;
 
-  if ((temp.value.binary.data = (unsigned char *)malloc(valuelen)) == NULL)
+  if ((temp.value.binary.data = (unsigned char *)_pdfioFileAlloc(dict->pdf, valuelen)) == NULL)
     return (false);
 
   memcpy(temp.value.binary.data, value, valuelen);
 
-  if (!_pdfioDictSetValue(dict, key, &temp))
-  {
-    free(temp.value.binary.data);
-    return (false);
-  }
-
-  return (true);
+  return (_pdfioDictSetValue(dict, key, &temp));
 }
 
 
@@ -1070,13 +1015,17 @@ pdfioDictSetStringf(
   vsnprintf(buffer, sizeof(buffer), format, ap);
   va_end(ap);
 
-  return (pdfioDictSetString(dict, key, buffer));
+  return (pdfioDictSetString(dict, key, pdfioStringCreate(dict->pdf, buffer)));
 }
 
 
 //
 // '_pdfioDictSetValue()' - Set a key value in a dictionary.
 //
+// All of the `pdfioDictSet` functions use this function.  The pairs and hash
+// index are updated without the file lock, so changing a dictionary while
+// other threads read it concurrently is not supported.
+//
 
 bool					// O - `true` on success, `false` on failure
 _pdfioDictSetValue(
@@ -1090,28 +1039,22 @@ _pdfioDictSetValue(
   PDFIO_DEBUG("_pdfioDictSetValue(dict=%p, key=\"%s\", value=%p)\n", dict, key, (void *)value);
 
   // See if the key is already set...
-  if (dict->num_pairs > 0)
+  if ((pair = find_pair(dict, key)) != NULL)
   {
-    _pdfio_pair_t	pkey;		// Search key
-
-    pkey.key = key;
-
-    if ((pair = (_pdfio_pair_t *)bsearch(&pkey, dict->pairs, dict->num_pairs, sizeof(_pdfio_pair_t), (int (*)(const void *, const void *))compare_pairs)) != NULL)
-    {
-      // Yes, replace the value...
-      PDFIO_DEBUG("_pdfioDictSetValue: Replacing existing value.\n");
-      if (pair->value.type == PDFIO_VALTYPE_BINARY)
-        free(pair->value.value.binary.data);
-      pair->value = *value;
-      return (true);
-    }
+    // Yes, replace the value...
+    PDFIO_DEBUG("_pdfioDictSetValue: Replacing existing value.\n");
+    pair->value = *value;
+    return (true);
   }
 
   // Nope, add a pair...
   if (dict->num_pairs >= dict->alloc_pairs)
   {
     // Expand the dictionary...
-    _pdfio_pair_t *temp = (_pdfio_pair_t *)realloc(dict->pairs, (dict->alloc_pairs + 8) * sizeof(_pdfio_pair_t));
+    size_t	alloc_pairs = dict->alloc_pairs ? 2 * dict->alloc_pairs : 8;
+					// New number of pairs
+    _pdfio_pair_t *temp = (_pdfio_pair_t *)_pdfioFileAlloc(dict->pdf, alloc_pairs * sizeof(_pdfio_pair_t));
+					// New pairs array
 
     if (!temp)
     {
@@ -1119,8 +1062,13 @@ _pdfioDictSetValue(
       return (false);
     }
 
+    if (dict->num_pairs > 0)
+      memcpy(temp, dict->pairs, dict->num_pairs * sizeof(_pdfio_pair_t));
+
+    _pdfioFileFree(dict->pdf, dict->pairs);
+
     dict->pairs       = temp;
-    dict->alloc_pairs += 8;
+    dict->alloc_pairs = alloc_pairs;
   }
 
   pair = dict->pairs + dict->num_pairs;
@@ -1129,9 +1077,22 @@ _pdfioDictSetValue(
   pair->key   = key;
   pair->value = *value;
 
-  // Re-sort the dictionary and return...
-  if (dict->num_pairs > 1 && compare_pairs(pair - 1, pair) > 0)
-    qsort(dict->pairs, dict->num_pairs, sizeof(_pdfio_pair_t), (int (*)(const void *, const void *))compare_pairs);
+  // Update the hash index, if any...
+  if (dict->hash)
+  {
+    if ((2 * dict->num_pairs) > dict->alloc_hash)
+    {
+      // Rebuild the index the next time it is needed...
+      _pdfioFileFree(dict->pdf, dict->hash);
+
+      dict->hash       = NULL;
+      dict->alloc_hash = 0;
+    }
+    else
+    {
+      hash_pair(dict, dict->num_pairs - 1);
+    }
+  }
 
 #ifdef DEBUG
   PDFIO_DEBUG("_pdfioDictSetValue(%p): %lu pairs\n", (void *)dict, (unsigned long)dict->num_pairs);
@@ -1188,12 +1149,108 @@ _pdfioDictWrite(pdfio_dict_t *dict,	// I - Dictionary
 
 
 //
-// 'compare_pairs()' - Compare the keys for two pairs.
+// 'find_pair()' - Find a key in a dictionary.
+//
+// Small dictionaries are searched linearly, first comparing the key pointers
+// (keys are typically durable strings or well-known keys) and then the key
+// strings.  Larger dictionaries use a hash index that is created as needed.
 //
 
-static int				// O - Result of comparison
-compare_pairs(_pdfio_pair_t *a,		// I - First pair
-              _pdfio_pair_t *b)		// I - Second pair
+static _pdfio_pair_t *			// O - Matching pair or `NULL` if not found
+find_pair(pdfio_dict_t *dict,		// I - Dictionary
+          const char   *key)		// I - Key
 {
-  return (strcmp(a->key, b->key));
+  size_t	i,			// Looping var
+		mask,			// Hash index mask
+		current;		// Current hash index entry
+  _pdfio_pair_t	*pair;			// Current pair
+
+
+  if (dict->num_pairs >= _PDFIO_DICT_HASH)
+  {
+    // Create and search the hash index while holding the file lock, since
+    // other threads may be searching the same dictionary...
+    _pdfioFileLock(dict->pdf);
+
+    if (!dict->hash)
+    {
+      size_t	alloc_hash = 64;	// Number of hash index entries
+      size_t	*hash;			// Hash index
+
+      while (alloc_hash < (4 * dict->num_pairs))
+	alloc_hash *= 2;
+
+      if ((hash = (size_t *)_pdfioFileAlloc(dict->pdf, alloc_hash * sizeof(size_t))) != NULL)
+      {
+	mask = alloc_hash - 1;
+
+	for (i = 0; i < dict->num_pairs; i ++)
+	{
+	  for (current = _pdfioStringHash(dict->pairs[i].key) & mask; hash[current]; current = (current + 1) & mask);
+
+	  hash[current] = i + 1;
+	}
+
+	dict->alloc_hash = alloc_hash;
+	dict->hash       = hash;
+      }
+    }
+
+    if (dict->hash)
+    {
+      // Search the hash index...
+      mask = dict->alloc_hash - 1;
+
+      for (current = _pdfioStringHash(key) & mask; dict->hash[current]; current = (current + 1) & mask)
+      {
+        pair = dict->pairs + dict->hash[current] - 1;
+
+        if (pair->key == key || !strcmp(pair->key, key))
+          break;
+      }
+
+      if (!dict->hash[current])
+        pair = NULL;
+
+      _pdfioFileUnlock(dict->pdf);
+
+      return (pair);
+    }
+
+    _pdfioFileUnlock(dict->pdf);
+  }
+
+  // Search linearly...
+  for (i = dict->num_pairs, pair = dict->pairs; i > 0; i --, pair ++)
+  {
+    if (pair->key == key)
+      return (pair);
+  }
+
+  for (i = dict->num_pairs, pair = dict->pairs; i > 0; i --, pair ++)
+  {
+    if (!strcmp(pair->key, key))
+      return (pair);
+  }
+
+  return (NULL);
+}
+
+
+//
+// 'hash_pair()' - Add a pair to the hash index.
+//
+
+static void
+hash_pair(pdfio_dict_t *dict,		// I - Dictionary
+          size_t       n)		// I - Pair index
+{
+  size_t	mask = dict->alloc_hash - 1,
+					// Hash index mask
+		current;		// Current hash index entry
+
+
+  for (current = _pdfioStringHash(dict->pairs[n].key) & mask; dict->hash[current]; current = (current + 1) & mask);
+
+  dict->hash[current] = n + 1;
 }
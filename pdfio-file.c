@@ -8,30 +8,206 @@
 //
 
 #include "pdfio-private.h"
+#ifndef _WIN32
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#endif // !_WIN32
 #ifndef O_BINARY
 #  define O_BINARY 0
 #endif // !O_BINARY
 
 
+//
+// Local types...
+//
+
+typedef struct _pdfio_objbuf_s		// Decoded object stream data
+{
+  const unsigned char *bufptr,		// Pointer into data
+		*bufend;		// End of data
+} _pdfio_objbuf_t;
+
+typedef struct _pdfio_objjob_s		// Object stream decoding job
+{
+  pdfio_obj_t	*obj;			// Object stream
+  unsigned char	*data;			// Decoded stream data
+  size_t	datalen;		// Length of decoded stream data
+} _pdfio_objjob_t;
+
+typedef struct _pdfio_objpool_s		// Object stream decoding threads
+{
+  _pdfio_mutex_t mutex;			// Mutex for next job
+  size_t	num_jobs,		// Number of jobs
+		next_job;		// Next job to decode
+  _pdfio_objjob_t *jobs;		// Jobs
+} _pdfio_objpool_t;
+
+
 //
 // Local functions...
 //
 
 static pdfio_obj_t	*add_obj(pdfio_file_t *pdf, size_t number, unsigned short generation, off_t offset);
+static bool		add_objstm_idx(pdfio_file_t *pdf, size_t number, size_t first, size_t count, size_t *entries);
+static void		add_hint_bits(unsigned char *data, size_t *bit, size_t value, size_t nbits);
+static bool		add_page_kid(pdfio_file_t *pdf, _pdfio_pnode_t *node, pdfio_obj_t *kid, size_t count);
+static bool		begin_linearized(pdfio_file_t *pdf);
+static int		compare_numbers(size_t *a, size_t *b);
 static int		compare_objmaps(_pdfio_objmap_t *a, _pdfio_objmap_t *b);
+static int		compare_objs(pdfio_obj_t **a, pdfio_obj_t **b);
+static int		compare_objstms(_pdfio_objstm_t *a, _pdfio_objstm_t *b);
+static bool		close_page_node(pdfio_file_t *pdf, size_t level);
+static bool		copy_linearized(pdfio_file_t *pdf, off_t offset, size_t length);
 static pdfio_file_t	*create_common(const char *filename, int fd, pdfio_output_cb_t output_cb, void *output_cbdata, const char *version, pdfio_rect_t *media_box, pdfio_rect_t *crop_box, pdfio_error_cb_t error_cb, void *error_cbdata);
+static int		create_temp_file(char *buffer, size_t bufsize, const char *ext);
+static pdfio_obj_t	*find_loaded_obj(pdfio_file_t *pdf, size_t number);
+static pdfio_obj_t	*find_sparse_obj(pdfio_file_t *pdf, size_t number);
+static _pdfio_xref_t	*find_xref(pdfio_file_t *pdf, size_t number);
+static bool		flush_obj_stream(pdfio_file_t *pdf);
+static void		free_blocks(_pdfio_block_t *block);
 static const char	*get_info_string(pdfio_file_t *pdf, const char *key);
-static struct lconv	*get_lconv(void);
-static bool		load_obj_stream(pdfio_obj_t *obj);
+static pdfio_obj_t	*get_page_node(pdfio_file_t *pdf, size_t level);
+static size_t		hint_bits(size_t value);
+static bool		is_update_obj(pdfio_file_t *pdf, pdfio_obj_t *obj);
+static bool		load_obj_stream(pdfio_file_t *pdf, pdfio_obj_t *obj, _pdfio_token_t *tb);
+static pdfio_obj_t	*load_page(pdfio_file_t *pdf, size_t n);
 static bool		load_pages(pdfio_file_t *pdf, pdfio_obj_t *obj, size_t depth);
+static size_t		next_free_obj(pdfio_file_t *pdf, size_t i, pdfio_obj_t *xref_obj);
 static bool		load_xref(pdfio_file_t *pdf, off_t xref_offset, pdfio_password_cb_t password_cb, void *password_data);
+static ssize_t		objstm_consume(_pdfio_objbuf_t *ob, size_t bytes);
+static ssize_t		objstm_peek(_pdfio_objbuf_t *ob, void *buffer, size_t bytes);
+#ifdef _WIN32
+static DWORD WINAPI	objstm_worker(_pdfio_objpool_t *pool);
+#else
+static void		*objstm_worker(_pdfio_objpool_t *pool);
+#endif // _WIN32
+static pdfio_file_t	*open_common(const char *filename, int fd, const char *memdata, size_t memsize, bool memmapped, pdfio_input_cb_t input_cb, void *input_ctx, off_t input_size, pdfio_password_cb_t password_cb, void *password_cbdata, pdfio_error_cb_t error_cb, void *error_cbdata);
+static void		scan_linearized(pdfio_file_t *pdf, _pdfio_value_t *v, size_t page, size_t *work, size_t *num_work);
+static void		sort_sparse_objs(pdfio_file_t *pdf);
+static bool		write_linearized(pdfio_file_t *pdf);
+static bool		write_page_node(pdfio_file_t *pdf, _pdfio_pnode_t *node, pdfio_obj_t *parent);
 static bool		write_pages(pdfio_file_t *pdf);
 static bool		write_trailer(pdfio_file_t *pdf);
+static bool		write_xref_stream(pdfio_file_t *pdf, off_t xref_offset);
+
+
+//
+// '_pdfioFileAddCompressedObj()' - Add an object to the current object stream.
+//
+// The object's value is written to the spool buffer and the object stream is
+// written to the PDF file once it is full or the PDF file is closed.
+//
+
+bool					// O - `true` on success, `false` on failure
+_pdfioFileAddCompressedObj(
+    pdfio_file_t *pdf,			// I - PDF file
+    pdfio_obj_t  *obj)			// I - Object
+{
+  bool	ret;				// Return value
+
+
+  // Create a new object stream as needed...
+  if (!pdf->objstm_obj)
+  {
+    _pdfio_value_t	value;		// Object stream value
+
+    value.type = PDFIO_VALTYPE_DICT;
+
+    if ((value.value.dict = pdfioDictCreate(pdf)) == NULL)
+    {
+      _pdfioFileError(pdf, "Unable to create object stream dictionary.");
+      return (false);
+    }
+
+    pdfioDictSetName(value.value.dict, "Type", "ObjStm");
+
+    if ((pdf->objstm_obj = _pdfioFileCreateObj(pdf, pdf, &value)) == NULL)
+      return (false);
+  }
+
+  // Write the object's value to the spool buffer...  Strings are not encrypted
+  // since the object stream itself is encrypted.
+  if (!_pdfioFileBeginSpool(pdf))
+    return (false);
+
+  pdf->objstm_numbers[pdf->num_objstm] = obj->number;
+  pdf->objstm_offsets[pdf->num_objstm] = (size_t)_pdfioFileTell(pdf);
+
+  ret = _pdfioValueWrite(pdf, NULL, &obj->value, NULL) && _pdfioFilePuts(pdf, "\n");
+
+  if (!_pdfioFileEndSpool(pdf) || !ret)
+    return (false);
+
+  // The offset of a compressed object is its index in the object stream...
+  obj->objstm = pdf->objstm_obj->number;
+  obj->offset = (off_t)pdf->num_objstm ++;
+
+  if (pdf->num_objstm >= _PDFIO_OBJSTM_MAX)
+    return (flush_obj_stream(pdf));
+  else
+    return (true);
+}
+
+
+//
+// '_pdfioFileAddHashedObj()' - Add a copied stream object's content hash.
+//
+
+bool					// O - `true` on success, `false` on failure
+_pdfioFileAddHashedObj(
+    pdfio_file_t  *pdf,			// I - Destination PDF file
+    pdfio_obj_t   *obj,			// I - Destination object
+    const uint8_t *digest)		// I - SHA-256 digest
+{
+  size_t		left,		// Left side of search
+			right,		// Right side of search
+			current;	// Current element
+  _pdfio_objhash_t	*hash;		// Object hash
+
+
+  // Allocate memory as needed...
+  if (pdf->num_objhashes >= pdf->alloc_objhashes)
+  {
+    if ((hash = realloc(pdf->objhashes, (pdf->alloc_objhashes + 32) * sizeof(_pdfio_objhash_t))) == NULL)
+    {
+      _pdfioFileError(pdf, "Unable to allocate memory for object hash.");
+      return (false);
+    }
+
+    pdf->alloc_objhashes += 32;
+    pdf->objhashes       = hash;
+  }
+
+  // Insert the hash in sorted order...
+  for (left = 0, right = pdf->num_objhashes; left < right;)
+  {
+    current = (left + right) / 2;
+
+    if (memcmp(pdf->objhashes[current].digest, digest, sizeof(hash->digest)) < 0)
+      left = current + 1;
+    else
+      right = current;
+  }
+
+  hash = pdf->objhashes + left;
+
+  if (left < pdf->num_objhashes)
+    memmove(hash + 1, hash, (pdf->num_objhashes - left) * sizeof(_pdfio_objhash_t));
+
+  pdf->num_objhashes ++;
+
+  memcpy(hash->digest, digest, sizeof(hash->digest));
+  hash->obj = obj;
+
+  return (true);
+}
 
 
 //
 // '_pdfioFileAddMappedObj()' - Add a mapped object.
 //
+// If the source object is already mapped, the existing mapping is updated.
+//
 
 bool					// O - `true` on success, `false` on failure
 _pdfioFileAddMappedObj(
@@ -39,8 +215,22 @@ _pdfioFileAddMappedObj(
     pdfio_obj_t  *dst_obj,		// I - Destination object
     pdfio_obj_t  *src_obj)		// I - Source object
 {
-  _pdfio_objmap_t	*map;		// Object map
+  _pdfio_objmap_t	*map,		// Object map
+			key;		// Search key
+
 
+  // Update an existing mapping as needed...
+  if (pdf->num_objmaps > 0)
+  {
+    key.src_pdf    = src_obj->pdf;
+    key.src_number = src_obj->number;
+
+    if ((map = (_pdfio_objmap_t *)bsearch(&key, pdf->objmaps, pdf->num_objmaps, sizeof(_pdfio_objmap_t), (int (*)(const void *, const void *))compare_objmaps)) != NULL)
+    {
+      map->obj = dst_obj;
+      return (true);
+    }
+  }
 
   // Allocate memory as needed...
   if (pdf->num_objmaps >= pdf->alloc_objmaps)
@@ -79,6 +269,15 @@ bool					// O - `true` on success and `false` on failure
 _pdfioFileAddPage(pdfio_file_t *pdf,	// I - PDF file
                   pdfio_obj_t  *obj)	// I - Page object
 {
+  // Streaming output only adds the page to the current leaf node of the page
+  // tree since page objects are freed once their node has been written...
+  if (pdf->num_page_levels > 0 && (pdf->options & PDFIO_OPTION_STREAMING))
+  {
+    pdf->num_pages ++;
+
+    return (add_page_kid(pdf, pdf->page_levels, obj, 1));
+  }
+
   // Add the page to the array of pages...
   if (pdf->num_pages >= pdf->alloc_pages)
   {
@@ -96,10 +295,125 @@ _pdfioFileAddPage(pdfio_file_t *pdf,	// I - PDF file
 
   pdf->pages[pdf->num_pages ++] = obj;
 
+  // Add the page to the current leaf node of the page tree, if any...
+  if (pdf->num_page_levels > 0)
+    return (add_page_kid(pdf, pdf->page_levels, obj, 1));
+
   return (true);
 }
 
 
+//
+// '_pdfioFileAlloc()' - Allocate memory for a PDF file.
+//
+// This function allocates zeroed memory for arrays, dictionaries, and values
+// from a list of memory blocks that are freed when the PDF file is closed or
+// once all of their allocations have been released with @link _pdfioFileFree@.
+// Allocations are aligned to the size of a `double`.
+//
+
+void *					// O - Memory or `NULL` on error
+_pdfioFileAlloc(pdfio_file_t *pdf,	// I - PDF file
+                size_t       bytes)	// I - Number of bytes
+{
+  _pdfio_block_t	*block;		// Current block
+  size_t		pad;		// Alignment padding
+  void			*ptr;		// Allocated memory
+
+
+  _pdfioFileLock(pdf);
+
+  // Find the padding needed to align the next allocation...
+  if ((block = pdf->blocks) != NULL)
+    pad = (sizeof(double) - (size_t)((uintptr_t)(block->buffer + block->used) & (sizeof(double) - 1))) & (sizeof(double) - 1);
+  else
+    pad = 0;
+
+  if (!block || (block->size - block->used) < (bytes + pad))
+  {
+    // Allocate a new block, using a separate block for large allocations...
+    size_t	size = bytes > (_PDFIO_BLOCK_SIZE / 4) ? bytes + sizeof(double) : _PDFIO_BLOCK_SIZE;
+					// Size of block
+
+    if ((block = (_pdfio_block_t *)malloc(sizeof(_pdfio_block_t) + size)) == NULL)
+    {
+      _pdfioFileUnlock(pdf);
+      return (NULL);
+    }
+
+    block->size = size;
+    block->used = 0;
+    block->live = 0;
+
+    if ((pdf->stats.alloc_bytes += sizeof(_pdfio_block_t) + size) > pdf->stats.peak_alloc_bytes)
+      pdf->stats.peak_alloc_bytes = pdf->stats.alloc_bytes;
+    pad         = (sizeof(double) - (size_t)((uintptr_t)block->buffer & (sizeof(double) - 1))) & (sizeof(double) - 1);
+
+    // Add the block to the index used by _pdfioFileFree...
+    if (pdf->num_bindex >= pdf->alloc_bindex)
+    {
+      size_t		alloc_bindex = pdf->alloc_bindex ? 2 * pdf->alloc_bindex : 64;
+					// New number of index entries
+      _pdfio_block_t	**temp = (_pdfio_block_t **)realloc(pdf->bindex, alloc_bindex * sizeof(_pdfio_block_t *));
+					// New index
+
+      if (temp)
+      {
+        pdf->bindex       = temp;
+        pdf->alloc_bindex = alloc_bindex;
+      }
+    }
+
+    if (pdf->num_bindex < pdf->alloc_bindex)
+    {
+      size_t	left,			// Left side of search
+		right,			// Right side of search
+		current;		// Current element
+
+      for (left = 0, right = pdf->num_bindex; left < right;)
+      {
+        current = (left + right) / 2;
+
+        if ((uintptr_t)pdf->bindex[current] < (uintptr_t)block)
+          left = current + 1;
+        else
+          right = current;
+      }
+
+      if (left < pdf->num_bindex)
+        memmove(pdf->bindex + left + 1, pdf->bindex + left, (pdf->num_bindex - left) * sizeof(_pdfio_block_t *));
+
+      pdf->bindex[left] = block;
+      pdf->num_bindex ++;
+    }
+
+    if (size == _PDFIO_BLOCK_SIZE || !pdf->blocks)
+    {
+      block->next = pdf->blocks;
+      pdf->blocks = block;
+    }
+    else
+    {
+      // Keep the partially-used block at the head of the list...
+      block->next       = pdf->blocks->next;
+      pdf->blocks->next = block;
+    }
+  }
+
+  ptr         = block->buffer + block->used + pad;
+  block->used += bytes + pad;
+  block->live ++;
+
+  pdf->alloc_bytes += bytes + pad;
+
+  _pdfioFileUnlock(pdf);
+
+  memset(ptr, 0, bytes);
+
+  return (ptr);
+}
+
+
 //
 // 'pdfioFileClose()' - Close a PDF file and free all memory used for it.
 //
@@ -120,36 +434,82 @@ pdfioFileClose(pdfio_file_t *pdf)	// I - PDF file
   {
     ret = false;
 
-    if (pdfioObjClose(pdf->info_obj) && write_pages(pdf) && pdfioObjClose(pdf->root_obj) && write_trailer(pdf))
+    if (pdf->update && pdf->info_obj && pdf->info_obj->value.type == PDFIO_VALTYPE_DICT)
+      pdfioDictSetDate(pdf->info_obj->value.value.dict, "ModDate", time(NULL));
+
+    if (_pdfioContentSubsetFonts(pdf) && pdfioObjClose(pdf->info_obj) && write_pages(pdf) && pdfioObjClose(pdf->root_obj) && (pdf->linearize ? write_linearized(pdf) : write_trailer(pdf)))
       ret = _pdfioFileFlush(pdf);
+
+    _pdfioStreamStopParallel(pdf);
+
+    if (pdf->linearize)
+    {
+      // Close and remove the temporary file...
+      if (pdf->fd == pdf->lin_fd)
+        pdf->fd = pdf->lin_outfd;
+
+      close(pdf->lin_fd);
+
+      if (pdf->lin_filename)
+      {
+        unlink(pdf->lin_filename);
+        free(pdf->lin_filename);
+      }
+    }
   }
 
   if (pdf->fd >= 0 && close(pdf->fd) < 0)
     ret = false;
 
+#ifndef _WIN32
+  if (pdf->memmapped)
+    munmap((void *)pdf->memdata, pdf->memsize);
+#endif // !_WIN32
+
+  _pdfioFileDeleteCache(pdf);
+
   // Free all data...
   free(pdf->filename);
   free(pdf->version);
-
-  for (i = 0; i < pdf->num_arrays; i ++)
-    _pdfioArrayDelete(pdf->arrays[i]);
-  free(pdf->arrays);
-
-  for (i = 0; i < pdf->num_dicts; i ++)
-    _pdfioDictDelete(pdf->dicts[i]);
-  free(pdf->dicts);
+  free(pdf->spool);
 
   for (i = 0; i < pdf->num_objs; i ++)
     _pdfioObjDelete(pdf->objs[i]);
   free(pdf->objs);
+  free(pdf->objnums);
+  free(pdf->sparse_objs);
+  free(pdf->xrefs);
 
   free(pdf->objmaps);
+  free(pdf->objhashes);
+
+  for (i = 0; i < pdf->num_objstm_idx; i ++)
+    free(pdf->objstm_idx[i].entries);
+  free(pdf->objstm_idx);
+
+  free(pdf->subfonts);
+  free(pdf->used_chars);
 
   free(pdf->pages);
 
-  for (i = 0; i < pdf->num_strings; i ++)
-    free(pdf->strings[i]);
+  for (i = 0; i < pdf->num_page_levels; i ++)
+    free(pdf->page_levels[i].kids);
+  free(pdf->page_nodes);
+
   free(pdf->strings);
+  free_blocks(pdf->strbufs);
+
+  free_blocks(pdf->blocks);
+  free(pdf->bindex);
+
+  if (pdf->have_mutex)
+  {
+#ifdef _WIN32
+    DeleteCriticalSection(&pdf->mutex);
+#else
+    pthread_mutex_destroy(&pdf->mutex);
+#endif // _WIN32
+  }
 
   free(pdf);
 
@@ -342,34 +702,19 @@ _pdfioFileCreateObj(
   if (pdf->mode != _PDFIO_MODE_WRITE)
     return (NULL);
 
-  // Allocate memory for the object...
-  if ((obj = (pdfio_obj_t *)calloc(1, sizeof(pdfio_obj_t))) == NULL)
-  {
-    _pdfioFileError(pdf, "Unable to allocate memory for object - %s", strerror(errno));
-    return (NULL);
-  }
-
-  // Expand the objects array as needed
-  if (pdf->num_objs >= pdf->alloc_objs)
-  {
-    pdfio_obj_t **temp = (pdfio_obj_t **)realloc(pdf->objs, (pdf->alloc_objs + 32) * sizeof(pdfio_obj_t *));
-
-    if (!temp)
-    {
-      _pdfioFileError(pdf, "Unable to allocate memory for object - %s", strerror(errno));
-      free(obj);
-      return (NULL);
-    }
-
-    pdf->objs       = temp;
-    pdf->alloc_objs += 32;
-  }
+  // Allocate the object, which gets the next object number...  Objects in an
+  // incremental update are numbered after the objects in the original file,
+  // and objects in a new file are numbered after any that have been freed.
+  if (pdf->update)
+    obj = add_obj(pdf, pdf->update_objnum + pdf->update_num_objs, 0, 0);
+  else
+    obj = add_obj(pdf, pdf->num_objs + pdf->num_xrefs + 1, 0, 0);
 
-  pdf->objs[pdf->num_objs ++] = obj;
+  if (!obj)
+    return (NULL);
 
-  // Initialize the object...
-  obj->pdf    = pdf;
-  obj->number = pdf->num_objs;
+  if (pdf->update)
+    pdf->update_num_objs ++;
 
   if (value)
     _pdfioValueCopy(pdf, &obj->value, srcpdf, value);
@@ -436,6 +781,7 @@ pdfioFileCreatePage(pdfio_file_t *pdf,	// I - PDF file
                     pdfio_dict_t *dict)	// I - Page dictionary
 {
   pdfio_obj_t	*page,			// Page object
+		*parent,		// Parent pages object
 		*contents;		// Contents object
   pdfio_dict_t	*contents_dict;		// Dictionary for Contents object
 
@@ -444,11 +790,30 @@ pdfioFileCreatePage(pdfio_file_t *pdf,	// I - PDF file
   if (!pdf)
     return (NULL);
 
-  // Copy the page dictionary...
-  if (dict)
+  // Find the page tree node for the new page...
+  if ((parent = _pdfioFileGetPageParent(pdf)) == NULL)
+    return (NULL);
+
+  // Copy the page dictionary...  When streaming, the copy must not share any
+  // values with the original so it can be released once written.
+  if (dict && (pdf->options & PDFIO_OPTION_STREAMING))
+  {
+    _pdfio_value_t	src,		// Source value
+			dst;		// Copied value
+
+    src.type       = PDFIO_VALTYPE_DICT;
+    src.value.dict = dict;
+
+    dict = _pdfioValueClone(pdf, &dst, &src) ? dst.value.dict : NULL;
+  }
+  else if (dict)
+  {
     dict = pdfioDictCopy(pdf, dict);
+  }
   else
+  {
     dict = pdfioDictCreate(pdf);
+  }
 
   if (!dict)
     return (NULL);
@@ -460,12 +825,12 @@ pdfioFileCreatePage(pdfio_file_t *pdf,	// I - PDF file
   if (!_pdfioDictGetValue(dict, "MediaBox"))
     pdfioDictSetRect(dict, "MediaBox", &pdf->media_box);
 
-  pdfioDictSetObj(dict, "Parent", pdf->pages_obj);
+  pdfioDictSetObj(dict, "Parent", parent);
 
   if (!_pdfioDictGetValue(dict, "Resources"))
     pdfioDictSetDict(dict, "Resources", pdfioDictCreate(pdf));
 
-  if (!_pdfioDictGetValue(dict, "Type"))
+  if (!_pdfioDictGetValue(dict, _pdfio_keys[_PDFIO_KEY_TYPE]))
     pdfioDictSetName(dict, "Type", "Page");
 
   // Create the page object...
@@ -483,6 +848,13 @@ pdfioFileCreatePage(pdfio_file_t *pdf,	// I - PDF file
   if ((contents = pdfioFileCreateObj(pdf, contents_dict)) == NULL)
     return (NULL);
 
+  if (pdf->options & PDFIO_OPTION_STREAMING)
+  {
+    // Free the page and contents dictionaries once they are written...
+    page->release     = true;
+    contents->release = true;
+  }
+
   // Add the contents stream to the pages object and write it...
   pdfioDictSetObj(dict, "Contents", contents);
   if (!pdfioObjClose(page))
@@ -491,6 +863,8 @@ pdfioFileCreatePage(pdfio_file_t *pdf,	// I - PDF file
   if (!_pdfioFileAddPage(pdf, page))
     return (NULL);
 
+  _pdfioObjRelease(page);
+
   // Create the contents stream...
 #ifdef DEBUG
   return (pdfioObjCreateStream(contents, PDFIO_FILTER_NONE));
@@ -548,13 +922,7 @@ pdfioFileCreateTemporary(
     void             *error_cbdata)	// I - Error callback data, if any
 {
   pdfio_file_t	*pdf;			// PDF file
-  int		i,			// Looping var
-		fd;			// File descriptor
-  const char	*tmpdir;		// Temporary directory
-#if _WIN32 || defined(__APPLE__)
-  char		tmppath[256];		// Temporary directory path
-#endif // _WIN32 || __APPLE__
-  unsigned	tmpnum;			// Temporary filename number
+  int		fd;			// File descriptor
 
 
   PDFIO_DEBUG("pdfioFileCreate(buffer=%p, bufsize=%lu, version=\"%s\", media_box=%p, crop_box=%p, error_cb=%p, error_cbdata=%p)\n", (void *)buffer, (unsigned long)bufsize, version, (void *)media_box, (void *)crop_box, (void *)error_cb, (void *)error_cbdata);
@@ -568,40 +936,7 @@ pdfioFileCreateTemporary(
   }
 
   // Create the temporary PDF file...
-#if _WIN32
-  if ((tmpdir = getenv("TEMP")) == NULL)
-  {
-    GetTempPathA(sizeof(tmppath), tmppath);
-    tmpdir = tmppath;
-  }
-
-#elif defined(__APPLE__)
-  if ((tmpdir = getenv("TMPDIR")) != NULL && access(tmpdir, W_OK))
-    tmpdir = NULL;
-
-  if (!tmpdir)
-  {
-    // Grab the per-process temporary directory for sandboxed apps...
-#  ifdef _CS_DARWIN_USER_TEMP_DIR
-    if (confstr(_CS_DARWIN_USER_TEMP_DIR, tmppath, sizeof(tmppath)))
-      tmpdir = tmppath;
-    else
-#  endif // _CS_DARWIN_USER_TEMP_DIR
-      tmpdir = "/private/tmp";
-  }
-
-#else
-  if ((tmpdir = getenv("TMPDIR")) == NULL || access(tmpdir, W_OK))
-    tmpdir = "/tmp";
-#endif // _WIN32
-
-  for (i = 0, fd = -1; i < 1000; i ++)
-  {
-    _pdfioCryptoMakeRandom((uint8_t *)&tmpnum, sizeof(tmpnum));
-    snprintf(buffer, bufsize, "%s/%08x.pdf", tmpdir, tmpnum);
-    if ((fd = open(buffer, O_WRONLY | O_BINARY | O_CREAT | O_TRUNC | O_EXCL, 0666)) >= 0)
-      break;
-  }
+  fd = create_temp_file(buffer, bufsize, "pdf");
 
   if (fd < 0)
   {
@@ -627,6 +962,37 @@ pdfioFileCreateTemporary(
 }
 
 
+//
+// '_pdfioFileFindHashedObj()' - Find a copied stream object by content hash.
+//
+
+pdfio_obj_t *				// O - Matching object or `NULL` if none
+_pdfioFileFindHashedObj(
+    pdfio_file_t  *pdf,			// I - Destination PDF file
+    const uint8_t *digest)		// I - SHA-256 digest
+{
+  size_t	left,			// Left side of search
+		right,			// Right side of search
+		current;		// Current element
+  int		result;			// Result of comparison
+
+
+  for (left = 0, right = pdf->num_objhashes; left < right;)
+  {
+    current = (left + right) / 2;
+
+    if ((result = memcmp(pdf->objhashes[current].digest, digest, sizeof(pdf->objhashes[current].digest))) == 0)
+      return (pdf->objhashes[current].obj);
+    else if (result < 0)
+      left = current + 1;
+    else
+      right = current;
+  }
+
+  return (NULL);
+}
+
+
 //
 // '_pdfioFileFindMappedObj()' - Find a mapped object.
 //
@@ -668,67 +1034,180 @@ pdfioFileFindObj(
     pdfio_file_t *pdf,			// I - PDF file
     size_t       number)		// I - Object number (1 to N)
 {
-  size_t	left,			// Left object
-		right,			// Right object
-		current;		// Current object
+  pdfio_obj_t	*obj = NULL;		// Matching object
 
 
-  PDFIO_DEBUG("pdfioFileFindObj(pdf=%p, number=%lu) alloc_objs=%lu, num_objs=%lu, objs=%p\n", (void *)pdf, (unsigned long)number, (unsigned long)(pdf ? pdf->alloc_objs : 0), (unsigned long)(pdf ? pdf->num_objs : 0), (void *)(pdf ? pdf->objs : NULL));
+  PDFIO_DEBUG("pdfioFileFindObj(pdf=%p, number=%lu) alloc_objnums=%lu, num_sparse_objs=%lu\n", (void *)pdf, (unsigned long)number, (unsigned long)(pdf ? pdf->alloc_objnums : 0), (unsigned long)(pdf ? pdf->num_sparse_objs : 0));
 
   // Range check input...
-  if (!pdf || pdf->num_objs == 0 || number < 1)
+  if (!pdf || number < 1)
     return (NULL);
 
-  // Do a binary search for the object...
-  if ((current = number - 1) >= pdf->num_objs)
-    current = pdf->num_objs / 2;
+  // Most objects are found using the object number index...
+  _pdfioFileLock(pdf);
 
-  PDFIO_DEBUG("pdfioFileFindObj: objs[current=%lu]=%p(%lu)\n", (unsigned long)current, (void *)pdf->objs[current], (unsigned long)(pdf->objs[current] ? pdf->objs[current]->number : 0));
-
-  if (number == pdf->objs[current]->number)
-  {
-    // Fast match...
-    PDFIO_DEBUG("pdfioFileFindObj: Returning %lu (%p)\n", (unsigned long)current, pdf->objs[current]);
-    return (pdf->objs[current]);
-  }
-  else if (number < pdf->objs[current]->number)
+  if (number < pdf->alloc_objnums)
   {
-    left  = 0;
-    right = current;
+    obj = pdf->objnums[number];
   }
   else
   {
-    left  = current;
-    right = pdf->num_objs - 1;
+    // Otherwise search the remaining objects...
+    sort_sparse_objs(pdf);
+
+    obj = find_sparse_obj(pdf, number);
   }
 
-  while ((right - left) > 1)
+  _pdfioFileUnlock(pdf);
+
+  PDFIO_DEBUG("pdfioFileFindObj: Returning %p\n", (void *)obj);
+
+  return (obj);
+}
+
+
+//
+// '_pdfioFileFree()' - Release memory allocated with @link _pdfioFileAlloc@.
+//
+// The memory block is freed once all of its allocations have been released.
+// The current block is instead reused from the beginning.
+//
+
+void
+_pdfioFileFree(pdfio_file_t *pdf,	// I - PDF file
+               void         *ptr)	// I - Memory to release
+{
+  _pdfio_block_t	*block,		// Current block
+			*prev;		// Previous block
+  size_t		left,		// Left side of search
+			right,		// Right side of search
+			current;	// Current element
+
+
+  if (!ptr)
+    return;
+
+  _pdfioFileLock(pdf);
+
+  // Find the last block that starts at or before the allocation...
+  for (left = 0, right = pdf->num_bindex; left < right;)
   {
     current = (left + right) / 2;
 
-    if (number == pdf->objs[current]->number)
-      return (pdf->objs[current]);
-    else if (number < pdf->objs[current]->number)
+    if ((uintptr_t)pdf->bindex[current] <= (uintptr_t)ptr)
+      left = current + 1;
+    else
       right = current;
+  }
+
+  if (left > 0 && (block = pdf->bindex[left - 1]) != NULL && (char *)ptr >= block->buffer && (char *)ptr <= (block->buffer + block->used) && block->live > 0 && -- block->live == 0)
+  {
+    if (block == pdf->blocks)
+    {
+      // Start over with the current block...
+      block->used = 0;
+    }
     else
-      left = current;
+    {
+      // Remove the block from the list and index, then free it...
+      for (prev = pdf->blocks; prev && prev->next != block; prev = prev->next);
+
+      if (prev)
+        prev->next = block->next;
+
+      pdf->num_bindex --;
+      if ((left - 1) < pdf->num_bindex)
+        memmove(pdf->bindex + left - 1, pdf->bindex + left, (pdf->num_bindex - left + 1) * sizeof(_pdfio_block_t *));
+
+      pdf->stats.alloc_bytes -= sizeof(_pdfio_block_t) + block->size;
+
+      free(block);
+    }
   }
 
-  if (number == pdf->objs[left]->number)
+  _pdfioFileUnlock(pdf);
+}
+
+
+//
+// '_pdfioFileFreeObj()' - Free a written object, keeping its cross-reference entry.
+//
+// This is used by the `PDFIO_OPTION_STREAMING` output option to free the page,
+// content stream, and page tree node objects once they have been written and
+// are no longer referenced by the library.  Only the offset or object stream
+// index is kept so that the cross-reference data can be written when the PDF
+// file is closed - the generation number of a new object is always 0.
+//
+// Objects in an incremental update are kept since they are numbered after the
+// objects in the original file.
+//
+
+void
+_pdfioFileFreeObj(pdfio_file_t *pdf,	// I - PDF file
+                  pdfio_obj_t  *obj)	// I - Object
+{
+  pdfio_obj_t	**match;		// Matching object
+
+
+  if (!obj->release || pdf->update || obj == pdf->pages_obj || (!obj->offset && !obj->objstm))
+    return;
+
+  PDFIO_DEBUG("_pdfioFileFreeObj(pdf=%p, obj=%p(%lu))\n", (void *)pdf, (void *)obj, (unsigned long)obj->number);
+
+  // Expand the cross-reference entries as needed, keeping the object if
+  // there is no memory for them...
+  if (obj->number > pdf->alloc_xrefs)
   {
-    PDFIO_DEBUG("pdfioFileFindObj: Returning %lu (%p)\n", (unsigned long)left, pdf->objs[left]);
-    return (pdf->objs[left]);
+    size_t	alloc_xrefs = pdf->alloc_xrefs ? 2 * pdf->alloc_xrefs : 1024;
+					// New allocation
+    _pdfio_xref_t *temp;		// New cross-reference entries
+
+    while (alloc_xrefs < obj->number)
+      alloc_xrefs *= 2;
+
+    if ((temp = (_pdfio_xref_t *)realloc(pdf->xrefs, alloc_xrefs * sizeof(_pdfio_xref_t))) == NULL)
+      return;
+
+    memset(temp + pdf->alloc_xrefs, 0, (alloc_xrefs - pdf->alloc_xrefs) * sizeof(_pdfio_xref_t));
+
+    pdf->xrefs       = temp;
+    pdf->alloc_xrefs = alloc_xrefs;
   }
-  else if (number == pdf->objs[right]->number)
+
+  // Remove the object from the objects array, which is sorted by number for a
+  // new PDF file...
+  if ((match = (pdfio_obj_t **)bsearch(&obj, pdf->objs, pdf->num_objs, sizeof(pdfio_obj_t *), (int (*)(const void *, const void *))compare_objs)) == NULL)
+    return;
+
+  pdf->num_objs --;
+  if (match < (pdf->objs + pdf->num_objs))
+    memmove(match, match + 1, (size_t)(pdf->objs + pdf->num_objs - match) * sizeof(pdfio_obj_t *));
+
+  // Then from the index or sparse array...
+  if (obj->number < pdf->alloc_objnums)
   {
-    PDFIO_DEBUG("pdfioFileFindObj: Returning %lu (%p)\n", (unsigned long)right, pdf->objs[right]);
-    return (pdf->objs[right]);
+    pdf->objnums[obj->number] = NULL;
   }
   else
   {
-    PDFIO_DEBUG("pdfioFileFindObj: Returning NULL\n");
-    return (NULL);
+    sort_sparse_objs(pdf);
+
+    if ((match = (pdfio_obj_t **)bsearch(&obj, pdf->sparse_objs, pdf->num_sparse_objs, sizeof(pdfio_obj_t *), (int (*)(const void *, const void *))compare_objs)) != NULL)
+    {
+      pdf->num_sparse_objs --;
+      pdf->sorted_sparse_objs --;
+
+      if (match < (pdf->sparse_objs + pdf->num_sparse_objs))
+        memmove(match, match + 1, (size_t)(pdf->sparse_objs + pdf->num_sparse_objs - match) * sizeof(pdfio_obj_t *));
+    }
   }
+
+  // Save the cross-reference entry and free the object...
+  pdf->xrefs[obj->number - 1].offset = obj->offset;
+  pdf->xrefs[obj->number - 1].objstm = obj->objstm;
+  pdf->num_xrefs ++;
+
+  _pdfioObjDelete(obj);
 }
 
 
@@ -820,7 +1299,7 @@ size_t					// O - Number of objects
 pdfioFileGetNumObjs(
     pdfio_file_t *pdf)			// I - PDF file
 {
-  return (pdf ? pdf->num_objs : 0);
+  return (pdf ? pdf->num_objs + pdf->num_xrefs : 0);
 }
 
 
@@ -838,30 +1317,107 @@ pdfioFileGetNumPages(pdfio_file_t *pdf)	// I - PDF file
 //
 // 'pdfioFileGetObj()' - Get an object from a PDF file.
 //
+// When writing a new PDF file with the `PDFIO_OPTION_STREAMING` option, `NULL`
+// is returned for the page, content stream, and page tree objects that have
+// been freed after they were written.
+//
 
 pdfio_obj_t *				// O - Object
 pdfioFileGetObj(pdfio_file_t *pdf,	// I - PDF file
                 size_t       n)		// I - Object index (starting at 0)
 {
-  if (!pdf || n >= pdf->num_objs)
+  pdfio_obj_t	*obj;			// Object
+
+
+  if (!pdf || n >= (pdf->num_objs + pdf->num_xrefs))
     return (NULL);
+
+  _pdfioFileLock(pdf);
+
+  if (pdf->num_xrefs)
+  {
+    // Objects in a new file are numbered by index, some of which have been
+    // freed...
+    sort_sparse_objs(pdf);
+
+    obj = find_loaded_obj(pdf, n + 1);
+  }
   else
-    return (pdf->objs[n]);
+  {
+    if (pdf->sort_objs)
+    {
+      // Sort objects by number the first time they are needed...
+      qsort(pdf->objs, pdf->num_objs, sizeof(pdfio_obj_t *), (int (*)(const void *, const void *))compare_objs);
+      pdf->sort_objs = false;
+    }
+
+    obj = pdf->objs[n];
+  }
+
+  _pdfioFileUnlock(pdf);
+
+  return (obj);
 }
 
 
 //
 // 'pdfioFileGetPage()' - Get a page object from a PDF file.
 //
+// When writing a new PDF file with the `PDFIO_OPTION_STREAMING` option, `NULL`
+// is returned since page objects are freed once their page tree node has been
+// written.
+//
 
 pdfio_obj_t *				// O - Object
 pdfioFileGetPage(pdfio_file_t *pdf,	// I - PDF file
                  size_t       n)	// I - Page index (starting at 0)
 {
-  if (!pdf || n >= pdf->num_pages)
+  pdfio_obj_t	*page;			// Page object
+
+
+  if (!pdf || n >= pdf->num_pages || !pdf->pages)
     return (NULL);
+
+  _pdfioFileLock(pdf);
+
+  if (!pdf->pages[n] && pdf->lazy_pages)
+    page = load_page(pdf, n);
   else
-    return (pdf->pages[n]);
+    page = pdf->pages[n];
+
+  _pdfioFileUnlock(pdf);
+
+  return (page);
+}
+
+
+//
+// '_pdfioFileGetPageParent()' - Get the page tree node for the next page.
+//
+// Pages are added to leaf nodes holding up to "page_fanout" pages each, which
+// are written as part of a balanced page tree as they fill up.  New pages in
+// an incremental update are added to the original pages object.
+//
+
+pdfio_obj_t *				// O - Pages object
+_pdfioFileGetPageParent(
+    pdfio_file_t *pdf)			// I - PDF file
+{
+  if (pdf->update || !pdf->page_fanout)
+    return (pdf->pages_obj);
+  else
+    return (get_page_node(pdf, 0));
+}
+
+
+//
+// 'pdfioFileGetOptions()' - Get the output options for a PDF file.
+//
+
+pdfio_option_t				// O - Output options
+pdfioFileGetOptions(pdfio_file_t *pdf)	// I - PDF file
+{
+  return (pdf ? pdf->options : PDFIO_OPTION_NONE);
 }
 
 
@@ -905,6 +1461,45 @@ pdfioFileGetProducer(pdfio_file_t *pdf)	// I - PDF file
 }
 
 
+//
+// 'pdfioFileGetStats()' - Get runtime statistics for a PDF file.
+//
+// This function copies the current statistics for a PDF file, which count the
+// reads, writes, and seeks made using the file descriptor or I/O callbacks,
+// the objects and object streams that have been loaded, the bytes of Flate
+// data that have been decompressed and compressed, the bytes that have been
+// encrypted or decrypted, and the memory used for values and strings.
+//
+// Reads from memory-mapped and in-memory PDF files are not counted since
+// the data is used in place.  Flate and encryption statistics for a stream
+// are added when the stream is closed.
+//
+
+bool					// O - `true` on success, `false` on error
+pdfioFileGetStats(pdfio_file_t  *pdf,	// I - PDF file
+                  pdfio_stats_t *stats)	// O - Statistics
+{
+  if (!pdf || !stats)
+  {
+    if (stats)
+      memset(stats, 0, sizeof(pdfio_stats_t));
+
+    return (false);
+  }
+
+  _pdfioFileLock(pdf);
+
+  *stats = pdf->stats;
+
+  if (pdf->num_strings > _PDFIO_KEY_MAX)
+    stats->strings = pdf->num_strings - _PDFIO_KEY_MAX;
+
+  _pdfioFileUnlock(pdf);
+
+  return (true);
+}
+
+
 //
 // 'pdfioFileGetSubject()' - Get the subject for a PDF file.
 //
@@ -940,1303 +1535,4485 @@ pdfioFileGetVersion(
 
 
 //
-// 'pdfioFileOpen()' - Open a PDF file for reading.
-//
-// This function opens an existing PDF file.  The "filename" argument specifies
-// the name of the PDF file to create.
-//
-// The "password_cb" and "password_cbdata" arguments specify a password callback
-// and its data pointer for PDF files that use one of the standard Adobe
-// "security" handlers.  The callback returns a password string or `NULL` to
-// cancel the open.  If `NULL` is specified for the callback function and the
-// PDF file requires a password, the open will always fail.
+// '_pdfioFileLoadCompressedObj()' - Load a single object from an object stream.
 //
-// The "error_cb" and "error_cbdata" arguments specify an error handler callback
-// and its data pointer - if `NULL` the default error handler is used that
-// writes error messages to `stderr`.
+// When the object value cache is enabled and the object stream has already
+// been loaded once, the object is read again using the saved object offsets
+// instead of loading every object in the stream.  The stream data still has
+// to be decompressed up to the object, but nothing else is parsed or kept.
 //
 
-pdfio_file_t *				// O - PDF file
-pdfioFileOpen(
-    const char          *filename,	// I - Filename
-    pdfio_password_cb_t password_cb,	// I - Password callback or `NULL` for none
-    void                *password_cbdata,
-					// I - Password callback data, if any
-    pdfio_error_cb_t    error_cb,	// I - Error callback or `NULL` for default
-    void                *error_cbdata)	// I - Error callback data, if any
+bool					// O - `true` on success, `false` on error
+_pdfioFileLoadCompressedObj(
+    pdfio_file_t *pdf,			// I - PDF file
+    pdfio_obj_t  *obj)			// I - Object
 {
-  pdfio_file_t	*pdf;			// PDF file
-  char		line[1025],		// Line from file
-		*ptr,			// Pointer into line
-		*end;			// End of line
-  ssize_t	bytes;			// Bytes read
-  off_t		xref_offset;		// Offset to xref table
+  _pdfio_objstm_t	key,		// Search key
+			*idx;		// Object stream index
+  size_t		i;		// Looping var
+  pdfio_obj_t		*stmobj;	// Object stream
+  pdfio_stream_t	*st;		// Stream
+  _pdfio_token_t	tb;		// Token buffer/stack
+  _pdfio_value_t	value;		// Object value
+  size_t		bytes,		// Bytes to skip
+			alloc_bytes;	// Bytes allocated before reading value
+  bool			ret = true;	// Return value
 
 
-  PDFIO_DEBUG("pdfioFileOpen(filename=\"%s\", password_cb=%p, password_cbdata=%p, error_cb=%p, error_cbdata=%p)\n", filename, (void *)password_cb, (void *)password_cbdata, (void *)error_cb, (void *)error_cbdata);
+  // See if we have an index for the object stream...
+  key.number = obj->objstm;
 
-  // Range check input...
-  if (!filename)
-    return (NULL);
+  if (pdf->num_objstm_idx == 0 || (idx = (_pdfio_objstm_t *)bsearch(&key, pdf->objstm_idx, pdf->num_objstm_idx, sizeof(_pdfio_objstm_t), (int (*)(const void *, const void *))compare_objstms)) == NULL)
+    return (_pdfioFileLoadObjStream(pdf, obj->objstm));
 
-  if (!error_cb)
+  for (i = 0; i < idx->count; i ++)
   {
-    error_cb     = _pdfioFileDefaultError;
-    error_cbdata = NULL;
+    if (idx->entries[2 * i] == obj->number)
+      break;
   }
 
-  // Allocate a PDF file structure...
-  if ((pdf = (pdfio_file_t *)calloc(1, sizeof(pdfio_file_t))) == NULL)
-  {
-    pdfio_file_t temp;			// Dummy file
-    char	message[8192];		// Message string
-
-    temp.filename = (char *)filename;
-    snprintf(message, sizeof(message), "Unable to allocate memory for PDF file - %s", strerror(errno));
-    (error_cb)(&temp, message, error_cbdata);
-    return (NULL);
-  }
+  if (i >= idx->count || (stmobj = pdfioFileFindObj(pdf, obj->objstm)) == NULL)
+    return (_pdfioFileLoadObjStream(pdf, obj->objstm));
 
-  pdf->loc         = get_lconv();
-  pdf->filename    = strdup(filename);
-  pdf->mode        = _PDFIO_MODE_READ;
-  pdf->error_cb    = error_cb;
-  pdf->error_data  = error_cbdata;
-  pdf->permissions = PDFIO_PERMISSION_ALL;
+  PDFIO_DEBUG("_pdfioFileLoadCompressedObj: Object %lu at offset %lu in object stream %lu.\n", (unsigned long)obj->number, (unsigned long)idx->entries[2 * i + 1], (unsigned long)obj->objstm);
 
-  // Open the file...
-  if ((pdf->fd = open(filename, O_RDONLY | O_BINARY)) < 0)
+  // Skip to the object and read its value...
+  if ((st = pdfioObjOpenStream(stmobj, true)) == NULL)
   {
-    _pdfioFileError(pdf, "Unable to open file - %s", strerror(errno));
-    free(pdf->filename);
-    free(pdf);
-    return (NULL);
+    _pdfioFileError(pdf, "Unable to open compressed object stream %lu.", (unsigned long)obj->objstm);
+    return (false);
   }
 
-  // Read the header from the first line...
-  if (!_pdfioFileGets(pdf, line, sizeof(line)))
-    goto error;
+  pdf->stats.objstms_loaded ++;
 
-  if ((strncmp(line, "%PDF-1.", 7) && strncmp(line, "%PDF-2.", 7)) || !isdigit(line[7] & 255))
+  if ((bytes = idx->first + idx->entries[2 * i + 1]) > 0 && !pdfioStreamConsume(st, bytes))
   {
-    // Bad header
-    _pdfioFileError(pdf, "Bad header '%s'.", line);
-    goto error;
+    _pdfioFileError(pdf, "Unable to find object %lu in compressed object stream %lu.", (unsigned long)obj->number, (unsigned long)obj->objstm);
+    pdfioStreamClose(st);
+    return (false);
   }
 
-  // Copy the version number...
-  pdf->version = strdup(line + 5);
+  _pdfioTokenInit(&tb, pdf, (_pdfio_tconsume_cb_t)pdfioStreamConsume, (_pdfio_tpeek_cb_t)pdfioStreamPeek, st);
 
-  // Grab the last 1k of the file to find the start of the xref table...
-  if (_pdfioFileSeek(pdf, -1024, SEEK_END) < 0)
+  alloc_bytes = pdf->alloc_bytes;
+
+  if (!_pdfioValueRead(pdf, stmobj, &tb, &value, 0))
   {
-    _pdfioFileError(pdf, "Unable to read startxref data.");
-    goto error;
+    _pdfioFileError(pdf, "Unable to read compressed object.");
+    ret = false;
   }
+  else if (obj->value.type == PDFIO_VALTYPE_NONE)
+  {
+    obj->value = value;
+    _pdfioObjCache(obj, pdf->alloc_bytes - alloc_bytes);
 
-  if ((bytes = _pdfioFileRead(pdf, line, sizeof(line) - 1)) < 1)
+    pdf->stats.objs_loaded ++;
+  }
+  else
   {
-    _pdfioFileError(pdf, "Unable to read startxref data.");
-    goto error;
+    _pdfioValueRelease(pdf, &value);
   }
 
-  line[bytes] = '\0';
-  end = line + bytes - 9;
+  pdfioStreamClose(st);
 
-  for (ptr = line; ptr < end; ptr ++)
+  return (ret);
+}
+
+
+//
+// '_pdfioFileLoadObjStream()' - Load the objects in a compressed object stream.
+//
+// Object streams are Adobe's complicated solution for saving a few
+// kilobytes in an average PDF file at the expense of massively more
+// complicated reader applications.
+//
+// Each object stream starts with pairs of object numbers and offsets,
+// followed by the object values (typically dictionaries).  For
+// simplicity pdfio loads all of these values into memory the first time
+// one of the objects is referenced so that we don't later have to randomly
+// access compressed stream data to get a dictionary.  When the object value
+// cache is enabled, the object numbers and offsets are saved so that
+// @link _pdfioFileLoadCompressedObj@ can reload individual objects.
+//
+
+bool					// O - `true` on success, `false` on error
+_pdfioFileLoadObjStream(
+    pdfio_file_t *pdf,			// I - PDF file
+    size_t       number)		// I - Object stream number
+{
+  pdfio_obj_t		*obj;		// Object stream
+  pdfio_stream_t	*st;		// Stream
+  _pdfio_token_t	tb;		// Token buffer/stack
+  bool			ret;		// Return value
+
+
+  PDFIO_DEBUG("_pdfioFileLoadObjStream(pdf=%p, number=%lu)\n", pdf, (unsigned long)number);
+
+  // Find and open the object stream...
+  if ((obj = pdfioFileFindObj(pdf, number)) == NULL)
   {
-    if (!memcmp(ptr, "startxref", 9))
-      break;
+    _pdfioFileError(pdf, "Unable to find compressed object stream %lu.", (unsigned long)number);
+    return (false);
   }
 
-  if (ptr >= end)
+  if ((st = pdfioObjOpenStream(obj, true)) == NULL)
   {
-    _pdfioFileError(pdf, "Unable to find start of xref table.");
-    goto error;
+    _pdfioFileError(pdf, "Unable to open compressed object stream %lu.", (unsigned long)number);
+    return (false);
   }
 
-  xref_offset = (off_t)strtol(ptr + 9, NULL, 10);
-
-  if (!load_xref(pdf, xref_offset, password_cb, password_cbdata))
-    goto error;
-
-  return (pdf);
+  pdf->stats.objstms_loaded ++;
 
+  // Read the objects and close the stream...
+  _pdfioTokenInit(&tb, pdf, (_pdfio_tconsume_cb_t)pdfioStreamConsume, (_pdfio_tpeek_cb_t)pdfioStreamPeek, st);
 
-  // If we get here we had a fatal read error...
-  error:
+  ret = load_obj_stream(pdf, obj, &tb);
 
-  pdfioFileClose(pdf);
+  pdfioStreamClose(st);
 
-  return (NULL);
+  return (ret);
 }
 
 
 //
-// 'pdfioFileSetAuthor()' - Set the author for a PDF file.
+// 'pdfioFileLoadObjStreams()' - Load all compressed object streams using multiple threads.
+//
+// This function decompresses all of the compressed object streams in a PDF
+// file that has been opened for reading, using one thread per CPU, and then
+// loads the objects they contain.  PDF 1.5 and later files usually store most
+// of their objects in compressed object streams that are otherwise loaded one
+// at a time as the objects are used, so calling this function right after
+// @link pdfioFileOpen@ reduces the time needed to access every object in a
+// large PDF file.
+//
+// > *Note*: This function must be called when no other threads are using the
+// > PDF file and when no streams are open.
 //
 
-void
-pdfioFileSetAuthor(pdfio_file_t *pdf,	// I - PDF file
-                   const char   *value)	// I - Value
+bool					// O - `true` on success, `false` on error
+pdfioFileLoadObjStreams(
+    pdfio_file_t *pdf)			// I - PDF file
 {
-  if (pdf && pdf->info_obj)
-    pdfioDictSetString(pdf->info_obj->value.value.dict, "Author", pdfioStringCreate(pdf, value));
-}
-
+  bool			ret = true;	// Return value
+  bool			concurrent;	// Was concurrent reading enabled?
+  size_t		i, j,		// Looping vars
+			num_threads;	// Number of threads to start
+  size_t		*numbers;	// Object stream numbers
+  size_t		num_numbers = 0;// Number of object stream numbers
+  pdfio_obj_t		*obj;		// Current object
+  _pdfio_objpool_t	pool;		// Decoding threads
+  _pdfio_objjob_t	*job;		// Current job
+  _pdfio_thread_t	threads[_PDFIO_DEFLATE_THREADS];
+					// Threads
+  size_t		num_started = 0;// Number of threads that were started
+  _pdfio_objbuf_t	ob;		// Decoded object stream data
+  _pdfio_token_t	tb;		// Token buffer/stack
 
-//
-// 'pdfioFileSetCreationDate()' - Set the creation date for a PDF file.
-//
 
-void
-pdfioFileSetCreationDate(
-    pdfio_file_t *pdf,			// I - PDF file
-    time_t       value)			// I - Value
-{
-  if (pdf && pdf->info_obj)
-    pdfioDictSetDate(pdf->info_obj->value.value.dict, "CreationDate", value);
-}
+  // Range check input...
+  if (!pdf)
+    return (false);
 
+  if (pdf->mode != _PDFIO_MODE_READ)
+  {
+    _pdfioFileError(pdf, "Object streams can only be loaded when reading a PDF file.");
+    return (false);
+  }
 
-//
-// 'pdfioFileSetCreator()' - Set the creator string for a PDF file.
-//
+  if (pdf->current_obj)
+  {
+    _pdfioFileError(pdf, "Unable to load object streams while object %u is open.", (unsigned)pdf->current_obj->number);
+    return (false);
+  }
 
-void
-pdfioFileSetCreator(pdfio_file_t *pdf,	// I - PDF file
-                    const char   *value)// I - Value
-{
-  if (pdf && pdf->info_obj)
-    pdfioDictSetString(pdf->info_obj->value.value.dict, "Creator", pdfioStringCreate(pdf, value));
-}
+  // Find the object streams with objects that have not been loaded...
+  if ((numbers = (size_t *)malloc((pdf->num_objs + 1) * sizeof(size_t))) == NULL)
+  {
+    _pdfioFileError(pdf, "Unable to allocate memory for object streams.");
+    return (false);
+  }
 
+  for (i = 0; i < pdf->num_objs; i ++)
+  {
+    obj = pdf->objs[i];
 
-//
-// 'pdfioFileSetKeywords()' - Set the keywords string for a PDF file.
-//
+    if (obj->objstm && obj->value.type == PDFIO_VALTYPE_NONE)
+      numbers[num_numbers ++] = obj->objstm;
+  }
 
-void
-pdfioFileSetKeywords(
-    pdfio_file_t *pdf,			// I - PDF file
-    const char   *value)		// I - Value
-{
-  if (pdf && pdf->info_obj)
-    pdfioDictSetString(pdf->info_obj->value.value.dict, "Keywords", pdfioStringCreate(pdf, value));
-}
+  qsort(numbers, num_numbers, sizeof(size_t), (int (*)(const void *, const void *))compare_numbers);
 
+  for (i = 0, j = 0; i < num_numbers; i ++)
+  {
+    if (j == 0 || numbers[j - 1] != numbers[i])
+      numbers[j ++] = numbers[i];
+  }
 
-//
-// 'pdfioFileSetPermissions()' - Set the PDF permissions, encryption mode, and passwords.
-//
-// This function sets the PDF usage permissions, encryption mode, and
-// passwords.
-//
-// > *Note*: This function must be called before creating or copying any
-// > objects.  Due to fundamental limitations in the PDF format, PDF encryption
-// > offers little protection from disclosure.  Permissions are not enforced in
-// > any meaningful way.
-//
+  num_numbers = j;
 
-bool					// O - `true` on success, `false` otherwise
-pdfioFileSetPermissions(
-    pdfio_file_t       *pdf,		// I - PDF file
-    pdfio_permission_t permissions,	// I - Use permissions
-    pdfio_encryption_t encryption,	// I - Type of encryption to use
-    const char         *owner_password,	// I - Owner password, if any
-    const char         *user_password)	// I - User password, if any
-{
-  if (!pdf)
-    return (false);
+  PDFIO_DEBUG("pdfioFileLoadObjStreams: num_numbers=%lu\n", (unsigned long)num_numbers);
 
-  if (pdf->num_objs > 3)		// First three objects are pages, info, and root
+  if (num_numbers == 0)
   {
-    _pdfioFileError(pdf, "You must call pdfioFileSetPermissions before adding any objects.");
-    return (false);
+    free(numbers);
+    return (true);
   }
 
-  if (encryption == PDFIO_ENCRYPTION_NONE)
-    return (true);
+  // Create the decoding jobs, loading the object stream dictionaries...
+  memset(&pool, 0, sizeof(pool));
 
-  return (_pdfioCryptoLock(pdf, permissions, encryption, owner_password, user_password));
-}
+  if ((pool.jobs = (_pdfio_objjob_t *)calloc(num_numbers, sizeof(_pdfio_objjob_t))) == NULL)
+  {
+    _pdfioFileError(pdf, "Unable to allocate memory for object streams.");
+    free(numbers);
+    return (false);
+  }
 
+  for (i = 0; i < num_numbers; i ++)
+  {
+    if ((obj = pdfioFileFindObj(pdf, numbers[i])) == NULL || !pdfioObjGetDict(obj))
+    {
+      _pdfioFileError(pdf, "Unable to find compressed object stream %lu.", (unsigned long)numbers[i]);
+      ret = false;
+      continue;
+    }
 
-//
-// 'pdfioFileSetSubject()' - Set the subject for a PDF file.
-//
+    pool.jobs[pool.num_jobs ++].obj = obj;
+  }
 
-void
-pdfioFileSetSubject(
-    pdfio_file_t *pdf,			// I - PDF file
-    const char   *value)		// I - Value
-{
-  if (pdf && pdf->info_obj)
-    pdfioDictSetString(pdf->info_obj->value.value.dict, "Subject", pdfioStringCreate(pdf, value));
-}
+  free(numbers);
 
+  if (pool.num_jobs == 0)
+  {
+    free(pool.jobs);
+    return (ret);
+  }
 
-//
-// 'pdfioFileSetTitle()' - Set the title for a PDF file.
-//
+  // Decode the object streams using one thread per CPU, with each stream
+  // reading from its own position in the file...
+  if ((concurrent = pdf->concurrent) == false && !pdfioFileSetConcurrent(pdf, true))
+  {
+    free(pool.jobs);
+    return (false);
+  }
 
-void
-pdfioFileSetTitle(pdfio_file_t *pdf,	// I - PDF file
-                  const char   *value)	// I - Value
-{
-  if (pdf && pdf->info_obj)
-    pdfioDictSetString(pdf->info_obj->value.value.dict, "Title", pdfioStringCreate(pdf, value));
-}
+#ifdef _WIN32
+  SYSTEM_INFO	sysinfo;		// System information
 
+  GetSystemInfo(&sysinfo);
+  num_threads = (size_t)sysinfo.dwNumberOfProcessors;
+#else
+  long		ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+					// Number of CPUs
 
-//
-// '_pdfioObjAdd()' - Add an object to a file.
-//
+  num_threads = ncpus > 0 ? (size_t)ncpus : 1;
+#endif // _WIN32
 
-static pdfio_obj_t *			// O - Object
-add_obj(pdfio_file_t   *pdf,		// I - PDF file
-	size_t         number,		// I - Object number
-	unsigned short generation,	// I - Object generation
-	off_t          offset)		// I - Offset in file
-{
-  pdfio_obj_t	*obj;			// Object
-  size_t	left,			// Left object
-		right,			// Right object
-		current;		// Current object (center)
+  // The current thread also decodes object streams...
+  num_threads --;
 
+  if (num_threads > _PDFIO_DEFLATE_THREADS)
+    num_threads = _PDFIO_DEFLATE_THREADS;
+  if (num_threads >= pool.num_jobs)
+    num_threads = pool.num_jobs - 1;
 
-  // Allocate memory for the object...
-  if ((obj = (pdfio_obj_t *)calloc(1, sizeof(pdfio_obj_t))) == NULL)
-  {
-    _pdfioFileError(pdf, "Unable to allocate memory for object - %s", strerror(errno));
-    return (NULL);
-  }
+#ifdef _WIN32
+  InitializeCriticalSection(&pool.mutex);
+#else
+  pthread_mutex_init(&pool.mutex, NULL);
+#endif // _WIN32
 
-  // Expand the objects array as needed
-  if (pdf->num_objs >= pdf->alloc_objs)
+  for (num_started = 0; num_started < num_threads; num_started ++)
   {
-    pdfio_obj_t **temp = (pdfio_obj_t **)realloc(pdf->objs, (pdf->alloc_objs + 32) * sizeof(pdfio_obj_t *));
+#ifdef _WIN32
+    if ((threads[num_started] = CreateThread(NULL, 0, (LPTHREAD_START_ROUTINE)objstm_worker, &pool, 0, NULL)) == NULL)
+      break;
+#else
+    if (pthread_create(threads + num_started, NULL, (void *(*)(void *))objstm_worker, &pool))
+      break;
+#endif // _WIN32
+  }
 
-    if (!temp)
-    {
-      _pdfioFileError(pdf, "Unable to allocate memory for object - %s", strerror(errno));
-      free(obj);
-      return (NULL);
-    }
+  objstm_worker(&pool);
 
-    pdf->objs       = temp;
-    pdf->alloc_objs += 32;
+  for (i = 0; i < num_started; i ++)
+  {
+#ifdef _WIN32
+    WaitForSingleObject(threads[i], INFINITE);
+    CloseHandle(threads[i]);
+#else
+    pthread_join(threads[i], NULL);
+#endif // _WIN32
   }
 
-  obj->pdf        = pdf;
-  obj->number     = number;
-  obj->generation = generation;
-  obj->offset     = offset;
-
-  PDFIO_DEBUG("add_obj: obj=%p, ->pdf=%p, ->number=%lu, ->offset=%lu\n", obj, pdf, (unsigned long)obj->number, (unsigned long)offset);
+#ifdef _WIN32
+  DeleteCriticalSection(&pool.mutex);
+#else
+  pthread_mutex_destroy(&pool.mutex);
+#endif // _WIN32
 
-  // Insert object into array as needed...
-  if (pdf->num_objs == 0 || obj->number > pdf->objs[pdf->num_objs - 1]->number)
-  {
-    // Append object...
-    PDFIO_DEBUG("add_obj: Appending at %lu\n", (unsigned long)pdf->num_objs);
+  if (!concurrent)
+    pdfioFileSetConcurrent(pdf, false);
 
-    pdf->objs[pdf->num_objs] = obj;
-    pdf->last_obj            = pdf->num_objs;
-  }
-  else
+  // Then load the objects from the decoded data...
+  for (i = pool.num_jobs, job = pool.jobs; i > 0; i --, job ++)
   {
-    // Insert object...
-    if (obj->number < pdf->objs[pdf->last_obj]->number)
-    {
-      left  = 0;
-      right = pdf->last_obj;
-    }
-    else
+    if (!job->data)
     {
-      left  = pdf->last_obj;
-      right = pdf->num_objs - 1;
+      ret = false;
+      continue;
     }
 
-    while ((right - left) > 1)
-    {
-      current = (left + right) / 2;
-
-      if (obj->number < pdf->objs[current]->number)
-        right = current;
-      else
-        left = current;
-    }
+    pdf->stats.objstms_loaded ++;
 
-    if (obj->number < pdf->objs[left]->number)
-      current = left;
-    else if (obj->number < pdf->objs[right]->number)
-      current = right;
-    else
-      current = right;
+    ob.bufptr = job->data;
+    ob.bufend = job->data + job->datalen;
 
-    PDFIO_DEBUG("add_obj: Inserting at %lu\n", (unsigned long)current);
+    _pdfioTokenInit(&tb, pdf, (_pdfio_tconsume_cb_t)objstm_consume, (_pdfio_tpeek_cb_t)objstm_peek, &ob);
 
-    if (current < pdf->num_objs)
-      memmove(pdf->objs + current + 1, pdf->objs + current, (pdf->num_objs - current) * sizeof(pdfio_obj_t *));
+    if (!load_obj_stream(pdf, job->obj, &tb))
+      ret = false;
 
-    pdf->objs[current] = obj;
-    pdf->last_obj      = current;
+    free(job->data);
   }
 
-  pdf->num_objs ++;
+  free(pool.jobs);
 
-  return (obj);
+  return (ret);
 }
 
 
 //
-// 'compare_objmaps()' - Compare two object maps...
+// 'pdfioFileOpen()' - Open a PDF file for reading.
 //
-
-static int				// O - Result of comparison
-compare_objmaps(_pdfio_objmap_t *a,	// I - First object map
-                _pdfio_objmap_t *b)	// I - Second object map
-{
-  if (a->src_pdf < b->src_pdf)
-    return (-1);
-  else if (a->src_pdf > b->src_pdf)
-    return (1);
-  else if (a->src_number < b->src_number)
-    return (-1);
-  else if (a->src_number > b->src_number)
-    return (1);
-  else
-    return (0);
-}
-
-
+// This function opens an existing PDF file.  The "filename" argument specifies
+// the name of the PDF file to create.
 //
-// 'create_common()' - Allocate and initialize a pdfio_file_t object for writing.
+// The "password_cb" and "password_cbdata" arguments specify a password callback
+// and its data pointer for PDF files that use one of the standard Adobe
+// "security" handlers.  The callback returns a password string or `NULL` to
+// cancel the open.  If `NULL` is specified for the callback function and the
+// PDF file requires a password, the open will always fail.
+//
+// The "error_cb" and "error_cbdata" arguments specify an error handler callback
+// and its data pointer - if `NULL` the default error handler is used that
+// writes error messages to `stderr`.
 //
 
-static pdfio_file_t *			// O - New PDF file
-create_common(
-    const char        *filename,	// I - Filename
-    int               fd,		// I - File descriptor, if any
-    pdfio_output_cb_t output_cb,	// I - Output callback function, if any
-    void              *output_cbdata,	// I - Output callback data, if any
-    const char        *version,		// I - PDF version
-    pdfio_rect_t      *media_box,	// I - Media box or `NULL` for default
-    pdfio_rect_t      *crop_box,	// I - Crop box of `NULL` for default
-    pdfio_error_cb_t  error_cb,		// I - Error callback function
-    void              *error_cbdata)	// I - Error callback data
+pdfio_file_t *				// O - PDF file
+pdfioFileOpen(
+    const char          *filename,	// I - Filename
+    pdfio_password_cb_t password_cb,	// I - Password callback or `NULL` for none
+    void                *password_cbdata,
+					// I - Password callback data, if any
+    pdfio_error_cb_t    error_cb,	// I - Error callback or `NULL` for default
+    void                *error_cbdata)	// I - Error callback data, if any
 {
-  pdfio_file_t	*pdf;			// New PDF file
-  pdfio_dict_t	*dict;			// Dictionary
-  unsigned char	id_value[16];		// File ID value
+  int		fd;			// File descriptor
+  const char	*memdata = NULL;	// Memory-mapped file data
+  size_t	memsize = 0;		// Size of memory-mapped file data
+#ifndef _WIN32
+  struct stat	fileinfo;		// File information
+  void		*mapdata;		// Mapped data
+#endif // !_WIN32
 
 
-  PDFIO_DEBUG("create_common(filename=\"%s\", fd=%d, output_cb=%p, output_cbdata=%p, version=\"%s\", media_box=%p, crop_box=%p, error_cb=%p, error_cbdata=%p)\n", filename, fd, (void *)output_cb, (void *)output_cbdata, version, (void *)media_box, (void *)crop_box, (void *)error_cb, (void *)error_cbdata);
+  PDFIO_DEBUG("pdfioFileOpen(filename=\"%s\", password_cb=%p, password_cbdata=%p, error_cb=%p, error_cbdata=%p)\n", filename, (void *)password_cb, (void *)password_cbdata, (void *)error_cb, (void *)error_cbdata);
 
   // Range check input...
-  if (!filename || (fd < 0 && !output_cb))
+  if (!filename)
     return (NULL);
 
-  if (!version)
-    version = "2.0";
-
   if (!error_cb)
   {
     error_cb     = _pdfioFileDefaultError;
     error_cbdata = NULL;
   }
 
-  // Allocate a PDF file structure...
-  if ((pdf = (pdfio_file_t *)calloc(1, sizeof(pdfio_file_t))) == NULL)
+  // Open the file...
+  if ((fd = open(filename, O_RDONLY | O_BINARY)) < 0)
   {
     pdfio_file_t temp;			// Dummy file
     char	message[8192];		// Message string
 
     temp.filename = (char *)filename;
-    snprintf(message, sizeof(message), "Unable to allocate memory for PDF file: %s", strerror(errno));
+    snprintf(message, sizeof(message), "Unable to open file - %s", strerror(errno));
     (error_cb)(&temp, message, error_cbdata);
-
     return (NULL);
   }
 
-  // Initialize PDF object...
-  pdf->loc         = get_lconv();
-  pdf->fd          = fd;
-  pdf->output_cb   = output_cb;
-  pdf->output_ctx  = output_cbdata;
-  pdf->filename    = strdup(filename);
-  pdf->version     = strdup(version);
-  pdf->mode        = _PDFIO_MODE_WRITE;
-  pdf->error_cb    = error_cb;
-  pdf->error_data  = error_cbdata;
-  pdf->permissions = PDFIO_PERMISSION_ALL;
-  pdf->bufptr      = pdf->buffer;
-  pdf->bufend      = pdf->buffer + sizeof(pdf->buffer);
-
-  if (media_box)
+#ifndef _WIN32
+  // Map regular files into memory so that seeks are free and data can be used
+  // without copying...
+  if (!fstat(fd, &fileinfo) && S_ISREG(fileinfo.st_mode) && fileinfo.st_size > 0 && (mapdata = mmap(NULL, (size_t)fileinfo.st_size, PROT_READ, MAP_PRIVATE, fd, 0)) != MAP_FAILED)
   {
-    pdf->media_box = *media_box;
-  }
-  else
-  {
-    // Default to "universal" size (intersection of A4 and US Letter)
-    pdf->media_box.x2 = 210.0 * 72.0f / 25.4f;
-    pdf->media_box.y2 = 11.0f * 72.0f;
-  }
-
-  if (crop_box)
-  {
-    pdf->crop_box = *crop_box;
-  }
-  else
-  {
-    // Default to "universal" size (intersection of A4 and US Letter)
-    pdf->crop_box.x2 = 210.0 * 72.0f / 25.4f;
-    pdf->crop_box.y2 = 11.0f * 72.0f;
+    PDFIO_DEBUG("pdfioFileOpen: Mapped %lu bytes.\n", (unsigned long)fileinfo.st_size);
+
+    memdata = (const char *)mapdata;
+    memsize = (size_t)fileinfo.st_size;
+
+    close(fd);
+    fd = -1;
   }
+#endif // !_WIN32
 
-  // Write a standard PDF header...
-  if (!_pdfioFilePrintf(pdf, "%%PDF-%s\n%%\342\343\317\323\n", version))
-    goto error;
+  return (open_common(filename, fd, memdata, memsize, memdata != NULL, /*input_cb*/NULL, /*input_ctx*/NULL, /*input_size*/0, password_cb, password_cbdata, error_cb, error_cbdata));
+}
 
-  // Create the pages object...
-  if ((dict = pdfioDictCreate(pdf)) == NULL)
-    goto error;
 
-  pdfioDictSetName(dict, "Type", "Pages");
+//
+// 'pdfioFileOpenIO()' - Open a PDF file for reading using an input callback.
+//
+// This function opens an existing PDF file whose data is read by calling the
+// "input_cb" function, for example to read a PDF file using ranged requests
+// to a remote server:
+//
+// ```
+// ssize_t
+// my_input_cb(void *ctx, off_t offset, void *buffer, size_t bytes)
+// {
+// ... read up to "bytes" bytes at "offset" into "buffer" ...
+// ... return the number of bytes read, 0 at end-of-file, or -1 on error ...
+// }
+// ```
+//
+// The "size" argument specifies the total size of the PDF file in bytes.
+//
+// File data is read in large blocks that are kept in a cache, adjacent reads
+// are combined into a single callback, and the trailer, cross-reference data,
+// and stream data are requested ahead of time so that a PDF file can be opened
+// and read with few calls to the callback.  The callback may be called from
+// multiple threads, one at a time, when @link pdfioFileSetConcurrent@ is used.
+//
+// The "password_cb" and "password_cbdata" arguments specify a password callback
+// and its data pointer for PDF files that use one of the standard Adobe
+// "security" handlers.  The callback returns a password string or `NULL` to
+// cancel the open.  If `NULL` is specified for the callback function and the
+// PDF file requires a password, the open will always fail.
+//
+// The "error_cb" and "error_cbdata" arguments specify an error handler callback
+// and its data pointer - if `NULL` the default error handler is used that
+// writes error messages to `stderr`.
+//
 
-  if ((pdf->pages_obj = pdfioFileCreateObj(pdf, dict)) == NULL)
-    goto error;
+pdfio_file_t *				// O - PDF file or `NULL` on error
+pdfioFileOpenIO(
+    pdfio_input_cb_t    input_cb,	// I - Input callback
+    void                *input_ctx,	// I - Input callback context
+    off_t               size,		// I - Size of PDF file in bytes
+    pdfio_password_cb_t password_cb,	// I - Password callback or `NULL` for none
+    void                *password_cbdata,
+					// I - Password callback data, if any
+    pdfio_error_cb_t    error_cb,	// I - Error callback or `NULL` for default
+    void                *error_cbdata)	// I - Error callback data, if any
+{
+  PDFIO_DEBUG("pdfioFileOpenIO(input_cb=%p, input_ctx=%p, size=%ld, password_cb=%p, password_cbdata=%p, error_cb=%p, error_cbdata=%p)\n", (void *)input_cb, input_ctx, (long)size, (void *)password_cb, (void *)password_cbdata, (void *)error_cb, (void *)error_cbdata);
 
-  // Create the info object...
-  if ((dict = pdfioDictCreate(pdf)) == NULL)
-    goto error;
+  // Range check input...
+  if (!input_cb || size <= 0)
+    return (NULL);
 
-  pdfioDictSetDate(dict, "CreationDate", time(NULL));
-  pdfioDictSetString(dict, "Producer", "pdfio/" PDFIO_VERSION);
+  if (!error_cb)
+  {
+    error_cb     = _pdfioFileDefaultError;
+    error_cbdata = NULL;
+  }
 
-  if ((pdf->info_obj = pdfioFileCreateObj(pdf, dict)) == NULL)
-    goto error;
+  return (open_common("input.pdf", /*fd*/-1, /*memdata*/NULL, /*memsize*/0, /*memmapped*/false, input_cb, input_ctx, size, password_cb, password_cbdata, error_cb, error_cbdata));
+}
 
-  // Create the root object...
-  if ((dict = pdfioDictCreate(pdf)) == NULL)
-    goto error;
 
-  pdfioDictSetName(dict, "Type", "Catalog");
-  pdfioDictSetObj(dict, "Pages", pdf->pages_obj);
+//
+// 'pdfioFileOpenMemory()' - Open a PDF file in memory for reading.
+//
+// This function opens an existing PDF file that has been loaded into memory.
+// The "data" and "datalen" arguments specify the PDF file data, which is used
+// directly (without copying) and must remain valid until @link pdfioFileClose@
+// is called.
+//
+// The "password_cb" and "password_cbdata" arguments specify a password callback
+// and its data pointer for PDF files that use one of the standard Adobe
+// "security" handlers.  The callback returns a password string or `NULL` to
+// cancel the open.  If `NULL` is specified for the callback function and the
+// PDF file requires a password, the open will always fail.
+//
+// The "error_cb" and "error_cbdata" arguments specify an error handler callback
+// and its data pointer - if `NULL` the default error handler is used that
+// writes error messages to `stderr`.
+//
 
-  if ((pdf->root_obj = pdfioFileCreateObj(pdf, dict)) == NULL)
-    goto error;
+pdfio_file_t *				// O - PDF file
+pdfioFileOpenMemory(
+    const void          *data,		// I - PDF file data
+    size_t              datalen,	// I - Length of PDF file data
+    pdfio_password_cb_t password_cb,	// I - Password callback or `NULL` for none
+    void                *password_cbdata,
+					// I - Password callback data, if any
+    pdfio_error_cb_t    error_cb,	// I - Error callback or `NULL` for default
+    void                *error_cbdata)	// I - Error callback data, if any
+{
+  PDFIO_DEBUG("pdfioFileOpenMemory(data=%p, datalen=%lu, password_cb=%p, password_cbdata=%p, error_cb=%p, error_cbdata=%p)\n", data, (unsigned long)datalen, (void *)password_cb, (void *)password_cbdata, (void *)error_cb, (void *)error_cbdata);
 
-  // Create random file ID values...
-  _pdfioCryptoMakeRandom(id_value, sizeof(id_value));
+  // Range check input...
+  if (!data || datalen == 0)
+    return (NULL);
 
-  if ((pdf->id_array = pdfioArrayCreate(pdf)) != NULL)
+  if (!error_cb)
   {
-    pdfioArrayAppendBinary(pdf->id_array, id_value, sizeof(id_value));
-    pdfioArrayAppendBinary(pdf->id_array, id_value, sizeof(id_value));
+    error_cb     = _pdfioFileDefaultError;
+    error_cbdata = NULL;
   }
 
-  return (pdf);
-
-  // Common error handling code...
-  error:
-
-  pdfioFileClose(pdf);
-
-  return (NULL);
+  return (open_common("memory.pdf", /*fd*/-1, (const char *)data, datalen, /*memmapped*/false, /*input_cb*/NULL, /*input_ctx*/NULL, /*input_size*/0, password_cb, password_cbdata, error_cb, error_cbdata));
 }
 
 
 //
-// 'get_info_string()' - Get a string value from the Info dictionary.
+// 'pdfioFileOpenUpdate()' - Open a PDF file for an incremental update.
 //
-// This function also handles converting binary strings to C strings, which
-// occur in encrypted PDF files.
+// This function opens an existing PDF file so that changes can be appended to
+// it as an incremental update.  The original file data is left unchanged -
+// new and changed objects, a new cross-reference table or stream, and a new
+// trailer are written to the end of the file when @link pdfioFileClose@ is
+// called.
+//
+// Objects and pages can be read from the file and new objects and pages can
+// be created like a PDF file created with @link pdfioFileCreate@.  To save
+// changes to an object from the original file, modify its value and then call
+// @link pdfioObjClose@ to append the new value.  Changes to the document
+// information, catalog, and page tree are saved automatically.
+//
+// The "password_cb" and "password_cbdata" arguments specify a password callback
+// and its data pointer for PDF files that use one of the standard Adobe
+// "security" handlers.  The callback returns a password string or `NULL` to
+// cancel the open.  If `NULL` is specified for the callback function and the
+// PDF file requires a password, the open will always fail.  Files using 40-bit
+// RC4 or 256-bit AES encryption cannot be updated.
+//
+// The "error_cb" and "error_cbdata" arguments specify an error handler callback
+// and its data pointer - if `NULL` the default error handler is used that
+// writes error messages to `stderr`.
 //
 
-static const char *			// O - String or `NULL` if not found
-get_info_string(pdfio_file_t *pdf,	// I - PDF file
-                const char   *key)	// I - Dictionary key
+pdfio_file_t *				// O - PDF file or `NULL` on error
+pdfioFileOpenUpdate(
+    const char          *filename,	// I - Filename
+    pdfio_password_cb_t password_cb,	// I - Password callback or `NULL` for none
+    void                *password_cbdata,
+					// I - Password callback data, if any
+    pdfio_error_cb_t    error_cb,	// I - Error callback or `NULL` for default
+    void                *error_cbdata)	// I - Error callback data, if any
 {
+  pdfio_file_t	*pdf;			// PDF file
+  int		fd;			// File descriptor
+  size_t	i;			// Looping var
+  off_t		end;			// End of file
+  char		last;			// Last character in file
+  unsigned char	id_value[16],		// New file ID value
+		*id_first;		// Original file ID value
+  size_t	id_length;		// Length of original file ID value
   pdfio_dict_t	*dict;			// Info dictionary
 
 
+  PDFIO_DEBUG("pdfioFileOpenUpdate(filename=\"%s\", password_cb=%p, password_cbdata=%p, error_cb=%p, error_cbdata=%p)\n", filename, (void *)password_cb, (void *)password_cbdata, (void *)error_cb, (void *)error_cbdata);
+
   // Range check input...
-  if (!pdf || !pdf->info_obj || (dict = pdfioObjGetDict(pdf->info_obj)) == NULL)
+  if (!filename)
     return (NULL);
-  else
-    return (pdfioDictGetString(dict, key));
-}
-
-
-//
-// 'get_lconv()' - Get any locale-specific numeric information.
-//
-
-static struct lconv *			// O - Locale information or `NULL`
-get_lconv(void)
-{
-  struct lconv	*loc;			// Locale information
 
+  if (!error_cb)
+  {
+    error_cb     = _pdfioFileDefaultError;
+    error_cbdata = NULL;
+  }
 
-  if ((loc = localeconv()) != NULL)
+  // Open the file for reading and writing...
+  if ((fd = open(filename, O_RDWR | O_BINARY)) < 0)
   {
-    PDFIO_DEBUG("get_lconv: loc=%p, loc->decimal_point=\"%s\"\n", loc, loc->decimal_point);
+    pdfio_file_t temp;			// Dummy file
+    char	message[8192];		// Message string
 
-    if (!loc->decimal_point || !strcmp(loc->decimal_point, "."))
-      loc = NULL;
+    temp.filename = (char *)filename;
+    snprintf(message, sizeof(message), "Unable to open file - %s", strerror(errno));
+    (error_cb)(&temp, message, error_cbdata);
+    return (NULL);
   }
 
-  return (loc);
-}
+  if ((pdf = open_common(filename, fd, /*memdata*/NULL, /*memsize*/0, /*memmapped*/false, /*input_cb*/NULL, /*input_ctx*/NULL, /*input_size*/0, password_cb, password_cbdata, error_cb, error_cbdata)) == NULL)
+    return (NULL);
 
+  if (pdf->encryption != PDFIO_ENCRYPTION_NONE && pdf->encryption != PDFIO_ENCRYPTION_RC4_128 && pdf->encryption != PDFIO_ENCRYPTION_AES_128)
+  {
+    _pdfioFileError(pdf, "Unable to update PDF files using this type of encryption.");
+    goto error;
+  }
 
-//
-// 'load_obj_stream()' - Load an object stream.
-//
-// Object streams are Adobe's complicated solution for saving a few
-// kilobytes in an average PDF file at the expense of massively more
-// complicated reader applications.
-//
-// Each object stream starts with pairs of object numbers and offsets,
-// followed by the object values (typically dictionaries).  For
-// simplicity pdfio loads all of these values into memory so that we
-// don't later have to randomly access compressed stream data to get
-// a dictionary.
-//
+  // Load the whole page tree so that new pages can be added...
+  if (pdf->lazy_pages)
+  {
+    pdf->lazy_pages = false;
+    pdf->num_pages  = 0;
 
-static bool				// O - `true` on success, `false` on error
-load_obj_stream(pdfio_obj_t *obj)	// I - Object to load
-{
-  pdfio_stream_t	*st;		// Stream
-  _pdfio_token_t	tb;		// Token buffer/stack
-  char			buffer[32];	// Token
-  size_t		number,		// Object number
-			cur_obj,	// Current object
-			num_objs = 0;	// Number of objects
-  pdfio_obj_t		*objs[16384];	// Objects
-  int			count;		// Count of objects
+    if (!load_pages(pdf, pdf->pages_obj, 0))
+      goto error;
+  }
 
+  pdf->update_num_pages = pdf->num_pages;
 
-  PDFIO_DEBUG("load_obj_stream(obj=%p(%d))\n", obj, (int)obj->number);
+  // New objects are numbered after the original objects...
+  pdf->update_objnum = (size_t)pdfioDictGetNumber(pdf->trailer_dict, "Size");
 
-  // Open the object stream...
-  if ((st = pdfioObjOpenStream(obj, true)) == NULL)
+  for (i = 0; i < pdf->num_objs; i ++)
   {
-    _pdfioFileError(obj->pdf, "Unable to open compressed object stream %lu.", (unsigned long)obj->number);
-    return (false);
+    if (pdf->objs[i]->number >= pdf->update_objnum)
+      pdf->update_objnum = pdf->objs[i]->number + 1;
   }
 
-  count = (int)pdfioDictGetNumber(pdfioObjGetDict(obj), "N");
+  if (pdf->update_objnum == 0)
+    pdf->update_objnum = 1;
 
-  PDFIO_DEBUG("load_obj_stream: N=%d\n", count);
+  // Load the document information so it can be updated...
+  if (pdf->info_obj && !pdfioObjGetDict(pdf->info_obj))
+    pdf->info_obj = NULL;
 
-  _pdfioTokenInit(&tb, obj->pdf, (_pdfio_tconsume_cb_t)pdfioStreamConsume, (_pdfio_tpeek_cb_t)pdfioStreamPeek, st);
+  // Start the update on a new line at the end of the file...
+  if ((end = _pdfioFileSeek(pdf, -1, SEEK_END)) < 0 || _pdfioFileRead(pdf, &last, 1) != 1)
+    goto error;
 
-  // Read the object numbers from the beginning of the stream...
-  while (count > 0 && _pdfioTokenGet(&tb, buffer, sizeof(buffer)))
-  {
-    // Stop if this isn't an object number...
-    PDFIO_DEBUG("load_obj_stream: %s\n", buffer);
-    if (!isdigit(buffer[0] & 255))
-      break;
+  pdf->update        = true;
+  pdf->update_offset = end + 1;
+  pdf->update_pos    = end + 1;
+  pdf->level         = 9;
 
-    // Stop if we have too many objects...
-    if (num_objs >= (sizeof(objs) / sizeof(objs[0])))
-    {
-      _pdfioFileError(obj->pdf, "Too many compressed objects in one stream.");
-      pdfioStreamClose(st);
-      return (false);
-    }
+  _pdfioFileEndRead(pdf);
 
-    // Add the object in memory...
-    number = (size_t)strtoimax(buffer, NULL, 10);
+  if (last != '\n' && last != '\r' && !_pdfioFilePuts(pdf, "\n"))
+    goto error;
 
-    if ((objs[num_objs] = pdfioFileFindObj(obj->pdf, number)) == NULL)
-      objs[num_objs] = add_obj(obj->pdf, number, 0, 0);
+  // Default to "universal" size (intersection of A4 and US Letter) for new
+  // pages...
+  pdf->media_box.x2 = pdf->crop_box.x2 = 210.0 * 72.0f / 25.4f;
+  pdf->media_box.y2 = pdf->crop_box.y2 = 11.0f * 72.0f;
 
-    num_objs ++;
+  // Create an info object as needed...
+  if (!pdf->info_obj)
+  {
+    if ((dict = pdfioDictCreate(pdf)) == NULL)
+      goto error;
 
-    // Skip offset
-    _pdfioTokenGet(&tb, buffer, sizeof(buffer));
-    PDFIO_DEBUG("load_obj_stream: %ld at offset %s\n", (long)number, buffer);
+    pdfioDictSetString(dict, "Producer", "pdfio/" PDFIO_VERSION);
 
-    // One less compressed object...
-    count --;
+    if ((pdf->info_obj = pdfioFileCreateObj(pdf, dict)) == NULL)
+      goto error;
   }
 
-  PDFIO_DEBUG("load_obj_stream: num_objs=%lu\n", (unsigned long)num_objs);
+  // Keep the original file ID and add a new one for the update...
+  _pdfioCryptoMakeRandom(id_value, sizeof(id_value));
 
-  // Read the objects themselves...
-  for (cur_obj = 0; cur_obj < num_objs; cur_obj ++)
+  if ((id_first = pdfioArrayGetBinary(pdf->id_array, 0, &id_length)) == NULL)
   {
-    if (!_pdfioValueRead(obj->pdf, obj, &tb, &(objs[cur_obj]->value), 0))
-    {
-      _pdfioFileError(obj->pdf, "Unable to read compressed object.");
-      pdfioStreamClose(st);
-      return (false);
-    }
+    id_first  = id_value;
+    id_length = sizeof(id_value);
   }
 
-  // Close the stream and return
-  pdfioStreamClose(st);
+  if ((pdf->id_array = pdfioArrayCreate(pdf)) != NULL)
+  {
+    pdfioArrayAppendBinary(pdf->id_array, id_first, id_length);
+    pdfioArrayAppendBinary(pdf->id_array, id_value, sizeof(id_value));
+  }
 
-  return (true);
+  return (pdf);
+
+  // If we get here we had a fatal error, close without writing anything...
+  error:
+
+  pdf->mode = _PDFIO_MODE_READ;
+
+  pdfioFileClose(pdf);
+
+  return (NULL);
 }
 
 
 //
-// 'load_pages()' - Load pages in the document.
+// 'pdfioFileSetAuthor()' - Set the author for a PDF file.
 //
 
-static bool				// O - `true` on success, `false` on error
-load_pages(pdfio_file_t *pdf,		// I - PDF file
-           pdfio_obj_t  *obj,		// I - Page object
-           size_t       depth)		// I - Depth of page tree
+void
+pdfioFileSetAuthor(pdfio_file_t *pdf,	// I - PDF file
+                   const char   *value)	// I - Value
 {
-  pdfio_dict_t	*dict;			// Page object dictionary
-  const char	*type;			// Node type
-  pdfio_array_t	*kids;			// Kids array
+  if (pdf && pdf->info_obj)
+    pdfioDictSetString(pdf->info_obj->value.value.dict, "Author", pdfioStringCreate(pdf, value));
+}
 
 
-  // Range check input...
-  if (!obj)
-  {
-    _pdfioFileError(pdf, "Unable to find pages object.");
+//
+// 'pdfioFileSetCacheSize()' - Set the memory limit for cached object values.
+//
+// This function limits the memory used for the dictionaries and arrays of
+// objects loaded from a PDF file opened for reading.  When the
+// limit is exceeded, the least recently used values are freed and loaded
+// again from the file as needed.  Pass `0` for no limit, the default.
+//
+// Values are kept once an application gets them using @link pdfioObjGetArray@
+// or @link pdfioObjGetDict@.  Values that are only used internally, such as
+// the dictionaries of content streams and the other objects stored in an
+// object stream, can be freed.  Values are not freed while concurrent reading
+// is enabled with @link pdfioFileSetConcurrent@.
+//
+
+bool					// O - `true` on success, `false` otherwise
+pdfioFileSetCacheSize(
+    pdfio_file_t *pdf,			// I - PDF file
+    size_t       bytes)			// I - Maximum memory for object values or `0` for no limit
+{
+  if (!pdf)
     return (false);
-  }
 
-  // Get the object dictionary and make sure this is a Pages or Page object...
-  if ((dict = pdfioObjGetDict(obj)) == NULL)
+  if (pdf->mode != _PDFIO_MODE_READ)
   {
-    _pdfioFileError(pdf, "No dictionary for pages object.");
+    _pdfioFileError(pdf, "The object value cache is only supported when reading a PDF file.");
     return (false);
   }
 
-  if ((type = pdfioDictGetName(dict, "Type")) == NULL || (strcmp(type, "Pages") && strcmp(type, "Page")))
+  pdf->cache_limit = bytes;
+
+  return (true);
+}
+
+
+//
+// 'pdfioFileSetCodec()' - Set the Flate compression and decompression functions for a PDF file.
+//
+// This function sets callbacks that replace the built-in ZLIB functions for
+// compressing and decompressing Flate streams, for example to use a faster
+// library.  Both callbacks work on whole buffers of zlib (RFC 1950) data and
+// return the number of bytes written to "dst", `0` if "dst" is too small, or
+// `-1` on error.  PDFio retries with a larger buffer when `0` is returned.
+//
+// The "deflate_cb" callback is called from multiple threads when the
+// `PDFIO_OPTION_PARALLEL` option is set, and the "inflate_cb" callback is
+// called from multiple threads when concurrent reading is enabled.  Streams
+// whose data does not fit in memory are always decompressed using ZLIB, and
+// the built-in functions are used if the "inflate_cb" callback fails.
+//
+// Pass `NULL` for either callback to use the built-in ZLIB function.
+//
+
+bool					// O - `true` on success, `false` otherwise
+pdfioFileSetCodec(
+    pdfio_file_t       *pdf,		// I - PDF file
+    pdfio_deflate_cb_t deflate_cb,	// I - Compression callback or `NULL` for default
+    pdfio_inflate_cb_t inflate_cb,	// I - Decompression callback or `NULL` for default
+    void               *cb_data)	// I - Callback data
+{
+  if (!pdf)
     return (false);
 
-  // If there is a Kids array, then this is a parent node and we have to look
-  // at the child objects...
-  if ((kids = pdfioDictGetArray(dict, "Kids")) != NULL)
-  {
-    // Load the child objects...
-    size_t	i,			// Looping var
-		num_kids;		// Number of elements in array
+  pdf->deflate_cb = deflate_cb;
+  pdf->inflate_cb = inflate_cb;
+  pdf->codec_data = cb_data;
 
-    if (depth >= PDFIO_MAX_DEPTH)
-    {
-      _pdfioFileError(pdf, "Depth of pages objects too great to load.");
-      return (false);
-    }
+  return (true);
+}
 
-    for (i = 0, num_kids = pdfioArrayGetSize(kids); i < num_kids; i ++)
-    {
-      if (!load_pages(pdf, pdfioArrayGetObj(kids, i), depth + 1))
-        return (false);
-    }
-  }
-  else
-  {
-    // Add this page...
-    if (pdf->num_pages >= pdf->alloc_pages)
-    {
-      pdfio_obj_t **temp = (pdfio_obj_t **)realloc(pdf->pages, (pdf->alloc_pages + 32) * sizeof(pdfio_obj_t *));
 
-      if (!temp)
-      {
-        _pdfioFileError(pdf, "Unable to allocate memory for pages.");
-        return (false);
-      }
+//
+// 'pdfioFileSetCompression()' - Set the default Flate compression level and strategy for a PDF file.
+//
+// This function sets the default compression level and strategy used for new
+// Flate streams in a PDF file being written.  The "level" argument ranges from
+// `0` (no compression, fastest) to `9` (best compression, slowest).  The
+// default is level `9` with the `PDFIO_STRATEGY_DEFAULT` strategy.  Use the
+// @link pdfioStreamSetCompression@ function to override these values for a
+// single stream.
+//
 
-      pdf->alloc_pages += 32;
-      pdf->pages       = temp;
-    }
+bool					// O - `true` on success, `false` otherwise
+pdfioFileSetCompression(
+    pdfio_file_t     *pdf,		// I - PDF file
+    int              level,		// I - Compression level (`0` to `9`)
+    pdfio_strategy_t strategy)		// I - Compression strategy
+{
+  if (!pdf)
+    return (false);
 
-    pdf->pages[pdf->num_pages ++] = obj;
+  if (pdf->mode != _PDFIO_MODE_WRITE)
+  {
+    _pdfioFileError(pdf, "Compression can only be set when writing a PDF file.");
+    return (false);
+  }
+
+  if (level < 0 || level > 9 || strategy < PDFIO_STRATEGY_DEFAULT || strategy > PDFIO_STRATEGY_RLE)
+  {
+    _pdfioFileError(pdf, "Bad compression level or strategy.");
+    return (false);
   }
 
+  pdf->level    = level;
+  pdf->strategy = strategy;
+
   return (true);
 }
 
 
 //
-// 'load_xref()' - Load an XREF table...
+// 'pdfioFileSetConcurrent()' - Enable or disable concurrent reading of a PDF file.
+//
+// This function enables or disables concurrent reading of a PDF file that was
+// opened with @link pdfioFileOpen@ or @link pdfioFileOpenMemory@.  When
+// enabled, multiple threads can load objects and read streams from the same
+// PDF file at the same time, for example to extract text from different pages
+// in parallel.  Each stream reads from its own position in the file and the
+// shared objects, strings, and file buffer are protected by a lock.
+//
+// Streams and objects are still owned by the thread that uses them - two
+// threads must not read from the same `pdfio_stream_t` at the same time, and
+// the error callback can be called from any thread.  Dictionaries and arrays
+// must not be changed while other threads are reading the PDF file.
+//
+// > *Note*: This function must be called before any other threads use the PDF
+// > file and when no streams are open.
 //
 
-static bool				// O - `true` on success, `false` on failure
-load_xref(
-    pdfio_file_t        *pdf,		// I - PDF file
-    off_t               xref_offset,	// I - Offset to xref
-    pdfio_password_cb_t password_cb,	// I - Password callback or `NULL` for none
-    void                *password_data)	// I - Password callback data, if any
+bool					// O - `true` on success, `false` otherwise
+pdfioFileSetConcurrent(
+    pdfio_file_t *pdf,			// I - PDF file
+    bool         concurrent)		// I - `true` to allow concurrent reads, `false` otherwise
 {
-  bool		done = false;		// Are we done?
-  char		line[1024],		// Line from file
-		*ptr;			// Pointer into line
-  _pdfio_value_t trailer;		// Trailer dictionary
-  intmax_t	number,			// Object number
-		num_objects,		// Number of objects
-		offset;			// Offset in file
-  int		generation;		// Generation number
-  _pdfio_token_t tb;			// Token buffer/stack
-  off_t		line_offset;		// Offset to start of line
+  if (!pdf)
+    return (false);
 
+  if (pdf->mode != _PDFIO_MODE_READ)
+  {
+    _pdfioFileError(pdf, "Concurrent access is only supported when reading a PDF file.");
+    return (false);
+  }
 
-  while (!done)
+  if (pdf->current_obj)
   {
-    if (_pdfioFileSeek(pdf, xref_offset, SEEK_SET) != xref_offset)
-    {
-      _pdfioFileError(pdf, "Unable to seek to start of xref table.");
-      return (false);
-    }
+    _pdfioFileError(pdf, "Unable to change concurrent access while object %u is open.", (unsigned)pdf->current_obj->number);
+    return (false);
+  }
 
-    do
-    {
-      line_offset = _pdfioFileTell(pdf);
+  if (concurrent && !pdf->have_mutex)
+  {
+    // Create the recursive mutex used to protect the shared file state...
+#ifdef _WIN32
+    InitializeCriticalSection(&pdf->mutex);
 
-      if (!_pdfioFileGets(pdf, line, sizeof(line)))
-      {
-	_pdfioFileError(pdf, "Unable to read start of xref table.");
-	return (false);
-      }
-    }
-    while (!line[0]);
+#else
+    pthread_mutexattr_t	attr;		// Mutex attributes
+    int			error;		// Error code, if any
 
-    PDFIO_DEBUG("load_xref: line_offset=%lu, line='%s'\n", (unsigned long)line_offset, line);
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    error = pthread_mutex_init(&pdf->mutex, &attr);
+    pthread_mutexattr_destroy(&attr);
 
-    if (isdigit(line[0] & 255) && strlen(line) > 4 && (!strcmp(line + strlen(line) - 4, " obj") || ((ptr = strstr(line, " obj")) != NULL && ptr[4] == '<')))
+    if (error)
     {
-      // Cross-reference stream
-      pdfio_obj_t	*obj;		// Object
-      size_t		i;		// Looping var
-      pdfio_array_t	*index_array;	// Index array
-      size_t		index_n,	// Current element in array
-			index_count,	// Number of values in index array
-			count;		// Number of objects in current pairing
-      pdfio_array_t	*w_array;	// W array
-      size_t		w[3];		// Size of each cross-reference field
-      size_t		w_2,		// Offset to second field
-			w_3;		// Offset to third field
-      size_t		w_total;	// Total length
-      pdfio_stream_t	*st;		// Stream
-      unsigned char	buffer[32];	// Read buffer
-      size_t		num_sobjs = 0,	// Number of object streams
-			sobjs[16384];	// Object streams to load
-      pdfio_obj_t	*current;	// Current object
+      _pdfioFileError(pdf, "Unable to create mutex - %s", strerror(error));
+      return (false);
+    }
+#endif // _WIN32
 
-      if ((number = strtoimax(line, &ptr, 10)) < 1)
-      {
-	_pdfioFileError(pdf, "Bad xref table header '%s'.", line);
-	return (false);
-      }
+    pdf->have_mutex = true;
+  }
 
-      if ((generation = (int)strtol(ptr, &ptr, 10)) < 0 || (generation > 65535 && number != 0))
-      {
-	_pdfioFileError(pdf, "Bad xref table header '%s'.", line);
-	return (false);
-      }
+  pdf->concurrent = concurrent;
 
-      while (isspace(*ptr & 255))
-	ptr ++;
+  return (true);
+}
 
-      if (strncmp(ptr, "obj", 3))
-      {
-	_pdfioFileError(pdf, "Bad xref table header '%s'.", line);
-	return (false);
-      }
 
-      if (_pdfioFileSeek(pdf, line_offset + ptr + 3 - line, SEEK_SET) < 0)
-      {
-        _pdfioFileError(pdf, "Unable to seek to xref object %lu %u.", (unsigned long)number, (unsigned)generation);
-        return (false);
-      }
+//
+// 'pdfioFileSetCreationDate()' - Set the creation date for a PDF file.
+//
 
-      PDFIO_DEBUG("load_xref: Loading object %lu %u.\n", (unsigned long)number, (unsigned)generation);
+void
+pdfioFileSetCreationDate(
+    pdfio_file_t *pdf,			// I - PDF file
+    time_t       value)			// I - Value
+{
+  if (pdf && pdf->info_obj)
+    pdfioDictSetDate(pdf->info_obj->value.value.dict, "CreationDate", value);
+}
 
-      if ((obj = add_obj(pdf, (size_t)number, (unsigned short)generation, xref_offset)) == NULL)
-      {
-        _pdfioFileError(pdf, "Unable to allocate memory for object.");
-        return (false);
-      }
 
-      _pdfioTokenInit(&tb, pdf, (_pdfio_tconsume_cb_t)_pdfioFileConsume, (_pdfio_tpeek_cb_t)_pdfioFilePeek, pdf);
+//
+// 'pdfioFileSetCreator()' - Set the creator string for a PDF file.
+//
 
-      if (!_pdfioValueRead(pdf, obj, &tb, &trailer, 0))
-      {
-        _pdfioFileError(pdf, "Unable to read cross-reference stream dictionary.");
-        return (false);
-      }
-      else if (trailer.type != PDFIO_VALTYPE_DICT)
-      {
-	_pdfioFileError(pdf, "Cross-reference stream does not have a dictionary.");
-	return (false);
-      }
+void
+pdfioFileSetCreator(pdfio_file_t *pdf,	// I - PDF file
+                    const char   *value)// I - Value
+{
+  if (pdf && pdf->info_obj)
+    pdfioDictSetString(pdf->info_obj->value.value.dict, "Creator", pdfioStringCreate(pdf, value));
+}
 
-      obj->value = trailer;
 
-      if (!_pdfioTokenGet(&tb, line, sizeof(line)) || strcmp(line, "stream"))
-      {
-        _pdfioFileError(pdf, "Unable to get stream after xref dictionary.");
-        return (false);
-      }
+//
+// 'pdfioFileSetKeywords()' - Set the keywords string for a PDF file.
+//
 
-      PDFIO_DEBUG("load_xref: tb.bufptr=%p, tb.bufend=%p, tb.bufptr[0]=0x%02x, tb.bufptr[0]=0x%02x\n", tb.bufptr, tb.bufend, tb.bufptr[0], tb.bufptr[1]);
-      if (tb.bufptr && tb.bufptr < tb.bufend && (tb.bufptr[0] == 0x0d || tb.bufptr[0] == 0x0a))
-	tb.bufptr ++;			// Skip trailing CR or LF after token
+void
+pdfioFileSetKeywords(
+    pdfio_file_t *pdf,			// I - PDF file
+    const char   *value)		// I - Value
+{
+  if (pdf && pdf->info_obj)
+    pdfioDictSetString(pdf->info_obj->value.value.dict, "Keywords", pdfioStringCreate(pdf, value));
+}
 
-      _pdfioTokenFlush(&tb);
 
-      obj->stream_offset = _pdfioFileTell(pdf);
+//
+// 'pdfioFileSetOptions()' - Set the output options for a PDF file.
+//
+// This function sets the output options for a PDF file being written.  The
+// following options are supported:
+//
+// - `PDFIO_OPTION_OBJSTREAMS`: Write objects without streams to compressed
+//   object streams and write a cross-reference stream instead of a
+//   cross-reference table.  Requires PDF 1.5 or later.
+// - `PDFIO_OPTION_DEDUPLICATE`: Share stream objects such as images, fonts,
+//   and ICC profiles that are copied from other PDF files using
+//   @link pdfioObjCopy@ or @link pdfioPageCopy@ when their dictionary and
+//   stream data match a previously copied object.
+// - `PDFIO_OPTION_SUBSET_FONTS`: Embed only the glyphs that are needed by
+//   Unicode fonts created with @link pdfioFileCreateFontObjFromFile@.  The
+//   font data is written when the PDF file is closed and includes every
+//   character shown with the Unicode text functions such as
+//   @link pdfioContentTextShow@.
+// - `PDFIO_OPTION_PARALLEL`: Compress Flate streams using multiple threads.
+//   Stream data is compressed in the background after the stream is closed
+//   and the stream object is written to the PDF file once compression is
+//   complete, so stream objects may appear in the PDF file in a different
+//   order.
+// - `PDFIO_OPTION_LINEARIZE`: Write a linearized ("Fast Web View") PDF file.
+//   Objects are written to a temporary file and then reordered when the PDF
+//   file is closed so that the first page can be displayed before the rest of
+//   the file has been loaded.  This option must be set before any objects are
+//   written, cannot be combined with `PDFIO_OPTION_OBJSTREAMS` or encryption,
+//   and cannot be cleared once set.
+// - `PDFIO_OPTION_STREAMING`: Free the page and content stream objects
+//   created by @link pdfioFileCreatePage@ once they have been written, so
+//   that memory use stays bounded when writing many pages.  The page
+//   dictionary passed to @link pdfioFileCreatePage@ is copied and may be
+//   reused for the next page.  Only the offset of each freed object is kept
+//   for the cross-reference table - page objects are freed once their node of
+//   the page tree has been written and are not available from
+//   @link pdfioFileGetPage@, and content stream objects are freed when the
+//   stream is closed.  Page objects are kept when all pages are written to a
+//   single page tree node (see @link pdfioFileSetPageFanout@), and only the
+//   dictionaries are freed when appending an incremental update.  This option
+//   must be set before any pages are added, cannot be changed once pages have
+//   been added, and cannot be combined with `PDFIO_OPTION_LINEARIZE`.
+//
+// Options only apply to objects that are closed after this function is called.
+//
 
-      if ((index_array = pdfioDictGetArray(trailer.value.dict, "Index")) != NULL)
-        index_count = index_array->num_values;
-      else
-        index_count = 1;
+bool					// O - `true` on success, `false` otherwise
+pdfioFileSetOptions(
+    pdfio_file_t   *pdf,		// I - PDF file
+    pdfio_option_t options)		// I - Output options
+{
+  if (!pdf)
+    return (false);
 
-      if ((w_array = pdfioDictGetArray(trailer.value.dict, "W")) == NULL)
-      {
-	_pdfioFileError(pdf, "Cross-reference stream does not have required W key.");
-	return (false);
-      }
+  if (pdf->mode != _PDFIO_MODE_WRITE)
+  {
+    _pdfioFileError(pdf, "Output options can only be set when writing a PDF file.");
+    return (false);
+  }
 
-      w[0]    = (size_t)pdfioArrayGetNumber(w_array, 0);
-      w[1]    = (size_t)pdfioArrayGetNumber(w_array, 1);
-      w[2]    = (size_t)pdfioArrayGetNumber(w_array, 2);
-      w_total = w[0] + w[1] + w[2];
-      w_2     = w[0];
-      w_3     = w[0] + w[1];
+  if ((options & PDFIO_OPTION_OBJSTREAMS) && strcmp(pdf->version, "1.5") < 0)
+  {
+    _pdfioFileError(pdf, "Object streams require PDF 1.5 or later.");
+    return (false);
+  }
 
-      if (w[1] == 0 || w[2] > 4 || w[0] > sizeof(buffer) || w[1] > sizeof(buffer) || w[2] > sizeof(buffer) || w_total > sizeof(buffer))
-      {
-	_pdfioFileError(pdf, "Cross-reference stream has invalid W key [%u %u %u].", (unsigned)w[0], (unsigned)w[1], (unsigned)w[2]);
-	return (false);
-      }
+  if (((options ^ pdf->options) & PDFIO_OPTION_STREAMING) && pdf->num_pages > pdf->update_num_pages)
+  {
+    _pdfioFileError(pdf, "Streaming output must be set before adding pages.");
+    return (false);
+  }
 
-      if ((st = pdfioObjOpenStream(obj, true)) == NULL)
-      {
-	_pdfioFileError(pdf, "Unable to open cross-reference stream.");
+  if (options & PDFIO_OPTION_LINEARIZE)
+  {
+    if (options & PDFIO_OPTION_STREAMING)
+    {
+      _pdfioFileError(pdf, "Linearized PDF files cannot use streaming output.");
+      return (false);
+    }
+
+    if (options & PDFIO_OPTION_OBJSTREAMS)
+    {
+      _pdfioFileError(pdf, "Linearized PDF files cannot use object streams.");
+      return (false);
+    }
+
+    if (!pdf->linearize && !begin_linearized(pdf))
+      return (false);
+  }
+  else if (pdf->linearize)
+  {
+    if (options & PDFIO_OPTION_STREAMING)
+    {
+      _pdfioFileError(pdf, "Linearized PDF files cannot use streaming output.");
+      return (false);
+    }
+
+    // Objects have already been written to the temporary file...
+    options |= PDFIO_OPTION_LINEARIZE;
+  }
+
+  pdf->options = options;
+
+  return (true);
+}
+
+
+//
+// 'pdfioFileSetPageFanout()' - Set the maximum number of kids in each page tree node.
+//
+// This function sets the maximum number of pages or page tree nodes listed by
+// each node of the page tree in a PDF file being written.  Documents with more
+// pages than the fan-out are written with a balanced page tree, which allows
+// readers to find any page without loading a single huge "Kids" array.  The
+// default fan-out is 32 - a value of `0` writes all of the pages to a single
+// page tree node.
+//
+// The fan-out must be set before any pages are added to the PDF file and is
+// not used when appending an incremental update, where new pages are added to
+// the original page tree.
+//
+
+bool					// O - `true` on success, `false` otherwise
+pdfioFileSetPageFanout(
+    pdfio_file_t *pdf,			// I - PDF file
+    size_t       fanout)		// I - Maximum number of kids (`0` for a single node, `2` or more otherwise)
+{
+  if (!pdf)
+    return (false);
+
+  if (pdf->mode != _PDFIO_MODE_WRITE)
+  {
+    _pdfioFileError(pdf, "Page tree fan-out can only be set when writing a PDF file.");
+    return (false);
+  }
+
+  if (pdf->num_pages > pdf->update_num_pages)
+  {
+    _pdfioFileError(pdf, "Page tree fan-out must be set before adding pages.");
+    return (false);
+  }
+
+  if (fanout == 1)
+  {
+    _pdfioFileError(pdf, "Bad page tree fan-out %lu.", (unsigned long)fanout);
+    return (false);
+  }
+
+  pdf->page_fanout = fanout;
+
+  return (true);
+}
+
+
+//
+// 'pdfioFileSetPermissions()' - Set the PDF permissions, encryption mode, and passwords.
+//
+// This function sets the PDF usage permissions, encryption mode, and
+// passwords.
+//
+// > *Note*: This function must be called before creating or copying any
+// > objects.  Due to fundamental limitations in the PDF format, PDF encryption
+// > offers little protection from disclosure.  Permissions are not enforced in
+// > any meaningful way.
+//
+
+bool					// O - `true` on success, `false` otherwise
+pdfioFileSetPermissions(
+    pdfio_file_t       *pdf,		// I - PDF file
+    pdfio_permission_t permissions,	// I - Use permissions
+    pdfio_encryption_t encryption,	// I - Type of encryption to use
+    const char         *owner_password,	// I - Owner password, if any
+    const char         *user_password)	// I - User password, if any
+{
+  if (!pdf)
+    return (false);
+
+  if (pdf->update)
+  {
+    _pdfioFileError(pdf, "Unable to change the permissions or encryption of an existing PDF file.");
+    return (false);
+  }
+
+  if (pdf->num_objs > 3)		// First three objects are pages, info, and root
+  {
+    _pdfioFileError(pdf, "You must call pdfioFileSetPermissions before adding any objects.");
+    return (false);
+  }
+
+  if (pdf->linearize && encryption != PDFIO_ENCRYPTION_NONE)
+  {
+    _pdfioFileError(pdf, "Linearized PDF files cannot be encrypted.");
+    return (false);
+  }
+
+  if (encryption == PDFIO_ENCRYPTION_NONE)
+    return (true);
+
+  return (_pdfioCryptoLock(pdf, permissions, encryption, owner_password, user_password));
+}
+
+
+//
+// 'pdfioFileSetPrecision()' - Set the precision of real numbers written to a PDF file.
+//
+// This function sets the maximum number of decimal places used for real
+// numbers written to a PDF file, including numbers in content streams written
+// with the `pdfioContent` functions.  Numbers are always written in a
+// locale-independent fixed-point notation with trailing zeros removed.
+//
+// The default precision of `PDFIO_PRECISION_DEFAULT` (`-1`) writes up to 6
+// significant digits, for example "123457000" for the number 123456789.
+// Values from `0` to `17` round to the specified number of decimal places and
+// up to 17 significant digits, for example a precision of `2` writes "1.23"
+// for the number 1.23456.  Neither reads back as the same value in general.
+//
+// A precision of `PDFIO_PRECISION_SHORTEST` (`-2`) writes the shortest string
+// that reads back as the same value, with up to 17 significant digits and as
+// many decimal places as needed.
+//
+
+bool					// O - `true` on success, `false` otherwise
+pdfioFileSetPrecision(
+    pdfio_file_t *pdf,			// I - PDF file
+    int          precision)		// I - Number of decimal places (`0` to `17`), `PDFIO_PRECISION_DEFAULT`, or `PDFIO_PRECISION_SHORTEST`
+{
+  if (!pdf)
+    return (false);
+
+  if (pdf->mode != _PDFIO_MODE_WRITE)
+  {
+    _pdfioFileError(pdf, "Precision can only be set when writing a PDF file.");
+    return (false);
+  }
+
+  if (precision < PDFIO_PRECISION_SHORTEST || precision > 17)
+  {
+    _pdfioFileError(pdf, "Bad precision %d.", precision);
+    return (false);
+  }
+
+  pdf->precision = precision;
+
+  return (true);
+}
+
+
+//
+// 'pdfioFileSetSpanCallback()' - Set a callback for tracing operations on a PDF file.
+//
+// This function sets a callback that is called with "begin" set to `true`
+// before and `false` after reading, writing, or seeking in the file, loading
+// an object value or compressed object stream, Flate compression or
+// decompression, or encryption/decryption.  Spans can be nested, for example
+// reads happen while an object is being loaded.
+//
+// The callback may be called from any thread when concurrent reading is
+// enabled with @link pdfioFileSetConcurrent@ or when using the
+// `PDFIO_OPTION_PARALLEL` output option.  Pass `NULL` to remove the callback.
+//
+
+void
+pdfioFileSetSpanCallback(
+    pdfio_file_t    *pdf,		// I - PDF file
+    pdfio_span_cb_t cb,			// I - Span callback or `NULL` for none
+    void            *cb_data)		// I - Callback data
+{
+  if (!pdf)
+    return;
+
+  pdf->span_cb   = cb;
+  pdf->span_data = cb_data;
+}
+
+
+//
+// 'pdfioFileSetSubject()' - Set the subject for a PDF file.
+//
+
+void
+pdfioFileSetSubject(
+    pdfio_file_t *pdf,			// I - PDF file
+    const char   *value)		// I - Value
+{
+  if (pdf && pdf->info_obj)
+    pdfioDictSetString(pdf->info_obj->value.value.dict, "Subject", pdfioStringCreate(pdf, value));
+}
+
+
+//
+// 'pdfioFileSetTitle()' - Set the title for a PDF file.
+//
+
+void
+pdfioFileSetTitle(pdfio_file_t *pdf,	// I - PDF file
+                  const char   *value)	// I - Value
+{
+  if (pdf && pdf->info_obj)
+    pdfioDictSetString(pdf->info_obj->value.value.dict, "Title", pdfioStringCreate(pdf, value));
+}
+
+
+//
+// 'add_obj()' - Add an object to a file.
+//
+// Objects are appended to the objects array and sorted when needed by
+// @link pdfioFileGetObj@.  Object numbers that are close to the number of
+// objects are stored in a directly-indexed table, with a sorted array of
+// "sparse" objects for any others.
+//
+
+static pdfio_obj_t *			// O - Object
+add_obj(pdfio_file_t   *pdf,		// I - PDF file
+	size_t         number,		// I - Object number
+	unsigned short generation,	// I - Object generation
+	off_t          offset)		// I - Offset in file
+{
+  pdfio_obj_t	*obj;			// Object
+  size_t	i, j,			// Looping vars
+		sorted;			// Number of sorted sparse objects
+
+
+  // Expand the objects array as needed
+  if (pdf->num_objs >= pdf->alloc_objs)
+  {
+    size_t	alloc_objs = pdf->alloc_objs ? 2 * pdf->alloc_objs : 32;
+					// New allocation
+    pdfio_obj_t	**temp = (pdfio_obj_t **)realloc(pdf->objs, alloc_objs * sizeof(pdfio_obj_t *));
+					// New objects array
+
+    if (!temp)
+    {
+      _pdfioFileError(pdf, "Unable to allocate memory for object - %s", strerror(errno));
+      return (NULL);
+    }
+
+    pdf->objs       = temp;
+    pdf->alloc_objs = alloc_objs;
+  }
+
+  // Expand the object number index as needed, limiting the size to roughly
+  // twice the number of objects...
+  if (number >= pdf->alloc_objnums && number < (2 * pdf->num_objs + 1024))
+  {
+    size_t	alloc_objnums = pdf->alloc_objnums ? pdf->alloc_objnums : 1024;
+					// New allocation
+    pdfio_obj_t	**temp;			// New index
+
+    while (alloc_objnums <= number)
+      alloc_objnums *= 2;
+
+    if ((temp = (pdfio_obj_t **)realloc(pdf->objnums, alloc_objnums * sizeof(pdfio_obj_t *))) == NULL)
+    {
+      _pdfioFileError(pdf, "Unable to allocate memory for object - %s", strerror(errno));
+      return (NULL);
+    }
+
+    memset(temp + pdf->alloc_objnums, 0, (alloc_objnums - pdf->alloc_objnums) * sizeof(pdfio_obj_t *));
+
+    pdf->objnums       = temp;
+    pdf->alloc_objnums = alloc_objnums;
+
+    // Move any sparse objects that now fit in the index, keeping the order of
+    // the rest...
+    for (i = 0, j = 0, sorted = 0; i < pdf->num_sparse_objs; i ++)
+    {
+      if (pdf->sparse_objs[i]->number < alloc_objnums)
+      {
+        pdf->objnums[pdf->sparse_objs[i]->number] = pdf->sparse_objs[i];
+      }
+      else
+      {
+        if (i < pdf->sorted_sparse_objs)
+          sorted ++;
+
+        pdf->sparse_objs[j ++] = pdf->sparse_objs[i];
+      }
+    }
+
+    pdf->num_sparse_objs    = j;
+    pdf->sorted_sparse_objs = sorted;
+  }
+  else if (number >= pdf->alloc_objnums && pdf->num_sparse_objs >= pdf->alloc_sparse_objs)
+  {
+    // Expand the sparse objects array...
+    size_t	alloc_sparse_objs = pdf->alloc_sparse_objs ? 2 * pdf->alloc_sparse_objs : 32;
+					// New allocation
+    pdfio_obj_t **temp = (pdfio_obj_t **)realloc(pdf->sparse_objs, alloc_sparse_objs * sizeof(pdfio_obj_t *));
+					// New sparse objects array
+
+    if (!temp)
+    {
+      _pdfioFileError(pdf, "Unable to allocate memory for object - %s", strerror(errno));
+      return (NULL);
+    }
+
+    pdf->sparse_objs       = temp;
+    pdf->alloc_sparse_objs = alloc_sparse_objs;
+  }
+
+  // Allocate memory for the object...
+  if ((obj = (pdfio_obj_t *)calloc(1, sizeof(pdfio_obj_t))) == NULL)
+  {
+    _pdfioFileError(pdf, "Unable to allocate memory for object - %s", strerror(errno));
+    return (NULL);
+  }
+
+  obj->pdf        = pdf;
+  obj->number     = number;
+  obj->generation = generation;
+  obj->offset     = offset;
+
+  PDFIO_DEBUG("add_obj: obj=%p, ->pdf=%p, ->number=%lu, ->offset=%lu\n", obj, pdf, (unsigned long)obj->number, (unsigned long)offset);
+
+  // Append object to the array, noting whether we need to sort later...
+  if (pdf->num_objs > 0 && number < pdf->objs[pdf->num_objs - 1]->number)
+    pdf->sort_objs = true;
+
+  pdf->objs[pdf->num_objs ++] = obj;
+
+  // Then add it to the index or sparse array...
+  if (number < pdf->alloc_objnums)
+  {
+    pdf->objnums[number] = obj;
+  }
+  else
+  {
+    // Append sparse objects, which are sorted when they are first looked up
+    // after being added out of order...
+    PDFIO_DEBUG("add_obj: Appending sparse object at %lu\n", (unsigned long)pdf->num_sparse_objs);
+
+    if (pdf->sorted_sparse_objs == pdf->num_sparse_objs && (pdf->num_sparse_objs == 0 || number > pdf->sparse_objs[pdf->num_sparse_objs - 1]->number))
+      pdf->sorted_sparse_objs ++;
+
+    pdf->sparse_objs[pdf->num_sparse_objs ++] = obj;
+  }
+
+  return (obj);
+}
+
+
+//
+// 'add_objstm_idx()' - Save the object numbers and offsets in an object stream.
+//
+// The "entries" array is owned by the index on success.
+//
+
+static bool				// O - `true` on success, `false` on failure
+add_objstm_idx(pdfio_file_t *pdf,	// I - PDF file
+               size_t       number,	// I - Object stream number
+               size_t       first,	// I - Offset of first object
+               size_t       count,	// I - Number of objects
+               size_t       *entries)	// I - Object numbers and offsets
+{
+  size_t		left,		// Left side of search
+			right,		// Right side of search
+			current;	// Current element
+  _pdfio_objstm_t	*idx;		// New index
+
+
+  // Find where the index goes, ignoring duplicates...
+  for (left = 0, right = pdf->num_objstm_idx; left < right;)
+  {
+    current = (left + right) / 2;
+
+    if (number == pdf->objstm_idx[current].number)
+      return (false);
+    else if (number > pdf->objstm_idx[current].number)
+      left = current + 1;
+    else
+      right = current;
+  }
+
+  // Expand the indices as needed...
+  if (pdf->num_objstm_idx >= pdf->alloc_objstm_idx)
+  {
+    size_t		alloc_objstm_idx = pdf->alloc_objstm_idx ? 2 * pdf->alloc_objstm_idx : 16;
+					// New number of indices
+    _pdfio_objstm_t	*temp = (_pdfio_objstm_t *)realloc(pdf->objstm_idx, alloc_objstm_idx * sizeof(_pdfio_objstm_t));
+					// New indices
+
+    if (!temp)
+      return (false);
+
+    pdf->objstm_idx       = temp;
+    pdf->alloc_objstm_idx = alloc_objstm_idx;
+  }
+
+  if (left < pdf->num_objstm_idx)
+    memmove(pdf->objstm_idx + left + 1, pdf->objstm_idx + left, (pdf->num_objstm_idx - left) * sizeof(_pdfio_objstm_t));
+
+  idx          = pdf->objstm_idx + left;
+  idx->number  = number;
+  idx->first   = first;
+  idx->count   = count;
+  idx->entries = entries;
+
+  pdf->num_objstm_idx ++;
+
+  return (true);
+}
+
+
+//
+// 'add_hint_bits()' - Add a value to a hint table.
+//
+// Hint table values are packed most significant bit first.  The data buffer
+// must be zeroed before the first call.
+//
+
+static void
+add_hint_bits(unsigned char *data,	// I  - Hint table data
+              size_t        *bit,	// IO - Current bit position
+              size_t        value,	// I  - Value
+              size_t        nbits)	// I  - Number of bits
+{
+  for (; nbits > 0; nbits --, (*bit) ++)
+  {
+    if ((value >> (nbits - 1)) & 1)
+      data[*bit / 8] |= (unsigned char)(0x80 >> (*bit & 7));
+  }
+}
+
+
+//
+// 'add_page_kid()' - Add a page or page tree node to a page tree node.
+//
+
+static bool				// O - `true` on success, `false` on failure
+add_page_kid(pdfio_file_t   *pdf,	// I - PDF file
+             _pdfio_pnode_t *node,	// I - Page tree node
+             pdfio_obj_t    *kid,	// I - Page or pages object
+             size_t         count)	// I - Number of pages
+{
+  if (node->num_kids >= node->alloc_kids)
+  {
+    size_t	alloc_kids = node->alloc_kids ? 2 * node->alloc_kids : 16;
+					// New number of kids
+    pdfio_obj_t	**temp = (pdfio_obj_t **)realloc(node->kids, alloc_kids * sizeof(pdfio_obj_t *));
+					// New kids
+
+    if (!temp)
+    {
+      _pdfioFileError(pdf, "Unable to allocate memory for page tree.");
+      return (false);
+    }
+
+    node->alloc_kids = alloc_kids;
+    node->kids       = temp;
+  }
+
+  node->kids[node->num_kids ++] = kid;
+  node->count += count;
+
+  return (true);
+}
+
+
+//
+// 'begin_linearized()' - Start writing objects to a temporary file for a linearized PDF file.
+//
+// The temporary file uses the same offsets as the PDF file so that stream
+// lengths can be updated in place as usual.
+//
+
+static bool				// O - `true` on success, `false` on failure
+begin_linearized(pdfio_file_t *pdf)	// I - PDF file
+{
+  size_t	i;			// Looping var
+  int		fd;			// Temporary file
+  char		filename[1024];		// Temporary filename
+
+
+  if (pdf->update)
+  {
+    _pdfioFileError(pdf, "Unable to linearize an incremental update.");
+    return (false);
+  }
+
+  if (pdf->encrypt_obj)
+  {
+    _pdfioFileError(pdf, "Linearized PDF files cannot be encrypted.");
+    return (false);
+  }
+
+  for (i = 0; i < pdf->num_objs; i ++)
+  {
+    if (pdf->objs[i]->offset || pdf->objs[i]->objstm)
+    {
+      _pdfioFileError(pdf, "You must set the linearize option before writing any objects.");
+      return (false);
+    }
+  }
+
+  // Write the PDF header and create the temporary file...
+  if (!_pdfioFileFlush(pdf))
+    return (false);
+
+  if ((fd = create_temp_file(filename, sizeof(filename), "tmp")) < 0)
+  {
+    _pdfioFileError(pdf, "Unable to create temporary file: %s", strerror(errno));
+    return (false);
+  }
+
+  if (lseek(fd, pdf->bufpos, SEEK_SET) < 0)
+  {
+    _pdfioFileError(pdf, "Unable to seek within temporary file: %s", strerror(errno));
+    close(fd);
+    unlink(filename);
+    return (false);
+  }
+
+#ifdef _WIN32
+  // Windows cannot remove open files...
+  pdf->lin_filename = strdup(filename);
+#else
+  unlink(filename);
+#endif // _WIN32
+
+  // Write objects to the temporary file until the PDF file is closed...
+  pdf->linearize      = true;
+  pdf->lin_fd         = fd;
+  pdf->lin_outfd      = pdf->fd;
+  pdf->lin_output_cb  = pdf->output_cb;
+  pdf->lin_output_ctx = pdf->output_ctx;
+  pdf->lin_offset     = pdf->bufpos;
+  pdf->fd             = fd;
+  pdf->output_cb      = NULL;
+  pdf->output_ctx     = NULL;
+
+  return (true);
+}
+
+
+//
+// 'compare_numbers()' - Compare two object numbers.
+//
+
+static int				// O - Result of comparison
+compare_numbers(size_t *a,		// I - First number
+                size_t *b)		// I - Second number
+{
+  if (*a < *b)
+    return (-1);
+  else if (*a > *b)
+    return (1);
+  else
+    return (0);
+}
+
+
+//
+// 'compare_objmaps()' - Compare two object maps...
+//
+
+static int				// O - Result of comparison
+compare_objmaps(_pdfio_objmap_t *a,	// I - First object map
+                _pdfio_objmap_t *b)	// I - Second object map
+{
+  if (a->src_pdf < b->src_pdf)
+    return (-1);
+  else if (a->src_pdf > b->src_pdf)
+    return (1);
+  else if (a->src_number < b->src_number)
+    return (-1);
+  else if (a->src_number > b->src_number)
+    return (1);
+  else
+    return (0);
+}
+
+
+//
+// 'compare_objs()' - Compare two objects by number.
+//
+
+static int				// O - Result of comparison
+compare_objs(pdfio_obj_t **a,		// I - First object
+             pdfio_obj_t **b)		// I - Second object
+{
+  if ((*a)->number < (*b)->number)
+    return (-1);
+  else if ((*a)->number > (*b)->number)
+    return (1);
+  else
+    return (0);
+}
+
+
+//
+// 'compare_objstms()' - Compare two object stream indices by number.
+//
+
+static int				// O - Result of comparison
+compare_objstms(_pdfio_objstm_t *a,	// I - First object stream index
+                _pdfio_objstm_t *b)	// I - Second object stream index
+{
+  if (a->number < b->number)
+    return (-1);
+  else if (a->number > b->number)
+    return (1);
+  else
+    return (0);
+}
+
+
+//
+// 'close_page_node()' - Add the current page tree node at a level to its parent and write it.
+//
+
+static bool				// O - `true` on success, `false` on failure
+close_page_node(pdfio_file_t *pdf,	// I - PDF file
+                size_t       level)	// I - Page tree level
+{
+  _pdfio_pnode_t *node = pdf->page_levels + level;
+					// Page tree node
+  pdfio_obj_t	*parent;		// Parent pages object
+
+
+  if ((parent = get_page_node(pdf, level + 1)) == NULL || !add_page_kid(pdf, pdf->page_levels + level + 1, node->obj, node->count))
+    return (false);
+
+  return (write_page_node(pdf, node, parent));
+}
+
+
+//
+// 'copy_linearized()' - Copy stream data from the temporary file for a linearized PDF file.
+//
+
+static bool				// O - `true` on success, `false` on failure
+copy_linearized(pdfio_file_t *pdf,	// I - PDF file
+                off_t        offset,	// I - Offset in temporary file
+                size_t       length)	// I - Number of bytes to copy
+{
+  char		buffer[32768];		// Copy buffer
+  ssize_t	bytes;			// Bytes read
+
+
+  if (lseek(pdf->lin_fd, offset, SEEK_SET) != offset)
+  {
+    _pdfioFileError(pdf, "Unable to seek within temporary file: %s", strerror(errno));
+    return (false);
+  }
+
+  while (length > 0)
+  {
+    if ((bytes = read(pdf->lin_fd, buffer, length > sizeof(buffer) ? sizeof(buffer) : length)) < 0)
+    {
+      // Stop if we have an error that shouldn't be retried...
+      if (errno == EINTR || errno == EAGAIN)
+        continue;
+    }
+
+    if (bytes <= 0)
+    {
+      _pdfioFileError(pdf, "Unable to read from temporary file: %s", bytes < 0 ? strerror(errno) : "Unexpected end of file");
+      return (false);
+    }
+
+    if (!_pdfioFileWrite(pdf, buffer, (size_t)bytes))
+      return (false);
+
+    length -= (size_t)bytes;
+  }
+
+  return (true);
+}
+
+
+//
+// 'create_common()' - Allocate and initialize a pdfio_file_t object for writing.
+//
+
+static pdfio_file_t *			// O - New PDF file
+create_common(
+    const char        *filename,	// I - Filename
+    int               fd,		// I - File descriptor, if any
+    pdfio_output_cb_t output_cb,	// I - Output callback function, if any
+    void              *output_cbdata,	// I - Output callback data, if any
+    const char        *version,		// I - PDF version
+    pdfio_rect_t      *media_box,	// I - Media box or `NULL` for default
+    pdfio_rect_t      *crop_box,	// I - Crop box of `NULL` for default
+    pdfio_error_cb_t  error_cb,		// I - Error callback function
+    void              *error_cbdata)	// I - Error callback data
+{
+  pdfio_file_t	*pdf;			// New PDF file
+  pdfio_dict_t	*dict;			// Dictionary
+  unsigned char	id_value[16];		// File ID value
+
+
+  PDFIO_DEBUG("create_common(filename=\"%s\", fd=%d, output_cb=%p, output_cbdata=%p, version=\"%s\", media_box=%p, crop_box=%p, error_cb=%p, error_cbdata=%p)\n", filename, fd, (void *)output_cb, (void *)output_cbdata, version, (void *)media_box, (void *)crop_box, (void *)error_cb, (void *)error_cbdata);
+
+  // Range check input...
+  if (!filename || (fd < 0 && !output_cb))
+    return (NULL);
+
+  if (!version)
+    version = "2.0";
+
+  if (!error_cb)
+  {
+    error_cb     = _pdfioFileDefaultError;
+    error_cbdata = NULL;
+  }
+
+  // Allocate a PDF file structure...
+  if ((pdf = (pdfio_file_t *)calloc(1, sizeof(pdfio_file_t))) == NULL)
+  {
+    pdfio_file_t temp;			// Dummy file
+    char	message[8192];		// Message string
+
+    temp.filename = (char *)filename;
+    snprintf(message, sizeof(message), "Unable to allocate memory for PDF file: %s", strerror(errno));
+    (error_cb)(&temp, message, error_cbdata);
+
+    return (NULL);
+  }
+
+  // Initialize PDF object...
+  pdf->precision   = PDFIO_PRECISION_DEFAULT;
+  pdf->page_fanout = _PDFIO_PAGE_FANOUT;
+  pdf->fd          = fd;
+  pdf->output_cb   = output_cb;
+  pdf->output_ctx  = output_cbdata;
+  pdf->filename    = strdup(filename);
+  pdf->version     = strdup(version);
+  pdf->mode        = _PDFIO_MODE_WRITE;
+  pdf->error_cb    = error_cb;
+  pdf->error_data  = error_cbdata;
+  pdf->permissions = PDFIO_PERMISSION_ALL;
+  pdf->level       = 9;
+  pdf->buffer      = pdf->localbuf;
+  pdf->bufptr      = pdf->buffer;
+  pdf->bufend      = pdf->buffer + sizeof(pdf->localbuf);
+
+  if (media_box)
+  {
+    pdf->media_box = *media_box;
+  }
+  else
+  {
+    // Default to "universal" size (intersection of A4 and US Letter)
+    pdf->media_box.x2 = 210.0 * 72.0f / 25.4f;
+    pdf->media_box.y2 = 11.0f * 72.0f;
+  }
+
+  if (crop_box)
+  {
+    pdf->crop_box = *crop_box;
+  }
+  else
+  {
+    // Default to "universal" size (intersection of A4 and US Letter)
+    pdf->crop_box.x2 = 210.0 * 72.0f / 25.4f;
+    pdf->crop_box.y2 = 11.0f * 72.0f;
+  }
+
+  // Write a standard PDF header...
+  if (!_pdfioFilePrintf(pdf, "%%PDF-%s\n%%\342\343\317\323\n", version))
+    goto error;
+
+  // Create the pages object...
+  if ((dict = pdfioDictCreate(pdf)) == NULL)
+    goto error;
+
+  pdfioDictSetName(dict, "Type", "Pages");
+
+  if ((pdf->pages_obj = pdfioFileCreateObj(pdf, dict)) == NULL)
+    goto error;
+
+  // Create the info object...
+  if ((dict = pdfioDictCreate(pdf)) == NULL)
+    goto error;
+
+  pdfioDictSetDate(dict, "CreationDate", time(NULL));
+  pdfioDictSetString(dict, "Producer", "pdfio/" PDFIO_VERSION);
+
+  if ((pdf->info_obj = pdfioFileCreateObj(pdf, dict)) == NULL)
+    goto error;
+
+  // Create the root object...
+  if ((dict = pdfioDictCreate(pdf)) == NULL)
+    goto error;
+
+  pdfioDictSetName(dict, "Type", "Catalog");
+  pdfioDictSetObj(dict, "Pages", pdf->pages_obj);
+
+  if ((pdf->root_obj = pdfioFileCreateObj(pdf, dict)) == NULL)
+    goto error;
+
+  // Create random file ID values...
+  _pdfioCryptoMakeRandom(id_value, sizeof(id_value));
+
+  if ((pdf->id_array = pdfioArrayCreate(pdf)) != NULL)
+  {
+    pdfioArrayAppendBinary(pdf->id_array, id_value, sizeof(id_value));
+    pdfioArrayAppendBinary(pdf->id_array, id_value, sizeof(id_value));
+  }
+
+  return (pdf);
+
+  // Common error handling code...
+  error:
+
+  pdfioFileClose(pdf);
+
+  return (NULL);
+}
+
+
+//
+// 'create_temp_file()' - Create a temporary file.
+//
+// The filename is stored in "buffer" and the file is opened for reading and
+// writing.
+//
+
+static int				// O - File descriptor or `-1` on error
+create_temp_file(char       *buffer,	// I - Filename buffer
+                 size_t     bufsize,	// I - Size of filename buffer
+                 const char *ext)	// I - Filename extension
+{
+  int		i,			// Looping var
+		fd;			// File descriptor
+  const char	*tmpdir;		// Temporary directory
+#if _WIN32 || defined(__APPLE__)
+  char		tmppath[256];		// Temporary directory path
+#endif // _WIN32 || __APPLE__
+  unsigned	tmpnum;			// Temporary filename number
+
+
+#if _WIN32
+  if ((tmpdir = getenv("TEMP")) == NULL)
+  {
+    GetTempPathA(sizeof(tmppath), tmppath);
+    tmpdir = tmppath;
+  }
+
+#elif defined(__APPLE__)
+  if ((tmpdir = getenv("TMPDIR")) != NULL && access(tmpdir, W_OK))
+    tmpdir = NULL;
+
+  if (!tmpdir)
+  {
+    // Grab the per-process temporary directory for sandboxed apps...
+#  ifdef _CS_DARWIN_USER_TEMP_DIR
+    if (confstr(_CS_DARWIN_USER_TEMP_DIR, tmppath, sizeof(tmppath)))
+      tmpdir = tmppath;
+    else
+#  endif // _CS_DARWIN_USER_TEMP_DIR
+      tmpdir = "/private/tmp";
+  }
+
+#else
+  if ((tmpdir = getenv("TMPDIR")) == NULL || access(tmpdir, W_OK))
+    tmpdir = "/tmp";
+#endif // _WIN32
+
+  for (i = 0, fd = -1; i < 1000; i ++)
+  {
+    _pdfioCryptoMakeRandom((uint8_t *)&tmpnum, sizeof(tmpnum));
+    snprintf(buffer, bufsize, "%s/%08x.%s", tmpdir, tmpnum, ext);
+    if ((fd = open(buffer, O_RDWR | O_BINARY | O_CREAT | O_TRUNC | O_EXCL, 0666)) >= 0)
+      break;
+  }
+
+  return (fd);
+}
+
+
+//
+// 'find_loaded_obj()' - Find an object while loading the xref tables.
+//
+// Objects outside the object number index that were added from the current
+// xref table are not sorted yet, so only the sorted objects are searched.
+// This keeps a newer object from an incremental update without sorting again
+// for every xref entry.
+//
+
+static pdfio_obj_t *			// O - Object or `NULL` if not found
+find_loaded_obj(pdfio_file_t *pdf,	// I - PDF file
+                size_t       number)	// I - Object number
+{
+  if (number < pdf->alloc_objnums)
+    return (pdf->objnums[number]);
+  else
+    return (find_sparse_obj(pdf, number));
+}
+
+
+//
+// 'find_sparse_obj()' - Find a sorted object outside the object number index.
+//
+
+static pdfio_obj_t *			// O - Object or `NULL` if not found
+find_sparse_obj(pdfio_file_t *pdf,	// I - PDF file
+                size_t       number)	// I - Object number
+{
+  size_t	left,			// Left object
+		right,			// Right object
+		current;		// Current object
+
+
+  if (pdf->sorted_sparse_objs == 0)
+    return (NULL);
+
+  // Do a binary search of the sorted objects...
+  left  = 0;
+  right = pdf->sorted_sparse_objs - 1;
+
+  while (left < right)
+  {
+    current = (left + right) / 2;
+
+    if (number > pdf->sparse_objs[current]->number)
+      left = current + 1;
+    else
+      right = current;
+  }
+
+  if (number == pdf->sparse_objs[left]->number)
+  {
+    PDFIO_DEBUG("find_sparse_obj: Returning sparse %lu (%p)\n", (unsigned long)left, pdf->sparse_objs[left]);
+    return (pdf->sparse_objs[left]);
+  }
+
+  return (NULL);
+}
+
+
+//
+// 'find_xref()' - Find the cross-reference entry of a freed object.
+//
+
+static _pdfio_xref_t *			// O - Cross-reference entry or `NULL` if not freed
+find_xref(pdfio_file_t *pdf,		// I - PDF file
+          size_t       number)		// I - Object number
+{
+  _pdfio_xref_t	*xref;			// Cross-reference entry
+
+
+  if (number < 1 || number > pdf->alloc_xrefs)
+    return (NULL);
+
+  xref = pdf->xrefs + number - 1;
+
+  return ((xref->offset || xref->objstm) ? xref : NULL);
+}
+
+
+//
+// 'flush_obj_stream()' - Write the current object stream, if any.
+//
+
+static bool				// O - `true` on success, `false` on failure
+flush_obj_stream(pdfio_file_t *pdf)	// I - PDF file
+{
+  bool		ret;			// Return value
+  pdfio_dict_t	*dict;			// Object stream dictionary
+  pdfio_stream_t *st;			// Object stream
+  size_t	i;			// Looping var
+  char		header[_PDFIO_OBJSTM_MAX * 42],
+					// Object numbers and offsets
+		*hptr;			// Pointer into header
+
+
+  if (!pdf->num_objstm)
+    return (true);
+
+  // Build the list of object numbers and offsets...
+  for (i = 0, hptr = header; i < pdf->num_objstm; i ++, hptr += strlen(hptr))
+    snprintf(hptr, sizeof(header) - (size_t)(hptr - header), "%lu %lu ", (unsigned long)pdf->objstm_numbers[i], (unsigned long)pdf->objstm_offsets[i]);
+
+  // Write the stream...
+  dict = pdfioObjGetDict(pdf->objstm_obj);
+
+  pdfioDictSetName(dict, "Filter", "FlateDecode");
+  pdfioDictSetNumber(dict, "First", (double)(hptr - header));
+  pdfioDictSetNumber(dict, "N", (double)pdf->num_objstm);
+
+  // Free the object stream once it is written when streaming...
+  if (pdf->options & PDFIO_OPTION_STREAMING)
+    pdf->objstm_obj->release = true;
+
+  if ((st = pdfioObjCreateStream(pdf->objstm_obj, PDFIO_FILTER_FLATE)) == NULL)
+    return (false);
+
+  ret = pdfioStreamWrite(st, header, (size_t)(hptr - header)) && pdfioStreamWrite(st, pdf->spool, pdf->spoollen);
+
+  if (!pdfioStreamClose(st))
+    ret = false;
+
+  // Reset for the next object stream...
+  pdf->objstm_obj = NULL;
+  pdf->num_objstm = 0;
+  pdf->spoollen   = 0;
+  pdf->num_objstms ++;
+
+  return (ret);
+}
+
+
+//
+// 'free_blocks()' - Free a list of memory blocks.
+//
+
+static void
+free_blocks(_pdfio_block_t *block)	// I - First block
+{
+  _pdfio_block_t	*next;		// Next block
+
+
+  for (; block; block = next)
+  {
+    next = block->next;
+    free(block);
+  }
+}
+
+
+//
+// 'get_info_string()' - Get a string value from the Info dictionary.
+//
+// This function also handles converting binary strings to C strings, which
+// occur in encrypted PDF files.
+//
+
+static const char *			// O - String or `NULL` if not found
+get_info_string(pdfio_file_t *pdf,	// I - PDF file
+                const char   *key)	// I - Dictionary key
+{
+  pdfio_dict_t	*dict;			// Info dictionary
+
+
+  // Range check input...
+  if (!pdf || !pdf->info_obj || (dict = pdfioObjGetDict(pdf->info_obj)) == NULL)
+    return (NULL);
+  else
+    return (pdfioDictGetString(dict, key));
+}
+
+
+//
+// 'get_page_node()' - Get the current page tree node at a level with room for another kid.
+//
+// Full nodes are added to their parent node and written before a new node is
+// started at the same level.  The node dictionaries are only created when the
+// nodes are written, so streaming output does not hold on to any memory
+// blocks for the page tree.
+//
+
+static pdfio_obj_t *			// O - Pages object or `NULL` on error
+get_page_node(pdfio_file_t *pdf,	// I - PDF file
+              size_t       level)	// I - Page tree level (`0` for leaves)
+{
+  _pdfio_pnode_t *node;			// Page tree node
+  pdfio_obj_t	*obj;			// Pages object
+
+
+  if (level >= PDFIO_MAX_DEPTH)
+  {
+    _pdfioFileError(pdf, "Page tree is too deep.");
+    return (NULL);
+  }
+
+  node = pdf->page_levels + level;
+
+  if (level < pdf->num_page_levels)
+  {
+    // Use the current node unless it is full...
+    if (node->num_kids < pdf->page_fanout)
+      return (node->obj);
+
+    if (!close_page_node(pdf, level))
+      return (NULL);
+  }
+
+  // Start a new node, using the original pages object for the first leaf...
+  if (pdf->num_page_nodes == 0)
+    obj = pdf->pages_obj;
+  else if ((obj = _pdfioFileCreateObj(pdf, pdf, NULL)) == NULL)
+    return (NULL);
+
+  // Keep the nodes for linearization, which cannot be combined with streaming
+  // output that frees them once they are written...
+  if (!(pdf->options & PDFIO_OPTION_STREAMING))
+  {
+    if (pdf->num_page_nodes >= pdf->alloc_page_nodes)
+    {
+      pdfio_obj_t **temp = (pdfio_obj_t **)realloc(pdf->page_nodes, (pdf->alloc_page_nodes + 16) * sizeof(pdfio_obj_t *));
+
+      if (!temp)
+      {
+	_pdfioFileError(pdf, "Unable to allocate memory for page tree.");
+	return (NULL);
+      }
+
+      pdf->alloc_page_nodes += 16;
+      pdf->page_nodes       = temp;
+    }
+
+    pdf->page_nodes[pdf->num_page_nodes] = obj;
+  }
+
+  pdf->num_page_nodes ++;
+
+  node->obj      = obj;
+  node->num_kids = 0;
+  node->count    = 0;
+
+  if (level >= pdf->num_page_levels)
+    pdf->num_page_levels = level + 1;
+
+  return (obj);
+}
+
+
+//
+// 'hint_bits()' - Return the number of bits needed for a hint table value.
+//
+
+static size_t				// O - Number of bits
+hint_bits(size_t value)			// I - Maximum value
+{
+  size_t	bits;			// Number of bits
+
+
+  for (bits = 0; value; bits ++, value >>= 1);
+
+  return (bits);
+}
+
+
+//
+// 'is_update_obj()' - Determine whether an object belongs in the xref data of an update.
+//
+// New objects and original objects that have been written again are part of
+// an incremental update.
+//
+
+static bool				// O - `true` if in the update, `false` otherwise
+is_update_obj(pdfio_file_t *pdf,	// I - PDF file
+              pdfio_obj_t  *obj)	// I - Object
+{
+  return (obj->number >= pdf->update_objnum || _pdfioObjIsUpdated(obj));
+}
+
+
+//
+// 'load_obj_stream()' - Load the objects in a compressed object stream.
+//
+// The token buffer reads from the object stream data, either directly from
+// the stream or from data that was decoded by @link pdfioFileLoadObjStreams@.
+//
+
+static bool				// O - `true` on success, `false` on error
+load_obj_stream(pdfio_file_t   *pdf,	// I - PDF file
+                pdfio_obj_t    *obj,	// I - Object stream
+                _pdfio_token_t *tb)	// I - Token buffer/stack
+{
+  size_t		number = obj->number;
+					// Object stream number
+  char			buffer[32];	// Token
+  size_t		cur_obj,	// Current object
+			num_objs = 0,	// Number of objects
+			alloc_objs = 0;	// Allocated objects
+  pdfio_obj_t		**objs = NULL;	// Objects
+  _pdfio_value_t	value;		// Object value
+  int			count;		// Count of objects
+  size_t		first,		// Offset of first object
+			alloc_bytes,	// Bytes allocated before reading value
+			*entries = NULL;// Object numbers and offsets to save
+  bool			ret = false;	// Return value
+
+
+  count = (int)pdfioDictGetNumber(_pdfioObjGetDict(obj), _pdfio_keys[_PDFIO_KEY_N]);
+  first = (size_t)pdfioDictGetNumber(_pdfioObjGetDict(obj), "First");
+
+  PDFIO_DEBUG("load_obj_stream: N=%d\n", count);
+
+  // Read the object numbers from the beginning of the stream...
+  while (count > 0 && _pdfioTokenGet(tb, buffer, sizeof(buffer)))
+  {
+    size_t	objnum;			// Object number
+
+    // Stop if this isn't an object number...
+    PDFIO_DEBUG("load_obj_stream: %s\n", buffer);
+    if (!isdigit(buffer[0] & 255))
+      break;
+
+    // Expand the object arrays as needed...
+    if (num_objs >= alloc_objs)
+    {
+      pdfio_obj_t	**temp;		// New objects
+      size_t		*tentries;	// New object numbers and offsets
+
+      alloc_objs = alloc_objs ? 2 * alloc_objs : (size_t)count < 1024 ? (size_t)count : 1024;
+
+      if ((temp = (pdfio_obj_t **)realloc(objs, alloc_objs * sizeof(pdfio_obj_t *))) == NULL)
+      {
+        _pdfioFileError(pdf, "Unable to allocate memory for compressed objects.");
+        goto done;
+      }
+
+      objs = temp;
+
+      if (pdf->cache_limit)
+      {
+        if ((tentries = (size_t *)realloc(entries, 2 * alloc_objs * sizeof(size_t))) == NULL)
+	{
+	  _pdfioFileError(pdf, "Unable to allocate memory for compressed objects.");
+	  goto done;
+	}
+
+	entries = tentries;
+      }
+    }
+
+    // Add the object in memory...
+    objnum = (size_t)strtoimax(buffer, NULL, 10);
+
+    if ((objs[num_objs] = pdfioFileFindObj(pdf, objnum)) == NULL)
+    {
+      if ((objs[num_objs] = add_obj(pdf, objnum, 0, 0)) == NULL)
+        goto done;
+
+      objs[num_objs]->objstm = number;
+    }
+
+    // Get the offset, saving it as needed...
+    _pdfioTokenGet(tb, buffer, sizeof(buffer));
+    PDFIO_DEBUG("load_obj_stream: %ld at offset %s\n", (long)objnum, buffer);
+
+    if (entries)
+    {
+      entries[2 * num_objs]     = objnum;
+      entries[2 * num_objs + 1] = (size_t)strtoimax(buffer, NULL, 10);
+    }
+
+    num_objs ++;
+
+    // One less compressed object...
+    count --;
+  }
+
+  PDFIO_DEBUG("load_obj_stream: num_objs=%lu\n", (unsigned long)num_objs);
+
+  // Read the objects themselves, only keeping the values of objects that are
+  // still stored in this object stream...
+  for (cur_obj = 0; cur_obj < num_objs; cur_obj ++)
+  {
+    alloc_bytes = pdf->alloc_bytes;
+
+    if (!_pdfioValueRead(pdf, obj, tb, &value, 0))
+    {
+      _pdfioFileError(pdf, "Unable to read compressed object.");
+      goto done;
+    }
+
+    if (objs[cur_obj]->objstm == number && objs[cur_obj]->value.type == PDFIO_VALTYPE_NONE)
+    {
+      objs[cur_obj]->value = value;
+      _pdfioObjCache(objs[cur_obj], pdf->alloc_bytes - alloc_bytes);
+
+      pdf->stats.objs_loaded ++;
+    }
+    else
+    {
+      _pdfioValueRelease(pdf, &value);
+    }
+  }
+
+  // Save the object numbers and offsets so objects can be reloaded...
+  if (entries && num_objs > 0 && add_objstm_idx(pdf, number, first, num_objs, entries))
+    entries = NULL;
+
+  ret = true;
+
+  done:
+
+  free(objs);
+  free(entries);
+
+  return (ret);
+}
+
+
+//
+// 'load_page()' - Look up a page in the page tree.
+//
+// This function descends the page tree using the Count values of each Pages
+// object, remembering any leaf Page objects it sees along the way.  If the page
+// tree is not consistent, the whole page tree is loaded instead.
+//
+
+static pdfio_obj_t *			// O - Page object or `NULL` if not found
+load_page(pdfio_file_t *pdf,		// I - PDF file
+          size_t       n)		// I - Page index (starting at 0)
+{
+  pdfio_obj_t	*node = pdf->pages_obj;	// Current node in page tree
+  size_t	first = 0,		// Index of first page in node
+		depth,			// Depth of page tree
+		i,			// Looping var
+		num_kids,		// Number of kids
+		count;			// Number of pages in kid
+  pdfio_array_t	*kids;			// Kids array
+  pdfio_obj_t	*kid = NULL;		// Current kid
+  pdfio_dict_t	*kdict = NULL;		// Kid dictionary
+
+
+  PDFIO_DEBUG("load_page(pdf=%p, n=%lu)\n", pdf, (unsigned long)n);
+
+  for (depth = 0; depth < PDFIO_MAX_DEPTH; depth ++)
+  {
+    if ((kids = pdfioDictGetArray(pdfioObjGetDict(node), _pdfio_keys[_PDFIO_KEY_KIDS])) == NULL)
+      break;
+
+    for (i = 0, num_kids = pdfioArrayGetSize(kids); i < num_kids; i ++)
+    {
+      if ((kid = pdfioArrayGetObj(kids, i)) == NULL || (kdict = pdfioObjGetDict(kid)) == NULL)
+        break;
+
+      if (pdfioDictGetArray(kdict, _pdfio_keys[_PDFIO_KEY_KIDS]))
+      {
+        // Pages node, see if the page is in this subtree...
+        count = (size_t)pdfioDictGetNumber(kdict, _pdfio_keys[_PDFIO_KEY_COUNT]);
+
+        if (n < (first + count))
+          break;
+
+        first += count;
+      }
+      else
+      {
+        // Page object, remember it and see if it is the one we want...
+        if (first < pdf->num_pages && !pdf->pages[first])
+          pdf->pages[first] = kid;
+
+        if (first == n)
+          return (kid);
+
+        first ++;
+      }
+    }
+
+    if (i >= num_kids || !kid || !kdict)
+      break;
+
+    node = kid;
+  }
+
+  // If we get here the page tree is broken or the Count values are wrong, so
+  // load the whole page tree...
+  PDFIO_DEBUG("load_page: Inconsistent page tree, loading all pages.\n");
+
+  pdf->lazy_pages = false;
+  pdf->num_pages  = 0;
+
+  if (!load_pages(pdf, pdf->pages_obj, 0) || n >= pdf->num_pages)
+    return (NULL);
+  else
+    return (pdf->pages[n]);
+}
+
+
+//
+// 'load_pages()' - Load pages in the document.
+//
+
+static bool				// O - `true` on success, `false` on error
+load_pages(pdfio_file_t *pdf,		// I - PDF file
+           pdfio_obj_t  *obj,		// I - Page object
+           size_t       depth)		// I - Depth of page tree
+{
+  pdfio_dict_t	*dict;			// Page object dictionary
+  const char	*type;			// Node type
+  pdfio_array_t	*kids;			// Kids array
+
+
+  // Range check input...
+  if (!obj)
+  {
+    _pdfioFileError(pdf, "Unable to find pages object.");
+    return (false);
+  }
+
+  // Get the object dictionary and make sure this is a Pages or Page object...
+  if ((dict = pdfioObjGetDict(obj)) == NULL)
+  {
+    _pdfioFileError(pdf, "No dictionary for pages object.");
+    return (false);
+  }
+
+  if ((type = pdfioDictGetName(dict, _pdfio_keys[_PDFIO_KEY_TYPE])) == NULL || (strcmp(type, "Pages") && strcmp(type, "Page")))
+    return (false);
+
+  // If there is a Kids array, then this is a parent node and we have to look
+  // at the child objects...
+  if ((kids = pdfioDictGetArray(dict, _pdfio_keys[_PDFIO_KEY_KIDS])) != NULL)
+  {
+    // Load the child objects...
+    size_t	i,			// Looping var
+		num_kids;		// Number of elements in array
+
+    if (depth >= PDFIO_MAX_DEPTH)
+    {
+      _pdfioFileError(pdf, "Depth of pages objects too great to load.");
+      return (false);
+    }
+
+    for (i = 0, num_kids = pdfioArrayGetSize(kids); i < num_kids; i ++)
+    {
+      if (!load_pages(pdf, pdfioArrayGetObj(kids, i), depth + 1))
+        return (false);
+    }
+  }
+  else
+  {
+    // Add this page...
+    if (pdf->num_pages >= pdf->alloc_pages)
+    {
+      pdfio_obj_t **temp = (pdfio_obj_t **)realloc(pdf->pages, (pdf->alloc_pages + 32) * sizeof(pdfio_obj_t *));
+
+      if (!temp)
+      {
+        _pdfioFileError(pdf, "Unable to allocate memory for pages.");
+        return (false);
+      }
+
+      pdf->alloc_pages += 32;
+      pdf->pages       = temp;
+    }
+
+    pdf->pages[pdf->num_pages ++] = obj;
+  }
+
+  return (true);
+}
+
+
+//
+// 'load_xref()' - Load an XREF table...
+//
+
+static bool				// O - `true` on success, `false` on failure
+load_xref(
+    pdfio_file_t        *pdf,		// I - PDF file
+    off_t               xref_offset,	// I - Offset to xref
+    pdfio_password_cb_t password_cb,	// I - Password callback or `NULL` for none
+    void                *password_data)	// I - Password callback data, if any
+{
+  bool		done = false;		// Are we done?
+  char		line[1024],		// Line from file
+		*ptr;			// Pointer into line
+  _pdfio_value_t trailer;		// Trailer dictionary
+  intmax_t	number,			// Object number
+		num_objects,		// Number of objects
+		offset;			// Offset in file
+  int		generation;		// Generation number
+  _pdfio_token_t tb;			// Token buffer/stack
+  off_t		line_offset;		// Offset to start of line
+  double	count;			// Number of pages
+
+
+  while (!done)
+  {
+    // Sort the objects from newer xref tables so that find_loaded_obj() can
+    // look them up...
+    sort_sparse_objs(pdf);
+
+    if (_pdfioFileSeek(pdf, xref_offset, SEEK_SET) != xref_offset)
+    {
+      _pdfioFileError(pdf, "Unable to seek to start of xref table.");
+      return (false);
+    }
+
+    do
+    {
+      line_offset = _pdfioFileTell(pdf);
+
+      if (!_pdfioFileGets(pdf, line, sizeof(line)))
+      {
+	_pdfioFileError(pdf, "Unable to read start of xref table.");
+	return (false);
+      }
+    }
+    while (!line[0]);
+
+    PDFIO_DEBUG("load_xref: line_offset=%lu, line='%s'\n", (unsigned long)line_offset, line);
+
+    if (isdigit(line[0] & 255) && strlen(line) > 4 && (!strcmp(line + strlen(line) - 4, " obj") || ((ptr = strstr(line, " obj")) != NULL && ptr[4] == '<')))
+    {
+      // Cross-reference stream
+      pdfio_obj_t	*obj;		// Object
+      size_t		i;		// Looping var
+      pdfio_array_t	*index_array;	// Index array
+      size_t		index_n,	// Current element in array
+			index_count,	// Number of values in index array
+			count;		// Number of objects in current pairing
+      pdfio_array_t	*w_array;	// W array
+      size_t		w[3];		// Size of each cross-reference field
+      size_t		w_2,		// Offset to second field
+			w_3;		// Offset to third field
+      size_t		w_total;	// Total length
+      pdfio_stream_t	*st;		// Stream
+      unsigned char	buffer[32];	// Read buffer
+      pdfio_obj_t	*current;	// Current object
+
+      if ((number = strtoimax(line, &ptr, 10)) < 1)
+      {
+	_pdfioFileError(pdf, "Bad xref table header '%s'.", line);
+	return (false);
+      }
+
+      if ((generation = (int)strtol(ptr, &ptr, 10)) < 0 || (generation > 65535 && number != 0))
+      {
+	_pdfioFileError(pdf, "Bad xref table header '%s'.", line);
+	return (false);
+      }
+
+      while (isspace(*ptr & 255))
+	ptr ++;
+
+      if (strncmp(ptr, "obj", 3))
+      {
+	_pdfioFileError(pdf, "Bad xref table header '%s'.", line);
+	return (false);
+      }
+
+      if (_pdfioFileSeek(pdf, line_offset + ptr + 3 - line, SEEK_SET) < 0)
+      {
+        _pdfioFileError(pdf, "Unable to seek to xref object %lu %u.", (unsigned long)number, (unsigned)generation);
+        return (false);
+      }
+
+      PDFIO_DEBUG("load_xref: Loading object %lu %u.\n", (unsigned long)number, (unsigned)generation);
+
+      if ((obj = add_obj(pdf, (size_t)number, (unsigned short)generation, xref_offset)) == NULL)
+      {
+        _pdfioFileError(pdf, "Unable to allocate memory for object.");
+        return (false);
+      }
+
+      _pdfioTokenInit(&tb, pdf, (_pdfio_tconsume_cb_t)_pdfioFileConsume, (_pdfio_tpeek_cb_t)_pdfioFilePeek, pdf);
+
+      if (!_pdfioValueRead(pdf, obj, &tb, &trailer, 0))
+      {
+        _pdfioFileError(pdf, "Unable to read cross-reference stream dictionary.");
+        return (false);
+      }
+      else if (trailer.type != PDFIO_VALTYPE_DICT)
+      {
+	_pdfioFileError(pdf, "Cross-reference stream does not have a dictionary.");
+	return (false);
+      }
+
+      obj->value = trailer;
+
+      if (!_pdfioTokenGet(&tb, line, sizeof(line)) || strcmp(line, "stream"))
+      {
+        _pdfioFileError(pdf, "Unable to get stream after xref dictionary.");
+        return (false);
+      }
+
+      PDFIO_DEBUG("load_xref: tb.bufptr=%p, tb.bufend=%p, tb.bufptr[0]=0x%02x, tb.bufptr[0]=0x%02x\n", tb.bufptr, tb.bufend, tb.bufptr[0], tb.bufptr[1]);
+      if (tb.bufptr && tb.bufptr < tb.bufend && (tb.bufptr[0] == 0x0d || tb.bufptr[0] == 0x0a))
+	tb.bufptr ++;			// Skip trailing CR or LF after token
+
+      _pdfioTokenFlush(&tb);
+
+      obj->stream_offset = _pdfioFileTell(pdf);
+
+      if ((index_array = pdfioDictGetArray(trailer.value.dict, "Index")) != NULL)
+        index_count = index_array->num_values;
+      else
+        index_count = 1;
+
+      if ((w_array = pdfioDictGetArray(trailer.value.dict, "W")) == NULL)
+      {
+	_pdfioFileError(pdf, "Cross-reference stream does not have required W key.");
+	return (false);
+      }
+
+      w[0]    = (size_t)pdfioArrayGetNumber(w_array, 0);
+      w[1]    = (size_t)pdfioArrayGetNumber(w_array, 1);
+      w[2]    = (size_t)pdfioArrayGetNumber(w_array, 2);
+      w_total = w[0] + w[1] + w[2];
+      w_2     = w[0];
+      w_3     = w[0] + w[1];
+
+      if (w[1] == 0 || w[2] > 4 || w[0] > sizeof(buffer) || w[1] > sizeof(buffer) || w[2] > sizeof(buffer) || w_total > sizeof(buffer))
+      {
+	_pdfioFileError(pdf, "Cross-reference stream has invalid W key [%u %u %u].", (unsigned)w[0], (unsigned)w[1], (unsigned)w[2]);
+	return (false);
+      }
+
+      if ((st = pdfioObjOpenStream(obj, true)) == NULL)
+      {
+	_pdfioFileError(pdf, "Unable to open cross-reference stream.");
+	return (false);
+      }
+
+      for (index_n = 0; index_n < index_count; index_n += 2)
+      {
+        if (index_count == 1)
+        {
+          number = 0;
+          count  = 999999999;
+	}
+	else
+	{
+          number = (intmax_t)pdfioArrayGetNumber(index_array, index_n);
+          count  = (size_t)pdfioArrayGetNumber(index_array, index_n + 1);
+	}
+
+	while (count > 0 && pdfioStreamRead(st, buffer, w_total) > 0)
+	{
+	  count --;
+
+	  PDFIO_DEBUG("load_xref: number=%u %02X%02X%02X%02X%02X\n", (unsigned)number, buffer[0], buffer[1], buffer[2], buffer[3], buffer[4]);
+
+	  // Check whether this is an object definition...
+	  if (w[0] > 0)
+	  {
+	    if (buffer[0] == 0)
+	    {
+	      // Ignore free objects...
+	      number ++;
+	      continue;
+	    }
+	  }
+
+          // Offset
+	  for (i = 1, offset = buffer[w_2]; i < w[1]; i ++)
+	    offset = (offset << 8) | buffer[w_2 + i];
+
+          // Generation number
+	  switch (w[2])
+	  {
+	    default :
+		generation = 0;
+		break;
+	    case 1 :
+		generation = buffer[w_3];
+		break;
+	    case 2 :
+		generation = (buffer[w_3] << 8) | buffer[w_3 + 1];
+		break;
+	    case 3 :
+	        // Issue #46: Stupid Microsoft PDF generator using 3 bytes to
+	        // encode 16-bit generation numbers == 0 (probably a lazy coder
+	        // stuffing things into an array of 64-bit unsigned integers)
+		generation = (buffer[w_3] << 16) | (buffer[w_3 + 1] << 8) | buffer[w_3 + 2];
+		if (generation > 65535)
+		  generation = 65535;
+		break;
+	    case 4 : // Even stupider :)
+		generation = (buffer[w_3] << 24) | (buffer[w_3 + 1] << 16) | (buffer[w_3 + 2] << 8) | buffer[w_3 + 3];
+		if (generation > 65535)
+		  generation = 65535;
+		break;
+	  }
+
+	  // Create a placeholder for the object in memory, keeping any newer
+	  // object from an incremental update...
+	  if ((current = find_loaded_obj(pdf, (size_t)number)) != NULL)
+	  {
+	    PDFIO_DEBUG("load_xref: existing object, offset=%u\n", (unsigned)current->offset);
+	  }
+	  else
+	  {
+	    if (w[0] > 0 && buffer[0] == 2)
+	    {
+	      // Add a placeholder for an object in an object stream, which is
+	      // loaded when the object is first used...
+	      if ((current = add_obj(pdf, (size_t)number, 0, 0)) == NULL)
+	        return (false);
+
+	      current->objstm = (size_t)offset;
+	    }
+	    else if (!add_obj(pdf, (size_t)number, (unsigned short)generation, offset))
+	    {
+	      // Unable to add this object...
+	      return (false);
+	    }
+	  }
+
+	  number ++;
+	}
+      }
+
+      pdfioStreamClose(st);
+
+      if (!pdf->trailer_dict)
+      {
+	// Save the trailer dictionary and file ID...
+	pdf->trailer_dict = trailer.value.dict;
+	pdf->id_array     = pdfioDictGetArray(pdf->trailer_dict, "ID");
+      }
+    }
+    else if (!strncmp(line, "xref", 4) && (!line[4] || isspace(line[4] & 255)))
+    {
+      // Read the xref tables
+      off_t trailer_offset = _pdfioFileTell(pdf);
+					// Offset of current line
+
+      PDFIO_DEBUG("load_xref: Reading xref table starting at offset %lu\n", (unsigned long)trailer_offset);
+      while (_pdfioFileGets(pdf, line, sizeof(line)))
+      {
+        PDFIO_DEBUG("load_xref: '%s' at offset %lu\n", line, (unsigned long)trailer_offset);
+
+	if (!strncmp(line, "trailer", 7) && (!line[7] || isspace(line[7] & 255) || line[7] == '<'))
+	{
+	  if (line[7])
+	  {
+	    // Probably the start of the trailer dictionary, rewind the file so
+	    // we can read it...
+	    _pdfioFileSeek(pdf, trailer_offset + 7, SEEK_SET);
+	  }
+
+	  break;
+	}
+	else
+	{
+	  trailer_offset = _pdfioFileTell(pdf);
+
+          if (!line[0])
+	    continue;
+	}
+
+	if (sscanf(line, "%jd%jd", &number, &num_objects) != 2)
+	{
+	  _pdfioFileError(pdf, "Malformed xref table section '%s'.", line);
+	  return (false);
+	}
+
+	// Read this group of objects...
+	for (; num_objects > 0; num_objects --, number ++)
+	{
+	  // Read a line from the file and validate it...
+	  if (_pdfioFileRead(pdf, line, 20) != 20)
+	    return (false);
+
+	  line[20] = '\0';
+
+	  if (strcmp(line + 18, "\r\n") && strcmp(line + 18, " \n") && strcmp(line + 18, " \r"))
+	  {
+	    _pdfioFileError(pdf, "Malformed xref table entry '%s'.", line);
+	    return (false);
+	  }
+	  line[18] = '\0';
+
+	  // Parse the line
+	  if ((offset = strtoimax(line, &ptr, 10)) < 0)
+	  {
+	    _pdfioFileError(pdf, "Malformed xref table entry '%s'.", line);
+	    return (false);
+	  }
+
+	  if ((generation = (int)strtol(ptr, &ptr, 10)) < 0 || (generation > 65535 && offset != 0))
+	  {
+	    _pdfioFileError(pdf, "Malformed xref table entry '%s'.", line);
+	    return (false);
+	  }
+
+	  if (*ptr != ' ')
+	  {
+	    _pdfioFileError(pdf, "Malformed xref table entry '%s'.", line);
+	    return (false);
+	  }
+
+	  ptr ++;
+	  if (*ptr != 'f' && *ptr != 'n')
+	  {
+	    _pdfioFileError(pdf, "Malformed xref table entry '%s'.", line);
+	    return (false);
+	  }
+
+	  if (*ptr == 'f')
+	    continue;			// Don't care about free objects...
+
+	  // Create a placeholder for the object in memory...
+	  if (find_loaded_obj(pdf, (size_t)number))
+	    continue;			// Don't replace newer object...
+
+	  if (!add_obj(pdf, (size_t)number, (unsigned short)generation, offset))
+	    return (false);
+	}
+
+	trailer_offset = _pdfioFileTell(pdf);
+      }
+
+      if (strncmp(line, "trailer", 7))
+      {
+	_pdfioFileError(pdf, "Missing trailer.");
+	return (false);
+      }
+
+      _pdfioTokenInit(&tb, pdf, (_pdfio_tconsume_cb_t)_pdfioFileConsume, (_pdfio_tpeek_cb_t)_pdfioFilePeek, pdf);
+
+      if (!_pdfioValueRead(pdf, NULL, &tb, &trailer, 0))
+      {
+	_pdfioFileError(pdf, "Unable to read trailer dictionary.");
+	return (false);
+      }
+      else if (trailer.type != PDFIO_VALTYPE_DICT)
+      {
+	_pdfioFileError(pdf, "Trailer is not a dictionary.");
 	return (false);
       }
 
-      for (index_n = 0; index_n < index_count; index_n += 2)
+      PDFIO_DEBUG("load_xref: Got trailer dict.\n");
+
+      _pdfioTokenFlush(&tb);
+
+      if (!pdf->trailer_dict)
+      {
+	// Save the trailer dictionary and file ID...
+	pdf->trailer_dict = trailer.value.dict;
+	pdf->id_array     = pdfioDictGetArray(pdf->trailer_dict, "ID");
+      }
+    }
+    else
+    {
+      _pdfioFileError(pdf, "Bad xref table header '%s'.", line);
+      return (false);
+    }
+
+    PDFIO_DEBUG("load_xref: Contents of trailer dictionary:\n");
+    PDFIO_DEBUG("load_xref: ");
+    PDFIO_DEBUG_VALUE(&trailer);
+    PDFIO_DEBUG("\n");
+
+    off_t new_offset = (off_t)pdfioDictGetNumber(trailer.value.dict, "Prev");
+
+    if (new_offset <= 0)
+    {
+      done = true;
+    }
+    else if (new_offset == xref_offset)
+    {
+      _pdfioFileError(pdf, "Recursive xref table.");
+      return (false);
+    }
+
+    xref_offset = new_offset;
+  }
+
+  // Once we have all of the xref tables loaded, try unlocking the file if the
+  // trailer contains an Encrypt key - the encryption dictionary is usually
+  // in the original file when there are incremental updates...
+  if ((pdf->encrypt_obj = pdfioDictGetObj(pdf->trailer_dict, "Encrypt")) != NULL && !_pdfioCryptoUnlock(pdf, password_cb, password_data))
+    return (false);
+
+  // Then get the important objects and build the pages array...
+  pdf->info_obj = pdfioDictGetObj(pdf->trailer_dict, "Info");
+
+  if ((pdf->root_obj = pdfioDictGetObj(pdf->trailer_dict, "Root")) == NULL)
+  {
+    _pdfioFileError(pdf, "Missing Root object.");
+    return (false);
+  }
+
+  PDFIO_DEBUG("load_xref: Root=%p(%lu)\n", pdf->root_obj, (unsigned long)pdf->root_obj->number);
+
+  if ((pdf->pages_obj = pdfioDictGetObj(pdfioObjGetDict(pdf->root_obj), "Pages")) == NULL)
+  {
+    _pdfioFileError(pdf, "Unable to find pages object.");
+    return (false);
+  }
+
+  // Use the Count value in the root Pages object to look up pages as needed,
+  // otherwise load the whole page tree...
+  if (pdfioDictGetArray(pdfioObjGetDict(pdf->pages_obj), _pdfio_keys[_PDFIO_KEY_KIDS]) && (count = pdfioDictGetNumber(pdfioObjGetDict(pdf->pages_obj), _pdfio_keys[_PDFIO_KEY_COUNT])) >= 1.0 && count < (double)(SIZE_MAX / sizeof(pdfio_obj_t *)))
+  {
+    if ((pdf->pages = (pdfio_obj_t **)calloc((size_t)count, sizeof(pdfio_obj_t *))) == NULL)
+    {
+      _pdfioFileError(pdf, "Unable to allocate memory for pages.");
+      return (false);
+    }
+
+    pdf->num_pages   = pdf->alloc_pages = (size_t)count;
+    pdf->lazy_pages  = true;
+
+    PDFIO_DEBUG("load_xref: Using lazy lookup of %lu pages.\n", (unsigned long)pdf->num_pages);
+
+    return (true);
+  }
+
+  return (load_pages(pdf, pdf->pages_obj, 0));
+}
+
+
+//
+// 'next_free_obj()' - Find the next object that was not written.
+//
+// Objects that were never written are recorded as free entries in the
+// cross-reference table or stream, for example when a copied stream object
+// was replaced by an identical object that was already copied.
+//
+
+static size_t				// O - Object number or 0 if none
+next_free_obj(pdfio_file_t *pdf,	// I - PDF file
+              size_t       i,		// I - Starting index
+              pdfio_obj_t  *xref_obj)	// I - Cross-reference stream object, if any
+{
+  for (; i < pdf->num_objs; i ++)
+  {
+    pdfio_obj_t *obj = pdf->objs[i];	// Current object
+
+    if (!obj->offset && !obj->objstm && obj != xref_obj)
+      return (obj->number);
+  }
+
+  return (0);
+}
+
+
+//
+// 'objstm_consume()' - Consume bytes from decoded object stream data.
+//
+
+static ssize_t				// O - Number of bytes consumed
+objstm_consume(_pdfio_objbuf_t *ob,	// I - Decoded object stream data
+               size_t          bytes)	// I - Number of bytes to consume
+{
+  if (bytes > (size_t)(ob->bufend - ob->bufptr))
+    bytes = (size_t)(ob->bufend - ob->bufptr);
+
+  ob->bufptr += bytes;
+
+  return ((ssize_t)bytes);
+}
+
+
+//
+// 'objstm_peek()' - Peek at bytes in decoded object stream data.
+//
+
+static ssize_t				// O - Number of bytes peeked
+objstm_peek(_pdfio_objbuf_t *ob,	// I - Decoded object stream data
+            void            *buffer,	// I - Peek buffer
+            size_t          bytes)	// I - Number of bytes to peek
+{
+  if (bytes > (size_t)(ob->bufend - ob->bufptr))
+    bytes = (size_t)(ob->bufend - ob->bufptr);
+
+  memcpy(buffer, ob->bufptr, bytes);
+
+  return ((ssize_t)bytes);
+}
+
+
+//
+// 'objstm_worker()' - Decode compressed object streams.
+//
+
+#ifdef _WIN32
+static DWORD WINAPI			// O - Exit status
+#else
+static void *				// O - Exit status
+#endif // _WIN32
+objstm_worker(_pdfio_objpool_t *pool)	// I - Decoding threads
+{
+  _pdfio_objjob_t	*job;		// Current job
+  pdfio_stream_t	*st;		// Object stream
+  size_t		dataalloc;	// Allocated size of data
+  unsigned char		*data;		// New data buffer
+  ssize_t		bytes;		// Bytes read
+
+
+  for (;;)
+  {
+    // Get the next object stream...
+#ifdef _WIN32
+    EnterCriticalSection(&pool->mutex);
+#else
+    pthread_mutex_lock(&pool->mutex);
+#endif // _WIN32
+
+    job = pool->next_job < pool->num_jobs ? pool->jobs + pool->next_job ++ : NULL;
+
+#ifdef _WIN32
+    LeaveCriticalSection(&pool->mutex);
+#else
+    pthread_mutex_unlock(&pool->mutex);
+#endif // _WIN32
+
+    if (!job)
+      break;
+
+    // Read all of the decoded data...
+    if ((st = pdfioObjOpenStream(job->obj, true)) == NULL)
+    {
+      _pdfioFileError(job->obj->pdf, "Unable to open compressed object stream %lu.", (unsigned long)job->obj->number);
+      continue;
+    }
+
+    for (dataalloc = 0;;)
+    {
+      if (job->datalen >= dataalloc)
+      {
+        dataalloc = dataalloc ? 2 * dataalloc : 65536;
+
+        if ((data = (unsigned char *)realloc(job->data, dataalloc)) == NULL)
+        {
+          _pdfioFileError(job->obj->pdf, "Unable to allocate memory for compressed object stream %lu.", (unsigned long)job->obj->number);
+          free(job->data);
+          job->data = NULL;
+          break;
+	}
+
+	job->data = data;
+      }
+
+      if ((bytes = pdfioStreamRead(st, job->data + job->datalen, dataalloc - job->datalen)) <= 0)
+        break;
+
+      job->datalen += (size_t)bytes;
+    }
+
+    pdfioStreamClose(st);
+  }
+
+  return (0);
+}
+
+
+//
+// 'open_common()' - Open a PDF file for reading.
+//
+// The file descriptor and mapped memory are closed/unmapped on error.
+//
+
+static pdfio_file_t *			// O - PDF file or `NULL` on error
+open_common(
+    const char          *filename,	// I - Filename
+    int                 fd,		// I - File descriptor or `-1` for memory
+    const char          *memdata,	// I - File data in memory or `NULL` for none
+    size_t              memsize,	// I - Size of file data in memory
+    bool                memmapped,	// I - Was the file data mapped with `mmap`?
+    pdfio_input_cb_t    input_cb,	// I - Input callback or `NULL` for none
+    void                *input_ctx,	// I - Input callback context
+    off_t               input_size,	// I - Size of file data from input callback
+    pdfio_password_cb_t password_cb,	// I - Password callback or `NULL` for none
+    void                *password_cbdata,
+					// I - Password callback data, if any
+    pdfio_error_cb_t    error_cb,	// I - Error callback
+    void                *error_cbdata)	// I - Error callback data, if any
+{
+  pdfio_file_t	*pdf;			// PDF file
+  char		line[1025],		// Line from file
+		*ptr,			// Pointer into line
+		*end;			// End of line
+  ssize_t	bytes;			// Bytes read
+  off_t		xref_offset;		// Offset to xref table
+
+
+  // Allocate a PDF file structure...
+  if ((pdf = (pdfio_file_t *)calloc(1, sizeof(pdfio_file_t))) == NULL)
+  {
+    pdfio_file_t temp;			// Dummy file
+    char	message[8192];		// Message string
+
+    temp.filename = (char *)filename;
+    snprintf(message, sizeof(message), "Unable to allocate memory for PDF file - %s", strerror(errno));
+    (error_cb)(&temp, message, error_cbdata);
+
+#ifndef _WIN32
+    if (memmapped)
+      munmap((void *)memdata, memsize);
+#endif // !_WIN32
+
+    if (fd >= 0)
+      close(fd);
+
+    return (NULL);
+  }
+
+  pdf->precision   = PDFIO_PRECISION_DEFAULT;
+  pdf->filename    = strdup(filename);
+  pdf->mode        = _PDFIO_MODE_READ;
+  pdf->error_cb    = error_cb;
+  pdf->error_data  = error_cbdata;
+  pdf->permissions = PDFIO_PERMISSION_ALL;
+  pdf->fd          = fd;
+
+  if (memdata)
+  {
+    // Read directly from memory...
+    pdf->memdata   = memdata;
+    pdf->memsize   = memsize;
+    pdf->memmapped = memmapped;
+    pdf->buffer    = (char *)memdata;
+    pdf->bufptr    = pdf->buffer;
+    pdf->bufend    = pdf->buffer + memsize;
+  }
+  else
+  {
+    // Read through the local buffer...
+    pdf->buffer = pdf->localbuf;
+  }
+
+  if (input_cb)
+  {
+    // Read through the block cache, starting with the end of the file that
+    // contains the trailer and (usually) the cross-reference table...
+    pdf->input_cb   = input_cb;
+    pdf->input_ctx  = input_ctx;
+    pdf->input_size = input_size;
+
+    if (!_pdfioFileCreateCache(pdf))
+      goto error;
+
+    if (input_size <= (_PDFIO_CACHE_RUN * _PDFIO_CACHE_BLOCK))
+      _pdfioFilePrefetch(pdf, 0, (size_t)input_size);
+    else
+      _pdfioFilePrefetch(pdf, input_size - _PDFIO_CACHE_BLOCK, _PDFIO_CACHE_BLOCK);
+  }
+
+  // Read the header from the first line...
+  if (!_pdfioFileGets(pdf, line, sizeof(line)))
+    goto error;
+
+  if ((strncmp(line, "%PDF-1.", 7) && strncmp(line, "%PDF-2.", 7)) || !isdigit(line[7] & 255))
+  {
+    // Bad header
+    _pdfioFileError(pdf, "Bad header '%s'.", line);
+    goto error;
+  }
+
+  // Copy the version number...
+  pdf->version = strdup(line + 5);
+
+  // Grab the last 1k of the file to find the start of the xref table...
+  if (_pdfioFileSeek(pdf, -1024, SEEK_END) < 0)
+  {
+    _pdfioFileError(pdf, "Unable to read startxref data.");
+    goto error;
+  }
+
+  if ((bytes = _pdfioFileRead(pdf, line, sizeof(line) - 1)) < 1)
+  {
+    _pdfioFileError(pdf, "Unable to read startxref data.");
+    goto error;
+  }
+
+  line[bytes] = '\0';
+  end = line + bytes - 9;
+
+  for (ptr = line; ptr < end; ptr ++)
+  {
+    if (!memcmp(ptr, "startxref", 9))
+      break;
+  }
+
+  if (ptr >= end)
+  {
+    _pdfioFileError(pdf, "Unable to find start of xref table.");
+    goto error;
+  }
+
+  xref_offset      = (off_t)strtol(ptr + 9, NULL, 10);
+  pdf->update_xref = xref_offset;
+
+  _pdfioFilePrefetch(pdf, xref_offset, _PDFIO_CACHE_AHEAD * _PDFIO_CACHE_BLOCK);
+
+  if (!load_xref(pdf, xref_offset, password_cb, password_cbdata))
+    goto error;
+
+  return (pdf);
+
+
+  // If we get here we had a fatal read error...
+  error:
+
+  pdfioFileClose(pdf);
+
+  return (NULL);
+}
+
+
+//
+// 'scan_linearized()' - Find the objects used by a page.
+//
+// Objects referenced by the value that have not been seen for the current
+// page are added to the work list.  Page objects, the page tree, the catalog,
+// and the information dictionary are marked so they are never added.
+//
+
+static void
+scan_linearized(pdfio_file_t   *pdf,	// I  - PDF file
+                _pdfio_value_t *v,	// I  - Value
+                size_t         page,	// I  - Page number (1-based)
+                size_t         *work,	// I  - Work list
+                size_t         *num_work)
+					// IO - Number of objects in work list
+{
+  size_t		i;		// Looping var
+  _pdfio_linobj_t	*lo;		// Object layout
+
+
+  switch (v->type)
+  {
+    case PDFIO_VALTYPE_ARRAY :
+        for (i = 0; i < v->value.array->num_values; i ++)
+          scan_linearized(pdf, v->value.array->values + i, page, work, num_work);
+        break;
+
+    case PDFIO_VALTYPE_DICT :
+        for (i = 0; i < v->value.dict->num_pairs; i ++)
+          scan_linearized(pdf, &v->value.dict->pairs[i].value, page, work, num_work);
+        break;
+
+    case PDFIO_VALTYPE_INDIRECT :
+        if (v->value.indirect.number < pdf->num_lin_objs)
+        {
+          lo = pdf->lin_objs + v->value.indirect.number;
+
+          if (lo->obj && lo->mark != page && lo->mark != SIZE_MAX)
+          {
+            lo->mark                = page;
+            work[(*num_work) ++] = v->value.indirect.number;
+          }
+        }
+        break;
+
+    default :
+        break;
+  }
+}
+
+
+//
+// 'sort_sparse_objs()' - Sort the objects outside the object number index.
+//
+
+static void
+sort_sparse_objs(pdfio_file_t *pdf)	// I - PDF file
+{
+  if (pdf->sorted_sparse_objs < pdf->num_sparse_objs)
+  {
+    qsort(pdf->sparse_objs, pdf->num_sparse_objs, sizeof(pdfio_obj_t *), (int (*)(const void *, const void *))compare_objs);
+    pdf->sorted_sparse_objs = pdf->num_sparse_objs;
+  }
+}
+
+
+//
+// 'write_linearized()' - Write a linearized PDF file.
+//
+// The objects in the temporary file are renumbered and written in the order
+// described in Annex F of the PDF specification: the linearization dictionary,
+// the first page cross-reference table and trailer, the catalog, the primary
+// hint stream, the objects used by the first page, the objects used by each of
+// the remaining pages, the objects that are shared by several pages, all other
+// objects, and finally the main cross-reference table.
+//
+
+static bool				// O - `true` on success, `false` on failure
+write_linearized(pdfio_file_t *pdf)	// I - PDF file
+{
+  bool		ret = false;		// Return value
+  size_t	i, j,			// Looping vars
+		number,			// Object number
+		num_lin,		// Number of object layouts
+		num_objs,		// Number of objects in file order
+		num_first,		// Number of objects in the first page section
+		num_shared = 0,		// Number of shared objects
+		num_main,		// Number of objects in the main section
+		first_number,		// Object number of linearization dictionary
+		first_end,		// End of first page objects in file order
+		shared_start,		// Start of shared objects in file order
+		rest_start,		// Start of other objects in file order
+		*order = NULL,		// Object numbers in file order
+		*ends = NULL,		// End of each page's objects in file order
+		*work = NULL,		// Work list
+		num_work,		// Number of objects in work list
+		*refs = NULL,		// Objects referenced by each page
+		num_refs = 0,		// Number of references
+		alloc_refs = 0,		// Allocated references
+		*ref_start = NULL,	// Start of references for each page
+		id_offset,		// Offset of file ID in spool buffer
+		id_length,		// Length of file ID
+		nobjs,			// Number of objects for page
+		page_length,		// Length of page
+		nshared,		// Number of shared objects for page
+		min_nobjs, max_nobjs,	// Range of objects per page
+		min_length, max_length,	// Range of page/group lengths
+		max_nshared,		// Maximum number of shared objects per page
+		bits_nobjs,		// Bits for number of objects
+		bits_length,		// Bits for page/group length
+		bits_nshared,		// Bits for number of shared objects
+		bits_shared,		// Bits for shared object identifiers
+		bit,			// Current bit in hint data
+		hint_size,		// Allocated size of hint data
+		hint_datalen,		// Length of hint data
+		hint_s,			// Offset of shared object hint table
+		hint_length;		// Length of hint stream object
+  off_t		offset,			// Current offset
+		lin_offset,		// Offset of linearization dictionary
+		fpxref_offset,		// Offset of first page xref table
+		hint_offset,		// Offset of hint stream object
+		first_page_end = 0,	// End of first page section
+		xref_offset,		// Offset of main xref table
+		file_length;		// Length of PDF file
+  unsigned char	*hint = NULL;		// Hint data
+  _pdfio_linobj_t *lo;			// Current object layout
+  pdfio_obj_t	*obj;			// Current object
+  _pdfio_value_t value,			// ID value
+		*length;		// Length value
+  char		lin_text[256],		// Linearization dictionary
+		trailer_text[256],	// Start of first page trailer
+		prev_text[256],		// End of first page trailer
+		main_text[256];		// End of main xref table
+  size_t	lin_length,		// Length of linearization dictionary
+		fpxref_length,		// Length of first page xref table
+		main_length;		// Length of main xref table
+  static const char *endstream = "\nendstream\nendobj\n";
+					// End of stream object
+
+
+  // Write any pending streams...
+  if (!_pdfioStreamFlushParallel(pdf, true) || !_pdfioFileFlush(pdf))
+    return (false);
+
+  if (pdf->num_pages == 0)
+  {
+    _pdfioFileError(pdf, "Linearized PDF files require at least one page.");
+    return (false);
+  }
+
+  // Allocate memory for the object layouts...
+  for (i = 0, num_lin = 0; i < pdf->num_objs; i ++)
+  {
+    if (pdf->objs[i]->number >= num_lin)
+      num_lin = pdf->objs[i]->number + 1;
+  }
+
+  pdf->lin_objs     = (_pdfio_linobj_t *)calloc(num_lin, sizeof(_pdfio_linobj_t));
+  pdf->num_lin_objs = num_lin;
+  order             = (size_t *)calloc(num_lin, sizeof(size_t));
+  work              = (size_t *)calloc(num_lin, sizeof(size_t));
+  ends              = (size_t *)calloc(pdf->num_pages + 2, sizeof(size_t));
+  ref_start         = (size_t *)calloc(pdf->num_pages + 2, sizeof(size_t));
+
+  if (!pdf->lin_objs || !order || !work || !ends || !ref_start)
+  {
+    _pdfioFileError(pdf, "Unable to allocate memory for linearized PDF file.");
+    goto done;
+  }
+
+  for (i = 0; i < pdf->num_objs; i ++)
+    pdf->lin_objs[pdf->objs[i]->number].obj = pdf->objs[i];
+
+  if (pdf->pages_obj)
+    pdf->lin_objs[pdf->pages_obj->number].mark = SIZE_MAX;
+  for (i = 0; i < pdf->num_page_nodes; i ++)
+    pdf->lin_objs[pdf->page_nodes[i]->number].mark = SIZE_MAX;
+  if (pdf->root_obj)
+    pdf->lin_objs[pdf->root_obj->number].mark = SIZE_MAX;
+  if (pdf->info_obj)
+    pdf->lin_objs[pdf->info_obj->number].mark = SIZE_MAX;
+
+  for (i = 0; i < pdf->num_pages; i ++)
+  {
+    obj = pdf->pages[i];
+    lo  = pdf->lin_objs + obj->number;
+
+    if (lo->page || !obj->offset)
+    {
+      _pdfioFileError(pdf, "Unable to linearize page %lu.", (unsigned long)(i + 1));
+      goto done;
+    }
+
+    lo->page = i + 1;
+    lo->mark = SIZE_MAX;
+  }
+
+  // Find the objects used by each page - objects used by the first page stay
+  // with it, and objects used by more than one of the other pages are
+  // shared...
+  for (i = 1; i <= pdf->num_pages; i ++)
+  {
+    ref_start[i] = num_refs;
+    num_work     = 0;
+
+    scan_linearized(pdf, &pdf->pages[i - 1]->value, i, work, &num_work);
+
+    while (num_work > 0)
+    {
+      number = work[-- num_work];
+      lo     = pdf->lin_objs + number;
+
+      if (!lo->page)
+        lo->page = i;
+      else if (lo->page != 1)
+        lo->page = SIZE_MAX;
+
+      if (i > 1)
+      {
+        if (num_refs >= alloc_refs)
+        {
+          size_t *temp;			// New references
+
+          alloc_refs = alloc_refs ? 2 * alloc_refs : 1024;
+
+          if ((temp = (size_t *)realloc(refs, alloc_refs * sizeof(size_t))) == NULL)
+          {
+	    _pdfioFileError(pdf, "Unable to allocate memory for linearized PDF file.");
+	    goto done;
+          }
+
+          refs = temp;
+        }
+
+        refs[num_refs ++] = number;
+      }
+
+      scan_linearized(pdf, &lo->obj->value, i, work, &num_work);
+    }
+  }
+
+  ref_start[i] = num_refs;
+
+  // Put the objects in file order, starting with the catalog...
+  for (number = 1; number < num_lin; number ++)
+  {
+    lo = pdf->lin_objs + number;
+
+    if (!lo->obj)
+      continue;
+
+    if (!lo->obj->offset)
+      lo->page = 0;			// Not written, always in the main section
+    else if (lo->page == SIZE_MAX)
+      num_shared ++;
+    else if (lo->page)
+      ends[lo->page] ++;
+  }
+
+  for (i = 1, j = 1; i <= pdf->num_pages; i ++)
+  {
+    number  = ends[i];
+    ends[i] = j;
+    j       += number;
+  }
+
+  shared_start = j;
+  rest_start   = j + num_shared;
+  order[0]     = pdf->root_obj->number;
+
+  for (i = 1; i <= pdf->num_pages; i ++)
+    order[ends[i] ++] = pdf->pages[i - 1]->number;
+
+  for (number = 1, num_objs = rest_start; number < num_lin; number ++)
+  {
+    lo = pdf->lin_objs + number;
+
+    if (!lo->obj || lo->obj == pdf->root_obj)
+      continue;
+    else if (lo->page == SIZE_MAX)
+      order[shared_start ++] = number;
+    else if (!lo->page)
+      order[num_objs ++] = number;
+    else if (lo->obj != pdf->pages[lo->page - 1])
+      order[ends[lo->page] ++] = number;
+  }
+
+  shared_start = rest_start - num_shared;
+  first_end    = ends[1];
+  num_first    = first_end - 1;
+  num_main     = num_objs - first_end;
+  first_number = num_main + 1;
+
+  // Assign new object numbers - the main section has the objects for the
+  // remaining pages, followed by the first page section with the
+  // linearization dictionary, catalog, hint stream, and first page
+  // objects...
+  pdf->lin_objs[order[0]].number = first_number + 1;
+
+  for (i = 1; i < first_end; i ++)
+  {
+    pdf->lin_objs[order[i]].number = first_number + i + 2;
+    pdf->lin_objs[order[i]].shared = i - 1;
+  }
+
+  for (i = first_end; i < num_objs; i ++)
+  {
+    pdf->lin_objs[order[i]].number = i - first_end + 1;
+
+    if (i >= shared_start && i < rest_start)
+      pdf->lin_objs[order[i]].shared = num_first + i - shared_start;
+  }
+
+  // Write the object text to the spool buffer...
+  pdf->spoollen = 0;
+
+  if (!_pdfioFileBeginSpool(pdf))
+    goto done;
+
+  for (i = 0; i < num_objs; i ++)
+  {
+    lo  = pdf->lin_objs + order[i];
+    obj = lo->obj;
+
+    if (!obj->offset)
+      continue;
+
+    if (obj->stream_offset && obj->value.type == PDFIO_VALTYPE_DICT && ((length = _pdfioDictGetValue(obj->value.value.dict, _pdfio_keys[_PDFIO_KEY_LENGTH])) == NULL || length->type != PDFIO_VALTYPE_INDIRECT))
+      pdfioDictSetNumber(obj->value.value.dict, "Length", (double)obj->stream_length);
+
+    lo->text_offset = (size_t)_pdfioFileTell(pdf);
+
+    if (!_pdfioFilePrintf(pdf, "%lu 0 obj\n", (unsigned long)lo->number) || !_pdfioValueWrite(pdf, obj, &obj->value, NULL) || !_pdfioFilePuts(pdf, obj->stream_offset ? "\nstream\n" : "\nendobj\n"))
+    {
+      _pdfioFileEndSpool(pdf);
+      goto done;
+    }
+
+    lo->text_length = (size_t)_pdfioFileTell(pdf) - lo->text_offset;
+  }
+
+  id_offset = (size_t)_pdfioFileTell(pdf);
+
+  if (pdf->id_array)
+  {
+    value.type        = PDFIO_VALTYPE_ARRAY;
+    value.value.array = pdf->id_array;
+
+    if (!_pdfioFilePuts(pdf, "/ID") || !_pdfioValueWrite(pdf, NULL, &value, NULL))
+    {
+      _pdfioFileEndSpool(pdf);
+      goto done;
+    }
+  }
+
+  id_length = (size_t)_pdfioFileTell(pdf) - id_offset;
+
+  if (!_pdfioFileEndSpool(pdf))
+    goto done;
+
+  // Switch back to the PDF file...
+  pdf->fd         = pdf->lin_outfd;
+  pdf->output_cb  = pdf->lin_output_cb;
+  pdf->output_ctx = pdf->lin_output_ctx;
+  pdf->bufpos     = pdf->lin_offset;
+  pdf->bufptr     = pdf->buffer;
+
+  // Lay out the file without the hint stream, since offsets in the hint tables
+  // are computed as if the hint stream was not present...
+  snprintf(lin_text, sizeof(lin_text), "%lu 0 obj\n<</Linearized 1/L %-10lu/H[%-10lu %-10lu]/O %lu/E %-10lu/N %lu/T %-10lu>>\nendobj\n", (unsigned long)first_number, 0UL, 0UL, 0UL, (unsigned long)(first_number + 3), 0UL, (unsigned long)pdf->num_pages, 0UL);
+  snprintf(trailer_text, sizeof(trailer_text), "xref\n%lu %lu\n", (unsigned long)first_number, (unsigned long)(num_first + 3));
+  fpxref_length = strlen(trailer_text) + 20 * (num_first + 3);
+  snprintf(trailer_text, sizeof(trailer_text), "trailer\n<</Size %lu/Root %lu 0 R/Info %lu 0 R", (unsigned long)(first_number + num_first + 3), (unsigned long)(first_number + 1), (unsigned long)pdf->lin_objs[pdf->info_obj->number].number);
+  snprintf(prev_text, sizeof(prev_text), "/Prev %-10lu>>\nstartxref\n0\n%%%%EOF\n", 0UL);
+
+  lin_length    = strlen(lin_text);
+  fpxref_length += strlen(trailer_text) + id_length + strlen(prev_text);
+  lin_offset    = pdf->lin_offset;
+  fpxref_offset = lin_offset + (off_t)lin_length;
+  offset        = fpxref_offset + (off_t)fpxref_length;
+  hint_offset   = 0;
+
+  for (i = 0; i < num_objs; i ++)
+  {
+    lo = pdf->lin_objs + order[i];
+
+    if (!lo->obj->offset)
+      continue;
+
+    lo->offset = offset;
+    lo->length = lo->text_length;
+
+    if (lo->obj->stream_offset)
+      lo->length += lo->obj->stream_length + strlen(endstream);
+
+    offset += (off_t)lo->length;
+
+    if (i == 0)
+      hint_offset = offset;
+    else if (i == (first_end - 1))
+      first_page_end = offset;
+  }
+
+  xref_offset = offset;
+
+  // Build the hint tables, starting with the range of values for each page...
+  for (i = 1, min_nobjs = SIZE_MAX, max_nobjs = 0, min_length = SIZE_MAX, max_length = 0, max_nshared = 0; i <= pdf->num_pages; i ++)
+  {
+    for (j = i == 1 ? 1 : ends[i - 1], nobjs = 0, page_length = 0; j < ends[i]; j ++, nobjs ++)
+      page_length += pdf->lin_objs[order[j]].length;
+
+    for (j = ref_start[i], nshared = 0; j < ref_start[i + 1]; j ++)
+    {
+      if (pdf->lin_objs[refs[j]].page == 1 || pdf->lin_objs[refs[j]].page == SIZE_MAX)
+        nshared ++;
+    }
+
+    if (nobjs < min_nobjs)
+      min_nobjs = nobjs;
+    if (nobjs > max_nobjs)
+      max_nobjs = nobjs;
+    if (page_length < min_length)
+      min_length = page_length;
+    if (page_length > max_length)
+      max_length = page_length;
+    if (nshared > max_nshared)
+      max_nshared = nshared;
+  }
+
+  bits_nobjs   = hint_bits(max_nobjs - min_nobjs);
+  bits_length  = hint_bits(max_length - min_length);
+  bits_nshared = hint_bits(max_nshared);
+  bits_shared  = hint_bits(num_first + num_shared - 1);
+  hint_size    = 64 + 4 * (5 * pdf->num_pages + num_refs + 2 * (num_first + num_shared));
+
+  if ((hint = (unsigned char *)calloc(1, hint_size)) == NULL)
+  {
+    _pdfioFileError(pdf, "Unable to allocate memory for linearized PDF file.");
+    goto done;
+  }
+
+  // Page offset hint table header...
+  bit = 0;
+  add_hint_bits(hint, &bit, min_nobjs, 32);
+  add_hint_bits(hint, &bit, (size_t)pdf->lin_objs[order[1]].offset, 32);
+  add_hint_bits(hint, &bit, bits_nobjs, 16);
+  add_hint_bits(hint, &bit, min_length, 32);
+  add_hint_bits(hint, &bit, bits_length, 16);
+  add_hint_bits(hint, &bit, 0, 32);	// Content stream offsets are not used
+  add_hint_bits(hint, &bit, 0, 16);
+  add_hint_bits(hint, &bit, min_length, 32);
+  add_hint_bits(hint, &bit, bits_length, 16);
+  add_hint_bits(hint, &bit, bits_nshared, 16);
+  add_hint_bits(hint, &bit, bits_shared, 16);
+  add_hint_bits(hint, &bit, 0, 16);	// No fractional shared object references
+  add_hint_bits(hint, &bit, 1, 16);
+
+  // Page offset hint table entries - each item is a separate byte-aligned
+  // array for all pages...
+  for (i = 1; i <= pdf->num_pages; i ++)
+    add_hint_bits(hint, &bit, ends[i] - (i == 1 ? 1 : ends[i - 1]) - min_nobjs, bits_nobjs);
+
+  bit = (bit + 7) & ~(size_t)7;
+
+  for (number = 0; number < 2; number ++)
+  {
+    // Page lengths, then content stream lengths (the same values)...
+    for (i = 1; i <= pdf->num_pages; i ++)
+    {
+      for (j = i == 1 ? 1 : ends[i - 1], page_length = 0; j < ends[i]; j ++)
+	page_length += pdf->lin_objs[order[j]].length;
+
+      add_hint_bits(hint, &bit, page_length - min_length, bits_length);
+    }
+
+    bit = (bit + 7) & ~(size_t)7;
+
+    if (number)
+      break;
+
+    // Number of shared objects and shared object identifiers...
+    for (i = 1; i <= pdf->num_pages; i ++)
+    {
+      for (j = ref_start[i], nshared = 0; j < ref_start[i + 1]; j ++)
+      {
+	if (pdf->lin_objs[refs[j]].page == 1 || pdf->lin_objs[refs[j]].page == SIZE_MAX)
+	  nshared ++;
+      }
+
+      add_hint_bits(hint, &bit, nshared, bits_nshared);
+    }
+
+    bit = (bit + 7) & ~(size_t)7;
+
+    for (i = 1; i <= pdf->num_pages; i ++)
+    {
+      for (j = ref_start[i]; j < ref_start[i + 1]; j ++)
       {
-        if (index_count == 1)
-        {
-          number = 0;
-          count  = 999999999;
-	}
-	else
-	{
-          number = (intmax_t)pdfioArrayGetNumber(index_array, index_n);
-          count  = (size_t)pdfioArrayGetNumber(index_array, index_n + 1);
-	}
+        lo = pdf->lin_objs + refs[j];
 
-	while (count > 0 && pdfioStreamRead(st, buffer, w_total) > 0)
-	{
-	  count --;
+	if (lo->page == 1 || lo->page == SIZE_MAX)
+	  add_hint_bits(hint, &bit, lo->shared, bits_shared);
+      }
+    }
 
-	  PDFIO_DEBUG("load_xref: number=%u %02X%02X%02X%02X%02X\n", (unsigned)number, buffer[0], buffer[1], buffer[2], buffer[3], buffer[4]);
+    bit = (bit + 7) & ~(size_t)7;
+  }
 
-	  // Check whether this is an object definition...
-	  if (w[0] > 0)
-	  {
-	    if (buffer[0] == 0)
-	    {
-	      // Ignore free objects...
-	      number ++;
-	      continue;
-	    }
-	  }
+  // Shared object hint table - the first page objects are followed by the
+  // shared objects, each in its own group...
+  hint_s = bit / 8;
 
-          // Offset
-	  for (i = 1, offset = buffer[w_2]; i < w[1]; i ++)
-	    offset = (offset << 8) | buffer[w_2 + i];
+  for (i = 1, min_length = SIZE_MAX, max_length = 0; i < rest_start; i ++)
+  {
+    if (i == first_end)
+      i = shared_start;
 
-          // Generation number
-	  switch (w[2])
-	  {
-	    default :
-		generation = 0;
-		break;
-	    case 1 :
-		generation = buffer[w_3];
-		break;
-	    case 2 :
-		generation = (buffer[w_3] << 8) | buffer[w_3 + 1];
-		break;
-	    case 3 :
-	        // Issue #46: Stupid Microsoft PDF generator using 3 bytes to
-	        // encode 16-bit generation numbers == 0 (probably a lazy coder
-	        // stuffing things into an array of 64-bit unsigned integers)
-		generation = (buffer[w_3] << 16) | (buffer[w_3 + 1] << 8) | buffer[w_3 + 2];
-		if (generation > 65535)
-		  generation = 65535;
-		break;
-	    case 4 : // Even stupider :)
-		generation = (buffer[w_3] << 24) | (buffer[w_3 + 1] << 16) | (buffer[w_3 + 2] << 8) | buffer[w_3 + 3];
-		if (generation > 65535)
-		  generation = 65535;
-		break;
-	  }
+    if (i >= rest_start)
+      break;
 
-	  // Create a placeholder for the object in memory...
-	  if ((current = pdfioFileFindObj(pdf, (size_t)number)) != NULL)
-	  {
-	    PDFIO_DEBUG("load_xref: existing object, prev offset=%u\n", (unsigned)current->offset);
+    lo = pdf->lin_objs + order[i];
 
-            if (w[0] == 0 || buffer[0] == 1)
-            {
-              // Location of object...
-	      current->offset = offset;
-	    }
-	    else if (number != offset)
-	    {
-	      // Object is part of a stream, offset is the object number...
-	      current->offset = 0;
-	    }
+    if (lo->length < min_length)
+      min_length = lo->length;
+    if (lo->length > max_length)
+      max_length = lo->length;
+  }
 
-	    PDFIO_DEBUG("load_xref: new offset=%u\n", (unsigned)current->offset);
-	  }
+  bits_length = hint_bits(max_length - min_length);
 
-	  if (w[0] > 0 && buffer[0] == 2)
-	  {
-	    // Object streams need to be loaded into memory, so add them
-	    // to the list of objects to load later as needed...
-	    for (i = 0; i < num_sobjs; i ++)
-	    {
-	      if (sobjs[i] == (size_t)offset)
-		break;
-	    }
+  add_hint_bits(hint, &bit, num_shared ? pdf->lin_objs[order[shared_start]].number : 0, 32);
+  add_hint_bits(hint, &bit, num_shared ? (size_t)pdf->lin_objs[order[shared_start]].offset : 0, 32);
+  add_hint_bits(hint, &bit, num_first, 32);
+  add_hint_bits(hint, &bit, num_first + num_shared, 32);
+  add_hint_bits(hint, &bit, 0, 16);	// One object per group
+  add_hint_bits(hint, &bit, min_length, 32);
+  add_hint_bits(hint, &bit, bits_length, 16);
 
-	    if (i >= num_sobjs)
-	    {
-	      if (num_sobjs < (sizeof(sobjs) / sizeof(sobjs[0])))
-	      {
-		sobjs[num_sobjs ++] = (size_t)offset;
-	      }
-	      else
-	      {
-		_pdfioFileError(pdf, "Too many object streams.");
-	        return (false);
-	      }
-	    }
-	  }
-	  else if (!current)
-	  {
-	    // Add this object...
-	    if (!add_obj(pdf, (size_t)number, (unsigned short)generation, offset))
-	      return (false);
-	  }
+  for (i = 1; i < rest_start; i ++)
+  {
+    if (i == first_end)
+      i = shared_start;
 
-	  number ++;
-	}
-      }
+    if (i >= rest_start)
+      break;
 
-      pdfioStreamClose(st);
+    add_hint_bits(hint, &bit, pdf->lin_objs[order[i]].length - min_length, bits_length);
+  }
 
-      if (!pdf->trailer_dict)
-      {
-	// Save the trailer dictionary and grab the root (catalog) and info
-	// objects...
-	pdf->trailer_dict = trailer.value.dict;
-	pdf->encrypt_obj  = pdfioDictGetObj(pdf->trailer_dict, "Encrypt");
-	pdf->id_array     = pdfioDictGetArray(pdf->trailer_dict, "ID");
+  bit = (bit + 7) & ~(size_t)7;
+  bit += 8 * ((num_first + num_shared + 7) / 8);
+					// No MD5 signatures
 
-	// If the trailer contains an Encrypt key, try unlocking the file...
-	if (pdf->encrypt_obj && !_pdfioCryptoUnlock(pdf, password_cb, password_data))
-	  return (false);
-      }
+  hint_datalen = bit / 8;
 
-      // Load any object streams that are left...
-      PDFIO_DEBUG("load_xref: %lu compressed object streams to load.\n", (unsigned long)num_sobjs);
+  // Now insert the hint stream after the catalog...
+  snprintf(main_text, sizeof(main_text), "%lu 0 obj\n<</S %lu/Length %lu>>\nstream\n", (unsigned long)(first_number + 2), (unsigned long)hint_s, (unsigned long)hint_datalen);
+  hint_length = strlen(main_text) + hint_datalen + strlen(endstream);
 
-      for (i = 0; i < num_sobjs; i ++)
-      {
-        if ((obj = pdfioFileFindObj(pdf, sobjs[i])) != NULL)
-        {
-	  PDFIO_DEBUG("load_xref: Loading compressed object stream %lu (pdf=%p, obj->pdf=%p).\n", (unsigned long)sobjs[i], pdf, obj->pdf);
+  for (i = 1; i < num_objs; i ++)
+  {
+    if (pdf->lin_objs[order[i]].offset)
+      pdf->lin_objs[order[i]].offset += (off_t)hint_length;
+  }
 
-          if (!load_obj_stream(obj))
-            return (false);
-	}
-	else
-	{
-	  _pdfioFileError(pdf, "Unable to find compressed object stream %lu.", (unsigned long)sobjs[i]);
-	  return (false);
-	}
-      }
+  first_page_end += (off_t)hint_length;
+  xref_offset    += (off_t)hint_length;
+
+  // Write the linearization dictionary and first page xref table...
+  snprintf(main_text, sizeof(main_text), "xref\n0 %lu\n", (unsigned long)first_number);
+  snprintf(prev_text, sizeof(prev_text), "trailer\n<</Size %lu>>\nstartxref\n%lu\n%%%%EOF\n", (unsigned long)first_number, (unsigned long)fpxref_offset);
+  main_length = strlen(main_text) + 20 * first_number + strlen(prev_text);
+  file_length = xref_offset + (off_t)main_length;
+
+  if (!_pdfioFilePrintf(pdf, "%lu 0 obj\n<</Linearized 1/L %-10lu/H[%-10lu %-10lu]/O %lu/E %-10lu/N %lu/T %-10lu>>\nendobj\n", (unsigned long)first_number, (unsigned long)file_length, (unsigned long)hint_offset, (unsigned long)hint_length, (unsigned long)(first_number + 3), (unsigned long)first_page_end, (unsigned long)pdf->num_pages, (unsigned long)(xref_offset + (off_t)strlen(main_text) - 1)))
+    goto done;
+
+  if (!_pdfioFilePrintf(pdf, "xref\n%lu %lu\n%010lu 00000 n \n%010lu 00000 n \n%010lu 00000 n \n", (unsigned long)first_number, (unsigned long)(num_first + 3), (unsigned long)lin_offset, (unsigned long)pdf->lin_objs[order[0]].offset, (unsigned long)hint_offset))
+    goto done;
+
+  for (i = 1; i < first_end; i ++)
+  {
+    if (!_pdfioFilePrintf(pdf, "%010lu 00000 n \n", (unsigned long)pdf->lin_objs[order[i]].offset))
+      goto done;
+  }
+
+  if (!_pdfioFilePuts(pdf, trailer_text) || !_pdfioFileWrite(pdf, pdf->spool + id_offset, id_length) || !_pdfioFilePrintf(pdf, "/Prev %-10lu>>\nstartxref\n0\n%%%%EOF\n", (unsigned long)xref_offset))
+    goto done;
+
+  // Write the objects...
+  for (i = 0; i < num_objs; i ++)
+  {
+    lo  = pdf->lin_objs + order[i];
+    obj = lo->obj;
+
+    if (!obj->offset)
+      continue;
+
+    if (_pdfioFileTell(pdf) != lo->offset)
+    {
+      _pdfioFileError(pdf, "Unable to write object %lu at the expected offset.", (unsigned long)lo->number);
+      goto done;
     }
-    else if (!strncmp(line, "xref", 4) && (!line[4] || isspace(line[4] & 255)))
+
+    if (!_pdfioFileWrite(pdf, pdf->spool + lo->text_offset, lo->text_length))
+      goto done;
+
+    if (obj->stream_offset && (!copy_linearized(pdf, obj->stream_offset, obj->stream_length) || !_pdfioFilePuts(pdf, endstream)))
+      goto done;
+
+    if (i == 0)
     {
-      // Read the xref tables
-      off_t trailer_offset = _pdfioFileTell(pdf);
-					// Offset of current line
+      // Write the primary hint stream after the catalog...
+      if (!_pdfioFilePrintf(pdf, "%lu 0 obj\n<</S %lu/Length %lu>>\nstream\n", (unsigned long)(first_number + 2), (unsigned long)hint_s, (unsigned long)hint_datalen) || !_pdfioFileWrite(pdf, hint, hint_datalen) || !_pdfioFilePuts(pdf, endstream))
+        goto done;
+    }
+  }
 
-      PDFIO_DEBUG("load_xref: Reading xref table starting at offset %lu\n", (unsigned long)trailer_offset);
-      while (_pdfioFileGets(pdf, line, sizeof(line)))
-      {
-        PDFIO_DEBUG("load_xref: '%s' at offset %lu\n", line, (unsigned long)trailer_offset);
+  // Write the main xref table and trailer...
+  if (!_pdfioFilePuts(pdf, main_text) || !_pdfioFilePuts(pdf, "0000000000 65535 f \n"))
+    goto done;
 
-	if (!strncmp(line, "trailer", 7) && (!line[7] || isspace(line[7] & 255) || line[7] == '<'))
-	{
-	  if (line[7])
-	  {
-	    // Probably the start of the trailer dictionary, rewind the file so
-	    // we can read it...
-	    _pdfioFileSeek(pdf, trailer_offset + 7, SEEK_SET);
-	  }
+  for (i = first_end; i < num_objs; i ++)
+  {
+    lo = pdf->lin_objs + order[i];
 
-	  break;
-	}
-	else
-	{
-	  trailer_offset = _pdfioFileTell(pdf);
+    if (lo->obj->offset)
+    {
+      if (!_pdfioFilePrintf(pdf, "%010lu 00000 n \n", (unsigned long)lo->offset))
+        goto done;
+    }
+    else if (!_pdfioFilePuts(pdf, "0000000000 00001 f \n"))
+      goto done;
+  }
 
-          if (!line[0])
-	    continue;
-	}
+  ret = _pdfioFilePuts(pdf, prev_text);
+
+  done:
+
+  if (!ret)
+    _pdfioFileError(pdf, "Unable to write linearized PDF file.");
+
+  free(pdf->lin_objs);
+  pdf->lin_objs     = NULL;
+  pdf->num_lin_objs = 0;
+
+  free(order);
+  free(work);
+  free(ends);
+  free(refs);
+  free(ref_start);
+  free(hint);
+
+  return (ret);
+}
+
+
+//
+// 'write_page_node()' - Write a page tree node.
+//
+
+static bool				// O - `true` on success, `false` on failure
+write_page_node(pdfio_file_t   *pdf,	// I - PDF file
+                _pdfio_pnode_t *node,	// I - Page tree node
+                pdfio_obj_t    *parent)	// I - Parent pages object or `NULL` for the root
+{
+  size_t	i;			// Looping var
+  pdfio_dict_t	*dict;			// Pages dictionary
+  pdfio_array_t	*kids;			// Kids array
+
+
+  // Create the pages dictionary, reusing the original pages object...
+  if (node->obj == pdf->pages_obj)
+  {
+    dict = pdfioObjGetDict(node->obj);
+  }
+  else
+  {
+    if ((dict = pdfioDictCreate(pdf)) == NULL)
+      return (false);
+
+    pdfioDictSetName(dict, "Type", "Pages");
+
+    node->obj->value.type       = PDFIO_VALTYPE_DICT;
+    node->obj->value.value.dict = dict;
+  }
+
+  if ((kids = pdfioArrayCreate(pdf)) == NULL)
+    return (false);
+
+  for (i = 0; i < node->num_kids; i ++)
+    pdfioArrayAppendObj(kids, node->kids[i]);
+
+  pdfioDictSetNumber(dict, "Count", node->count);
+  pdfioDictSetArray(dict, "Kids", kids);
+
+  if (parent)
+    pdfioDictSetObj(dict, "Parent", parent);
+
+  // Free the node dictionary once it is written when streaming...
+  if (pdf->options & PDFIO_OPTION_STREAMING)
+    node->obj->release = true;
+
+  if (!pdfioObjClose(node->obj))
+    return (false);
+
+  _pdfioObjRelease(node->obj);
+
+  // Then free the pages and nodes below it since they are no longer needed...
+  for (i = 0; i < node->num_kids; i ++)
+    _pdfioFileFreeObj(pdf, node->kids[i]);
+
+  return (true);
+}
+
+
+//
+// 'write_pages()' - Write the PDF pages objects.
+//
+// When appending an incremental update, any new pages are added to the
+// original root pages object.  Otherwise the remaining nodes of the balanced
+// page tree are written, with the top node becoming the root pages object.
+//
+
+static bool				// O - `true` on success, `false` on failure
+write_pages(pdfio_file_t *pdf)		// I - PDF file
+{
+  pdfio_array_t	*kids;			// Pages array
+  size_t	i,			// Looping var
+		level;			// Page tree level
+  _pdfio_pnode_t *node;			// Root page tree node
+
+
+  if (pdf->update)
+  {
+    // Add any new pages to the original page tree...
+    pdfio_dict_t	*dict = pdfioObjGetDict(pdf->pages_obj);
+					// Pages dictionary
+    pdfio_obj_t		*kids_obj = NULL;
+					// Indirect Kids array, if any
+
+    if (pdf->num_pages == pdf->update_num_pages)
+      return (true);
+
+    if (!dict)
+    {
+      _pdfioFileError(pdf, "Unable to find pages object.");
+      return (false);
+    }
+
+    if ((kids_obj = pdfioDictGetObj(dict, "Kids")) != NULL)
+      kids = pdfioObjGetArray(kids_obj);
+    else
+      kids = pdfioDictGetArray(dict, "Kids");
+
+    if (!kids)
+    {
+      if ((kids = pdfioArrayCreate(pdf)) == NULL)
+        return (false);
+
+      kids_obj = NULL;
+      pdfioDictSetArray(dict, "Kids", kids);
+    }
+
+    for (i = pdf->update_num_pages; i < pdf->num_pages; i ++)
+      pdfioArrayAppendObj(kids, pdf->pages[i]);
+
+    pdfioDictSetNumber(dict, "Count", pdf->num_pages);
+
+    if (kids_obj && !pdfioObjClose(kids_obj))
+      return (false);
+
+    return (pdfioObjClose(pdf->pages_obj));
+  }
+
+  if (pdf->num_page_levels == 0)
+  {
+    // Build the "Kids" array pointing to each page...
+    if ((kids = pdfioArrayCreate(pdf)) == NULL)
+      return (false);
+
+    for (i = 0; i < pdf->num_pages; i ++)
+      pdfioArrayAppendObj(kids, pdf->pages[i]);
+
+    pdfioDictSetNumber(pdf->pages_obj->value.value.dict, "Count", pdf->num_pages);
+    pdfioDictSetArray(pdf->pages_obj->value.value.dict, "Kids", kids);
+
+    // Write the Pages object...
+    return (pdfioObjClose(pdf->pages_obj));
+  }
+
+  // Write the nodes below the top level of the page tree, which may add
+  // another level when the current top node is full...
+  for (level = 0; level < (pdf->num_page_levels - 1); level ++)
+  {
+    if (!close_page_node(pdf, level))
+      return (false);
+  }
+
+  // Point the catalog at the root node and write it...
+  node = pdf->page_levels + pdf->num_page_levels - 1;
+
+  pdfioDictSetObj(pdfioObjGetDict(pdf->root_obj), "Pages", node->obj);
+
+  if (!write_page_node(pdf, node, NULL))
+    return (false);
+
+  pdf->pages_obj = node->obj;
+
+  return (true);
+}
+
+
+//
+// 'write_trailer()' - Write the PDF catalog object, xref table, and trailer.
+//
+
+static bool				// O - `true` on success, `false` on failure
+write_trailer(pdfio_file_t *pdf)	// I - PDF file
+{
+  bool		ret = true;		// Return value
+  off_t		xref_offset;		// Offset to xref table
+  size_t	i, j, k;		// Looping vars
+  bool		xref_stream;		// Write a cross-reference stream?
 
-	if (sscanf(line, "%jd%jd", &number, &num_objects) != 2)
-	{
-	  _pdfioFileError(pdf, "Malformed xref table section '%s'.", line);
-	  return (false);
-	}
 
-	// Read this group of objects...
-	for (; num_objects > 0; num_objects --, number ++)
-	{
-	  // Read a line from the file and validate it...
-	  if (_pdfioFileRead(pdf, line, 20) != 20)
-	    return (false);
+  // Write any pending compressed objects and streams...
+  if (!flush_obj_stream(pdf) || !_pdfioStreamFlushParallel(pdf, true))
+    return (false);
 
-	  line[20] = '\0';
+  // An incremental update uses the same kind of cross-reference data as the
+  // original file...
+  xref_stream = (pdf->options & PDFIO_OPTION_OBJSTREAMS) || pdf->num_objstms > 0;
 
-	  if (strcmp(line + 18, "\r\n") && strcmp(line + 18, " \n") && strcmp(line + 18, " \r"))
-	  {
-	    _pdfioFileError(pdf, "Malformed xref table entry '%s'.", line);
-	    return (false);
-	  }
-	  line[18] = '\0';
+  if (pdf->update)
+  {
+    const char *type = pdfioDictGetName(pdf->trailer_dict, "Type");
+					// Original trailer type
 
-	  // Parse the line
-	  if ((offset = strtoimax(line, &ptr, 10)) < 0)
-	  {
-	    _pdfioFileError(pdf, "Malformed xref table entry '%s'.", line);
-	    return (false);
-	  }
+    if (type && !strcmp(type, "XRef"))
+      xref_stream = true;
 
-	  if ((generation = (int)strtol(ptr, &ptr, 10)) < 0 || (generation > 65535 && offset != 0))
-	  {
-	    _pdfioFileError(pdf, "Malformed xref table entry '%s'.", line);
-	    return (false);
-	  }
+    if (pdf->sort_objs)
+    {
+      qsort(pdf->objs, pdf->num_objs, sizeof(pdfio_obj_t *), (int (*)(const void *, const void *))compare_objs);
+      pdf->sort_objs = false;
+    }
+  }
 
-	  if (*ptr != ' ')
-	  {
-	    _pdfioFileError(pdf, "Malformed xref table entry '%s'.", line);
-	    return (false);
-	  }
+  // Create the trailer...
+  if ((pdf->trailer_dict = pdfioDictCreate(pdf)) == NULL)
+  {
+    _pdfioFileError(pdf, "Unable to create trailer.");
+    return (false);
+  }
 
-	  ptr ++;
-	  if (*ptr != 'f' && *ptr != 'n')
-	  {
-	    _pdfioFileError(pdf, "Malformed xref table entry '%s'.", line);
-	    return (false);
-	  }
+  if (pdf->encrypt_obj)
+    pdfioDictSetObj(pdf->trailer_dict, "Encrypt", pdf->encrypt_obj);
+  if (pdf->id_array)
+    pdfioDictSetArray(pdf->trailer_dict, "ID", pdf->id_array);
+  pdfioDictSetObj(pdf->trailer_dict, "Info", pdf->info_obj);
+  pdfioDictSetObj(pdf->trailer_dict, "Root", pdf->root_obj);
 
-	  if (*ptr == 'f')
-	    continue;			// Don't care about free objects...
+  if (pdf->update)
+  {
+    pdfioDictSetNumber(pdf->trailer_dict, "Prev", (double)pdf->update_xref);
+    pdfioDictSetNumber(pdf->trailer_dict, "Size", (double)(pdf->update_objnum + pdf->update_num_objs));
+  }
+  else
+  {
+    pdfioDictSetNumber(pdf->trailer_dict, "Size", (double)(pdf->num_objs + pdf->num_xrefs + 1));
+  }
 
-	  // Create a placeholder for the object in memory...
-	  if (pdfioFileFindObj(pdf, (size_t)number))
-	    continue;			// Don't replace newer object...
+  xref_offset = _pdfioFileTell(pdf);
 
-	  if (!add_obj(pdf, (size_t)number, (unsigned short)generation, offset))
-	    return (false);
-	}
+  if (xref_stream)
+  {
+    // Write a cross-reference stream...
+    if (!write_xref_stream(pdf, xref_offset))
+    {
+      ret = false;
+      goto done;
+    }
+  }
+  else if (pdf->update)
+  {
+    // Write an xref table with sections for the objects in the update...
+    if (!_pdfioFilePuts(pdf, "xref\n"))
+    {
+      _pdfioFileError(pdf, "Unable to write cross-reference table.");
+      ret = false;
+      goto done;
+    }
 
-	trailer_offset = _pdfioFileTell(pdf);
-      }
+    for (i = 0; i < pdf->num_objs; i = j)
+    {
+      bool	written;		// Was the section written?
 
-      if (strncmp(line, "trailer", 7))
+      if (!is_update_obj(pdf, pdf->objs[i]))
       {
-	_pdfioFileError(pdf, "Missing trailer.");
-	return (false);
+        j = i + 1;
+        continue;
       }
 
-      _pdfioTokenInit(&tb, pdf, (_pdfio_tconsume_cb_t)_pdfioFileConsume, (_pdfio_tpeek_cb_t)_pdfioFilePeek, pdf);
+      // Find the run of consecutively numbered objects for this section...
+      for (j = i + 1; j < pdf->num_objs && is_update_obj(pdf, pdf->objs[j]) && pdf->objs[j]->number == (pdf->objs[j - 1]->number + 1); j ++);
 
-      if (!_pdfioValueRead(pdf, NULL, &tb, &trailer, 0))
+      written = _pdfioFilePrintf(pdf, "%lu %lu \n", (unsigned long)pdf->objs[i]->number, (unsigned long)(j - i));
+
+      for (k = i; written && k < j; k ++)
       {
-	_pdfioFileError(pdf, "Unable to read trailer dictionary.");
-	return (false);
+        pdfio_obj_t *obj = pdf->objs[k];// Current object
+
+	if (obj->offset)
+	  written = _pdfioFilePrintf(pdf, "%010lu %05u n \n", (unsigned long)obj->offset, obj->generation);
+	else
+	  written = _pdfioFilePuts(pdf, "0000000000 00001 f \n");
       }
-      else if (trailer.type != PDFIO_VALTYPE_DICT)
+
+      if (!written)
       {
-	_pdfioFileError(pdf, "Trailer is not a dictionary.");
-	return (false);
+	_pdfioFileError(pdf, "Unable to write cross-reference table.");
+	ret = false;
+	goto done;
       }
+    }
 
-      PDFIO_DEBUG("load_xref: Got trailer dict.\n");
+    if (!_pdfioFilePuts(pdf, "trailer\n") || !_pdfioDictWrite(pdf->trailer_dict, NULL, NULL) || !_pdfioFilePuts(pdf, "\n"))
+    {
+      _pdfioFileError(pdf, "Unable to write trailer.");
+      ret = false;
+      goto done;
+    }
+  }
+  else
+  {
+    // Write the xref table, using the saved entries of any freed objects...
+    if (!_pdfioFilePrintf(pdf, "xref\n0 %lu \n%010lu 65535 f \n", (unsigned long)(pdf->num_objs + pdf->num_xrefs + 1), (unsigned long)next_free_obj(pdf, 0, NULL)))
+    {
+      _pdfioFileError(pdf, "Unable to write cross-reference table.");
+      ret = false;
+      goto done;
+    }
 
-      _pdfioTokenFlush(&tb);
+    for (i = 0, j = 1; j <= (pdf->num_objs + pdf->num_xrefs); j ++)
+    {
+      pdfio_obj_t	*obj;		// Current object
+      _pdfio_xref_t	*xref;		// Entry for freed object
+      bool	written;		// Was the object written?
+
+      if ((xref = find_xref(pdf, j)) != NULL)
+        written = _pdfioFilePrintf(pdf, "%010lu 00000 n \n", (unsigned long)xref->offset);
+      else if ((obj = pdf->objs[i ++])->offset)
+        written = _pdfioFilePrintf(pdf, "%010lu %05u n \n", (unsigned long)obj->offset, obj->generation);
+      else
+        written = _pdfioFilePrintf(pdf, "%010lu 00001 f \n", (unsigned long)next_free_obj(pdf, i, NULL));
 
-      if (!pdf->trailer_dict)
+      if (!written)
       {
-	// Save the trailer dictionary and grab the root (catalog) and info
-	// objects...
-	pdf->trailer_dict = trailer.value.dict;
-	pdf->encrypt_obj  = pdfioDictGetObj(pdf->trailer_dict, "Encrypt");
-	pdf->id_array     = pdfioDictGetArray(pdf->trailer_dict, "ID");
-
-	// If the trailer contains an Encrypt key, try unlocking the file...
-	if (pdf->encrypt_obj && !_pdfioCryptoUnlock(pdf, password_cb, password_data))
-	  return (false);
+	_pdfioFileError(pdf, "Unable to write cross-reference table.");
+	ret = false;
+	goto done;
       }
     }
-    else
+
+    // Write the trailer...
+    if (!_pdfioFilePuts(pdf, "trailer\n"))
     {
-      _pdfioFileError(pdf, "Bad xref table header '%s'.", line);
-      return (false);
+      _pdfioFileError(pdf, "Unable to write trailer.");
+      ret = false;
+      goto done;
     }
 
-    PDFIO_DEBUG("load_xref: Contents of trailer dictionary:\n");
-    PDFIO_DEBUG("load_xref: ");
-    PDFIO_DEBUG_VALUE(&trailer);
-    PDFIO_DEBUG("\n");
-
-    off_t new_offset = (off_t)pdfioDictGetNumber(trailer.value.dict, "Prev");
-
-    if (new_offset <= 0)
+    if (!_pdfioDictWrite(pdf->trailer_dict, NULL, NULL))
     {
-      done = true;
+      _pdfioFileError(pdf, "Unable to write trailer.");
+      ret = false;
+      goto done;
     }
-    else if (new_offset == xref_offset)
+
+    if (!_pdfioFilePuts(pdf, "\n"))
     {
-      _pdfioFileError(pdf, "Recursive xref table.");
-      return (false);
+      ret = false;
+      goto done;
     }
-
-    xref_offset = new_offset;
   }
 
-  // Once we have all of the xref tables loaded, get the important objects and
-  // build the pages array...
-  pdf->info_obj = pdfioDictGetObj(pdf->trailer_dict, "Info");
-
-  if ((pdf->root_obj = pdfioDictGetObj(pdf->trailer_dict, "Root")) == NULL)
+  if (!_pdfioFilePrintf(pdf, "startxref\n%lu\n%%EOF\n", (unsigned long)xref_offset))
   {
-    _pdfioFileError(pdf, "Missing Root object.");
-    return (false);
+    _pdfioFileError(pdf, "Unable to write xref offset.");
+    ret = false;
   }
 
-  PDFIO_DEBUG("load_xref: Root=%p(%lu)\n", pdf->root_obj, (unsigned long)pdf->root_obj->number);
+  done:
 
-  return (load_pages(pdf, pdfioDictGetObj(pdfioObjGetDict(pdf->root_obj), "Pages"), 0));
+  return (ret);
 }
 
 
 //
-// 'write_pages()' - Write the PDF pages objects.
+// 'write_xref_stream()' - Write a cross-reference stream.
+//
+// The xref stream uses the trailer dictionary and contains a row for every
+// object including itself, or just the objects in an incremental update.  The
+// data is compressed in memory with the PNG "up" predictor so that the length
+// is known ahead of time - this avoids creating a separate length object after
+// the xref stream.
 //
 
 static bool				// O - `true` on success, `false` on failure
-write_pages(pdfio_file_t *pdf)		// I - PDF file
+write_xref_stream(pdfio_file_t *pdf,	// I - PDF file
+                  off_t        xref_offset)
+					// I - Offset of xref stream
 {
-  pdfio_array_t	*kids;			// Pages array
-  size_t	i;			// Looping var
-
+  bool		ret = false;		// Return value
+  _pdfio_value_t value;			// Xref stream value
+  pdfio_obj_t	*xref_obj;		// Xref stream object
+  pdfio_stream_t *st;			// Xref stream
+  pdfio_dict_t	*params;		// Decode parameters
+  pdfio_array_t	*w,			// Field widths
+		*index = NULL;		// Subsections for an incremental update
+  pdfio_encryption_t encryption;	// Encryption mode
+  size_t	i, j,			// Looping vars
+		number,			// Object number
+		num_rows,		// Number of rows
+		first = 0,		// First object in subsection
+		count,			// Number of objects in subsection
+		maxval,			// Maximum field value
+		field2,			// Second field
+		w2,			// Width of second field
+		rowlen,			// Length of a row
+		datalen;		// Length of row data
+  uLongf	clen;			// Length of compressed data
+  int		status;			// Compression status
+  unsigned char	*data = NULL,		// Row data
+		*dataptr,		// Pointer into row data
+		*cdata = NULL;		// Compressed data
+
+
+  // Create the xref stream object, which is included in the xref data...
+  value.type       = PDFIO_VALTYPE_DICT;
+  value.value.dict = pdf->trailer_dict;
 
-  // Build the "Kids" array pointing to each page...
-  if ((kids = pdfioArrayCreate(pdf)) == NULL)
+  if ((xref_obj = _pdfioFileCreateObj(pdf, pdf, &value)) == NULL)
     return (false);
 
-  for (i = 0; i < pdf->num_pages; i ++)
-    pdfioArrayAppendObj(kids, pdf->pages[i]);
+  // Figure out the width of the second field...
+  for (i = 0, maxval = (size_t)xref_offset; i < pdf->num_objs; i ++)
+  {
+    if (pdf->objs[i]->objstm > maxval)
+      maxval = pdf->objs[i]->objstm;
+    else if (!pdf->objs[i]->objstm && (size_t)pdf->objs[i]->offset > maxval)
+      maxval = (size_t)pdf->objs[i]->offset;
+  }
 
-  pdfioDictSetNumber(pdf->pages_obj->value.value.dict, "Count", pdf->num_pages);
-  pdfioDictSetArray(pdf->pages_obj->value.value.dict, "Kids", kids);
+  for (i = 0; pdf->num_xrefs && i < pdf->alloc_xrefs; i ++)
+  {
+    if (pdf->xrefs[i].objstm > maxval)
+      maxval = pdf->xrefs[i].objstm;
+    else if (!pdf->xrefs[i].objstm && (size_t)pdf->xrefs[i].offset > maxval)
+      maxval = (size_t)pdf->xrefs[i].offset;
+  }
 
-  // Write the Pages object...
-  return (pdfioObjClose(pdf->pages_obj));
-}
+  for (w2 = 1; w2 < sizeof(size_t) && (maxval >> (8 * w2)) != 0; w2 ++);
 
+  // Count the rows - an incremental update only has rows for the objects in
+  // the update, using an Index array with a subsection for each run of
+  // consecutively numbered objects...
+  if (pdf->update)
+  {
+    if ((index = pdfioArrayCreate(pdf)) == NULL)
+    {
+      _pdfioFileError(pdf, "Unable to create cross-reference stream dictionary.");
+      return (false);
+    }
 
-//
-// 'write_trailer()' - Write the PDF catalog object, xref table, and trailer.
-//
+    for (i = 0, num_rows = 0, count = 0; i < pdf->num_objs; i ++)
+    {
+      if (!is_update_obj(pdf, pdf->objs[i]))
+        continue;
 
-static bool				// O - `true` on success, `false` on failure
-write_trailer(pdfio_file_t *pdf)	// I - PDF file
-{
-  bool		ret = true;		// Return value
-  off_t		xref_offset;		// Offset to xref table
-  size_t	i;			// Looping var
+      if (count > 0 && pdf->objs[i]->number == (first + count))
+      {
+        count ++;
+      }
+      else
+      {
+        if (count > 0)
+        {
+	  pdfioArrayAppendNumber(index, (double)first);
+	  pdfioArrayAppendNumber(index, (double)count);
+        }
 
+        first = pdf->objs[i]->number;
+        count = 1;
+      }
 
-  // Write the xref table...
-  // TODO: Look at adding support for xref streams...
-  xref_offset = _pdfioFileTell(pdf);
+      num_rows ++;
+    }
 
-  if (!_pdfioFilePrintf(pdf, "xref\n0 %lu \n0000000000 65535 f \n", (unsigned long)pdf->num_objs + 1))
+    if (count > 0)
+    {
+      pdfioArrayAppendNumber(index, (double)first);
+      pdfioArrayAppendNumber(index, (double)count);
+    }
+  }
+  else
   {
-    _pdfioFileError(pdf, "Unable to write cross-reference table.");
-    ret = false;
+    num_rows = pdf->num_objs + pdf->num_xrefs + 1;
+  }
+
+  // Build the row data with the PNG "up" predictor...
+  rowlen  = 1 + 1 + w2 + 2;
+  datalen = rowlen * num_rows;
+  clen    = compressBound((uLong)datalen);
+
+  if ((data = (unsigned char *)calloc(1, datalen)) == NULL || (cdata = (unsigned char *)malloc(clen)) == NULL)
+  {
+    _pdfioFileError(pdf, "Unable to allocate memory for cross-reference stream.");
     goto done;
   }
 
-  for (i = 0; i < pdf->num_objs; i ++)
+  data[0] = 2;
+  dataptr = data;
+
+  if (!pdf->update)
+  {
+    // Object 0 (free) has a generation of 65535...
+    data[rowlen - 2] = 255;
+    data[rowlen - 1] = 255;
+
+    for (j = w2, field2 = next_free_obj(pdf, 0, xref_obj); j > 0; j --, field2 >>= 8)
+      data[1 + j] = (unsigned char)field2;
+
+    dataptr += rowlen;
+  }
+
+  for (i = 0, number = 1; i < pdf->num_objs; number ++)
   {
-    pdfio_obj_t	*obj = pdf->objs[i];	// Current object
+    pdfio_obj_t	*obj;			// Current object
+    _pdfio_xref_t *xref;		// Entry for freed object
+    size_t	field3;			// Third field
 
-    if (!_pdfioFilePrintf(pdf, "%010lu %05u n \n", (unsigned long)obj->offset, obj->generation))
+    if ((xref = find_xref(pdf, number)) != NULL && xref->objstm)
     {
-      _pdfioFileError(pdf, "Unable to write cross-reference table.");
-      ret = false;
-      goto done;
+      // Object was freed after it was written to an object stream...
+      dataptr[1] = 2;
+      field2     = xref->objstm;
+      field3     = (size_t)xref->offset;
+    }
+    else if (xref)
+    {
+      // Object was freed after it was written...
+      dataptr[1] = 1;
+      field2     = (size_t)xref->offset;
+      field3     = 0;
+    }
+    else if (pdf->update && !is_update_obj(pdf, pdf->objs[i]))
+    {
+      i ++;
+      continue;
     }
+    else if ((obj = pdf->objs[i ++])->objstm)
+    {
+      dataptr[1] = 2;
+      field2     = obj->objstm;
+      field3     = (size_t)obj->offset;
+    }
+    else if (!obj->offset && obj != xref_obj)
+    {
+      // Object was never written...
+      dataptr[1] = 0;
+      field2     = pdf->update ? 0 : next_free_obj(pdf, i, xref_obj);
+      field3     = 1;
+    }
+    else
+    {
+      // The xref stream is written at the current offset...
+      dataptr[1] = 1;
+      field2     = obj == xref_obj ? (size_t)xref_offset : (size_t)obj->offset;
+      field3     = obj->generation;
+    }
+
+    for (j = w2; j > 0; j --, field2 >>= 8)
+      dataptr[1 + j] = (unsigned char)field2;
+
+    dataptr[rowlen - 2] = (unsigned char)(field3 >> 8);
+    dataptr[rowlen - 1] = (unsigned char)field3;
+
+    dataptr += rowlen;
   }
 
-  // Write the trailer...
-  if (!_pdfioFilePuts(pdf, "trailer\n"))
+  // Apply the predictor from the last row back to the second row...
+  for (dataptr = data + datalen - rowlen; dataptr > data; dataptr -= rowlen)
   {
-    _pdfioFileError(pdf, "Unable to write trailer.");
-    ret = false;
-    goto done;
+    for (j = 1; j < rowlen; j ++)
+      dataptr[j] -= dataptr[j - rowlen];
+
+    dataptr[0] = 2;
   }
 
-  if ((pdf->trailer_dict = pdfioDictCreate(pdf)) == NULL)
+  _pdfioFileSpan(pdf, PDFIO_SPAN_DEFLATE, true);
+  status = compress2(cdata, &clen, data, (uLong)datalen, 9);
+  _pdfioFileSpan(pdf, PDFIO_SPAN_DEFLATE, false);
+
+  if (status != Z_OK)
   {
-    _pdfioFileError(pdf, "Unable to create trailer.");
-    ret = false;
+    _pdfioFileError(pdf, "Unable to compress cross-reference stream.");
     goto done;
   }
 
-  if (pdf->encrypt_obj)
-    pdfioDictSetObj(pdf->trailer_dict, "Encrypt", pdf->encrypt_obj);
-  if (pdf->id_array)
-    pdfioDictSetArray(pdf->trailer_dict, "ID", pdf->id_array);
-  pdfioDictSetObj(pdf->trailer_dict, "Info", pdf->info_obj);
-  pdfioDictSetObj(pdf->trailer_dict, "Root", pdf->root_obj);
-  pdfioDictSetNumber(pdf->trailer_dict, "Size", pdf->num_objs + 1);
+  pdf->stats.bytes_deflated += datalen;
 
-  if (!_pdfioDictWrite(pdf->trailer_dict, NULL, NULL))
+  // Write the xref stream, which is never encrypted...
+  if ((w = pdfioArrayCreate(pdf)) == NULL || (params = pdfioDictCreate(pdf)) == NULL)
   {
-    _pdfioFileError(pdf, "Unable to write trailer.");
-    ret = false;
+    _pdfioFileError(pdf, "Unable to create cross-reference stream dictionary.");
     goto done;
   }
 
-  if (!_pdfioFilePrintf(pdf, "\nstartxref\n%lu\n%%EOF\n", (unsigned long)xref_offset))
+  pdfioArrayAppendNumber(w, 1);
+  pdfioArrayAppendNumber(w, (double)w2);
+  pdfioArrayAppendNumber(w, 2);
+
+  pdfioDictSetNumber(params, "Columns", (double)(rowlen - 1));
+  pdfioDictSetNumber(params, "Predictor", 12);
+
+  pdfioDictSetName(pdf->trailer_dict, "Type", "XRef");
+  if (pdf->update)
   {
-    _pdfioFileError(pdf, "Unable to write xref offset.");
-    ret = false;
+    pdfioDictSetNumber(pdf->trailer_dict, "Size", (double)(pdf->update_objnum + pdf->update_num_objs));
+    pdfioDictSetArray(pdf->trailer_dict, "Index", index);
+  }
+  else
+  {
+    pdfioDictSetNumber(pdf->trailer_dict, "Size", (double)(pdf->num_objs + pdf->num_xrefs + 1));
+  }
+  pdfioDictSetArray(pdf->trailer_dict, "W", w);
+  pdfioDictSetName(pdf->trailer_dict, "Filter", "FlateDecode");
+  pdfioDictSetDict(pdf->trailer_dict, "DecodeParms", params);
+  pdfioDictSetNumber(pdf->trailer_dict, "Length", (double)clen);
+
+  encryption      = pdf->encryption;
+  pdf->encryption = PDFIO_ENCRYPTION_NONE;
+
+  if ((st = pdfioObjCreateStream(xref_obj, PDFIO_FILTER_NONE)) != NULL)
+  {
+    ret = pdfioStreamWrite(st, cdata, (size_t)clen);
+
+    if (!pdfioStreamClose(st))
+      ret = false;
   }
 
+  pdf->encryption = encryption;
+
+  if (!ret)
+    _pdfioFileError(pdf, "Unable to write cross-reference stream.");
+
   done:
 
+  free(data);
+  free(cdata);
+
   return (ret);
 }
@@ -14,9 +14,47 @@
 // Local functions...
 //
 
+static void	cache_evict(pdfio_file_t *pdf, pdfio_obj_t *keep);
+static void	cache_remove(pdfio_obj_t *obj);
+static void	cache_touch(pdfio_obj_t *obj);
+static pdfio_obj_t *copy_obj(pdfio_file_t *pdf, pdfio_obj_t *srcobj);
+static pdfio_obj_t *copy_shared_stream(pdfio_file_t *pdf, pdfio_obj_t *dstobj, pdfio_obj_t *srcobj);
+static bool	load_obj(pdfio_obj_t *obj);
+static bool	update_obj(pdfio_obj_t *obj);
 static bool	write_obj_header(pdfio_obj_t *obj);
 
 
+//
+// '_pdfioObjCache()' - Add a loaded object value to the object value cache.
+//
+// Values are only cached when a memory limit has been set with
+// @link pdfioFileSetCacheSize@ and the application has not used the value.
+//
+
+void
+_pdfioObjCache(pdfio_obj_t *obj,	// I - Object
+               size_t      bytes)	// I - Memory used by value
+{
+  pdfio_file_t	*pdf = obj->pdf;	// PDF file
+
+
+  if (!pdf->cache_limit || obj->pinned || obj->cache_bytes || !bytes || pdf->mode != _PDFIO_MODE_READ)
+    return;
+
+  obj->cache_bytes = bytes;
+  obj->cache_prev  = pdf->cache_last;
+  obj->cache_next  = NULL;
+
+  if (pdf->cache_last)
+    pdf->cache_last->cache_next = obj;
+  else
+    pdf->cache_first = obj;
+
+  pdf->cache_last  = obj;
+  pdf->cache_bytes += bytes;
+}
+
+
 //
 // 'pdfioObjClose()' - Close an object, writing any data as needed to the PDF
 //                     file.
@@ -25,11 +63,15 @@ static bool	write_obj_header(pdfio_obj_t *obj);
 bool					// O - `true` on success, `false` on failure
 pdfioObjClose(pdfio_obj_t *obj)		// I - Object
 {
+  bool	nested;				// Closing while another object is open?
+
+
   // Range check input
   if (!obj)
     return (false);
 
   // Clear the current object pointer...
+  nested                = obj->pdf->current_obj && obj->pdf->current_obj != obj;
   obj->pdf->current_obj = NULL;
 
   if (obj->pdf->mode != _PDFIO_MODE_WRITE)
@@ -38,9 +80,26 @@ pdfioObjClose(pdfio_obj_t *obj)		// I - Object
     return (true);
   }
 
+  if (obj->pdf->update && (obj->offset || obj->objstm) && !_pdfioObjIsUpdated(obj))
+  {
+    // Append the new value of an object from the original file...
+    if (nested)
+    {
+      _pdfioFileError(obj->pdf, "Unable to update object %lu while another object is open.", (unsigned long)obj->number);
+      return (false);
+    }
+
+    return (update_obj(obj));
+  }
+
   // Write what remains for the object...
-  if (!obj->offset)
+  if (!obj->offset && !obj->objstm)
   {
+    // Add the object to an object stream as needed.  Length objects are
+    // closed while their stream is still open so they are written directly...
+    if ((obj->pdf->options & PDFIO_OPTION_OBJSTREAMS) && !nested && obj->generation == 0 && obj != obj->pdf->encrypt_obj)
+      return (_pdfioFileAddCompressedObj(obj->pdf, obj));
+
     // Write the object value
     if (!write_obj_header(obj))
       return (false);
@@ -64,16 +123,17 @@ pdfioObjClose(pdfio_obj_t *obj)		// I - Object
 //
 // 'pdfioObjCopy()' - Copy an object to another PDF file.
 //
+// When the `PDFIO_OPTION_DEDUPLICATE` option is set for the destination PDF
+// file, stream objects whose dictionary and stream data match an object that
+// was already copied from any PDF file are not copied again - the existing
+// object is returned instead.
+//
 
 pdfio_obj_t *				// O - New object or `NULL` on error
 pdfioObjCopy(pdfio_file_t *pdf,		// I - PDF file
              pdfio_obj_t  *srcobj)	// I - Object to copy
 {
   pdfio_obj_t	*dstobj;		// Destination object
-  pdfio_stream_t *srcst,		// Source stream
-		*dstst;			// Destination stream
-  char		buffer[32768];		// Copy buffer
-  ssize_t	bytes;			// Bytes read
 
 
   PDFIO_DEBUG("pdfioObjCopy(pdf=%p, srcobj=%p(%p))\n", pdf, srcobj, srcobj ? srcobj->pdf : NULL);
@@ -82,58 +142,17 @@ pdfioObjCopy(pdfio_file_t *pdf,		// I - PDF file
   if (!pdf || !srcobj)
     return (NULL);
 
-  // Load the object value if needed...
-  if (srcobj->value.type == PDFIO_VALTYPE_NONE)
-    _pdfioObjLoad(srcobj);
-
-  // Create the new object...
-  if ((dstobj = _pdfioFileCreateObj(pdf, srcobj->pdf, NULL)) == NULL)
-    return (NULL);
+  // Keep the cached values of the source file while copying, since the source
+  // value is used while other objects are copied...
+  _pdfioFileLock(srcobj->pdf);
+  srcobj->pdf->cache_hold ++;
+  _pdfioFileUnlock(srcobj->pdf);
 
-  // Add new object to the cache of copied objects...
-  if (!_pdfioFileAddMappedObj(pdf, dstobj, srcobj))
-    return (NULL);
+  dstobj = copy_obj(pdf, srcobj);
 
-  // Copy the object's value...
-  if (!_pdfioValueCopy(pdf, &dstobj->value, srcobj->pdf, &srcobj->value))
-    return (NULL);
-
-  if (dstobj->value.type == PDFIO_VALTYPE_DICT)
-    pdfioDictClear(dstobj->value.value.dict, "Length");
-
-  if (srcobj->stream_offset)
-  {
-    // Copy stream data...
-    if ((srcst = pdfioObjOpenStream(srcobj, false)) == NULL)
-    {
-      pdfioObjClose(dstobj);
-      return (NULL);
-    }
-
-    if ((dstst = pdfioObjCreateStream(dstobj, PDFIO_FILTER_NONE)) == NULL)
-    {
-      pdfioStreamClose(srcst);
-      pdfioObjClose(dstobj);
-      return (NULL);
-    }
-
-    while ((bytes = pdfioStreamRead(srcst, buffer, sizeof(buffer))) > 0)
-    {
-      if (!pdfioStreamWrite(dstst, buffer, (size_t)bytes))
-      {
-        bytes = -1;
-        break;
-      }
-    }
-
-    pdfioStreamClose(srcst);
-    pdfioStreamClose(dstst);
-
-    if (bytes < 0)
-      return (NULL);
-  }
-  else
-    pdfioObjClose(dstobj);
+  _pdfioFileLock(srcobj->pdf);
+  srcobj->pdf->cache_hold --;
+  _pdfioFileUnlock(srcobj->pdf);
 
   return (dstobj);
 }
@@ -155,7 +174,7 @@ pdfioObjCreateStream(
   if (!obj || obj->pdf->mode != _PDFIO_MODE_WRITE || obj->value.type != PDFIO_VALTYPE_DICT)
     return (NULL);
 
-  if (obj->offset)
+  if (obj->offset || obj->objstm)
   {
     _pdfioFileError(obj->pdf, "Object has already been written.");
     return (NULL);
@@ -173,8 +192,17 @@ pdfioObjCreateStream(
     return (NULL);
   }
 
+  if (filter == PDFIO_FILTER_FLATE && ((obj->pdf->options & PDFIO_OPTION_PARALLEL) || obj->pdf->deflate_cb))
+  {
+    // Compressing in parallel or with a compression callback, the object is
+    // written once the stream data has been compressed...
+    obj->pdf->current_obj = obj;
+
+    return (_pdfioStreamCreate(obj, NULL, filter, false));
+  }
+
   // Write the header...
-  if (!_pdfioDictGetValue(obj->value.value.dict, "Length"))
+  if (!_pdfioDictGetValue(obj->value.value.dict, _pdfio_keys[_PDFIO_KEY_LENGTH]))
   {
     if (obj->pdf->output_cb)
     {
@@ -205,7 +233,7 @@ pdfioObjCreateStream(
   obj->pdf->current_obj = obj;
 
   // Return the new stream...
-  return (_pdfioStreamCreate(obj, length_obj, filter));
+  return (_pdfioStreamCreate(obj, length_obj, filter, false));
 }
 
 
@@ -238,8 +266,20 @@ pdfioObjGetArray(pdfio_obj_t *obj)	// I - Object
   if (!obj)
     return (NULL);
 
-  if (obj->value.type == PDFIO_VALTYPE_NONE)
-    _pdfioObjLoad(obj);
+  _pdfioObjLoad(obj);
+
+  // Keep the value since the application can use it at any time...
+  if (!obj->pinned)
+  {
+    _pdfioFileLock(obj->pdf);
+
+    if (obj->cache_bytes)
+      cache_remove(obj);
+
+    obj->pinned = true;
+
+    _pdfioFileUnlock(obj->pdf);
+  }
 
   if (obj->value.type == PDFIO_VALTYPE_ARRAY)
     return (obj->value.value.array);
@@ -258,8 +298,20 @@ pdfioObjGetDict(pdfio_obj_t *obj)	// I - Object
   if (!obj)
     return (NULL);
 
-  if (obj->value.type == PDFIO_VALTYPE_NONE)
-    _pdfioObjLoad(obj);
+  _pdfioObjLoad(obj);
+
+  // Keep the value since the application can use it at any time...
+  if (!obj->pinned)
+  {
+    _pdfioFileLock(obj->pdf);
+
+    if (obj->cache_bytes)
+      cache_remove(obj);
+
+    obj->pinned = true;
+
+    _pdfioFileUnlock(obj->pdf);
+  }
 
   if (obj->value.type == PDFIO_VALTYPE_DICT)
     return (obj->value.value.dict);
@@ -268,6 +320,23 @@ pdfioObjGetDict(pdfio_obj_t *obj)	// I - Object
 }
 
 
+//
+// '_pdfioObjGetDict()' - Get the dictionary associated with an object for internal use.
+//
+// Unlike @link pdfioObjGetDict@, the value can still be freed by the object
+// value cache when another object is loaded.
+//
+
+pdfio_dict_t *				// O - Dictionary or `NULL` on error
+_pdfioObjGetDict(pdfio_obj_t *obj)	// I - Object
+{
+  if (!obj || !_pdfioObjLoad(obj) || obj->value.type != PDFIO_VALTYPE_DICT)
+    return (NULL);
+  else
+    return (obj->value.value.dict);
+}
+
+
 //
 // '_pdfioObjGetExtension()' - Get the extension pointer for an object.
 //
@@ -302,24 +371,23 @@ pdfioObjGetLength(pdfio_obj_t *obj)	// I - Object
 
 
   // Range check input...
-  if (!obj || !obj->stream_offset || obj->value.type != PDFIO_VALTYPE_DICT)
+  if (!obj || !_pdfioObjLoad(obj) || !obj->stream_offset || obj->value.type != PDFIO_VALTYPE_DICT)
     return (0);
 
   // Try getting the length, directly or indirectly
-  if ((length = (size_t)pdfioDictGetNumber(obj->value.value.dict, "Length")) > 0)
+  if ((length = (size_t)pdfioDictGetNumber(obj->value.value.dict, _pdfio_keys[_PDFIO_KEY_LENGTH])) > 0)
   {
     PDFIO_DEBUG("pdfioObjGetLength(obj=%p) returning %lu.\n", obj, (unsigned long)length);
     return (length);
   }
 
-  if ((lenobj = pdfioDictGetObj(obj->value.value.dict, "Length")) == NULL)
+  if ((lenobj = pdfioDictGetObj(obj->value.value.dict, _pdfio_keys[_PDFIO_KEY_LENGTH])) == NULL)
   {
     _pdfioFileError(obj->pdf, "Unable to get length of stream.");
     return (0);
   }
 
-  if (lenobj->value.type == PDFIO_VALTYPE_NONE)
-    _pdfioObjLoad(lenobj);
+  _pdfioObjLoad(lenobj);
 
   if (lenobj->value.type != PDFIO_VALTYPE_NUMBER || lenobj->value.value.number <= 0.0)
   {
@@ -343,8 +411,7 @@ pdfioObjGetName(pdfio_obj_t *obj)	// I - Object
   if (!obj)
     return (NULL);
 
-  if (obj->value.type == PDFIO_VALTYPE_NONE)
-    _pdfioObjLoad(obj);
+  _pdfioObjLoad(obj);
 
   if (obj->value.type == PDFIO_VALTYPE_NAME)
     return (obj->value.value.name);
@@ -387,10 +454,10 @@ pdfioObjGetSubtype(pdfio_obj_t *obj)	// I - Object
   pdfio_dict_t	*dict;			// Object dictionary
 
 
-  if ((dict = pdfioObjGetDict(obj)) == NULL)
+  if ((dict = _pdfioObjGetDict(obj)) == NULL)
     return (NULL);
   else
-    return (pdfioDictGetName(dict, "Subtype"));
+    return (pdfioDictGetName(dict, _pdfio_keys[_PDFIO_KEY_SUBTYPE]));
 }
 
 
@@ -417,19 +484,496 @@ pdfioObjGetType(pdfio_obj_t *obj)	// I - Object
   pdfio_dict_t	*dict;			// Object dictionary
 
 
-  if ((dict = pdfioObjGetDict(obj)) == NULL)
+  if ((dict = _pdfioObjGetDict(obj)) == NULL)
     return (NULL);
   else
-    return (pdfioDictGetName(dict, "Type"));
+    return (pdfioDictGetName(dict, _pdfio_keys[_PDFIO_KEY_TYPE]));
 }
 
 
 //
-// '_pdfioObjLoad()' - Load an object dictionary/value.
+// '_pdfioObjLoad()' - Load an object dictionary/value as needed.
+//
+// Objects in compressed object streams are loaded by loading the containing
+// object stream.  If another stream is currently open for reading, its file
+// position is preserved.
+//
+// When concurrent reading is enabled, the object is loaded while holding the
+// file lock so that only one thread loads it.  When a file is being updated,
+// the file is switched to reading while the object is loaded.
 //
 
 bool					// O - `true` on success, `false` otherwise
 _pdfioObjLoad(pdfio_obj_t *obj)		// I - Object
+{
+  bool		ret;			// Return value
+  pdfio_file_t	*pdf = obj->pdf;	// PDF file
+  pdfio_obj_t	*current_obj = NULL;	// Current object being read
+  off_t		current_pos = 0;	// Current position in file
+  bool		reading;		// Switched to reading for an update?
+
+
+  PDFIO_DEBUG("_pdfioObjLoad(obj=%p(%lu)), offset=%lu, objstm=%lu\n", obj, (unsigned long)obj->number, (unsigned long)obj->offset, (unsigned long)obj->objstm);
+
+  // Don't load the object more than once...
+  if (!pdf->concurrent && obj->value.type != PDFIO_VALTYPE_NONE)
+  {
+    if (obj->cache_bytes)
+      cache_touch(obj);
+
+    return (true);
+  }
+
+  _pdfioFileLock(pdf);
+
+  if (obj->value.type != PDFIO_VALTYPE_NONE)
+  {
+    // Another thread loaded the object while we waited for the lock...
+    _pdfioFileUnlock(pdf);
+    return (true);
+  }
+
+  _pdfioFileSpan(pdf, PDFIO_SPAN_LOAD_OBJ, true);
+
+  // When updating a file, switch from writing to reading.  Otherwise save the
+  // position of any stream that is being read...
+  if ((reading = _pdfioFileBeginRead(pdf)) == false && (current_obj = pdf->current_obj) != NULL)
+    current_pos = _pdfioFileTell(pdf);
+
+  if (obj->objstm)
+  {
+    // Load the object stream containing this object...
+    pdfio_obj_t	*open_obj = pdf->current_obj;
+					// Object that is open
+
+    pdf->current_obj = NULL;
+
+    _pdfioFileSpan(pdf, PDFIO_SPAN_LOAD_OBJSTM, true);
+    ret = _pdfioFileLoadCompressedObj(pdf, obj);
+    _pdfioFileSpan(pdf, PDFIO_SPAN_LOAD_OBJSTM, false);
+
+    if (ret && obj->value.type == PDFIO_VALTYPE_NONE)
+    {
+      _pdfioFileError(pdf, "Unable to find object %lu in compressed object stream %lu.", (unsigned long)obj->number, (unsigned long)obj->objstm);
+      ret = false;
+    }
+
+    pdf->current_obj = open_obj;
+  }
+  else
+  {
+    // Load the object from the file...
+    size_t alloc_bytes = pdf->alloc_bytes;
+					// Bytes allocated before loading
+
+    if ((ret = load_obj(obj)) == true)
+    {
+      _pdfioObjCache(obj, pdf->alloc_bytes - alloc_bytes);
+
+      pdf->stats.objs_loaded ++;
+    }
+  }
+
+  // Free other cached values as needed...
+  if (ret)
+    cache_evict(pdf, obj);
+
+  if (reading)
+    _pdfioFileEndRead(pdf);
+  else if (current_obj && _pdfioFileSeek(pdf, current_pos, SEEK_SET) != current_pos)
+    ret = false;
+
+  _pdfioFileSpan(pdf, PDFIO_SPAN_LOAD_OBJ, false);
+
+  _pdfioFileUnlock(pdf);
+
+  return (ret);
+}
+
+
+//
+// '_pdfioObjIsUpdated()' - Determine whether an object is part of an incremental update.
+//
+
+bool					// O - `true` if written by the update, `false` if from the original file
+_pdfioObjIsUpdated(pdfio_obj_t *obj)	// I - Object
+{
+  if (obj->objstm)
+    return (obj->objstm >= obj->pdf->update_objnum);
+  else
+    return (obj->offset >= obj->pdf->update_offset);
+}
+
+
+//
+// 'pdfioObjOpenStream()' - Open an object's (data) stream for reading.
+//
+// Only one stream can be open at a time unless concurrent reading has been
+// enabled with @link pdfioFileSetConcurrent@ or the file was opened with
+// @link pdfioFileOpenUpdate@.
+//
+
+pdfio_stream_t *			// O - Stream or `NULL` on error
+pdfioObjOpenStream(pdfio_obj_t *obj,	// I - Object
+                   bool        decode)	// I - Decode/decompress data?
+{
+  pdfio_stream_t	*st;		// Stream
+
+
+  // Range check input...
+  if (!obj)
+    return (NULL);
+
+  if (obj->pdf->current_obj && !obj->pdf->update)
+  {
+    _pdfioFileError(obj->pdf, "Another object (%u) is already open.", (unsigned)obj->pdf->current_obj->number);
+    return (NULL);
+  }
+
+  // Make sure we've loaded the object dictionary...
+  if (!_pdfioObjLoad(obj))
+    return (NULL);
+
+  // No stream if there is no dict or offset to a stream...
+  if (obj->value.type != PDFIO_VALTYPE_DICT || !obj->stream_offset)
+    return (NULL);
+
+  // Open the stream...  Streams in a file being updated are read using their
+  // own file position, after any pending output has been written.
+  _pdfioFileLock(obj->pdf);
+
+  if (obj->pdf->update)
+  {
+    if (!_pdfioFileFlush(obj->pdf))
+    {
+      _pdfioFileUnlock(obj->pdf);
+      return (NULL);
+    }
+  }
+  else if (!obj->pdf->concurrent)
+  {
+    obj->pdf->current_obj = obj;
+  }
+
+  st = _pdfioStreamOpen(obj, decode);
+
+  _pdfioFileUnlock(obj->pdf);
+
+  return (st);
+}
+
+
+//
+// '_pdfioObjRelease()' - Release the value of a written object.
+//
+// This is used by the `PDFIO_OPTION_STREAMING` output option to free the
+// dictionaries of page and content stream objects once they have been written.
+// Only objects marked for release by the library are affected, and they stay
+// marked so that @link _pdfioFileFreeObj@ can free the objects themselves.
+//
+
+void
+_pdfioObjRelease(pdfio_obj_t *obj)	// I - Object
+{
+  if (!obj->release)
+    return;
+
+  PDFIO_DEBUG("_pdfioObjRelease(obj=%p(%lu))\n", (void *)obj, (unsigned long)obj->number);
+
+  _pdfioValueRelease(obj->pdf, &obj->value);
+}
+
+
+//
+// '_pdfioObjSetExtension()' - Set extension data for an object.
+//
+
+void
+_pdfioObjSetExtension(
+    pdfio_obj_t      *obj,		// I - Object
+    void             *data,		// I - Data
+    _pdfio_extfree_t datafree)		// I - Free function
+{
+  obj->data     = data;
+  obj->datafree = datafree;
+}
+
+
+//
+// 'cache_evict()' - Free cached object values until under the memory limit.
+//
+// Values are not freed while concurrent reading is enabled or while another
+// operation is using them.
+//
+
+static void
+cache_evict(pdfio_file_t *pdf,		// I - PDF file
+            pdfio_obj_t  *keep)		// I - Object to keep
+{
+  pdfio_obj_t	*obj,			// Current object
+		*next;			// Next object
+
+
+  if (!pdf->cache_limit || pdf->concurrent || pdf->cache_hold)
+    return;
+
+  for (obj = pdf->cache_first; obj && pdf->cache_bytes > pdf->cache_limit; obj = next)
+  {
+    next = obj->cache_next;
+
+    if (obj == keep || obj == pdf->current_obj)
+      continue;
+
+    PDFIO_DEBUG("cache_evict: Freeing value of object %lu (%lu bytes).\n", (unsigned long)obj->number, (unsigned long)obj->cache_bytes);
+
+    cache_remove(obj);
+    _pdfioValueRelease(pdf, &obj->value);
+  }
+}
+
+
+//
+// 'cache_remove()' - Remove an object from the object value cache.
+//
+
+static void
+cache_remove(pdfio_obj_t *obj)		// I - Object
+{
+  pdfio_file_t	*pdf = obj->pdf;	// PDF file
+
+
+  if (obj->cache_prev)
+    obj->cache_prev->cache_next = obj->cache_next;
+  else
+    pdf->cache_first = obj->cache_next;
+
+  if (obj->cache_next)
+    obj->cache_next->cache_prev = obj->cache_prev;
+  else
+    pdf->cache_last = obj->cache_prev;
+
+  pdf->cache_bytes -= obj->cache_bytes;
+
+  obj->cache_prev  = NULL;
+  obj->cache_next  = NULL;
+  obj->cache_bytes = 0;
+}
+
+
+//
+// 'cache_touch()' - Mark a cached object value as most recently used.
+//
+
+static void
+cache_touch(pdfio_obj_t *obj)		// I - Object
+{
+  pdfio_file_t	*pdf = obj->pdf;	// PDF file
+  size_t	bytes = obj->cache_bytes;
+					// Memory used by value
+
+
+  if (pdf->cache_last == obj)
+    return;
+
+  cache_remove(obj);
+  _pdfioObjCache(obj, bytes);
+}
+
+
+//
+// 'copy_obj()' - Copy an object to another PDF file.
+//
+
+static pdfio_obj_t *			// O - New object or `NULL` on error
+copy_obj(pdfio_file_t *pdf,		// I - PDF file
+         pdfio_obj_t  *srcobj)		// I - Object to copy
+{
+  pdfio_obj_t	*dstobj;		// Destination object
+  pdfio_stream_t *srcst,		// Source stream
+		*dstst;			// Destination stream
+  char		buffer[32768];		// Copy buffer
+  ssize_t	bytes;			// Bytes read
+
+
+  // Load the object value if needed...
+  _pdfioObjLoad(srcobj);
+
+  // Create the new object...
+  if ((dstobj = _pdfioFileCreateObj(pdf, srcobj->pdf, NULL)) == NULL)
+    return (NULL);
+
+  // Add new object to the cache of copied objects...
+  if (!_pdfioFileAddMappedObj(pdf, dstobj, srcobj))
+    return (NULL);
+
+  // Copy the object's value...
+  if (!_pdfioValueCopy(pdf, &dstobj->value, srcobj->pdf, &srcobj->value))
+    return (NULL);
+
+  if (dstobj->value.type == PDFIO_VALTYPE_DICT)
+    pdfioDictClear(dstobj->value.value.dict, "Length");
+
+  if (srcobj->stream_offset && (pdf->options & PDFIO_OPTION_DEDUPLICATE))
+  {
+    // Copy stream data, sharing identical streams...
+    return (copy_shared_stream(pdf, dstobj, srcobj));
+  }
+  else if (srcobj->stream_offset)
+  {
+    // Copy stream data...
+    if ((srcst = pdfioObjOpenStream(srcobj, false)) == NULL)
+    {
+      pdfioObjClose(dstobj);
+      return (NULL);
+    }
+
+    if ((dstst = pdfioObjCreateStream(dstobj, PDFIO_FILTER_NONE)) == NULL)
+    {
+      pdfioStreamClose(srcst);
+      pdfioObjClose(dstobj);
+      return (NULL);
+    }
+
+    while ((bytes = pdfioStreamRead(srcst, buffer, sizeof(buffer))) > 0)
+    {
+      if (!pdfioStreamWrite(dstst, buffer, (size_t)bytes))
+      {
+        bytes = -1;
+        break;
+      }
+    }
+
+    pdfioStreamClose(srcst);
+    pdfioStreamClose(dstst);
+
+    if (bytes < 0)
+      return (NULL);
+  }
+  else
+    pdfioObjClose(dstobj);
+
+  return (dstobj);
+}
+
+
+//
+// 'copy_shared_stream()' - Copy stream data or share an identical object.
+//
+// The SHA-256 digest of the destination dictionary and raw stream data is
+// used to find an identical object that was already copied.  Since indirect
+// references in the dictionary have already been copied (and shared), nested
+// resources such as ICC profiles and soft masks match as well.  An unused
+// destination object is written as a free object in the cross-reference table.
+//
+
+static pdfio_obj_t *			// O - Destination object or `NULL` on error
+copy_shared_stream(
+    pdfio_file_t *pdf,			// I - Destination PDF file
+    pdfio_obj_t  *dstobj,		// I - Destination object
+    pdfio_obj_t  *srcobj)		// I - Source object
+{
+  pdfio_obj_t	*match;			// Matching object
+  pdfio_stream_t *srcst,		// Source stream
+		*dstst;			// Destination stream
+  unsigned char	*data = NULL,		// Stream data
+		*newdata;		// New stream data buffer
+  size_t	datalen = 0,		// Length of stream data
+		dataalloc = 0;		// Allocated size of stream data
+  ssize_t	bytes;			// Bytes read
+  bool		ret;			// Return value
+  _pdfio_sha256_t ctx;			// SHA-256 context
+  uint8_t	digest[32];		// SHA-256 digest
+
+
+  // Read the raw stream data into memory...
+  if ((srcst = pdfioObjOpenStream(srcobj, false)) == NULL)
+  {
+    pdfioObjClose(dstobj);
+    return (NULL);
+  }
+
+  do
+  {
+    if (datalen >= dataalloc)
+    {
+      dataalloc = dataalloc ? 2 * dataalloc : 32768;
+
+      if ((newdata = realloc(data, dataalloc)) == NULL)
+      {
+        _pdfioFileError(pdf, "Unable to allocate memory for stream data.");
+        free(data);
+        pdfioStreamClose(srcst);
+        return (NULL);
+      }
+
+      data = newdata;
+    }
+
+    if ((bytes = pdfioStreamRead(srcst, data + datalen, dataalloc - datalen)) > 0)
+      datalen += (size_t)bytes;
+  }
+  while (bytes > 0);
+
+  pdfioStreamClose(srcst);
+
+  if (bytes < 0)
+  {
+    free(data);
+    return (NULL);
+  }
+
+  // Compute the digest of the dictionary and the stream data...
+  _pdfioCryptoSHA256Init(&ctx);
+
+  if (!_pdfioValueDigest(pdf, &dstobj->value, &ctx))
+  {
+    free(data);
+    return (NULL);
+  }
+
+  _pdfioCryptoSHA256Append(&ctx, data, datalen);
+  _pdfioCryptoSHA256Finish(&ctx, digest);
+
+  if ((match = _pdfioFileFindHashedObj(pdf, digest)) != NULL)
+  {
+    // Use the existing object and leave the new one unwritten...
+    free(data);
+
+    dstobj->value.type = PDFIO_VALTYPE_NONE;
+
+    if (!_pdfioFileAddMappedObj(pdf, match, srcobj))
+      return (NULL);
+
+    return (match);
+  }
+
+  // Write the stream data to the new object...
+  if ((dstst = pdfioObjCreateStream(dstobj, PDFIO_FILTER_NONE)) == NULL)
+  {
+    free(data);
+    return (NULL);
+  }
+
+  ret = datalen == 0 || pdfioStreamWrite(dstst, data, datalen);
+
+  free(data);
+
+  if (!pdfioStreamClose(dstst) || !ret)
+    return (NULL);
+
+  if (!_pdfioFileAddHashedObj(pdf, dstobj, digest))
+    return (NULL);
+
+  return (dstobj);
+}
+
+
+//
+// 'load_obj()' - Load an object dictionary/value from the file.
+//
+
+static bool				// O - `true` on success, `false` otherwise
+load_obj(pdfio_obj_t *obj)		// I - Object
 {
   char			line[64],	// Line from file
 			*ptr;		// Pointer into line
@@ -437,8 +981,6 @@ _pdfioObjLoad(pdfio_obj_t *obj)		// I - Object
   _pdfio_token_t	tb;		// Token buffer/stack
 
 
-  PDFIO_DEBUG("_pdfioObjLoad(obj=%p(%lu)), offset=%lu\n", obj, (unsigned long)obj->number, (unsigned long)obj->offset);
-
   // Seek to the start of the object and read its header...
   if (_pdfioFileSeek(obj->pdf, obj->offset, SEEK_SET) != obj->offset)
   {
@@ -531,53 +1073,66 @@ _pdfioObjLoad(pdfio_obj_t *obj)		// I - Object
 
 
 //
-// 'pdfioObjOpenStream()' - Open an object's (data) stream for reading.
+// 'update_obj()' - Append a modified object from the original file.
+//
+// The (possibly modified) value of the object is written at the end of the
+// file.  The raw data of a stream object is copied as-is, since the object
+// number, generation, and thus any encryption key are unchanged.
 //
 
-pdfio_stream_t *			// O - Stream or `NULL` on error
-pdfioObjOpenStream(pdfio_obj_t *obj,	// I - Object
-                   bool        decode)	// I - Decode/decompress data?
+static bool				// O - `true` on success, `false` on failure
+update_obj(pdfio_obj_t *obj)		// I - Object
 {
-  // Range check input...
-  if (!obj)
-    return (NULL);
+  pdfio_file_t	*pdf = obj->pdf;	// PDF file
+  off_t		stream_offset;		// Offset of original stream data
+  size_t	length,			// Length of stream data
+		bytes;			// Bytes to copy
+  ssize_t	rbytes;			// Bytes read
+  char		buffer[32768];		// Copy buffer
 
-  if (obj->pdf->current_obj)
-  {
-    _pdfioFileError(obj->pdf, "Another object (%u) is already open.", (unsigned)obj->pdf->current_obj->number);
-    return (NULL);
-  }
 
-  // Make sure we've loaded the object dictionary...
-  if (!obj->value.type)
+  // Make sure the original value has been loaded...
+  if (!_pdfioObjLoad(obj))
+    return (false);
+
+  if ((stream_offset = obj->stream_offset) == 0)
   {
-    if (!_pdfioObjLoad(obj))
-      return (NULL);
+    // Not a stream, write the object normally...
+    obj->offset = 0;
+    obj->objstm = 0;
+
+    return (pdfioObjClose(obj));
   }
 
-  // No stream if there is no dict or offset to a stream...
-  if (obj->value.type != PDFIO_VALTYPE_DICT || !obj->stream_offset)
-    return (NULL);
+  // Use a direct length for the copied stream data...
+  length = pdfioObjGetLength(obj);
 
-  // Open the stream...
-  obj->pdf->current_obj = obj;
+  pdfioDictSetNumber(obj->value.value.dict, "Length", (double)length);
 
-  return (_pdfioStreamOpen(obj, decode));
-}
+  if (!write_obj_header(obj) || !_pdfioFilePuts(pdf, "stream\n"))
+    return (false);
 
+  obj->stream_offset = _pdfioFileTell(pdf);
+  obj->stream_length = length;
 
-//
-// '_pdfioObjSetExtension()' - Set extension data for an object.
-//
+  while (length > 0)
+  {
+    bytes = length > sizeof(buffer) ? sizeof(buffer) : length;
 
-void
-_pdfioObjSetExtension(
-    pdfio_obj_t      *obj,		// I - Object
-    void             *data,		// I - Data
-    _pdfio_extfree_t datafree)		// I - Free function
-{
-  obj->data     = data;
-  obj->datafree = datafree;
+    if ((rbytes = _pdfioFileReadAt(pdf, stream_offset, buffer, bytes)) <= 0)
+    {
+      _pdfioFileError(pdf, "Unable to read stream data for object %lu.", (unsigned long)obj->number);
+      return (false);
+    }
+
+    if (!_pdfioFileWrite(pdf, buffer, (size_t)rbytes))
+      return (false);
+
+    stream_offset += rbytes;
+    length        -= (size_t)rbytes;
+  }
+
+  return (_pdfioFilePuts(pdf, "\nendstream\nendobj\n"));
 }
 
 
@@ -20,12 +20,33 @@ static _pdfio_value_t	*get_contents(pdfio_obj_t *page);
 //
 // 'pdfioPageCopy()' - Copy a page to a PDF file.
 //
+// The page is added to the page tree of the destination file.  Any attributes
+// the page inherits from the source page tree ("CropBox", "MediaBox",
+// "Resources", and "Rotate") are copied to the new page.
+//
 
 bool					// O - `true` on success, `false` on failure
 pdfioPageCopy(pdfio_file_t *pdf,	// I - PDF file
               pdfio_obj_t  *srcpage)	// I - Source page
 {
-  pdfio_obj_t	*dstpage;		// Destination page object
+  bool		ret = false;		// Return value
+  pdfio_file_t	*srcpdf;		// Source PDF file
+  pdfio_obj_t	*dstpage,		// Destination page object
+		*parent,		// Parent pages object
+		*srcparent,		// Source parent pages object
+		*node;			// Current source pages node
+  pdfio_dict_t	*dstdict;		// Destination page dictionary
+  size_t	i,			// Looping var
+		depth;			// Depth of page tree
+  _pdfio_value_t *srcvalue,		// Inherited source value
+		dstvalue;		// Copied value
+  static const char * const inherited[] =
+  {					// Inheritable page attributes
+    "CropBox",
+    "MediaBox",
+    "Resources",
+    "Rotate"
+  };
 
 
   PDFIO_DEBUG("pdfioPageCopy(pdf=%p, srcpage=%p(%p))\n", pdf, srcpage, srcpage ? srcpage->pdf : NULL);
@@ -44,11 +65,63 @@ pdfioPageCopy(pdfio_file_t *pdf,	// I - PDF file
     return (false);
   }
 
-  // Copy the page object and add it to the pages array...
-  if ((dstpage = pdfioObjCopy(pdf, srcpage)) == NULL)
+  // Copying a page within the same file shares the page tree...
+  if ((srcpdf = srcpage->pdf) == pdf)
+  {
+    if ((dstpage = pdfioObjCopy(pdf, srcpage)) == NULL)
+      return (false);
+    else
+      return (_pdfioFileAddPage(pdf, dstpage));
+  }
+
+  // Find the page tree node for the new page...
+  if ((parent = _pdfioFileGetPageParent(pdf)) == NULL)
     return (false);
-  else
-    return (_pdfioFileAddPage(pdf, dstpage));
+
+  // Keep the cached values of the source file while copying...
+
+  _pdfioFileLock(srcpdf);
+  srcpdf->cache_hold ++;
+  _pdfioFileUnlock(srcpdf);
+
+  // Map the source parent to the new parent so that the source page tree and
+  // its other pages are not copied along with this page...
+  srcparent = pdfioDictGetObj(srcpage->value.value.dict, "Parent");
+
+  if (srcparent && !_pdfioFileAddMappedObj(pdf, parent, srcparent))
+    goto done;
+
+  // Copy the page object...
+  if ((dstpage = _pdfioFileCreateObj(pdf, srcpdf, NULL)) == NULL || !_pdfioFileAddMappedObj(pdf, dstpage, srcpage) || !_pdfioValueCopy(pdf, &dstpage->value, srcpdf, &srcpage->value))
+    goto done;
+
+  dstdict = dstpage->value.value.dict;
+
+  pdfioDictSetObj(dstdict, "Parent", parent);
+
+  // Copy any attributes the page inherits from the source page tree...
+  for (node = srcparent, depth = 0; node && depth < PDFIO_MAX_DEPTH; node = pdfioDictGetObj(pdfioObjGetDict(node), "Parent"), depth ++)
+  {
+    for (i = 0; i < (sizeof(inherited) / sizeof(inherited[0])); i ++)
+    {
+      if (_pdfioDictGetValue(dstdict, inherited[i]) || (srcvalue = _pdfioDictGetValue(pdfioObjGetDict(node), inherited[i])) == NULL)
+        continue;
+
+      if (!_pdfioValueCopy(pdf, &dstvalue, srcpdf, srcvalue) || !_pdfioDictSetValue(dstdict, inherited[i], &dstvalue))
+        goto done;
+    }
+  }
+
+  // Write the page object and add it to the pages array...
+  ret = pdfioObjClose(dstpage) && _pdfioFileAddPage(pdf, dstpage);
+
+  done:
+
+  _pdfioFileLock(srcpdf);
+  srcpdf->cache_hold --;
+  _pdfioFileUnlock(srcpdf);
+
+  return (ret);
 }
 
 
@@ -110,14 +183,11 @@ get_contents(pdfio_obj_t *page)		// I - Page object
     return (NULL);
 
   // Load the page object as needed...
-  if (page->value.type == PDFIO_VALTYPE_NONE)
-  {
-    if (!_pdfioObjLoad(page))
-      return (NULL);
-  }
+  if (!_pdfioObjLoad(page))
+    return (NULL);
 
   if (page->value.type != PDFIO_VALTYPE_DICT)
     return (NULL);
 
-  return (_pdfioDictGetValue(page->value.value.dict, "Contents"));
+  return (_pdfioDictGetValue(page->value.value.dict, _pdfio_keys[_PDFIO_KEY_CONTENTS]));
 }
@@ -20,7 +20,6 @@
 #  include <errno.h>
 #  include <inttypes.h>
 #  include <fcntl.h>
-#  include <locale.h>
 #  ifdef _WIN32
 #    include <io.h>
 #    include <direct.h>
@@ -45,11 +44,13 @@
 #    endif // !F_OK
 #    define O_RDONLY	_O_RDONLY	// Map standard POSIX open flags
 #    define O_WRONLY	_O_WRONLY
+#    define O_RDWR	_O_RDWR
 #    define O_CREAT	_O_CREAT
 #    define O_TRUNC	_O_TRUNC
 #    define O_BINARY	_O_BINARY
 #  else // !_WIN32
 #    include <unistd.h>
+#    include <pthread.h>
 #    define O_BINARY	0		// Map Windows-specific open flag
 #  endif // _WIN32
 #  include <zlib.h>
@@ -94,10 +95,57 @@
 //
 
 #  define PDFIO_MAX_DEPTH	32	// Maximum nesting depth for values
+#  define _PDFIO_BLOCK_SIZE	32768	// Size of memory blocks
+#  define _PDFIO_CACHE_AHEAD	4	// Number of input cache blocks to read ahead
+#  define _PDFIO_CACHE_BLOCK	65536	// Size of input cache blocks
+#  define _PDFIO_CACHE_BLOCKS	64	// Number of input cache blocks
+#  define _PDFIO_CACHE_RUN	16	// Maximum number of input cache blocks fetched at once
+#  define _PDFIO_DEFLATE_CHUNK	131072	// Size of chunks for parallel Flate compression
+#  define _PDFIO_DEFLATE_MAX	67108864// Maximum bytes of stream data waiting for parallel compression
+#  define _PDFIO_DEFLATE_THREADS 16	// Maximum number of parallel compression threads
+#  define _PDFIO_INFLATE_MAX	16777216// Maximum size of Flate data that is decompressed all at once
+#  define _PDFIO_DICT_HASH	16	// Minimum number of pairs for a dictionary hash index
+#  define _PDFIO_OBJSTM_MAX	100	// Maximum number of objects in an object stream
+#  define _PDFIO_PAGE_FANOUT	32	// Default number of kids in each page tree node
+#  define _PDFIO_STRBUF_SIZE	16384	// Size of string buffer blocks
 
 typedef void (*_pdfio_extfree_t)(void *);
 					// Extension data free function
 
+#  ifdef _WIN32
+typedef CONDITION_VARIABLE _pdfio_cond_t;
+					// Condition variable
+typedef CRITICAL_SECTION _pdfio_mutex_t;
+					// Mutex
+typedef HANDLE _pdfio_thread_t;		// Thread
+#  else
+typedef pthread_cond_t _pdfio_cond_t;	// Condition variable
+typedef pthread_mutex_t _pdfio_mutex_t;	// Mutex
+typedef pthread_t _pdfio_thread_t;	// Thread
+#  endif // _WIN32
+
+typedef enum _pdfio_key_e		// Well-known dictionary keys
+{
+  _PDFIO_KEY_BITSPERCOMPONENT,		// BitsPerComponent
+  _PDFIO_KEY_COLORS,			// Colors
+  _PDFIO_KEY_COLUMNS,			// Columns
+  _PDFIO_KEY_CONTENTS,			// Contents
+  _PDFIO_KEY_COUNT,			// Count
+  _PDFIO_KEY_DECODEPARMS,		// DecodeParms
+  _PDFIO_KEY_FILTER,			// Filter
+  _PDFIO_KEY_FIRST,			// First
+  _PDFIO_KEY_KIDS,			// Kids
+  _PDFIO_KEY_LENGTH,			// Length
+  _PDFIO_KEY_MEDIABOX,			// MediaBox
+  _PDFIO_KEY_N,				// N
+  _PDFIO_KEY_PARENT,			// Parent
+  _PDFIO_KEY_PREDICTOR,			// Predictor
+  _PDFIO_KEY_RESOURCES,			// Resources
+  _PDFIO_KEY_SUBTYPE,			// Subtype
+  _PDFIO_KEY_TYPE,			// Type
+  _PDFIO_KEY_MAX			// Number of well-known keys
+} _pdfio_key_t;
+
 typedef enum _pdfio_mode_e		// Read/write mode
 {
   _PDFIO_MODE_READ,			// Read a PDF file
@@ -113,7 +161,7 @@ typedef enum _pdfio_predictor_e		// PNG predictor constants
   _PDFIO_PREDICTOR_PNG_UP = 12,		// PNG Up predictor
   _PDFIO_PREDICTOR_PNG_AVERAGE = 13,	// PNG Average predictor
   _PDFIO_PREDICTOR_PNG_PAETH = 14,	// PNG Paeth predictor
-  _PDFIO_PREDICTOR_PNG_AUTO = 15	// PNG "auto" predictor (currently mapped to Paeth)
+  _PDFIO_PREDICTOR_PNG_AUTO = 15	// PNG "auto" predictor (best filter for each line)
 } _pdfio_predictor_t;
 
 typedef ssize_t (*_pdfio_tconsume_cb_t)(void *data, size_t bytes);
@@ -215,6 +263,8 @@ struct _pdfio_dict_s			// Dictionary
   size_t	num_pairs,		// Number of pairs in use
 		alloc_pairs;		// Number of allocated pairs
   _pdfio_pair_t *pairs;			// Array of pairs
+  size_t	alloc_hash;		// Number of hash index entries
+  size_t	*hash;			// Hash index (pair number + 1) or `NULL`
 };
 
 typedef struct _pdfio_objmap_s		// PDF object map
@@ -224,10 +274,128 @@ typedef struct _pdfio_objmap_s		// PDF object map
   size_t	src_number;		// Source object number
 } _pdfio_objmap_t;
 
+typedef struct _pdfio_pnode_s		// Page tree node being written
+{
+  pdfio_obj_t	*obj;			// Pages object
+  size_t	num_kids,		// Number of kids
+		alloc_kids;		// Allocated kids
+  pdfio_obj_t	**kids;			// Kids
+  size_t	count;			// Number of pages under this node
+} _pdfio_pnode_t;
+
+typedef struct _pdfio_objhash_s		// PDF object content hash
+{
+  uint8_t	digest[32];		// SHA-256 digest of dictionary and stream data
+  pdfio_obj_t	*obj;			// Object for this file
+} _pdfio_objhash_t;
+
+typedef struct _pdfio_subfont_s		// Font that is subset when the file is closed
+{
+  pdfio_obj_t	*font_obj,		// Type0 font object
+		*type2_obj,		// CIDFontType2 font object
+		*file_obj,		// Font file object
+		*cid2gid_obj;		// CIDToGIDMap object
+} _pdfio_subfont_t;
+
+typedef struct _pdfio_xref_s		// Cross-reference entry for a freed object
+{
+  off_t		offset;			// Offset in file or index in object stream
+  size_t	objstm;			// Object stream containing the object, if any
+} _pdfio_xref_t;
+
+typedef struct _pdfio_dchunk_s		// Chunk of stream data for parallel Flate compression
+{
+  unsigned char	*cdata;			// Compressed data
+  size_t	cdatalen;		// Length of compressed data
+  uLong		adler;			// Adler-32 checksum of uncompressed data
+} _pdfio_dchunk_t;
+
+typedef struct _pdfio_djob_s		// Stream waiting for parallel Flate compression
+{
+  struct _pdfio_djob_s *next;		// Next stream in queue
+  pdfio_obj_t	*obj;			// Stream object
+  unsigned char	*data;			// Uncompressed stream data
+  size_t	datalen,		// Length of uncompressed data
+		dataalloc;		// Allocated size of uncompressed data
+  int		level;			// Compression level
+  pdfio_strategy_t strategy;		// Compression strategy
+  pdfio_deflate_cb_t deflate_cb;	// Compression callback, if any
+  void		*codec_data;		// Compression callback data
+  size_t	num_chunks,		// Number of chunks
+		next_chunk,		// Next chunk to compress
+		chunks_left;		// Number of chunks that are not yet compressed
+  _pdfio_dchunk_t *chunks;		// Chunks
+  bool		failed;			// Did compression fail?
+} _pdfio_djob_t;
+
+typedef struct _pdfio_dpool_s		// Parallel Flate compression threads
+{
+  _pdfio_mutex_t mutex;			// Mutex for queue
+  _pdfio_cond_t	work_cond,		// Signaled when chunks are queued
+		done_cond;		// Signaled when a stream is compressed
+  size_t	num_threads;		// Number of threads
+  _pdfio_thread_t threads[_PDFIO_DEFLATE_THREADS];
+					// Threads
+  bool		stopping,		// Are the threads stopping?
+		flushing;		// Are compressed streams being written?
+  _pdfio_djob_t	*first,			// First stream in queue
+		*last,			// Last stream in queue
+		*next;			// Next stream with chunks to compress
+  size_t	pending;		// Bytes of uncompressed data in queue
+} _pdfio_dpool_t;
+
+typedef struct _pdfio_cblock_s		// Input cache block
+{
+  off_t		offset;			// Offset of block in file or `-1` if unused
+  size_t	length;			// Number of bytes in block
+  unsigned	used;			// Use counter value for LRU replacement
+  unsigned char	*data;			// Block data
+} _pdfio_cblock_t;
+
+typedef struct _pdfio_cache_s		// Input cache for pdfioFileOpenIO
+{
+  _pdfio_mutex_t mutex;			// Mutex for concurrent reads
+  unsigned	counter;		// Use counter
+  off_t		next_offset;		// End of the last fetch for read-ahead
+  _pdfio_cblock_t blocks[_PDFIO_CACHE_BLOCKS];
+					// Cache blocks
+  unsigned char	*run;			// Buffer for coalesced reads
+} _pdfio_cache_t;
+
+typedef struct _pdfio_linobj_s		// Object layout for linearized output
+{
+  pdfio_obj_t	*obj;			// Object, if any
+  size_t	page,			// Page that uses the object (1-based), if any
+		mark,			// Page currently being scanned (1-based)
+		number,			// New object number
+		shared;			// Shared object identifier for hint tables
+  size_t	text_offset,		// Offset of object text in spool buffer
+		text_length,		// Length of object text
+		length;			// Length of object in the PDF file
+  off_t		offset;			// New offset in the PDF file
+} _pdfio_linobj_t;
+
+typedef struct _pdfio_objstm_s		// Object stream index
+{
+  size_t	number,			// Object stream number
+		first,			// Offset of first object in stream data
+		count;			// Number of objects
+  size_t	*entries;		// Object numbers and offsets
+} _pdfio_objstm_t;
+
+typedef struct _pdfio_block_s		// Memory block
+{
+  struct _pdfio_block_s *next;		// Next block
+  size_t	used,			// Bytes used in buffer
+		size,			// Size of buffer
+		live;			// Number of allocations still in use
+  char		buffer[];		// Buffer
+} _pdfio_block_t;
+
 struct _pdfio_file_s			// PDF file structure
 {
   char		*filename;		// Filename
-  struct lconv	*loc;			// Locale data
+  int		precision;		// Number of decimal places for reals or a `PDFIO_PRECISION_` value
   char		*version;		// Version number
   pdfio_rect_t	media_box,		// Default MediaBox value
 		crop_box;		// Default CropBox value
@@ -236,6 +404,12 @@ struct _pdfio_file_s			// PDF file structure
   void		*output_ctx;		// Context for output callback
   pdfio_error_cb_t error_cb;		// Error callback
   void		*error_data;		// Data for error callback
+  pdfio_option_t options;		// Output options
+  int		level;			// Default Flate compression level
+  pdfio_strategy_t strategy;		// Default Flate compression strategy
+  pdfio_deflate_cb_t deflate_cb;	// Flate compression callback, if any
+  pdfio_inflate_cb_t inflate_cb;	// Flate decompression callback, if any
+  void		*codec_data;		// Flate callback data
 
   pdfio_encryption_t encryption;	// Encryption mode
   pdfio_permission_t permissions;	// Access permissions (encrypted PDF files)
@@ -249,10 +423,31 @@ struct _pdfio_file_s			// PDF file structure
 
   // Active file data
   int		fd;			// File descriptor
-  char		buffer[8192],		// Read/write buffer
+  const char	*memdata;		// Memory-mapped or in-memory file data, if any
+  size_t	memsize;		// Size of file data in memory
+  bool		memmapped;		// Was the file data mapped with `mmap`?
+  pdfio_input_cb_t input_cb;		// Input callback, if any
+  void		*input_ctx;		// Context for input callback
+  off_t		input_size,		// Size of file data from input callback
+		input_pos;		// Read position for input callback
+  _pdfio_cache_t *cache;		// Block cache for input callback
+  char		*buffer,		// Read/write buffer (`localbuf` or `memdata`)
 		*bufptr,		// Pointer into buffer
 		*bufend;		// End of buffer
   off_t		bufpos;			// Position in file for start of buffer
+  char		localbuf[8192];		// Local read/write buffer
+  bool		spooling;		// Are writes going to the spool buffer?
+  off_t		spool_bufpos;		// Saved file position while spooling
+  char		*spool;			// Spool buffer
+  size_t	spoollen,		// Bytes in spool buffer
+		spoolalloc;		// Allocated size of spool buffer
+  pdfio_obj_t	*objstm_obj;		// Current object stream being written, if any
+  size_t	num_objstm,		// Number of objects in current object stream
+		objstm_numbers[_PDFIO_OBJSTM_MAX],
+					// Object numbers in current object stream
+		objstm_offsets[_PDFIO_OBJSTM_MAX],
+					// Offsets of objects in spool buffer
+		num_objstms;		// Number of object streams written
   pdfio_dict_t	*trailer_dict;		// Trailer dictionary
   pdfio_obj_t	*root_obj;		// Root object/dictionary
   pdfio_obj_t	*info_obj;		// Information object
@@ -263,26 +458,91 @@ struct _pdfio_file_s			// PDF file structure
   pdfio_array_t	*id_array;		// ID array
 
   // Allocated data elements
-  size_t	num_arrays,		// Number of arrays
-		alloc_arrays;		// Allocated arrays
-  pdfio_array_t	**arrays;		// Arrays
-  size_t	num_dicts,		// Number of dictionaries
-		alloc_dicts;		// Allocated dictionaries
-  pdfio_dict_t	**dicts;		// Dictionaries
+  _pdfio_block_t *blocks;		// Memory blocks for arrays, dictionaries, and values
+  size_t	num_bindex,		// Number of memory block index entries
+		alloc_bindex,		// Allocated memory block index entries
+		alloc_bytes;		// Number of bytes allocated from memory blocks
+  _pdfio_block_t **bindex;		// Memory blocks sorted by address
   size_t	num_objs,		// Number of objects
-		alloc_objs,		// Allocated objects
-		last_obj;		// Last object added
+		alloc_objs;		// Allocated objects
   pdfio_obj_t	**objs,			// Objects
 		*current_obj;		// Current object being written/read
+  bool		sort_objs;		// Do the objects need to be sorted by number?
+  size_t	alloc_objnums;		// Allocated object number index entries
+  pdfio_obj_t	**objnums;		// Objects indexed by object number
+  size_t	num_sparse_objs,	// Number of objects outside the index
+		sorted_sparse_objs,	// Number of objects outside the index that are sorted
+		alloc_sparse_objs;	// Allocated objects outside the index
+  pdfio_obj_t	**sparse_objs;		// Objects outside the index, sorted by number up to sorted_sparse_objs
+  size_t	num_xrefs,		// Number of written objects that have been freed
+		alloc_xrefs;		// Allocated cross-reference entries
+  _pdfio_xref_t	*xrefs;			// Cross-reference entries of freed objects, indexed by number - 1
   size_t	num_objmaps,		// Number of object maps
 		alloc_objmaps;		// Allocated object maps
   _pdfio_objmap_t *objmaps;		// Object maps
+  size_t	num_objhashes,		// Number of object content hashes
+		alloc_objhashes;	// Allocated object content hashes
+  _pdfio_objhash_t *objhashes;		// Object content hashes, sorted by digest
+  size_t	num_subfonts,		// Number of fonts to subset
+		alloc_subfonts;		// Allocated fonts to subset
+  _pdfio_subfont_t *subfonts;		// Fonts to subset
+  _pdfio_dpool_t *dpool;		// Parallel Flate compression threads, if any
+  uint8_t	*used_chars;		// Bitmap of Unicode characters shown with subset fonts
   size_t	num_pages,		// Number of pages
 		alloc_pages;		// Allocated pages
   pdfio_obj_t	**pages;		// Pages
+  bool		lazy_pages;		// Are pages looked up as needed using the page tree?
+  size_t	page_fanout,		// Maximum number of kids in each page tree node, 0 for one node
+		num_page_levels;	// Number of page tree levels being written
+  _pdfio_pnode_t page_levels[PDFIO_MAX_DEPTH];
+					// Current page tree node for each level, leaves first
+  size_t	num_page_nodes,		// Number of page tree nodes
+		alloc_page_nodes;	// Allocated page tree nodes
+  pdfio_obj_t	**page_nodes;		// Page tree nodes
   size_t	num_strings,		// Number of strings
-		alloc_strings;		// Allocated strings
-  char		**strings;		// Nul-terminated strings
+		alloc_strings;		// Allocated string hash table entries
+  char		**strings;		// String hash table
+  _pdfio_block_t *strbufs;		// String buffer blocks
+
+  // Object value cache
+  size_t	cache_limit,		// Memory limit for cached object values, 0 for none
+		cache_bytes;		// Memory used by cached object values
+  int		cache_hold;		// Number of operations using cached values
+  pdfio_obj_t	*cache_first,		// Least recently used cached object
+		*cache_last;		// Most recently used cached object
+  size_t	num_objstm_idx,		// Number of object stream indices
+		alloc_objstm_idx;	// Allocated object stream indices
+  _pdfio_objstm_t *objstm_idx;		// Object stream indices, sorted by number
+
+  // Statistics and tracing
+  pdfio_stats_t	stats;			// Runtime statistics
+  pdfio_span_cb_t span_cb;		// Span callback, if any
+  void		*span_data;		// Span callback data
+
+  // Concurrent reading
+  bool		concurrent;		// Allow reads from multiple threads?
+  bool		have_mutex;		// Has the mutex been initialized?
+  _pdfio_mutex_t mutex;			// Mutex for shared file state
+
+  // Incremental updates
+  bool		update;			// Appending an incremental update?
+  off_t		update_offset,		// Offset of the incremental update
+		update_pos,		// Saved write position while reading
+		update_xref;		// Offset of the previous xref table/stream
+  size_t	update_objnum,		// First object number in the update
+		update_num_objs,	// Number of objects created by the update
+		update_num_pages;	// Number of pages before the update
+
+  // Linearized output
+  bool		linearize;		// Writing a linearized PDF file?
+  int		lin_fd,			// Temporary file for objects
+		lin_outfd;		// Saved output file descriptor
+  pdfio_output_cb_t lin_output_cb;	// Saved output callback
+  void		*lin_output_ctx;	// Saved output callback context
+  off_t		lin_offset;		// Offset of objects in the PDF file
+  char		*lin_filename;		// Temporary filename, if any
+  size_t	num_lin_objs;		// Number of object layouts
+  _pdfio_linobj_t *lin_objs;		// Object layouts indexed by original number
 };
 
 struct _pdfio_obj_s			// Object
@@ -294,8 +554,16 @@ struct _pdfio_obj_s			// Object
 		length_offset,		// Offset to /Length in object dict
 		stream_offset;		// Offset to start of stream in file
   size_t	stream_length;		// Length of stream, if any
+  size_t	objstm;			// Compressed object stream containing this object, if any
   _pdfio_value_t value;			// Dictionary/number/etc. value
+  bool		have_key;		// Is the encryption key cached?
+  uint8_t	key[16];		// Cached RC4/AES encryption key
   pdfio_stream_t *stream;		// Open stream, if any
+  bool		release;		// Release value once written?
+  bool		pinned;			// Value used by the application?
+  size_t	cache_bytes;		// Memory used by cached value, 0 if not cached
+  pdfio_obj_t	*cache_prev,		// Less recently used cached object
+		*cache_next;		// More recently used cached object
   void		*data;			// Extension data, if any
   _pdfio_extfree_t datafree;		// Free callback for extension data
 };
@@ -305,33 +573,59 @@ struct _pdfio_stream_s			// Stream
   pdfio_file_t	*pdf;			// PDF file
   pdfio_obj_t	*obj;			// Object
   pdfio_obj_t	*length_obj;		// Length object, if any
+  _pdfio_mode_t	mode;			// Read/write mode
   pdfio_filter_t filter;		// Compression/decompression filter
   size_t	remaining;		// Remaining bytes in stream
+  _pdfio_djob_t	*djob;			// Parallel Flate compression data, if any
+  bool		concurrent;		// Read using the stream's own file position?
+  off_t		filepos;		// File position for concurrent reads
   char		buffer[8192],		// Read/write buffer
 		*bufptr,		// Current position in buffer
 	        *bufend;		// End of buffer
   z_stream	flate;			// Flate filter state
+  int		level;			// Flate compression level
+  pdfio_strategy_t strategy;		// Flate compression strategy
+  bool		inflate_all;		// Decompress the whole stream on the first read?
+  unsigned char	*cdata,			// Compressed data for the whole stream, if any
+		*ddata;			// Decompressed data for the whole stream, if any
+  bool		deferred;		// Keep compressed data in memory until closed?
+  size_t	cdatalen,		// Length of compressed data for a deferred stream
+		cdataalloc;		// Allocated size of compressed data
+  size_t	ddatalen,		// Length of decompressed data
+		ddatapos;		// Current position in decompressed data
   _pdfio_predictor_t predictor;		// Predictor function, if any
   size_t	pbpixel,		// Size of a pixel in bytes
 		pbsize;			// Predictor buffer size, if any
   unsigned char	cbuffer[4096],		// Compressed data buffer
 		*prbuffer,		// Raw buffer (previous line), as needed
-		*psbuffer;		// PNG filter buffer, as needed
+		*psbuffer,		// PNG filter buffer, as needed
+		*pcbuffer;		// Candidate PNG filter buffer, as needed
   _pdfio_crypto_cb_t crypto_cb;		// Encryption/descryption callback, if any
   _pdfio_crypto_ctx_t crypto_ctx;	// Cryptographic context
+  size_t	crypto_bytes;		// Bytes encrypted/decrypted
 };
 
 
+//
+// Globals...
+//
+
+extern bool		_pdfio_crypto_accel _PDFIO_INTERNAL;
+					// Use AES-NI/SHA-NI instructions when available?
+extern const char * const _pdfio_keys[_PDFIO_KEY_MAX] _PDFIO_INTERNAL;
+					// Well-known dictionary keys
+
+
 //
 // Functions...
 //
 
-extern double		_pdfio_strtod(pdfio_file_t *pdf, const char *s) _PDFIO_INTERNAL;
+extern size_t		_pdfio_dtostr(char *buffer, size_t bufsize, double number, int digits, int decimals) _PDFIO_INTERNAL;
+extern double		_pdfio_strtod(const char *s, const char **end) _PDFIO_INTERNAL;
 extern ssize_t		_pdfio_vsnprintf(pdfio_file_t *pdf, char *buffer, size_t bufsize, const char *format, va_list ap) _PDFIO_INTERNAL;
 
 extern bool		_pdfioArrayDecrypt(pdfio_file_t *pdf, pdfio_obj_t *obj, pdfio_array_t *a, size_t depth) _PDFIO_INTERNAL;
 extern void		_pdfioArrayDebug(pdfio_array_t *a, FILE *fp) _PDFIO_INTERNAL;
-extern void		_pdfioArrayDelete(pdfio_array_t *a) _PDFIO_INTERNAL;
 extern _pdfio_value_t	*_pdfioArrayGetValue(pdfio_array_t *a, size_t n) _PDFIO_INTERNAL;
 extern pdfio_array_t	*_pdfioArrayRead(pdfio_file_t *pdf, pdfio_obj_t *obj, _pdfio_token_t *ts, size_t depth) _PDFIO_INTERNAL;
 extern bool		_pdfioArrayWrite(pdfio_array_t *a, pdfio_obj_t *obj) _PDFIO_INTERNAL;
@@ -339,6 +633,8 @@ extern bool		_pdfioArrayWrite(pdfio_array_t *a, pdfio_obj_t *obj) _PDFIO_INTERNA
 extern void		_pdfioCryptoAESInit(_pdfio_aes_t *ctx, const uint8_t *key, size_t keylen, const uint8_t *iv) _PDFIO_INTERNAL;
 extern size_t		_pdfioCryptoAESDecrypt(_pdfio_aes_t *ctx, uint8_t *outbuffer, const uint8_t *inbuffer, size_t len) _PDFIO_INTERNAL;
 extern size_t		_pdfioCryptoAESEncrypt(_pdfio_aes_t *ctx, uint8_t *outbuffer, const uint8_t *inbuffer, size_t len) _PDFIO_INTERNAL;
+extern bool		_pdfioContentSubsetFonts(pdfio_file_t *pdf) _PDFIO_INTERNAL;
+
 extern bool		_pdfioCryptoLock(pdfio_file_t *pdf, pdfio_permission_t permissions, pdfio_encryption_t encryption, const char *owner_password, const char *user_password) _PDFIO_INTERNAL;
 extern void		_pdfioCryptoMakeRandom(uint8_t *buffer, size_t bytes) _PDFIO_INTERNAL;
 extern _pdfio_crypto_cb_t _pdfioCryptoMakeReader(pdfio_file_t *pdf, pdfio_obj_t *obj, _pdfio_crypto_ctx_t *ctx, uint8_t *iv, size_t *ivlen) _PDFIO_INTERNAL;
@@ -351,42 +647,72 @@ extern size_t		_pdfioCryptoRC4Crypt(_pdfio_rc4_t *ctx, uint8_t *outbuffer, const
 extern void		_pdfioCryptoSHA256Append(_pdfio_sha256_t *, const uint8_t *bytes, size_t bytecount) _PDFIO_INTERNAL;
 extern void		_pdfioCryptoSHA256Init(_pdfio_sha256_t *ctx) _PDFIO_INTERNAL;
 extern void		_pdfioCryptoSHA256Finish(_pdfio_sha256_t *ctx, uint8_t *Message_Digest) _PDFIO_INTERNAL;
+extern bool		_pdfioCryptoSetAccel(bool accel) _PDFIO_INTERNAL;
 extern bool		_pdfioCryptoUnlock(pdfio_file_t *pdf, pdfio_password_cb_t password_cb, void *password_data) _PDFIO_INTERNAL;
 
 extern bool		_pdfioDictDecrypt(pdfio_file_t *pdf, pdfio_obj_t *obj, pdfio_dict_t *dict, size_t depth) _PDFIO_INTERNAL;
 extern void		_pdfioDictDebug(pdfio_dict_t *dict, FILE *fp) _PDFIO_INTERNAL;
-extern void		_pdfioDictDelete(pdfio_dict_t *dict) _PDFIO_INTERNAL;
 extern _pdfio_value_t	*_pdfioDictGetValue(pdfio_dict_t *dict, const char *key) _PDFIO_INTERNAL;
 extern pdfio_dict_t	*_pdfioDictRead(pdfio_file_t *pdf, pdfio_obj_t *obj, _pdfio_token_t *ts, size_t depth) _PDFIO_INTERNAL;
 extern bool		_pdfioDictSetValue(pdfio_dict_t *dict, const char *key, _pdfio_value_t *value) _PDFIO_INTERNAL;
 extern bool		_pdfioDictWrite(pdfio_dict_t *dict, pdfio_obj_t *obj, off_t *length) _PDFIO_INTERNAL;
 
+extern bool		_pdfioFileAddCompressedObj(pdfio_file_t *pdf, pdfio_obj_t *obj) _PDFIO_INTERNAL;
+extern bool		_pdfioFileAddHashedObj(pdfio_file_t *pdf, pdfio_obj_t *obj, const uint8_t *digest) _PDFIO_INTERNAL;
 extern bool		_pdfioFileAddMappedObj(pdfio_file_t *pdf, pdfio_obj_t *dst_obj, pdfio_obj_t *src_obj) _PDFIO_INTERNAL;
 extern bool		_pdfioFileAddPage(pdfio_file_t *pdf, pdfio_obj_t *obj) _PDFIO_INTERNAL;
+extern void		*_pdfioFileAlloc(pdfio_file_t *pdf, size_t bytes) _PDFIO_INTERNAL;
+extern bool		_pdfioFileBeginRead(pdfio_file_t *pdf) _PDFIO_INTERNAL;
+extern bool		_pdfioFileBeginSpool(pdfio_file_t *pdf) _PDFIO_INTERNAL;
 extern bool		_pdfioFileConsume(pdfio_file_t *pdf, size_t bytes) _PDFIO_INTERNAL;
+extern bool		_pdfioFileCreateCache(pdfio_file_t *pdf) _PDFIO_INTERNAL;
 extern pdfio_obj_t	*_pdfioFileCreateObj(pdfio_file_t *pdf, pdfio_file_t *srcpdf, _pdfio_value_t *value) _PDFIO_INTERNAL;
 extern bool		_pdfioFileDefaultError(pdfio_file_t *pdf, const char *message, void *data) _PDFIO_INTERNAL;
+extern void		_pdfioFileDeleteCache(pdfio_file_t *pdf) _PDFIO_INTERNAL;
+extern void		_pdfioFileEndRead(pdfio_file_t *pdf) _PDFIO_INTERNAL;
+extern bool		_pdfioFileEndSpool(pdfio_file_t *pdf) _PDFIO_INTERNAL;
 extern bool		_pdfioFileError(pdfio_file_t *pdf, const char *format, ...) _PDFIO_FORMAT(2,3) _PDFIO_INTERNAL;
+extern pdfio_obj_t	*_pdfioFileFindHashedObj(pdfio_file_t *pdf, const uint8_t *digest) _PDFIO_INTERNAL;
 extern pdfio_obj_t	*_pdfioFileFindMappedObj(pdfio_file_t *pdf, pdfio_file_t *src_pdf, size_t src_number) _PDFIO_INTERNAL;
 extern bool		_pdfioFileFlush(pdfio_file_t *pdf) _PDFIO_INTERNAL;
+extern void		_pdfioFileFree(pdfio_file_t *pdf, void *ptr) _PDFIO_INTERNAL;
+extern void		_pdfioFileFreeObj(pdfio_file_t *pdf, pdfio_obj_t *obj) _PDFIO_INTERNAL;
 extern int		_pdfioFileGetChar(pdfio_file_t *pdf) _PDFIO_INTERNAL;
+extern pdfio_obj_t	*_pdfioFileGetPageParent(pdfio_file_t *pdf) _PDFIO_INTERNAL;
 extern bool		_pdfioFileGets(pdfio_file_t *pdf, char *buffer, size_t bufsize) _PDFIO_INTERNAL;
+extern bool		_pdfioFileLoadCompressedObj(pdfio_file_t *pdf, pdfio_obj_t *obj) _PDFIO_INTERNAL;
+extern bool		_pdfioFileLoadObjStream(pdfio_file_t *pdf, size_t number) _PDFIO_INTERNAL;
+extern void		_pdfioFileLock(pdfio_file_t *pdf) _PDFIO_INTERNAL;
 extern ssize_t		_pdfioFilePeek(pdfio_file_t *pdf, void *buffer, size_t bytes) _PDFIO_INTERNAL;
+extern void		_pdfioFilePrefetch(pdfio_file_t *pdf, off_t offset, size_t bytes) _PDFIO_INTERNAL;
 extern bool		_pdfioFilePrintf(pdfio_file_t *pdf, const char *format, ...) _PDFIO_FORMAT(2,3) _PDFIO_INTERNAL;
 extern bool		_pdfioFilePuts(pdfio_file_t *pdf, const char *s) _PDFIO_INTERNAL;
 extern ssize_t		_pdfioFileRead(pdfio_file_t *pdf, void *buffer, size_t bytes) _PDFIO_INTERNAL;
+extern ssize_t		_pdfioFileReadAt(pdfio_file_t *pdf, off_t offset, void *buffer, size_t bytes) _PDFIO_INTERNAL;
+extern const char	*_pdfioFileReadMapped(pdfio_file_t *pdf, size_t *bytes) _PDFIO_INTERNAL;
+extern const char	*_pdfioFileReadMappedAt(pdfio_file_t *pdf, off_t offset, size_t *bytes) _PDFIO_INTERNAL;
 extern off_t		_pdfioFileSeek(pdfio_file_t *pdf, off_t offset, int whence) _PDFIO_INTERNAL;
+extern void		_pdfioFileSpan(pdfio_file_t *pdf, pdfio_span_t span, bool begin) _PDFIO_INTERNAL;
 extern off_t		_pdfioFileTell(pdfio_file_t *pdf) _PDFIO_INTERNAL;
+extern void		_pdfioFileUnlock(pdfio_file_t *pdf) _PDFIO_INTERNAL;
 extern bool		_pdfioFileWrite(pdfio_file_t *pdf, const void *buffer, size_t bytes) _PDFIO_INTERNAL;
 
+extern void		_pdfioObjCache(pdfio_obj_t *obj, size_t bytes) _PDFIO_INTERNAL;
 extern void		_pdfioObjDelete(pdfio_obj_t *obj) _PDFIO_INTERNAL;
+extern pdfio_dict_t	*_pdfioObjGetDict(pdfio_obj_t *obj) _PDFIO_INTERNAL;
 extern void		*_pdfioObjGetExtension(pdfio_obj_t *obj) _PDFIO_INTERNAL;
+extern bool		_pdfioObjIsUpdated(pdfio_obj_t *obj) _PDFIO_INTERNAL;
 extern bool		_pdfioObjLoad(pdfio_obj_t *obj) _PDFIO_INTERNAL;
+extern void		_pdfioObjRelease(pdfio_obj_t *obj) _PDFIO_INTERNAL;
 extern void		_pdfioObjSetExtension(pdfio_obj_t *obj, void *data, _pdfio_extfree_t datafree) _PDFIO_INTERNAL;
 
-extern pdfio_stream_t	*_pdfioStreamCreate(pdfio_obj_t *obj, pdfio_obj_t *length_obj, pdfio_filter_t compression) _PDFIO_INTERNAL;
+extern pdfio_stream_t	*_pdfioStreamCreate(pdfio_obj_t *obj, pdfio_obj_t *length_obj, pdfio_filter_t compression, bool deferred) _PDFIO_INTERNAL;
+extern bool		_pdfioStreamFlushParallel(pdfio_file_t *pdf, bool wait) _PDFIO_INTERNAL;
 extern pdfio_stream_t	*_pdfioStreamOpen(pdfio_obj_t *obj, bool decode) _PDFIO_INTERNAL;
+extern bool		_pdfioStreamSetAccel(bool accel) _PDFIO_INTERNAL;
+extern void		_pdfioStreamStopParallel(pdfio_file_t *pdf) _PDFIO_INTERNAL;
 
+extern size_t		_pdfioStringHash(const char *s) _PDFIO_INTERNAL;
 extern bool		_pdfioStringIsAllocated(pdfio_file_t *pdf, const char *s) _PDFIO_INTERNAL;
 
 extern void		_pdfioTokenClear(_pdfio_token_t *tb) _PDFIO_INTERNAL;
@@ -396,11 +722,13 @@ extern void		_pdfioTokenInit(_pdfio_token_t *tb, pdfio_file_t *pdf, _pdfio_tcons
 extern void		_pdfioTokenPush(_pdfio_token_t *tb, const char *token) _PDFIO_INTERNAL;
 extern bool		_pdfioTokenRead(_pdfio_token_t *tb, char *buffer, size_t bufsize);
 
+extern _pdfio_value_t	*_pdfioValueClone(pdfio_file_t *pdf, _pdfio_value_t *vdst, _pdfio_value_t *vsrc) _PDFIO_INTERNAL;
 extern _pdfio_value_t	*_pdfioValueCopy(pdfio_file_t *pdfdst, _pdfio_value_t *vdst, pdfio_file_t *pdfsrc, _pdfio_value_t *vsrc) _PDFIO_INTERNAL;
 extern bool		_pdfioValueDecrypt(pdfio_file_t *pdf, pdfio_obj_t *obj, _pdfio_value_t *v, size_t depth) _PDFIO_INTERNAL;
 extern void		_pdfioValueDebug(_pdfio_value_t *v, FILE *fp) _PDFIO_INTERNAL;
-extern void		_pdfioValueDelete(_pdfio_value_t *v) _PDFIO_INTERNAL;
+extern bool		_pdfioValueDigest(pdfio_file_t *pdf, _pdfio_value_t *v, _pdfio_sha256_t *ctx) _PDFIO_INTERNAL;
 extern _pdfio_value_t	*_pdfioValueRead(pdfio_file_t *pdf, pdfio_obj_t *obj, _pdfio_token_t *ts, _pdfio_value_t *v, size_t depth) _PDFIO_INTERNAL;
+extern void		_pdfioValueRelease(pdfio_file_t *pdf, _pdfio_value_t *v) _PDFIO_INTERNAL;
 extern bool		_pdfioValueWrite(pdfio_file_t *pdf, pdfio_obj_t *obj, _pdfio_value_t *v, off_t *length) _PDFIO_INTERNAL;
 
 
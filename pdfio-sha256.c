@@ -75,6 +75,11 @@
  */
 
 #include "pdfio-private.h"
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#  include <immintrin.h>
+#  define HAVE_SHANI 1			/* Use SHA-NI instructions when available */
+#  define SHANI_TARGET __attribute__((target("sha,sse4.1")))
+#endif /* __GNUC__ && (__x86_64__ || __i386__) */
 
 /* Constants from sha.h */
 enum {
@@ -114,19 +119,24 @@ enum {
   (SHA256_ROTR(17,word) ^ SHA256_ROTR(19,word) ^ SHA256_SHR(10,word))
 
 /*
- * Add "length" to the length.
+ * Add "length" bits to the length.
  * Set Corrupted when overflow has occurred.
  */
-static uint32_t addTemp;
-#define SHA224_256AddLength(context, length)               \
-  (addTemp = (context)->Length_Low, (context)->Corrupted = \
-    (((context)->Length_Low += (length)) < addTemp) &&     \
-    (++(context)->Length_High == 0) ? shaInputTooLong :    \
+#define SHA224_256AddLength(context, length)                  \
+  ((context)->Corrupted =                                     \
+    (((context)->Length_Low += (length)) < (length)) &&       \
+    (++(context)->Length_High == 0) ? shaInputTooLong :       \
                                       (context)->Corrupted )
 
 /* Local Function Prototypes */
 static int SHA224_256Reset(_pdfio_sha256_t *context, uint32_t *H0);
 static void SHA224_256ProcessMessageBlock(_pdfio_sha256_t *context);
+static void SHA224_256ProcessBlocks(uint32_t *H, const uint8_t *blocks,
+  size_t count);
+#ifdef HAVE_SHANI
+static void SHA224_256ProcessBlocksNI(uint32_t *H, const uint8_t *blocks,
+  size_t count) SHANI_TARGET;
+#endif /* HAVE_SHANI */
 static void SHA224_256Finalize(_pdfio_sha256_t *context,
   uint8_t Pad_Byte);
 static void SHA224_256PadMessage(_pdfio_sha256_t *context,
@@ -134,6 +144,23 @@ static void SHA224_256PadMessage(_pdfio_sha256_t *context,
 static int SHA224_256ResultN(_pdfio_sha256_t *context,
   uint8_t Message_Digest[ ], int HashSize);
 
+/* Constants defined in FIPS 180-3, section 4.2.2 */
+static const uint32_t K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b,
+    0x59f111f1, 0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01,
+    0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7,
+    0xc19bf174, 0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+    0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da, 0x983e5152,
+    0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
+    0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc,
+    0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819,
+    0xd6990624, 0xf40e3585, 0x106aa070, 0x19a4c116, 0x1e376c08,
+    0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f,
+    0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+    0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
 /* Initial Hash Values: FIPS 180-3 section 5.3.3 */
 static uint32_t SHA256_H0[SHA256HashSize/4] = {
   0x6A09E667, 0xBB67AE85, 0x3C6EF372, 0xA54FF53A,
@@ -182,17 +209,45 @@ void
 _pdfioCryptoSHA256Append(_pdfio_sha256_t *context, const uint8_t *message_array,
     size_t length)
 {
-  if (!length) return;
+  size_t count;                       /* Number of bytes to copy */
 
-  while (length--) {
-    context->Message_Block[context->Message_Block_Index++] =
-            *message_array;
-
-    if ((SHA224_256AddLength(context, 8) == shaSuccess) &&
-      (context->Message_Block_Index == SHA256_Message_Block_Size))
-      SHA224_256ProcessMessageBlock(context);
+  if (!length) return;
 
-    message_array++;
+  while (length > 0 && context->Corrupted == shaSuccess) {
+    if (context->Message_Block_Index == 0 &&
+        length >= SHA256_Message_Block_Size) {
+      /*
+       * Hash whole blocks directly from the message, limiting the count so
+       * the length in bits fits in 32 bits.
+       */
+      count = length / SHA256_Message_Block_Size;
+      if (count > 0x100000)
+        count = 0x100000;
+
+      SHA224_256ProcessBlocks(context->Intermediate_Hash, message_array,
+        count);
+
+      count *= SHA256_Message_Block_Size;
+    } else {
+      /*
+       * Copy as much as will fit into the current block...
+       */
+      count = SHA256_Message_Block_Size - context->Message_Block_Index;
+      if (count > length)
+        count = length;
+
+      memcpy(context->Message_Block + context->Message_Block_Index,
+        message_array, count);
+      context->Message_Block_Index += (int)count;
+
+      if (context->Message_Block_Index == SHA256_Message_Block_Size)
+        SHA224_256ProcessMessageBlock(context);
+    }
+
+    SHA224_256AddLength(context, (uint32_t)(count * 8));
+
+    message_array += count;
+    length        -= count;
   }
 }
 
@@ -273,81 +328,181 @@ static int SHA224_256Reset(_pdfio_sha256_t *context, uint32_t *H0)
  *
  * Returns:
  *   Nothing.
+ */
+static void SHA224_256ProcessMessageBlock(_pdfio_sha256_t *context)
+{
+  SHA224_256ProcessBlocks(context->Intermediate_Hash,
+    context->Message_Block, 1);
+
+  context->Message_Block_Index = 0;
+}
+
+/*
+ * SHA224_256ProcessBlocks
+ *
+ * Description:
+ *   This helper function will process "count" 512-bit blocks of the
+ *   message, using the SHA-NI instructions when the CPU supports them.
+ *
+ * Parameters:
+ *   H[ ]: [in/out]
+ *     The intermediate hash value to update.
+ *   blocks[ ]: [in]
+ *     The message blocks.
+ *   count: [in]
+ *     The number of message blocks.
+ *
+ * Returns:
+ *   Nothing.
  *
  * Comments:
  *   Many of the variable names in this code, especially the
  *   single character names, were used because those were the
  *   names used in the Secure Hash Standard.
  */
-static void SHA224_256ProcessMessageBlock(_pdfio_sha256_t *context)
+static void SHA224_256ProcessBlocks(uint32_t *H, const uint8_t *blocks,
+  size_t count)
 {
-  /* Constants defined in FIPS 180-3, section 4.2.2 */
-  static const uint32_t K[64] = {
-      0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b,
-      0x59f111f1, 0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01,
-      0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7,
-      0xc19bf174, 0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
-      0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da, 0x983e5152,
-      0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
-      0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc,
-      0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
-      0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819,
-      0xd6990624, 0xf40e3585, 0x106aa070, 0x19a4c116, 0x1e376c08,
-      0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f,
-      0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
-      0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
-  };
   int        t, t4;                   /* Loop counter */
   uint32_t   temp1, temp2;            /* Temporary word value */
   uint32_t   W[64];                   /* Word sequence */
-  uint32_t   A, B, C, D, E, F, G, H;  /* Word buffers */
+  uint32_t   A, B, C, D, E, F, G, H0; /* Word buffers */
+
+#ifdef HAVE_SHANI
+  if (_pdfio_crypto_accel && __builtin_cpu_supports("sha") && __builtin_cpu_supports("sse4.1")) {
+    SHA224_256ProcessBlocksNI(H, blocks, count);
+    return;
+  }
+#endif /* HAVE_SHANI */
+
+  for (; count > 0; count--, blocks += SHA256_Message_Block_Size) {
+    /*
+     * Initialize the first 16 words in the array W
+     */
+    for (t = t4 = 0; t < 16; t++, t4 += 4)
+      W[t] = (((uint32_t)blocks[t4]) << 24) |
+             (((uint32_t)blocks[t4 + 1]) << 16) |
+             (((uint32_t)blocks[t4 + 2]) << 8) |
+             (((uint32_t)blocks[t4 + 3]));
+
+    for (t = 16; t < 64; t++)
+      W[t] = SHA256_sigma1(W[t-2]) + W[t-7] +
+          SHA256_sigma0(W[t-15]) + W[t-16];
+
+    A  = H[0];
+    B  = H[1];
+    C  = H[2];
+    D  = H[3];
+    E  = H[4];
+    F  = H[5];
+    G  = H[6];
+    H0 = H[7];
+
+    for (t = 0; t < 64; t++) {
+      temp1 = H0 + SHA256_SIGMA1(E) + SHA_Ch(E,F,G) + K[t] + W[t];
+      temp2 = SHA256_SIGMA0(A) + SHA_Maj(A,B,C);
+      H0 = G;
+      G = F;
+      F = E;
+      E = D + temp1;
+      D = C;
+      C = B;
+      B = A;
+      A = temp1 + temp2;
+    }
+
+    H[0] += A;
+    H[1] += B;
+    H[2] += C;
+    H[3] += D;
+    H[4] += E;
+    H[5] += F;
+    H[6] += G;
+    H[7] += H0;
+  }
+}
+
+#ifdef HAVE_SHANI
+/*
+ * SHA224_256ProcessBlocksNI
+ *
+ * Description:
+ *   This helper function will process "count" 512-bit blocks of the
+ *   message using the SHA-NI instructions.
+ *
+ * Parameters:
+ *   H[ ]: [in/out]
+ *     The intermediate hash value to update.
+ *   blocks[ ]: [in]
+ *     The message blocks.
+ *   count: [in]
+ *     The number of message blocks.
+ *
+ * Returns:
+ *   Nothing.
+ */
+static void SHA224_256ProcessBlocksNI(uint32_t *H, const uint8_t *blocks,
+  size_t count)
+{
+  int        t;                       /* Loop counter */
+  __m128i    state0, state1;          /* ABEF and CDGH state */
+  __m128i    save0, save1;            /* State at start of block */
+  __m128i    msg, temp;               /* Message words */
+  __m128i    W[4];                    /* Message schedule */
+  const __m128i mask =                /* Byte swap mask */
+    _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
 
   /*
-   * Initialize the first 16 words in the array W
+   * Rearrange the hash value from ABCD/EFGH to ABEF/CDGH
    */
-  for (t = t4 = 0; t < 16; t++, t4 += 4)
-    W[t] = (((uint32_t)context->Message_Block[t4]) << 24) |
-           (((uint32_t)context->Message_Block[t4 + 1]) << 16) |
-           (((uint32_t)context->Message_Block[t4 + 2]) << 8) |
-           (((uint32_t)context->Message_Block[t4 + 3]));
-
-  for (t = 16; t < 64; t++)
-    W[t] = SHA256_sigma1(W[t-2]) + W[t-7] +
-        SHA256_sigma0(W[t-15]) + W[t-16];
-
-  A = context->Intermediate_Hash[0];
-  B = context->Intermediate_Hash[1];
-  C = context->Intermediate_Hash[2];
-  D = context->Intermediate_Hash[3];
-  E = context->Intermediate_Hash[4];
-  F = context->Intermediate_Hash[5];
-  G = context->Intermediate_Hash[6];
-  H = context->Intermediate_Hash[7];
-
-  for (t = 0; t < 64; t++) {
-    temp1 = H + SHA256_SIGMA1(E) + SHA_Ch(E,F,G) + K[t] + W[t];
-    temp2 = SHA256_SIGMA0(A) + SHA_Maj(A,B,C);
-    H = G;
-    G = F;
-    F = E;
-    E = D + temp1;
-    D = C;
-    C = B;
-    B = A;
-    A = temp1 + temp2;
+  temp   = _mm_loadu_si128((const __m128i *)H);
+  state1 = _mm_loadu_si128((const __m128i *)(H + 4));
+  temp   = _mm_shuffle_epi32(temp, 0xB1);
+  state1 = _mm_shuffle_epi32(state1, 0x1B);
+  state0 = _mm_alignr_epi8(temp, state1, 8);
+  state1 = _mm_blend_epi16(state1, temp, 0xF0);
+
+  for (; count > 0; count--, blocks += SHA256_Message_Block_Size) {
+    save0 = state0;
+    save1 = state1;
+
+    /*
+     * Do 4 rounds at a time, computing the message schedule as we go...
+     */
+    for (t = 0; t < 16; t++) {
+      if (t < 4) {
+        W[t] = _mm_shuffle_epi8(
+          _mm_loadu_si128((const __m128i *)(blocks + 16 * t)), mask);
+      } else {
+        temp     = _mm_alignr_epi8(W[(t - 1) & 3], W[(t - 2) & 3], 4);
+        W[t & 3] = _mm_sha256msg2_epu32(
+          _mm_add_epi32(_mm_sha256msg1_epu32(W[t & 3], W[(t - 3) & 3]),
+          temp), W[(t - 1) & 3]);
+      }
+
+      msg    = _mm_add_epi32(W[t & 3],
+        _mm_loadu_si128((const __m128i *)(K + 4 * t)));
+      state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+      msg    = _mm_shuffle_epi32(msg, 0x0E);
+      state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+    }
+
+    state0 = _mm_add_epi32(state0, save0);
+    state1 = _mm_add_epi32(state1, save1);
   }
 
-  context->Intermediate_Hash[0] += A;
-  context->Intermediate_Hash[1] += B;
-  context->Intermediate_Hash[2] += C;
-  context->Intermediate_Hash[3] += D;
-  context->Intermediate_Hash[4] += E;
-  context->Intermediate_Hash[5] += F;
-  context->Intermediate_Hash[6] += G;
-  context->Intermediate_Hash[7] += H;
+  /*
+   * Rearrange the hash value back to ABCD/EFGH
+   */
+  temp   = _mm_shuffle_epi32(state0, 0x1B);
+  state1 = _mm_shuffle_epi32(state1, 0xB1);
+  state0 = _mm_blend_epi16(temp, state1, 0xF0);
+  state1 = _mm_alignr_epi8(state1, temp, 8);
 
-  context->Message_Block_Index = 0;
+  _mm_storeu_si128((__m128i *)H, state0);
+  _mm_storeu_si128((__m128i *)(H + 4), state1);
 }
+#endif /* HAVE_SHANI */
 
 /*
  * SHA224_256Finalize
@@ -8,18 +8,60 @@
 //
 
 #include "pdfio-private.h"
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#  include <immintrin.h>
+#  define HAVE_SSE2 1			// Use SSE2 instructions when available
+#  define SSE2_TARGET __attribute__((target("sse2")))
+#endif // __GNUC__ && (__x86_64__ || __i386__)
 
 
 //
 // Local functions...
 //
 
+static void		parallel_broadcast(_pdfio_cond_t *cond);
+static bool		parallel_deflate(_pdfio_djob_t *djob, size_t n);
+static void		parallel_free(_pdfio_djob_t *djob);
+static void		parallel_lock(_pdfio_dpool_t *dpool);
+static bool		parallel_queue(pdfio_file_t *pdf, _pdfio_djob_t *djob);
+static void		parallel_unlock(_pdfio_dpool_t *dpool);
+static void		parallel_wait(_pdfio_dpool_t *dpool, _pdfio_cond_t *cond);
+#ifdef _WIN32
+static DWORD WINAPI	parallel_worker(_pdfio_dpool_t *dpool);
+#else
+static void		*parallel_worker(_pdfio_dpool_t *dpool);
+#endif // _WIN32
+static bool		parallel_write(pdfio_file_t *pdf, _pdfio_djob_t *djob);
+static size_t		stream_crypto(pdfio_stream_t *st, uint8_t *outbuffer, const uint8_t *inbuffer, size_t len);
+static ssize_t		stream_get_input(pdfio_stream_t *st);
+static int		stream_inflate(pdfio_stream_t *st);
+static void		stream_inflate_all(pdfio_stream_t *st);
+static bool		stream_output(pdfio_stream_t *st, const void *buffer, size_t bytes);
 static unsigned char	stream_paeth(unsigned char a, unsigned char b, unsigned char c);
+static void		stream_png_decode(unsigned char filter, unsigned char *dst, const unsigned char *src, const unsigned char *prev, size_t len, size_t bpp);
+#ifdef HAVE_SSE2
+static void		stream_png_decode_sse2(unsigned char filter, unsigned char *dst, const unsigned char *src, const unsigned char *prev, size_t len, size_t bpp) SSE2_TARGET;
+#endif // HAVE_SSE2
+static void		stream_png_encode(unsigned char filter, unsigned char *dst, const unsigned char *src, const unsigned char *prev, size_t len, size_t bpp);
+#ifdef HAVE_SSE2
+static void		stream_png_encode_sse2(unsigned char filter, unsigned char *dst, const unsigned char *src, const unsigned char *prev, size_t len, size_t bpp) SSE2_TARGET;
+#endif // HAVE_SSE2
+static size_t		stream_png_swar(unsigned char *dst, const unsigned char *a, const unsigned char *b, size_t len, bool add);
 static ssize_t		stream_read(pdfio_stream_t *st, char *buffer, size_t bytes);
+static ssize_t		stream_read_file(pdfio_stream_t *st, void *buffer, size_t bytes);
 static bool		stream_write(pdfio_stream_t *st, const void *buffer, size_t bytes);
+static int		zstrategy(pdfio_strategy_t strategy);
 static const char	*zstrerror(int error);
 
 
+//
+// Local globals...
+//
+
+static bool		stream_accel = true;
+					// Use SSE2 instructions when available?
+
+
 //
 // 'pdfioStreamClose()' - Close a (data) stream in a PDF file.
 //
@@ -27,18 +69,38 @@ static const char	*zstrerror(int error);
 bool					// O - `true` on success, `false` on failure
 pdfioStreamClose(pdfio_stream_t *st)	// I - Stream
 {
-  bool ret = true;			// Return value
+  bool		ret = true;		// Return value
+  pdfio_file_t	*pdf;			// PDF file
 
 
   // Range check input...
   if (!st)
     return (false);
 
+  pdf = st->pdf;
+
   // Finish reads/writes and free memory...
-  if (st->pdf->mode == _PDFIO_MODE_READ)
+  if (st->mode == _PDFIO_MODE_READ)
   {
     if (st->filter == PDFIO_FILTER_FLATE)
+    {
+      _pdfioFileLock(pdf);
+      pdf->stats.bytes_inflated += (st->ddata ? st->ddatalen : 0) + (size_t)st->flate.total_out;
+      _pdfioFileUnlock(pdf);
+
       inflateEnd(&(st->flate));
+    }
+  }
+  else if (st->djob)
+  {
+    // Queue the stream data for compression, the object is written once the
+    // data has been compressed...
+    st->pdf->current_obj = NULL;
+
+    pdf->stats.bytes_deflated += st->djob->datalen;
+
+    ret      = parallel_queue(st->pdf, st->djob);
+    st->djob = NULL;
   }
   else
   {
@@ -48,12 +110,20 @@ pdfioStreamClose(pdfio_stream_t *st)	// I - Stream
       // Finalize flate compression stream...
       int status;			// Deflate status
 
-      while ((status = deflate(&st->flate, Z_FINISH)) != Z_STREAM_END)
+      for (;;)
       {
-        size_t	bytes = sizeof(st->cbuffer) - st->flate.avail_out,
-					// Bytes to write
+        size_t	bytes,			// Bytes to write
 		outbytes;		// Actual bytes written
 
+        _pdfioFileSpan(st->pdf, PDFIO_SPAN_DEFLATE, true);
+        status = deflate(&st->flate, Z_FINISH);
+        _pdfioFileSpan(st->pdf, PDFIO_SPAN_DEFLATE, false);
+
+        if (status == Z_STREAM_END)
+          break;
+
+        bytes = sizeof(st->cbuffer) - st->flate.avail_out;
+
 	if (status < Z_OK && status != Z_BUF_ERROR)
 	{
 	  _pdfioFileError(st->pdf, "Flate compression failed: %s", zstrerror(status));
@@ -64,7 +134,7 @@ pdfioStreamClose(pdfio_stream_t *st)	// I - Stream
 	if (st->crypto_cb)
 	{
 	  // Encrypt it first...
-	  outbytes = (st->crypto_cb)(&st->crypto_ctx, st->cbuffer, st->cbuffer, bytes & (size_t)~15);
+	  outbytes = stream_crypto(st, st->cbuffer, st->cbuffer, bytes & (size_t)~15);
 	}
 	else
 	{
@@ -72,7 +142,7 @@ pdfioStreamClose(pdfio_stream_t *st)	// I - Stream
 	  outbytes = bytes;
 	}
 
-	if (!_pdfioFileWrite(st->pdf, st->cbuffer, outbytes))
+	if (!stream_output(st, st->cbuffer, outbytes))
 	{
 	  ret = false;
 	  goto done;
@@ -101,17 +171,41 @@ pdfioStreamClose(pdfio_stream_t *st)	// I - Stream
 	if (st->crypto_cb)
 	{
 	  // Encrypt it first...
-	  bytes = (st->crypto_cb)(&st->crypto_ctx, st->cbuffer, st->cbuffer, bytes);
+	  bytes = stream_crypto(st, st->cbuffer, st->cbuffer, bytes);
 	}
 
-	if (!_pdfioFileWrite(st->pdf, st->cbuffer, bytes))
+	if (!stream_output(st, st->cbuffer, bytes))
 	{
 	  ret = false;
 	  goto done;
 	}
       }
 
+      pdf->stats.bytes_deflated += (size_t)st->flate.total_in;
+
       deflateEnd(&st->flate);
+
+      if (st->deferred)
+      {
+        // Write the object with the compressed data now that the file is
+        // available...
+        pdfio_stream_t *cst;		// Compressed data stream
+
+        if ((cst = pdfioObjCreateStream(st->obj, PDFIO_FILTER_NONE)) == NULL)
+        {
+          ret = false;
+        }
+        else
+        {
+          if (st->cdatalen > 0 && !pdfioStreamWrite(cst, st->cdata, st->cdatalen))
+            ret = false;
+
+          if (!pdfioStreamClose(cst))
+            ret = false;
+        }
+
+        goto done;
+      }
     }
     else if (st->crypto_cb && st->bufptr > st->buffer)
     {
@@ -119,7 +213,7 @@ pdfioStreamClose(pdfio_stream_t *st)	// I - Stream
       uint8_t	temp[8192];		// Temporary buffer
       size_t	outbytes;		// Output bytes
 
-      outbytes = (st->crypto_cb)(&st->crypto_ctx, temp, (uint8_t *)st->buffer, (size_t)(st->bufptr - st->buffer));
+      outbytes = stream_crypto(st, temp, (uint8_t *)st->buffer, (size_t)(st->bufptr - st->buffer));
       if (!_pdfioFileWrite(st->pdf, temp, outbytes))
       {
         ret = false;
@@ -166,16 +260,46 @@ pdfioStreamClose(pdfio_stream_t *st)	// I - Stream
         goto done;
       }
     }
+
+    // Free the object and its length object as needed...
+    if (st->obj->release)
+    {
+      _pdfioObjRelease(st->obj);
+
+      if (st->length_obj)
+      {
+        st->length_obj->release = true;
+        _pdfioFileFreeObj(pdf, st->length_obj);
+      }
+
+      _pdfioFileFreeObj(pdf, st->obj);
+    }
   }
 
   done:
 
-  st->pdf->current_obj = NULL;
+  if (st->crypto_bytes)
+  {
+    _pdfioFileLock(pdf);
+    pdf->stats.bytes_crypto += st->crypto_bytes;
+    _pdfioFileUnlock(pdf);
+  }
+
+  if (!st->concurrent && !st->deferred)
+    st->pdf->current_obj = NULL;
 
+  parallel_free(st->djob);
+  free(st->cdata);
+  free(st->ddata);
   free(st->prbuffer);
   free(st->psbuffer);
+  free(st->pcbuffer);
   free(st);
 
+  // Write any streams that have been compressed in parallel...
+  if (ret && pdf->dpool && !pdf->current_obj)
+    ret = _pdfioStreamFlushParallel(pdf, false);
+
   return (ret);
 }
 
@@ -185,12 +309,18 @@ pdfioStreamClose(pdfio_stream_t *st)	// I - Stream
 //
 // Note: pdfioObjCreateStream handles writing the object and its dictionary.
 //
+// A deferred stream keeps its Flate-compressed data in memory and writes the
+// object when the stream is closed, so it can be written at the same time as
+// another stream.  Deferred streams must be closed after any other open
+// stream.
+//
 
 pdfio_stream_t *			// O - Stream or `NULL` on error
 _pdfioStreamCreate(
     pdfio_obj_t    *obj,		// I - Object
     pdfio_obj_t    *length_obj,		// I - Length object, if any
-    pdfio_filter_t compression)		// I - Compression to apply
+    pdfio_filter_t compression,		// I - Compression to apply
+    bool           deferred)		// I - Keep compressed data in memory until closed?
 {
   pdfio_stream_t	*st;		// Stream
 
@@ -204,13 +334,37 @@ _pdfioStreamCreate(
 
   st->pdf        = obj->pdf;
   st->obj        = obj;
+  st->mode       = _PDFIO_MODE_WRITE;
   st->length_obj = length_obj;
   st->filter     = compression;
   st->bufptr     = st->buffer;
   st->bufend     = st->buffer + sizeof(st->buffer);
 
-  if (obj->pdf->encryption)
+  st->level      = obj->pdf->level;
+  st->strategy   = obj->pdf->strategy;
+  st->deferred   = deferred && compression == PDFIO_FILTER_FLATE;
+
+  if (compression == PDFIO_FILTER_FLATE && !st->deferred && ((obj->pdf->options & PDFIO_OPTION_PARALLEL) || obj->pdf->deflate_cb))
+  {
+    // Collect the stream data so it can be compressed in parallel or by the
+    // compression callback - the object is encrypted and written once the
+    // data has been compressed...
+    if ((st->djob = (_pdfio_djob_t *)calloc(1, sizeof(_pdfio_djob_t))) == NULL)
+    {
+      _pdfioFileError(obj->pdf, "Unable to allocate memory for a stream.");
+      free(st);
+      return (NULL);
+    }
+
+    st->djob->obj        = obj;
+    st->djob->level      = st->level;
+    st->djob->strategy   = st->strategy;
+    st->djob->deflate_cb = obj->pdf->deflate_cb;
+    st->djob->codec_data = obj->pdf->codec_data;
+  }
+  else if (obj->pdf->encryption && !st->deferred)
   {
+    // Deferred streams are encrypted when the object is written...
     uint8_t	iv[64];			// Initialization vector
     size_t	ivlen = sizeof(iv);	// Length of initialization vector, if any
 
@@ -228,15 +382,15 @@ _pdfioStreamCreate(
   if (compression == PDFIO_FILTER_FLATE)
   {
     // Flate compression
-    pdfio_dict_t *params = pdfioDictGetDict(obj->value.value.dict, "DecodeParms");
+    pdfio_dict_t *params = pdfioDictGetDict(obj->value.value.dict, _pdfio_keys[_PDFIO_KEY_DECODEPARMS]);
 					// Decoding parameters
-    int bpc = (int)pdfioDictGetNumber(params, "BitsPerComponent");
+    int bpc = (int)pdfioDictGetNumber(params, _pdfio_keys[_PDFIO_KEY_BITSPERCOMPONENT]);
 					// Bits per component
-    int colors = (int)pdfioDictGetNumber(params, "Colors");
+    int colors = (int)pdfioDictGetNumber(params, _pdfio_keys[_PDFIO_KEY_COLORS]);
 					// Number of colors
-    int columns = (int)pdfioDictGetNumber(params, "Columns");
+    int columns = (int)pdfioDictGetNumber(params, _pdfio_keys[_PDFIO_KEY_COLUMNS]);
 					// Number of columns
-    int predictor = (int)pdfioDictGetNumber(params, "Predictor");
+    int predictor = (int)pdfioDictGetNumber(params, _pdfio_keys[_PDFIO_KEY_PREDICTOR]);
 					// Predictory value, if any
     int status;				// ZLIB status code
 
@@ -249,6 +403,7 @@ _pdfioStreamCreate(
     else if (bpc < 1 || bpc == 3 || (bpc > 4 && bpc < 8) || (bpc > 8 && bpc < 16) || bpc > 16)
     {
       _pdfioFileError(st->pdf, "Unsupported BitsPerColor value %d.", bpc);
+      parallel_free(st->djob);
       free(st);
       return (NULL);
     }
@@ -260,6 +415,7 @@ _pdfioStreamCreate(
     else if (colors < 0 || colors > 4)
     {
       _pdfioFileError(st->pdf, "Unsupported Colors value %d.", colors);
+      parallel_free(st->djob);
       free(st);
       return (NULL);
     }
@@ -271,6 +427,7 @@ _pdfioStreamCreate(
     else if (columns < 0)
     {
       _pdfioFileError(st->pdf, "Unsupported Columns value %d.", columns);
+      parallel_free(st->djob);
       free(st);
       return (NULL);
     }
@@ -278,6 +435,7 @@ _pdfioStreamCreate(
     if ((predictor > 1 && predictor < 10) || predictor > 15)
     {
       _pdfioFileError(st->pdf, "Unsupported Predictor function %d.", predictor);
+      parallel_free(st->djob);
       free(st);
       return (NULL);
     }
@@ -290,11 +448,13 @@ _pdfioStreamCreate(
       if (predictor >= 10)
 	st->pbsize ++;		// Add PNG predictor byte
 
-      if ((st->prbuffer = calloc(1, st->pbsize - 1)) == NULL || (st->psbuffer = calloc(1, st->pbsize)) == NULL)
+      if ((st->prbuffer = calloc(1, st->pbsize - 1)) == NULL || (st->psbuffer = calloc(1, st->pbsize)) == NULL || (predictor == _PDFIO_PREDICTOR_PNG_AUTO && (st->pcbuffer = calloc(1, st->pbsize)) == NULL))
       {
 	_pdfioFileError(st->pdf, "Unable to allocate %lu bytes for Predictor buffers.", (unsigned long)st->pbsize);
+	parallel_free(st->djob);
 	free(st->prbuffer);
 	free(st->psbuffer);
+	free(st->pcbuffer);
 	free(st);
 	return (NULL);
       }
@@ -305,7 +465,7 @@ _pdfioStreamCreate(
     st->flate.next_out  = (Bytef *)st->cbuffer;
     st->flate.avail_out = (uInt)sizeof(st->cbuffer);
 
-    if ((status = deflateInit(&(st->flate), 9)) != Z_OK)
+    if (!st->djob && (status = deflateInit2(&(st->flate), st->level, Z_DEFLATED, 15, 8, zstrategy(st->strategy))) != Z_OK)
     {
       _pdfioFileError(st->pdf, "Unable to start Flate filter: %s", zstrerror(status));
       free(st->prbuffer);
@@ -332,7 +492,7 @@ pdfioStreamConsume(pdfio_stream_t *st,	// I - Stream
 
 
   // Range check input...
-  if (!st || st->pdf->mode != _PDFIO_MODE_READ || !bytes)
+  if (!st || st->mode != _PDFIO_MODE_READ || !bytes)
     return (false);
 
   // Skip bytes in the stream buffer until we've consumed the requested number
@@ -359,6 +519,81 @@ pdfioStreamConsume(pdfio_stream_t *st,	// I - Stream
 }
 
 
+//
+// '_pdfioStreamFlushParallel()' - Write streams that have been compressed in parallel.
+//
+// When "wait" is `false`, only streams that have been compressed are written,
+// unless too much uncompressed data is waiting in the queue.  When "wait" is
+// `true`, all queued streams are compressed and written.
+//
+
+bool					// O - `true` on success, `false` on failure
+_pdfioStreamFlushParallel(
+    pdfio_file_t *pdf,			// I - PDF file
+    bool         wait)			// I - Wait for all streams to be compressed?
+{
+  bool		ret = true;		// Return value
+  _pdfio_dpool_t *dpool = pdf->dpool;	// Compression threads
+  _pdfio_djob_t	*djob,			// Current stream
+		*prev;			// Previous stream
+
+
+  // Don't write streams recursively from pdfioStreamClose...
+  if (!dpool || dpool->flushing)
+    return (true);
+
+  dpool->flushing = true;
+
+  parallel_lock(dpool);
+
+  while (dpool->first)
+  {
+    // Find a stream that has been compressed...
+    for (prev = NULL, djob = dpool->first; djob; prev = djob, djob = djob->next)
+    {
+      if (!djob->chunks_left)
+        break;
+    }
+
+    if (!djob)
+    {
+      // Nothing ready, wait as needed...
+      if (!wait && dpool->pending <= _PDFIO_DEFLATE_MAX)
+        break;
+
+      parallel_wait(dpool, &dpool->done_cond);
+      continue;
+    }
+
+    // Remove the stream from the queue and write it...
+    if (prev)
+      prev->next = djob->next;
+    else
+      dpool->first = djob->next;
+
+    if (dpool->last == djob)
+      dpool->last = prev;
+
+    dpool->pending -= djob->datalen;
+
+    parallel_unlock(dpool);
+
+    if (!parallel_write(pdf, djob))
+      ret = false;
+
+    parallel_free(djob);
+
+    parallel_lock(dpool);
+  }
+
+  parallel_unlock(dpool);
+
+  dpool->flushing = false;
+
+  return (ret);
+}
+
+
 //
 // 'pdfioStreamGetToken()' - Read a single PDF token from a stream.
 //
@@ -381,7 +616,7 @@ pdfioStreamGetToken(
 
 
   // Range check input...
-  if (!st || st->pdf->mode != _PDFIO_MODE_READ || !buffer || !bufsize)
+  if (!st || st->mode != _PDFIO_MODE_READ || !buffer || !bufsize)
     return (false);
 
   // Read using the token engine...
@@ -406,9 +641,9 @@ _pdfioStreamOpen(pdfio_obj_t *obj,	// I - Object
                  bool        decode)	// I - Decode/decompress the stream?
 {
   pdfio_stream_t	*st;		// Stream
-  pdfio_dict_t		*dict = pdfioObjGetDict(obj);
-					// Object dictionary
+  pdfio_dict_t		*dict;		// Object dictionary
   const char		*type;		// Object type
+  bool			reading;	// Switched to reading for an update?
 
 
   PDFIO_DEBUG("_pdfioStreamOpen(obj=%p(%u), decode=%s)\n", obj, (unsigned)obj->number, decode ? "true" : "false");
@@ -420,8 +655,9 @@ _pdfioStreamOpen(pdfio_obj_t *obj,	// I - Object
     return (NULL);
   }
 
-  st->pdf = obj->pdf;
-  st->obj = obj;
+  st->pdf  = obj->pdf;
+  st->obj  = obj;
+  st->mode = _PDFIO_MODE_READ;
 
   if ((st->remaining = pdfioObjGetLength(obj)) == 0)
   {
@@ -429,8 +665,18 @@ _pdfioStreamOpen(pdfio_obj_t *obj,	// I - Object
     return (NULL);
   }
 
+  // Request all of the stream data at once when reading with an input
+  // callback...
+  _pdfioFilePrefetch(st->pdf, obj->stream_offset, st->remaining);
+
+  // When updating a file, switch to reading the start of the stream...
+  reading = _pdfioFileBeginRead(st->pdf);
+
   if (_pdfioFileSeek(st->pdf, obj->stream_offset, SEEK_SET) != obj->stream_offset)
   {
+    if (reading)
+      _pdfioFileEndRead(st->pdf);
+
     free(st);
     return (NULL);
   }
@@ -447,6 +693,9 @@ _pdfioStreamOpen(pdfio_obj_t *obj,	// I - Object
     if ((st->crypto_cb = _pdfioCryptoMakeReader(st->pdf, obj, &st->crypto_ctx, iv, &ivlen)) == NULL)
     {
       // TODO: Add error message?
+      if (reading)
+        _pdfioFileEndRead(st->pdf);
+
       free(st);
       return (NULL);
     }
@@ -459,12 +708,26 @@ _pdfioStreamOpen(pdfio_obj_t *obj,	// I - Object
       st->remaining = (st->remaining + 15) & (size_t)~15;
   }
 
+  if (st->pdf->concurrent || st->pdf->update)
+  {
+    // Read the rest of the stream data from its own file position...
+    st->concurrent = true;
+    st->filepos    = _pdfioFileTell(st->pdf);
+  }
+
+  if (reading)
+    _pdfioFileEndRead(st->pdf);
+
+  // Get the object dictionary now since loading the length or type might
+  // have reloaded it...
+  dict = _pdfioObjGetDict(obj);
+
   if (decode)
   {
     // Try to decode/decompress the contents of this object...
-    const char	*filter = pdfioDictGetName(dict, "Filter");
+    const char	*filter = pdfioDictGetName(dict, _pdfio_keys[_PDFIO_KEY_FILTER]);
 					// Filter value
-    pdfio_array_t *fa = pdfioDictGetArray(dict, "Filter");
+    pdfio_array_t *fa = pdfioDictGetArray(dict, _pdfio_keys[_PDFIO_KEY_FILTER]);
 					// Filter array
 
     if (!filter && fa && pdfioArrayGetSize(fa) == 1)
@@ -490,18 +753,17 @@ _pdfioStreamOpen(pdfio_obj_t *obj,	// I - Object
     else if (!strcmp(filter, "FlateDecode"))
     {
       // Flate compression
-      pdfio_dict_t *params = pdfioDictGetDict(dict, "DecodeParms");
+      pdfio_dict_t *params = pdfioDictGetDict(dict, _pdfio_keys[_PDFIO_KEY_DECODEPARMS]);
 					// Decoding parameters
-      int bpc = (int)pdfioDictGetNumber(params, "BitsPerComponent");
+      int bpc = (int)pdfioDictGetNumber(params, _pdfio_keys[_PDFIO_KEY_BITSPERCOMPONENT]);
 					// Bits per component
-      int colors = (int)pdfioDictGetNumber(params, "Colors");
+      int colors = (int)pdfioDictGetNumber(params, _pdfio_keys[_PDFIO_KEY_COLORS]);
 					// Number of colors
-      int columns = (int)pdfioDictGetNumber(params, "Columns");
+      int columns = (int)pdfioDictGetNumber(params, _pdfio_keys[_PDFIO_KEY_COLUMNS]);
 					// Number of columns
-      int predictor = (int)pdfioDictGetNumber(params, "Predictor");
+      int predictor = (int)pdfioDictGetNumber(params, _pdfio_keys[_PDFIO_KEY_PREDICTOR]);
 					// Predictory value, if any
       int status;			// ZLIB status
-      ssize_t rbytes;			// Bytes read
 
       PDFIO_DEBUG("_pdfioStreamOpen: FlateDecode - BitsPerComponent=%d, Colors=%d, Columns=%d, Predictor=%d\n", bpc, colors, columns, predictor);
 
@@ -568,12 +830,7 @@ _pdfioStreamOpen(pdfio_obj_t *obj,	// I - Object
         st->predictor = _PDFIO_PREDICTOR_NONE;
 
       PDFIO_DEBUG("_pdfioStreamOpen: pos=%ld\n", (long)_pdfioFileTell(st->pdf));
-      if (sizeof(st->cbuffer) > st->remaining)
-	rbytes = _pdfioFileRead(st->pdf, st->cbuffer, st->remaining);
-      else
-	rbytes = _pdfioFileRead(st->pdf, st->cbuffer, sizeof(st->cbuffer));
-
-      if (rbytes <= 0)
+      if (stream_get_input(st) <= 0)
       {
 	_pdfioFileError(st->pdf, "Unable to read bytes for stream.");
 	free(st->prbuffer);
@@ -582,13 +839,7 @@ _pdfioStreamOpen(pdfio_obj_t *obj,	// I - Object
 	return (NULL);
       }
 
-      if (st->crypto_cb)
-        rbytes = (ssize_t)(st->crypto_cb)(&st->crypto_ctx, st->cbuffer, st->cbuffer, (size_t)rbytes);
-
-      st->flate.next_in  = (Bytef *)st->cbuffer;
-      st->flate.avail_in = (uInt)rbytes;
-
-      PDFIO_DEBUG("_pdfioStreamOpen: avail_in=%u, cbuffer=<%02X%02X%02X%02X%02X%02X%02X%02X...>\n", st->flate.avail_in, st->cbuffer[0], st->cbuffer[1], st->cbuffer[2], st->cbuffer[3], st->cbuffer[4], st->cbuffer[5], st->cbuffer[6], st->cbuffer[7]);
+      PDFIO_DEBUG("_pdfioStreamOpen: avail_in=%u, next_in=<%02X%02X%02X%02X%02X%02X%02X%02X...>\n", st->flate.avail_in, st->flate.next_in[0], st->flate.next_in[1], st->flate.next_in[2], st->flate.next_in[3], st->flate.next_in[4], st->flate.next_in[5], st->flate.next_in[6], st->flate.next_in[7]);
 
       if ((status = inflateInit(&(st->flate))) != Z_OK)
       {
@@ -599,7 +850,8 @@ _pdfioStreamOpen(pdfio_obj_t *obj,	// I - Object
 	return (NULL);
       }
 
-      st->remaining -= st->flate.avail_in;
+      // Decompress smaller streams all at once on the first read...
+      st->inflate_all = (st->flate.avail_in + st->remaining) <= _PDFIO_INFLATE_MAX;
     }
     else if (!strcmp(filter, "LZWDecode"))
     {
@@ -637,7 +889,7 @@ pdfioStreamPeek(pdfio_stream_t *st,	// I - Stream
 
 
   // Range check input...
-  if (!st || st->pdf->mode != _PDFIO_MODE_READ || !buffer || !bytes)
+  if (!st || st->mode != _PDFIO_MODE_READ || !buffer || !bytes)
     return (-1);
 
   // See if we have enough bytes in the buffer...
@@ -685,7 +937,7 @@ pdfioStreamPrintf(
 
 
   // Range check input...
-  if (!st || st->pdf->mode != _PDFIO_MODE_WRITE || !format)
+  if (!st || st->mode != _PDFIO_MODE_WRITE || !format)
     return (false);
 
   // Format the string...
@@ -709,7 +961,7 @@ pdfioStreamPutChar(pdfio_stream_t *st,	// I - Stream
   char	buffer[1];			// Write buffer
 
 
-  if (!st || st->pdf->mode != _PDFIO_MODE_WRITE)
+  if (!st || st->mode != _PDFIO_MODE_WRITE)
     return (false);
 
   buffer[0] = (char)ch;
@@ -726,7 +978,7 @@ bool					// O - `true` on success, `false` on failure
 pdfioStreamPuts(pdfio_stream_t *st,	// I - Stream
                 const char     *s)	// I - Literal string
 {
-  if (!st || st->pdf->mode != _PDFIO_MODE_WRITE || !s)
+  if (!st || st->mode != _PDFIO_MODE_WRITE || !s)
     return (false);
   else
     return (pdfioStreamWrite(st, s, strlen(s)));
@@ -755,7 +1007,7 @@ pdfioStreamRead(
 
 
   // Range check input...
-  if (!st || st->pdf->mode != _PDFIO_MODE_READ || !buffer || !bytes)
+  if (!st || st->mode != _PDFIO_MODE_READ || !buffer || !bytes)
     return (-1);
 
   // Loop until we have the requested bytes or hit the end of the stream...
@@ -801,6 +1053,133 @@ pdfioStreamRead(
 }
 
 
+//
+// '_pdfioStreamSetAccel()' - Enable or disable the SSE2 PNG predictor code.
+//
+// This is used by the unit tests to run the portable PNG predictor code on
+// CPUs that support SSE2.  The previous setting is returned.
+//
+
+bool					// O - Previous setting
+_pdfioStreamSetAccel(bool accel)	// I - `true` to use SSE2 when available, `false` to use the portable code
+{
+  bool	prev = stream_accel;	// Previous setting
+
+
+  stream_accel = accel;
+
+  return (prev);
+}
+
+
+//
+// 'pdfioStreamSetCompression()' - Set the Flate compression level and strategy for a stream.
+//
+// This function overrides the compression level and strategy set with
+// @link pdfioFileSetCompression@ for a single Flate stream.  The "level"
+// argument ranges from `0` (no compression, fastest) to `9` (best compression,
+// slowest).
+//
+// > *Note*: This function must be called before writing any data to the
+// > stream.
+//
+
+bool					// O - `true` on success, `false` on failure
+pdfioStreamSetCompression(
+    pdfio_stream_t   *st,		// I - Stream
+    int              level,		// I - Compression level (`0` to `9`)
+    pdfio_strategy_t strategy)		// I - Compression strategy
+{
+  int	status;				// Compression status
+
+
+  // Range check input...
+  if (!st || st->mode != _PDFIO_MODE_WRITE || st->filter != PDFIO_FILTER_FLATE)
+    return (false);
+
+  if (level < 0 || level > 9 || strategy < PDFIO_STRATEGY_DEFAULT || strategy > PDFIO_STRATEGY_RLE)
+  {
+    _pdfioFileError(st->pdf, "Bad compression level or strategy.");
+    return (false);
+  }
+
+  if (st->flate.total_in > 0 || (st->djob && st->djob->datalen > 0))
+  {
+    _pdfioFileError(st->pdf, "Compression must be set before writing stream data.");
+    return (false);
+  }
+
+  st->level    = level;
+  st->strategy = strategy;
+
+  if (st->djob)
+  {
+    st->djob->level    = level;
+    st->djob->strategy = strategy;
+  }
+  else if ((status = deflateParams(&(st->flate), level, zstrategy(strategy))) != Z_OK)
+  {
+    _pdfioFileError(st->pdf, "Unable to set Flate compression: %s", zstrerror(status));
+    return (false);
+  }
+
+  return (true);
+}
+
+
+//
+// '_pdfioStreamStopParallel()' - Stop the parallel compression threads.
+//
+
+void
+_pdfioStreamStopParallel(
+    pdfio_file_t *pdf)			// I - PDF file
+{
+  _pdfio_dpool_t *dpool = pdf->dpool;	// Compression threads
+  _pdfio_djob_t	*djob,			// Current stream
+		*next;			// Next stream
+  size_t	i;			// Looping var
+
+
+  if (!dpool)
+    return;
+
+  // Tell the threads to stop and wait for them...
+  parallel_lock(dpool);
+  dpool->stopping = true;
+  parallel_broadcast(&dpool->work_cond);
+  parallel_unlock(dpool);
+
+  for (i = 0; i < dpool->num_threads; i ++)
+  {
+#ifdef _WIN32
+    WaitForSingleObject(dpool->threads[i], INFINITE);
+    CloseHandle(dpool->threads[i]);
+#else
+    pthread_join(dpool->threads[i], NULL);
+#endif // _WIN32
+  }
+
+#ifdef _WIN32
+  DeleteCriticalSection(&dpool->mutex);
+#else
+  pthread_mutex_destroy(&dpool->mutex);
+  pthread_cond_destroy(&dpool->work_cond);
+  pthread_cond_destroy(&dpool->done_cond);
+#endif // _WIN32
+
+  // Free any streams that were not written...
+  for (djob = dpool->first; djob; djob = next)
+  {
+    next = djob->next;
+    parallel_free(djob);
+  }
+
+  free(dpool);
+  pdf->dpool = NULL;
+}
+
+
 //
 // 'pdfioStreamWrite()' - Write data to a stream.
 //
@@ -814,16 +1193,14 @@ pdfioStreamWrite(
   size_t		pbpixel,	// Size of pixel in bytes
       			pbline,		// Bytes per line
 			remaining;	// Remaining bytes on this line
-  const unsigned char	*bufptr,	// Pointer into buffer
-			*bufsecond;	// Pointer to second pixel in buffer
-  unsigned char		*sptr,		// Pointer into sbuffer
-			*pptr;		// Previous raw buffer
+  const unsigned char	*bufptr;	// Pointer into buffer
+  unsigned char		*sptr;		// Pointer into sbuffer
 
 
   PDFIO_DEBUG("pdfioStreamWrite(st=%p, buffer=%p, bytes=%lu)\n", st, buffer, (unsigned long)bytes);
 
   // Range check input...
-  if (!st || st->pdf->mode != _PDFIO_MODE_WRITE || !buffer || !bytes)
+  if (!st || st->mode != _PDFIO_MODE_WRITE || !buffer || !bytes)
     return (false);
 
   // Write it...
@@ -852,7 +1229,7 @@ pdfioStreamWrite(
           if (st->bufptr >= st->bufend)
           {
             // Encrypt and flush
-	    outbytes = (st->crypto_cb)(&st->crypto_ctx, temp, (uint8_t *)st->buffer, sizeof(st->buffer));
+	    outbytes = stream_crypto(st, temp, (uint8_t *)st->buffer, sizeof(st->buffer));
 	    if (!_pdfioFileWrite(st->pdf, temp, outbytes))
 	      return (false);
 
@@ -870,7 +1247,7 @@ pdfioStreamWrite(
             cbytes &= (size_t)~15;
           }
 
-	  outbytes = (st->crypto_cb)(&st->crypto_ctx, temp, bufptr, cbytes);
+	  outbytes = stream_crypto(st, temp, bufptr, cbytes);
 	  if (!_pdfioFileWrite(st->pdf, temp, outbytes))
 	    return (false);
         }
@@ -901,82 +1278,54 @@ pdfioStreamWrite(
     return (false);
   }
 
-  pbpixel   = st->pbpixel;
-  bufptr    = (const unsigned char *)buffer;
-  bufsecond = bufptr + pbpixel;
+  pbpixel = st->pbpixel;
+  bufptr  = (const unsigned char *)buffer;
 
   while (bytes > 0)
   {
-    // Store the PNG predictor in the first byte of the buffer...
     if (st->predictor == _PDFIO_PREDICTOR_PNG_AUTO)
-      st->psbuffer[0] = 4;		// Use Paeth predictor for auto...
-    else
-      st->psbuffer[0] = (unsigned char)(st->predictor - 10);
-
-    // Then process the current line using the specified PNG predictor...
-    sptr = st->psbuffer + 1;
-    pptr = st->prbuffer;
-
-    switch (st->predictor)
     {
-      default :
-          // Anti-compiler-warning code (NONE is handled above, TIFF is not supported for writing)
-	  return (false);
-
-      case _PDFIO_PREDICTOR_PNG_NONE :
-          // No PNG predictor...
-          memcpy(sptr, buffer, pbline);
-          break;
-
-      case _PDFIO_PREDICTOR_PNG_SUB :
-	  // Encode the difference from the previous column
-	  for (remaining = pbline; remaining > 0; remaining --, bufptr ++, sptr ++)
-	  {
-	    if (bufptr >= bufsecond)
-	      *sptr = *bufptr - bufptr[-(int)pbpixel];
-	    else
-	      *sptr = *bufptr;
-	  }
-	  break;
+      // Try each PNG filter and use the one with the smallest sum of absolute
+      // differences for this line...
+      size_t		score,		// Score for current filter
+			best_score = 0;	// Best score
+      unsigned char	filter,		// Current filter
+			*temp;		// Temporary buffer pointer
+
+      for (filter = 0; filter < 5; filter ++)
+      {
+        stream_png_encode(filter, st->pcbuffer + 1, bufptr, st->prbuffer, pbline, pbpixel);
 
-      case _PDFIO_PREDICTOR_PNG_UP :
-	  // Encode the difference from the previous line
-	  for (remaining = pbline; remaining > 0; remaining --, bufptr ++, sptr ++, pptr ++)
-	  {
-	    *sptr = *bufptr - *pptr;
-	  }
-	  break;
+        for (score = 0, sptr = st->pcbuffer + 1, remaining = pbline; remaining > 0; remaining --, sptr ++)
+          score += *sptr < 128 ? *sptr : 256 - *sptr;
 
-      case _PDFIO_PREDICTOR_PNG_AVERAGE :
-          // Encode the difference with the average of the previous column and line
-	  for (remaining = pbline; remaining > 0; remaining --, bufptr ++, sptr ++, pptr ++)
-	  {
-	    if (bufptr >= bufsecond)
-	      *sptr = *bufptr - (bufptr[-(int)pbpixel] + *pptr) / 2;
-	    else
-	      *sptr = *bufptr - *pptr / 2;
-	  }
-	  break;
+        if (filter == 0 || score < best_score)
+        {
+          // Keep this line...
+          best_score      = score;
+          temp            = st->psbuffer;
+          st->psbuffer    = st->pcbuffer;
+          st->pcbuffer    = temp;
+          st->psbuffer[0] = filter;
+        }
+      }
+    }
+    else
+    {
+      // Store the PNG predictor in the first byte of the buffer and then
+      // process the current line using the specified PNG predictor...
+      st->psbuffer[0] = (unsigned char)(st->predictor - 10);
 
-      case _PDFIO_PREDICTOR_PNG_PAETH :
-      case _PDFIO_PREDICTOR_PNG_AUTO :
-          // Encode the difference with a linear transform function
-	  for (remaining = pbline; remaining > 0; remaining --, bufptr ++, sptr ++, pptr ++)
-	  {
-	    if (bufptr >= bufsecond)
-	      *sptr = *bufptr - stream_paeth(bufptr[-(int)pbpixel], *pptr, pptr[-(int)pbpixel]);
-	    else
-	      *sptr = *bufptr - stream_paeth(0, *pptr, 0);
-	  }
-	  break;
+      stream_png_encode(st->psbuffer[0], st->psbuffer + 1, bufptr, st->prbuffer, pbline, pbpixel);
     }
 
     // Write the encoded line...
     if (!stream_write(st, st->psbuffer, st->pbsize))
       return (false);
 
-    memcpy(st->prbuffer, buffer, pbline);
-    bytes -= pbline;
+    memcpy(st->prbuffer, bufptr, pbline);
+    bufptr += pbline;
+    bytes  -= pbline;
   }
 
   return (true);
@@ -984,143 +1333,1324 @@ pdfioStreamWrite(
 
 
 //
-// 'stream_paeth()' - PaethPredictor function for PNG decompression filter.
+// 'parallel_broadcast()' - Wake all threads waiting on a condition.
 //
 
-static unsigned char			// O - Predictor value
-stream_paeth(unsigned char a,		// I - Left pixel
-             unsigned char b,		// I - Top pixel
-             unsigned char c)		// I - Top-left pixel
+static void
+parallel_broadcast(_pdfio_cond_t *cond)	// I - Condition
 {
-  int	p = a + b - c;			// Initial estimate
-  int	pa = abs(p - a);		// Distance to a
-  int	pb = abs(p - b);		// Distance to b
-  int	pc = abs(p - c);		// Distance to c
-
-  return ((pa <= pb && pa <= pc) ? a : (pb <= pc) ? b : c);
+#ifdef _WIN32
+  WakeAllConditionVariable(cond);
+#else
+  pthread_cond_broadcast(cond);
+#endif // _WIN32
 }
 
 
 //
-// 'stream_read()' - Read data from a stream, including filters.
+// 'parallel_deflate()' - Compress a chunk of stream data.
+//
+// Each chunk is compressed as raw deflate data, using the end of the previous
+// chunk as the dictionary and ending on a byte boundary so that the chunks can
+// be concatenated into a single zlib stream.  When a compression callback is
+// used, the whole stream is compressed as a single chunk of zlib data.
 //
 
-static ssize_t				// O - Number of bytes read or `-1` on error
-stream_read(pdfio_stream_t *st,		// I - Stream
-            char           *buffer,	// I - Buffer
-            size_t         bytes)	// I - Number of bytes to read
+static bool				// O - `true` on success, `false` on failure
+parallel_deflate(_pdfio_djob_t *djob,	// I - Stream
+                 size_t        n)	// I - Chunk number (0-based)
 {
-  ssize_t	rbytes;			// Bytes read
-  uInt		avail_in, avail_out;	// Previous flate values
-
-
-  if (st->filter == PDFIO_FILTER_NONE)
+  _pdfio_dchunk_t *chunk = djob->chunks + n;
+					// Chunk
+  size_t	offset = n * _PDFIO_DEFLATE_CHUNK,
+					// Offset of chunk in stream data
+		length = djob->datalen - offset,
+					// Length of chunk
+		dictlen,		// Length of dictionary
+		alloc,			// Allocated size of compressed data
+		used;			// Bytes of compressed data
+  unsigned char	*cdata;			// New compressed data buffer
+  z_stream	flate;			// Compression stream
+  int		flush,			// Flush mode
+		status;			// Compression status
+
+
+  if (djob->deflate_cb)
   {
-    // No filtering, but limit reads to the length of the stream...
-    if (bytes > st->remaining)
-      rbytes = _pdfioFileRead(st->pdf, buffer, st->remaining);
-    else
-      rbytes = _pdfioFileRead(st->pdf, buffer, bytes);
+    // Compress the whole stream using the callback...
+    ssize_t	cbytes;			// Bytes of compressed data
 
-    if (rbytes > 0)
+    for (alloc = compressBound((uLong)djob->datalen) + 16;; alloc *= 2)
     {
-      st->remaining -= (size_t)rbytes;
+      free(chunk->cdata);
 
-      if (st->crypto_cb)
-        (st->crypto_cb)(&st->crypto_ctx, (uint8_t *)buffer, (uint8_t *)buffer, (size_t)rbytes);
+      if ((chunk->cdata = (unsigned char *)malloc(alloc)) == NULL)
+        return (false);
+
+      if ((cbytes = (djob->deflate_cb)(djob->codec_data, djob->level, djob->data, djob->datalen, chunk->cdata, alloc)) < 0)
+        return (false);
+      else if (cbytes > 0)
+        break;
     }
 
-    return (rbytes);
+    chunk->cdatalen = (size_t)cbytes;
+
+    return (true);
   }
-  else if (st->filter == PDFIO_FILTER_FLATE)
-  {
-    // Deflate compression...
-    int	status;				// Status of decompression
 
-    if (st->predictor == _PDFIO_PREDICTOR_NONE)
-    {
-      // Decompress into the buffer...
-      PDFIO_DEBUG("stream_read: No predictor.\n");
+  if (length > _PDFIO_DEFLATE_CHUNK)
+    length = _PDFIO_DEFLATE_CHUNK;
 
-      if (st->flate.avail_in == 0)
-      {
-	// Read more from the file...
-	if (sizeof(st->cbuffer) > st->remaining)
-	  rbytes = _pdfioFileRead(st->pdf, st->cbuffer, st->remaining);
-	else
-	  rbytes = _pdfioFileRead(st->pdf, st->cbuffer, sizeof(st->cbuffer));
+  chunk->adler = adler32(adler32(0, NULL, 0), djob->data + offset, (uInt)length);
 
-	if (rbytes <= 0)
-	  return (-1);			// End of file...
+  memset(&flate, 0, sizeof(flate));
+  if (deflateInit2(&flate, djob->level, Z_DEFLATED, -15, 8, zstrategy(djob->strategy)) != Z_OK)
+    return (false);
 
-	if (st->crypto_cb)
-	  rbytes = (ssize_t)(st->crypto_cb)(&st->crypto_ctx, st->cbuffer, st->cbuffer, (size_t)rbytes);
+  if (n > 0)
+  {
+    // Use the end of the previous chunk as the dictionary...
+    dictlen = offset > 32768 ? 32768 : offset;
+    deflateSetDictionary(&flate, djob->data + offset - dictlen, (uInt)dictlen);
+  }
 
-	st->remaining      -= (size_t)rbytes;
-	st->flate.next_in  = (Bytef *)st->cbuffer;
-	st->flate.avail_in = (uInt)rbytes;
-      }
+  alloc = deflateBound(&flate, (uLong)length) + 16;
 
-      st->flate.next_out  = (Bytef *)buffer;
-      st->flate.avail_out = (uInt)bytes;
+  if ((chunk->cdata = (unsigned char *)malloc(alloc)) == NULL)
+  {
+    deflateEnd(&flate);
+    return (false);
+  }
 
-      if ((status = inflate(&(st->flate), Z_NO_FLUSH)) < Z_OK)
-      {
-	_pdfioFileError(st->pdf, "Unable to decompress stream data for object %ld: %s", (long)st->obj->number, zstrerror(status));
-	return (-1);
-      }
+  flate.next_in   = djob->data + offset;
+  flate.avail_in  = (uInt)length;
+  flate.next_out  = chunk->cdata;
+  flate.avail_out = (uInt)alloc;
+  flush           = (n + 1) < djob->num_chunks ? Z_SYNC_FLUSH : Z_FINISH;
 
-      return (st->flate.next_out - (Bytef *)buffer);
-    }
-    else if (st->predictor == _PDFIO_PREDICTOR_TIFF2)
+  while ((status = deflate(&flate, flush)) != Z_STREAM_END)
+  {
+    if ((status < Z_OK && status != Z_BUF_ERROR) || flate.avail_out > 0)
     {
-      size_t		pbpixel = st->pbpixel,
-					// Size of pixel in bytes
-      			remaining = st->pbsize;
-					// Remaining bytes
-      unsigned char	*bufptr = (unsigned char *)buffer,
-					// Pointer into buffer
-			*bufsecond = (unsigned char *)buffer + pbpixel,
-					// Pointer to second pixel in buffer
-			*sptr = st->psbuffer;
-					// Current (raw) line
+      // Done with an intermediate chunk or an error...
+      if (status >= Z_OK && flush == Z_SYNC_FLUSH)
+        status = Z_OK;
+      break;
+    }
 
-      PDFIO_DEBUG("stream_read: TIFF predictor 2.\n");
+    // Grow the compressed data buffer...
+    used  = alloc;
+    alloc *= 2;
 
-      if (bytes < st->pbsize)
-      {
-        _pdfioFileError(st->pdf, "Read buffer too small for stream.");
-        return (-1);
-      }
+    if ((cdata = (unsigned char *)realloc(chunk->cdata, alloc)) == NULL)
+    {
+      status = Z_MEM_ERROR;
+      break;
+    }
+
+    chunk->cdata    = cdata;
+    flate.next_out  = cdata + used;
+    flate.avail_out = (uInt)(alloc - used);
+  }
+
+  chunk->cdatalen = (size_t)(flate.next_out - chunk->cdata);
+
+  deflateEnd(&flate);
+
+  return (status == Z_STREAM_END || (status == Z_OK && flush == Z_SYNC_FLUSH));
+}
+
+
+//
+// 'parallel_free()' - Free the data for a stream.
+//
+
+static void
+parallel_free(_pdfio_djob_t *djob)	// I - Stream
+{
+  size_t	i;			// Looping var
+
+
+  if (!djob)
+    return;
+
+  if (djob->chunks)
+  {
+    for (i = 0; i < djob->num_chunks; i ++)
+      free(djob->chunks[i].cdata);
+
+    free(djob->chunks);
+  }
+
+  free(djob->data);
+  free(djob);
+}
+
+
+//
+// 'parallel_lock()' - Lock the compression queue.
+//
+
+static void
+parallel_lock(_pdfio_dpool_t *dpool)	// I - Compression threads
+{
+#ifdef _WIN32
+  EnterCriticalSection(&dpool->mutex);
+#else
+  pthread_mutex_lock(&dpool->mutex);
+#endif // _WIN32
+}
+
+
+//
+// 'parallel_queue()' - Queue a stream for compression.
+//
+// The compression threads are started as needed.  If they cannot be started,
+// or the `PDFIO_OPTION_PARALLEL` option is not set, the stream is compressed
+// and written immediately.
+//
+
+static bool				// O - `true` on success, `false` on failure
+parallel_queue(pdfio_file_t  *pdf,	// I - PDF file
+               _pdfio_djob_t *djob)	// I - Stream
+{
+  _pdfio_dpool_t *dpool;		// Compression threads
+  size_t	i,			// Looping var
+		num_threads;		// Number of threads to start
+  bool		ret;			// Return value
+
+
+  // Split the stream data into chunks - compression callbacks always get the
+  // whole stream...
+  if (djob->deflate_cb || !djob->datalen)
+    djob->num_chunks = 1;
+  else
+    djob->num_chunks = (djob->datalen + _PDFIO_DEFLATE_CHUNK - 1) / _PDFIO_DEFLATE_CHUNK;
+
+  djob->chunks_left = djob->num_chunks;
+
+  if ((djob->chunks = (_pdfio_dchunk_t *)calloc(djob->num_chunks, sizeof(_pdfio_dchunk_t))) == NULL)
+  {
+    _pdfioFileError(pdf, "Unable to allocate memory for a stream.");
+    parallel_free(djob);
+    return (false);
+  }
+
+  if (!(pdf->options & PDFIO_OPTION_PARALLEL))
+    dpool = NULL;
+  else if ((dpool = pdf->dpool) == NULL && (dpool = (_pdfio_dpool_t *)calloc(1, sizeof(_pdfio_dpool_t))) != NULL)
+  {
+    // Start the compression threads, one per CPU...
+#ifdef _WIN32
+    SYSTEM_INFO	sysinfo;		// System information
+
+    GetSystemInfo(&sysinfo);
+    num_threads = (size_t)sysinfo.dwNumberOfProcessors;
+#else
+    long	ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+					// Number of CPUs
+
+    num_threads = ncpus > 0 ? (size_t)ncpus : 1;
+#endif // _WIN32
+
+    if (num_threads < 1)
+      num_threads = 1;
+    else if (num_threads > _PDFIO_DEFLATE_THREADS)
+      num_threads = _PDFIO_DEFLATE_THREADS;
+
+#ifdef _WIN32
+    InitializeCriticalSection(&dpool->mutex);
+    InitializeConditionVariable(&dpool->work_cond);
+    InitializeConditionVariable(&dpool->done_cond);
+#else
+    pthread_mutex_init(&dpool->mutex, NULL);
+    pthread_cond_init(&dpool->work_cond, NULL);
+    pthread_cond_init(&dpool->done_cond, NULL);
+#endif // _WIN32
+
+    pdf->dpool = dpool;
+
+    for (i = 0; i < num_threads; i ++)
+    {
+#ifdef _WIN32
+      if ((dpool->threads[i] = CreateThread(NULL, 0, (LPTHREAD_START_ROUTINE)parallel_worker, dpool, 0, NULL)) == NULL)
+        break;
+#else
+      if (pthread_create(dpool->threads + i, NULL, (void *(*)(void *))parallel_worker, dpool))
+        break;
+#endif // _WIN32
+
+      dpool->num_threads ++;
+    }
+
+    if (!dpool->num_threads)
+    {
+      // Unable to start any threads, stop compressing in parallel...
+      _pdfioStreamStopParallel(pdf);
+      pdf->options &= (pdfio_option_t)~PDFIO_OPTION_PARALLEL;
+      dpool = NULL;
+    }
+  }
+
+  if (!dpool)
+  {
+    // Compress and write the stream now...
+    _pdfioFileSpan(pdf, PDFIO_SPAN_DEFLATE, true);
+
+    for (i = 0; i < djob->num_chunks; i ++)
+    {
+      if (!parallel_deflate(djob, i))
+      {
+        djob->failed = true;
+        break;
+      }
+    }
+
+    _pdfioFileSpan(pdf, PDFIO_SPAN_DEFLATE, false);
+
+    ret = parallel_write(pdf, djob);
+    parallel_free(djob);
+
+    return (ret);
+  }
+
+  // Add the stream to the queue...
+  parallel_lock(dpool);
+
+  if (dpool->last)
+    dpool->last->next = djob;
+  else
+    dpool->first = djob;
+
+  dpool->last = djob;
+
+  if (!dpool->next)
+    dpool->next = djob;
+
+  dpool->pending += djob->datalen;
+
+  parallel_broadcast(&dpool->work_cond);
+  parallel_unlock(dpool);
+
+  return (true);
+}
+
+
+//
+// 'parallel_unlock()' - Unlock the compression queue.
+//
+
+static void
+parallel_unlock(_pdfio_dpool_t *dpool)	// I - Compression threads
+{
+#ifdef _WIN32
+  LeaveCriticalSection(&dpool->mutex);
+#else
+  pthread_mutex_unlock(&dpool->mutex);
+#endif // _WIN32
+}
+
+
+//
+// 'parallel_wait()' - Wait for a condition.
+//
+// The compression queue must be locked.
+//
+
+static void
+parallel_wait(_pdfio_dpool_t *dpool,	// I - Compression threads
+              _pdfio_cond_t  *cond)	// I - Condition
+{
+#ifdef _WIN32
+  SleepConditionVariableCS(cond, &dpool->mutex, INFINITE);
+#else
+  pthread_cond_wait(cond, &dpool->mutex);
+#endif // _WIN32
+}
+
+
+//
+// 'parallel_worker()' - Compress chunks of stream data.
+//
+
+#ifdef _WIN32
+static DWORD WINAPI			// O - Exit status
+#else
+static void *				// O - Exit status
+#endif // _WIN32
+parallel_worker(_pdfio_dpool_t *dpool)	// I - Compression threads
+{
+  _pdfio_djob_t	*djob;			// Current stream
+  size_t	n;			// Chunk number
+  bool		ok;			// Was the chunk compressed?
+
+
+  parallel_lock(dpool);
+
+  while (!dpool->stopping)
+  {
+    if ((djob = dpool->next) == NULL)
+    {
+      // Wait for more chunks...
+      parallel_wait(dpool, &dpool->work_cond);
+      continue;
+    }
+
+    // Grab the next chunk and compress it...
+    n = djob->next_chunk ++;
+
+    if (djob->next_chunk >= djob->num_chunks)
+      dpool->next = djob->next;
+
+    parallel_unlock(dpool);
+
+    _pdfioFileSpan(djob->obj->pdf, PDFIO_SPAN_DEFLATE, true);
+    ok = parallel_deflate(djob, n);
+    _pdfioFileSpan(djob->obj->pdf, PDFIO_SPAN_DEFLATE, false);
+
+    parallel_lock(dpool);
+
+    if (!ok)
+      djob->failed = true;
+
+    if (-- djob->chunks_left == 0)
+      parallel_broadcast(&dpool->done_cond);
+  }
+
+  parallel_unlock(dpool);
+
+#ifdef _WIN32
+  return (0);
+#else
+  return (NULL);
+#endif // _WIN32
+}
+
+
+//
+// 'parallel_write()' - Write a stream that has been compressed.
+//
+// The compressed chunks are written with a zlib header and trailer using an
+// unfiltered stream, which takes care of encryption and the stream length.
+//
+
+static bool				// O - `true` on success, `false` on failure
+parallel_write(pdfio_file_t  *pdf,	// I - PDF file
+               _pdfio_djob_t *djob)	// I - Stream
+{
+  pdfio_stream_t *st;			// Output stream
+  size_t	i,			// Looping var
+		length;			// Length of uncompressed chunk
+  uLong		adler;			// Adler-32 checksum of stream data
+  bool		ret;			// Return value
+  unsigned	check;			// zlib header check value
+  unsigned char	header[2],		// zlib header
+		trailer[4];		// zlib trailer
+
+
+  if (djob->failed)
+  {
+    _pdfioFileError(pdf, "Flate compression failed for object %u.", (unsigned)djob->obj->number);
+    return (false);
+  }
+
+  if (djob->deflate_cb)
+  {
+    // The compression callback provides the complete zlib data...
+    if ((st = pdfioObjCreateStream(djob->obj, PDFIO_FILTER_NONE)) == NULL)
+      return (false);
+
+    ret = pdfioStreamWrite(st, djob->chunks[0].cdata, djob->chunks[0].cdatalen);
+
+    if (!pdfioStreamClose(st))
+      ret = false;
+
+    return (ret);
+  }
+
+  // Build the zlib header with the compression level, like deflate does...
+  if (djob->strategy >= PDFIO_STRATEGY_HUFFMAN || djob->level < 2)
+    check = 0x7800;
+  else if (djob->level < 6)
+    check = 0x7840;
+  else if (djob->level == 6)
+    check = 0x7880;
+  else
+    check = 0x78C0;
+
+  check     += 31 - check % 31;
+  header[0] = (unsigned char)(check >> 8);
+  header[1] = (unsigned char)check;
+
+  // Combine the checksums for each chunk...
+  for (i = 1, adler = djob->chunks[0].adler; i < djob->num_chunks; i ++)
+  {
+    if ((length = djob->datalen - i * _PDFIO_DEFLATE_CHUNK) > _PDFIO_DEFLATE_CHUNK)
+      length = _PDFIO_DEFLATE_CHUNK;
+
+    adler = adler32_combine(adler, djob->chunks[i].adler, (z_off_t)length);
+  }
+
+  trailer[0] = (unsigned char)(adler >> 24);
+  trailer[1] = (unsigned char)(adler >> 16);
+  trailer[2] = (unsigned char)(adler >> 8);
+  trailer[3] = (unsigned char)adler;
+
+  // Write the stream object...
+  if ((st = pdfioObjCreateStream(djob->obj, PDFIO_FILTER_NONE)) == NULL)
+    return (false);
+
+  ret = pdfioStreamWrite(st, header, sizeof(header));
+
+  for (i = 0; ret && i < djob->num_chunks; i ++)
+    ret = pdfioStreamWrite(st, djob->chunks[i].cdata, djob->chunks[i].cdatalen);
+
+  if (ret)
+    ret = pdfioStreamWrite(st, trailer, sizeof(trailer));
+
+  if (!pdfioStreamClose(st))
+    ret = false;
+
+  return (ret);
+}
+
+
+//
+// 'stream_crypto()' - Encrypt or decrypt stream data.
+//
+
+static size_t				// O - Number of output bytes
+stream_crypto(pdfio_stream_t *st,	// I - Stream
+              uint8_t        *outbuffer,// I - Output buffer
+              const uint8_t  *inbuffer,	// I - Input buffer
+              size_t         len)	// I - Number of input bytes
+{
+  size_t	outbytes;		// Number of output bytes
+
+
+  _pdfioFileSpan(st->pdf, PDFIO_SPAN_CRYPTO, true);
+  outbytes = (st->crypto_cb)(&st->crypto_ctx, outbuffer, inbuffer, len);
+  _pdfioFileSpan(st->pdf, PDFIO_SPAN_CRYPTO, false);
+
+  st->crypto_bytes += len;
+
+  return (outbytes);
+}
+
+
+//
+// 'stream_get_input()' - Get more compressed input for a stream.
+//
+// Memory-mapped files are decompressed in place without copying unless the
+// stream is encrypted.
+//
+
+static ssize_t				// O - Number of bytes available or `-1` on error
+stream_get_input(pdfio_stream_t *st)	// I - Stream
+{
+  ssize_t	rbytes;			// Bytes read
+  size_t	bytes;			// Bytes to read
+  const char	*data;			// Memory-mapped data
+
+
+  if (!st->crypto_cb)
+  {
+    // Use memory-mapped data directly, if possible...
+    bytes = st->remaining > UINT_MAX ? UINT_MAX : st->remaining;
+
+    if (st->concurrent)
+      data = _pdfioFileReadMappedAt(st->pdf, st->filepos, &bytes);
+    else
+      data = _pdfioFileReadMapped(st->pdf, &bytes);
+
+    if (data)
+    {
+      if (st->concurrent)
+        st->filepos += (off_t)bytes;
+
+      st->remaining      -= bytes;
+      st->flate.next_in  = (Bytef *)data;
+      st->flate.avail_in = (uInt)bytes;
+
+      return ((ssize_t)bytes);
+    }
+  }
+
+  // Read into the compressed data buffer...
+  if (sizeof(st->cbuffer) > st->remaining)
+    rbytes = stream_read_file(st, st->cbuffer, st->remaining);
+  else
+    rbytes = stream_read_file(st, st->cbuffer, sizeof(st->cbuffer));
+
+  if (rbytes <= 0)
+    return (-1);
+
+  if (st->crypto_cb)
+    rbytes = (ssize_t)stream_crypto(st, st->cbuffer, st->cbuffer, (size_t)rbytes);
+
+  st->remaining      -= (size_t)rbytes;
+  st->flate.next_in  = (Bytef *)st->cbuffer;
+  st->flate.avail_in = (uInt)rbytes;
+
+  return (rbytes);
+}
+
+
+//
+// 'stream_inflate()' - Decompress stream data.
+//
+// This function works like the ZLIB `inflate` function, copying data that was
+// decompressed all at once when available.
+//
+
+static int				// O - ZLIB status
+stream_inflate(pdfio_stream_t *st)	// I - Stream
+{
+  size_t	bytes;			// Bytes to copy
+
+
+  if (!st->ddata)
+  {
+    int	status;				// ZLIB status
+
+    _pdfioFileSpan(st->pdf, PDFIO_SPAN_INFLATE, true);
+    status = inflate(&(st->flate), Z_NO_FLUSH);
+    _pdfioFileSpan(st->pdf, PDFIO_SPAN_INFLATE, false);
+
+    return (status);
+  }
+
+  if ((bytes = st->ddatalen - st->ddatapos) > st->flate.avail_out)
+    bytes = st->flate.avail_out;
+
+  memcpy(st->flate.next_out, st->ddata + st->ddatapos, bytes);
+
+  st->ddatapos        += bytes;
+  st->flate.next_out  += bytes;
+  st->flate.avail_out -= (uInt)bytes;
+
+  return (st->ddatapos < st->ddatalen ? Z_OK : Z_STREAM_END);
+}
+
+
+//
+// 'stream_inflate_all()' - Decompress a whole stream at once.
+//
+// This function reads the remaining compressed data for the stream and tries
+// to decompress it with a single call to the decompression callback or ZLIB.
+// If that fails, the stream is decompressed incrementally from the compressed
+// data in memory as usual.
+//
+
+static void
+stream_inflate_all(pdfio_stream_t *st)	// I - Stream
+{
+  size_t	cdatalen,		// Length of compressed data
+		cdataalloc,		// Allocated size of compressed data
+		alloc;			// Allocated size of decompressed data
+  unsigned char	*cdata,			// Compressed data
+		*ddata;			// Decompressed data
+  ssize_t	dbytes;			// Bytes of decompressed data
+  z_stream	flate;			// Decompression stream
+  int		status;			// Decompression status
+
+
+  st->inflate_all = false;
+
+  if (st->remaining > 0)
+  {
+    // Copy the compressed data into memory...
+    cdatalen   = st->flate.avail_in;
+    cdataalloc = cdatalen + st->remaining + 16;
+
+    if ((st->cdata = (unsigned char *)malloc(cdataalloc)) == NULL)
+      return;
+
+    memcpy(st->cdata, st->flate.next_in, cdatalen);
+
+    while (st->remaining > 0 && stream_get_input(st) > 0)
+    {
+      if ((cdatalen + st->flate.avail_in) > cdataalloc)
+      {
+        cdataalloc = cdatalen + st->flate.avail_in + st->remaining;
+
+        if ((cdata = (unsigned char *)realloc(st->cdata, cdataalloc)) == NULL)
+          break;
+
+        st->cdata = cdata;
+      }
+
+      memcpy(st->cdata + cdatalen, st->flate.next_in, st->flate.avail_in);
+      cdatalen += st->flate.avail_in;
+    }
+
+    st->flate.next_in  = st->cdata;
+    st->flate.avail_in = (uInt)cdatalen;
+  }
+
+  // Decompress the data, growing the buffer as needed...
+  alloc = 4 * (size_t)st->flate.avail_in;
+
+  if (alloc < 65536)
+    alloc = 65536;
+
+  if (st->pdf->inflate_cb)
+  {
+    // Use the decompression callback...
+    for (; alloc <= 4 * _PDFIO_INFLATE_MAX; alloc *= 2)
+    {
+      if ((ddata = (unsigned char *)realloc(st->ddata, alloc)) == NULL)
+        break;
+
+      st->ddata = ddata;
+
+      _pdfioFileSpan(st->pdf, PDFIO_SPAN_INFLATE, true);
+      dbytes = (st->pdf->inflate_cb)(st->pdf->codec_data, st->flate.next_in, st->flate.avail_in, ddata, alloc);
+      _pdfioFileSpan(st->pdf, PDFIO_SPAN_INFLATE, false);
+
+      if (dbytes < 0)
+        break;
+      else if (dbytes > 0)
+      {
+        st->ddatalen = (size_t)dbytes;
+        return;
+      }
+    }
+  }
+  else
+  {
+    // Use ZLIB...
+    memset(&flate, 0, sizeof(flate));
+    flate.next_in  = st->flate.next_in;
+    flate.avail_in = st->flate.avail_in;
+
+    if (inflateInit(&flate) == Z_OK)
+    {
+      size_t	bytes = 0;		// Bytes of decompressed data
+
+      for (; alloc <= 4 * _PDFIO_INFLATE_MAX; alloc *= 2)
+      {
+        if ((ddata = (unsigned char *)realloc(st->ddata, alloc)) == NULL)
+          break;
+
+        st->ddata       = ddata;
+        flate.next_out  = ddata + bytes;
+        flate.avail_out = (uInt)(alloc - bytes);
+
+        _pdfioFileSpan(st->pdf, PDFIO_SPAN_INFLATE, true);
+        status = inflate(&flate, Z_FINISH);
+        _pdfioFileSpan(st->pdf, PDFIO_SPAN_INFLATE, false);
+
+        bytes  = (size_t)(flate.next_out - ddata);
+
+        if (status == Z_STREAM_END)
+        {
+          inflateEnd(&flate);
+          st->ddatalen = bytes;
+          return;
+        }
+        else if (flate.avail_out > 0 || (status != Z_OK && status != Z_BUF_ERROR))
+        {
+          // Bad or truncated data...
+          break;
+        }
+      }
+
+      inflateEnd(&flate);
+    }
+  }
+
+  // Unable to decompress at once, decompress incrementally as usual...
+  free(st->ddata);
+  st->ddata = NULL;
+}
+
+
+//
+// 'stream_output()' - Write compressed stream data to the file or memory.
+//
+
+static bool				// O - `true` on success, `false` on failure
+stream_output(pdfio_stream_t *st,	// I - Stream
+              const void     *buffer,	// I - Data to write
+              size_t         bytes)	// I - Number of bytes to write
+{
+  if (!st->deferred)
+    return (_pdfioFileWrite(st->pdf, buffer, bytes));
+
+  if ((st->cdatalen + bytes) > st->cdataalloc)
+  {
+    size_t		cdataalloc;	// New allocated size
+    unsigned char	*cdata;		// New data buffer
+
+    for (cdataalloc = st->cdataalloc ? st->cdataalloc : 65536; cdataalloc < (st->cdatalen + bytes); cdataalloc *= 2);
+
+    if ((cdata = (unsigned char *)realloc(st->cdata, cdataalloc)) == NULL)
+    {
+      _pdfioFileError(st->pdf, "Unable to allocate memory for stream data.");
+      return (false);
+    }
+
+    st->cdata      = cdata;
+    st->cdataalloc = cdataalloc;
+  }
+
+  memcpy(st->cdata + st->cdatalen, buffer, bytes);
+  st->cdatalen += bytes;
+
+  return (true);
+}
+
+
+//
+// 'stream_paeth()' - PaethPredictor function for PNG decompression filter.
+//
+// This computes the same estimates as the PNG specification using fewer
+// operations, which lets the compiler avoid branches.
+//
+
+static unsigned char			// O - Predictor value
+stream_paeth(unsigned char a,		// I - Left pixel
+             unsigned char b,		// I - Top pixel
+             unsigned char c)		// I - Top-left pixel
+{
+  int	pb = a - c;			// Horizontal gradient
+  int	pa = b - c;			// Vertical gradient
+  int	pc = abs(pa + pb);		// Distance to c
+
+  pa = abs(pa);				// Distance to a
+  pb = abs(pb);				// Distance to b
+
+  return ((pa <= pb && pa <= pc) ? a : (pb <= pc) ? b : c);
+}
+
+
+//
+// 'stream_png_decode()' - Undo a PNG filter for a line.
+//
+// The "filter" argument is the PNG filter type from 0 (None) to 4 (Paeth),
+// and "prev" is the previous decoded line.  The Up filter does not depend on
+// neighboring output bytes, so it is processed 8 bytes at a time.  When the
+// CPU supports SSE2, the Sub, Average, and Paeth filters are decoded a pixel
+// at a time for 3 to 8 bytes per pixel, and the Up filter 16 bytes at a time.
+//
+
+static void
+stream_png_decode(
+    unsigned char       filter,		// I - PNG filter type
+    unsigned char       *dst,		// I - Decoded line
+    const unsigned char *src,		// I - Encoded line
+    const unsigned char *prev,		// I - Previous decoded line
+    size_t              len,		// I - Length of line in bytes
+    size_t              bpp)		// I - Bytes per pixel
+{
+  size_t	i;			// Looping var
+
+
+  if (bpp > len)
+    bpp = len;
+
+#ifdef HAVE_SSE2
+  // Use the SSE2 instructions when the CPU supports them...
+  if ((filter == 2 || (filter >= 1 && filter <= 4 && bpp >= 3 && bpp <= 8)) && stream_accel && __builtin_cpu_supports("sse2"))
+  {
+    stream_png_decode_sse2(filter, dst, src, prev, len, bpp);
+    return;
+  }
+#endif // HAVE_SSE2
+
+  switch (filter)
+  {
+    default : // None
+        memcpy(dst, src, len);
+        break;
+
+    case 1 : // Sub
+        memcpy(dst, src, bpp);
+        for (i = bpp; i < len; i ++)
+          dst[i] = (unsigned char)(src[i] + dst[i - bpp]);
+        break;
+
+    case 2 : // Up
+        i = stream_png_swar(dst, src, prev, len, true);
+        for (; i < len; i ++)
+          dst[i] = (unsigned char)(src[i] + prev[i]);
+        break;
+
+    case 3 : // Average
+        for (i = 0; i < bpp; i ++)
+          dst[i] = (unsigned char)(src[i] + (prev[i] >> 1));
+        for (; i < len; i ++)
+          dst[i] = (unsigned char)(src[i] + ((dst[i - bpp] + prev[i]) >> 1));
+        break;
+
+    case 4 : // Paeth
+        for (i = 0; i < bpp; i ++)
+          dst[i] = (unsigned char)(src[i] + prev[i]);
+        for (; i < len; i ++)
+          dst[i] = (unsigned char)(src[i] + stream_paeth(dst[i - bpp], prev[i], prev[i - bpp]));
+        break;
+  }
+}
+
+
+
+#ifdef HAVE_SSE2
+//
+// 'stream_png_decode_sse2()' - Undo a PNG filter for a line using SSE2.
+//
+// The Sub, Average, and Paeth filters depend on the previous decoded pixel,
+// so each pixel of 3 to 8 bytes is decoded in a single register.  Each pixel
+// is loaded and stored using 8 bytes - any bytes past the end of the pixel are
+// overwritten by the next pixel, so "dst" must not overlap "src" or "prev",
+// and the last pixels are decoded one byte at a time.  The Paeth estimates are
+// computed using 16-bit values so no branches are needed.
+//
+
+static void
+stream_png_decode_sse2(
+    unsigned char       filter,		// I - PNG filter type
+    unsigned char       *dst,		// I - Decoded line
+    const unsigned char *src,		// I - Encoded line
+    const unsigned char *prev,		// I - Previous decoded line
+    size_t              len,		// I - Length of line in bytes
+    size_t              bpp)		// I - Bytes per pixel (any for Up, 3 to 8 for the others)
+{
+  size_t	i;			// Looping var
+  __m128i	zero = _mm_setzero_si128(),
+					// Zero bytes
+		one = _mm_set1_epi8(1),	// Low bit of each byte
+		a = zero,		// Left pixel
+		b,			// Top pixel
+		c = zero,		// Top-left pixel
+		pa, pb, pc,		// Paeth distances
+		smallest,		// Smallest distance
+		mask,			// Selection mask
+		x;			// Current pixel
+
+
+  switch (filter)
+  {
+    case 1 : // Sub
+        for (i = 0; (i + 8) <= len; i += bpp)
+        {
+          a = _mm_add_epi8(_mm_loadl_epi64((const __m128i *)(src + i)), a);
+          _mm_storel_epi64((__m128i *)(dst + i), a);
+        }
+
+        for (; i < len; i ++)
+          dst[i] = (unsigned char)(src[i] + (i >= bpp ? dst[i - bpp] : 0));
+        break;
+
+    case 2 : // Up
+        for (i = 0; (i + 16) <= len; i += 16)
+          _mm_storeu_si128((__m128i *)(dst + i), _mm_add_epi8(_mm_loadu_si128((const __m128i *)(src + i)), _mm_loadu_si128((const __m128i *)(prev + i))));
+
+        for (; i < len; i ++)
+          dst[i] = (unsigned char)(src[i] + prev[i]);
+        break;
+
+    case 3 : // Average
+        for (i = 0; (i + 8) <= len; i += bpp)
+        {
+          // _mm_avg_epu8 rounds up, so subtract the low bit of a ^ b...
+          b = _mm_loadl_epi64((const __m128i *)(prev + i));
+          x = _mm_sub_epi8(_mm_avg_epu8(a, b), _mm_and_si128(_mm_xor_si128(a, b), one));
+          a = _mm_add_epi8(_mm_loadl_epi64((const __m128i *)(src + i)), x);
+          _mm_storel_epi64((__m128i *)(dst + i), a);
+        }
+
+        for (; i < len; i ++)
+          dst[i] = (unsigned char)(src[i] + (((i >= bpp ? dst[i - bpp] : 0) + prev[i]) >> 1));
+        break;
+
+    case 4 : // Paeth
+        for (i = 0; (i + 8) <= len; i += bpp)
+        {
+          // "a" and "c" hold 16-bit values from the last pixel...
+          b = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(prev + i)), zero);
+
+          pa = _mm_sub_epi16(b, c);
+          pb = _mm_sub_epi16(a, c);
+          pc = _mm_add_epi16(pa, pb);
+          pa = _mm_max_epi16(pa, _mm_sub_epi16(zero, pa));
+          pb = _mm_max_epi16(pb, _mm_sub_epi16(zero, pb));
+          pc = _mm_max_epi16(pc, _mm_sub_epi16(zero, pc));
+
+          smallest = _mm_min_epi16(pc, _mm_min_epi16(pa, pb));
+          mask     = _mm_cmpeq_epi16(smallest, pb);
+          x        = _mm_or_si128(_mm_and_si128(mask, b), _mm_andnot_si128(mask, c));
+          mask     = _mm_cmpeq_epi16(smallest, pa);
+          x        = _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, x));
+
+          x = _mm_add_epi8(_mm_loadl_epi64((const __m128i *)(src + i)), _mm_packus_epi16(x, x));
+          _mm_storel_epi64((__m128i *)(dst + i), x);
+
+          a = _mm_unpacklo_epi8(x, zero);
+          c = b;
+        }
+
+        for (; i < len; i ++)
+        {
+          if (i >= bpp)
+            dst[i] = (unsigned char)(src[i] + stream_paeth(dst[i - bpp], prev[i], prev[i - bpp]));
+          else
+            dst[i] = (unsigned char)(src[i] + prev[i]);
+        }
+        break;
+  }
+}
+#endif // HAVE_SSE2
+
+//
+// 'stream_png_encode()' - Apply a PNG filter to a line.
+//
+// The "filter" argument is the PNG filter type from 0 (None) to 4 (Paeth),
+// and "prev" is the previous unencoded line.  All of the filters only depend
+// on the unencoded data.  The Sub and Up filters are processed 8 bytes at a
+// time, or all four filters 16 bytes at a time when the CPU supports SSE2.
+//
+
+static void
+stream_png_encode(
+    unsigned char       filter,		// I - PNG filter type
+    unsigned char       *dst,		// I - Encoded line
+    const unsigned char *src,		// I - Unencoded line
+    const unsigned char *prev,		// I - Previous unencoded line
+    size_t              len,		// I - Length of line in bytes
+    size_t              bpp)		// I - Bytes per pixel
+{
+  size_t	i;			// Looping var
+
+
+  if (bpp > len)
+    bpp = len;
+
+#ifdef HAVE_SSE2
+  // Use the SSE2 instructions when the CPU supports them...
+  if (filter >= 1 && filter <= 4 && stream_accel && __builtin_cpu_supports("sse2"))
+  {
+    stream_png_encode_sse2(filter, dst, src, prev, len, bpp);
+    return;
+  }
+#endif // HAVE_SSE2
+
+  switch (filter)
+  {
+    default : // None
+        memcpy(dst, src, len);
+        break;
+
+    case 1 : // Sub
+        memcpy(dst, src, bpp);
+        i = bpp + stream_png_swar(dst + bpp, src + bpp, src, len - bpp, false);
+        for (; i < len; i ++)
+          dst[i] = (unsigned char)(src[i] - src[i - bpp]);
+        break;
+
+    case 2 : // Up
+        i = stream_png_swar(dst, src, prev, len, false);
+        for (; i < len; i ++)
+          dst[i] = (unsigned char)(src[i] - prev[i]);
+        break;
+
+    case 3 : // Average
+        for (i = 0; i < bpp; i ++)
+          dst[i] = (unsigned char)(src[i] - (prev[i] >> 1));
+        for (; i < len; i ++)
+          dst[i] = (unsigned char)(src[i] - ((src[i - bpp] + prev[i]) >> 1));
+        break;
+
+    case 4 : // Paeth
+        for (i = 0; i < bpp; i ++)
+          dst[i] = (unsigned char)(src[i] - prev[i]);
+        for (; i < len; i ++)
+          dst[i] = (unsigned char)(src[i] - stream_paeth(src[i - bpp], prev[i], prev[i - bpp]));
+        break;
+  }
+}
+
+
+
+#ifdef HAVE_SSE2
+//
+// 'stream_png_encode_sse2()' - Apply a PNG filter to a line using SSE2.
+//
+// The filters only depend on the unencoded data, so each filter is applied
+// 16 bytes at a time after the first pixel.  The Paeth estimates are computed
+// using 16-bit values so no branches are needed.
+//
+
+static void
+stream_png_encode_sse2(
+    unsigned char       filter,		// I - PNG filter type
+    unsigned char       *dst,		// I - Encoded line
+    const unsigned char *src,		// I - Unencoded line
+    const unsigned char *prev,		// I - Previous unencoded line
+    size_t              len,		// I - Length of line in bytes
+    size_t              bpp)		// I - Bytes per pixel
+{
+  size_t	i,			// Looping var
+		j;			// Looping var for 16-bit halves
+  __m128i	zero = _mm_setzero_si128(),
+					// Zero bytes
+		one = _mm_set1_epi8(1),	// Low bit of each byte
+		a, b, c,		// Left, top, and top-left bytes
+		a16, b16, c16,		// 16-bit left, top, and top-left values
+		pa, pb, pc,		// Paeth distances
+		smallest,		// Smallest distance
+		mask,			// Selection mask
+		x[2];			// 16-bit Paeth estimates
+
+
+  // The first pixel has no left neighbor...
+  switch (filter)
+  {
+    case 1 : // Sub
+        memcpy(dst, src, bpp);
+        break;
+
+    case 2 : // Up
+        for (i = 0; i < bpp; i ++)
+          dst[i] = (unsigned char)(src[i] - prev[i]);
+        break;
+
+    case 3 : // Average
+        for (i = 0; i < bpp; i ++)
+          dst[i] = (unsigned char)(src[i] - (prev[i] >> 1));
+        break;
+
+    case 4 : // Paeth
+        for (i = 0; i < bpp; i ++)
+          dst[i] = (unsigned char)(src[i] - prev[i]);
+        break;
+  }
+
+  for (i = bpp; (i + 16) <= len; i += 16)
+  {
+    a = _mm_loadu_si128((const __m128i *)(src + i - bpp));
+
+    switch (filter)
+    {
+      case 1 : // Sub
+          x[0] = a;
+          break;
+
+      case 2 : // Up
+          x[0] = _mm_loadu_si128((const __m128i *)(prev + i));
+          break;
+
+      case 3 : // Average
+          // _mm_avg_epu8 rounds up, so subtract the low bit of a ^ b...
+          b    = _mm_loadu_si128((const __m128i *)(prev + i));
+          x[0] = _mm_sub_epi8(_mm_avg_epu8(a, b), _mm_and_si128(_mm_xor_si128(a, b), one));
+          break;
+
+      case 4 : // Paeth
+          b = _mm_loadu_si128((const __m128i *)(prev + i));
+          c = _mm_loadu_si128((const __m128i *)(prev + i - bpp));
+
+          for (j = 0; j < 2; j ++)
+          {
+            a16 = j ? _mm_unpackhi_epi8(a, zero) : _mm_unpacklo_epi8(a, zero);
+            b16 = j ? _mm_unpackhi_epi8(b, zero) : _mm_unpacklo_epi8(b, zero);
+            c16 = j ? _mm_unpackhi_epi8(c, zero) : _mm_unpacklo_epi8(c, zero);
+
+            pa = _mm_sub_epi16(b16, c16);
+            pb = _mm_sub_epi16(a16, c16);
+            pc = _mm_add_epi16(pa, pb);
+            pa = _mm_max_epi16(pa, _mm_sub_epi16(zero, pa));
+            pb = _mm_max_epi16(pb, _mm_sub_epi16(zero, pb));
+            pc = _mm_max_epi16(pc, _mm_sub_epi16(zero, pc));
+
+            smallest = _mm_min_epi16(pc, _mm_min_epi16(pa, pb));
+            mask     = _mm_cmpeq_epi16(smallest, pb);
+            x[j]     = _mm_or_si128(_mm_and_si128(mask, b16), _mm_andnot_si128(mask, c16));
+            mask     = _mm_cmpeq_epi16(smallest, pa);
+            x[j]     = _mm_or_si128(_mm_and_si128(mask, a16), _mm_andnot_si128(mask, x[j]));
+          }
+
+          x[0] = _mm_packus_epi16(x[0], x[1]);
+          break;
+
+      default :
+          return;
+    }
+
+    _mm_storeu_si128((__m128i *)(dst + i), _mm_sub_epi8(_mm_loadu_si128((const __m128i *)(src + i)), x[0]));
+  }
+
+  // Finish any remaining bytes...
+  for (; i < len; i ++)
+  {
+    switch (filter)
+    {
+      case 1 : // Sub
+          dst[i] = (unsigned char)(src[i] - src[i - bpp]);
+          break;
+
+      case 2 : // Up
+          dst[i] = (unsigned char)(src[i] - prev[i]);
+          break;
+
+      case 3 : // Average
+          dst[i] = (unsigned char)(src[i] - ((src[i - bpp] + prev[i]) >> 1));
+          break;
+
+      case 4 : // Paeth
+          dst[i] = (unsigned char)(src[i] - stream_paeth(src[i - bpp], prev[i], prev[i - bpp]));
+          break;
+    }
+  }
+}
+#endif // HAVE_SSE2
+
+//
+// 'stream_png_swar()' - Add or subtract bytes 8 at a time.
+//
+// This function adds or subtracts the bytes in "b" from the bytes in "a"
+// (modulo 256) using 64-bit integer math, without carries between bytes.  The
+// number of bytes processed, a multiple of 8, is returned and the caller
+// handles any remaining bytes.
+//
+
+static size_t				// O - Number of bytes processed
+stream_png_swar(unsigned char       *dst,// I - Destination
+                const unsigned char *a,	// I - First source
+                const unsigned char *b,	// I - Second source
+                size_t              len,// I - Number of bytes
+                bool                add)// I - `true` to add, `false` to subtract
+{
+  size_t	i;			// Looping var
+  uint64_t	va,			// Bytes from "a"
+		vb,			// Bytes from "b"
+		vd;			// Result bytes
+  const uint64_t high = 0x8080808080808080ULL;
+					// High bit of each byte
+
+
+  for (i = 0; (i + 8) <= len; i += 8)
+  {
+    memcpy(&va, a + i, sizeof(va));
+    memcpy(&vb, b + i, sizeof(vb));
+
+    if (add)
+      vd = ((va & ~high) + (vb & ~high)) ^ ((va ^ vb) & high);
+    else
+      vd = ((va | high) - (vb & ~high)) ^ ((va ^ ~vb) & high);
+
+    memcpy(dst + i, &vd, sizeof(vd));
+  }
+
+  return (i);
+}
+
+
+//
+// 'stream_read()' - Read data from a stream, including filters.
+//
+
+static ssize_t				// O - Number of bytes read or `-1` on error
+stream_read(pdfio_stream_t *st,		// I - Stream
+            char           *buffer,	// I - Buffer
+            size_t         bytes)	// I - Number of bytes to read
+{
+  ssize_t	rbytes;			// Bytes read
+  uInt		avail_in, avail_out;	// Previous flate values
+
+
+  if (st->filter == PDFIO_FILTER_NONE)
+  {
+    // No filtering, but limit reads to the length of the stream...
+    if (bytes > st->remaining)
+      rbytes = stream_read_file(st, buffer, st->remaining);
+    else
+      rbytes = stream_read_file(st, buffer, bytes);
+
+    if (rbytes > 0)
+    {
+      st->remaining -= (size_t)rbytes;
+
+      if (st->crypto_cb)
+        stream_crypto(st, (uint8_t *)buffer, (uint8_t *)buffer, (size_t)rbytes);
+    }
+
+    return (rbytes);
+  }
+  else if (st->filter == PDFIO_FILTER_FLATE)
+  {
+    // Deflate compression...
+    int	status;				// Status of decompression
+
+    if (st->inflate_all)
+      stream_inflate_all(st);
+
+    if (st->predictor == _PDFIO_PREDICTOR_NONE)
+    {
+      // Decompress into the buffer...
+      PDFIO_DEBUG("stream_read: No predictor.\n");
+
+      if (st->ddata)
+      {
+        // Copy decompressed data...
+        if (st->ddatapos >= st->ddatalen)
+          return (-1);			// End of file...
+
+        st->flate.next_out  = (Bytef *)buffer;
+        st->flate.avail_out = (uInt)bytes;
+
+        stream_inflate(st);
+
+        return (st->flate.next_out - (Bytef *)buffer);
+      }
+
+      if (st->flate.avail_in == 0)
+      {
+	// Read more from the file...
+	if (stream_get_input(st) <= 0)
+	  return (-1);			// End of file...
+      }
+
+      st->flate.next_out  = (Bytef *)buffer;
+      st->flate.avail_out = (uInt)bytes;
+
+      if ((status = stream_inflate(st)) < Z_OK)
+      {
+	_pdfioFileError(st->pdf, "Unable to decompress stream data for object %ld: %s", (long)st->obj->number, zstrerror(status));
+	return (-1);
+      }
+
+      return (st->flate.next_out - (Bytef *)buffer);
+    }
+    else if (st->predictor == _PDFIO_PREDICTOR_TIFF2)
+    {
+      unsigned char	*sptr = st->psbuffer;
+					// Current (raw) line
+
+      PDFIO_DEBUG("stream_read: TIFF predictor 2.\n");
+
+      if (bytes < st->pbsize)
+      {
+        _pdfioFileError(st->pdf, "Read buffer too small for stream.");
+        return (-1);
+      }
 
       st->flate.next_out  = (Bytef *)sptr;
       st->flate.avail_out = (uInt)st->pbsize;
 
       while (st->flate.avail_out > 0)
       {
-	if (st->flate.avail_in == 0)
+	if (!st->ddata && st->flate.avail_in == 0)
 	{
 	  // Read more from the file...
-	  if (sizeof(st->cbuffer) > st->remaining)
-	    rbytes = _pdfioFileRead(st->pdf, st->cbuffer, st->remaining);
-	  else
-	    rbytes = _pdfioFileRead(st->pdf, st->cbuffer, sizeof(st->cbuffer));
-
-	  if (rbytes <= 0)
+	  if (stream_get_input(st) <= 0)
 	    return (-1);		// End of file...
-
-	  if (st->crypto_cb)
-	    rbytes = (ssize_t)(st->crypto_cb)(&st->crypto_ctx, st->cbuffer, st->cbuffer, (size_t)rbytes);
-
-	  st->remaining      -= (size_t)rbytes;
-	  st->flate.next_in  = (Bytef *)st->cbuffer;
-	  st->flate.avail_in = (uInt)rbytes;
 	}
 
         avail_in  = st->flate.avail_in;
         avail_out = st->flate.avail_out;
 
-	if ((status = inflate(&(st->flate), Z_NO_FLUSH)) < Z_OK)
+	if ((status = stream_inflate(st)) < Z_OK)
 	{
 	  _pdfioFileError(st->pdf, "Unable to decompress stream data for object %ld: %s", (long)st->obj->number, zstrerror(status));
 	  return (-1);
@@ -1132,28 +2662,17 @@ stream_read(pdfio_stream_t *st,		// I - Stream
       if (st->flate.avail_out > 0)
         return (-1);			// Early end of stream
 
-      for (; bufptr < bufsecond; remaining --, sptr ++)
-	*bufptr++ = *sptr;
-      for (; remaining > 0; remaining --, sptr ++, bufptr ++)
-	*bufptr = *sptr + bufptr[-(int)pbpixel];
+      stream_png_decode(1, (unsigned char *)buffer, st->psbuffer, NULL, st->pbsize, st->pbpixel);
 
       return ((ssize_t)st->pbsize);
     }
     else
     {
       // PNG predictor
-      size_t		pbpixel = st->pbpixel,
-					// Size of pixel in bytes
-      			remaining = st->pbsize - 1;
+      size_t		remaining = st->pbsize - 1;
 					// Remaining bytes
-      unsigned char	*bufptr = (unsigned char *)buffer,
-					// Pointer into buffer
-			*bufsecond = (unsigned char *)buffer + pbpixel,
-					// Pointer to second pixel in buffer
-			*sptr = st->psbuffer + 1,
+      unsigned char	*sptr = st->psbuffer + 1;
 					// Current (raw) line
-			*pptr = st->prbuffer;
-					// Previous (raw) line
 
       PDFIO_DEBUG("stream_read: PNG predictor.\n");
 
@@ -1168,29 +2687,17 @@ stream_read(pdfio_stream_t *st,		// I - Stream
 
       while (st->flate.avail_out > 0)
       {
-	if (st->flate.avail_in == 0)
+	if (!st->ddata && st->flate.avail_in == 0)
 	{
 	  // Read more from the file...
-	  if (sizeof(st->cbuffer) > st->remaining)
-	    rbytes = _pdfioFileRead(st->pdf, st->cbuffer, st->remaining);
-	  else
-	    rbytes = _pdfioFileRead(st->pdf, st->cbuffer, sizeof(st->cbuffer));
-
-	  if (rbytes <= 0)
+	  if (stream_get_input(st) <= 0)
 	    return (-1);		// End of file...
-
-	  if (st->crypto_cb)
-	    rbytes = (ssize_t)(st->crypto_cb)(&st->crypto_ctx, st->cbuffer, st->cbuffer, (size_t)rbytes);
-
-	  st->remaining      -= (size_t)rbytes;
-	  st->flate.next_in  = (Bytef *)st->cbuffer;
-	  st->flate.avail_in = (uInt)rbytes;
 	}
 
         avail_in  = st->flate.avail_in;
         avail_out = st->flate.avail_out;
 
-	if ((status = inflate(&(st->flate), Z_NO_FLUSH)) < Z_OK)
+	if ((status = stream_inflate(st)) < Z_OK)
 	{
 	  _pdfioFileError(st->pdf, "Unable to decompress stream data for object %ld: %s", (long)st->obj->number, zstrerror(status));
 	  return (-1);
@@ -1209,44 +2716,15 @@ stream_read(pdfio_stream_t *st,		// I - Stream
       // Apply predictor for this line
       PDFIO_DEBUG("stream_read: Line %02X %02X %02X %02X %02X.\n", sptr[-1], sptr[0], sptr[0], sptr[2], sptr[3]);
 
-      switch (sptr[-1])
+      if ((sptr[-1] % 10) > 4 || sptr[-1] > 14)
       {
-        case 0 : // None
-        case 10 : // None (for buggy PDF writers)
-            memcpy(buffer, sptr, remaining);
-            break;
-        case 1 : // Sub
-        case 11 : // Sub (for buggy PDF writers)
-            for (; bufptr < bufsecond; remaining --, sptr ++)
-              *bufptr++ = *sptr;
-            for (; remaining > 0; remaining --, sptr ++, bufptr ++)
-              *bufptr = *sptr + bufptr[-(int)pbpixel];
-            break;
-        case 2 : // Up
-        case 12 : // Up (for buggy PDF writers)
-            for (; remaining > 0; remaining --, sptr ++, pptr ++)
-              *bufptr++ = *sptr + *pptr;
-            break;
-        case 3 : // Average
-        case 13 : // Average (for buggy PDF writers)
-	    for (; bufptr < bufsecond; remaining --, sptr ++, pptr ++)
-	      *bufptr++ = *sptr + *pptr / 2;
-	    for (; remaining > 0; remaining --, sptr ++, pptr ++, bufptr ++)
-	      *bufptr = *sptr + (bufptr[-(int)pbpixel] + *pptr) / 2;
-            break;
-        case 4 : // Paeth
-        case 14 : // Paeth (for buggy PDF writers)
-            for (; bufptr < bufsecond; remaining --, sptr ++, pptr ++)
-              *bufptr++ = *sptr + stream_paeth(0, *pptr, 0);
-            for (; remaining > 0; remaining --, sptr ++, pptr ++, bufptr ++)
-              *bufptr = *sptr + stream_paeth(bufptr[-(int)pbpixel], *pptr, pptr[-(int)pbpixel]);
-            break;
-
-        default :
-            _pdfioFileError(st->pdf, "Bad PNG filter %d in data stream.", sptr[-1]);
-            return (-1);
+	_pdfioFileError(st->pdf, "Bad PNG filter %d in data stream.", sptr[-1]);
+	return (-1);
       }
 
+      // Values 10 to 14 are used by buggy PDF writers...
+      stream_png_decode(sptr[-1] % 10, (unsigned char *)buffer, sptr, st->prbuffer, remaining, st->pbpixel);
+
       // Copy the computed line and swap buffers...
       memcpy(st->prbuffer, buffer, st->pbsize - 1);
 
@@ -1260,6 +2738,31 @@ stream_read(pdfio_stream_t *st,		// I - Stream
 }
 
 
+//
+// 'stream_read_file()' - Read raw stream data from the PDF file.
+//
+// Streams opened in concurrent mode read from their own file position,
+// otherwise the current position in the PDF file is used.
+//
+
+static ssize_t				// O - Number of bytes read or `-1` on error
+stream_read_file(pdfio_stream_t *st,	// I - Stream
+                 void           *buffer,// I - Buffer
+                 size_t         bytes)	// I - Number of bytes to read
+{
+  ssize_t	rbytes;			// Bytes read
+
+
+  if (!st->concurrent)
+    return (_pdfioFileRead(st->pdf, buffer, bytes));
+
+  if ((rbytes = _pdfioFileReadAt(st->pdf, st->filepos, buffer, bytes)) > 0)
+    st->filepos += rbytes;
+
+  return (rbytes);
+}
+
+
 //
 // 'stream_write()' - Write flate-compressed data...
 //
@@ -1272,6 +2775,34 @@ stream_write(pdfio_stream_t *st,	// I - Stream
   int	status;				// Compression status
 
 
+  if (st->djob)
+  {
+    // Save the data for parallel compression...
+    _pdfio_djob_t *djob = st->djob;	// Parallel compression data
+
+    if ((djob->datalen + bytes) > djob->dataalloc)
+    {
+      size_t		dataalloc;	// New allocated size
+      unsigned char	*data;		// New data buffer
+
+      for (dataalloc = djob->dataalloc ? djob->dataalloc : 65536; dataalloc < (djob->datalen + bytes); dataalloc *= 2);
+
+      if ((data = (unsigned char *)realloc(djob->data, dataalloc)) == NULL)
+      {
+        _pdfioFileError(st->pdf, "Unable to allocate memory for stream data.");
+	return (false);
+      }
+
+      djob->data      = data;
+      djob->dataalloc = dataalloc;
+    }
+
+    memcpy(djob->data + djob->datalen, buffer, bytes);
+    djob->datalen += bytes;
+
+    return (true);
+  }
+
   // Flate-compress the buffer...
   st->flate.avail_in = (uInt)bytes;
   st->flate.next_in  = (Bytef *)buffer;
@@ -1287,7 +2818,7 @@ stream_write(pdfio_stream_t *st,	// I - Stream
       if (st->crypto_cb)
       {
         // Encrypt it first...
-        outbytes = (st->crypto_cb)(&st->crypto_ctx, st->cbuffer, st->cbuffer, cbytes & (size_t)~15);
+        outbytes = stream_crypto(st, st->cbuffer, st->cbuffer, cbytes & (size_t)~15);
       }
       else
       {
@@ -1296,7 +2827,7 @@ stream_write(pdfio_stream_t *st,	// I - Stream
 
 //      fprintf(stderr, "stream_write: bytes=%u, outbytes=%u\n", (unsigned)bytes, (unsigned)outbytes);
 
-      if (!_pdfioFileWrite(st->pdf, st->cbuffer, outbytes))
+      if (!stream_output(st, st->cbuffer, outbytes))
         return (false);
 
       if (cbytes > outbytes)
@@ -1314,7 +2845,9 @@ stream_write(pdfio_stream_t *st,	// I - Stream
     }
 
     // Deflate what we can this time...
+    _pdfioFileSpan(st->pdf, PDFIO_SPAN_DEFLATE, true);
     status = deflate(&st->flate, Z_NO_FLUSH);
+    _pdfioFileSpan(st->pdf, PDFIO_SPAN_DEFLATE, false);
 
     if (status < Z_OK && status != Z_BUF_ERROR)
     {
@@ -1327,6 +2860,30 @@ stream_write(pdfio_stream_t *st,	// I - Stream
 }
 
 
+//
+// 'zstrategy()' - Return the ZLIB compression strategy for a PDFio strategy.
+//
+
+static int				// O - ZLIB strategy
+zstrategy(pdfio_strategy_t strategy)	// I - PDFio strategy
+{
+  switch (strategy)
+  {
+    case PDFIO_STRATEGY_FILTERED :
+        return (Z_FILTERED);
+
+    case PDFIO_STRATEGY_HUFFMAN :
+        return (Z_HUFFMAN_ONLY);
+
+    case PDFIO_STRATEGY_RLE :
+        return (Z_RLE);
+
+    default :
+        return (Z_DEFAULT_STRATEGY);
+  }
+}
+
+
 //
 // 'zstrerror()' - Return a string for a zlib error number.
 //
@@ -8,76 +8,368 @@
 //
 
 #include "pdfio-private.h"
+#include <math.h>
 
 
 //
 // Local functions...
 //
 
-static size_t	find_string(pdfio_file_t *pdf, const char *s, int *rdiff);
+static char	*add_string(pdfio_file_t *pdf, const char *s);
+static char	**find_string(pdfio_file_t *pdf, const char *s);
+static uint64_t	round_number(double anumber, int places);
+static double	scale_digits(const char *s, int exponent);
+static int	shortest_digits(double anumber, int digits, int min_digits, int exponent, uint64_t *mantissa);
 
 
 //
-// '_pdfio_strtod()' - Convert a string to a double value.
+// Globals...
+//
+
+const char * const _pdfio_keys[_PDFIO_KEY_MAX] =
+{					// Well-known dictionary keys
+  "BitsPerComponent",
+  "Colors",
+  "Columns",
+  "Contents",
+  "Count",
+  "DecodeParms",
+  "Filter",
+  "First",
+  "Kids",
+  "Length",
+  "MediaBox",
+  "N",
+  "Parent",
+  "Predictor",
+  "Resources",
+  "Subtype",
+  "Type"
+};
+
+static const double powers_of_10[23] =	// Exactly representable powers of 10
+{
+  1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+
+//
+// '_pdfio_dtostr()' - Convert a double value to a string.
 //
-// This function wraps strtod() to avoid locale issues.
+// This function formats a real number using the PDF number syntax, which is
+// fixed-point with a "." decimal point and no exponent, without using the
+// locale.  The shortest string of at most "digits" significant digits and
+// "decimals" decimal places that converts back to the same value is used.
+// Values that need more digits are rounded to the nearest value, with halfway
+// values rounded to an even digit like printf.  A "decimals" value of `-1`
+// does not limit the number of decimal places, so 17 significant digits always
+// produce the shortest string that reads back as the same value.  Trailing
+// zeros are removed and NaN and infinite values are written as "0".
 //
 
-double					// O - Double value
-_pdfio_strtod(pdfio_file_t *pdf,	// I - PDF file
-              const char   *s)		// I - String
+size_t					// O - Length of string
+_pdfio_dtostr(char   *buffer,		// I - Output buffer
+              size_t bufsize,		// I - Size of output buffer
+              double number,		// I - Number
+              int    digits,		// I - Maximum significant digits (`1` to `17`)
+              int    decimals)		// I - Maximum decimal places (`0` to `17`) or `-1` for no limit
 {
-  char	temp[64],			// Temporary buffer
-	*tempptr;			// Pointer into temporary buffer
+  char		temp[400],		// Temporary buffer
+		*tempptr,		// Pointer into temporary buffer
+		dtemp[24],		// Reversed digits
+		*dptr;			// Pointer into digits
+  double	anumber;		// Absolute value of number
+  uint64_t	mantissa;		// Decimal mantissa
+  int		exponent,		// Decimal exponent of number
+		places,			// Number of decimal places
+		maxplaces;		// Maximum number of decimal places
+  size_t	len;			// Length of string
+
+
+  // Get the absolute value and decimal exponent of the number...
+  tempptr = temp;
 
+  if (!isfinite(number))
+    number = 0.0;			// NaN or infinity
 
-  // See if the locale has a special decimal point string...
-  if (!pdf->loc)
-    return (strtod(s, NULL));
+  if (number < 0.0)
+  {
+    anumber    = -number;
+    *tempptr++ = '-';
+  }
+  else
+  {
+    anumber = number;
+  }
+
+  if (digits < 1)
+    digits = 1;
+  else if (digits > 17)
+    digits = 17;
+
+  if (anumber >= 1e17)
+  {
+    if (decimals < 0)
+    {
+      // Use the shortest digits followed by zeros...
+      places = shortest_digits(anumber, digits, 1, 17, &mantissa);
+      goto format_mantissa;
+    }
 
-  // Copy leading sign, numbers, period, and then numbers...
-  tempptr                = temp;
-  temp[sizeof(temp) - 1] = '\0';
+    // Large numbers have no fractional part, let snprintf format all of the
+    // digits since "%.0f" does not use the locale decimal point...
+    snprintf(temp, sizeof(temp), "%.0f", number);
+    len = strlen(temp);
+    goto copy_string;
+  }
+  else if (anumber >= 1.0)
+  {
+    for (exponent = 0; exponent < 16 && anumber >= powers_of_10[exponent + 1]; exponent ++);
+  }
+  else if (anumber > 0.0)
+  {
+    for (exponent = -1; exponent > -22 && anumber * powers_of_10[-exponent] < 1.0; exponent --);
+  }
+  else
+  {
+    // Zero, including negative zero...
+    memcpy(temp, "0", 2);
+    len = 1;
+    goto copy_string;
+  }
 
-  while (*s && *s != '.')
+  // Find the smallest number of decimal places that reproduces the number.
+  // When the decimal mantissa and scale are exactly representable (2^53 and
+  // 10^22), the division is correctly rounded and strtod() or _pdfio_strtod()
+  // will read back the same value...
+  maxplaces = digits - 1 - exponent;
+  if (decimals >= 0 && maxplaces > decimals)
+    maxplaces = decimals;
+  if (maxplaces > 22)
+    maxplaces = 22;
+
+  for (places = maxplaces < 0 ? maxplaces : 0;; places ++)
   {
-    if (tempptr < (temp + sizeof(temp) - 1))
-      *tempptr++ = *s++;
+    if (places >= 0)
+      mantissa = (uint64_t)(anumber * powers_of_10[places] + 0.5);
     else
-      return (0.0);
+      mantissa = (uint64_t)(anumber / powers_of_10[-places] + 0.5);
+
+    if (places >= 0 && mantissa <= 9007199254740992ULL && (double)mantissa / powers_of_10[places] == anumber)
+      break;
+
+    if (places >= maxplaces)
+    {
+      if (decimals < 0)
+        places = shortest_digits(anumber, digits, (maxplaces < 22 && exponent < 15) ? 16 : 1, exponent, &mantissa);
+      else
+        mantissa = round_number(anumber, places);
+      break;
+    }
   }
 
-  if (*s == '.')
+  format_mantissa:
+
+  // Strip trailing zeros...
+  while (places > 0 && mantissa > 0 && (mantissa % 10) == 0)
   {
-    // Convert decimal point to locale equivalent...
-    size_t	declen = strlen(pdf->loc->decimal_point);
-					// Length of decimal point
-    s ++;
+    mantissa /= 10;
+    places --;
+  }
+
+  if (mantissa == 0)
+  {
+    // Rounded to zero...
+    memcpy(temp, "0", 2);
+    len = 1;
+    goto copy_string;
+  }
+
+  // Convert the mantissa to digits (in reverse order)...
+  for (dptr = dtemp; mantissa > 0; mantissa /= 10)
+    *dptr++ = (char)('0' + mantissa % 10);
+
+  if (places < 0)
+  {
+    // Integer rounded to tens, hundreds, etc.
+    while (dptr > dtemp)
+      *tempptr++ = *--dptr;
+
+    for (; places < 0; places ++)
+      *tempptr++ = '0';
+  }
+  else if ((dptr - dtemp) <= places)
+  {
+    // Number less than 1: "0.00ddd"
+    *tempptr++ = '0';
+    *tempptr++ = '.';
+
+    for (places -= (int)(dptr - dtemp); places > 0; places --)
+      *tempptr++ = '0';
+
+    while (dptr > dtemp)
+      *tempptr++ = *--dptr;
+  }
+  else
+  {
+    // Number greater than 1: "ddd.ddd"
+    while (dptr > dtemp)
+    {
+      if ((dptr - dtemp) == places)
+        *tempptr++ = '.';
+
+      *tempptr++ = *--dptr;
+    }
+  }
+
+  *tempptr = '\0';
+  len      = (size_t)(tempptr - temp);
 
-    if (declen <= (sizeof(temp) - (size_t)(tempptr - temp)))
+  // Copy the string to the output buffer...
+  copy_string:
+
+  if (bufsize > 0)
+  {
+    if (len < bufsize)
     {
-      memcpy(tempptr, pdf->loc->decimal_point, declen);
-      tempptr += declen;
+      memcpy(buffer, temp, len + 1);
     }
     else
     {
-      return (0.0);
+      memcpy(buffer, temp, bufsize - 1);
+      buffer[bufsize - 1] = '\0';
     }
   }
 
-  // Copy any remaining characters...
-  while (*s)
+  return (len);
+}
+
+
+//
+// '_pdfio_strtod()' - Convert a string to a double value.
+//
+// This function converts a PDF number to a double value without using the
+// locale.  The "end" argument, if not `NULL`, receives a pointer to the first
+// character after the number or "s" if the string does not start with a
+// number.  Exponents are not allowed by the PDF specification but are accepted
+// since some producers write them.
+//
+// The result is correctly rounded.  Numbers of up to 15 significant digits
+// with small exponents, which covers nearly all numbers in PDF files, are
+// converted directly and other numbers are converted by strtod() using only
+// digits and an exponent, so the locale decimal point is not used.
+//
+
+double					// O - Double value
+_pdfio_strtod(const char *s,		// I - String
+              const char **end)		// O - Pointer to end of number or `NULL`
+{
+  const char	*start = s,		// Start of string
+		*mstart;		// Start of mantissa
+  bool		negative = false,	// Negative number?
+		decimal = false,	// Seen decimal point?
+		digits = false,		// Seen digits?
+		inexact = false;	// Were non-zero digits dropped from the mantissa?
+  uint64_t	mantissa = 0;		// Decimal mantissa
+  int		exponent = 0,		// Decimal exponent
+		exp10 = 0;		// Exponent value
+  double	number;			// Number value
+
+
+  // Get the sign...
+  if (*s == '-')
+  {
+    negative = true;
+    s ++;
+  }
+  else if (*s == '+')
   {
-    if (tempptr < (temp + sizeof(temp) - 1))
-      *tempptr++ = *s++;
+    s ++;
+  }
+
+  // Collect up to 19 significant digits of the mantissa...
+  for (mstart = s;; s ++)
+  {
+    if (*s >= '0' && *s <= '9')
+    {
+      digits = true;
+
+      if (mantissa < 1000000000000000000ULL)
+      {
+        mantissa = mantissa * 10 + (uint64_t)(*s - '0');
+
+        if (decimal)
+          exponent --;
+      }
+      else
+      {
+        if (!decimal)
+          exponent ++;
+
+        if (*s != '0')
+          inexact = true;
+      }
+    }
+    else if (*s == '.' && !decimal)
+    {
+      decimal = true;
+    }
     else
-      return (0.0);
+    {
+      break;
+    }
   }
 
-  // Nul-terminate the temporary string and convert the string...
-  *tempptr = '\0';
+  if (!digits)
+  {
+    if (end)
+      *end = start;
 
-  return (strtod(temp, NULL));
+    return (0.0);
+  }
+
+  if ((*s == 'e' || *s == 'E') && ((s[1] >= '0' && s[1] <= '9') || ((s[1] == '-' || s[1] == '+') && s[2] >= '0' && s[2] <= '9')))
+  {
+    // Exponent...
+    bool	negexp = false;		// Negative exponent?
+
+    s ++;
+    if (*s == '-')
+    {
+      negexp = true;
+      s ++;
+    }
+    else if (*s == '+')
+    {
+      s ++;
+    }
+
+    for (; *s >= '0' && *s <= '9'; s ++)
+    {
+      if (exp10 < 1000)
+        exp10 = exp10 * 10 + (*s - '0');
+    }
+
+    if (negexp)
+      exp10 = -exp10;
+
+    exponent += exp10;
+  }
+
+  if (end)
+    *end = s;
+
+  // Scale the mantissa - this is exact when the mantissa and power of 10 can
+  // be represented exactly (2^53 and 10^22), otherwise use the slow path...
+  if (mantissa == 0)
+    number = 0.0;
+  else if (!inexact && mantissa <= 9007199254740992ULL && exponent >= -22 && exponent <= 22)
+    number = exponent < 0 ? (double)mantissa / powers_of_10[-exponent] : (double)mantissa * powers_of_10[exponent];
+  else
+    number = scale_digits(mstart, exp10);
+
+  return (negative ? -number : number);
 }
 
 
@@ -102,13 +394,11 @@ _pdfio_vsnprintf(pdfio_file_t *pdf,	// I - PDF file
 		prec;			// Number of characters of precision
   char		tformat[100],		// Temporary format string for snprintf()
 		*tptr,			// Pointer into temporary format
-		temp[1024],		// Buffer for formatted numbers
-		*tempptr;		// Pointer into buffer
+		temp[1024];		// Buffer for formatted numbers
   char		*s;			// Pointer to string
   ssize_t	bytes;			// Total number of bytes needed
-  const char	*dec = pdf->loc ? pdf->loc->decimal_point : ".";
-					// Decimal point string
-  char		*decptr;		// Pointer to decimal point
+  int		number_digits,		// Significant digits for real numbers
+		number_decimals;	// Decimal places for real numbers
 
 
   // Loop through the format string, formatting as needed...
@@ -160,6 +450,8 @@ _pdfio_vsnprintf(pdfio_file_t *pdf,	// I - PDF file
 	}
       }
 
+      prec = -1;
+
       if (*format == '.')
       {
 	if (tptr < (tformat + sizeof(tformat) - 1))
@@ -230,32 +522,37 @@ _pdfio_vsnprintf(pdfio_file_t *pdf,	// I - PDF file
 	case 'e' :
 	case 'f' :
 	case 'g' :
-	    if ((size_t)(width + 2) > sizeof(temp))
-	      break;
-
-	    snprintf(temp, sizeof(temp), tformat, va_arg(ap, double));
-
-	    if ((decptr = strstr(temp, dec)) != NULL)
+	    // Format real numbers using the PDF syntax - "%g" and "%e" use the
+	    // precision as the number of significant digits (6 by default) and
+	    // "%f" as the number of decimal places (6 by default).  The file
+	    // precision, if set, overrides the default for "%g" and "%e".
+	    if (type == 'f')
 	    {
-	      // Convert locale decimal point to "."
-	      PDFIO_DEBUG("_pdfio_vsnprintf: Before \"%s\"\n", temp);
-	      tempptr = decptr + strlen(dec);
-	      if (tempptr > (decptr + 1))
-	        memmove(decptr + 1, tempptr, strlen(tempptr) + 1);
-	      *decptr = '.';
-
-	      // Strip trailing 0's...
-	      for (tempptr = temp + strlen(temp) - 1; tempptr > temp && *tempptr == '0'; tempptr --)
-		*tempptr = '\0';
-
-	      if (*tempptr == '.')
-		*tempptr = '\0';	// Strip trailing decimal point
-
-	      PDFIO_DEBUG("_pdfio_vsnprintf: After \"%s\"\n", temp);
+	      number_digits   = 17;
+	      number_decimals = prec >= 0 ? prec : 6;
+	    }
+	    else if (prec >= 0)
+	    {
+	      number_digits   = prec;
+	      number_decimals = 17;
+	    }
+	    else if (pdf && pdf->precision == PDFIO_PRECISION_SHORTEST)
+	    {
+	      number_digits   = 17;
+	      number_decimals = -1;
+	    }
+	    else if (pdf && pdf->precision >= 0)
+	    {
+	      number_digits   = 17;
+	      number_decimals = pdf->precision;
+	    }
+	    else
+	    {
+	      number_digits   = 6;
+	      number_decimals = 17;
 	    }
 
-            // Copy to the output buffer
-            bytes += (int)strlen(temp);
+	    bytes += (ssize_t)_pdfio_dtostr(temp, sizeof(temp), va_arg(ap, double), number_digits, number_decimals);
 
             if (bufptr < bufend)
 	    {
@@ -386,8 +683,6 @@ pdfioStringCreate(
     const char   *s)			// I - Nul-terminated string
 {
   char		*news;			// New string
-  size_t	idx;			// Index into strings
-  int		diff;			// Different
 
 
   PDFIO_DEBUG("pdfioStringCreate(pdf=%p, s=\"%s\")\n", pdf, s);
@@ -396,51 +691,11 @@ pdfioStringCreate(
   if (!pdf || !s)
     return (NULL);
 
-  // See if the string has already been added...
-  if (pdf->num_strings > 0)
-  {
-    idx = find_string(pdf, s, &diff);
-    if (diff == 0)
-      return (pdf->strings[idx]);
-  }
-  else
-  {
-    idx  = 0;
-    diff = -1;
-  }
-
-  // Not already added, so add it...
-  if ((news = strdup(s)) == NULL)
-    return (NULL);
-
-  if (pdf->num_strings >= pdf->alloc_strings)
-  {
-    // Expand the string array...
-    char **temp = (char **)realloc(pdf->strings, (pdf->alloc_strings + 128) * sizeof(char *));
-
-    if (!temp)
-    {
-      free(news);
-      return (NULL);
-    }
-
-    pdf->strings       = temp;
-    pdf->alloc_strings += 128;
-  }
-
-  // Insert the string...
-  if (diff > 0)
-    idx ++;
-
-  PDFIO_DEBUG("pdfioStringCreate: Inserting \"%s\" at %u\n", news, (unsigned)idx);
-
-  if (idx < pdf->num_strings)
-    memmove(pdf->strings + idx + 1, pdf->strings + idx, (pdf->num_strings - idx) * sizeof(char *));
-
-  pdf->strings[idx] = news;
-  pdf->num_strings ++;
-
-  PDFIO_DEBUG("pdfioStringCreate: %lu strings\n", (unsigned long)pdf->num_strings);
+  // Add the string while holding the lock, since other threads might be
+  // reading from the same PDF file...
+  _pdfioFileLock(pdf);
+  news = add_string(pdf, s);
+  _pdfioFileUnlock(pdf);
 
   return (news);
 }
@@ -480,6 +735,26 @@ pdfioStringCreatef(
 }
 
 
+//
+// '_pdfioStringHash()' - Compute the FNV-1a hash of a string.
+//
+
+size_t					// O - Hash value
+_pdfioStringHash(const char *s)		// I - String
+{
+  uint32_t	hash = 2166136261U;	// FNV-1a hash of string
+
+
+  while (*s)
+  {
+    hash ^= (uint8_t)*s++;
+    hash *= 16777619U;
+  }
+
+  return ((size_t)hash);
+}
+
+
 //
 // '_pdfioStringIsAllocated()' - Check whether a string has been allocated.
 //
@@ -489,67 +764,393 @@ _pdfioStringIsAllocated(
     pdfio_file_t *pdf,			// I - PDF file
     const char   *s)			// I - String
 {
-  int	diff;				// Difference
+  bool	ret;				// Return value
+
+
+  _pdfioFileLock(pdf);
+  ret = pdf->num_strings > 0 && *find_string(pdf, s) != NULL;
+  _pdfioFileUnlock(pdf);
+
+  return (ret);
+}
+
+
+//
+// 'add_string()' - Add a string to the hash table.
+//
+
+static char *				// O - Durable string pointer or `NULL` on error
+add_string(pdfio_file_t *pdf,		// I - PDF file
+           const char   *s)		// I - Nul-terminated string
+{
+  char		*news,			// New string
+		**entry;		// Hash table entry
+  size_t	i,			// Looping var
+		len;			// Length of string
+  _pdfio_block_t *strbuf;		// String buffer
+
+
+  // Create the hash table with the well-known dictionary keys as needed...
+  if (!pdf->strings)
+  {
+    if ((pdf->strings = (char **)calloc(1024, sizeof(char *))) == NULL)
+      return (NULL);
+
+    pdf->alloc_strings = 1024;
+
+    for (i = 0; i < _PDFIO_KEY_MAX; i ++)
+      *find_string(pdf, _pdfio_keys[i]) = (char *)_pdfio_keys[i];
+
+    pdf->num_strings = _PDFIO_KEY_MAX;
+  }
+
+  // See if the string has already been added...
+  if (*(entry = find_string(pdf, s)) != NULL)
+    return (*entry);
+
+  // Expand the hash table as needed, keeping it no more than half full...
+  if ((pdf->num_strings + 1) * 2 > pdf->alloc_strings)
+  {
+    size_t	num_strings = pdf->alloc_strings,
+					// Old hash table size
+		alloc_strings = 2 * num_strings;
+					// New hash table size
+    char	**strings,		// Old hash table
+		**temp;			// New hash table
+
+    if ((temp = (char **)calloc(alloc_strings, sizeof(char *))) == NULL)
+      return (NULL);
+
+    // Rehash the existing strings...
+    strings            = pdf->strings;
+    pdf->strings       = temp;
+    pdf->alloc_strings = alloc_strings;
+
+    for (i = 0; i < num_strings; i ++)
+    {
+      if (strings[i])
+        *find_string(pdf, strings[i]) = strings[i];
+    }
+
+    free(strings);
+  }
+
+  // Copy the string to a string buffer...
+  len = strlen(s) + 1;
+
+  if ((strbuf = pdf->strbufs) == NULL || (strbuf->size - strbuf->used) < len)
+  {
+    // Allocate a new buffer, using a separate buffer for long strings...
+    size_t	size = len > (_PDFIO_STRBUF_SIZE / 4) ? len : _PDFIO_STRBUF_SIZE;
+					// Size of buffer
+
+    if ((strbuf = (_pdfio_block_t *)malloc(sizeof(_pdfio_block_t) + size)) == NULL)
+      return (NULL);
+
+    strbuf->used = 0;
+    strbuf->size = size;
+
+    if ((pdf->stats.alloc_bytes += sizeof(_pdfio_block_t) + size) > pdf->stats.peak_alloc_bytes)
+      pdf->stats.peak_alloc_bytes = pdf->stats.alloc_bytes;
+
+    if (size > len || !pdf->strbufs)
+    {
+      strbuf->next = pdf->strbufs;
+      pdf->strbufs = strbuf;
+    }
+    else
+    {
+      // Keep the partially-used buffer at the head of the list...
+      strbuf->next       = pdf->strbufs->next;
+      pdf->strbufs->next = strbuf;
+    }
+  }
 
+  news = strbuf->buffer + strbuf->used;
+  strbuf->used += len;
+  memcpy(news, s, len);
 
-  if (pdf->num_strings == 0)
-    return (false);
+  // Insert the string...
+  *find_string(pdf, news) = news;
+  pdf->num_strings ++;
 
-  find_string(pdf, s, &diff);
+  PDFIO_DEBUG("add_string: %lu strings\n", (unsigned long)pdf->num_strings);
 
-  return (diff == 0);
+  return (news);
 }
 
 
 //
-// 'find_string()' - Find an element in the array.
+// 'find_string()' - Find a string in the hash table.
+//
+// The returned entry contains the matching string or `NULL` if the string is
+// not in the table, in which case the entry can be used to insert the string.
 //
 
-static size_t				// O - Index of match
+static char **				// O - Hash table entry
 find_string(pdfio_file_t *pdf,		// I - PDF file
-	    const char   *s,		// I - String to find
-	    int          *rdiff)	// O - Difference of match
+	    const char   *s)		// I - String to find
 {
-  size_t	left,			// Left side of search
-		right,			// Right side of search
-		current;		// Current element
-  int		diff;			// Comparison with current element
+  size_t	mask = pdf->alloc_strings - 1,
+					// Hash table mask
+		current;		// Current entry
+
 
+  // Hash the string and then do a linear probe until we find the string or an
+  // empty entry...
+  for (current = _pdfioStringHash(s) & mask; pdf->strings[current]; current = (current + 1) & mask)
+  {
+    if (!strcmp(s, pdf->strings[current]))
+      break;
+  }
+
+  return (pdf->strings + current);
+}
+
+
+//
+// 'round_number()' - Round a number scaled by a power of 10 to an integer.
+//
+// The exact scaled value is the rounded product plus its error, or the
+// rounded quotient plus its remainder, so halfway values can be rounded to an
+// even integer like printf even when the product itself is rounded.
+//
+
+static uint64_t				// O - Rounded value
+round_number(double anumber,		// I - Absolute value of number
+             int    places)		// I - Number of decimal places (`-22` to `22`)
+{
+  double	product,		// Rounded product or quotient
+		error,			// Product error or quotient remainder
+		scale,			// Power of 10
+		whole,			// Integer part of product
+		frac;			// Fractional part of product
+  uint64_t	mantissa;		// Rounded value
 
-  // Do a binary search for the string...
-  left  = 0;
-  right = pdf->num_strings - 1;
 
-  do
+  if (places < 0)
   {
-    current = (left + right) / 2;
-    diff    = strcmp(s, pdf->strings[current]);
+    // Divide and correct the quotient using the exact remainder...
+    scale   = powers_of_10[-places];
+    product = floor(anumber / scale);
+    error   = fma(-product, scale, anumber);
 
-    if (diff == 0)
-      break;
-    else if (diff < 0)
-      right = current;
+    if (error < 0.0)
+    {
+      product -= 1.0;
+      error   += scale;
+    }
+    else if (error >= scale)
+    {
+      product += 1.0;
+      error   -= scale;
+    }
+
+    mantissa = (uint64_t)product;
+
+    if (2.0 * error > scale || (2.0 * error == scale && (mantissa & 1)))
+      mantissa ++;
+  }
+  else
+  {
+    // Multiply and get the exact error of the product...
+    product  = anumber * powers_of_10[places];
+    error    = fma(anumber, powers_of_10[places], -product);
+    whole    = floor(product);
+    mantissa = (uint64_t)whole;
+
+    if (whole == product)
+    {
+      // The product is an integer - the error is at most half of the spacing
+      // between doubles, so it only matters for large products...
+      if (fabs(error) == 0.5)
+      {
+        if ((mantissa & 1) && error > 0.0)
+          mantissa ++;
+        else if (mantissa & 1)
+          mantissa --;
+      }
+      else
+      {
+        mantissa = (uint64_t)((int64_t)mantissa + (int64_t)rint(error));
+      }
+    }
     else
-      left = current;
+    {
+      // The error is less than the spacing of the fraction, so it only
+      // matters for an exact fraction of 0.5...
+      frac = product - whole;
+
+      if (frac > 0.5 || (frac == 0.5 && (error > 0.0 || (error == 0.0 && (mantissa & 1)))))
+        mantissa ++;
+    }
   }
-  while ((right - left) > 1);
 
-  if (diff != 0)
+  return (mantissa);
+}
+
+
+//
+// 'scale_digits()' - Convert the digits of a number using strtod().
+//
+// The digits are copied without the decimal point and followed by an
+// exponent, so the conversion does not depend on the locale.  Only the first
+// 768 significant digits and whether any of the remaining digits are non-zero
+// matter for rounding.
+//
+
+static double				// O - Absolute value of number
+scale_digits(const char *s,		// I - Digits and decimal point
+             int        exponent)	// I - Exponent
+{
+  char		temp[800],		// Digits and exponent
+		*tempptr = temp,	// Pointer into digits
+		*tempend = temp + 780;	// End of digits
+  bool		decimal = false,	// Seen decimal point?
+		inexact = false;	// Were non-zero digits dropped?
+
+
+  for (;; s ++)
   {
-    // Check the last 1 or 2 elements...
-    if ((diff = strcmp(s, pdf->strings[left])) <= 0)
+    if (*s >= '0' && *s <= '9')
+    {
+      if (tempptr == temp && *s == '0')
+      {
+        // Skip leading zeros...
+        if (decimal)
+          exponent --;
+      }
+      else if (tempptr < tempend)
+      {
+        *tempptr++ = *s;
+
+        if (decimal)
+          exponent --;
+      }
+      else
+      {
+        if (!decimal)
+          exponent ++;
+
+        if (*s != '0')
+          inexact = true;
+      }
+    }
+    else if (*s == '.' && !decimal)
     {
-      current = left;
+      decimal = true;
     }
     else
     {
-      diff    = strcmp(s, pdf->strings[right]);
-      current = right;
+      break;
+    }
+  }
+
+  if (inexact)
+  {
+    // Add a non-zero digit so that strtod() rounds the dropped digits...
+    *tempptr++ = '1';
+    exponent --;
+  }
+
+  snprintf(tempptr, sizeof(temp) - (size_t)(tempptr - temp), "e%d", exponent);
+
+  return (strtod(temp, NULL));
+}
+
+
+//
+// 'shortest_digits()' - Find the shortest decimal mantissa that reads back as the same value.
+//
+// The number is first rounded to the maximum number of significant digits,
+// using round_number() when the scale is exact and snprintf() otherwise, and
+// then fewer digits are tried, rounding down and up.
+//
+
+static int				// O - Number of decimal places
+shortest_digits(double   anumber,	// I - Absolute value of number
+                int      digits,	// I - Maximum significant digits
+                int      min_digits,	// I - Minimum significant digits to try
+                int      exponent,	// I - Decimal exponent, if known
+                uint64_t *mantissa)	// O - Decimal mantissa
+{
+  char		temp[64],		// Formatted number
+		*tempptr;		// Pointer into formatted number
+  uint64_t	rounded = 0,		// Mantissa with all digits
+		scale,			// Power of 10 for dropped digits
+		candidate;		// Mantissa with fewer digits
+  int		i,			// Looping var
+		count,			// Number of digits
+		places;			// Decimal places of candidate
+  bool		up;			// Try rounding up first?
+  double	value;			// Value of candidate
+
+
+  for (scale = 1, count = 1; count < digits; count ++)
+    scale *= 10;
+
+  if (exponent > -22 && exponent < 17 && (digits - 1 - exponent) < 22)
+  {
+    // Round using the exact scale, correcting the exponent as needed...
+    rounded = round_number(anumber, digits - 1 - exponent);
+
+    if (rounded < scale)
+    {
+      exponent --;
+      rounded = round_number(anumber, digits - 1 - exponent);
+    }
+    else if (rounded >= scale * 10)
+    {
+      exponent ++;
+      rounded = round_number(anumber, digits - 1 - exponent);
+    }
+  }
+  else
+  {
+    // The number looks like "d.ddde+XX" but the decimal point depends on the
+    // locale, so just collect the digits...
+    snprintf(temp, sizeof(temp), "%.*e", digits - 1, anumber);
+
+    for (tempptr = temp; *tempptr && *tempptr != 'e'; tempptr ++)
+    {
+      if (*tempptr >= '0' && *tempptr <= '9')
+	rounded = rounded * 10 + (uint64_t)(*tempptr - '0');
+    }
+
+    exponent = *tempptr ? atoi(tempptr + 1) : 0;
+  }
+
+  for (count = 1; count < min_digits && count < digits; count ++)
+    scale /= 10;
+
+  for (; count < digits; count ++, scale /= 10)
+  {
+    up     = (rounded % scale) * 2 >= scale;
+    places = count - 1 - exponent;
+
+    for (i = 0; i < 2; i ++)
+    {
+      candidate = rounded / scale + ((i == 0) == up ? 1 : 0);
+
+      if (candidate <= 9007199254740992ULL && places >= -22 && places <= 22)
+      {
+        value = places < 0 ? (double)candidate * powers_of_10[-places] : (double)candidate / powers_of_10[places];
+      }
+      else
+      {
+        snprintf(temp, sizeof(temp), "%llue%d", (unsigned long long)candidate, -places);
+        value = strtod(temp, NULL);
+      }
+
+      if (value == anumber)
+      {
+        *mantissa = candidate;
+        return (places);
+      }
     }
   }
 
-  // Return the closest string and the difference...
-  *rdiff = diff;
+  *mantissa = rounded;
 
-  return (current);
+  return (digits - 1 - exponent);
 }
@@ -17,6 +17,109 @@
 static time_t	get_date_time(const char *s);
 
 
+//
+// '_pdfioValueClone()' - Make a deep copy of a value in the same PDF file.
+//
+// Unlike @link _pdfioValueCopy@, arrays and dictionaries are copied rather
+// than shared so that the new value can later be released with
+// @link _pdfioValueRelease@.
+//
+
+_pdfio_value_t *			// O - Destination value or `NULL` on error
+_pdfioValueClone(pdfio_file_t   *pdf,	// I - PDF file
+                 _pdfio_value_t *vdst,	// I - Destination value
+                 _pdfio_value_t *vsrc)	// I - Source value
+{
+  size_t	i;			// Looping var
+
+
+  *vdst = *vsrc;
+
+  switch (vsrc->type)
+  {
+    default :
+        break;
+
+    case PDFIO_VALTYPE_ARRAY :
+        {
+          pdfio_array_t	*a = vsrc->value.array,
+					// Source array
+			*na;		// New array
+
+	  if ((na = pdfioArrayCreate(pdf)) == NULL)
+	    return (NULL);
+
+	  if (a->num_values > 0)
+	  {
+	    if ((na->values = (_pdfio_value_t *)_pdfioFileAlloc(pdf, a->num_values * sizeof(_pdfio_value_t))) == NULL)
+	      return (NULL);
+
+	    na->alloc_values = a->num_values;
+
+	    for (i = 0; i < a->num_values; i ++, na->num_values ++)
+	    {
+	      if (!_pdfioValueClone(pdf, na->values + i, a->values + i))
+		return (NULL);
+	    }
+	  }
+
+	  vdst->value.array = na;
+	}
+        break;
+
+    case PDFIO_VALTYPE_BINARY :
+        if ((vdst->value.binary.data = (unsigned char *)_pdfioFileAlloc(pdf, vsrc->value.binary.datalen)) == NULL)
+        {
+          _pdfioFileError(pdf, "Unable to allocate memory for a binary string - %s", strerror(errno));
+          return (NULL);
+        }
+
+        memcpy(vdst->value.binary.data, vsrc->value.binary.data, vsrc->value.binary.datalen);
+        break;
+
+    case PDFIO_VALTYPE_DICT :
+        {
+          pdfio_dict_t	*dict = vsrc->value.dict,
+					// Source dictionary
+			*ndict;		// New dictionary
+
+	  if ((ndict = pdfioDictCreate(pdf)) == NULL)
+	    return (NULL);
+
+	  if (dict->num_pairs > 0)
+	  {
+	    // Copy the pairs and hash index as-is, then clone the values...
+	    if ((ndict->pairs = (_pdfio_pair_t *)_pdfioFileAlloc(pdf, dict->num_pairs * sizeof(_pdfio_pair_t))) == NULL)
+	      return (NULL);
+
+	    memcpy(ndict->pairs, dict->pairs, dict->num_pairs * sizeof(_pdfio_pair_t));
+	    ndict->alloc_pairs = dict->num_pairs;
+
+	    if (dict->hash)
+	    {
+	      if ((ndict->hash = (size_t *)_pdfioFileAlloc(pdf, dict->alloc_hash * sizeof(size_t))) == NULL)
+		return (NULL);
+
+	      memcpy(ndict->hash, dict->hash, dict->alloc_hash * sizeof(size_t));
+	      ndict->alloc_hash = dict->alloc_hash;
+	    }
+
+	    for (i = 0; i < dict->num_pairs; i ++, ndict->num_pairs ++)
+	    {
+	      if (!_pdfioValueClone(pdf, &ndict->pairs[i].value, &dict->pairs[i].value))
+		return (NULL);
+	    }
+	  }
+
+	  vdst->value.dict = ndict;
+	}
+        break;
+  }
+
+  return (vdst);
+}
+
+
 //
 // '_pdfioValueCopy()' - Copy a value to a PDF file.
 //
@@ -80,7 +183,7 @@ _pdfioValueCopy(pdfio_file_t   *pdfdst,	// I - Destination PDF file
         break;
 
     case PDFIO_VALTYPE_BINARY :
-        if ((vdst->value.binary.data = (unsigned char *)malloc(vsrc->value.binary.datalen)) == NULL)
+        if ((vdst->value.binary.data = (unsigned char *)_pdfioFileAlloc(pdfdst, vsrc->value.binary.datalen)) == NULL)
         {
           _pdfioFileError(pdfdst, "Unable to allocate memory for a binary string - %s", strerror(errno));
           return (NULL);
@@ -163,6 +266,7 @@ _pdfioValueDecrypt(pdfio_file_t   *pdf,	// I - PDF file
 	  return (false);
 
 	templen = (cb)(&ctx, temp, v->value.binary.data + ivlen, v->value.binary.datalen - ivlen);
+	pdf->stats.bytes_crypto += v->value.binary.datalen - ivlen;
 
 	// Copy the decrypted string back to the value and adjust the length...
 	memcpy(v->value.binary.data, temp, templen);
@@ -186,6 +290,7 @@ _pdfioValueDecrypt(pdfio_file_t   *pdf,	// I - PDF file
 	if ((cb = _pdfioCryptoMakeReader(pdf, obj, &ctx, (uint8_t *)v->value.string, &ivlen)) == NULL)
 	  return (false);
 
+	pdf->stats.bytes_crypto += templen - ivlen;
 	templen = (cb)(&ctx, temp, (uint8_t *)v->value.string + ivlen, templen - ivlen);
 	temp[templen] = '\0';
 
@@ -278,14 +383,36 @@ _pdfioValueDebug(_pdfio_value_t *v,	// I - Value
 
 
 //
-// '_pdfioValueDelete()' - Free the memory used by a value.
+// '_pdfioValueDigest()' - Add the written form of a value to a SHA-256 digest.
+//
+// The value is written (without encryption) to the end of the spool buffer of
+// a PDF file being written, so indirect references are digested as object
+// numbers in the destination file.
 //
 
-void
-_pdfioValueDelete(_pdfio_value_t *v)	// I - Value
+bool					// O - `true` on success, `false` on failure
+_pdfioValueDigest(pdfio_file_t    *pdf,	// I - PDF file
+                  _pdfio_value_t  *v,	// I - Value
+                  _pdfio_sha256_t *ctx)	// I - SHA-256 context
 {
-  if (v->type == PDFIO_VALTYPE_BINARY)
-    free(v->value.binary.data);
+  bool		ret;			// Return value
+  size_t	spoollen = pdf->spoollen;
+					// Original length of spool buffer
+
+
+  if (!_pdfioFileBeginSpool(pdf))
+    return (false);
+
+  ret = _pdfioValueWrite(pdf, NULL, v, NULL);
+
+  if (!_pdfioFileEndSpool(pdf) || !ret)
+    return (false);
+
+  _pdfioCryptoSHA256Append(ctx, (uint8_t *)pdf->spool + spoollen, pdf->spoollen - spoollen);
+
+  pdf->spoollen = spoollen;
+
+  return (true);
 }
 
 
@@ -376,7 +503,7 @@ _pdfioValueRead(pdfio_file_t   *pdf,	// I - PDF file
 
     v->type                 = PDFIO_VALTYPE_BINARY;
     v->value.binary.datalen = strlen(token) / 2;
-    if ((v->value.binary.data = (unsigned char *)malloc(v->value.binary.datalen)) == NULL)
+    if ((v->value.binary.data = (unsigned char *)_pdfioFileAlloc(pdf, v->value.binary.datalen)) == NULL)
     {
       _pdfioFileError(pdf, "Out of memory for hex string.");
       return (NULL);
@@ -500,7 +627,7 @@ _pdfioValueRead(pdfio_file_t   *pdf,	// I - PDF file
 
     // If we get here, we have a number...
     v->type         = PDFIO_VALTYPE_NUMBER;
-    v->value.number = _pdfio_strtod(pdf, token);
+    v->value.number = _pdfio_strtod(token, NULL);
   }
   else if (!strcmp(token, "true") || !strcmp(token, "false"))
   {
@@ -525,6 +652,52 @@ _pdfioValueRead(pdfio_file_t   *pdf,	// I - PDF file
 }
 
 
+//
+// '_pdfioValueRelease()' - Release the memory used by a value.
+//
+// Arrays, dictionaries, and binary strings are released recursively, so the
+// value must not share any of them with other values.  Strings are not
+// released since they may be used elsewhere.
+//
+
+void
+_pdfioValueRelease(pdfio_file_t   *pdf,	// I - PDF file
+                   _pdfio_value_t *v)	// I - Value
+{
+  size_t	i;			// Looping var
+
+
+  switch (v->type)
+  {
+    default :
+        break;
+
+    case PDFIO_VALTYPE_ARRAY :
+        for (i = 0; i < v->value.array->num_values; i ++)
+          _pdfioValueRelease(pdf, v->value.array->values + i);
+
+        _pdfioFileFree(pdf, v->value.array->values);
+        _pdfioFileFree(pdf, v->value.array);
+        break;
+
+    case PDFIO_VALTYPE_BINARY :
+        _pdfioFileFree(pdf, v->value.binary.data);
+        break;
+
+    case PDFIO_VALTYPE_DICT :
+        for (i = 0; i < v->value.dict->num_pairs; i ++)
+          _pdfioValueRelease(pdf, &v->value.dict->pairs[i].value);
+
+        _pdfioFileFree(pdf, v->value.dict->pairs);
+        _pdfioFileFree(pdf, v->value.dict->hash);
+        _pdfioFileFree(pdf, v->value.dict);
+        break;
+  }
+
+  v->type = PDFIO_VALTYPE_NONE;
+}
+
+
 //
 // '_pdfioValueWrite()' - Write a value to a PDF file.
 //
@@ -564,6 +737,8 @@ _pdfioValueWrite(pdfio_file_t   *pdf,	// I - PDF file
 
 	    cb        = _pdfioCryptoMakeWriter(pdf, obj, &ctx, temp, &ivlen);
 	    databytes = (cb)(&ctx, temp + ivlen, v->value.binary.data, v->value.binary.datalen) + ivlen;
+
+	    pdf->stats.bytes_crypto += v->value.binary.datalen;
 	    dataptr   = temp;
           }
           else
@@ -621,6 +796,8 @@ _pdfioValueWrite(pdfio_file_t   *pdf,	// I - PDF file
 	    cb        = _pdfioCryptoMakeWriter(pdf, obj, &ctx, temp, &ivlen);
 	    tempbytes = (cb)(&ctx, temp + ivlen, (const uint8_t *)datestr, len) + ivlen;
 
+	    pdf->stats.bytes_crypto += len;
+
 	    if (!_pdfioFilePuts(pdf, "<"))
 	      return (false);
 
@@ -645,6 +822,11 @@ _pdfioValueWrite(pdfio_file_t   *pdf,	// I - PDF file
         return (_pdfioDictWrite(v->value.dict, obj, length));
 
     case PDFIO_VALTYPE_INDIRECT :
+        if (pdf->lin_objs && v->value.indirect.number < pdf->num_lin_objs)
+        {
+          // Writing a linearized PDF file with new object numbers...
+          return (_pdfioFilePrintf(pdf, " %lu 0 R", (unsigned long)pdf->lin_objs[v->value.indirect.number].number));
+        }
         return (_pdfioFilePrintf(pdf, " %lu %u R", (unsigned long)v->value.indirect.number, v->value.indirect.generation));
 
     case PDFIO_VALTYPE_NAME :
@@ -654,7 +836,11 @@ _pdfioValueWrite(pdfio_file_t   *pdf,	// I - PDF file
         return (_pdfioFilePuts(pdf, " null"));
 
     case PDFIO_VALTYPE_NUMBER :
-        return (_pdfioFilePrintf(pdf, " %g", v->value.number));
+        // Write integers such as file offsets and lengths with all digits...
+        if (v->value.number > -1e15 && v->value.number < 1e15 && v->value.number == (double)(int64_t)v->value.number)
+          return (_pdfioFilePrintf(pdf, " %.0f", v->value.number));
+        else
+          return (_pdfioFilePrintf(pdf, " %g", v->value.number));
 
     case PDFIO_VALTYPE_STRING :
         if (obj && pdf->encryption)
@@ -678,6 +864,8 @@ _pdfioValueWrite(pdfio_file_t   *pdf,	// I - PDF file
           cb        = _pdfioCryptoMakeWriter(pdf, obj, &ctx, temp, &ivlen);
           tempbytes = (cb)(&ctx, temp + ivlen, (const uint8_t *)v->value.string, len) + ivlen;
 
+          pdf->stats.bytes_crypto += len;
+
           if (!_pdfioFilePuts(pdf, "<"))
             return (false);
 
@@ -53,12 +53,14 @@ typedef struct _pdfio_array_s pdfio_array_t;
 					// Array of PDF values
 typedef struct _pdfio_dict_s pdfio_dict_t;
 					// Key/value dictionary
+typedef ssize_t (*pdfio_deflate_cb_t)(void *cb_data, int level, const void *src, size_t srclen, void *dst, size_t dstsize);
+					// Flate compression callback for pdfioFileSetCodec
 typedef bool (*pdfio_dict_cb_t)(pdfio_dict_t *dict, const char *key, void *cb_data);
 					// Dictionary iterator callback
 typedef struct _pdfio_file_s pdfio_file_t;
 					// PDF file
 typedef bool (*pdfio_error_cb_t)(pdfio_file_t *pdf, const char *message, void *data);
-					// Error callback
+					// Error callback, "pdf" is `NULL` for pdfioFontCreate errors
 typedef enum pdfio_encryption_e		// PDF encryption modes
 {
   PDFIO_ENCRYPTION_NONE = 0,		// No encryption
@@ -81,11 +83,31 @@ typedef enum pdfio_filter_e		// Compression/decompression filters for streams
   PDFIO_FILTER_LZW,			// LZWDecode filter (reading only)
   PDFIO_FILTER_RUNLENGTH,		// RunLengthDecode filter (reading only)
 } pdfio_filter_t;
+typedef ssize_t (*pdfio_inflate_cb_t)(void *cb_data, const void *src, size_t srclen, void *dst, size_t dstsize);
+					// Flate decompression callback for pdfioFileSetCodec
+typedef ssize_t (*pdfio_input_cb_t)(void *ctx, off_t offset, void *buffer, size_t bytes);
+					// Input callback for pdfioFileOpenIO
 typedef struct _pdfio_obj_s pdfio_obj_t;// Numbered object in PDF file
+enum pdfio_option_e			// PDF output option bits
+{
+  PDFIO_OPTION_NONE = 0,		// No options
+  PDFIO_OPTION_OBJSTREAMS = 0x0001,	// Write objects in compressed object streams with a cross-reference stream (PDF 1.5)
+  PDFIO_OPTION_DEDUPLICATE = 0x0002,	// Share identical stream objects copied from other PDF files
+  PDFIO_OPTION_SUBSET_FONTS = 0x0004,	// Embed only the glyphs that are used by Unicode fonts
+  PDFIO_OPTION_PARALLEL = 0x0008,	// Compress Flate streams using multiple threads
+  PDFIO_OPTION_LINEARIZE = 0x0010,	// Write a linearized ("Fast Web View") PDF file
+  PDFIO_OPTION_STREAMING = 0x0020	// Free page objects once they are written
+};
+typedef int pdfio_option_t;		// PDF output option bitfield
 typedef ssize_t (*pdfio_output_cb_t)(void *ctx, const void *data, size_t datalen);
 					// Output callback for pdfioFileCreateOutput
 typedef const char *(*pdfio_password_cb_t)(void *data, const char *filename);
 					// Password callback for pdfioFileOpen
+enum pdfio_precision_e			// Special precision values for pdfioFileSetPrecision
+{
+  PDFIO_PRECISION_SHORTEST = -2,	// Shortest string that reads back as the same value
+  PDFIO_PRECISION_DEFAULT = -1		// Up to 6 significant digits
+};
 enum pdfio_permission_e			// PDF permission bits
 {
   PDFIO_PERMISSION_NONE = 0,		// No permissions
@@ -107,8 +129,45 @@ typedef struct pdfio_rect_s		// PDF rectangle
   double	x2;			// Upper-right X coordinate
   double	y2;			// Upper-right Y coordinate
 } pdfio_rect_t;
+typedef enum pdfio_span_e		// Traced operations for pdfioFileSetSpanCallback
+{
+  PDFIO_SPAN_READ,			// Reading from the file
+  PDFIO_SPAN_WRITE,			// Writing to the file
+  PDFIO_SPAN_SEEK,			// Seeking in the file
+  PDFIO_SPAN_LOAD_OBJ,			// Loading an object value
+  PDFIO_SPAN_LOAD_OBJSTM,		// Decompressing an object stream
+  PDFIO_SPAN_INFLATE,			// Decompressing Flate data
+  PDFIO_SPAN_DEFLATE,			// Compressing Flate data
+  PDFIO_SPAN_CRYPTO			// Encrypting or decrypting data
+} pdfio_span_t;
+typedef void (*pdfio_span_cb_t)(pdfio_file_t *pdf, pdfio_span_t span, bool begin, void *cb_data);
+					// Span callback for pdfioFileSetSpanCallback
+typedef struct pdfio_stats_s		// PDF file statistics
+{
+  size_t	bytes_read;		// Bytes read from the file descriptor or input callback
+  size_t	bytes_written;		// Bytes written to the file descriptor or output callback
+  size_t	reads;			// Number of reads from the file descriptor or input callback
+  size_t	writes;			// Number of writes to the file descriptor or output callback
+  size_t	seeks;			// Number of seeks in the file descriptor
+  size_t	buffer_fills;		// Number of times the read buffer was filled
+  size_t	objs_loaded;		// Number of object values loaded
+  size_t	objstms_loaded;		// Number of times an object stream was decompressed
+  size_t	bytes_inflated;		// Bytes of decompressed Flate data
+  size_t	bytes_deflated;		// Bytes of data given to Flate compression
+  size_t	bytes_crypto;		// Bytes of encrypted or decrypted data
+  size_t	strings;		// Number of unique strings
+  size_t	alloc_bytes;		// Bytes currently allocated for values and strings
+  size_t	peak_alloc_bytes;	// Peak bytes allocated for values and strings
+} pdfio_stats_t;
 typedef struct _pdfio_stream_s pdfio_stream_t;
 					// Object data stream in PDF file
+typedef enum pdfio_strategy_e		// Flate compression strategies
+{
+  PDFIO_STRATEGY_DEFAULT,		// Default strategy for general data
+  PDFIO_STRATEGY_FILTERED,		// Data from a predictor or other filter
+  PDFIO_STRATEGY_HUFFMAN,		// Huffman coding only, fastest
+  PDFIO_STRATEGY_RLE			// Run-length encoding, fast for images
+} pdfio_strategy_t;
 typedef enum pdfio_valtype_e		// PDF value types
 {
   PDFIO_VALTYPE_NONE,			// No value, not set
@@ -206,17 +265,31 @@ extern size_t		pdfioFileGetNumObjs(pdfio_file_t *pdf) _PDFIO_PUBLIC;
 extern size_t		pdfioFileGetNumPages(pdfio_file_t *pdf) _PDFIO_PUBLIC;
 extern pdfio_obj_t	*pdfioFileGetObj(pdfio_file_t *pdf, size_t n) _PDFIO_PUBLIC;
 extern pdfio_obj_t	*pdfioFileGetPage(pdfio_file_t *pdf, size_t n) _PDFIO_PUBLIC;
+extern pdfio_option_t	pdfioFileGetOptions(pdfio_file_t *pdf) _PDFIO_PUBLIC;
 extern pdfio_permission_t pdfioFileGetPermissions(pdfio_file_t *pdf, pdfio_encryption_t *encryption) _PDFIO_PUBLIC;
 extern const char	*pdfioFileGetProducer(pdfio_file_t *pdf) _PDFIO_PUBLIC;
+extern bool		pdfioFileGetStats(pdfio_file_t *pdf, pdfio_stats_t *stats) _PDFIO_PUBLIC;
 extern const char	*pdfioFileGetSubject(pdfio_file_t *pdf) _PDFIO_PUBLIC;
 extern const char	*pdfioFileGetTitle(pdfio_file_t *pdf) _PDFIO_PUBLIC;
 extern const char	*pdfioFileGetVersion(pdfio_file_t *pdf) _PDFIO_PUBLIC;
+extern bool		pdfioFileLoadObjStreams(pdfio_file_t *pdf) _PDFIO_PUBLIC;
 extern pdfio_file_t	*pdfioFileOpen(const char *filename, pdfio_password_cb_t password_cb, void *password_data, pdfio_error_cb_t error_cb, void *error_data) _PDFIO_PUBLIC;
+extern pdfio_file_t	*pdfioFileOpenIO(pdfio_input_cb_t input_cb, void *input_ctx, off_t size, pdfio_password_cb_t password_cb, void *password_data, pdfio_error_cb_t error_cb, void *error_data) _PDFIO_PUBLIC;
+extern pdfio_file_t	*pdfioFileOpenMemory(const void *data, size_t datalen, pdfio_password_cb_t password_cb, void *password_data, pdfio_error_cb_t error_cb, void *error_data) _PDFIO_PUBLIC;
+extern pdfio_file_t	*pdfioFileOpenUpdate(const char *filename, pdfio_password_cb_t password_cb, void *password_data, pdfio_error_cb_t error_cb, void *error_data) _PDFIO_PUBLIC;
 extern void		pdfioFileSetAuthor(pdfio_file_t *pdf, const char *value) _PDFIO_PUBLIC;
+extern bool		pdfioFileSetCacheSize(pdfio_file_t *pdf, size_t bytes) _PDFIO_PUBLIC;
+extern bool		pdfioFileSetCodec(pdfio_file_t *pdf, pdfio_deflate_cb_t deflate_cb, pdfio_inflate_cb_t inflate_cb, void *cb_data) _PDFIO_PUBLIC;
+extern bool		pdfioFileSetCompression(pdfio_file_t *pdf, int level, pdfio_strategy_t strategy) _PDFIO_PUBLIC;
+extern bool		pdfioFileSetConcurrent(pdfio_file_t *pdf, bool concurrent) _PDFIO_PUBLIC;
 extern void		pdfioFileSetCreationDate(pdfio_file_t *pdf, time_t value) _PDFIO_PUBLIC;
 extern void		pdfioFileSetCreator(pdfio_file_t *pdf, const char *value) _PDFIO_PUBLIC;
 extern void		pdfioFileSetKeywords(pdfio_file_t *pdf, const char *value) _PDFIO_PUBLIC;
+extern bool		pdfioFileSetOptions(pdfio_file_t *pdf, pdfio_option_t options) _PDFIO_PUBLIC;
+extern bool		pdfioFileSetPageFanout(pdfio_file_t *pdf, size_t fanout) _PDFIO_PUBLIC;
 extern bool		pdfioFileSetPermissions(pdfio_file_t *pdf, pdfio_permission_t permissions, pdfio_encryption_t encryption, const char *owner_password, const char *user_password) _PDFIO_PUBLIC;
+extern bool		pdfioFileSetPrecision(pdfio_file_t *pdf, int precision) _PDFIO_PUBLIC;
+extern void		pdfioFileSetSpanCallback(pdfio_file_t *pdf, pdfio_span_cb_t cb, void *cb_data) _PDFIO_PUBLIC;
 extern void		pdfioFileSetSubject(pdfio_file_t *pdf, const char *value) _PDFIO_PUBLIC;
 extern void		pdfioFileSetTitle(pdfio_file_t *pdf, const char *value) _PDFIO_PUBLIC;
 
@@ -245,6 +318,7 @@ extern bool		pdfioStreamPrintf(pdfio_stream_t *st, const char *format, ...) _PDF
 extern bool		pdfioStreamPutChar(pdfio_stream_t *st, int ch) _PDFIO_PUBLIC;
 extern bool		pdfioStreamPuts(pdfio_stream_t *st, const char *s) _PDFIO_PUBLIC;
 extern ssize_t		pdfioStreamRead(pdfio_stream_t *st, void *buffer, size_t bytes) _PDFIO_PUBLIC;
+extern bool		pdfioStreamSetCompression(pdfio_stream_t *st, int level, pdfio_strategy_t strategy) _PDFIO_PUBLIC;
 extern bool		pdfioStreamWrite(pdfio_stream_t *st, const void *buffer, size_t bytes) _PDFIO_PUBLIC;
 
 extern char		*pdfioStringCreate(pdfio_file_t *pdf, const char *s)  _PDFIO_PUBLIC;
@@ -0,0 +1,1121 @@
+//
+// Benchmark program for PDFio.
+//
+// Copyright © 2025 by Michael R Sweet.
+//
+// Licensed under Apache License v2.0.  See the file "LICENSE" for more
+// information.
+//
+// Usage:
+//
+//   ./pdfiobench [OPTIONS] [FILENAME ...]
+//
+// Options:
+//
+//   --help                Show program help.
+//   --iterations N        Run each benchmark N times (default 10).
+//   --no-synthetic        Only benchmark the named files.
+//   --output FILENAME     Write JSON results to FILENAME (default stdout).
+//   --password PASSWORD   Password for the named files.
+//   --quick               Use smaller synthetic files.
+//   --scratch DIRECTORY   Directory for generated files (default ".").
+//
+
+#include "pdfio.h"
+#include "pdfio-content.h"
+#include <stdio.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#  include <windows.h>
+#  include <psapi.h>
+#  include <direct.h>
+#  include <io.h>
+#  define access	_access
+#  define chdir		_chdir
+#else
+#  include <unistd.h>
+#  include <time.h>
+#  include <sys/resource.h>
+#endif // _WIN32
+
+
+//
+// Local types...
+//
+
+typedef struct bench_s			// Benchmark context
+{
+  FILE		*fp;			// JSON output file
+  size_t	iterations;		// Number of iterations
+  size_t	count;			// Number of results written
+  int		failures;		// Number of failed benchmarks
+  const char	*scratch;		// Scratch directory
+  const char	*password;		// Password for opening files
+  double	*times;			// Times for the current benchmark
+} bench_t;
+
+typedef bool (*bench_cb_t)(bench_t *bench, const char *filename, size_t *items, size_t *bytes);
+					// Benchmark callback
+
+typedef struct corpus_s			// Synthetic corpus
+{
+  const char	*name;			// Name of corpus
+  bool		(*create_cb)(const char *filename, size_t count, size_t *items, size_t *bytes);
+					// Function to create corpus
+  size_t	count,			// Number of items (full size)
+		quick_count;		// Number of items (quick)
+  const char	*item_unit;		// Unit for items
+  bool		encrypted;		// Encrypted?
+} corpus_t;
+
+
+//
+// Local functions...
+//
+
+static bool	bench_copy_pages(bench_t *bench, const char *filename, size_t *items, size_t *bytes);
+static bool	bench_inflate(bench_t *bench, const char *filename, size_t *items, size_t *bytes);
+static bool	bench_load_objects(bench_t *bench, const char *filename, size_t *items, size_t *bytes);
+static bool	bench_open(bench_t *bench, const char *filename, size_t *items, size_t *bytes);
+static int	compare_times(const double *a, const double *b);
+static bool	create_cjk_text(const char *filename, size_t count, size_t *items, size_t *bytes);
+static bool	create_encrypted(const char *filename, size_t count, size_t *items, size_t *bytes);
+static bool	create_images(const char *filename, size_t count, size_t *items, size_t *bytes);
+static bool	create_many_objects(const char *filename, size_t count, size_t *items, size_t *bytes);
+static bool	create_many_pages(const char *filename, size_t count, size_t *items, size_t *bytes);
+static bool	create_text_show(const char *filename, size_t count, size_t *items, size_t *bytes);
+static bool	error_cb(pdfio_file_t *pdf, const char *message, void *data);
+static double	get_peak_rss(void);
+static size_t	get_size(const char *filename);
+static double	get_time(void);
+static pdfio_file_t *open_file(bench_t *bench, const char *filename);
+static const char *password_cb(void *data, const char *filename);
+static void	run_bench(bench_t *bench, const char *name, const char *corpus, const char *filename, const char *item_unit, bench_cb_t cb);
+static void	run_create(bench_t *bench, const corpus_t *corpus, const char *filename, bool quick);
+static int	usage(FILE *fp);
+static void	write_result(bench_t *bench, const char *name, const char *corpus, const char *filename, const char *item_unit, size_t n, double total, size_t items, size_t bytes, bool ok);
+static bool	write_page(pdfio_file_t *pdf, pdfio_obj_t *font, bool unicode, const char *text, size_t lines, size_t *items, size_t *bytes);
+static void	write_string(FILE *fp, const char *s);
+
+
+//
+// Local globals...
+//
+
+static const corpus_t	corpora[] =	// Synthetic corpora
+{
+  { "many-objects", create_many_objects, 100000, 10000, "objects", false },
+  { "many-pages", create_many_pages, 2000, 200, "pages", false },
+  { "images", create_images, 64, 8, "images", false },
+  { "cjk-text", create_cjk_text, 100, 10, "pages", false },
+  { "encrypted", create_encrypted, 1000, 100, "pages", true },
+  { "text-show", create_text_show, 100000, 10000, "strings", false }
+};
+
+static const char	*bench_password = "pdfiobench";
+					// Password for encrypted corpus
+
+
+//
+// 'main()' - Main entry for benchmark program.
+//
+
+int					// O - Exit status
+main(int  argc,				// I - Number of command-line arguments
+     char *argv[])			// I - Command-line arguments
+{
+  int		i;			// Looping var
+  bench_t	bench;			// Benchmark context
+  const char	*outfile = NULL;	// Output filename
+  bool		quick = false,		// Use smaller synthetic files?
+		synthetic = true;	// Benchmark synthetic files?
+  size_t	j,			// Looping var
+		num_files = 0;		// Number of named files
+  char		filename[1024];		// Synthetic filename
+
+
+  // Parse command-line...
+  memset(&bench, 0, sizeof(bench));
+  bench.iterations = 10;
+  bench.scratch    = ".";
+
+  for (i = 1; i < argc; i ++)
+  {
+    if (!strcmp(argv[i], "--help"))
+    {
+      return (usage(stdout));
+    }
+    else if (!strcmp(argv[i], "--iterations"))
+    {
+      i ++;
+      if (i >= argc || atoi(argv[i]) < 1)
+      {
+        fputs("pdfiobench: Expected number after '--iterations'.\n", stderr);
+        return (usage(stderr));
+      }
+
+      bench.iterations = (size_t)atoi(argv[i]);
+    }
+    else if (!strcmp(argv[i], "--no-synthetic"))
+    {
+      synthetic = false;
+    }
+    else if (!strcmp(argv[i], "--output"))
+    {
+      i ++;
+      if (i >= argc)
+      {
+        fputs("pdfiobench: Missing filename after '--output'.\n", stderr);
+        return (usage(stderr));
+      }
+
+      outfile = argv[i];
+    }
+    else if (!strcmp(argv[i], "--password"))
+    {
+      i ++;
+      if (i >= argc)
+      {
+        fputs("pdfiobench: Missing password after '--password'.\n", stderr);
+        return (usage(stderr));
+      }
+
+      bench.password = argv[i];
+    }
+    else if (!strcmp(argv[i], "--quick"))
+    {
+      quick = true;
+    }
+    else if (!strcmp(argv[i], "--scratch"))
+    {
+      i ++;
+      if (i >= argc)
+      {
+        fputs("pdfiobench: Missing directory after '--scratch'.\n", stderr);
+        return (usage(stderr));
+      }
+
+      bench.scratch = argv[i];
+    }
+    else if (argv[i][0] == '-')
+    {
+      fprintf(stderr, "pdfiobench: Unknown option '%s'.\n", argv[i]);
+      return (usage(stderr));
+    }
+    else
+    {
+      num_files ++;
+    }
+  }
+
+  if ((bench.times = (double *)calloc(bench.iterations, sizeof(double))) == NULL)
+  {
+    perror("pdfiobench: Unable to allocate memory");
+    return (1);
+  }
+
+  if (!outfile)
+  {
+    bench.fp = stdout;
+  }
+  else if ((bench.fp = fopen(outfile, "w")) == NULL)
+  {
+    fprintf(stderr, "pdfiobench: Unable to create '%s': %s\n", outfile, strerror(errno));
+    free(bench.times);
+    return (1);
+  }
+
+#if _WIN32
+  // Windows puts executables in Platform/Configuration subdirs...
+  if (num_files == 0 && access("testfiles", 0) && !access("../../testfiles", 0))
+    chdir("../..");
+#endif // _WIN32
+
+  // Write the results header...
+  fputs("{\n", bench.fp);
+  fputs("  \"program\": \"pdfiobench\",\n", bench.fp);
+  fputs("  \"pdfio_version\": ", bench.fp);
+  write_string(bench.fp, PDFIO_VERSION);
+  fprintf(bench.fp, ",\n  \"iterations\": %lu,\n", (unsigned long)bench.iterations);
+  fprintf(bench.fp, "  \"quick\": %s,\n", quick ? "true" : "false");
+  fputs("  \"benchmarks\": [", bench.fp);
+
+  // Benchmark the synthetic corpora...
+  if (synthetic)
+  {
+    for (j = 0; j < (sizeof(corpora) / sizeof(corpora[0])); j ++)
+    {
+      snprintf(filename, sizeof(filename), "%s/pdfiobench-%s.pdf", bench.scratch, corpora[j].name);
+
+      run_create(&bench, corpora + j, filename, quick);
+
+      bench.password = corpora[j].encrypted ? bench_password : NULL;
+
+      run_bench(&bench, "open", corpora[j].name, filename, "objects", bench_open);
+      run_bench(&bench, "load-objects", corpora[j].name, filename, "objects", bench_load_objects);
+      run_bench(&bench, "inflate", corpora[j].name, filename, "streams", bench_inflate);
+      run_bench(&bench, "copy-pages", corpora[j].name, filename, "pages", bench_copy_pages);
+    }
+
+    bench.password = NULL;
+  }
+
+  // Then benchmark any named files...
+  for (i = 1; i < argc; i ++)
+  {
+    if (!strcmp(argv[i], "--iterations") || !strcmp(argv[i], "--output") || !strcmp(argv[i], "--password") || !strcmp(argv[i], "--scratch"))
+    {
+      i ++;
+
+      if (!strcmp(argv[i - 1], "--password"))
+        bench.password = argv[i];
+    }
+    else if (argv[i][0] != '-')
+    {
+      run_bench(&bench, "open", "file", argv[i], "objects", bench_open);
+      run_bench(&bench, "load-objects", "file", argv[i], "objects", bench_load_objects);
+      run_bench(&bench, "inflate", "file", argv[i], "pages", bench_inflate);
+      run_bench(&bench, "copy-pages", "file", argv[i], "pages", bench_copy_pages);
+    }
+  }
+
+  // Write the results trailer...
+  fputs(bench.count ? "\n  ],\n" : "],\n", bench.fp);
+  fprintf(bench.fp, "  \"failures\": %d,\n", bench.failures);
+  // The peak RSS is a process-wide high-water mark so it is only reported for the whole run...
+  fprintf(bench.fp, "  \"peak_rss_kb\": %.0f\n", get_peak_rss());
+  fputs("}\n", bench.fp);
+
+  if (bench.fp != stdout)
+    fclose(bench.fp);
+
+  free(bench.times);
+
+  return (bench.failures ? 1 : 0);
+}
+
+
+//
+// 'bench_copy_pages()' - Copy all of the pages in a PDF file to a new file.
+//
+
+static bool				// O - `true` on success, `false` on failure
+bench_copy_pages(bench_t    *bench,	// I - Benchmark context
+                 const char *filename,	// I - PDF filename
+                 size_t     *items,	// O - Number of pages
+                 size_t     *bytes)	// O - Number of bytes written
+{
+  pdfio_file_t	*inpdf,			// Input PDF file
+		*outpdf;		// Output PDF file
+  size_t	i,			// Looping var
+		num_pages;		// Number of pages
+  char		outname[1024];		// Output filename
+  bool		ret = true;		// Return value
+
+
+  if ((inpdf = open_file(bench, filename)) == NULL)
+    return (false);
+
+  snprintf(outname, sizeof(outname), "%s/pdfiobench-copy.pdf", bench->scratch);
+
+  if ((outpdf = pdfioFileCreate(outname, NULL, NULL, NULL, error_cb, NULL)) == NULL)
+  {
+    pdfioFileClose(inpdf);
+    return (false);
+  }
+
+  for (i = 0, num_pages = pdfioFileGetNumPages(inpdf); i < num_pages && ret; i ++)
+    ret = pdfioPageCopy(outpdf, pdfioFileGetPage(inpdf, i));
+
+  if (!pdfioFileClose(outpdf))
+    ret = false;
+
+  pdfioFileClose(inpdf);
+
+  *items = num_pages;
+  *bytes = get_size(outname);
+
+  remove(outname);
+
+  return (ret);
+}
+
+
+//
+// 'bench_inflate()' - Read and decode all of the Flate and unfiltered streams.
+//
+
+static bool				// O - `true` on success, `false` on failure
+bench_inflate(bench_t    *bench,	// I - Benchmark context
+              const char *filename,	// I - PDF filename
+              size_t     *items,	// O - Number of streams
+              size_t     *bytes)	// O - Number of bytes decoded
+{
+  pdfio_file_t	*pdf;			// PDF file
+  pdfio_obj_t	*obj;			// Current object
+  pdfio_dict_t	*dict;			// Object dictionary
+  pdfio_stream_t *st;			// Current stream
+  size_t	i,			// Looping var
+		num_objs;		// Number of objects
+  const char	*filter;		// Stream filter
+  ssize_t	bytes_read;		// Bytes read
+  char		buffer[65536];		// Read buffer
+  bool		ret = true;		// Return value
+
+
+  if ((pdf = open_file(bench, filename)) == NULL)
+    return (false);
+
+  *items = 0;
+  *bytes = 0;
+
+  for (i = 0, num_objs = pdfioFileGetNumObjs(pdf); i < num_objs; i ++)
+  {
+    // Skip non-stream objects and streams using filters other than Flate
+    // (JPEG, etc.)
+    if ((obj = pdfioFileGetObj(pdf, i)) == NULL || pdfioObjGetLength(obj) == 0)
+      continue;
+
+    dict = pdfioObjGetDict(obj);
+
+    if (pdfioDictGetType(dict, "Filter") == PDFIO_VALTYPE_ARRAY || ((filter = pdfioDictGetName(dict, "Filter")) != NULL && strcmp(filter, "FlateDecode")))
+      continue;
+
+    if ((st = pdfioObjOpenStream(obj, true)) == NULL)
+    {
+      ret = false;
+      break;
+    }
+
+    while ((bytes_read = pdfioStreamRead(st, buffer, sizeof(buffer))) > 0)
+      *bytes += (size_t)bytes_read;
+
+    pdfioStreamClose(st);
+
+    (*items) ++;
+  }
+
+  pdfioFileClose(pdf);
+
+  return (ret);
+}
+
+
+//
+// 'bench_load_objects()' - Load every object in a PDF file.
+//
+
+static bool				// O - `true` on success, `false` on failure
+bench_load_objects(
+    bench_t    *bench,			// I - Benchmark context
+    const char *filename,		// I - PDF filename
+    size_t     *items,			// O - Number of objects
+    size_t     *bytes)			// O - Size of file
+{
+  pdfio_file_t	*pdf;			// PDF file
+  size_t	i,			// Looping var
+		num_objs;		// Number of objects
+
+
+  if ((pdf = open_file(bench, filename)) == NULL)
+    return (false);
+
+  for (i = 0, num_objs = pdfioFileGetNumObjs(pdf); i < num_objs; i ++)
+    pdfioObjGetType(pdfioFileGetObj(pdf, i));
+
+  pdfioFileClose(pdf);
+
+  *items = num_objs;
+  *bytes = get_size(filename);
+
+  return (true);
+}
+
+
+//
+// 'bench_open()' - Open and close a PDF file.
+//
+
+static bool				// O - `true` on success, `false` on failure
+bench_open(bench_t    *bench,		// I - Benchmark context
+           const char *filename,	// I - PDF filename
+           size_t     *items,		// O - Number of objects
+           size_t     *bytes)		// O - Size of file
+{
+  pdfio_file_t	*pdf;			// PDF file
+
+
+  if ((pdf = open_file(bench, filename)) == NULL)
+    return (false);
+
+  *items = pdfioFileGetNumObjs(pdf);
+  *bytes = get_size(filename);
+
+  pdfioFileClose(pdf);
+
+  return (true);
+}
+
+
+//
+// 'compare_times()' - Compare two times.
+//
+
+static int				// O - Result of comparison
+compare_times(const double *a,		// I - First time
+              const double *b)		// I - Second time
+{
+  if (*a < *b)
+    return (-1);
+  else if (*a > *b)
+    return (1);
+  else
+    return (0);
+}
+
+
+//
+// 'create_cjk_text()' - Create a file with pages of Japanese text.
+//
+
+static bool				// O - `true` on success, `false` on failure
+create_cjk_text(const char *filename,	// I - PDF filename
+                size_t     count,	// I - Number of pages
+                size_t     *items,	// O - Number of pages
+                size_t     *bytes)	// O - Size of file
+{
+  pdfio_file_t	*pdf;			// PDF file
+  pdfio_obj_t	*font;			// Font object
+  size_t	i;			// Looping var
+  size_t	textbytes = 0;		// Bytes of text
+  bool		ret = true;		// Return value
+
+
+  if ((pdf = pdfioFileCreate(filename, NULL, NULL, NULL, error_cb, NULL)) == NULL)
+    return (false);
+
+  if ((font = pdfioFileCreateFontObjFromFile(pdf, "testfiles/NotoSansJP-Regular.otf", true)) == NULL)
+  {
+    pdfioFileClose(pdf);
+    return (false);
+  }
+
+  for (i = 0; i < count && ret; i ++)
+    ret = write_page(pdf, font, true, "日本語のテキストを表示するためのベンチマークです。漢字、ひらがな、カタカナ。", 50, NULL, &textbytes);
+
+  if (!pdfioFileClose(pdf))
+    ret = false;
+
+  *items = count;
+  *bytes = get_size(filename);
+
+  return (ret);
+}
+
+
+//
+// 'create_encrypted()' - Create an encrypted file with pages of text.
+//
+// AES-256 encryption is not yet supported for writing, so this uses AES-128.
+//
+
+static bool				// O - `true` on success, `false` on failure
+create_encrypted(const char *filename,	// I - PDF filename
+                 size_t     count,	// I - Number of pages
+                 size_t     *items,	// O - Number of pages
+                 size_t     *bytes)	// O - Size of file
+{
+  pdfio_file_t	*pdf;			// PDF file
+  pdfio_obj_t	*font;			// Font object
+  size_t	i;			// Looping var
+  size_t	textbytes = 0;		// Bytes of text
+  bool		ret = true;		// Return value
+
+
+  if ((pdf = pdfioFileCreate(filename, NULL, NULL, NULL, error_cb, NULL)) == NULL)
+    return (false);
+
+  if (!pdfioFileSetPermissions(pdf, PDFIO_PERMISSION_ALL, PDFIO_ENCRYPTION_AES_128, NULL, bench_password) || (font = pdfioFileCreateFontObjFromBase(pdf, "Helvetica")) == NULL)
+  {
+    pdfioFileClose(pdf);
+    return (false);
+  }
+
+  for (i = 0; i < count && ret; i ++)
+    ret = write_page(pdf, font, false, "The quick brown fox jumps over the lazy dog, 0123456789 times.", 50, NULL, &textbytes);
+
+  if (!pdfioFileClose(pdf))
+    ret = false;
+
+  *items = count;
+  *bytes = get_size(filename);
+
+  return (ret);
+}
+
+
+//
+// 'create_images()' - Create a file with pages of generated RGB images.
+//
+
+static bool				// O - `true` on success, `false` on failure
+create_images(const char *filename,	// I - PDF filename
+              size_t     count,		// I - Number of images
+              size_t     *items,	// O - Number of images
+              size_t     *bytes)	// O - Number of pixel bytes
+{
+  pdfio_file_t	*pdf;			// PDF file
+  pdfio_obj_t	*image;			// Image object
+  pdfio_dict_t	*dict;			// Page dictionary
+  pdfio_stream_t *st;			// Page stream
+  unsigned char	*pixels,		// Image pixels
+		*pixptr;		// Pointer into pixels
+  size_t	i,			// Looping var
+		x, y;			// Current position
+  unsigned	seed;			// Noise seed
+  bool		ret = true;		// Return value
+  const size_t	width = 512,		// Width of images
+		height = 512;		// Height of images
+
+
+  if ((pixels = (unsigned char *)malloc(width * height * 3)) == NULL)
+    return (false);
+
+  if ((pdf = pdfioFileCreate(filename, NULL, NULL, NULL, error_cb, NULL)) == NULL)
+  {
+    free(pixels);
+    return (false);
+  }
+
+  for (i = 0; i < count && ret; i ++)
+  {
+    // Generate a gradient with some noise so each image is different and
+    // doesn't compress too well...
+    for (y = 0, pixptr = pixels, seed = (unsigned)i + 1; y < height; y ++)
+    {
+      for (x = 0; x < width; x ++, pixptr += 3)
+      {
+        seed      = seed * 1103515245 + 12345;
+        pixptr[0] = (unsigned char)(x / 2 + (seed >> 28));
+        pixptr[1] = (unsigned char)(y / 2 + ((seed >> 24) & 15));
+        pixptr[2] = (unsigned char)(i * 16 + x + y);
+      }
+    }
+
+    if ((image = pdfioFileCreateImageObjFromData(pdf, pixels, width, height, 3, NULL, false, false)) == NULL || (dict = pdfioDictCreate(pdf)) == NULL || !pdfioPageDictAddImage(dict, "IM1", image) || (st = pdfioFileCreatePage(pdf, dict)) == NULL)
+    {
+      ret = false;
+      break;
+    }
+
+    if (!pdfioContentDrawImage(st, "IM1", 36.0, 36.0, 540.0, 540.0))
+      ret = false;
+
+    if (!pdfioStreamClose(st))
+      ret = false;
+  }
+
+  if (!pdfioFileClose(pdf))
+    ret = false;
+
+  free(pixels);
+
+  *items = count;
+  *bytes = count * width * height * 3;
+
+  return (ret);
+}
+
+
+//
+// 'create_many_objects()' - Create a file with many small objects.
+//
+
+static bool				// O - `true` on success, `false` on failure
+create_many_objects(
+    const char *filename,		// I - PDF filename
+    size_t     count,			// I - Number of objects
+    size_t     *items,			// O - Number of objects
+    size_t     *bytes)			// O - Size of file
+{
+  pdfio_file_t	*pdf;			// PDF file
+  pdfio_obj_t	*font,			// Font object
+		*obj;			// Current object
+  pdfio_dict_t	*dict;			// Object dictionary
+  pdfio_array_t	*array;			// Object array
+  size_t	i;			// Looping var
+  size_t	textbytes = 0;		// Bytes of text
+  char		name[64];		// Object name
+  bool		ret = true;		// Return value
+
+
+  if ((pdf = pdfioFileCreate(filename, NULL, NULL, NULL, error_cb, NULL)) == NULL)
+    return (false);
+
+  if (!pdfioFileSetOptions(pdf, PDFIO_OPTION_OBJSTREAMS) || (font = pdfioFileCreateFontObjFromBase(pdf, "Helvetica")) == NULL)
+  {
+    pdfioFileClose(pdf);
+    return (false);
+  }
+
+  for (i = 0; i < count && ret; i ++)
+  {
+    snprintf(name, sizeof(name), "Object %lu", (unsigned long)(i + 1));
+
+    if ((dict = pdfioDictCreate(pdf)) == NULL || (array = pdfioArrayCreate(pdf)) == NULL)
+    {
+      ret = false;
+      break;
+    }
+
+    pdfioDictSetName(dict, "Type", "Benchmark");
+    pdfioDictSetString(dict, "Title", pdfioStringCreate(pdf, name));
+    pdfioDictSetNumber(dict, "Index", (double)i);
+    pdfioArrayAppendNumber(array, 0.5 * (double)i);
+    pdfioArrayAppendBoolean(array, (i & 1) != 0);
+    pdfioArrayAppendName(array, "Value");
+    pdfioDictSetArray(dict, "Values", array);
+
+    if ((obj = pdfioFileCreateObj(pdf, dict)) == NULL || !pdfioObjClose(obj))
+      ret = false;
+  }
+
+  if (ret)
+    ret = write_page(pdf, font, false, "Many objects", 1, NULL, &textbytes);
+
+  if (!pdfioFileClose(pdf))
+    ret = false;
+
+  *items = count;
+  *bytes = get_size(filename);
+
+  return (ret);
+}
+
+
+//
+// 'create_many_pages()' - Create a file with many pages of text.
+//
+
+static bool				// O - `true` on success, `false` on failure
+create_many_pages(const char *filename,	// I - PDF filename
+                  size_t     count,	// I - Number of pages
+                  size_t     *items,	// O - Number of pages
+                  size_t     *bytes)	// O - Size of file
+{
+  pdfio_file_t	*pdf;			// PDF file
+  pdfio_obj_t	*font;			// Font object
+  size_t	i;			// Looping var
+  size_t	textbytes = 0;		// Bytes of text
+  bool		ret = true;		// Return value
+
+
+  if ((pdf = pdfioFileCreate(filename, NULL, NULL, NULL, error_cb, NULL)) == NULL)
+    return (false);
+
+  if ((font = pdfioFileCreateFontObjFromBase(pdf, "Helvetica")) == NULL)
+  {
+    pdfioFileClose(pdf);
+    return (false);
+  }
+
+  for (i = 0; i < count && ret; i ++)
+    ret = write_page(pdf, font, false, "The quick brown fox jumps over the lazy dog, 0123456789 times.", 50, NULL, &textbytes);
+
+  if (!pdfioFileClose(pdf))
+    ret = false;
+
+  *items = count;
+  *bytes = get_size(filename);
+
+  return (ret);
+}
+
+
+//
+// 'create_text_show()' - Create a file with many text strings on a few pages.
+//
+
+static bool				// O - `true` on success, `false` on failure
+create_text_show(const char *filename,	// I - PDF filename
+                 size_t     count,	// I - Number of strings
+                 size_t     *items,	// O - Number of strings
+                 size_t     *bytes)	// O - Bytes of text
+{
+  pdfio_file_t	*pdf;			// PDF file
+  pdfio_obj_t	*font;			// Font object
+  size_t	lines;			// Number of lines remaining
+  bool		ret = true;		// Return value
+
+
+  if ((pdf = pdfioFileCreate(filename, NULL, NULL, NULL, error_cb, NULL)) == NULL)
+    return (false);
+
+  if ((font = pdfioFileCreateFontObjFromFile(pdf, "testfiles/OpenSans-Regular.ttf", true)) == NULL)
+  {
+    pdfioFileClose(pdf);
+    return (false);
+  }
+
+  *items = 0;
+  *bytes = 0;
+
+  for (lines = count; lines > 0 && ret; lines -= lines > 1000 ? 1000 : lines)
+    ret = write_page(pdf, font, true, "Unicode text with accents: àéîõü, and symbols: €£¥©®™.", lines > 1000 ? 1000 : lines, items, bytes);
+
+  if (!pdfioFileClose(pdf))
+    ret = false;
+
+  return (ret);
+}
+
+
+//
+// 'error_cb()' - Display an error message.
+//
+
+static bool				// O - `true` to stop, `false` to continue
+error_cb(pdfio_file_t *pdf,		// I - PDF file
+         const char   *message,		// I - Error message
+         void         *data)		// I - Callback data (unused)
+{
+  (void)data;
+
+  fprintf(stderr, "pdfiobench: %s: %s\n", pdfioFileGetName(pdf), message);
+
+  return (false);
+}
+
+
+//
+// 'get_peak_rss()' - Get the peak resident set size of the process in kilobytes.
+//
+
+static double				// O - Peak RSS in kilobytes
+get_peak_rss(void)
+{
+#ifdef _WIN32
+  PROCESS_MEMORY_COUNTERS pmc;		// Process memory counters
+
+
+  if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)))
+    return ((double)pmc.PeakWorkingSetSize / 1024.0);
+  else
+    return (0.0);
+
+#else
+  struct rusage	usage;			// Resource usage
+
+
+  if (getrusage(RUSAGE_SELF, &usage))
+    return (0.0);
+
+#  ifdef __APPLE__
+  return ((double)usage.ru_maxrss / 1024.0);
+#  else
+  return ((double)usage.ru_maxrss);
+#  endif // __APPLE__
+#endif // _WIN32
+}
+
+
+//
+// 'get_size()' - Get the size of a file.
+//
+
+static size_t				// O - Size in bytes
+get_size(const char *filename)		// I - Filename
+{
+  struct stat	fileinfo;		// File information
+
+
+  if (stat(filename, &fileinfo))
+    return (0);
+  else
+    return ((size_t)fileinfo.st_size);
+}
+
+
+//
+// 'get_time()' - Get the current monotonic time in seconds.
+//
+
+static double				// O - Time in seconds
+get_time(void)
+{
+#ifdef _WIN32
+  LARGE_INTEGER	freq,			// Counter frequency
+		count;			// Counter value
+
+
+  QueryPerformanceFrequency(&freq);
+  QueryPerformanceCounter(&count);
+
+  return ((double)count.QuadPart / (double)freq.QuadPart);
+
+#else
+  struct timespec curtime;		// Current time
+
+
+  clock_gettime(CLOCK_MONOTONIC, &curtime);
+
+  return ((double)curtime.tv_sec + 0.000000001 * curtime.tv_nsec);
+#endif // _WIN32
+}
+
+
+//
+// 'open_file()' - Open a PDF file for a benchmark.
+//
+
+static pdfio_file_t *			// O - PDF file or `NULL` on error
+open_file(bench_t    *bench,		// I - Benchmark context
+          const char *filename)		// I - PDF filename
+{
+  return (pdfioFileOpen(filename, password_cb, (void *)bench->password, error_cb, NULL));
+}
+
+
+//
+// 'password_cb()' - Return the password for a PDF file.
+//
+
+static const char *			// O - Password
+password_cb(void       *data,		// I - Password
+            const char *filename)	// I - Filename (unused)
+{
+  (void)filename;
+
+  return ((const char *)data);
+}
+
+
+//
+// 'run_bench()' - Run a benchmark and write the results.
+//
+
+static void
+run_bench(bench_t    *bench,		// I - Benchmark context
+          const char *name,		// I - Benchmark name
+          const char *corpus,		// I - Corpus name
+          const char *filename,		// I - PDF filename
+          const char *item_unit,	// I - Unit for items
+          bench_cb_t cb)		// I - Benchmark callback
+{
+  size_t	i,			// Looping var
+		n,			// Number of iterations
+		items = 0,		// Number of items per iteration
+		bytes = 0;		// Number of bytes per iteration
+  double	start,			// Start time
+		total = 0.0;		// Total time
+  bool		ok = true;		// Did all iterations succeed?
+
+
+  fprintf(stderr, "pdfiobench: %s %s (%s)...\n", name, corpus, filename);
+
+  for (i = 0, n = bench->iterations; i < n; i ++)
+  {
+    start = get_time();
+    ok    = (cb)(bench, filename, &items, &bytes);
+
+    bench->times[i] = get_time() - start;
+    total += bench->times[i];
+
+    if (!ok)
+    {
+      n = i;
+      break;
+    }
+  }
+
+  write_result(bench, name, corpus, filename, item_unit, n, total, items, bytes, ok);
+}
+
+
+//
+// 'run_create()' - Benchmark the creation of a synthetic corpus.
+//
+
+static void
+run_create(bench_t        *bench,	// I - Benchmark context
+           const corpus_t *corpus,	// I - Corpus
+           const char     *filename,	// I - PDF filename
+           bool           quick)	// I - Use smaller corpus?
+{
+  size_t	i,			// Looping var
+		n,			// Number of iterations
+		count,			// Number of items to create
+		items = 0,		// Number of items created
+		bytes = 0;		// Number of bytes created
+  double	start,			// Start time
+		total = 0.0;		// Total time
+  bool		ok = true;		// Did all iterations succeed?
+
+
+  fprintf(stderr, "pdfiobench: create %s (%s)...\n", corpus->name, filename);
+
+  count = quick ? corpus->quick_count : corpus->count;
+
+  for (i = 0, n = bench->iterations; i < n; i ++)
+  {
+    start = get_time();
+    ok    = (corpus->create_cb)(filename, count, &items, &bytes);
+
+    bench->times[i] = get_time() - start;
+    total += bench->times[i];
+
+    if (!ok)
+    {
+      n = i;
+      break;
+    }
+  }
+
+  write_result(bench, "create", corpus->name, filename, corpus->item_unit, n, total, items, bytes, ok);
+}
+
+
+//
+// 'usage()' - Show program usage.
+//
+
+static int				// O - Exit status
+usage(FILE *fp)				// I - Output file
+{
+  fputs("Usage: ./pdfiobench [OPTIONS] [FILENAME ...]\n", fp);
+  fputs("Options:\n", fp);
+  fputs("  --help                Show program help.\n", fp);
+  fputs("  --iterations N        Run each benchmark N times (default 10).\n", fp);
+  fputs("  --no-synthetic        Only benchmark the named files.\n", fp);
+  fputs("  --output FILENAME     Write JSON results to FILENAME (default stdout).\n", fp);
+  fputs("  --password PASSWORD   Password for the named files.\n", fp);
+  fputs("  --quick               Use smaller synthetic files.\n", fp);
+  fputs("  --scratch DIRECTORY   Directory for generated files (default \".\").\n", fp);
+
+  return (fp == stderr);
+}
+
+
+//
+// 'write_page()' - Write a page of text.
+//
+
+static bool				// O - `true` on success, `false` on failure
+write_page(pdfio_file_t *pdf,		// I - PDF file
+           pdfio_obj_t  *font,		// I - Font object
+           bool         unicode,	// I - Unicode text?
+           const char   *text,		// I - Text string
+           size_t       lines,		// I - Number of times to show the text
+           size_t       *items,		// IO - Number of strings shown or `NULL`
+           size_t       *bytes)		// IO - Bytes of text shown
+{
+  pdfio_dict_t	*dict;			// Page dictionary
+  pdfio_stream_t *st;			// Page stream
+  size_t	i;			// Looping var
+  size_t	textlen = strlen(text);	// Length of text
+  bool		ret = true;		// Return value
+
+
+  if ((dict = pdfioDictCreate(pdf)) == NULL || !pdfioPageDictAddFont(dict, "F1", font) || (st = pdfioFileCreatePage(pdf, dict)) == NULL)
+    return (false);
+
+  if (!pdfioContentTextBegin(st) || !pdfioContentSetTextFont(st, "F1", 10.0) || !pdfioContentSetTextLeading(st, 14.0) || !pdfioContentTextMoveTo(st, 36.0, 756.0))
+    ret = false;
+
+  for (i = 0; i < lines && ret; i ++)
+  {
+    if (!pdfioContentTextShow(st, unicode, text) || !pdfioContentTextNextLine(st))
+      ret = false;
+
+    *bytes += textlen;
+  }
+
+  if (items)
+    *items += i;
+
+  if (!pdfioContentTextEnd(st))
+    ret = false;
+
+  if (!pdfioStreamClose(st))
+    ret = false;
+
+  return (ret);
+}
+
+
+//
+// 'write_result()' - Write the results of a benchmark.
+//
+
+static void
+write_result(bench_t    *bench,		// I - Benchmark context
+             const char *name,		// I - Benchmark name
+             const char *corpus,	// I - Corpus name
+             const char *filename,	// I - PDF filename
+             const char *item_unit,	// I - Unit for items
+             size_t     n,		// I - Number of successful iterations
+             double     total,		// I - Total time in seconds
+             size_t     items,		// I - Number of items per iteration
+             size_t     bytes,		// I - Number of bytes per iteration
+             bool       ok)		// I - Did all iterations succeed?
+{
+  fputs(bench->count ? ",\n    {\n" : "\n    {\n", bench->fp);
+  fputs("      \"name\": ", bench->fp);
+  write_string(bench->fp, name);
+  fputs(",\n      \"corpus\": ", bench->fp);
+  write_string(bench->fp, corpus);
+  fputs(",\n      \"file\": ", bench->fp);
+  write_string(bench->fp, filename);
+  fprintf(bench->fp, ",\n      \"success\": %s,\n", ok ? "true" : "false");
+  fprintf(bench->fp, "      \"iterations\": %lu", (unsigned long)n);
+
+  if (n > 0)
+  {
+    // Report latency percentiles using the nearest-rank method...
+    qsort(bench->times, n, sizeof(double), (int (*)(const void *, const void *))compare_times);
+
+    fprintf(bench->fp, ",\n      \"items\": %lu,\n", (unsigned long)items);
+    fputs("      \"item_unit\": ", bench->fp);
+    write_string(bench->fp, item_unit);
+    fprintf(bench->fp, ",\n      \"bytes\": %lu,\n", (unsigned long)bytes);
+    fprintf(bench->fp, "      \"seconds\": { \"min\": %.6f, \"mean\": %.6f, \"p50\": %.6f, \"p90\": %.6f, \"p99\": %.6f, \"max\": %.6f },\n", bench->times[0], total / n, bench->times[(size_t)ceil(0.50 * n) - 1], bench->times[(size_t)ceil(0.90 * n) - 1], bench->times[(size_t)ceil(0.99 * n) - 1], bench->times[n - 1]);
+    fprintf(bench->fp, "      \"items_per_second\": %.1f,\n", total > 0.0 ? items * n / total : 0.0);
+    fprintf(bench->fp, "      \"bytes_per_second\": %.1f", total > 0.0 ? bytes * n / total : 0.0);
+  }
+
+  fputs("\n    }", bench->fp);
+  fflush(bench->fp);
+
+  bench->count ++;
+
+  if (!ok)
+    bench->failures ++;
+}
+
+
+//
+// 'write_string()' - Write a JSON string.
+//
+
+static void
+write_string(FILE       *fp,		// I - Output file
+             const char *s)		// I - String
+{
+  putc('\"', fp);
+
+  for (; *s; s ++)
+  {
+    if (*s == '\"' || *s == '\\')
+      fprintf(fp, "\\%c", *s);
+    else if ((*s & 255) < ' ')
+      fprintf(fp, "\\u%04x", *s & 255);
+    else
+      putc(*s, fp);
+  }
+
+  putc('\"', fp);
+}
@@ -17,39 +17,148 @@
 #include "pdfio-content.h"
 #include <math.h>
 #include <locale.h>
+#include <sys/stat.h>
+#ifdef __APPLE__
+#  include <malloc/malloc.h>
+#elif defined(__GLIBC__)
+#  include <malloc.h>
+#endif // __APPLE__
 #ifndef M_PI
 #  define M_PI	3.14159265358979323846264338327950288
 #endif // M_PI
 
 
+//
+// Local types...
+//
+
+typedef struct codec_data_s		// Compression callback data
+{
+  size_t	deflates,		// Number of compression calls
+		inflates;		// Number of decompression calls
+} codec_data_t;
+
+typedef struct concurrent_data_s	// Concurrent read thread data
+{
+  pdfio_file_t	*pdf;			// PDF file
+  size_t	first,			// First page to read
+		step;			// Page increment
+  const uint32_t *hashes;		// Expected page hashes
+  bool		passed;			// Did all pages match?
+} concurrent_data_t;
+
+typedef struct image_data_s		// Image callback data
+{
+  size_t	num_colors;		// Number of colors
+  bool		alpha;			// Include alpha values?
+  size_t	lines;			// Number of lines provided
+} image_data_t;
+
+typedef struct io_data_s		// Input callback data
+{
+  unsigned char	*data;			// File data
+  size_t	datalen;		// Length of file data
+  size_t	reads,			// Number of reads
+		bytes;			// Number of bytes read
+} io_data_t;
+
+typedef struct object_key_data_s	// Object key callback data
+{
+  pdfio_file_t	*pdf;			// PDF file
+  const size_t	*numbers;		// Object numbers
+  size_t	num_numbers,		// Number of objects
+		first,			// First object to read
+		passes;			// Number of passes over the objects
+  bool		passed;			// Did all objects match?
+} object_key_data_t;
+
+typedef struct scan_data_s		// Content scanner callback data
+{
+  size_t	count,			// Number of operators
+		bad;			// Number of unexpected operators
+  char		transcript[1024];	// Transcript of first operators
+} scan_data_t;
+
+typedef struct span_data_s		// Span callback data
+{
+  size_t	begins[PDFIO_SPAN_CRYPTO + 1],
+					// Number of begin calls for each span
+		ends[PDFIO_SPAN_CRYPTO + 1];
+					// Number of end calls for each span
+  bool		unbalanced;		// End without a matching begin?
+} span_data_t;
+
+
 //
 // Local functions...
 //
 
+static ssize_t	codec_deflate_cb(codec_data_t *data, int level, const void *src, size_t srclen, void *dst, size_t dstsize);
+static ssize_t	codec_inflate_cb(codec_data_t *data, const void *src, size_t srclen, void *dst, size_t dstsize);
+#ifdef _WIN32
+static DWORD WINAPI concurrent_cb(concurrent_data_t *data);
+#else
+static void	*concurrent_cb(concurrent_data_t *data);
+#endif // _WIN32
 static int	do_crypto_tests(void);
+static int	do_crypto_vector_tests(const char *path);
+static int	do_number_tests(void);
+static int	do_scan_tests(void);
 static int	do_test_file(const char *filename, int objnum, const char *password, bool verbose);
 static int	do_unit_tests(void);
 static int	draw_image(pdfio_stream_t *st, const char *name, double x, double y, double w, double h, const char *label);
 static bool	error_cb(pdfio_file_t *pdf, const char *message, bool *error);
+static size_t	get_heap_bytes(void);
+static bool	hash_page(pdfio_obj_t *page, uint32_t *hash);
+static bool	image_cb(image_data_t *data, size_t y, unsigned char *line, size_t linelen);
+static ssize_t	input_cb(io_data_t *io, off_t offset, void *buffer, size_t bytes);
 static bool	iterate_cb(pdfio_dict_t *dict, const char *key, void *cb_data);
+static ssize_t	number_printf(pdfio_file_t *pdf, char *buffer, size_t bufsize, const char *format, ...);
+#ifdef _WIN32
+static DWORD WINAPI object_key_cb(object_key_data_t *data);
+#else
+static void	*object_key_cb(object_key_data_t *data);
+#endif // _WIN32
 static ssize_t	output_cb(int *fd, const void *buffer, size_t bytes);
 static const char *password_cb(void *data, const char *filename);
+static int	read_cached_file(const char *filename);
+static int	read_codec_file(const char *filename);
+static int	read_concurrent_file(const char *filename);
+static int	read_io_file(const char *filename);
+static int	read_linearized_file(const char *filename, size_t num_pages, size_t *first_image);
+static int	read_objstms_file(const char *filename);
+static int	read_sparse_file(void);
+static int	read_stats_file(const char *filename);
 static int	read_unit_file(const char *filename, size_t num_pages, size_t first_image, bool is_output);
+static bool	scan_cb(scan_data_t *data, const char *op, size_t num_operands, const pdfio_operand_t *operands);
+static void	span_cb(pdfio_file_t *pdf, pdfio_span_t span, bool begin, span_data_t *data);
 static ssize_t	token_consume_cb(const char **s, size_t bytes);
 static ssize_t	token_peek_cb(const char **s, char *buffer, size_t bytes);
 static int	usage(FILE *fp);
 static int	verify_image(pdfio_file_t *pdf, size_t number);
+static bool	verify_page_tree(pdfio_file_t *pdf, pdfio_obj_t *node, size_t fanout, size_t depth, size_t *leaf_depth, size_t *count);
 static int	write_alpha_test(pdfio_file_t *pdf, int number, pdfio_obj_t *font);
 static int	write_color_patch(pdfio_stream_t *st, bool device);
 static int	write_color_test(pdfio_file_t *pdf, int number, pdfio_obj_t *font);
 static int	write_font_test(pdfio_file_t *pdf, int number, pdfio_obj_t *font, const char *textfontfile, bool unicode);
 static int	write_header_footer(pdfio_stream_t *st, const char *title, int number);
+static int	write_image_callback_file(const char *filename, pdfio_encryption_t encryption, pdfio_option_t options);
+static int	write_image_memory_file(const char *filename);
 static pdfio_obj_t *write_image_object(pdfio_file_t *pdf, _pdfio_predictor_t predictor);
 static int	write_images_test(pdfio_file_t *pdf, int number, pdfio_obj_t *font);
 static int	write_jpeg_test(pdfio_file_t *pdf, const char *title, int number, pdfio_obj_t *font, pdfio_obj_t *image);
+static int	write_object_key_file(const char *filename, pdfio_encryption_t encryption);
+static int	write_objstms_file(const char *filename, size_t num_pages);
+static int	write_page_tree_file(const char *filename, size_t fanout, pdfio_option_t options);
+static int	write_paragraph_file(const char *filename);
+static int	write_path_file(const char *filename);
 static int	write_png_test(pdfio_file_t *pdf, int number, pdfio_obj_t *font);
+static void	write_predictor_row(unsigned char *row, const unsigned char *prev, size_t y, size_t len, size_t bpp, unsigned *seed);
+static int	write_predictor_file(const char *filename);
+static int	write_streaming_file(const char *filename, size_t num_pages);
 static int	write_text_test(pdfio_file_t *pdf, int first_page, pdfio_obj_t *font, const char *filename);
 static int	write_unit_file(pdfio_file_t *inpdf, const char *outname, pdfio_file_t *outpdf, size_t *num_pages, size_t *first_image);
+static int	write_update_file(const char *srcname, const char *filename, size_t num_pages, size_t first_image);
 
 
 //
@@ -128,6 +237,91 @@ main(int  argc,				// I - Number of command-line arguments
 }
 
 
+//
+// 'codec_deflate_cb()' - Compress data using the ZLIB compress2 function.
+//
+
+static ssize_t				// O - Number of bytes, `0` if buffer too small, or `-1` on error
+codec_deflate_cb(codec_data_t *data,	// I - Callback data
+                 int          level,	// I - Compression level
+                 const void   *src,	// I - Uncompressed data
+                 size_t       srclen,	// I - Length of uncompressed data
+                 void         *dst,	// I - Compressed data buffer
+                 size_t       dstsize)	// I - Size of compressed data buffer
+{
+  uLongf	dstlen = (uLongf)dstsize;// Length of compressed data
+  int		status;			// Compression status
+
+
+  data->deflates ++;
+
+  if ((status = compress2((Bytef *)dst, &dstlen, (const Bytef *)src, (uLong)srclen, level)) == Z_BUF_ERROR)
+    return (0);
+  else if (status != Z_OK)
+    return (-1);
+  else
+    return ((ssize_t)dstlen);
+}
+
+
+//
+// 'codec_inflate_cb()' - Decompress data using the ZLIB uncompress function.
+//
+
+static ssize_t				// O - Number of bytes, `0` if buffer too small, or `-1` on error
+codec_inflate_cb(codec_data_t *data,	// I - Callback data
+                 const void   *src,	// I - Compressed data
+                 size_t       srclen,	// I - Length of compressed data
+                 void         *dst,	// I - Decompressed data buffer
+                 size_t       dstsize)	// I - Size of decompressed data buffer
+{
+  uLongf	dstlen = (uLongf)dstsize;// Length of decompressed data
+  int		status;			// Decompression status
+
+
+  data->inflates ++;
+
+  if ((status = uncompress((Bytef *)dst, &dstlen, (const Bytef *)src, (uLong)srclen)) == Z_BUF_ERROR)
+    return (0);
+  else if (status != Z_OK)
+    return (-1);
+  else
+    return ((ssize_t)dstlen);
+}
+
+
+//
+// 'concurrent_cb()' - Read pages from a PDF file in a separate thread.
+//
+
+#ifdef _WIN32
+static DWORD WINAPI			// O - Exit status
+#else
+static void *				// O - Exit status
+#endif // _WIN32
+concurrent_cb(concurrent_data_t *data)	// I - Thread data
+{
+  size_t	i,			// Looping var
+		num_pages = pdfioFileGetNumPages(data->pdf);
+					// Number of pages
+  uint32_t	hash;			// Page hash
+
+
+  data->passed = true;
+
+  for (i = data->first; i < num_pages; i += data->step)
+  {
+    if (!hash_page(pdfioFileGetPage(data->pdf, i), &hash) || hash != data->hashes[i])
+    {
+      data->passed = false;
+      break;
+    }
+  }
+
+  return (0);
+}
+
+
 //
 // 'do_crypto_tests()' - Test the various cryptographic functions in PDFio.
 //
@@ -146,6 +340,7 @@ do_crypto_tests(void)
 	        buffer[256],		// Output buffer
 	        buffer2[256];		// Second output buffer
   const char	*prefix, *suffix;	// Prefix/suffix strings
+  bool		accel;			// Use AES-NI/SHA-NI?
   static const char *text = "Hello, World! Now is the time for all good men to come to the aid of their country.\n";
 					// Test text
   static uint8_t aes128key[] = { 0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6, 0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c };
@@ -367,156 +562,829 @@ do_crypto_tests(void)
     ret = 1;
   }
 
+  // Run the standard test vectors through the default code and then the
+  // portable code, since the default is to use AES-NI/SHA-NI when the CPU has
+  // them...
+  if (do_crypto_vector_tests("default"))
+    ret = 1;
+
+  accel = _pdfioCryptoSetAccel(false);
+
+  if (do_crypto_vector_tests("portable"))
+    ret = 1;
+
+  _pdfioCryptoSetAccel(accel);
+
   return (ret);
 }
 
 
 //
-// 'do_test_file()' - Try loading a PDF file and listing pages and objects.
+// 'do_crypto_vector_tests()' - Test the AES and SHA-256 code with the FIPS-197, SP 800-38A, and FIPS-180 test vectors.
 //
 
 static int				// O - Exit status
-do_test_file(const char *filename,	// I - PDF filename
-             int        objnum,		// I - Object number to dump, if any
-             const char *password,	// I - Password for file
-             bool       verbose)	// I - Be verbose?
+do_crypto_vector_tests(
+    const char *path)			// I - Code path being tested
 {
-  bool		error = false;		// Have we shown an error yet?
-  pdfio_file_t	*pdf;			// PDF file
-  size_t	n,			// Object/page index
-		num_objs,		// Number of objects
-		num_pages;		// Number of pages
-  pdfio_obj_t	*obj;			// Object
-  pdfio_dict_t	*dict;			// Object dictionary
+  int		ret = 0;		// Return value
+  size_t	i, j;			// Looping vars
+  _pdfio_aes_t	aes;			// AES context
+  _pdfio_sha256_t sha256;		// SHA256 context
+  uint8_t	buffer[1000],		// Output buffer
+		buffer2[64];		// Second output buffer
+  static const struct
+  {
+    const char	*name;			// Test name
+    size_t	keylen;			// Key length in bytes
+    uint8_t	key[32],		// Key
+		iv[16];			// Initialization vector
+    size_t	len;			// Length of text in bytes
+    uint8_t	plain[64],		// Plain text
+		cipher[64];		// Cipher text
+  } aes_vectors[] =			// AES test vectors
+  {
+    {
+      "128-bit FIPS-197 C.1",
+      16,
+      { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f },
+      { 0 },
+      16,
+      { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff },
+      { 0x69, 0xc4, 0xe0, 0xd8, 0x6a, 0x7b, 0x04, 0x30, 0xd8, 0xcd, 0xb7, 0x80, 0x70, 0xb4, 0xc5, 0x5a }
+    },
+    {
+      "256-bit FIPS-197 C.3",
+      32,
+      { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f },
+      { 0 },
+      16,
+      { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff },
+      { 0x8e, 0xa2, 0xb7, 0xca, 0x51, 0x67, 0x45, 0xbf, 0xea, 0xfc, 0x49, 0x90, 0x4b, 0x49, 0x60, 0x89 }
+    },
+    {
+      "128-bit SP 800-38A F.2.1",
+      16,
+      { 0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6, 0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c },
+      { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f },
+      64,
+      { 0x6b, 0xc1, 0xbe, 0xe2, 0x2e, 0x40, 0x9f, 0x96, 0xe9, 0x3d, 0x7e, 0x11, 0x73, 0x93, 0x17, 0x2a, 0xae, 0x2d, 0x8a, 0x57, 0x1e, 0x03, 0xac, 0x9c, 0x9e, 0xb7, 0x6f, 0xac, 0x45, 0xaf, 0x8e, 0x51, 0x30, 0xc8, 0x1c, 0x46, 0xa3, 0x5c, 0xe4, 0x11, 0xe5, 0xfb, 0xc1, 0x19, 0x1a, 0x0a, 0x52, 0xef, 0xf6, 0x9f, 0x24, 0x45, 0xdf, 0x4f, 0x9b, 0x17, 0xad, 0x2b, 0x41, 0x7b, 0xe6, 0x6c, 0x37, 0x10 },
+      { 0x76, 0x49, 0xab, 0xac, 0x81, 0x19, 0xb2, 0x46, 0xce, 0xe9, 0x8e, 0x9b, 0x12, 0xe9, 0x19, 0x7d, 0x50, 0x86, 0xcb, 0x9b, 0x50, 0x72, 0x19, 0xee, 0x95, 0xdb, 0x11, 0x3a, 0x91, 0x76, 0x78, 0xb2, 0x73, 0xbe, 0xd6, 0xb8, 0xe3, 0xc1, 0x74, 0x3b, 0x71, 0x16, 0xe6, 0x9e, 0x22, 0x22, 0x95, 0x16, 0x3f, 0xf1, 0xca, 0xa1, 0x68, 0x1f, 0xac, 0x09, 0x12, 0x0e, 0xca, 0x30, 0x75, 0x86, 0xe1, 0xa7 }
+    },
+    {
+      "256-bit SP 800-38A F.2.5",
+      32,
+      { 0x60, 0x3d, 0xeb, 0x10, 0x15, 0xca, 0x71, 0xbe, 0x2b, 0x73, 0xae, 0xf0, 0x85, 0x7d, 0x77, 0x81, 0x1f, 0x35, 0x2c, 0x07, 0x3b, 0x61, 0x08, 0xd7, 0x2d, 0x98, 0x10, 0xa3, 0x09, 0x14, 0xdf, 0xf4 },
+      { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f },
+      64,
+      { 0x6b, 0xc1, 0xbe, 0xe2, 0x2e, 0x40, 0x9f, 0x96, 0xe9, 0x3d, 0x7e, 0x11, 0x73, 0x93, 0x17, 0x2a, 0xae, 0x2d, 0x8a, 0x57, 0x1e, 0x03, 0xac, 0x9c, 0x9e, 0xb7, 0x6f, 0xac, 0x45, 0xaf, 0x8e, 0x51, 0x30, 0xc8, 0x1c, 0x46, 0xa3, 0x5c, 0xe4, 0x11, 0xe5, 0xfb, 0xc1, 0x19, 0x1a, 0x0a, 0x52, 0xef, 0xf6, 0x9f, 0x24, 0x45, 0xdf, 0x4f, 0x9b, 0x17, 0xad, 0x2b, 0x41, 0x7b, 0xe6, 0x6c, 0x37, 0x10 },
+      { 0xf5, 0x8c, 0x4c, 0x04, 0xd6, 0xe5, 0xf1, 0xba, 0x77, 0x9e, 0xab, 0xfb, 0x5f, 0x7b, 0xfb, 0xd6, 0x9c, 0xfc, 0x4e, 0x96, 0x7e, 0xdb, 0x80, 0x8d, 0x67, 0x9f, 0x77, 0x7b, 0xc6, 0x70, 0x2c, 0x7d, 0x39, 0xf2, 0x33, 0x69, 0xa9, 0xd9, 0xba, 0xcf, 0xa5, 0x30, 0xe2, 0x63, 0x04, 0x23, 0x14, 0x61, 0xb2, 0xeb, 0x05, 0xe2, 0xc3, 0x9b, 0xe9, 0xfc, 0xda, 0x6c, 0x19, 0x07, 0x8c, 0x6a, 0x9d, 0x1b }
+    }
+  };
+  static const struct
+  {
+    const char	*name;			// Test name
+    const char	*text;			// Message text
+    size_t	repeat;			// Number of times to repeat the text
+    uint8_t	digest[32];		// Message digest
+  } sha256_vectors[] =			// SHA-256 test vectors
+  {
+    {
+      "empty",
+      "",
+      1,
+      { 0xe3, 0xb0, 0xc4, 0x42, 0x98, 0xfc, 0x1c, 0x14, 0x9a, 0xfb, 0xf4, 0xc8, 0x99, 0x6f, 0xb9, 0x24, 0x27, 0xae, 0x41, 0xe4, 0x64, 0x9b, 0x93, 0x4c, 0xa4, 0x95, 0x99, 0x1b, 0x78, 0x52, 0xb8, 0x55 }
+    },
+    {
+      "FIPS-180 one block",
+      "abc",
+      1,
+      { 0xba, 0x78, 0x16, 0xbf, 0x8f, 0x01, 0xcf, 0xea, 0x41, 0x41, 0x40, 0xde, 0x5d, 0xae, 0x22, 0x23, 0xb0, 0x03, 0x61, 0xa3, 0x96, 0x17, 0x7a, 0x9c, 0xb4, 0x10, 0xff, 0x61, 0xf2, 0x00, 0x15, 0xad }
+    },
+    {
+      "FIPS-180 two blocks",
+      "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq",
+      1,
+      { 0x24, 0x8d, 0x6a, 0x61, 0xd2, 0x06, 0x38, 0xb8, 0xe5, 0xc0, 0x26, 0x93, 0x0c, 0x3e, 0x60, 0x39, 0xa3, 0x3c, 0xe4, 0x59, 0x64, 0xff, 0x21, 0x67, 0xf6, 0xec, 0xed, 0xd4, 0x19, 0xdb, 0x06, 0xc1 }
+    },
+    {
+      "FIPS-180 one million 'a'",
+      NULL,
+      1000,
+      { 0xcd, 0xc7, 0x6e, 0x5c, 0x99, 0x14, 0xfb, 0x92, 0x81, 0xa1, 0xc7, 0xe2, 0x84, 0xd7, 0x3e, 0x67, 0xf1, 0x80, 0x9a, 0x48, 0xa4, 0x97, 0x20, 0x0e, 0x04, 0x6d, 0x39, 0xcc, 0xc7, 0x11, 0x2c, 0xd0 }
+    }
+  };
 
 
-  // Try opening the file...
-  if (!objnum)
+  for (i = 0; i < (sizeof(aes_vectors) / sizeof(aes_vectors[0])); i ++)
   {
-    printf("%s: ", filename);
-    fflush(stdout);
-  }
+    printf("_pdfioAESInit/Encrypt(%s, %s): ", aes_vectors[i].name, path);
+    _pdfioCryptoAESInit(&aes, aes_vectors[i].key, aes_vectors[i].keylen, aes_vectors[i].iv);
+    _pdfioCryptoAESEncrypt(&aes, buffer, aes_vectors[i].plain, aes_vectors[i].len);
 
-  if ((pdf = pdfioFileOpen(filename, password_cb, (void *)password, (pdfio_error_cb_t)error_cb, &error)) != NULL)
-  {
-    if (objnum)
+    for (j = 0; j < aes_vectors[i].len; j ++)
     {
-      const char	*filter;	// Stream filter
-      pdfio_stream_t	*st;		// Stream
-      char		buffer[8192];	// Read buffer
-      ssize_t		bytes;		// Bytes read
+      if (buffer[j] != aes_vectors[i].cipher[j])
+        break;
+    }
 
-      if ((obj = pdfioFileFindObj(pdf, (size_t)objnum)) == NULL)
-      {
-        puts("Not found.");
-        return (1);
-      }
+    if (j < aes_vectors[i].len)
+    {
+      printf("FAIL (got %02X at offset %u, expected %02X)\n", buffer[j], (unsigned)j, aes_vectors[i].cipher[j]);
+      ret = 1;
+    }
+    else
+    {
+      puts("PASS");
+    }
 
-      if ((dict = pdfioObjGetDict(obj)) == NULL)
-      {
-        _pdfioValueDebug(&obj->value, stdout);
-	putchar('\n');
-        return (0);
-      }
+    // Encrypt again one block at a time to check that the IV is chained
+    // between calls...
+    printf("_pdfioAESInit/Encrypt(%s, %s, blocks): ", aes_vectors[i].name, path);
+    _pdfioCryptoAESInit(&aes, aes_vectors[i].key, aes_vectors[i].keylen, aes_vectors[i].iv);
+    for (j = 0; j < aes_vectors[i].len; j += 16)
+      _pdfioCryptoAESEncrypt(&aes, buffer + j, aes_vectors[i].plain + j, 16);
 
-      filter = pdfioDictGetName(dict, "Filter");
+    for (j = 0; j < aes_vectors[i].len; j ++)
+    {
+      if (buffer[j] != aes_vectors[i].cipher[j])
+        break;
+    }
 
-      if ((st = pdfioObjOpenStream(obj, filter && !strcmp(filter, "FlateDecode"))) == NULL)
-      {
-        _pdfioValueDebug(&obj->value, stdout);
-	putchar('\n');
-        return (0);
-      }
+    if (j < aes_vectors[i].len)
+    {
+      printf("FAIL (got %02X at offset %u, expected %02X)\n", buffer[j], (unsigned)j, aes_vectors[i].cipher[j]);
+      ret = 1;
+    }
+    else
+    {
+      puts("PASS");
+    }
 
-      while ((bytes = pdfioStreamRead(st, buffer, sizeof(buffer))) > 0)
-        fwrite(buffer, 1, (size_t)bytes, stdout);
+    // Decrypt in place, again one block at a time...
+    printf("_pdfioAESInit/Decrypt(%s, %s): ", aes_vectors[i].name, path);
+    memcpy(buffer2, aes_vectors[i].cipher, aes_vectors[i].len);
+    _pdfioCryptoAESInit(&aes, aes_vectors[i].key, aes_vectors[i].keylen, aes_vectors[i].iv);
+    for (j = 0; j < aes_vectors[i].len; j += 16)
+      _pdfioCryptoAESDecrypt(&aes, buffer2 + j, buffer2 + j, 16);
 
-      pdfioStreamClose(st);
+    for (j = 0; j < aes_vectors[i].len; j ++)
+    {
+      if (buffer2[j] != aes_vectors[i].plain[j])
+        break;
+    }
 
-      return (0);
+    if (j < aes_vectors[i].len)
+    {
+      printf("FAIL (got %02X at offset %u, expected %02X)\n", buffer2[j], (unsigned)j, aes_vectors[i].plain[j]);
+      ret = 1;
     }
     else
     {
       puts("PASS");
+    }
+  }
 
-      // Show basic stats...
-      num_objs  = pdfioFileGetNumObjs(pdf);
-      num_pages = pdfioFileGetNumPages(pdf);
+  // One million 'a' is hashed 1000 bytes at a time so that the appended data
+  // does not line up with the 64-byte blocks...
+  memset(buffer, 'a', sizeof(buffer));
 
-      printf("    PDF %s, %d pages, %d objects.\n", pdfioFileGetVersion(pdf), (int)num_pages, (int)num_objs);
+  for (i = 0; i < (sizeof(sha256_vectors) / sizeof(sha256_vectors[0])); i ++)
+  {
+    printf("_pdfioSHA256Init/Append/Finish(%s, %s): ", sha256_vectors[i].name, path);
+    _pdfioCryptoSHA256Init(&sha256);
+    for (j = 0; j < sha256_vectors[i].repeat; j ++)
+    {
+      if (sha256_vectors[i].text)
+        _pdfioCryptoSHA256Append(&sha256, (const uint8_t *)sha256_vectors[i].text, strlen(sha256_vectors[i].text));
+      else
+        _pdfioCryptoSHA256Append(&sha256, buffer, sizeof(buffer));
+    }
+    _pdfioCryptoSHA256Finish(&sha256, buffer2);
 
-      if (verbose)
-      {
-	// Show a summary of each page...
-	for (n = 0; n < num_pages; n ++)
-	{
-	  if ((obj = pdfioFileGetPage(pdf, n)) == NULL)
-	  {
-	    printf("%s: Unable to get page #%d.\n", filename, (int)n + 1);
-	  }
-	  else
-	  {
-	    pdfio_rect_t media_box;	// MediaBox value
+    if (!memcmp(buffer2, sha256_vectors[i].digest, 32))
+    {
+      puts("PASS");
+    }
+    else
+    {
+      printf("FAIL (got '%02X%02X%02X%02X...%02X%02X%02X%02X', expected '%02X%02X%02X%02X...%02X%02X%02X%02X')\n", buffer2[0], buffer2[1], buffer2[2], buffer2[3], buffer2[28], buffer2[29], buffer2[30], buffer2[31], sha256_vectors[i].digest[0], sha256_vectors[i].digest[1], sha256_vectors[i].digest[2], sha256_vectors[i].digest[3], sha256_vectors[i].digest[28], sha256_vectors[i].digest[29], sha256_vectors[i].digest[30], sha256_vectors[i].digest[31]);
+      ret = 1;
+    }
+  }
 
-	    memset(&media_box, 0, sizeof(media_box));
-	    dict = pdfioObjGetDict(obj);
+  return (ret);
+}
 
-	    if (!pdfioDictGetRect(dict, "MediaBox", &media_box))
-	    {
-	      if ((obj = pdfioDictGetObj(dict, "Parent")) != NULL)
-	      {
-		dict = pdfioObjGetDict(obj);
-		pdfioDictGetRect(dict, "MediaBox", &media_box);
-	      }
-	    }
 
-	    printf("    Page #%d (obj %d) is %gx%g.\n", (int)n + 1, (int)pdfioObjGetNumber(obj), media_box.x2, media_box.y2);
-	  }
-	}
+//
+// 'do_number_tests()' - Test the number formatting and parsing functions in PDFio.
+//
 
-	// Show the associated value with each object...
-	for (n = 0; n < num_objs; n ++)
-	{
-	  if ((obj = pdfioFileGetObj(pdf, n)) == NULL)
-	  {
-	    printf("    Unable to get object #%d.\n", (int)n);
-	  }
-	  else
-	  {
-	    dict = pdfioObjGetDict(obj);
+static int				// O - Exit status
+do_number_tests(void)
+{
+  int		ret = 0;		// Return value
+  size_t	i;			// Looping var
+  char		buffer[400];		// Formatted number
+  double	number;			// Number value
+  const char	*end;			// End of number
+  uint64_t	state = 88172645463325252ULL;
+					// Random number state
+  size_t	count = 0;		// Number of mismatches
+  pdfio_file_t	*pdf;			// Temporary PDF file
+  char		temppdf[1024];		// Temporary PDF filename
+  bool		error = false;		// Error callback data
+  static const struct
+  {
+    double	number;			// Number
+    int		digits,			// Significant digits
+		decimals;		// Decimal places
+    const char	*s;			// Expected string
+  }		dtostr_tests[] =	// _pdfio_dtostr tests
+  {
+    { 0.0, 6, 17, "0" },
+    { -0.0, 6, 17, "0" },
+    { 1.0, 6, 17, "1" },
+    { -1.5, 6, 17, "-1.5" },
+    { 0.1, 6, 17, "0.1" },
+    { 123.456, 6, 17, "123.456" },
+    { 612.0, 6, 17, "612" },
+    { 1234567.0, 6, 17, "1234570" },
+    { 1234567.0, 17, 0, "1234567" },
+    { 0.0000001, 6, 17, "0.0000001" },
+    { 0.0000001, 17, 2, "0" },
+    { 72.0 / 7.0, 6, 17, "10.2857" },
+    { 72.0 / 7.0, 17, 17, "10.285714285714286" },
+    { 72.0 / 7.0, 17, 2, "10.29" },
+    { 0.1 + 0.2, 6, 17, "0.3" },
+    { 0.1 + 0.2, 17, 17, "0.30000000000000004" },
+    { 99999.95, 6, 17, "99999.9" },
+    { 99999.96, 6, 17, "100000" },
+    { 0.5, 17, 0, "0" },
+    { 1.5, 17, 0, "2" },
+    { 2.5, 17, 0, "2" },
+    { -2.5, 17, 0, "-2" },
+    { 0.125, 17, 2, "0.12" },
+    { 0.375, 17, 2, "0.38" },
+    { 125.0, 2, 17, "120" },
+    { 135.0, 2, 17, "140" },
+    { 1e20, 6, 17, "100000000000000000000" },
+    { 123456789.0, 6, 17, "123457000" },
+    { 123456789.0, 17, -1, "123456789" },
+    { 0.0094520276938076658, 17, 17, "0.00945202769380767" },
+    { 0.0094520276938076658, 17, -1, "0.009452027693807666" },
+    { 0.1 + 0.2, 17, -1, "0.30000000000000004" },
+    { 72.0 / 7.0, 17, -1, "10.285714285714286" },
+    { 1e-30, 17, -1, "0.000000000000000000000000000001" },
+    { 1e23, 17, -1, "100000000000000000000000" },
+    { 1.2345678901234567e20, 17, -1, "123456789012345670000" }
+  };
+  static const struct
+  {
+    const char	*s;			// String
+    double	number;			// Expected number
+    size_t	len;			// Expected length
+  }		strtod_tests[] =	// _pdfio_strtod tests
+  {
+    { "0", 0.0, 1 },
+    { "-1", -1.0, 2 },
+    { "+17", 17.0, 3 },
+    { "34.5", 34.5, 4 },
+    { "-3.62", -3.62, 5 },
+    { "123.6", 123.6, 5 },
+    { "4.", 4.0, 2 },
+    { "-.002", -0.002, 5 },
+    { "0.0", 0.0, 3 },
+    { "1e3", 1000.0, 3 },
+    { "2.5E-2", 0.025, 6 },
+    { "12e", 12.0, 2 },
+    { "12.5 0 R", 12.5, 4 },
+    { "0.30000000000000004", 0.30000000000000004, 19 },
+    { "10.285714285714286", 72.0 / 7.0, 18 },
+    { "-891476799.967267215274", -891476799.967267215274, 23 },
+    { "0.0094520276938076658", 0.0094520276938076658, 21 },
+    { "9007199254740993", 9007199254740993.0, 16 },
+    { "1e23", 1e23, 4 },
+    { "1.7976931348623157e308", 1.7976931348623157e308, 22 },
+    { "4.9406564584124654e-324", 4.9406564584124654e-324, 23 },
+    { "0.1000000000000000055511151231257827021181583404541015625", 0.1, 57 },
+    { "-", 0.0, 0 },
+    { ".", 0.0, 0 },
+    { "abc", 0.0, 0 }
+  };
 
-	    printf("    %u %u obj dict=%p(%lu pairs)\n", (unsigned)pdfioObjGetNumber(obj), (unsigned)pdfioObjGetGeneration(obj), dict, dict ? (unsigned long)dict->num_pairs : 0UL);
-	    fputs("        ", stdout);
-	    _pdfioValueDebug(&obj->value, stdout);
-	    putchar('\n');
-	  }
-	}
-      }
-    }
 
-    // Close the file and return success...
-    pdfioFileClose(pdf);
-    return (0);
+  for (i = 0; i < (sizeof(dtostr_tests) / sizeof(dtostr_tests[0])); i ++)
+  {
+    printf("_pdfio_dtostr(%.17g, %d, %d): ", dtostr_tests[i].number, dtostr_tests[i].digits, dtostr_tests[i].decimals);
+    _pdfio_dtostr(buffer, sizeof(buffer), dtostr_tests[i].number, dtostr_tests[i].digits, dtostr_tests[i].decimals);
+    if (!strcmp(buffer, dtostr_tests[i].s))
+    {
+      printf("PASS (%s)\n", buffer);
+    }
+    else
+    {
+      printf("FAIL (got '%s', expected '%s')\n", buffer, dtostr_tests[i].s);
+      ret = 1;
+    }
   }
-  else
+
+  for (i = 0; i < (sizeof(strtod_tests) / sizeof(strtod_tests[0])); i ++)
   {
-    // Error message will already be displayed so just indicate failure...
-    return (1);
+    printf("_pdfio_strtod(\"%s\"): ", strtod_tests[i].s);
+    number = _pdfio_strtod(strtod_tests[i].s, &end);
+    if (number == strtod_tests[i].number && (size_t)(end - strtod_tests[i].s) == strtod_tests[i].len)
+    {
+      printf("PASS (%.17g)\n", number);
+    }
+    else
+    {
+      printf("FAIL (got %.17g/%u, expected %.17g/%u)\n", number, (unsigned)(end - strtod_tests[i].s), strtod_tests[i].number, (unsigned)strtod_tests[i].len);
+      ret = 1;
+    }
   }
-}
 
+  // Round-trip random numbers from 1 to 10^16...
+  fputs("_pdfio_dtostr/_pdfio_strtod(round trip): ", stdout);
+  for (i = 0; i < 100000; i ++)
+  {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
 
-//
-// 'do_unit_tests()' - Do unit tests.
-//
+    number = (1.0 + (double)(state >> 11) / 9007199254740992.0) * pow(10.0, (double)(state % 16));
+    if (i & 1)
+      number = -number;
 
-static int				// O - Exit status
-do_unit_tests(void)
-{
-  pdfio_file_t		*inpdf,		// Input PDF file
-			*outpdf;	// Output PDF file
-  int			outfd;		// Output file descriptor
-  bool			error = false;	// Error callback data
+    _pdfio_dtostr(buffer, sizeof(buffer), number, 17, 17);
+
+    if (_pdfio_strtod(buffer, NULL) != number)
+    {
+      if (!count)
+        printf("FAIL (%.17g -> %s -> %.17g)\n", number, buffer, _pdfio_strtod(buffer, NULL));
+
+      count ++;
+    }
+  }
+
+  if (count)
+  {
+    printf("    %u mismatches.\n", (unsigned)count);
+    ret = 1;
+  }
+  else
+  {
+    puts("PASS");
+  }
+
+  // Round-trip random bit patterns with the shortest strings and check that
+  // they have the same number of significant digits as the shortest "%e"
+  // string...
+  fputs("_pdfio_dtostr/_pdfio_strtod(shortest): ", stdout);
+  for (i = 0, count = 0; i < 20000; i ++)
+  {
+    uint64_t	bits;			// Random bits
+    int		digits,			// Significant digits
+		libc_digits;		// Significant digits from printf
+    char	*bufptr,		// Pointer into buffer
+		*first = NULL,		// First significant digit
+		*last = NULL;		// Last significant digit
+
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+
+    bits = state;
+    memcpy(&number, &bits, sizeof(number));
+    if (!isfinite(number))
+      continue;
+
+    _pdfio_dtostr(buffer, sizeof(buffer), number, 17, -1);
+
+    for (bufptr = buffer; *bufptr; bufptr ++)
+    {
+      if (*bufptr >= '1' && *bufptr <= '9')
+      {
+        if (!first)
+          first = bufptr;
+        last = bufptr;
+      }
+    }
+
+    for (digits = 0, bufptr = first; bufptr && bufptr <= last; bufptr ++)
+    {
+      if (*bufptr != '.')
+        digits ++;
+    }
+
+    for (libc_digits = 1; libc_digits < 17; libc_digits ++)
+    {
+      char	temp[64];		// Temporary string
+
+      snprintf(temp, sizeof(temp), "%.*e", libc_digits - 1, number);
+      if (strtod(temp, NULL) == number)
+        break;
+    }
+
+    if (number == 0.0)
+      libc_digits = 0;
+
+    if (_pdfio_strtod(buffer, NULL) != number || digits != libc_digits)
+    {
+      if (!count)
+        printf("FAIL (%.17g -> %s -> %.17g, %d digits, expected %d)\n", number, buffer, _pdfio_strtod(buffer, NULL), digits, libc_digits);
+
+      count ++;
+    }
+  }
+
+  if (count)
+  {
+    printf("    %u mismatches.\n", (unsigned)count);
+    ret = 1;
+  }
+  else
+  {
+    puts("PASS");
+  }
+
+  // Compare long mantissas against strtod, which gets the same digits without
+  // a decimal point so the locale does not matter...
+  fputs("_pdfio_strtod(long mantissas): ", stdout);
+  for (i = 0, count = 0; i < 20000; i ++)
+  {
+    char	temp[128],		// Digits for strtod
+		*bufptr;		// Pointer into buffer
+    size_t	j,			// Looping var
+		num_digits,		// Number of digits
+		point;			// Position of decimal point
+    int		exp10;			// Exponent
+
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+
+    num_digits = 16 + state % 40;
+    point      = (size_t)(state >> 8) % (num_digits + 1);
+    exp10      = (i & 1) ? (int)((state >> 16) % 81) - 40 : 0;
+
+    for (j = 0, bufptr = buffer; j < num_digits; j ++)
+    {
+      state ^= state << 13;
+      state ^= state >> 7;
+      state ^= state << 17;
+
+      if (j == point)
+        *bufptr++ = '.';
+
+      temp[j]    = (char)('0' + (state >> 32) % 10);
+      *bufptr++ = temp[j];
+    }
+
+    snprintf(temp + num_digits, sizeof(temp) - num_digits, "e%d", exp10 - (int)(num_digits - point));
+
+    if (exp10)
+      snprintf(bufptr, sizeof(buffer) - (size_t)(bufptr - buffer), "e%d", exp10);
+    else
+      *bufptr = '\0';
+
+    if (_pdfio_strtod(buffer, NULL) != strtod(temp, NULL))
+    {
+      if (!count)
+        printf("FAIL (%s -> %.17g, expected %.17g)\n", buffer, _pdfio_strtod(buffer, NULL), strtod(temp, NULL));
+
+      count ++;
+    }
+  }
+
+  if (count)
+  {
+    printf("    %u mismatches.\n", (unsigned)count);
+    ret = 1;
+  }
+  else
+  {
+    puts("PASS");
+  }
+
+  // Test the file precision...
+  fputs("pdfioFileSetPrecision(2): ", stdout);
+  if ((pdf = pdfioFileCreateTemporary(temppdf, sizeof(temppdf), NULL, NULL, NULL, (pdfio_error_cb_t)error_cb, &error)) == NULL)
+    return (1);
+
+  if (pdfioFileSetPrecision(pdf, 2))
+  {
+    number_printf(pdf, buffer, sizeof(buffer), "%g %g %g %.0f", 1.23456, -0.5, 72.0 / 7.0, 1234567.0);
+
+    if (!strcmp(buffer, "1.23 -0.5 10.29 1234567"))
+    {
+      puts("PASS");
+    }
+    else
+    {
+      printf("FAIL (got '%s')\n", buffer);
+      ret = 1;
+    }
+  }
+  else
+  {
+    ret = 1;
+  }
+
+  fputs("pdfioFileSetPrecision(PDFIO_PRECISION_SHORTEST): ", stdout);
+  if (pdfioFileSetPrecision(pdf, PDFIO_PRECISION_SHORTEST))
+  {
+    number_printf(pdf, buffer, sizeof(buffer), "%g %g %g %.2f", 123456789.0, 0.0094520276938076658, 0.1 + 0.2, 1.23456);
+
+    if (!strcmp(buffer, "123456789 0.009452027693807666 0.30000000000000004 1.23"))
+    {
+      puts("PASS");
+    }
+    else
+    {
+      printf("FAIL (got '%s')\n", buffer);
+      ret = 1;
+    }
+  }
+  else
+  {
+    ret = 1;
+  }
+
+  pdfioFileClose(pdf);
+  unlink(temppdf);
+
+  return (ret);
+}
+
+
+//
+// 'do_scan_tests()' - Test the content stream scanner.
+//
+
+static int				// O - Exit status
+do_scan_tests(void)
+{
+  pdfio_file_t	*pdf;			// PDF file
+  pdfio_stream_t *st;			// Page content stream
+  bool		error = false;		// Error callback data
+  int		i;			// Looping var
+  scan_data_t	data;			// Scanner callback data
+  static const char *content =		// Page content
+    "% Comment\n"
+    "q 1 0 0 1 72.5 -.25 cm /GS#201 gs\n"
+    "BT /F1 12 Tf (Hello \\(World\\)\\n\\101\\\n!) Tj <48656c6c6f2> Tj [(A) -120 (B)] TJ ET\n"
+    "/Span<</MCID 3/Alt(x)>>BDC EMC true false null xx\n"
+    "BI /W 2 /H 1 /BPC 8 /CS /G ID \001E EI Q\n";
+  static const char *transcript =	// Expected transcript
+    "q\n"
+    "1 0 0 1 72.5 -0.25 cm\n"
+    "/GS 1 gs\n"
+    "BT\n"
+    "/F1 12 Tf\n"
+    "(Hello (World)\nA!:16) Tj\n"
+    "(Hello :6) Tj\n"
+    "[3 (A:1) -120 (B:1) TJ\n"
+    "ET\n"
+    "/Span <<4 /MCID 3 /Alt (x:1) BDC\n"
+    "EMC\n"
+    "true false null xx\n"
+    "/W 2 /H 1 /BPC 8 /CS /G <2> BI\n"
+    "Q\n";
+
+
+  // Write a page with hand-crafted content, followed by enough operators to
+  // span several read buffers...
+  fputs("pdfioFileCreate(\"testpdfio-scan.pdf\", ...): ", stdout);
+  if ((pdf = pdfioFileCreate("testpdfio-scan.pdf", NULL, NULL, NULL, (pdfio_error_cb_t)error_cb, &error)) != NULL)
+    puts("PASS");
+  else
+    return (1);
+
+  fputs("pdfioFileCreatePage: ", stdout);
+  if ((st = pdfioFileCreatePage(pdf, NULL)) != NULL)
+    puts("PASS");
+  else
+    return (1);
+
+  fputs("pdfioStreamPuts(content): ", stdout);
+  if (pdfioStreamPuts(st, content))
+    puts("PASS");
+  else
+    return (1);
+
+  fputs("pdfioStreamPrintf(...): ", stdout);
+  for (i = 0; i < 10000; i ++)
+  {
+    if (!pdfioStreamPrintf(st, "%d %d m %d.5 -%d l S\n", i, i + 1, i * 2, i))
+      break;
+  }
+
+  if (i == 10000)
+    puts("PASS");
+  else
+    return (1);
+
+  pdfioStreamClose(st);
+
+  if (!pdfioFileClose(pdf))
+    return (1);
+
+  // Scan the page content...
+  fputs("pdfioFileOpen(\"testpdfio-scan.pdf\", ...): ", stdout);
+  if ((pdf = pdfioFileOpen("testpdfio-scan.pdf", NULL, NULL, (pdfio_error_cb_t)error_cb, &error)) != NULL)
+    puts("PASS");
+  else
+    return (1);
+
+  memset(&data, 0, sizeof(data));
+
+  fputs("pdfioPageScanContent: ", stdout);
+  if (!pdfioPageScanContent(pdfioFileGetPage(pdf, 0), (pdfio_scan_cb_t)scan_cb, &data))
+  {
+    puts("FAIL");
+    return (1);
+  }
+  else if (data.count != 30014 || data.bad)
+  {
+    printf("FAIL (got %u operators, %u bad, expected 30014)\n", (unsigned)data.count, (unsigned)data.bad);
+    return (1);
+  }
+  else if (strcmp(data.transcript, transcript))
+  {
+    printf("FAIL (got \"%s\", expected \"%s\")\n", data.transcript, transcript);
+    return (1);
+  }
+  else
+  {
+    puts("PASS");
+  }
+
+  pdfioFileClose(pdf);
+
+  return (0);
+}
+
+
+//
+// 'do_test_file()' - Try loading a PDF file and listing pages and objects.
+//
+
+static int				// O - Exit status
+do_test_file(const char *filename,	// I - PDF filename
+             int        objnum,		// I - Object number to dump, if any
+             const char *password,	// I - Password for file
+             bool       verbose)	// I - Be verbose?
+{
+  bool		error = false;		// Have we shown an error yet?
+  pdfio_file_t	*pdf;			// PDF file
+  size_t	n,			// Object/page index
+		num_objs,		// Number of objects
+		num_pages;		// Number of pages
+  pdfio_obj_t	*obj;			// Object
+  pdfio_dict_t	*dict;			// Object dictionary
+
+
+  // Try opening the file...
+  if (!objnum)
+  {
+    printf("%s: ", filename);
+    fflush(stdout);
+  }
+
+  if ((pdf = pdfioFileOpen(filename, password_cb, (void *)password, (pdfio_error_cb_t)error_cb, &error)) != NULL)
+  {
+    if (objnum)
+    {
+      const char	*filter;	// Stream filter
+      pdfio_stream_t	*st;		// Stream
+      char		buffer[8192];	// Read buffer
+      ssize_t		bytes;		// Bytes read
+
+      if ((obj = pdfioFileFindObj(pdf, (size_t)objnum)) == NULL)
+      {
+        puts("Not found.");
+        return (1);
+      }
+
+      if ((dict = pdfioObjGetDict(obj)) == NULL)
+      {
+        _pdfioValueDebug(&obj->value, stdout);
+	putchar('\n');
+        return (0);
+      }
+
+      filter = pdfioDictGetName(dict, "Filter");
+
+      if ((st = pdfioObjOpenStream(obj, filter && !strcmp(filter, "FlateDecode"))) == NULL)
+      {
+        _pdfioValueDebug(&obj->value, stdout);
+	putchar('\n');
+        return (0);
+      }
+
+      while ((bytes = pdfioStreamRead(st, buffer, sizeof(buffer))) > 0)
+        fwrite(buffer, 1, (size_t)bytes, stdout);
+
+      pdfioStreamClose(st);
+
+      return (0);
+    }
+    else
+    {
+      puts("PASS");
+
+      // Show basic stats...
+      num_objs  = pdfioFileGetNumObjs(pdf);
+      num_pages = pdfioFileGetNumPages(pdf);
+
+      printf("    PDF %s, %d pages, %d objects.\n", pdfioFileGetVersion(pdf), (int)num_pages, (int)num_objs);
+
+      if (verbose)
+      {
+	// Show a summary of each page...
+	for (n = 0; n < num_pages; n ++)
+	{
+	  if ((obj = pdfioFileGetPage(pdf, n)) == NULL)
+	  {
+	    printf("%s: Unable to get page #%d.\n", filename, (int)n + 1);
+	  }
+	  else
+	  {
+	    pdfio_rect_t media_box;	// MediaBox value
+
+	    memset(&media_box, 0, sizeof(media_box));
+	    dict = pdfioObjGetDict(obj);
+
+	    if (!pdfioDictGetRect(dict, "MediaBox", &media_box))
+	    {
+	      if ((obj = pdfioDictGetObj(dict, "Parent")) != NULL)
+	      {
+		dict = pdfioObjGetDict(obj);
+		pdfioDictGetRect(dict, "MediaBox", &media_box);
+	      }
+	    }
+
+	    printf("    Page #%d (obj %d) is %gx%g.\n", (int)n + 1, (int)pdfioObjGetNumber(obj), media_box.x2, media_box.y2);
+	  }
+	}
+
+	// Show the associated value with each object...
+	for (n = 0; n < num_objs; n ++)
+	{
+	  if ((obj = pdfioFileGetObj(pdf, n)) == NULL)
+	  {
+	    printf("    Unable to get object #%d.\n", (int)n);
+	  }
+	  else
+	  {
+	    dict = pdfioObjGetDict(obj);
+
+	    printf("    %u %u obj dict=%p(%lu pairs)\n", (unsigned)pdfioObjGetNumber(obj), (unsigned)pdfioObjGetGeneration(obj), dict, dict ? (unsigned long)dict->num_pairs : 0UL);
+	    fputs("        ", stdout);
+	    _pdfioValueDebug(&obj->value, stdout);
+	    putchar('\n');
+	  }
+	}
+      }
+    }
+
+    // Close the file and return success...
+    pdfioFileClose(pdf);
+    return (0);
+  }
+  else
+  {
+    // Error message will already be displayed so just indicate failure...
+    return (1);
+  }
+}
+
+
+//
+// 'do_unit_tests()' - Do unit tests.
+//
+
+static int				// O - Exit status
+do_unit_tests(void)
+{
+  pdfio_file_t		*inpdf,		// Input PDF file
+			*mempdf,	// In-memory PDF file
+			*outpdf,	// Output PDF file
+			*srcpdfs[2];	// Source PDF files for merge
+  pdfio_obj_t		*contents[2];	// Content streams of merged pages
+  int			memfd,		// In-memory file descriptor
+			outfd;		// Output file descriptor
+  off_t			sizes[2];	// File sizes
+  pdfio_font_t		*sharedfont;	// Shared font
+  pdfio_obj_t		*fontobjs[2];	// Font objects
+  char			*memdata = NULL;// In-memory file data
+  size_t		memsize;	// Size of in-memory file data
+  pdfio_stream_t	*st;		// Page content stream
+  codec_data_t		codec = { 0, 0 };// Compression callback data
+  bool			error = false,	// Error callback data
+			accel;		// Use SSE2 instructions?
   _pdfio_token_t	tb;		// Token buffer
   const char		*s;		// String buffer
   _pdfio_value_t	value;		// Value
@@ -525,6 +1393,8 @@ do_unit_tests(void)
   char			temppdf[1024];	// Temporary PDF file
   pdfio_dict_t		*dict;		// Test dictionary
   int			count = 0;	// Number of key/value pairs
+  size_t		i;		// Looping var
+  char			key[32];	// Dictionary key
   static const char	*complex_dict =	// Complex dictionary value
     "<</Annots 5457 0 R/Contents 5469 0 R/CropBox[0 0 595.4 842]/Group 725 0 R"
     "/MediaBox[0 0 595.4 842]/Parent 23513 0 R/Resources<</ColorSpace<<"
@@ -975,1898 +1845,5417 @@ do_unit_tests(void)
     ">\nendobj\n";
 
 
-  setbuf(stdout, NULL);
+  setbuf(stdout, NULL);
+
+  // First open the test PDF file...
+  fputs("pdfioFileOpen(\"testfiles/testpdfio.pdf\"): ", stdout);
+  if ((inpdf = pdfioFileOpen("testfiles/testpdfio.pdf", /*password_cb*/NULL, /*password_data*/NULL, (pdfio_error_cb_t)error_cb, &error)) != NULL)
+    puts("PASS");
+  else
+    return (1);
+
+  // TODO: Test for known values in this test file.
+
+  // Test opening the same file from memory...
+  fputs("pdfioFileOpenMemory(\"testfiles/testpdfio.pdf\"): ", stdout);
+  if ((memfd = open("testfiles/testpdfio.pdf", O_RDONLY | O_BINARY)) < 0)
+  {
+    printf("FAIL (%s)\n", strerror(errno));
+    return (1);
+  }
+
+  memsize = (size_t)lseek(memfd, 0, SEEK_END);
+  lseek(memfd, 0, SEEK_SET);
+
+  if ((memdata = malloc(memsize)) == NULL || read(memfd, memdata, memsize) != (ssize_t)memsize)
+  {
+    puts("FAIL (unable to read file)");
+    close(memfd);
+    free(memdata);
+    return (1);
+  }
+
+  close(memfd);
+
+  if ((mempdf = pdfioFileOpenMemory(memdata, memsize, /*password_cb*/NULL, /*password_data*/NULL, (pdfio_error_cb_t)error_cb, &error)) != NULL)
+  {
+    puts("PASS");
+  }
+  else
+  {
+    free(memdata);
+    return (1);
+  }
+
+  fputs("pdfioFileGetNumObjs(memory): ", stdout);
+  if (pdfioFileGetNumObjs(mempdf) == pdfioFileGetNumObjs(inpdf))
+  {
+    puts("PASS");
+  }
+  else
+  {
+    printf("FAIL (got %lu, expected %lu)\n", (unsigned long)pdfioFileGetNumObjs(mempdf), (unsigned long)pdfioFileGetNumObjs(inpdf));
+    return (1);
+  }
+
+  fputs("pdfioPageOpenStream(memory): ", stdout);
+  if ((st = pdfioPageOpenStream(pdfioFileGetPage(mempdf, 0), 0, true)) != NULL)
+  {
+    char	token[1024];		// Token from stream
+
+    if (pdfioStreamGetToken(st, token, sizeof(token)))
+    {
+      printf("PASS (%s)\n", token);
+    }
+    else
+    {
+      puts("FAIL (unable to read stream)");
+      return (1);
+    }
+
+    pdfioStreamClose(st);
+  }
+  else
+  {
+    puts("FAIL");
+    return (1);
+  }
+
+  pdfioFileClose(mempdf);
+  free(memdata);
+
+  // Test a file with high object numbers listed in descending order...
+  if (read_sparse_file())
+    return (1);
+
+  // Test string APIs
+  fputs("pdfioStringCreate: ", stdout);
+  if ((s = pdfioStringCreate(inpdf, "Interned String")) != NULL && s == pdfioStringCreate(inpdf, "Interned String") && !strcmp(s, "Interned String"))
+  {
+    puts("PASS");
+  }
+  else
+  {
+    puts("FAIL");
+    return (1);
+  }
+
+  fputs("pdfioStringCreatef: ", stdout);
+  if ((s = pdfioStringCreatef(inpdf, "%06d", 42)) != NULL && s == pdfioStringCreate(inpdf, "000042"))
+  {
+    puts("PASS");
+  }
+  else
+  {
+    puts("FAIL");
+    return (1);
+  }
+
+  // Test dictionary APIs
+  fputs("pdfioDictCreate: ", stdout);
+  if ((dict = pdfioDictCreate(inpdf)) != NULL)
+  {
+    puts("PASS");
+
+    fputs("pdfioDictSet*: ", stdout);
+    if (pdfioDictSetBoolean(dict, "Boolean", true) && pdfioDictSetName(dict, "Name", "Name") && pdfioDictSetNumber(dict, "Number", 42.0) && pdfioDictSetString(dict, "String", "String"))
+    {
+      puts("PASS");
+    }
+    else
+    {
+      puts("FAIL");
+      return (1);
+    }
+
+    fputs("pdfioDictIterateKeys: ", stdout);
+    pdfioDictIterateKeys(dict, iterate_cb, &count);
+    if (count == 4)
+    {
+      puts("PASS");
+    }
+    else
+    {
+      printf("FAIL (got %d, expected 4)\n", count);
+      return (1);
+    }
+
+    fputs("pdfioDictGetNumber(large dictionary): ", stdout);
+    for (i = 0; i < 100; i ++)
+    {
+      snprintf(key, sizeof(key), "Key%u", (unsigned)i);
+      if (!pdfioDictSetNumber(dict, pdfioStringCreate(inpdf, key), (double)i))
+        break;
+    }
+
+    for (i = 0; i < 100; i ++)
+    {
+      snprintf(key, sizeof(key), "Key%u", (unsigned)i);
+      if (pdfioDictGetNumber(dict, key) != (double)i)
+        break;
+    }
+
+    if (i == 100 && pdfioDictGetNumber(dict, "Number") == 42.0 && pdfioDictGetNumber(dict, "Key100") == 0.0)
+    {
+      puts("PASS");
+    }
+    else
+    {
+      printf("FAIL (Key%u)\n", (unsigned)i);
+      return (1);
+    }
+
+    fputs("pdfioDictClear(large dictionary): ", stdout);
+    if (pdfioDictClear(dict, "Key42") && pdfioDictGetNumber(dict, "Key42") == 0.0 && pdfioDictGetNumber(dict, "Key43") == 43.0 && pdfioDictGetNumPairs(dict) == 103)
+    {
+      puts("PASS");
+    }
+    else
+    {
+      puts("FAIL");
+      return (1);
+    }
+
+    fputs("pdfioDictGetKey: ", stdout);
+    if ((s = pdfioDictGetKey(dict, 0)) != NULL && !strcmp(s, "Boolean") && (s = pdfioDictGetKey(dict, 4)) != NULL && !strcmp(s, "Key0"))
+    {
+      puts("PASS");
+    }
+    else
+    {
+      printf("FAIL (got '%s')\n", s ? s : "(null)");
+      return (1);
+    }
+  }
+  else
+  {
+    puts("FAIL");
+    return (1);
+  }
+
+  // Test the value parsers for edge cases...
+  fputs("_pdfioValueRead(complex_dict): ", stdout);
+  s = complex_dict;
+  _pdfioTokenInit(&tb, inpdf, (_pdfio_tconsume_cb_t)token_consume_cb, (_pdfio_tpeek_cb_t)token_peek_cb, (void *)&s);
+  if (_pdfioValueRead(inpdf, NULL, &tb, &value, 0))
+  {
+    // TODO: Check value...
+    fputs("PASS: ", stdout);
+    _pdfioValueDebug(&value, stdout);
+    puts("\n");
+  }
+  else
+    goto fail;
+
+  // Test the value parsers for edge cases...
+  fputs("_pdfioValueRead(cid_dict): ", stdout);
+  s = cid_dict;
+  _pdfioTokenInit(&tb, inpdf, (_pdfio_tconsume_cb_t)token_consume_cb, (_pdfio_tpeek_cb_t)token_peek_cb, (void *)&s);
+  if (_pdfioValueRead(inpdf, NULL, &tb, &value, 0))
+  {
+    // TODO: Check value...
+    fputs("PASS: ", stdout);
+    _pdfioValueDebug(&value, stdout);
+    puts("\n");
+  }
+  else
+    goto fail;
+
+  // Do crypto tests...
+  if (do_crypto_tests())
+    return (1);
+
+  // Do number formatting and parsing tests...
+  if (do_number_tests())
+    return (1);
+
+  // Do content scanner tests...
+  if (do_scan_tests())
+    return (1);
+
+  // Create a new PDF file...
+  fputs("pdfioFileCreate(\"testpdfio-out.pdf\", ...): ", stdout);
+  if ((outpdf = pdfioFileCreate("testpdfio-out.pdf", NULL, NULL, NULL, (pdfio_error_cb_t)error_cb, &error)) != NULL)
+    puts("PASS");
+  else
+    goto fail;
+
+  if (write_unit_file(inpdf, "testpdfio-out.pdf", outpdf, &num_pages, &first_image))
+    goto fail;
+
+  if (read_unit_file("testpdfio-out.pdf", num_pages, first_image, false))
+    goto fail;
+
+  if (write_update_file("testpdfio-out.pdf", "testpdfio-update.pdf", num_pages, first_image))
+    goto fail;
+
+  // Stream a new PDF file...
+  if ((outfd = open("testpdfio-out2.pdf", O_CREAT | O_TRUNC | O_WRONLY | O_BINARY, 0666)) < 0)
+  {
+    perror("Unable to open \"testpdfio-out2.pdf\"");
+    goto fail;
+  }
+
+  fputs("pdfioFileCreateOutput(...): ", stdout);
+  if ((outpdf = pdfioFileCreateOutput((pdfio_output_cb_t)output_cb, &outfd, NULL, NULL, NULL, (pdfio_error_cb_t)error_cb, &error)) != NULL)
+    puts("PASS");
+  else
+    goto fail;
+
+  if (write_unit_file(inpdf, "testpdfio-out2.pdf", outpdf, &num_pages, &first_image))
+    goto fail;
+
+  close(outfd);
+
+  if (read_unit_file("testpdfio-out2.pdf", num_pages, first_image, true))
+    goto fail;
+
+  // Create a new PDF file using object streams...
+  fputs("pdfioFileCreate(\"testpdfio-objstm.pdf\", ...): ", stdout);
+  if ((outpdf = pdfioFileCreate("testpdfio-objstm.pdf", NULL, NULL, NULL, (pdfio_error_cb_t)error_cb, &error)) != NULL)
+    puts("PASS");
+  else
+    goto fail;
+
+  fputs("pdfioFileSetOptions(PDFIO_OPTION_OBJSTREAMS): ", stdout);
+  if (pdfioFileSetOptions(outpdf, PDFIO_OPTION_OBJSTREAMS) && pdfioFileGetOptions(outpdf) == PDFIO_OPTION_OBJSTREAMS)
+    puts("PASS");
+  else
+    goto fail;
+
+  if (write_unit_file(inpdf, "testpdfio-objstm.pdf", outpdf, &num_pages, &first_image))
+    goto fail;
+
+  if (read_unit_file("testpdfio-objstm.pdf", num_pages, first_image, false))
+    goto fail;
+
+  if (read_concurrent_file("testpdfio-objstm.pdf"))
+    goto fail;
+
+  if (read_objstms_file("testpdfio-objstm.pdf"))
+    goto fail;
+
+  if (read_io_file("testpdfio-objstm.pdf"))
+    goto fail;
+
+  if (read_cached_file("testpdfio-objstm.pdf"))
+    goto fail;
+
+  if (read_stats_file("testpdfio-objstm.pdf"))
+    goto fail;
+
+  if (write_update_file("testpdfio-objstm.pdf", "testpdfio-updateobjstm.pdf", num_pages, first_image))
+    goto fail;
+
+  // Create a new PDF file using parallel compression...
+  fputs("pdfioFileCreate(\"testpdfio-parallel.pdf\", ...): ", stdout);
+  if ((outpdf = pdfioFileCreate("testpdfio-parallel.pdf", NULL, NULL, NULL, (pdfio_error_cb_t)error_cb, &error)) != NULL)
+    puts("PASS");
+  else
+    goto fail;
+
+  fputs("pdfioFileSetOptions(PDFIO_OPTION_OBJSTREAMS | PDFIO_OPTION_PARALLEL): ", stdout);
+  if (pdfioFileSetOptions(outpdf, PDFIO_OPTION_OBJSTREAMS | PDFIO_OPTION_PARALLEL))
+    puts("PASS");
+  else
+    goto fail;
+
+  if (write_unit_file(inpdf, "testpdfio-parallel.pdf", outpdf, &num_pages, &first_image))
+    goto fail;
+
+  if (read_unit_file("testpdfio-parallel.pdf", num_pages, first_image, false))
+    goto fail;
+
+  if (read_concurrent_file("testpdfio-parallel.pdf"))
+    goto fail;
+
+  // Create a linearized PDF file...
+  fputs("pdfioFileCreate(\"testpdfio-linear.pdf\", ...): ", stdout);
+  if ((outpdf = pdfioFileCreate("testpdfio-linear.pdf", NULL, NULL, NULL, (pdfio_error_cb_t)error_cb, &error)) != NULL)
+    puts("PASS");
+  else
+    goto fail;
+
+  fputs("pdfioFileSetOptions(PDFIO_OPTION_LINEARIZE | PDFIO_OPTION_PARALLEL): ", stdout);
+  if (pdfioFileSetOptions(outpdf, PDFIO_OPTION_LINEARIZE | PDFIO_OPTION_PARALLEL))
+    puts("PASS");
+  else
+    goto fail;
+
+  if (write_unit_file(inpdf, "testpdfio-linear.pdf", outpdf, &num_pages, &first_image))
+    goto fail;
+
+  if (read_linearized_file("testpdfio-linear.pdf", num_pages, &first_image))
+    goto fail;
+
+  if (read_unit_file("testpdfio-linear.pdf", num_pages, first_image, false))
+    goto fail;
+
+  // Stream a linearized PDF file...
+  if ((outfd = open("testpdfio-linear2.pdf", O_CREAT | O_TRUNC | O_WRONLY | O_BINARY, 0666)) < 0)
+  {
+    perror("Unable to open \"testpdfio-linear2.pdf\"");
+    goto fail;
+  }
+
+  fputs("pdfioFileCreateOutput(...): ", stdout);
+  if ((outpdf = pdfioFileCreateOutput((pdfio_output_cb_t)output_cb, &outfd, NULL, NULL, NULL, (pdfio_error_cb_t)error_cb, &error)) != NULL)
+    puts("PASS");
+  else
+    goto fail;
+
+  fputs("pdfioFileSetOptions(PDFIO_OPTION_LINEARIZE): ", stdout);
+  if (pdfioFileSetOptions(outpdf, PDFIO_OPTION_LINEARIZE))
+    puts("PASS");
+  else
+    goto fail;
+
+  if (write_unit_file(inpdf, "testpdfio-linear2.pdf", outpdf, &num_pages, &first_image))
+    goto fail;
+
+  close(outfd);
+
+  // Stream lengths are not written as separate objects when linearizing...
+  if (read_linearized_file("testpdfio-linear2.pdf", num_pages, &first_image))
+    goto fail;
+
+  if (read_unit_file("testpdfio-linear2.pdf", num_pages, first_image, false))
+    goto fail;
+
+  // Create a new PDF file using streaming output...
+  fputs("pdfioFileCreate(\"testpdfio-streaming.pdf\", ...): ", stdout);
+  if ((outpdf = pdfioFileCreate("testpdfio-streaming.pdf", NULL, NULL, NULL, (pdfio_error_cb_t)error_cb, &error)) != NULL)
+    puts("PASS");
+  else
+    goto fail;
+
+  fputs("pdfioFileSetOptions(PDFIO_OPTION_OBJSTREAMS | PDFIO_OPTION_STREAMING): ", stdout);
+  if (pdfioFileSetOptions(outpdf, PDFIO_OPTION_OBJSTREAMS | PDFIO_OPTION_STREAMING))
+    puts("PASS");
+  else
+    goto fail;
+
+  if (write_unit_file(inpdf, "testpdfio-streaming.pdf", outpdf, &num_pages, &first_image))
+    goto fail;
+
+  if (read_unit_file("testpdfio-streaming.pdf", num_pages, first_image, false))
+    goto fail;
+
+  if (write_streaming_file("testpdfio-streaming2.pdf", 5000))
+    goto fail;
+
+  if (write_objstms_file("testpdfio-objstms.pdf", 1000))
+    goto fail;
+
+  if (read_objstms_file("testpdfio-objstms.pdf"))
+    goto fail;
+
+  if (write_page_tree_file("testpdfio-pagetree.pdf", 4, PDFIO_OPTION_NONE))
+    goto fail;
+
+  if (write_page_tree_file("testpdfio-pagetree2.pdf", 3, PDFIO_OPTION_LINEARIZE))
+    goto fail;
+
+  if (write_page_tree_file("testpdfio-pagetree3.pdf", 5, PDFIO_OPTION_STREAMING))
+    goto fail;
+
+  if (write_path_file("testpdfio-paths.pdf"))
+    goto fail;
+
+  // Test the PNG predictors with the default code and then the portable code,
+  // since the default is to use SSE2 when the CPU has it...
+  if (write_predictor_file("testpdfio-predictor.pdf"))
+    goto fail;
+
+  accel = _pdfioStreamSetAccel(false);
+
+  if (write_predictor_file("testpdfio-predictor2.pdf"))
+  {
+    _pdfioStreamSetAccel(accel);
+    goto fail;
+  }
+
+  _pdfioStreamSetAccel(accel);
+
+  if (write_object_key_file("testpdfio-objkey.pdf", PDFIO_ENCRYPTION_RC4_128))
+    goto fail;
+
+  if (write_object_key_file("testpdfio-objkey2.pdf", PDFIO_ENCRYPTION_AES_128))
+    goto fail;
+
+  if (write_image_callback_file("testpdfio-imagecb.pdf", PDFIO_ENCRYPTION_NONE, PDFIO_OPTION_NONE))
+    goto fail;
+
+  if (write_image_callback_file("testpdfio-imagecb2.pdf", PDFIO_ENCRYPTION_AES_128, PDFIO_OPTION_PARALLEL))
+    goto fail;
+
+  if (write_image_memory_file("testpdfio-imagemem.pdf"))
+    goto fail;
+
+  if (write_paragraph_file("testpdfio-paragraph.pdf"))
+    goto fail;
+
+  // Create a new PDF file using compression callbacks...
+  fputs("pdfioFileCreate(\"testpdfio-codec.pdf\", ...): ", stdout);
+  if ((outpdf = pdfioFileCreate("testpdfio-codec.pdf", NULL, NULL, NULL, (pdfio_error_cb_t)error_cb, &error)) != NULL)
+    puts("PASS");
+  else
+    goto fail;
+
+  fputs("pdfioFileSetCompression(1, PDFIO_STRATEGY_DEFAULT): ", stdout);
+  if (pdfioFileSetCompression(outpdf, 1, PDFIO_STRATEGY_DEFAULT))
+    puts("PASS");
+  else
+    goto fail;
+
+  fputs("pdfioStreamSetCompression(0, PDFIO_STRATEGY_RLE): ", stdout);
+  if ((dict = pdfioDictCreate(outpdf)) != NULL && pdfioDictSetName(dict, "Filter", "FlateDecode") && (st = pdfioObjCreateStream(pdfioFileCreateObj(outpdf, dict), PDFIO_FILTER_FLATE)) != NULL && pdfioStreamSetCompression(st, 0, PDFIO_STRATEGY_RLE) && pdfioStreamPuts(st, "Stored stream data.\n") && pdfioStreamClose(st))
+    puts("PASS");
+  else
+    goto fail;
+
+  fputs("pdfioFileSetCodec(deflate): ", stdout);
+  if (pdfioFileSetCodec(outpdf, (pdfio_deflate_cb_t)codec_deflate_cb, NULL, &codec))
+    puts("PASS");
+  else
+    goto fail;
+
+  if (write_unit_file(inpdf, "testpdfio-codec.pdf", outpdf, &num_pages, &first_image))
+    goto fail;
+
+  fputs("codec_deflate_cb: ", stdout);
+  if (codec.deflates > 0)
+  {
+    printf("PASS (%u calls)\n", (unsigned)codec.deflates);
+  }
+  else
+  {
+    puts("FAIL (not called)");
+    goto fail;
+  }
+
+  if (read_unit_file("testpdfio-codec.pdf", num_pages, first_image, false))
+    goto fail;
+
+  if (read_codec_file("testpdfio-codec.pdf"))
+    goto fail;
+
+  // Create a new PDF file with subset fonts...
+  fputs("pdfioFileCreate(\"testpdfio-subset.pdf\", ...): ", stdout);
+  if ((outpdf = pdfioFileCreate("testpdfio-subset.pdf", NULL, NULL, NULL, (pdfio_error_cb_t)error_cb, &error)) != NULL)
+    puts("PASS");
+  else
+    goto fail;
+
+  fputs("pdfioFileSetOptions(PDFIO_OPTION_SUBSET_FONTS): ", stdout);
+  if (pdfioFileSetOptions(outpdf, PDFIO_OPTION_SUBSET_FONTS))
+    puts("PASS");
+  else
+    goto fail;
+
+  if (write_unit_file(inpdf, "testpdfio-subset.pdf", outpdf, &num_pages, &first_image))
+    goto fail;
+
+  if (read_unit_file("testpdfio-subset.pdf", num_pages, first_image, false))
+    goto fail;
+
+  fputs("testpdfio-subset.pdf < testpdfio-out.pdf: ", stdout);
+  for (i = 0; i < 2; i ++)
+  {
+    if ((outfd = open(i ? "testpdfio-subset.pdf" : "testpdfio-out.pdf", O_RDONLY | O_BINARY)) < 0)
+      break;
+
+    sizes[i] = lseek(outfd, 0, SEEK_END);
+    close(outfd);
+  }
+
+  if (i == 2 && sizes[1] > 0 && sizes[1] < sizes[0])
+  {
+    printf("PASS (%ld < %ld bytes)\n", (long)sizes[1], (long)sizes[0]);
+  }
+  else
+  {
+    puts("FAIL");
+    goto fail;
+  }
+
+  // Try loading a missing font, which reports the error with a NULL PDF file...
+  fputs("pdfioFontCreate(\"testfiles/missing.ttf\"): ", stdout);
+  if ((sharedfont = pdfioFontCreate("testfiles/missing.ttf", (pdfio_error_cb_t)error_cb, &error)) != NULL)
+  {
+    puts("FAIL (font loaded)");
+    pdfioFontDelete(sharedfont);
+    goto fail;
+  }
+  else
+    puts("PASS");
+
+  error = false;
+
+  // Embed a shared font in two PDF files...
+  fputs("pdfioFontCreate(\"testfiles/OpenSans-Regular.ttf\"): ", stdout);
+  if ((sharedfont = pdfioFontCreate("testfiles/OpenSans-Regular.ttf", (pdfio_error_cb_t)error_cb, &error)) != NULL)
+    puts("PASS");
+  else
+    goto fail;
+
+  for (i = 0; i < 2; i ++)
+  {
+    snprintf(temppdf, sizeof(temppdf), "testpdfio-font%u.pdf", (unsigned)(i + 1));
+
+    printf("pdfioFileCreate(\"%s\", ...): ", temppdf);
+    if ((outpdf = pdfioFileCreate(temppdf, NULL, NULL, NULL, (pdfio_error_cb_t)error_cb, &error)) != NULL)
+      puts("PASS");
+    else
+      goto fail;
+
+    fputs("pdfioFileCreateFontObjFromFont: ", stdout);
+    fontobjs[0] = pdfioFileCreateFontObjFromFont(outpdf, sharedfont, i == 1);
+    fontobjs[1] = pdfioFileCreateFontObjFromFont(outpdf, sharedfont, i == 1);
+    if (fontobjs[0] && fontobjs[0] == fontobjs[1])
+    {
+      puts("PASS");
+    }
+    else
+    {
+      printf("FAIL (got %p and %p)\n", (void *)fontobjs[0], (void *)fontobjs[1]);
+      goto fail;
+    }
+
+    fputs("pdfioContentTextMeasure(shared font): ", stdout);
+    if (pdfioContentTextMeasure(fontobjs[0], "Hello, World!", 12.0) > 0.0)
+      puts("PASS");
+    else
+      goto fail;
+
+    if ((dict = pdfioDictCreate(outpdf)) == NULL || !pdfioPageDictAddFont(dict, "F1", fontobjs[0]) || (st = pdfioFileCreatePage(outpdf, dict)) == NULL)
+      goto fail;
+
+    if (!pdfioContentTextBegin(st) || !pdfioContentSetTextFont(st, "F1", 12.0) || !pdfioContentTextMoveTo(st, 72.0, 720.0) || !pdfioContentTextShow(st, i == 1, "Hello, World!") || !pdfioContentTextEnd(st) || !pdfioStreamClose(st))
+      goto fail;
+
+    printf("pdfioFileClose(\"%s\"): ", temppdf);
+    if (pdfioFileClose(outpdf))
+      puts("PASS");
+    else
+      goto fail;
+
+    printf("pdfioFileOpen(\"%s\", ...): ", temppdf);
+    if ((outpdf = pdfioFileOpen(temppdf, /*password_cb*/NULL, /*password_data*/NULL, (pdfio_error_cb_t)error_cb, &error)) != NULL && pdfioFileGetNumPages(outpdf) == 1)
+    {
+      puts("PASS");
+      pdfioFileClose(outpdf);
+    }
+    else
+    {
+      goto fail;
+    }
+  }
+
+  pdfioFontDelete(sharedfont);
+
+  // Merge two copies of a PDF file, sharing identical streams...
+  fputs("pdfioFileCreate(\"testpdfio-merge.pdf\", ...): ", stdout);
+  if ((outpdf = pdfioFileCreate("testpdfio-merge.pdf", NULL, NULL, NULL, (pdfio_error_cb_t)error_cb, &error)) != NULL)
+    puts("PASS");
+  else
+    goto fail;
+
+  fputs("pdfioFileSetOptions(PDFIO_OPTION_DEDUPLICATE): ", stdout);
+  if (pdfioFileSetOptions(outpdf, PDFIO_OPTION_DEDUPLICATE))
+    puts("PASS");
+  else
+    goto fail;
+
+  for (i = 0; i < 2; i ++)
+  {
+    size_t	j;			// Looping var
+
+    printf("pdfioPageCopy(testpdfio-out.pdf copy %u): ", (unsigned)(i + 1));
+    if ((srcpdfs[i] = pdfioFileOpen("testpdfio-out.pdf", /*password_cb*/NULL, /*password_data*/NULL, (pdfio_error_cb_t)error_cb, &error)) == NULL)
+      goto fail;
+
+    for (j = 0; j < pdfioFileGetNumPages(srcpdfs[i]); j ++)
+    {
+      if (!pdfioPageCopy(outpdf, pdfioFileGetPage(srcpdfs[i], j)))
+        break;
+    }
+
+    if (j < pdfioFileGetNumPages(srcpdfs[i]))
+      goto fail;
+
+    puts("PASS");
+  }
+
+  fputs("pdfioPageCopy(shared streams): ", stdout);
+  contents[0] = pdfioDictGetObj(pdfioObjGetDict(pdfioFileGetPage(outpdf, 1)), "Contents");
+  contents[1] = pdfioDictGetObj(pdfioObjGetDict(pdfioFileGetPage(outpdf, pdfioFileGetNumPages(srcpdfs[0]) + 1)), "Contents");
+  if (contents[0] && contents[0] == contents[1])
+  {
+    puts("PASS");
+  }
+  else
+  {
+    printf("FAIL (got %p and %p)\n", (void *)contents[0], (void *)contents[1]);
+    goto fail;
+  }
+
+  fputs("pdfioFileClose(\"testpdfio-merge.pdf\"): ", stdout);
+  if (pdfioFileClose(outpdf))
+    puts("PASS");
+  else
+    goto fail;
+
+  pdfioFileClose(srcpdfs[0]);
+  pdfioFileClose(srcpdfs[1]);
+
+  fputs("pdfioFileOpen(\"testpdfio-merge.pdf\"): ", stdout);
+  if ((outpdf = pdfioFileOpen("testpdfio-merge.pdf", /*password_cb*/NULL, /*password_data*/NULL, (pdfio_error_cb_t)error_cb, &error)) != NULL && pdfioFileGetNumPages(outpdf) == 2 * num_pages)
+  {
+    puts("PASS");
+  }
+  else
+  {
+    printf("FAIL (%u pages)\n", outpdf ? (unsigned)pdfioFileGetNumPages(outpdf) : 0);
+    goto fail;
+  }
+
+  pdfioFileClose(outpdf);
+
+  // Create new encrypted PDF files...
+  fputs("pdfioFileCreate(\"testpdfio-rc4.pdf\", ...): ", stdout);
+  if ((outpdf = pdfioFileCreate("testpdfio-rc4.pdf", NULL, NULL, NULL, (pdfio_error_cb_t)error_cb, &error)) != NULL)
+    puts("PASS");
+  else
+    return (1);
+
+  fputs("pdfioFileSetPermissions(all, RC4-128, no passwords): ", stdout);
+  if (pdfioFileSetPermissions(outpdf, PDFIO_PERMISSION_ALL, PDFIO_ENCRYPTION_RC4_128, NULL, NULL))
+    puts("PASS");
+  else
+    return (1);
+
+  if (write_unit_file(inpdf, "testpdfio-rc4.pdf", outpdf, &num_pages, &first_image))
+    return (1);
+
+  if (read_unit_file("testpdfio-rc4.pdf", num_pages, first_image, false))
+    return (1);
+
+  // Create new encrypted PDF files...
+  fputs("pdfioFileCreate(\"testpdfio-rc4p.pdf\", ...): ", stdout);
+  if ((outpdf = pdfioFileCreate("testpdfio-rc4p.pdf", NULL, NULL, NULL, (pdfio_error_cb_t)error_cb, &error)) != NULL)
+    puts("PASS");
+  else
+    return (1);
+
+  fputs("pdfioFileSetPermissions(no-print, RC4-128, passwords='owner' and 'user'): ", stdout);
+  if (pdfioFileSetPermissions(outpdf, PDFIO_PERMISSION_ALL ^ PDFIO_PERMISSION_PRINT, PDFIO_ENCRYPTION_RC4_128, "owner", "user"))
+    puts("PASS");
+  else
+    return (1);
+
+  if (write_unit_file(inpdf, "testpdfio-rc4p.pdf", outpdf, &num_pages, &first_image))
+    return (1);
+
+  if (read_unit_file("testpdfio-rc4p.pdf", num_pages, first_image, false))
+    return (1);
+
+  fputs("pdfioFileCreate(\"testpdfio-aes.pdf\", ...): ", stdout);
+  if ((outpdf = pdfioFileCreate("testpdfio-aes.pdf", NULL, NULL, NULL, (pdfio_error_cb_t)error_cb, &error)) != NULL)
+    puts("PASS");
+  else
+    return (1);
+
+  fputs("pdfioFileSetPermissions(all, AES-128, no passwords): ", stdout);
+  if (pdfioFileSetPermissions(outpdf, PDFIO_PERMISSION_ALL, PDFIO_ENCRYPTION_AES_128, NULL, NULL))
+    puts("PASS");
+  else
+    return (1);
+
+  if (write_unit_file(inpdf, "testpdfio-aes.pdf", outpdf, &num_pages, &first_image))
+    return (1);
+
+  if (read_unit_file("testpdfio-aes.pdf", num_pages, first_image, false))
+    return (1);
+
+  if (write_update_file("testpdfio-aes.pdf", "testpdfio-aesupdate.pdf", num_pages, first_image))
+    return (1);
+
+  fputs("pdfioFileCreate(\"testpdfio-aesp.pdf\", ...): ", stdout);
+  if ((outpdf = pdfioFileCreate("testpdfio-aesp.pdf", NULL, NULL, NULL, (pdfio_error_cb_t)error_cb, &error)) != NULL)
+    puts("PASS");
+  else
+    return (1);
+
+  fputs("pdfioFileSetPermissions(no-print, AES-128, passwords='owner' and 'user'): ", stdout);
+  if (pdfioFileSetPermissions(outpdf, PDFIO_PERMISSION_ALL ^ PDFIO_PERMISSION_PRINT, PDFIO_ENCRYPTION_AES_128, "owner", "user"))
+    puts("PASS");
+  else
+    return (1);
+
+  if (write_unit_file(inpdf, "testpdfio-aesp.pdf", outpdf, &num_pages, &first_image))
+    return (1);
+
+  if (read_unit_file("testpdfio-aesp.pdf", num_pages, first_image, false))
+    return (1);
+
+  fputs("pdfioFileCreate(\"testpdfio-aesobjstm.pdf\", ...): ", stdout);
+  if ((outpdf = pdfioFileCreate("testpdfio-aesobjstm.pdf", NULL, NULL, NULL, (pdfio_error_cb_t)error_cb, &error)) != NULL)
+    puts("PASS");
+  else
+    return (1);
+
+  fputs("pdfioFileSetOptions(PDFIO_OPTION_OBJSTREAMS): ", stdout);
+  if (pdfioFileSetOptions(outpdf, PDFIO_OPTION_OBJSTREAMS))
+    puts("PASS");
+  else
+    return (1);
+
+  fputs("pdfioFileSetPermissions(all, AES-128, no passwords): ", stdout);
+  if (pdfioFileSetPermissions(outpdf, PDFIO_PERMISSION_ALL, PDFIO_ENCRYPTION_AES_128, NULL, NULL))
+    puts("PASS");
+  else
+    return (1);
+
+  if (write_unit_file(inpdf, "testpdfio-aesobjstm.pdf", outpdf, &num_pages, &first_image))
+    return (1);
+
+  if (read_unit_file("testpdfio-aesobjstm.pdf", num_pages, first_image, false))
+    return (1);
+
+  if (read_concurrent_file("testpdfio-aesobjstm.pdf"))
+    return (1);
+
+  if (read_objstms_file("testpdfio-aesobjstm.pdf"))
+    return (1);
+
+  if (read_io_file("testpdfio-aesobjstm.pdf"))
+    return (1);
+
+  fputs("pdfioFileCreate(\"testpdfio-aesparallel.pdf\", ...): ", stdout);
+  if ((outpdf = pdfioFileCreate("testpdfio-aesparallel.pdf", NULL, NULL, NULL, (pdfio_error_cb_t)error_cb, &error)) != NULL)
+    puts("PASS");
+  else
+    return (1);
+
+  fputs("pdfioFileSetOptions(PDFIO_OPTION_PARALLEL): ", stdout);
+  if (pdfioFileSetOptions(outpdf, PDFIO_OPTION_PARALLEL))
+    puts("PASS");
+  else
+    return (1);
+
+  fputs("pdfioFileSetPermissions(all, AES-128, no passwords): ", stdout);
+  if (pdfioFileSetPermissions(outpdf, PDFIO_PERMISSION_ALL, PDFIO_ENCRYPTION_AES_128, NULL, NULL))
+    puts("PASS");
+  else
+    return (1);
+
+  if (write_unit_file(inpdf, "testpdfio-aesparallel.pdf", outpdf, &num_pages, &first_image))
+    return (1);
+
+  if (read_unit_file("testpdfio-aesparallel.pdf", num_pages, first_image, false))
+    return (1);
+
+  fputs("pdfioFileCreateTemporary: ", stdout);
+  if ((outpdf = pdfioFileCreateTemporary(temppdf, sizeof(temppdf), NULL, NULL, NULL, (pdfio_error_cb_t)error_cb, &error)) != NULL)
+    printf("PASS (%s)\n", temppdf);
+  else
+    return (1);
+
+  if (write_unit_file(inpdf, "<temporary>", outpdf, &num_pages, &first_image))
+    return (1);
+
+  if (read_unit_file(temppdf, num_pages, first_image, false))
+    return (1);
+
+  pdfioFileClose(inpdf);
+
+  return (0);
+
+  fail:
+
+  pdfioFileClose(inpdf);
+
+  return (1);
+}
+
+
+//
+// 'draw_image()' - Draw an image with a label.
+//
+
+static int				// O - 1 on failure, 0 on success
+draw_image(pdfio_stream_t *st,
+           const char     *name,	// I - Name
+           double         x,		// I - X offset
+           double         y,		// I - Y offset
+           double         w,		// I - Image width
+           double         h,		// I - Image height
+           const char     *label)	// I - Label
+{
+  printf("pdfioContentDrawImage(name=\"%s\", x=%g, y=%g, w=%g, h=%g): ", name, x, y, w, h);
+  if (pdfioContentDrawImage(st, name, x, y, w, h))
+    puts("PASS");
+  else
+    return (1);
+
+  fputs("pdfioContentTextBegin(): ", stdout);
+  if (pdfioContentTextBegin(st))
+    puts("PASS");
+  else
+    return (1);
+
+  fputs("pdfioContentSetTextFont(\"F1\", 18.0): ", stdout);
+  if (pdfioContentSetTextFont(st, "F1", 18.0))
+    puts("PASS");
+  else
+    return (1);
+
+  printf("pdfioContentTextMoveTo(%g, %g): ", x, y + h + 9);
+  if (pdfioContentTextMoveTo(st, x, y + h + 9))
+    puts("PASS");
+  else
+    return (1);
+
+  printf("pdfioContentTextShow(\"%s\"): ", label);
+  if (pdfioContentTextShow(st, false, label))
+    puts("PASS");
+  else
+    return (1);
+
+  fputs("pdfioContentTextEnd(): ", stdout);
+  if (pdfioContentTextEnd(st))
+    puts("PASS");
+  else
+    return (1);
+
+  return (0);
+}
+
+
+//
+// 'error_cb()' - Display an error message during a unit test.
+//
+
+static bool				// O  - `true` to stop, `false` to continue
+error_cb(pdfio_file_t *pdf,		// I  - PDF file
+         const char   *message,		// I  - Error message
+	 bool         *error)		// IO - Have we displayed an error?
+{
+  (void)pdf;
+
+  if (!*error)
+  {
+    // First error, so show a "FAIL" indicator
+    *error = true;
+
+    puts("FAIL");
+  }
+
+  // Indent error messages...
+  printf("    %s\n", message);
+
+  // Continue to catch more errors...
+  return (false);
+}
+
+
+//
+// 'get_heap_bytes()' - Get the number of bytes allocated from the heap.
+//
+// Returns `0` if the C library does not provide heap statistics.
+//
+
+static size_t				// O - Bytes allocated or `0` if unknown
+get_heap_bytes(void)
+{
+#ifdef __APPLE__
+  malloc_statistics_t	stats;		// Heap statistics
+
+
+  malloc_zone_statistics(NULL, &stats);
+
+  return (stats.size_in_use);
+
+#elif defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+  struct mallinfo2	info = mallinfo2();
+					// Heap statistics
+
+
+  return (info.uordblks + info.hblkhd);
+
+#else
+  return (0);
+#endif // __APPLE__
+}
+
+
+//
+// 'hash_page()' - Compute a FNV-1a hash of the content and image streams on a page.
+//
+
+static bool				// O - `true` on success, `false` on error
+hash_page(pdfio_obj_t *page,		// I - Page object
+          uint32_t    *hash)		// O - Hash value
+{
+  size_t	i,			// Looping var
+		count;			// Number of streams/XObjects
+  pdfio_dict_t	*xobjects;		// XObject dictionary
+  pdfio_stream_t *st;			// Current stream
+  unsigned char	buffer[1024],		// Read buffer
+		*bufptr;		// Pointer into buffer
+  ssize_t	bytes;			// Bytes read
+
+
+  *hash = 2166136261U;
+
+  if (!page)
+    return (false);
+
+  xobjects = pdfioDictGetDict(pdfioDictGetDict(pdfioObjGetDict(page), "Resources"), "XObject");
+  count    = pdfioPageGetNumStreams(page) + pdfioDictGetNumPairs(xobjects);
+
+  for (i = 0; i < count; i ++)
+  {
+    if (i < pdfioPageGetNumStreams(page))
+    {
+      st = pdfioPageOpenStream(page, i, true);
+    }
+    else
+    {
+      // Only decode Flate-compressed images...
+      pdfio_obj_t *xobject = pdfioDictGetObj(xobjects, pdfioDictGetKey(xobjects, i - pdfioPageGetNumStreams(page)));
+					// XObject
+      const char  *filter = pdfioDictGetName(pdfioObjGetDict(xobject), "Filter");
+					// Compression filter
+
+      st = pdfioObjOpenStream(xobject, filter && !strcmp(filter, "FlateDecode"));
+    }
+
+    if (!st)
+      return (false);
+
+    while ((bytes = pdfioStreamRead(st, buffer, sizeof(buffer))) > 0)
+    {
+      for (bufptr = buffer; bytes > 0; bytes --, bufptr ++)
+      {
+        *hash ^= *bufptr;
+        *hash *= 16777619U;
+      }
+    }
+
+    pdfioStreamClose(st);
+  }
+
+  return (true);
+}
+
+
+//
+// 'image_cb()' - Generate a line of image data for pdfioFileCreateImageObjFromCallback.
+//
+
+static bool				// O - `true` on success, `false` on error
+image_cb(image_data_t  *data,		// I - Image callback data
+         size_t        y,		// I - Line number
+         unsigned char *line,		// I - Line buffer
+         size_t        linelen)		// I - Length of line buffer
+{
+  size_t	x,			// X position in line
+		c,			// Color number
+		bpp = data->alpha ? data->num_colors + 1 : data->num_colors;
+					// Bytes per pixel
+
+
+  if (linelen % bpp)
+    return (false);
+
+  for (x = 0; x < (linelen / bpp); x ++)
+  {
+    for (c = 0; c < data->num_colors; c ++)
+      *line++ = (unsigned char)(x * (c + 1) + y);
+
+    if (data->alpha)
+      *line++ = (unsigned char)(x ^ y);
+  }
+
+  data->lines ++;
+
+  return (true);
+}
+
+
+//
+// 'input_cb()' - Read PDF file data from memory for pdfioFileOpenIO.
+//
+
+static ssize_t				// O - Number of bytes read
+input_cb(io_data_t *io,			// I - Input callback data
+         off_t     offset,		// I - Offset in file
+         void      *buffer,		// I - Read buffer
+         size_t    bytes)		// I - Number of bytes to read
+{
+  if (offset < 0 || (size_t)offset >= io->datalen)
+    return (0);
+
+  if (bytes > (io->datalen - (size_t)offset))
+    bytes = io->datalen - (size_t)offset;
+
+  memcpy(buffer, io->data + offset, bytes);
+
+  io->reads ++;
+  io->bytes += bytes;
+
+  return ((ssize_t)bytes);
+}
+
+
+//
+// 'iterate_cb()' - Test pdfioDictIterateKeys function.
+//
+
+static bool				// O - `true` to continue, `false` to stop
+iterate_cb(pdfio_dict_t *dict,		// I - Dictionary
+           const char   *key,		// I - Key
+           void         *cb_data)	// I - Callback data
+{
+  int	*count = (int *)cb_data;	// Pointer to counter
+
+
+  if (!dict || !key || !cb_data)
+    return (false);
+
+  (*count)++;
+
+  return (true);
+}
+
+
+//
+// 'number_printf()' - Format numbers using the PDFio formatter.
+//
+
+static ssize_t				// O - Number of bytes
+number_printf(pdfio_file_t *pdf,	// I - PDF file
+              char         *buffer,	// I - Output buffer
+              size_t       bufsize,	// I - Size of output buffer
+              const char   *format,	// I - `printf`-style format string
+              ...)			// I - Additional arguments
+{
+  ssize_t	bytes;			// Number of bytes
+  va_list	ap;			// Argument pointer
+
+
+  va_start(ap, format);
+  bytes = _pdfio_vsnprintf(pdf, buffer, bufsize, format, ap);
+  va_end(ap);
+
+  return (bytes);
+}
+
+
+//
+// 'object_key_cb()' - Read encrypted objects from a PDF file, possibly in a separate thread.
+//
+
+#ifdef _WIN32
+static DWORD WINAPI			// O - Exit status
+#else
+static void *				// O - Exit status
+#endif // _WIN32
+object_key_cb(object_key_data_t *data)	// I - Callback data
+{
+  size_t	i, j,			// Looping vars
+		number;			// Object number
+  pdfio_obj_t	*obj;			// Current object
+  pdfio_stream_t *st;			// Object stream
+  const char	*title;			// Title string
+  char		expected[256],		// Expected text
+		buffer[256];		// Read buffer
+  ssize_t	bytes;			// Bytes read
+
+
+  data->passed = false;
+
+  for (i = 0; i < data->passes; i ++)
+  {
+    for (j = 0; j < data->num_numbers; j ++)
+    {
+      number = data->numbers[(data->first + j) % data->num_numbers];
+
+      if ((obj = pdfioFileFindObj(data->pdf, number)) == NULL)
+        return (0);
+
+      snprintf(expected, sizeof(expected), "Encrypted object %u", (unsigned)number);
+      if ((title = pdfioDictGetString(pdfioObjGetDict(obj), "Title")) == NULL || strcmp(title, expected))
+        return (0);
+
+      snprintf(expected, sizeof(expected), "Object %u: Now is the time for all good men to come to the aid of their country.\n", (unsigned)number);
+      if ((st = pdfioObjOpenStream(obj, true)) == NULL)
+        return (0);
+
+      bytes = pdfioStreamRead(st, buffer, sizeof(buffer));
+      pdfioStreamClose(st);
+
+      if (bytes != (ssize_t)strlen(expected) || memcmp(buffer, expected, (size_t)bytes))
+        return (0);
+    }
+  }
+
+  data->passed = true;
+
+  return (0);
+}
+
+
+//
+// 'output_cb()' - Write output to a file.
+//
+
+static ssize_t				// O - Number of bytes written
+output_cb(int        *fd,		// I - File descriptor
+          const void *buffer,		// I - Output buffer
+          size_t     bytes)		// I - Number of bytes to write
+{
+  return (write(*fd, buffer, bytes));
+}
+
+
+//
+// 'password_cb()' - Password callback for PDF file.
+//
+
+static const char *			// O - Password string
+password_cb(void       *data,		// I - Callback data
+            const char *filename)	// I - Filename (not used)
+{
+  (void)filename;
+
+  return ((const char *)data);
+}
+
+
+//
+// 'read_cached_file()' - Read a PDF file with a small object value cache.
+//
+
+static int				// O - Exit status
+read_cached_file(const char *filename)	// I - File to read
+{
+  int		ret = 1;		// Exit status
+  pdfio_file_t	*pdf;			// PDF file
+  pdfio_obj_t	*obj;			// Current object
+  size_t	i,			// Looping var
+		num_objs,		// Number of objects
+		num_pages,		// Number of pages
+		num_evicted;		// Number of evicted objects
+  uint32_t	*hashes = NULL,		// Expected page hashes
+		hash;			// Current page hash
+  pdfio_valtype_t *types = NULL;	// Expected object types
+  bool		error = false;		// Error callback data
+
+
+  // Get the object types and page hashes without a cache...
+  printf("pdfioFileOpen(\"%s\", ...): ", filename);
+  if ((pdf = pdfioFileOpen(filename, password_cb, (void *)"user", (pdfio_error_cb_t)error_cb, &error)) != NULL)
+    puts("PASS");
+  else
+    return (1);
+
+  num_objs  = pdfioFileGetNumObjs(pdf);
+  num_pages = pdfioFileGetNumPages(pdf);
+
+  if ((hashes = (uint32_t *)calloc(num_pages, sizeof(uint32_t))) == NULL || (types = (pdfio_valtype_t *)calloc(num_objs, sizeof(pdfio_valtype_t))) == NULL)
+  {
+    puts("FAIL (unable to allocate memory)");
+    goto done;
+  }
+
+  for (i = 0; i < num_objs; i ++)
+  {
+    if ((obj = pdfioFileGetObj(pdf, i)) != NULL && _pdfioObjLoad(obj))
+      types[i] = obj->value.type;
+  }
+
+  for (i = 0; i < num_pages; i ++)
+  {
+    if (!hash_page(pdfioFileGetPage(pdf, i), hashes + i))
+    {
+      printf("hash_page: FAIL (page %u)\n", (unsigned)(i + 1));
+      goto done;
+    }
+  }
+
+  pdfioFileClose(pdf);
+
+  // Then re-open the file with a small cache...
+  printf("pdfioFileOpen(\"%s\", ...): ", filename);
+  if ((pdf = pdfioFileOpen(filename, password_cb, (void *)"user", (pdfio_error_cb_t)error_cb, &error)) != NULL)
+    puts("PASS");
+  else
+    goto done;
+
+  fputs("pdfioFileSetCacheSize(4096): ", stdout);
+  if (pdfioFileSetCacheSize(pdf, 4096))
+    puts("PASS");
+  else
+    goto done;
+
+  fputs("_pdfioObjLoad(all objects): ", stdout);
+  for (i = 0; i < num_objs; i ++)
+  {
+    if ((obj = pdfioFileGetObj(pdf, i)) == NULL || !_pdfioObjLoad(obj) || obj->value.type != types[i])
+    {
+      printf("FAIL (object %u)\n", (unsigned)i);
+      goto done;
+    }
+
+    if (pdf->cache_bytes > 4096 && pdf->cache_first != pdf->cache_last)
+    {
+      printf("FAIL (object %u, %u bytes cached)\n", (unsigned)i, (unsigned)pdf->cache_bytes);
+      goto done;
+    }
+  }
+
+  for (i = 0, num_evicted = 0; i < num_objs; i ++)
+  {
+    if ((obj = pdfioFileGetObj(pdf, i)) != NULL && obj->value.type == PDFIO_VALTYPE_NONE)
+      num_evicted ++;
+  }
+
+  if (num_evicted == 0)
+  {
+    puts("FAIL (no objects evicted)");
+    goto done;
+  }
+
+  printf("PASS (%u objects evicted)\n", (unsigned)num_evicted);
+
+  fputs("pdfioObjGetType(evicted objects): ", stdout);
+  for (i = 0; i < num_objs; i ++)
+  {
+    if ((obj = pdfioFileGetObj(pdf, i)) != NULL && obj->value.type == PDFIO_VALTYPE_NONE && (!_pdfioObjLoad(obj) || obj->value.type != types[i]))
+    {
+      printf("FAIL (object %u)\n", (unsigned)i);
+      goto done;
+    }
+  }
+
+  puts("PASS");
+
+  fputs("hash_page: ", stdout);
+  for (i = 0; i < num_pages; i ++)
+  {
+    if (!hash_page(pdfioFileGetPage(pdf, i), &hash) || hash != hashes[i])
+    {
+      printf("FAIL (page %u)\n", (unsigned)(i + 1));
+      goto done;
+    }
+  }
+
+  printf("PASS (%u pages)\n", (unsigned)num_pages);
+
+  ret = 0;
+
+  done:
+
+  free(hashes);
+  free(types);
+  pdfioFileClose(pdf);
+
+  return (ret);
+}
+
+
+//
+// 'read_codec_file()' - Read a PDF file using a decompression callback.
+//
+
+static int				// O - Exit status
+read_codec_file(const char *filename)	// I - File to read
+{
+  int		ret = 1;		// Exit status
+  pdfio_file_t	*pdf;			// PDF file
+  size_t	i,			// Looping var
+		num_pages;		// Number of pages
+  uint32_t	*hashes = NULL,		// Expected page hashes
+		hash;			// Page hash
+  codec_data_t	data = { 0, 0 };	// Callback data
+  bool		error = false;		// Error callback data
+
+
+  // Hash all of the pages using ZLIB...
+  printf("pdfioFileOpen(\"%s\", ...): ", filename);
+  if ((pdf = pdfioFileOpen(filename, NULL, NULL, (pdfio_error_cb_t)error_cb, &error)) != NULL)
+    puts("PASS");
+  else
+    return (1);
+
+  num_pages = pdfioFileGetNumPages(pdf);
+
+  fputs("hash_page: ", stdout);
+  if ((hashes = (uint32_t *)calloc(num_pages, sizeof(uint32_t))) == NULL)
+  {
+    puts("FAIL (unable to allocate memory)");
+    goto done;
+  }
+
+  for (i = 0; i < num_pages; i ++)
+  {
+    if (!hash_page(pdfioFileGetPage(pdf, i), hashes + i))
+    {
+      printf("FAIL (page %u)\n", (unsigned)(i + 1));
+      goto done;
+    }
+  }
+
+  printf("PASS (%u pages)\n", (unsigned)num_pages);
+
+  pdfioFileClose(pdf);
+
+  // Then re-open the file and hash the pages using the callback...
+  printf("pdfioFileOpen(\"%s\", ...): ", filename);
+  if ((pdf = pdfioFileOpen(filename, NULL, NULL, (pdfio_error_cb_t)error_cb, &error)) != NULL)
+    puts("PASS");
+  else
+    goto done;
+
+  fputs("pdfioFileSetCodec(inflate): ", stdout);
+  if (pdfioFileSetCodec(pdf, NULL, (pdfio_inflate_cb_t)codec_inflate_cb, &data))
+    puts("PASS");
+  else
+    goto done;
+
+  fputs("codec_inflate_cb: ", stdout);
+  for (i = 0; i < num_pages; i ++)
+  {
+    if (!hash_page(pdfioFileGetPage(pdf, i), &hash))
+    {
+      printf("FAIL (page %u)\n", (unsigned)(i + 1));
+      goto done;
+    }
+    else if (hash != hashes[i])
+    {
+      printf("FAIL (page %u hash %08X, expected %08X)\n", (unsigned)(i + 1), hash, hashes[i]);
+      goto done;
+    }
+  }
+
+  if (data.inflates > 0)
+  {
+    printf("PASS (%u calls)\n", (unsigned)data.inflates);
+    ret = 0;
+  }
+  else
+  {
+    puts("FAIL (not called)");
+  }
+
+  done:
+
+  free(hashes);
+  pdfioFileClose(pdf);
+
+  return (ret);
+}
+
+
+//
+// 'read_concurrent_file()' - Read the pages of a PDF file from multiple threads.
+//
+
+static int				// O - Exit status
+read_concurrent_file(
+    const char *filename)		// I - File to read
+{
+  int		ret = 1;		// Exit status
+  pdfio_file_t	*pdf;			// PDF file
+  size_t	i,			// Looping var
+		num_pages;		// Number of pages
+  uint32_t	*hashes = NULL;		// Expected page hashes
+  pdfio_stream_t *st[2];		// Streams open at the same time
+  concurrent_data_t data[4];		// Thread data
+#ifdef _WIN32
+  HANDLE	threads[4];		// Threads
+#else
+  pthread_t	threads[4];		// Threads
+#endif // _WIN32
+  bool		error = false;		// Error callback data
+
+
+  // Hash all of the pages from a single thread...
+  printf("pdfioFileOpen(\"%s\", ...): ", filename);
+  if ((pdf = pdfioFileOpen(filename, password_cb, (void *)"user", (pdfio_error_cb_t)error_cb, &error)) != NULL)
+    puts("PASS");
+  else
+    return (1);
+
+  num_pages = pdfioFileGetNumPages(pdf);
+
+  fputs("hash_page: ", stdout);
+  if ((hashes = (uint32_t *)calloc(num_pages, sizeof(uint32_t))) == NULL)
+  {
+    puts("FAIL (unable to allocate memory)");
+    goto done;
+  }
+
+  for (i = 0; i < num_pages; i ++)
+  {
+    if (!hash_page(pdfioFileGetPage(pdf, i), hashes + i))
+    {
+      printf("FAIL (page %u)\n", (unsigned)(i + 1));
+      goto done;
+    }
+  }
+
+  printf("PASS (%u pages)\n", (unsigned)num_pages);
+
+  fputs("pdfioFileSetConcurrent(false): ", stdout);
+  if (pdfioFileSetConcurrent(pdf, false))
+    puts("PASS");
+  else
+    goto done;
+
+  pdfioFileClose(pdf);
+
+  // Then re-open the file and hash the pages from multiple threads...
+  printf("pdfioFileOpen(\"%s\", ...): ", filename);
+  if ((pdf = pdfioFileOpen(filename, password_cb, (void *)"user", (pdfio_error_cb_t)error_cb, &error)) != NULL)
+    puts("PASS");
+  else
+    goto done;
+
+  fputs("pdfioFileSetConcurrent(true): ", stdout);
+  if (pdfioFileSetConcurrent(pdf, true))
+    puts("PASS");
+  else
+    goto done;
+
+  fputs("pdfioPageOpenStream(multiple): ", stdout);
+  if ((st[0] = pdfioPageOpenStream(pdfioFileGetPage(pdf, 0), 0, true)) == NULL)
+  {
+    puts("FAIL (first stream)");
+    goto done;
+  }
+
+  if ((st[1] = pdfioPageOpenStream(pdfioFileGetPage(pdf, 1), 0, true)) == NULL)
+  {
+    puts("FAIL (second stream)");
+    pdfioStreamClose(st[0]);
+    goto done;
+  }
+
+  pdfioStreamClose(st[0]);
+  pdfioStreamClose(st[1]);
+  puts("PASS");
+
+  fputs("concurrent_cb: ", stdout);
+  for (i = 0; i < (sizeof(data) / sizeof(data[0])); i ++)
+  {
+    data[i].pdf    = pdf;
+    data[i].first  = i;
+    data[i].step   = sizeof(data) / sizeof(data[0]);
+    data[i].hashes = hashes;
+    data[i].passed = false;
+
+#ifdef _WIN32
+    threads[i] = CreateThread(NULL, 0, (LPTHREAD_START_ROUTINE)concurrent_cb, data + i, 0, NULL);
+#else
+    pthread_create(threads + i, NULL, (void *(*)(void *))concurrent_cb, data + i);
+#endif // _WIN32
+  }
+
+  for (i = 0; i < (sizeof(data) / sizeof(data[0])); i ++)
+  {
+#ifdef _WIN32
+    WaitForSingleObject(threads[i], INFINITE);
+    CloseHandle(threads[i]);
+#else
+    pthread_join(threads[i], NULL);
+#endif // _WIN32
+  }
+
+  for (i = 0; i < (sizeof(data) / sizeof(data[0])); i ++)
+  {
+    if (!data[i].passed)
+      break;
+  }
+
+  if (i < (sizeof(data) / sizeof(data[0])))
+  {
+    printf("FAIL (thread %u)\n", (unsigned)(i + 1));
+    goto done;
+  }
+
+  printf("PASS (%u threads)\n", (unsigned)i);
+
+  ret = 0;
+
+  done:
+
+  free(hashes);
+  pdfioFileClose(pdf);
+
+  return (ret);
+}
+
+
+//
+// 'read_io_file()' - Read a PDF file using an input callback.
+//
+
+static int				// O - Exit status
+read_io_file(const char *filename)	// I - File to read
+{
+  int		ret = 1;		// Exit status
+  pdfio_file_t	*pdf;			// PDF file
+  int		fd;			// File descriptor
+  struct stat	fileinfo;		// File information
+  io_data_t	io;			// Input callback data
+  size_t	i,			// Looping var
+		num_pages;		// Number of pages
+  uint32_t	*hashes = NULL,		// Expected page hashes
+		hash;			// Page hash
+  concurrent_data_t data[4];		// Thread data
+#ifdef _WIN32
+  HANDLE	threads[4];		// Threads
+#else
+  pthread_t	threads[4];		// Threads
+#endif // _WIN32
+  bool		error = false;		// Error callback data
+
+
+  // Load the file into memory and hash the pages using pdfioFileOpen...
+  memset(&io, 0, sizeof(io));
+
+  if ((fd = open(filename, O_RDONLY | O_BINARY)) < 0 || fstat(fd, &fileinfo) || (io.data = (unsigned char *)malloc((size_t)fileinfo.st_size)) == NULL || read(fd, io.data, (size_t)fileinfo.st_size) != (ssize_t)fileinfo.st_size)
+  {
+    printf("read_io_file: Unable to load \"%s\": %s\n", filename, strerror(errno));
+    if (fd >= 0)
+      close(fd);
+    free(io.data);
+    return (1);
+  }
+
+  close(fd);
+
+  io.datalen = (size_t)fileinfo.st_size;
+
+  if ((pdf = pdfioFileOpen(filename, password_cb, (void *)"user", (pdfio_error_cb_t)error_cb, &error)) == NULL)
+    goto done;
+
+  num_pages = pdfioFileGetNumPages(pdf);
+
+  if ((hashes = (uint32_t *)calloc(num_pages, sizeof(uint32_t))) == NULL)
+  {
+    pdfioFileClose(pdf);
+    goto done;
+  }
+
+  for (i = 0; i < num_pages; i ++)
+    hash_page(pdfioFileGetPage(pdf, i), hashes + i);
+
+  pdfioFileClose(pdf);
+
+  // Then open the file using the input callback and compare...
+  printf("pdfioFileOpenIO(\"%s\", ...): ", filename);
+  if ((pdf = pdfioFileOpenIO((pdfio_input_cb_t)input_cb, &io, (off_t)io.datalen, password_cb, (void *)"user", (pdfio_error_cb_t)error_cb, &error)) != NULL)
+  {
+    printf("PASS (%u reads, %u bytes)\n", (unsigned)io.reads, (unsigned)io.bytes);
+  }
+  else
+  {
+    goto done;
+  }
+
+  fputs("pdfioFileGetNumPages(io): ", stdout);
+  if (pdfioFileGetNumPages(pdf) == num_pages)
+  {
+    puts("PASS");
+  }
+  else
+  {
+    printf("FAIL (got %u, expected %u)\n", (unsigned)pdfioFileGetNumPages(pdf), (unsigned)num_pages);
+    pdfioFileClose(pdf);
+    goto done;
+  }
+
+  fputs("hash_page(io): ", stdout);
+  for (i = 0; i < num_pages; i ++)
+  {
+    if (!hash_page(pdfioFileGetPage(pdf, i), &hash) || hash != hashes[i])
+      break;
+  }
+
+  if (i < num_pages)
+  {
+    printf("FAIL (page %u)\n", (unsigned)(i + 1));
+    pdfioFileClose(pdf);
+    goto done;
+  }
+  else if (io.bytes > (2 * io.datalen))
+  {
+    printf("FAIL (read %u bytes for %u byte file)\n", (unsigned)io.bytes, (unsigned)io.datalen);
+    pdfioFileClose(pdf);
+    goto done;
+  }
+
+  printf("PASS (%u reads, %u bytes)\n", (unsigned)io.reads, (unsigned)io.bytes);
+
+  pdfioFileClose(pdf);
+
+  // Finally hash the pages from multiple threads...
+  if ((pdf = pdfioFileOpenIO((pdfio_input_cb_t)input_cb, &io, (off_t)io.datalen, password_cb, (void *)"user", (pdfio_error_cb_t)error_cb, &error)) == NULL)
+    goto done;
+
+  fputs("concurrent_cb(io): ", stdout);
+  if (!pdfioFileSetConcurrent(pdf, true))
+  {
+    pdfioFileClose(pdf);
+    goto done;
+  }
+
+  for (i = 0; i < (sizeof(data) / sizeof(data[0])); i ++)
+  {
+    data[i].pdf    = pdf;
+    data[i].first  = i;
+    data[i].step   = sizeof(data) / sizeof(data[0]);
+    data[i].hashes = hashes;
+    data[i].passed = false;
+
+#ifdef _WIN32
+    threads[i] = CreateThread(NULL, 0, (LPTHREAD_START_ROUTINE)concurrent_cb, data + i, 0, NULL);
+#else
+    pthread_create(threads + i, NULL, (void *(*)(void *))concurrent_cb, data + i);
+#endif // _WIN32
+  }
+
+  for (i = 0; i < (sizeof(data) / sizeof(data[0])); i ++)
+  {
+#ifdef _WIN32
+    WaitForSingleObject(threads[i], INFINITE);
+    CloseHandle(threads[i]);
+#else
+    pthread_join(threads[i], NULL);
+#endif // _WIN32
+  }
+
+  pdfioFileClose(pdf);
+
+  for (i = 0; i < (sizeof(data) / sizeof(data[0])); i ++)
+  {
+    if (!data[i].passed)
+      break;
+  }
+
+  if (i < (sizeof(data) / sizeof(data[0])))
+  {
+    printf("FAIL (thread %u)\n", (unsigned)(i + 1));
+    goto done;
+  }
+
+  printf("PASS (%u threads)\n", (unsigned)i);
+
+  ret = 0;
+
+  done:
+
+  free(hashes);
+  free(io.data);
+
+  return (ret);
+}
+
+
+//
+// 'read_linearized_file()' - Read a linearized PDF file and check the linearization dictionary.
+//
+// Since objects are renumbered in a linearized PDF file, the number of the
+// first image on the images test page is also returned.
+//
+
+static int				// O - Exit status
+read_linearized_file(
+    const char *filename,		// I - File to read
+    size_t     num_pages,		// I - Expected number of pages
+    size_t     *first_image)		// O - First image object
+{
+  int		fd;			// File descriptor
+  char		header[1025],		// Start of file
+		*ptr;			// Pointer into header
+  ssize_t	bytes;			// Bytes read
+  struct stat	fileinfo;		// File information
+  unsigned long	length = 0,		// File length
+		hint_offset = 0,	// Offset of hint stream
+		hint_length = 0,	// Length of hint stream
+		first_page = 0,		// First page object number
+		first_end = 0,		// End of first page
+		pages = 0,		// Number of pages
+		xref = 0;		// Offset of main xref table
+  pdfio_file_t	*pdf;			// PDF file
+  pdfio_obj_t	*page;			// First page
+  pdfio_dict_t	*xobject;		// XObject resources for page
+  size_t	i;			// Looping var
+  bool		error = false;		// Error?
+
+
+  printf("Linearization dictionary of \"%s\": ", filename);
+
+  if ((fd = open(filename, O_RDONLY | O_BINARY)) < 0 || fstat(fd, &fileinfo))
+  {
+    printf("FAIL (%s)\n", strerror(errno));
+    if (fd >= 0)
+      close(fd);
+    return (1);
+  }
+
+  bytes = read(fd, header, sizeof(header) - 1);
+  close(fd);
+
+  if (bytes <= 0)
+  {
+    puts("FAIL (unable to read file)");
+    return (1);
+  }
+
+  header[bytes] = '\0';
+
+  if ((ptr = strstr(header, "/Linearized 1")) == NULL || sscanf(ptr, "/Linearized 1/L %lu /H[%lu %lu ]/O %lu/E %lu /N %lu/T %lu", &length, &hint_offset, &hint_length, &first_page, &first_end, &pages, &xref) != 7)
+  {
+    puts("FAIL (missing or bad dictionary)");
+    return (1);
+  }
+
+  if (length != (unsigned long)fileinfo.st_size || pages != num_pages || hint_offset >= first_end || first_end >= xref || xref >= length)
+  {
+    printf("FAIL (got L=%lu, H=[%lu %lu], E=%lu, N=%lu, T=%lu, expected L=%lu, N=%lu)\n", length, hint_offset, hint_length, first_end, pages, xref, (unsigned long)fileinfo.st_size, (unsigned long)num_pages);
+    return (1);
+  }
+
+  puts("PASS");
+
+  printf("pdfioFileOpen(\"%s\", ...): ", filename);
+  if ((pdf = pdfioFileOpen(filename, NULL, NULL, (pdfio_error_cb_t)error_cb, &error)) == NULL)
+    return (1);
+  puts("PASS");
+
+  fputs("pdfioFileGetPage(0): ", stdout);
+  if ((page = pdfioFileGetPage(pdf, 0)) == NULL)
+  {
+    puts("FAIL");
+    pdfioFileClose(pdf);
+    return (1);
+  }
+  else if (pdfioObjGetNumber(page) != first_page)
+  {
+    printf("FAIL (got object %lu, expected %lu)\n", (unsigned long)pdfioObjGetNumber(page), first_page);
+    pdfioFileClose(pdf);
+    return (1);
+  }
+  puts("PASS");
+
+  fputs("Find images test page: ", stdout);
+  for (i = 0, *first_image = 0; i < pdfioFileGetNumPages(pdf); i ++)
+  {
+    xobject = pdfioDictGetDict(pdfioDictGetDict(pdfioObjGetDict(pdfioFileGetPage(pdf, i)), "Resources"), "XObject");
+
+    if (pdfioDictGetObj(xobject, "IM15"))
+    {
+      *first_image = pdfioObjGetNumber(pdfioDictGetObj(xobject, "IM1"));
+      break;
+    }
+  }
+
+  pdfioFileClose(pdf);
+
+  if (*first_image)
+  {
+    printf("PASS (page %lu, first image %lu)\n", (unsigned long)(i + 1), (unsigned long)*first_image);
+    return (0);
+  }
+  else
+  {
+    puts("FAIL");
+    return (1);
+  }
+}
+
+//
+// 'read_objstms_file()' - Load all object streams in a PDF file using threads.
+//
+
+static int				// O - Exit status
+read_objstms_file(
+    const char *filename)		// I - File to read
+{
+  int		ret = 1;		// Exit status
+  pdfio_file_t	*pdf;			// PDF file
+  size_t	i,			// Looping var
+		num_pages;		// Number of pages
+  uint32_t	*hashes = NULL,		// Expected page hashes
+		hash;			// Page hash
+  pdfio_stats_t	stats;			// I/O statistics
+  size_t	objstms_loaded;		// Object streams loaded by pdfioFileLoadObjStreams
+  bool		error = false;		// Error callback data
+
+
+  // Hash all of the pages, loading object streams as needed...
+  printf("pdfioFileOpen(\"%s\", ...): ", filename);
+  if ((pdf = pdfioFileOpen(filename, password_cb, (void *)"user", (pdfio_error_cb_t)error_cb, &error)) != NULL)
+    puts("PASS");
+  else
+    return (1);
+
+  num_pages = pdfioFileGetNumPages(pdf);
+
+  if ((hashes = (uint32_t *)calloc(num_pages, sizeof(uint32_t))) == NULL)
+  {
+    puts("FAIL (unable to allocate memory)");
+    goto close_pdf;
+  }
+
+  for (i = 0; i < num_pages; i ++)
+    hash_page(pdfioFileGetPage(pdf, i), hashes + i);
+
+  pdfioFileClose(pdf);
+
+  // Then load all of the object streams up front and compare...
+  printf("pdfioFileOpen(\"%s\", ...): ", filename);
+  if ((pdf = pdfioFileOpen(filename, password_cb, (void *)"user", (pdfio_error_cb_t)error_cb, &error)) != NULL)
+    puts("PASS");
+  else
+    goto done;
+
+  fputs("pdfioFileLoadObjStreams: ", stdout);
+  if (!pdfioFileLoadObjStreams(pdf) || !pdfioFileGetStats(pdf, &stats))
+  {
+    puts("FAIL");
+    goto close_pdf;
+  }
+  else if (stats.objstms_loaded == 0 || stats.objs_loaded == 0)
+  {
+    printf("FAIL (%u object streams, %u objects)\n", (unsigned)stats.objstms_loaded, (unsigned)stats.objs_loaded);
+    goto close_pdf;
+  }
+
+  printf("PASS (%u object streams, %u objects)\n", (unsigned)stats.objstms_loaded, (unsigned)stats.objs_loaded);
+
+  objstms_loaded = stats.objstms_loaded;
+
+  fputs("pdfioFileLoadObjStreams(again): ", stdout);
+  if (!pdfioFileLoadObjStreams(pdf) || !pdfioFileGetStats(pdf, &stats))
+  {
+    puts("FAIL");
+    goto close_pdf;
+  }
+  else if (stats.objstms_loaded != objstms_loaded)
+  {
+    printf("FAIL (%u object streams loaded again)\n", (unsigned)(stats.objstms_loaded - objstms_loaded));
+    goto close_pdf;
+  }
+
+  puts("PASS");
+
+  fputs("hash_page: ", stdout);
+  for (i = 0; i < num_pages; i ++)
+  {
+    if (!hash_page(pdfioFileGetPage(pdf, i), &hash) || hash != hashes[i])
+    {
+      printf("FAIL (page %u)\n", (unsigned)(i + 1));
+      goto close_pdf;
+    }
+  }
+
+  if (!pdfioFileGetStats(pdf, &stats))
+  {
+    puts("FAIL");
+    goto close_pdf;
+  }
+  else if (stats.objstms_loaded != objstms_loaded)
+  {
+    printf("FAIL (%u object streams loaded later)\n", (unsigned)(stats.objstms_loaded - objstms_loaded));
+    goto close_pdf;
+  }
+
+  printf("PASS (%u pages)\n", (unsigned)num_pages);
+
+  ret = 0;
+
+  close_pdf:
+
+  pdfioFileClose(pdf);
+
+  done:
+
+  free(hashes);
+
+  return (ret);
+}
+
+
+//
+// 'read_sparse_file()' - Read a PDF file with sparse object numbers.
+//
+// The file has an xref table listing high object numbers in descending order,
+// followed by an incremental update that replaces some of the objects.
+//
+
+static int				// O - Exit status
+read_sparse_file(void)
+{
+  int		ret = 1;		// Exit status
+  pdfio_file_t	*pdf;			// PDF file
+  pdfio_obj_t	*obj;			// Object
+  char		*data,			// PDF file data
+		*ptr;			// Pointer into data
+  size_t	i,			// Looping var
+		number;			// Object number
+  long		offsets[2][10002],	// Object offsets
+		xref_offset,		// Offset of first xref table
+		update_offset;		// Offset of update xref table
+  bool		error = false;		// Error callback data
+  static const size_t num_sparse = 10000;
+					// Number of sparse objects
+  static const size_t first_sparse = 1000000;
+					// First sparse object number
+
+
+  fputs("pdfioFileOpenMemory(sparse): ", stdout);
+
+  if ((data = malloc(2 * 1024 * 1024)) == NULL)
+  {
+    puts("FAIL (unable to allocate memory)");
+    return (1);
+  }
+
+  // Write the objects, the xref table listing the sparse objects from highest
+  // to lowest, and an update that replaces every 100th sparse object...
+  ptr = data;
+  ptr += sprintf(ptr, "%%PDF-1.7\n");
+  offsets[0][0] = (long)(ptr - data);
+  ptr += sprintf(ptr, "1 0 obj\n<</Type/Catalog/Pages 2 0 R>>\nendobj\n");
+  offsets[0][1] = (long)(ptr - data);
+  ptr += sprintf(ptr, "2 0 obj\n<</Type/Pages/Kids[]/Count 0>>\nendobj\n");
+
+  for (i = 0; i < num_sparse; i ++)
+  {
+    offsets[0][i + 2] = (long)(ptr - data);
+    ptr += sprintf(ptr, "%lu 0 obj\n<</Value 1>>\nendobj\n", (unsigned long)(first_sparse + 10 * i));
+  }
+
+  xref_offset = (long)(ptr - data);
+  ptr += sprintf(ptr, "xref\n0 3\n0000000000 65535 f \n%010ld 00000 n \n%010ld 00000 n \n", offsets[0][0], offsets[0][1]);
+  for (i = num_sparse; i > 0; i --)
+    ptr += sprintf(ptr, "%lu 1\n%010ld 00000 n \n", (unsigned long)(first_sparse + 10 * (i - 1)), offsets[0][i + 1]);
+  ptr += sprintf(ptr, "trailer\n<</Size %lu/Root 1 0 R>>\nstartxref\n%ld\n%%%%EOF\n", (unsigned long)(first_sparse + 10 * num_sparse), xref_offset);
+
+  for (i = 0; i < num_sparse; i += 100)
+  {
+    offsets[1][i] = (long)(ptr - data);
+    ptr += sprintf(ptr, "%lu 0 obj\n<</Value 2>>\nendobj\n", (unsigned long)(first_sparse + 10 * i));
+  }
+
+  update_offset = (long)(ptr - data);
+  ptr += sprintf(ptr, "xref\n");
+  for (i = num_sparse; i > 0; i -= 100)
+    ptr += sprintf(ptr, "%lu 1\n%010ld 00000 n \n", (unsigned long)(first_sparse + 10 * (i - 100)), offsets[1][i - 100]);
+  ptr += sprintf(ptr, "trailer\n<</Size %lu/Root 1 0 R/Prev %ld>>\nstartxref\n%ld\n%%%%EOF\n", (unsigned long)(first_sparse + 10 * num_sparse), xref_offset, update_offset);
+
+  if ((pdf = pdfioFileOpenMemory(data, (size_t)(ptr - data), /*password_cb*/NULL, /*password_data*/NULL, (pdfio_error_cb_t)error_cb, &error)) == NULL)
+    goto done;
+
+  if (pdfioFileGetNumObjs(pdf) != num_sparse + 2)
+  {
+    printf("FAIL (got %lu objects, expected %lu)\n", (unsigned long)pdfioFileGetNumObjs(pdf), (unsigned long)(num_sparse + 2));
+    goto close_pdf;
+  }
+
+  // Check that every sparse object is found, using the replacement objects
+  // from the update...
+  for (i = 0; i < num_sparse; i ++)
+  {
+    number = first_sparse + 10 * i;
+
+    if ((obj = pdfioFileFindObj(pdf, number)) == NULL)
+    {
+      printf("FAIL (object %lu not found)\n", (unsigned long)number);
+      goto close_pdf;
+    }
+    else if (pdfioDictGetNumber(pdfioObjGetDict(obj), "Value") != ((i % 100) ? 1.0 : 2.0))
+    {
+      printf("FAIL (object %lu has Value %g)\n", (unsigned long)number, pdfioDictGetNumber(pdfioObjGetDict(obj), "Value"));
+      goto close_pdf;
+    }
+    else if (pdfioFileFindObj(pdf, number + 1))
+    {
+      printf("FAIL (found missing object %lu)\n", (unsigned long)(number + 1));
+      goto close_pdf;
+    }
+  }
+
+  puts("PASS");
+  ret = 0;
+
+  close_pdf:
+
+  pdfioFileClose(pdf);
+
+  done:
+
+  free(data);
+
+  return (ret);
+}
+
+
+//
+// 'read_stats_file()' - Read a PDF file and check the I/O statistics and spans.
+//
+
+static int				// O - Exit status
+read_stats_file(const char *filename)	// I - File to read
+{
+  int		ret = 1;		// Exit status
+  pdfio_file_t	*pdf;			// PDF file
+  int		fd;			// File descriptor
+  struct stat	fileinfo;		// File information
+  io_data_t	io;			// Input callback data
+  size_t	i,			// Looping var
+		num_pages;		// Number of pages
+  uint32_t	hash;			// Page hash
+  pdfio_stats_t	stats;			// I/O statistics
+  span_data_t	spans;			// Span callback data
+  bool		error = false;		// Error callback data
+
+
+  // Load the file into memory so that all reads go through the input callback...
+  memset(&io, 0, sizeof(io));
+  memset(&spans, 0, sizeof(spans));
+
+  if ((fd = open(filename, O_RDONLY | O_BINARY)) < 0 || fstat(fd, &fileinfo) || (io.data = (unsigned char *)malloc((size_t)fileinfo.st_size)) == NULL || read(fd, io.data, (size_t)fileinfo.st_size) != (ssize_t)fileinfo.st_size)
+  {
+    printf("read_stats_file: Unable to load \"%s\": %s\n", filename, strerror(errno));
+    if (fd >= 0)
+      close(fd);
+    free(io.data);
+    return (1);
+  }
+
+  close(fd);
+
+  io.datalen = (size_t)fileinfo.st_size;
+
+  printf("pdfioFileOpenIO(\"%s\", ...): ", filename);
+  if ((pdf = pdfioFileOpenIO((pdfio_input_cb_t)input_cb, &io, (off_t)io.datalen, password_cb, (void *)"user", (pdfio_error_cb_t)error_cb, &error)) != NULL)
+    puts("PASS");
+  else
+    goto done;
+
+  fputs("pdfioFileSetSpanCallback: ", stdout);
+  pdfioFileSetSpanCallback(pdf, (pdfio_span_cb_t)span_cb, &spans);
+  puts("PASS");
+
+  fputs("hash_page: ", stdout);
+  num_pages = pdfioFileGetNumPages(pdf);
+  for (i = 0; i < num_pages; i ++)
+  {
+    if (!hash_page(pdfioFileGetPage(pdf, i), &hash))
+    {
+      printf("FAIL (page %u)\n", (unsigned)(i + 1));
+      goto close_pdf;
+    }
+  }
+
+  printf("PASS (%u pages)\n", (unsigned)num_pages);
+
+  fputs("pdfioFileGetStats: ", stdout);
+  if (!pdfioFileGetStats(pdf, &stats))
+  {
+    puts("FAIL");
+    goto close_pdf;
+  }
+  else if (stats.reads != io.reads || stats.bytes_read != io.bytes)
+  {
+    printf("FAIL (got %u reads/%u bytes, expected %u reads/%u bytes)\n", (unsigned)stats.reads, (unsigned)stats.bytes_read, (unsigned)io.reads, (unsigned)io.bytes);
+    goto close_pdf;
+  }
+  else if (stats.objs_loaded == 0 || stats.objstms_loaded == 0 || stats.bytes_inflated == 0 || stats.strings == 0)
+  {
+    printf("FAIL (%u objects, %u object streams, %u bytes inflated, %u strings)\n", (unsigned)stats.objs_loaded, (unsigned)stats.objstms_loaded, (unsigned)stats.bytes_inflated, (unsigned)stats.strings);
+    goto close_pdf;
+  }
+  else if (stats.alloc_bytes == 0 || stats.alloc_bytes > stats.peak_alloc_bytes)
+  {
+    printf("FAIL (%u bytes allocated, %u peak)\n", (unsigned)stats.alloc_bytes, (unsigned)stats.peak_alloc_bytes);
+    goto close_pdf;
+  }
+
+  printf("PASS (%u reads, %u bytes read, %u objects, %u object streams, %u bytes inflated)\n", (unsigned)stats.reads, (unsigned)stats.bytes_read, (unsigned)stats.objs_loaded, (unsigned)stats.objstms_loaded, (unsigned)stats.bytes_inflated);
+
+  fputs("span_cb: ", stdout);
+  for (i = 0; i <= PDFIO_SPAN_CRYPTO; i ++)
+  {
+    if (spans.begins[i] != spans.ends[i])
+      break;
+  }
+
+  if (spans.unbalanced)
+    puts("FAIL (span ended without a matching begin)");
+  else if (i <= PDFIO_SPAN_CRYPTO)
+    printf("FAIL (span %u has %u begins and %u ends)\n", (unsigned)i, (unsigned)spans.begins[i], (unsigned)spans.ends[i]);
+  else if (spans.begins[PDFIO_SPAN_LOAD_OBJ] == 0 || spans.begins[PDFIO_SPAN_INFLATE] == 0)
+    printf("FAIL (%u LOAD_OBJ spans, %u INFLATE spans)\n", (unsigned)spans.begins[PDFIO_SPAN_LOAD_OBJ], (unsigned)spans.begins[PDFIO_SPAN_INFLATE]);
+  else
+  {
+    printf("PASS (%u LOAD_OBJ spans, %u INFLATE spans)\n", (unsigned)spans.begins[PDFIO_SPAN_LOAD_OBJ], (unsigned)spans.begins[PDFIO_SPAN_INFLATE]);
+    ret = 0;
+  }
+
+  close_pdf:
+
+  pdfioFileClose(pdf);
+
+  done:
+
+  free(io.data);
+
+  return (ret);
+}
+
+
+//
+// 'read_unit_file()' - Read back a unit test file and confirm its contents.
+//
+
+static int				// O - Exit status
+read_unit_file(const char *filename,	// I - File to read
+               size_t     num_pages,	// I - Expected number of pages
+	       size_t     first_image,	// I - First image object
+	       bool       is_output)	// I - File written with output callback?
+{
+  pdfio_file_t	*pdf;			// PDF file
+  pdfio_dict_t	*catalog;		// Catalog dictionary
+  size_t	i;			// Looping var
+  const char	*s;			// String
+  bool		error = false;		// Error callback data
+
+
+  // Open the new PDF file to read it...
+  printf("pdfioFileOpen(\"%s\", ...): ", filename);
+  if ((pdf = pdfioFileOpen(filename, password_cb, (void *)"user", (pdfio_error_cb_t)error_cb, &error)) != NULL)
+    puts("PASS");
+  else
+    return (1);
+
+  // Get the root object/catalog dictionary
+  fputs("pdfioFileGetCatalog: ", stdout);
+  if ((catalog = pdfioFileGetCatalog(pdf)) != NULL)
+  {
+    puts("PASS");
+  }
+  else
+  {
+    puts("FAIL (got NULL, expected dictionary)");
+    return (1);
+  }
+
+  // Verify some catalog values...
+  fputs("pdfioDictGetName(PageLayout): ", stdout);
+  if ((s = pdfioDictGetName(catalog, "PageLayout")) != NULL && !strcmp(s, "SinglePage"))
+  {
+    puts("PASS");
+  }
+  else if (s)
+  {
+    printf("FAIL (got '%s', expected 'SinglePage')\n", s);
+    return (1);
+  }
+  else
+  {
+    puts("FAIL (got NULL, expected 'SinglePage')");
+    return (1);
+  }
+
+  fputs("pdfioDictGetName(PageLayout): ", stdout);
+  if ((s = pdfioDictGetName(catalog, "PageLayout")) != NULL && !strcmp(s, "SinglePage"))
+  {
+    puts("PASS");
+  }
+  else if (s)
+  {
+    printf("FAIL (got '%s', expected 'SinglePage')\n", s);
+    return (1);
+  }
+  else
+  {
+    puts("FAIL (got NULL, expected 'SinglePage')");
+    return (1);
+  }
+
+  fputs("pdfioDictGetName(PageMode): ", stdout);
+  if ((s = pdfioDictGetName(catalog, "PageMode")) != NULL && !strcmp(s, "UseThumbs"))
+  {
+    puts("PASS");
+  }
+  else if (s)
+  {
+    printf("FAIL (got '%s', expected 'UseThumbs')\n", s);
+    return (1);
+  }
+  else
+  {
+    puts("FAIL (got NULL, expected 'UseThumbs')");
+    return (1);
+  }
+
+  fputs("pdfioDictGetString(Lang): ", stdout);
+  if ((s = pdfioDictGetString(catalog, "Lang")) != NULL && !strcmp(s, "en"))
+  {
+    puts("PASS");
+  }
+  else if (s)
+  {
+    printf("FAIL (got '%s', expected 'en')\n", s);
+    return (1);
+  }
+  else
+  {
+    puts("FAIL (got NULL, expected 'en')");
+    return (1);
+  }
+
+  // Verify metadata...
+  fputs("pdfioFileGetAuthor: ", stdout);
+  if ((s = pdfioFileGetAuthor(pdf)) != NULL && !strcmp(s, "Michael R Sweet"))
+  {
+    puts("PASS");
+  }
+  else if (s)
+  {
+    printf("FAIL (got '%s', expected 'Michael R Sweet')\n", s);
+    return (1);
+  }
+  else
+  {
+    puts("FAIL (got NULL, expected 'Michael R Sweet')");
+    return (1);
+  }
+
+  fputs("pdfioFileGetCreator: ", stdout);
+  if ((s = pdfioFileGetCreator(pdf)) != NULL && !strcmp(s, "testpdfio"))
+  {
+    puts("PASS");
+  }
+  else if (s)
+  {
+    printf("FAIL (got '%s', expected 'testpdfio')\n", s);
+    return (1);
+  }
+  else
+  {
+    puts("FAIL (got NULL, expected 'testpdfio')");
+    return (1);
+  }
+
+  fputs("pdfioFileGetKeywords: ", stdout);
+  if ((s = pdfioFileGetKeywords(pdf)) != NULL && !strcmp(s, "one fish,two fish,red fish,blue fish"))
+  {
+    puts("PASS");
+  }
+  else if (s)
+  {
+    printf("FAIL (got '%s', expected 'one fish,two fish,red fish,blue fish')\n", s);
+    return (1);
+  }
+  else
+  {
+    puts("FAIL (got NULL, expected 'one fish,two fish,red fish,blue fish')");
+    return (1);
+  }
+
+  fputs("pdfioFileGetSubject: ", stdout);
+  if ((s = pdfioFileGetSubject(pdf)) != NULL && !strcmp(s, "Unit test document"))
+  {
+    puts("PASS");
+  }
+  else if (s)
+  {
+    printf("FAIL (got '%s', expected 'Unit test document')\n", s);
+    return (1);
+  }
+  else
+  {
+    puts("FAIL (got NULL, expected 'Unit test document')");
+    return (1);
+  }
+
+  fputs("pdfioFileGetTitle: ", stdout);
+  if ((s = pdfioFileGetTitle(pdf)) != NULL && !strcmp(s, "Test Document"))
+  {
+    puts("PASS");
+  }
+  else if (s)
+  {
+    printf("FAIL (got '%s', expected 'Test Document')\n", s);
+    return (1);
+  }
+  else
+  {
+    puts("FAIL (got NULL, expected 'Test Document')");
+    return (1);
+  }
+
+  // Verify the number of pages is the same...
+  fputs("pdfioFileGetNumPages: ", stdout);
+  if (num_pages == pdfioFileGetNumPages(pdf))
+  {
+    puts("PASS");
+  }
+  else
+  {
+    printf("FAIL (%lu != %lu)\n", (unsigned long)num_pages, (unsigned long)pdfioFileGetNumPages(pdf));
+    return (1);
+  }
+
+  // Verify that the pages can be looked up in reverse order...
+  fputs("pdfioFileGetPage: ", stdout);
+  for (i = num_pages; i > 0; i --)
+  {
+    if ((s = pdfioObjGetType(pdfioFileGetPage(pdf, i - 1))) == NULL || strcmp(s, "Page"))
+      break;
+  }
+
+  if (i == 0)
+  {
+    puts("PASS");
+  }
+  else
+  {
+    printf("FAIL (unable to get page %lu)\n", (unsigned long)i);
+    return (1);
+  }
+
+  // Verify that objects are sorted and can be found by number...
+  fputs("pdfioFileGetObj/FindObj: ", stdout);
+  for (i = 0; i < pdfioFileGetNumObjs(pdf); i ++)
+  {
+    pdfio_obj_t *obj = pdfioFileGetObj(pdf, i);
+					// Current object
+
+    if (!obj || pdfioFileFindObj(pdf, pdfioObjGetNumber(obj)) != obj || (i > 0 && pdfioObjGetNumber(pdfioFileGetObj(pdf, i - 1)) >= pdfioObjGetNumber(obj)))
+      break;
+  }
+
+  if (i == pdfioFileGetNumObjs(pdf))
+  {
+    puts("PASS");
+  }
+  else
+  {
+    printf("FAIL (object %lu)\n", (unsigned long)i);
+    return (1);
+  }
+
+  // Verify the images
+  for (i = 0; i < 7; i ++)
+  {
+    if (is_output)
+    {
+      if (verify_image(pdf, first_image + (size_t)i * 2))
+        return (1);
+    }
+    else if (verify_image(pdf, first_image + (size_t)i))
+      return (1);
+  }
+
+  // Close the new PDF file...
+  fputs("pdfioFileClose(\"testpdfio-out.pdf\"): ", stdout);
+  if (pdfioFileClose(pdf))
+    puts("PASS");
+  else
+    return (1);
+
+  return (0);
+}
+
+
+//
+// 'scan_cb()' - Record operators from pdfioPageScanContent.
+//
+
+static bool				// O - `true` to continue, `false` to stop
+scan_cb(scan_data_t           *data,	// I - Callback data
+        const char            *op,	// I - Operator
+        size_t                num_operands,
+					// I - Number of operands
+        const pdfio_operand_t *operands)// I - Operands
+{
+  size_t	i;			// Looping var
+  char		*ptr = data->transcript + strlen(data->transcript),
+					// Pointer into transcript
+		*end = data->transcript + sizeof(data->transcript);
+					// End of transcript
+
+
+  data->count ++;
+
+  if (data->count > 14)
+  {
+    // Check the generated "m", "l", and "S" operators...
+    if ((strcmp(op, "m") && strcmp(op, "l") && strcmp(op, "S")) || num_operands != (op[0] == 'S' ? 0 : 2) || (num_operands && (operands[0].type != PDFIO_VALTYPE_NUMBER || operands[1].type != PDFIO_VALTYPE_NUMBER)))
+      data->bad ++;
+
+    return (true);
+  }
+
+  for (i = 0; i < num_operands; i ++, ptr += strlen(ptr))
+  {
+    switch (operands[i].type)
+    {
+      case PDFIO_VALTYPE_ARRAY :
+          snprintf(ptr, (size_t)(end - ptr), "[%u ", (unsigned)operands[i].length);
+          break;
+      case PDFIO_VALTYPE_BINARY :
+          snprintf(ptr, (size_t)(end - ptr), "<%u> ", (unsigned)operands[i].length);
+          break;
+      case PDFIO_VALTYPE_BOOLEAN :
+          snprintf(ptr, (size_t)(end - ptr), "%s ", operands[i].value.boolean ? "true" : "false");
+          break;
+      case PDFIO_VALTYPE_DICT :
+          snprintf(ptr, (size_t)(end - ptr), "<<%u ", (unsigned)operands[i].length);
+          break;
+      case PDFIO_VALTYPE_NAME :
+          snprintf(ptr, (size_t)(end - ptr), "/%s ", operands[i].value.name);
+          break;
+      case PDFIO_VALTYPE_NULL :
+          snprintf(ptr, (size_t)(end - ptr), "null ");
+          break;
+      case PDFIO_VALTYPE_NUMBER :
+          snprintf(ptr, (size_t)(end - ptr), "%g ", operands[i].value.number);
+          break;
+      case PDFIO_VALTYPE_STRING :
+          snprintf(ptr, (size_t)(end - ptr), "(%s:%u) ", operands[i].value.string, (unsigned)operands[i].length);
+          break;
+      default :
+          snprintf(ptr, (size_t)(end - ptr), "? ");
+          break;
+    }
+  }
+
+  snprintf(ptr, (size_t)(end - ptr), "%s\n", op);
+
+  return (true);
+}
+
+
+//
+// 'span_cb()' - Count the timing spans for an operation.
+//
+
+static void
+span_cb(pdfio_file_t *pdf,		// I - PDF file
+        pdfio_span_t span,		// I - Span
+        bool         begin,		// I - `true` for the beginning of the span, `false` for the end
+        span_data_t  *data)		// I - Callback data
+{
+  (void)pdf;
+
+  if ((size_t)span > PDFIO_SPAN_CRYPTO)
+  {
+    data->unbalanced = true;
+  }
+  else if (begin)
+  {
+    data->begins[span] ++;
+  }
+  else
+  {
+    data->ends[span] ++;
+
+    if (data->ends[span] > data->begins[span])
+      data->unbalanced = true;
+  }
+}
+
+
+//
+// 'token_consume_cb()' - Consume bytes from a test string.
+//
+
+static ssize_t				// O  - Number of bytes consumed
+token_consume_cb(const char **s,	// IO - Test string
+                 size_t     bytes)	// I  - Bytes to consume
+{
+  size_t	len = strlen(*s);	// Number of bytes remaining
+
+
+  // "Consume" bytes by incrementing the string pointer, limiting to the
+  // remaining length...
+  if (bytes > len)
+    bytes = len;
+
+  *s += bytes;
+
+  return ((ssize_t)bytes);
+}
+
+
+//
+// 'token_peek_cb()' - Peek bytes from a test string.
+//
+
+static ssize_t				// O  - Number of bytes peeked
+token_peek_cb(const char **s,		// IO - Test string
+              char       *buffer,	// I  - Buffer
+              size_t     bytes)		// I  - Bytes to peek
+{
+  size_t	len = strlen(*s);	// Number of bytes remaining
+
+
+  // Copy bytes from the test string as possible...
+  if (bytes > len)
+    bytes = len;
+
+  if (bytes > 0)
+    memcpy(buffer, *s, bytes);
+
+  return ((ssize_t)bytes);
+}
+
+
+//
+// 'usage()' - Show program usage.
+//
+
+static int				// O - Exit status
+usage(FILE *fp)				// I - Output file
+{
+  fputs("Usage: ./testpdfio [OPTIONS] [FILENAME [OBJNUM]] ...\n", fp);
+  fputs("Options:\n", fp);
+  fputs("  --help               Show program help.\n", fp);
+  fputs("  --password PASSWORD  Set PDF password.\n", fp);
+  fputs("  --verbose            Be verbose.\n", fp);
+
+  return (fp != stdout);
+}
+
+
+//
+// 'verify_image()' - Verify an image object.
+//
+
+static int				// O - 1 on failure, 0 on success
+verify_image(pdfio_file_t *pdf,		// I - PDF file
+             size_t       number)	// I - Object number
+{
+  pdfio_obj_t	*obj;			// Image object
+  const char	*type,			// Object type
+		*subtype;		// Object subtype
+  double	width,			// Width of object
+		height;			// Height of object
+  pdfio_stream_t *st;			// Stream
+  int		x, y;			// Coordinates in image
+  unsigned char	buffer[768],		// Expected data
+		*bufptr,		// Pointer into buffer
+		line[768];		// Line from file
+  ssize_t	bytes;			// Bytes read from stream
+
+
+  printf("pdfioFileFindObj(%lu): ", (unsigned long)number);
+  if ((obj = pdfioFileFindObj(pdf, number)) != NULL)
+    puts("PASS");
+  else
+    return (1);
+
+  fputs("pdfioObjGetType: ", stdout);
+  if ((type = pdfioObjGetType(obj)) != NULL && !strcmp(type, "XObject"))
+  {
+    puts("PASS");
+  }
+  else
+  {
+    printf("FAIL (got %s, expected XObject)\n", type);
+    return (1);
+  }
+
+  fputs("pdfioObjGetSubtype: ", stdout);
+  if ((subtype = pdfioObjGetSubtype(obj)) != NULL && !strcmp(subtype, "Image"))
+  {
+    puts("PASS");
+  }
+  else
+  {
+    printf("FAIL (got %s, expected Image)\n", subtype);
+    return (1);
+  }
+
+  fputs("pdfioImageGetWidth: ", stdout);
+  if ((width = pdfioImageGetWidth(obj)) == 256.0)
+  {
+    puts("PASS");
+  }
+  else
+  {
+    printf("FAIL (got %g, expected 256)\n", width);
+    return (1);
+  }
+
+  fputs("pdfioImageGetHeight: ", stdout);
+  if ((height = pdfioImageGetHeight(obj)) == 256.0)
+  {
+    puts("PASS");
+  }
+  else
+  {
+    printf("FAIL (got %g, expected 256)\n", height);
+    return (1);
+  }
+
+  // Open the image stream, read the image, and verify it matches expectations...
+  fputs("pdfioObjOpenStream: ", stdout);
+  if ((st = pdfioObjOpenStream(obj, PDFIO_FILTER_FLATE)) != NULL)
+    puts("PASS");
+  else
+    return (1);
+
+  for (y = 0; y < 256; y ++)
+  {
+    for (x = 0, bufptr = buffer; x < 256; x ++, bufptr += 3)
+    {
+      bufptr[0] = (unsigned char)y;
+      bufptr[1] = (unsigned char)(y + x);
+      bufptr[2] = (unsigned char)(y - x);
+    }
+
+    if ((bytes = pdfioStreamRead(st, line, sizeof(line))) != (ssize_t)sizeof(line))
+    {
+      printf("pdfioStreamRead: FAIL (got %d for line %d, expected 768)\n", y, (int)bytes);
+      pdfioStreamClose(st);
+      return (1);
+    }
+
+    if (memcmp(buffer, line, sizeof(buffer)))
+    {
+      printf("pdfioStreamRead: FAIL (line %d doesn't match expectations)\n", y);
+      pdfioStreamClose(st);
+      return (1);
+    }
+  }
+
+  pdfioStreamClose(st);
+
+  return (0);
+}
+
+
+//
+// 'verify_page_tree()' - Verify a node of a balanced page tree.
+//
+
+static bool				// O  - `true` if valid, `false` otherwise
+verify_page_tree(
+    pdfio_file_t *pdf,			// I  - PDF file
+    pdfio_obj_t  *node,			// I  - Pages object
+    size_t       fanout,		// I  - Maximum number of kids
+    size_t       depth,			// I  - Depth of node
+    size_t       *leaf_depth,		// IO - Depth of nodes with pages
+    size_t       *count)		// IO - Number of pages so far
+{
+  pdfio_dict_t	*dict = pdfioObjGetDict(node),
+					// Pages dictionary
+		*kdict;			// Kid dictionary
+  pdfio_array_t	*kids = pdfioDictGetArray(dict, "Kids");
+					// Kids array
+  pdfio_obj_t	*kid;			// Current kid
+  size_t	i,			// Looping var
+		num_kids,		// Number of kids
+		first = *count;		// First page in node
+
+
+  if ((num_kids = pdfioArrayGetSize(kids)) == 0 || num_kids > fanout || depth > PDFIO_MAX_DEPTH)
+  {
+    printf("FAIL (object %u has %u kids)\n", (unsigned)pdfioObjGetNumber(node), (unsigned)num_kids);
+    return (false);
+  }
+
+  for (i = 0; i < num_kids; i ++)
+  {
+    kid   = pdfioArrayGetObj(kids, i);
+    kdict = pdfioObjGetDict(kid);
+
+    if (!kid || pdfioDictGetObj(kdict, "Parent") != node)
+    {
+      printf("FAIL (bad parent for kid %u of object %u)\n", (unsigned)i, (unsigned)pdfioObjGetNumber(node));
+      return (false);
+    }
+
+    if (pdfioDictGetArray(kdict, "Kids"))
+    {
+      if (!verify_page_tree(pdf, kid, fanout, depth + 1, leaf_depth, count))
+        return (false);
+
+      continue;
+    }
+
+    if (!*leaf_depth)
+    {
+      *leaf_depth = depth;
+    }
+    else if (depth != *leaf_depth)
+    {
+      printf("FAIL (page %u at depth %u, expected %u)\n", (unsigned)(*count + 1), (unsigned)depth, (unsigned)*leaf_depth);
+      return (false);
+    }
+
+    if (pdfioFileGetPage(pdf, *count) != kid)
+    {
+      printf("FAIL (page %u is object %u, expected %u)\n", (unsigned)(*count + 1), (unsigned)pdfioObjGetNumber(pdfioFileGetPage(pdf, *count)), (unsigned)pdfioObjGetNumber(kid));
+      return (false);
+    }
+
+    (*count) ++;
+  }
+
+  if ((size_t)pdfioDictGetNumber(dict, "Count") != (*count - first))
+  {
+    printf("FAIL (object %u has Count %g, expected %u)\n", (unsigned)pdfioObjGetNumber(node), pdfioDictGetNumber(dict, "Count"), (unsigned)(*count - first));
+    return (false);
+  }
+
+  return (true);
+}
+
+
+//
+// 'write_alpha_test()' - Write a series of test images with alpha channels.
+//
+
+static int				// O - 1 on failure, 0 on success
+write_alpha_test(
+    pdfio_file_t *pdf,			// I - PDF file
+    int          number,		// I - Page number
+    pdfio_obj_t  *font)			// I - Text font
+{
+  pdfio_dict_t	*dict;			// Page dictionary
+  pdfio_stream_t *st;			// Page stream
+  pdfio_obj_t	*images[6];		// Images using PNG predictors
+  char		iname[32];		// Image name
+  int		i,			// Image number
+		x, y;			// Coordinates in image
+  unsigned char	buffer[1280 * 256],	// Buffer for image
+		*bufptr;		// Pointer into buffer
+
+
+  // Create the images...
+  for (i = 0; i < 6; i ++)
+  {
+    size_t	num_colors = 0;		// Number of colors
+
+    // Generate test image data...
+    switch (i)
+    {
+      case 0 : // Grayscale
+      case 3 : // Grayscale + alpha
+          num_colors = 1;
+	  for (y = 0, bufptr = buffer; y < 256; y ++)
+	  {
+	    for (x = 0; x < 256; x ++)
+	    {
+	      unsigned char r = (unsigned char)y;
+	      unsigned char g = (unsigned char)(y + x);
+	      unsigned char b = (unsigned char)(y - x);
+
+              *bufptr++ = (unsigned char)((r * 30 + g * 59 + b * 11) / 100);
+
+	      if (i > 2)
+	      {
+	        // Add alpha channel
+	        if (x < 112 || x >= 144 || y < 112 || y >= 144)
+		  *bufptr++ = (unsigned char)((x - 128) * (y - 128));
+		else
+		  *bufptr++ = 0;
+	      }
+	    }
+	  }
+          break;
+
+      case 1 : // RGB
+      case 4 : // RGB + alpha
+          num_colors = 3;
+	  for (y = 0, bufptr = buffer; y < 256; y ++)
+	  {
+	    for (x = 0; x < 256; x ++)
+	    {
+	      *bufptr++ = (unsigned char)y;
+	      *bufptr++ = (unsigned char)(y + x);
+	      *bufptr++ = (unsigned char)(y - x);
+
+	      if (i > 2)
+	      {
+	        // Add alpha channel
+	        if (x < 112 || x >= 144 || y < 112 || y >= 144)
+		  *bufptr++ = (unsigned char)((x - 128) * (y - 128));
+		else
+		  *bufptr++ = 0;
+	      }
+	    }
+	  }
+          break;
+      case 2 : // CMYK
+      case 5 : // CMYK + alpha
+          num_colors = 4;
+	  for (y = 0, bufptr = buffer; y < 256; y ++)
+	  {
+	    for (x = 0; x < 256; x ++)
+	    {
+	      unsigned char cc = (unsigned char)y;
+	      unsigned char mm = (unsigned char)(y + x);
+	      unsigned char yy = (unsigned char)(y - x);
+	      unsigned char kk = cc < mm ? cc < yy ? cc : yy : mm < yy ? mm : yy;
+
+              *bufptr++ = (unsigned char)(cc - kk);
+              *bufptr++ = (unsigned char)(mm - kk);
+              *bufptr++ = (unsigned char)(yy - kk);
+              *bufptr++ = (unsigned char)(kk);
+
+	      if (i > 2)
+	      {
+	        // Add alpha channel
+	        if (x < 112 || x >= 144 || y < 112 || y >= 144)
+		  *bufptr++ = (unsigned char)((x - 128) * (y - 128));
+		else
+		  *bufptr++ = 0;
+	      }
+	    }
+	  }
+          break;
+    }
+
+    // Write the image...
+    printf("pdfioFileCreateImageObjFromData(num_colors=%u, alpha=%s): ", (unsigned)num_colors, i > 2 ? "true" : "false");
+    if ((images[i] = pdfioFileCreateImageObjFromData(pdf, buffer, 256, 256, num_colors, NULL, i > 2, false)) != NULL)
+    {
+      printf("PASS (%u)\n", (unsigned)pdfioObjGetNumber(images[i]));
+    }
+    else
+    {
+      puts("FAIL");
+      return (1);
+    }
+
+    printf("pdfioFileCreateImageObjFromData(num_colors=%u, alpha=%s, cached): ", (unsigned)num_colors, i > 2 ? "true" : "false");
+    if (pdfioFileCreateImageObjFromData(pdf, buffer, 256, 256, num_colors, NULL, i > 2, false) == images[i])
+    {
+      puts("PASS");
+    }
+    else
+    {
+      puts("FAIL");
+      return (1);
+    }
+  }
+
+  // Create the page dictionary, object, and stream...
+  fputs("pdfioDictCreate: ", stdout);
+  if ((dict = pdfioDictCreate(pdf)) != NULL)
+    puts("PASS");
+  else
+    return (1);
+
+  for (i = 0; i < 6; i ++)
+  {
+    printf("pdfioPageDictAddImage(%d): ", i + 1);
+    snprintf(iname, sizeof(iname), "IM%d", i + 1);
+    if (pdfioPageDictAddImage(dict, pdfioStringCreate(pdf, iname), images[i]))
+      puts("PASS");
+    else
+      return (1);
+  }
+
+  fputs("pdfioPageDictAddFont(F1): ", stdout);
+  if (pdfioPageDictAddFont(dict, "F1", font))
+    puts("PASS");
+  else
+    return (1);
+
+  printf("pdfioFileCreatePage(%d): ", number);
+
+  if ((st = pdfioFileCreatePage(pdf, dict)) != NULL)
+    puts("PASS");
+  else
+    return (1);
+
+  if (write_header_footer(st, "Image Writing Test", number))
+    goto error;
+
+  // Draw images
+  for (i = 0; i < 6; i ++)
+  {
+    static const char *labels[] = {
+      "DeviceGray",
+      "DeviceRGB",
+      "DeviceCMYK",
+      "DevGray + Alpha",
+      "DevRGB + Alpha",
+      "DevCMYK + Alpha"
+    };
+
+    snprintf(iname, sizeof(iname), "IM%d", i + 1);
+
+    if (draw_image(st, iname, 36 + 180 * (i % 3), 306 - 216 * (i / 3), 144, 144, labels[i]))
+      goto error;
+  }
+
+  // Wrap up...
+  fputs("pdfioStreamClose: ", stdout);
+  if (pdfioStreamClose(st))
+    puts("PASS");
+  else
+    return (1);
+
+  return (0);
+
+  error:
+
+  pdfioStreamClose(st);
+  return (1);
+}
+
+
+//
+// 'write_color_patch()' - Write a color patch...
+//
+
+static int				// O - 1 on failure, 0 on success
+write_color_patch(pdfio_stream_t *st,	// I - Content stream
+                  bool           device)// I - Use device color?
+{
+  int		col,			// Current column
+		row;			// Current row
+  double	x, y,			// Relative position
+		r,			// Radius
+		hue,			// Hue angle
+		sat,			// Saturation
+		cc,			// Computed color
+		red,			// Red value
+		green,			// Green value
+		blue;			// Blue value
+
+
+  // Draw an 11x11 patch...
+  for (col = 0; col < 21; col ++)
+  {
+    for (row = 0; row < 21; row ++)
+    {
+      // Compute color in patch...
+      x = 0.1 * (col - 10);
+      y = 0.1 * (row - 10);
+      r = sqrt(x * x + y * y);
+
+      if (r == 0.0)
+      {
+        red = green = blue = 1.0;
+      }
+      else
+      {
+	sat = pow(r, 1.5);
+
+        x   /= r;
+        y   /= r;
+	hue = 3.0 * atan2(y, x) / M_PI;
+	if (hue < 0.0)
+	  hue += 6.0;
+
+	cc = sat * (1.0 - fabs(fmod(hue, 2.0) - 1.0)) + 1.0 - sat;
+
+	if (hue < 1.0)
+	{
+	  red   = 1.0;
+	  green = cc;
+	  blue  = 1.0 - sat;
+	}
+	else if (hue < 2.0)
+	{
+	  red   = cc;
+	  green = 1.0;
+	  blue  = 1.0 - sat;
+	}
+	else if (hue < 3.0)
+	{
+	  red   = 1.0 - sat;
+	  green = 1.0;
+	  blue  = cc;
+	}
+	else if (hue < 4.0)
+	{
+	  red   = 1.0 - sat;
+	  green = cc;
+	  blue  = 1.0;
+	}
+	else if (hue < 5.0)
+	{
+	  red   = cc;
+	  green = 1.0 - sat;
+	  blue  = 1.0;
+	}
+	else
+	{
+	  red   = 1.0;
+	  green = 1.0 - sat;
+	  blue  = cc;
+	}
+      }
+
+      // Draw it...
+      if (device)
+      {
+        // Use device CMYK color instead of a calibrated RGB space...
+        double cyan = 1.0 - red;	// Cyan color
+        double magenta = 1.0 - green;	// Magenta color
+        double yellow = 1.0 - blue;	// Yellow color
+        double black = cyan;		// Black color
+
+        if (black > magenta)
+          black = magenta;
+        if (black > yellow)
+          black = yellow;
+
+        cyan    -= black;
+        magenta -= black;
+        yellow  -= black;
+
+	printf("pdfioContentSetFillColorDeviceCMYK(c=%g, m=%g, y=%g, k=%g): ", cyan, magenta, yellow, black);
+	if (pdfioContentSetFillColorDeviceCMYK(st, cyan, magenta, yellow, black))
+	  puts("PASS");
+	else
+	  return (1);
+      }
+      else
+      {
+        // Use calibrate RGB space...
+	printf("pdfioContentSetFillColorRGB(r=%g, g=%g, b=%g): ", red, green, blue);
+	if (pdfioContentSetFillColorRGB(st, red, green, blue))
+	  puts("PASS");
+	else
+	  return (1);
+      }
+
+      printf("pdfioContentPathRect(x=%g, y=%g, w=%g, h=%g): ", col * 6.0, row * 6.0, 6.0, 6.0);
+      if (pdfioContentPathRect(st, col * 6.0, row * 6.0, 6.0, 6.0))
+	puts("PASS");
+      else
+	return (1);
+
+      fputs("pdfioContentFill(even_odd=false): ", stdout);
+      if (pdfioContentFill(st, false))
+	puts("PASS");
+      else
+	return (1);
+    }
+  }
+
+  return (0);
+}
+
+
+//
+// 'write_color_test()' - Write a color test page...
+//
+
+static int				// O - 1 on failure, 0 on success
+write_color_test(pdfio_file_t *pdf,	// I - PDF file
+                 int          number,	// I - Page number
+                 pdfio_obj_t  *font)	// I - Text font
+{
+  pdfio_dict_t		*dict;		// Page dictionary
+  pdfio_stream_t	*st;		// Page contents stream
+  pdfio_array_t		*cs;		// Color space array
+  pdfio_obj_t		*prophoto;	// ProPhotoRGB ICC profile object
+
+
+  fputs("pdfioFileCreateICCObjFromFile(ProPhotoRGB): ", stdout);
+  if ((prophoto = pdfioFileCreateICCObjFromFile(pdf, "testfiles/iso22028-2-romm-rgb.icc", 3)) != NULL)
+    puts("PASS");
+  else
+    return (1);
+
+  fputs("pdfioDictCreate: ", stdout);
+  if ((dict = pdfioDictCreate(pdf)) != NULL)
+    puts("PASS");
+  else
+    return (1);
+
+  fputs("pdfioArrayCreateColorFromStandard(AdobeRGB): ", stdout);
+  if ((cs = pdfioArrayCreateColorFromStandard(pdf, 3, PDFIO_CS_ADOBE)) != NULL)
+    puts("PASS");
+  else
+    return (1);
+
+  fputs("pdfioPageDictAddColorSpace(AdobeRGB): ", stdout);
+  if (pdfioPageDictAddColorSpace(dict, "AdobeRGB", cs))
+    puts("PASS");
+  else
+    return (1);
+
+  fputs("pdfioArrayCreateColorFromStandard(DisplayP3): ", stdout);
+  if ((cs = pdfioArrayCreateColorFromStandard(pdf, 3, PDFIO_CS_P3_D65)) != NULL)
+    puts("PASS");
+  else
+    return (1);
+
+  fputs("pdfioPageDictAddColorSpace(DisplayP3): ", stdout);
+  if (pdfioPageDictAddColorSpace(dict, "DisplayP3", cs))
+    puts("PASS");
+  else
+    return (1);
+
+  fputs("pdfioArrayCreateColorFromICCObj(ProPhotoRGB): ", stdout);
+  if ((cs = pdfioArrayCreateColorFromICCObj(pdf, prophoto)) != NULL)
+    puts("PASS");
+  else
+    return (1);
+
+  fputs("pdfioPageDictAddColorSpace(ProPhotoRGB): ", stdout);
+  if (pdfioPageDictAddColorSpace(dict, "ProPhotoRGB", cs))
+    puts("PASS");
+  else
+    return (1);
+
+  fputs("pdfioArrayCreateColorFromStandard(sRGB): ", stdout);
+  if ((cs = pdfioArrayCreateColorFromStandard(pdf, 3, PDFIO_CS_SRGB)) != NULL)
+    puts("PASS");
+  else
+    return (1);
+
+  fputs("pdfioPageDictAddColorSpace(sRGB): ", stdout);
+  if (pdfioPageDictAddColorSpace(dict, "sRGB", cs))
+    puts("PASS");
+  else
+    return (1);
+
+  fputs("pdfioPageDictAddFont(F1): ", stdout);
+  if (pdfioPageDictAddFont(dict, "F1", font))
+    puts("PASS");
+  else
+    return (1);
+
+  printf("pdfioFileCreatePage(%d): ", number);
+
+  if ((st = pdfioFileCreatePage(pdf, dict)) != NULL)
+    puts("PASS");
+  else
+    return (1);
+
+  if (write_header_footer(st, "Color Space Test", number))
+    goto error;
+
+  fputs("pdfioContentTextBegin(): ", stdout);
+  if (pdfioContentTextBegin(st))
+    puts("PASS");
+  else
+    goto error;
+
+  fputs("pdfioContentSetTextFont(\"F1\", 18.0): ", stdout);
+  if (pdfioContentSetTextFont(st, "F1", 18.0))
+    puts("PASS");
+  else
+    goto error;
+
+  fputs("pdfioContentTextMoveTo(82, 234): ", stdout);
+  if (pdfioContentTextMoveTo(st, 82, 234))
+    puts("PASS");
+  else
+    goto error;
+
+  fputs("pdfioContentTextShow(\"AdobeRGB\"): ", stdout);
+  if (pdfioContentTextShow(st, false, "AdobeRGB"))
+    puts("PASS");
+  else
+    goto error;
+
+  fputs("pdfioContentTextMoveTo(234, 0): ", stdout);
+  if (pdfioContentTextMoveTo(st, 234, 0))
+    puts("PASS");
+  else
+    goto error;
+
+  fputs("pdfioContentTextShow(\"DisplayP3\"): ", stdout);
+  if (pdfioContentTextShow(st, false, "DisplayP3"))
+    puts("PASS");
+  else
+    goto error;
+
+  fputs("pdfioContentTextMoveTo(-234, 216): ", stdout);
+  if (pdfioContentTextMoveTo(st, -234, 216))
+    puts("PASS");
+  else
+    goto error;
+
+  fputs("pdfioContentTextShow(\"sRGB\"): ", stdout);
+  if (pdfioContentTextShow(st, false, "sRGB"))
+    puts("PASS");
+  else
+    goto error;
+
+  fputs("pdfioContentTextMoveTo(234, 0): ", stdout);
+  if (pdfioContentTextMoveTo(st, 234, 0))
+    puts("PASS");
+  else
+    goto error;
+
+  fputs("pdfioContentTextShow(\"ProPhotoRGB\"): ", stdout);
+  if (pdfioContentTextShow(st, false, "ProPhotoRGB"))
+    puts("PASS");
+  else
+    goto error;
+
+  fputs("pdfioContentTextMoveTo(-234, 216): ", stdout);
+  if (pdfioContentTextMoveTo(st, -234, 216))
+    puts("PASS");
+  else
+    goto error;
+
+  fputs("pdfioContentTextShow(\"DeviceCMYK\"): ", stdout);
+  if (pdfioContentTextShow(st, false, "DeviceCMYK"))
+    puts("PASS");
+  else
+    goto error;
+
+  fputs("pdfioContentTextEnd(): ", stdout);
+  if (pdfioContentTextEnd(st))
+    puts("PASS");
+  else
+    goto error;
+
+  fputs("pdfioContentSave(): ", stdout);
+  if (pdfioContentSave(st))
+    puts("PASS");
+  else
+    goto error;
+
+  fputs("pdfioContentSetFillColorSpace(AdobeRGB): ", stdout);
+  if (pdfioContentSetFillColorSpace(st, "AdobeRGB"))
+    puts("PASS");
+  else
+    goto error;
+
+  fputs("pdfioContentMatrixTranslate(82, 90): ", stdout);
+  if (pdfioContentMatrixTranslate(st, 82, 90))
+    puts("PASS");
+  else
+    goto error;
+
+  if (write_color_patch(st, false))
+    goto error;
+
+  fputs("pdfioContentRestore(): ", stdout);
+  if (pdfioContentRestore(st))
+    puts("PASS");
+  else
+    goto error;
+
+  fputs("pdfioContentSave(): ", stdout);
+  if (pdfioContentSave(st))
+    puts("PASS");
+  else
+    goto error;
+
+  fputs("pdfioContentSetFillColorSpace(DisplayP3): ", stdout);
+  if (pdfioContentSetFillColorSpace(st, "DisplayP3"))
+    puts("PASS");
+  else
+    goto error;
+
+  fputs("pdfioContentMatrixTranslate(316, 90): ", stdout);
+  if (pdfioContentMatrixTranslate(st, 316, 90))
+    puts("PASS");
+  else
+    goto error;
+
+  if (write_color_patch(st, false))
+    goto error;
+
+  fputs("pdfioContentRestore(): ", stdout);
+  if (pdfioContentRestore(st))
+    puts("PASS");
+  else
+    goto error;
+
+  fputs("pdfioContentSave(): ", stdout);
+  if (pdfioContentSave(st))
+    puts("PASS");
+  else
+    goto error;
+
+  fputs("pdfioContentSetFillColorSpace(sRGB): ", stdout);
+  if (pdfioContentSetFillColorSpace(st, "sRGB"))
+    puts("PASS");
+  else
+    goto error;
+
+  fputs("pdfioContentMatrixTranslate(82, 306): ", stdout);
+  if (pdfioContentMatrixTranslate(st, 82, 306))
+    puts("PASS");
+  else
+    goto error;
+
+  if (write_color_patch(st, false))
+    goto error;
+
+  fputs("pdfioContentRestore(): ", stdout);
+  if (pdfioContentRestore(st))
+    puts("PASS");
+  else
+    goto error;
+
+  fputs("pdfioContentSave(): ", stdout);
+  if (pdfioContentSave(st))
+    puts("PASS");
+  else
+    goto error;
+
+  fputs("pdfioContentSetFillColorSpace(ProPhotoRGB): ", stdout);
+  if (pdfioContentSetFillColorSpace(st, "ProPhotoRGB"))
+    puts("PASS");
+  else
+    goto error;
+
+  fputs("pdfioContentMatrixTranslate(316, 306): ", stdout);
+  if (pdfioContentMatrixTranslate(st, 316, 306))
+    puts("PASS");
+  else
+    goto error;
+
+  if (write_color_patch(st, false))
+    goto error;
+
+  fputs("pdfioContentRestore(): ", stdout);
+  if (pdfioContentRestore(st))
+    puts("PASS");
+  else
+    goto error;
+
+  fputs("pdfioContentSave(): ", stdout);
+  if (pdfioContentSave(st))
+    puts("PASS");
+  else
+    goto error;
+
+  fputs("pdfioContentMatrixTranslate(82, 522): ", stdout);
+  if (pdfioContentMatrixTranslate(st, 82, 522))
+    puts("PASS");
+  else
+    goto error;
+
+  if (write_color_patch(st, true))
+    goto error;
+
+  fputs("pdfioContentRestore(): ", stdout);
+  if (pdfioContentRestore(st))
+    puts("PASS");
+  else
+    goto error;
+
+  fputs("pdfioStreamClose: ", stdout);
+  if (pdfioStreamClose(st))
+    puts("PASS");
+  else
+    return (1);
+
+  return (0);
+
+  error:
+
+  pdfioStreamClose(st);
+  return (1);
+}
+
+
+//
+// 'write_font_test()' - Write a font test page.
+//
+
+static int				// O - 1 on failure, 0 on success
+write_font_test(
+    pdfio_file_t *pdf,			// I - PDF file
+    int          number,		// I - Page number
+    pdfio_obj_t  *font,			// I - Page number font
+    const char   *textfontfile,		// I - Text font file
+    bool         unicode)		// I - Use Unicode font?
+{
+  pdfio_dict_t		*dict;		// Page dictionary
+  pdfio_stream_t	*st;		// Page contents stream
+  pdfio_obj_t		*textfont;	// Text font
+  char			title[256],	// Page title
+			textname[256],	// Name of text font
+			*ptr;		// Pointer into name
+  double		width;		// Text width
+  int			i;		// Looping var
+  static const char * const welcomes[] =// "Welcome" in many languages
+  {
+    "Welcome",
+    "Welkom",
+    "ḫaṣānu",
+    "Mayad-ayad nga pad-abot",
+    "Mir se vjên",
+    "Mirë se vjen",
+    "Wellkumma",
+    "Bienveniu",
+    "Ghini vinit!",
+    "Bienveníu",
+    "Miro peicak",
+    "Xoş gəlmişsiniz!",
+    "Salamat datang",
+    "Сәләм бирем!",
+    "Menjuah-juah!",
+    "Še das d' kemma bisd",
+    "Mwaiseni",
+    "Maogmáng Pag-abót",
+    "Welkam",
+    "Dobrodošli",
+    "Degemer mat",
+    "Benvingut",
+    "Maayong pag-abot",
+    "Kopisanangan do kinorikatan",
+    "Bienvenida",
+    "Bien binidu",
+    "Bienbenidu",
+    "Hóʔą",
+    "Boolkhent!",
+    "Kopivosian do kinoikatan",
+    "Malipayeng Pag-abot!",
+    "Vítej",
+    "Velkommen",
+    "Salâm",
+    "Welkom",
+    "Emedi",
+    "Welkumin",
+    "Tere tulemast",
+    "Woé zɔ",
+    "Bienveníu",
+    "Vælkomin",
+    "Bula",
+    "Tervetuloa",
+    "Bienvenue",
+    "Wäljkiimen",
+    "Wäilkuumen",
+    "Wäilkuumen",
+    "Wolkom",
+    "Benvignût",
+    "Benvido",
+    "Willkommen",
+    "Ἀσπάζομαι!",
+    "Καλώς Ήρθες",
+    "Tikilluarit",
+    "Byen venu",
+    "Sannu da zuwa",
+    "Aloha",
+    "Wayakurua",
+    "Dayón",
+    "Zoo siab txais tos!",
+    "Üdvözlet",
+    "Selamat datai",
+    "Velkomin",
+    "Nnọọ",
+    "Selamat datang",
+    "Qaimarutin",
+    "Fáilte",
+    "Benvenuto",
+    "Voschata",
+    "Murakaza neza",
+    "Mauri",
+    "Tu be xér hatî ye!",
+    "Taŋyáŋ yahí",
+    "Salve",
+    "Laipni lūdzam",
+    "Wilkóm",
+    "Sveiki atvykę",
+    "Willkamen",
+    "Mu amuhezwi",
+    "Tukusanyukidde",
+    "Wëllkomm",
+    "Swagatam",
+    "Tonga soa",
+    "Selamat datang",
+    "Merħba",
+    "B’a’ntulena",
+    "Failt ort",
+    "Haere mai",
+    "mai",
+    "Pjila’si",
+    "Benvegnüu",
+    "Ne y kena",
+    "Ximopanōltih",
+    "Yá'át'ééh",
+    "Siyalemukela",
+    "Siyalemukela",
+    "Bures boahtin",
+    "Re a go amogela",
+    "Velkommen",
+    "Benvengut!",
+    "Bon bini",
+    "Witam Cię",
+    "Bem-vindo",
+    "Haykuykuy!",
+    "T'aves baxtalo",
+    "Bainvegni",
+    "Afio mai",
+    "Ennidos",
+    "Walcome",
+    "Fàilte",
+    "Mauya",
+    "Bon vinutu",
+    "Vitaj",
+    "Dobrodošli",
+    "Soo dhowow",
+    "Witaj",
+    "Bienvenido",
+    "Wilujeng sumping",
+    "Karibu",
+    "Wamukelekile",
+    "Välkommen",
+    "Wilkomme",
+    "Maligayang pagdating",
+    "Maeva",
+    "Räxim itegez",
+    "Ksolok Bodik Mai",
+    "Ulu tons mai",
+    "Welkam",
+    "Talitali fiefia",
+    "Lek oy li la tale",
+    "amogetswe",
+    "Tempokani",
+    "Hoş geldin",
+    "Koş geldiniz",
+    "Ulufale mai!",
+    "Xush kelibsiz",
+    "Benvignùo",
+    "Tervhen tuldes",
+    "Hoan nghênh",
+    "Tere tulõmast",
+    "Benvnuwe",
+    "Croeso",
+    "Merhbe",
+    "Wamkelekile",
+    "Märr-ŋamathirri",
+    "Ẹ ku abọ",
+    "Kíimak 'oolal",
+    "Ngiyakwemukela",
+    "いらっしゃいませ"
+  };
+
+
+  printf("pdfioFileCreateFontObjFromFile(%s): ", textfontfile);
+  if ((textfont = pdfioFileCreateFontObjFromFile(pdf, textfontfile, unicode)) != NULL)
+    puts("PASS");
+  else
+    return (1);
+
+  fputs("pdfioDictCreate: ", stdout);
+  if ((dict = pdfioDictCreate(pdf)) != NULL)
+    puts("PASS");
+  else
+    return (1);
+
+  fputs("pdfioPageDictAddFont(F1): ", stdout);
+  if (pdfioPageDictAddFont(dict, "F1", font))
+    puts("PASS");
+  else
+    return (1);
+
+  fputs("pdfioPageDictAddFont(F2): ", stdout);
+  if (pdfioPageDictAddFont(dict, "F2", textfont))
+    puts("PASS");
+  else
+    return (1);
+
+  printf("pdfioFileCreatePage(%d): ", number);
+
+  if ((st = pdfioFileCreatePage(pdf, dict)) != NULL)
+    puts("PASS");
+  else
+    return (1);
+
+  if ((ptr = strrchr(textfontfile, '/')) != NULL)
+    strncpy(textname, ptr + 1, sizeof(textname) - 1);
+  else
+    strncpy(textname, textfontfile, sizeof(textname) - 1);
+
+  textname[sizeof(textname) - 1] = '\0';
+  if ((ptr = strrchr(textname, '.')) != NULL)
+    *ptr = '\0';
+
+  if (unicode)
+    snprintf(title, sizeof(title), "Unicode %s Font Test", textname);
+  else
+    snprintf(title, sizeof(title), "CP1252 %s Font Test", textname);
+
+  if (write_header_footer(st, title, number))
+    goto error;
+
+  fputs("pdfioContentTextBegin(): ", stdout);
+  if (pdfioContentTextBegin(st))
+    puts("PASS");
+  else
+    return (1);
 
-  // First open the test PDF file...
-  fputs("pdfioFileOpen(\"testfiles/testpdfio.pdf\"): ", stdout);
-  if ((inpdf = pdfioFileOpen("testfiles/testpdfio.pdf", /*password_cb*/NULL, /*password_data*/NULL, (pdfio_error_cb_t)error_cb, &error)) != NULL)
+  fputs("pdfioContentSetTextFont(\"F2\", 10.0): ", stdout);
+  if (pdfioContentSetTextFont(st, "F2", 10.0))
     puts("PASS");
   else
     return (1);
 
-  // TODO: Test for known values in this test file.
+  fputs("pdfioContentSetTextLeading(12.0): ", stdout);
+  if (pdfioContentSetTextLeading(st, 12.0))
+    puts("PASS");
+  else
+    goto error;
 
-  // Test dictionary APIs
-  fputs("pdfioDictCreate: ", stdout);
-  if ((dict = pdfioDictCreate(inpdf)) != NULL)
-  {
+  fputs("pdfioContentTextMoveTo(198.0, 702.0): ", stdout);
+  if (pdfioContentTextMoveTo(st, 198.0, 702.0))
     puts("PASS");
+  else
+    return (1);
 
-    fputs("pdfioDictSet*: ", stdout);
-    if (pdfioDictSetBoolean(dict, "Boolean", true) && pdfioDictSetName(dict, "Name", "Name") && pdfioDictSetNumber(dict, "Number", 42.0) && pdfioDictSetString(dict, "String", "String"))
+  for (i = 0; i < (int)(sizeof(welcomes) / sizeof(welcomes[0])); i ++)
+  {
+    if (i > 0 && (i % 50) == 0)
     {
-      puts("PASS");
+      fputs("pdfioContentTextMoveTo(162.0, 600.0): ", stdout);
+      if (pdfioContentTextMoveTo(st, 162.0, 600.0))
+	puts("PASS");
+      else
+	return (1);
     }
+
+    printf("pdfioContentTextMeasure(\"%s\"): ", welcomes[i]);
+    if ((width = pdfioContentTextMeasure(textfont, welcomes[i], 10.0)) >= 0.0)
+      puts("PASS");
     else
-    {
-      puts("FAIL");
       return (1);
-    }
 
-    fputs("pdfioDictIterateKeys: ", stdout);
-    pdfioDictIterateKeys(dict, iterate_cb, &count);
-    if (count == 4)
-    {
+    printf("pdfioContextTextMoveTo(%g, 0.0): ", -width);
+    if (pdfioContentTextMoveTo(st, -width, 0.0))
       puts("PASS");
-    }
     else
-    {
-      printf("FAIL (got %d, expected 4)\n", count);
       return (1);
-    }
-  }
-  else
-  {
-    puts("FAIL");
-    return (1);
-  }
 
-  // Test the value parsers for edge cases...
-  fputs("_pdfioValueRead(complex_dict): ", stdout);
-  s = complex_dict;
-  _pdfioTokenInit(&tb, inpdf, (_pdfio_tconsume_cb_t)token_consume_cb, (_pdfio_tpeek_cb_t)token_peek_cb, (void *)&s);
-  if (_pdfioValueRead(inpdf, NULL, &tb, &value, 0))
-  {
-    // TODO: Check value...
-    fputs("PASS: ", stdout);
-    _pdfioValueDebug(&value, stdout);
-    puts("\n");
-  }
-  else
-    goto fail;
+    printf("pdfioContentTextShowf(\"%s\"): ", welcomes[i]);
+    if (pdfioContentTextShowf(st, unicode, "%s\n", welcomes[i]))
+      puts("PASS");
+    else
+      return (1);
 
-  // Test the value parsers for edge cases...
-  fputs("_pdfioValueRead(cid_dict): ", stdout);
-  s = cid_dict;
-  _pdfioTokenInit(&tb, inpdf, (_pdfio_tconsume_cb_t)token_consume_cb, (_pdfio_tpeek_cb_t)token_peek_cb, (void *)&s);
-  if (_pdfioValueRead(inpdf, NULL, &tb, &value, 0))
-  {
-    // TODO: Check value...
-    fputs("PASS: ", stdout);
-    _pdfioValueDebug(&value, stdout);
-    puts("\n");
+    printf("pdfioContextTextMoveTo(%g, 0.0): ", width);
+    if (pdfioContentTextMoveTo(st, width, 0.0))
+      puts("PASS");
+    else
+      return (1);
   }
-  else
-    goto fail;
 
-  // Do crypto tests...
-  if (do_crypto_tests())
+  fputs("pdfioContentTextEnd(): ", stdout);
+  if (pdfioContentTextEnd(st))
+    puts("PASS");
+  else
     return (1);
 
-  // Create a new PDF file...
-  fputs("pdfioFileCreate(\"testpdfio-out.pdf\", ...): ", stdout);
-  if ((outpdf = pdfioFileCreate("testpdfio-out.pdf", NULL, NULL, NULL, (pdfio_error_cb_t)error_cb, &error)) != NULL)
+  fputs("pdfioStreamClose: ", stdout);
+  if (pdfioStreamClose(st))
     puts("PASS");
   else
-    goto fail;
-
-  if (write_unit_file(inpdf, "testpdfio-out.pdf", outpdf, &num_pages, &first_image))
-    goto fail;
-
-  if (read_unit_file("testpdfio-out.pdf", num_pages, first_image, false))
-    goto fail;
+    return (1);
 
-  // Stream a new PDF file...
-  if ((outfd = open("testpdfio-out2.pdf", O_CREAT | O_TRUNC | O_WRONLY | O_BINARY, 0666)) < 0)
-  {
-    perror("Unable to open \"testpdfio-out2.pdf\"");
-    goto fail;
-  }
+  return (0);
 
-  fputs("pdfioFileCreateOutput(...): ", stdout);
-  if ((outpdf = pdfioFileCreateOutput((pdfio_output_cb_t)output_cb, &outfd, NULL, NULL, NULL, (pdfio_error_cb_t)error_cb, &error)) != NULL)
-    puts("PASS");
-  else
-    goto fail;
+  error:
 
-  if (write_unit_file(inpdf, "testpdfio-out2.pdf", outpdf, &num_pages, &first_image))
-    goto fail;
+  pdfioStreamClose(st);
+  return (1);
+}
 
-  close(outfd);
 
-  if (read_unit_file("testpdfio-out2.pdf", num_pages, first_image, true))
-    goto fail;
+//
+// 'write_header_footer()' - Write common header and footer text.
+//
 
-  // Create new encrypted PDF files...
-  fputs("pdfioFileCreate(\"testpdfio-rc4.pdf\", ...): ", stdout);
-  if ((outpdf = pdfioFileCreate("testpdfio-rc4.pdf", NULL, NULL, NULL, (pdfio_error_cb_t)error_cb, &error)) != NULL)
+static int				// O - 1 on failure, 0 on success
+write_header_footer(
+    pdfio_stream_t *st,			// I - Page content stream
+    const char     *title,		// I - Title
+    int            number)		// I - Page number
+{
+  fputs("pdfioContentSetFillColorDeviceGray(0.0): ", stdout);
+  if (pdfioContentSetFillColorDeviceGray(st, 0.0))
     puts("PASS");
   else
     return (1);
 
-  fputs("pdfioFileSetPermissions(all, RC4-128, no passwords): ", stdout);
-  if (pdfioFileSetPermissions(outpdf, PDFIO_PERMISSION_ALL, PDFIO_ENCRYPTION_RC4_128, NULL, NULL))
+  fputs("pdfioContentTextBegin(): ", stdout);
+  if (pdfioContentTextBegin(st))
     puts("PASS");
   else
     return (1);
 
-  if (write_unit_file(inpdf, "testpdfio-rc4.pdf", outpdf, &num_pages, &first_image))
-    return (1);
-
-  if (read_unit_file("testpdfio-rc4.pdf", num_pages, first_image, false))
-    return (1);
-
-  // Create new encrypted PDF files...
-  fputs("pdfioFileCreate(\"testpdfio-rc4p.pdf\", ...): ", stdout);
-  if ((outpdf = pdfioFileCreate("testpdfio-rc4p.pdf", NULL, NULL, NULL, (pdfio_error_cb_t)error_cb, &error)) != NULL)
+  fputs("pdfioContentSetTextFont(\"F1\", 18.0): ", stdout);
+  if (pdfioContentSetTextFont(st, "F1", 18.0))
     puts("PASS");
   else
     return (1);
 
-  fputs("pdfioFileSetPermissions(no-print, RC4-128, passwords='owner' and 'user'): ", stdout);
-  if (pdfioFileSetPermissions(outpdf, PDFIO_PERMISSION_ALL ^ PDFIO_PERMISSION_PRINT, PDFIO_ENCRYPTION_RC4_128, "owner", "user"))
+  fputs("pdfioContentTextMoveTo(36.0, 738.0): ", stdout);
+  if (pdfioContentTextMoveTo(st, 36.0, 738.0))
     puts("PASS");
   else
     return (1);
 
-  if (write_unit_file(inpdf, "testpdfio-rc4p.pdf", outpdf, &num_pages, &first_image))
-    return (1);
-
-  if (read_unit_file("testpdfio-rc4p.pdf", num_pages, first_image, false))
-    return (1);
-
-  fputs("pdfioFileCreate(\"testpdfio-aes.pdf\", ...): ", stdout);
-  if ((outpdf = pdfioFileCreate("testpdfio-aes.pdf", NULL, NULL, NULL, (pdfio_error_cb_t)error_cb, &error)) != NULL)
+  printf("pdfioContentTextShow(\"%s\"): ", title);
+  if (pdfioContentTextShow(st, false, title))
     puts("PASS");
   else
     return (1);
 
-  fputs("pdfioFileSetPermissions(all, AES-128, no passwords): ", stdout);
-  if (pdfioFileSetPermissions(outpdf, PDFIO_PERMISSION_ALL, PDFIO_ENCRYPTION_AES_128, NULL, NULL))
+  fputs("pdfioContentSetTextFont(\"F1\", 12.0): ", stdout);
+  if (pdfioContentSetTextFont(st, "F1", 12.0))
     puts("PASS");
   else
     return (1);
 
-  if (write_unit_file(inpdf, "testpdfio-aes.pdf", outpdf, &num_pages, &first_image))
-    return (1);
-
-  if (read_unit_file("testpdfio-aes.pdf", num_pages, first_image, false))
-    return (1);
-
-  fputs("pdfioFileCreate(\"testpdfio-aesp.pdf\", ...): ", stdout);
-  if ((outpdf = pdfioFileCreate("testpdfio-aesp.pdf", NULL, NULL, NULL, (pdfio_error_cb_t)error_cb, &error)) != NULL)
+  fputs("pdfioContentTextMoveTo(514.0, -702.0): ", stdout);
+  if (pdfioContentTextMoveTo(st, 514.0, -702.0))
     puts("PASS");
   else
     return (1);
 
-  fputs("pdfioFileSetPermissions(no-print, AES-128, passwords='owner' and 'user'): ", stdout);
-  if (pdfioFileSetPermissions(outpdf, PDFIO_PERMISSION_ALL ^ PDFIO_PERMISSION_PRINT, PDFIO_ENCRYPTION_AES_128, "owner", "user"))
+  printf("pdfioContentTextShowf(\"%d\"): ", number);
+  if (pdfioContentTextShowf(st, false, "%d", number))
     puts("PASS");
   else
     return (1);
 
-  if (write_unit_file(inpdf, "testpdfio-aesp.pdf", outpdf, &num_pages, &first_image))
-    return (1);
-
-  if (read_unit_file("testpdfio-aesp.pdf", num_pages, first_image, false))
-    return (1);
-
-  fputs("pdfioFileCreateTemporary: ", stdout);
-  if ((outpdf = pdfioFileCreateTemporary(temppdf, sizeof(temppdf), NULL, NULL, NULL, (pdfio_error_cb_t)error_cb, &error)) != NULL)
-    printf("PASS (%s)\n", temppdf);
+  fputs("pdfioContentTextEnd(): ", stdout);
+  if (pdfioContentTextEnd(st))
+    puts("PASS");
   else
     return (1);
 
-  if (write_unit_file(inpdf, "<temporary>", outpdf, &num_pages, &first_image))
-    return (1);
-
-  if (read_unit_file(temppdf, num_pages, first_image, false))
-    return (1);
-
-  pdfioFileClose(inpdf);
-
   return (0);
-
-  fail:
-
-  pdfioFileClose(inpdf);
-
-  return (1);
 }
 
 
 //
-// 'draw_image()' - Draw an image with a label.
+// 'write_image_callback_file()' - Write and verify images using a line callback.
 //
 
 static int				// O - 1 on failure, 0 on success
-draw_image(pdfio_stream_t *st,
-           const char     *name,	// I - Name
-           double         x,		// I - X offset
-           double         y,		// I - Y offset
-           double         w,		// I - Image width
-           double         h,		// I - Image height
-           const char     *label)	// I - Label
+write_image_callback_file(
+    const char         *filename,	// I - PDF filename
+    pdfio_encryption_t encryption,	// I - Encryption to use
+    pdfio_option_t     options)		// I - Output options
 {
-  printf("pdfioContentDrawImage(name=\"%s\", x=%g, y=%g, w=%g, h=%g): ", name, x, y, w, h);
-  if (pdfioContentDrawImage(st, name, x, y, w, h))
-    puts("PASS");
-  else
-    return (1);
-
-  fputs("pdfioContentTextBegin(): ", stdout);
-  if (pdfioContentTextBegin(st))
-    puts("PASS");
-  else
-    return (1);
-
-  fputs("pdfioContentSetTextFont(\"F1\", 18.0): ", stdout);
-  if (pdfioContentSetTextFont(st, "F1", 18.0))
-    puts("PASS");
-  else
-    return (1);
+  int		ret = 1;		// Exit status
+  pdfio_file_t	*pdf;			// PDF file
+  pdfio_dict_t	*dict;			// Page dictionary
+  pdfio_stream_t *st;			// Page or image stream
+  pdfio_obj_t	*image;			// Image object
+  size_t	i,			// Looping var
+		x, y,			// Position in image
+		numbers[3];		// Image object numbers
+  ssize_t	bytes;			// Bytes read
+  bool		error = false;		// Error callback data
+  image_data_t	data;			// Image callback data
+  unsigned char	line[500 * 5],		// Generated line
+		buffer[500 * 4];	// Line read from image
+  static const size_t colors[3] =	// Number of colors for each image
+  { 1, 3, 4 };
+  static const bool alphas[3] =		// Alpha channel for each image?
+  { false, true, true };
 
-  printf("pdfioContentTextMoveTo(%g, %g): ", x, y + h + 9);
-  if (pdfioContentTextMoveTo(st, x, y + h + 9))
+
+  printf("pdfioFileCreate(\"%s\", ...): ", filename);
+  if ((pdf = pdfioFileCreate(filename, NULL, NULL, NULL, (pdfio_error_cb_t)error_cb, &error)) != NULL)
     puts("PASS");
   else
     return (1);
 
-  printf("pdfioContentTextShow(\"%s\"): ", label);
-  if (pdfioContentTextShow(st, false, label))
+  if (options != PDFIO_OPTION_NONE && !pdfioFileSetOptions(pdf, options))
+    goto close_pdf;
+
+  if (encryption != PDFIO_ENCRYPTION_NONE && !pdfioFileSetPermissions(pdf, PDFIO_PERMISSION_ALL, encryption, NULL, NULL))
+    goto close_pdf;
+
+  if ((dict = pdfioDictCreate(pdf)) == NULL)
+    goto close_pdf;
+
+  // Create the images...
+  for (i = 0; i < 3; i ++)
+  {
+    data.num_colors = colors[i];
+    data.alpha      = alphas[i];
+    data.lines      = 0;
+
+    printf("pdfioFileCreateImageObjFromCallback(colors=%u, alpha=%s): ", (unsigned)colors[i], alphas[i] ? "true" : "false");
+    if ((image = pdfioFileCreateImageObjFromCallback(pdf, (pdfio_image_cb_t)image_cb, &data, 500, 300, colors[i], NULL, alphas[i], false)) != NULL && data.lines == 300)
+    {
+      puts("PASS");
+    }
+    else
+    {
+      printf("FAIL (%u lines)\n", (unsigned)data.lines);
+      goto close_pdf;
+    }
+
+    numbers[i] = pdfioObjGetNumber(image);
+
+    snprintf((char *)buffer, sizeof(buffer), "IM%u", (unsigned)i + 1);
+    if (!pdfioPageDictAddImage(dict, pdfioStringCreate(pdf, (char *)buffer), image))
+      goto close_pdf;
+  }
+
+  // Draw the images on a page...
+  if ((st = pdfioFileCreatePage(pdf, dict)) == NULL)
+    goto close_pdf;
+
+  for (i = 0; i < 3; i ++)
+  {
+    snprintf((char *)buffer, sizeof(buffer), "IM%u", (unsigned)i + 1);
+    if (!pdfioContentDrawImage(st, (char *)buffer, 36.0, 36.0 + 240.0 * i, 300.0, 180.0))
+    {
+      pdfioStreamClose(st);
+      goto close_pdf;
+    }
+  }
+
+  if (!pdfioStreamClose(st))
+    goto close_pdf;
+
+  fputs("pdfioFileClose: ", stdout);
+  if (pdfioFileClose(pdf))
     puts("PASS");
   else
     return (1);
 
-  fputs("pdfioContentTextEnd(): ", stdout);
-  if (pdfioContentTextEnd(st))
+  // Read the images back and check them...
+  printf("pdfioFileOpen(\"%s\", ...): ", filename);
+  if ((pdf = pdfioFileOpen(filename, NULL, NULL, (pdfio_error_cb_t)error_cb, &error)) != NULL)
     puts("PASS");
   else
     return (1);
 
-  return (0);
-}
+  for (i = 0; i < 3; i ++)
+  {
+    size_t	bpp = alphas[i] ? colors[i] + 1 : colors[i];
+					// Bytes per generated pixel
 
+    data.num_colors = colors[i];
+    data.alpha      = alphas[i];
 
-//
-// 'error_cb()' - Display an error message during a unit test.
-//
+    printf("pdfioObjOpenStream(image %u): ", (unsigned)numbers[i]);
+    if ((image = pdfioFileFindObj(pdf, numbers[i])) != NULL && (st = pdfioObjOpenStream(image, true)) != NULL)
+    {
+      puts("PASS");
+    }
+    else
+    {
+      puts("FAIL");
+      goto close_pdf;
+    }
 
-static bool				// O  - `true` to stop, `false` to continue
-error_cb(pdfio_file_t *pdf,		// I  - PDF file
-         const char   *message,		// I  - Error message
-	 bool         *error)		// IO - Have we displayed an error?
-{
-  (void)pdf;
+    printf("pdfioStreamRead(image %u): ", (unsigned)numbers[i]);
+    for (y = 0; y < 300; y ++)
+    {
+      image_cb(&data, y, line, 500 * bpp);
 
-  if (!*error)
-  {
-    // First error, so show a "FAIL" indicator
-    *error = true;
+      for (x = 0; x < (500 * colors[i]); x ++)
+        line[x] = line[(x / colors[i]) * bpp + x % colors[i]];
 
-    puts("FAIL");
-  }
+      if ((bytes = pdfioStreamRead(st, buffer, 500 * colors[i])) != (ssize_t)(500 * colors[i]) || memcmp(buffer, line, 500 * colors[i]))
+        break;
+    }
 
-  // Indent error messages...
-  printf("    %s\n", message);
+    pdfioStreamClose(st);
 
-  // Continue to catch more errors...
-  return (false);
-}
+    if (y < 300)
+    {
+      printf("FAIL (line %u)\n", (unsigned)y);
+      goto close_pdf;
+    }
 
+    puts("PASS");
 
-//
-// 'iterate_cb()' - Test pdfioDictIterateKeys function.
-//
+    if (!alphas[i])
+    {
+      fputs("pdfioDictGetObj(SMask): ", stdout);
+      if (!pdfioDictGetObj(pdfioObjGetDict(image), "SMask"))
+      {
+        puts("PASS");
+        continue;
+      }
 
-static bool				// O - `true` to continue, `false` to stop
-iterate_cb(pdfio_dict_t *dict,		// I - Dictionary
-           const char   *key,		// I - Key
-           void         *cb_data)	// I - Callback data
-{
-  int	*count = (int *)cb_data;	// Pointer to counter
+      puts("FAIL (unexpected mask)");
+      goto close_pdf;
+    }
 
+    fputs("pdfioDictGetObj(SMask): ", stdout);
+    if ((image = pdfioDictGetObj(pdfioObjGetDict(image), "SMask")) != NULL && (st = pdfioObjOpenStream(image, true)) != NULL)
+    {
+      puts("PASS");
+    }
+    else
+    {
+      puts("FAIL");
+      goto close_pdf;
+    }
 
-  if (!dict || !key || !cb_data)
-    return (false);
+    printf("pdfioStreamRead(mask %u): ", (unsigned)pdfioObjGetNumber(image));
+    for (y = 0; y < 300; y ++)
+    {
+      image_cb(&data, y, line, 500 * bpp);
 
-  (*count)++;
+      for (x = 0; x < 500; x ++)
+        line[x] = line[x * bpp + colors[i]];
 
-  return (true);
-}
+      if ((bytes = pdfioStreamRead(st, buffer, 500)) != 500 || memcmp(buffer, line, 500))
+        break;
+    }
 
+    pdfioStreamClose(st);
 
-//
-// 'output_cb()' - Write output to a file.
-//
+    if (y < 300)
+    {
+      printf("FAIL (line %u)\n", (unsigned)y);
+      goto close_pdf;
+    }
 
-static ssize_t				// O - Number of bytes written
-output_cb(int        *fd,		// I - File descriptor
-          const void *buffer,		// I - Output buffer
-          size_t     bytes)		// I - Number of bytes to write
-{
-  return (write(*fd, buffer, bytes));
-}
+    puts("PASS");
+  }
 
+  ret = 0;
 
-//
-// 'password_cb()' - Password callback for PDF file.
-//
+  close_pdf:
 
-static const char *			// O - Password string
-password_cb(void       *data,		// I - Callback data
-            const char *filename)	// I - Filename (not used)
-{
-  (void)filename;
+  pdfioFileClose(pdf);
 
-  return ((const char *)data);
+  return (ret);
 }
 
 
 //
-// 'read_unit_file()' - Read back a unit test file and confirm its contents.
+// 'write_image_memory_file()' - Write and verify images copied from memory and a read callback.
 //
 
-static int				// O - Exit status
-read_unit_file(const char *filename,	// I - File to read
-               size_t     num_pages,	// I - Expected number of pages
-	       size_t     first_image,	// I - First image object
-	       bool       is_output)	// I - File written with output callback?
+static int				// O - 1 on failure, 0 on success
+write_image_memory_file(
+    const char *filename)		// I - PDF filename
 {
+  int		ret = 1;		// Exit status
   pdfio_file_t	*pdf;			// PDF file
-  pdfio_dict_t	*catalog;		// Catalog dictionary
-  size_t	i;			// Looping var
-  const char	*s;			// String
+  pdfio_dict_t	*dict;			// Page dictionary
+  pdfio_stream_t *st;			// Page or image stream
+  pdfio_obj_t	*images[3];		// Image objects
+  size_t	i, j,			// Looping vars
+		numbers[4][3],		// Image object numbers
+		lengths[3];		// Lengths of image data
+  int		fd;			// File descriptor
+  struct stat	fileinfo;		// File information
+  io_data_t	io;			// Input callback data
+  ssize_t	bytes;			// Bytes read
   bool		error = false;		// Error callback data
+  char		name[32];		// Image name
+  unsigned char	*data[3] = { NULL, NULL, NULL },
+					// Image data read back
+		bad[64];		// Unsupported image data
+  static const char * const files[4] =	// Image files
+  {
+    "testfiles/color.jpg",
+    "testfiles/gray.jpg",
+    "testfiles/pdfio-color.png",
+    "testfiles/pdfio-indexed.png"
+  };
 
 
-  // Open the new PDF file to read it...
-  printf("pdfioFileOpen(\"%s\", ...): ", filename);
-  if ((pdf = pdfioFileOpen(filename, password_cb, (void *)"user", (pdfio_error_cb_t)error_cb, &error)) != NULL)
+  printf("pdfioFileCreate(\"%s\", ...): ", filename);
+  if ((pdf = pdfioFileCreate(filename, NULL, NULL, NULL, (pdfio_error_cb_t)error_cb, &error)) != NULL)
     puts("PASS");
   else
     return (1);
 
-  // Get the root object/catalog dictionary
-  fputs("pdfioFileGetCatalog: ", stdout);
-  if ((catalog = pdfioFileGetCatalog(pdf)) != NULL)
-  {
-    puts("PASS");
-  }
-  else
-  {
-    puts("FAIL (got NULL, expected dictionary)");
-    return (1);
-  }
+  if ((dict = pdfioDictCreate(pdf)) == NULL)
+    goto close_pdf;
 
-  // Verify some catalog values...
-  fputs("pdfioDictGetName(PageLayout): ", stdout);
-  if ((s = pdfioDictGetName(catalog, "PageLayout")) != NULL && !strcmp(s, "SinglePage"))
-  {
-    puts("PASS");
-  }
-  else if (s)
-  {
-    printf("FAIL (got '%s', expected 'SinglePage')\n", s);
-    return (1);
-  }
-  else
+  // Copy each image file using a filename, memory, and a read callback...
+  for (i = 0; i < 4; i ++)
   {
-    puts("FAIL (got NULL, expected 'SinglePage')");
-    return (1);
-  }
+    memset(&io, 0, sizeof(io));
 
-  fputs("pdfioDictGetName(PageLayout): ", stdout);
-  if ((s = pdfioDictGetName(catalog, "PageLayout")) != NULL && !strcmp(s, "SinglePage"))
-  {
-    puts("PASS");
-  }
-  else if (s)
-  {
-    printf("FAIL (got '%s', expected 'SinglePage')\n", s);
-    return (1);
-  }
-  else
-  {
-    puts("FAIL (got NULL, expected 'SinglePage')");
-    return (1);
-  }
+    if ((fd = open(files[i], O_RDONLY | O_BINARY)) < 0 || fstat(fd, &fileinfo) || (io.data = (unsigned char *)malloc((size_t)fileinfo.st_size)) == NULL || read(fd, io.data, (size_t)fileinfo.st_size) != (ssize_t)fileinfo.st_size)
+    {
+      printf("write_image_memory_file: Unable to load \"%s\": %s\n", files[i], strerror(errno));
+      if (fd >= 0)
+        close(fd);
+      free(io.data);
+      goto close_pdf;
+    }
 
-  fputs("pdfioDictGetName(PageMode): ", stdout);
-  if ((s = pdfioDictGetName(catalog, "PageMode")) != NULL && !strcmp(s, "UseThumbs"))
-  {
-    puts("PASS");
-  }
-  else if (s)
-  {
-    printf("FAIL (got '%s', expected 'UseThumbs')\n", s);
-    return (1);
-  }
-  else
-  {
-    puts("FAIL (got NULL, expected 'UseThumbs')");
-    return (1);
-  }
+    close(fd);
 
-  fputs("pdfioDictGetString(Lang): ", stdout);
-  if ((s = pdfioDictGetString(catalog, "Lang")) != NULL && !strcmp(s, "en"))
-  {
-    puts("PASS");
-  }
-  else if (s)
-  {
-    printf("FAIL (got '%s', expected 'en')\n", s);
-    return (1);
-  }
-  else
-  {
-    puts("FAIL (got NULL, expected 'en')");
-    return (1);
-  }
+    io.datalen = (size_t)fileinfo.st_size;
 
-  // Verify metadata...
-  fputs("pdfioFileGetAuthor: ", stdout);
-  if ((s = pdfioFileGetAuthor(pdf)) != NULL && !strcmp(s, "Michael R Sweet"))
-  {
-    puts("PASS");
-  }
-  else if (s)
-  {
-    printf("FAIL (got '%s', expected 'Michael R Sweet')\n", s);
-    return (1);
-  }
-  else
-  {
-    puts("FAIL (got NULL, expected 'Michael R Sweet')");
-    return (1);
-  }
+    printf("pdfioFileCreateImageObjFromFile(\"%s\"): ", files[i]);
+    if ((images[0] = pdfioFileCreateImageObjFromFile(pdf, files[i], false)) != NULL)
+      puts("PASS");
+    else
+      goto free_data;
 
-  fputs("pdfioFileGetCreator: ", stdout);
-  if ((s = pdfioFileGetCreator(pdf)) != NULL && !strcmp(s, "testpdfio"))
-  {
-    puts("PASS");
-  }
-  else if (s)
-  {
-    printf("FAIL (got '%s', expected 'testpdfio')\n", s);
-    return (1);
-  }
-  else
-  {
-    puts("FAIL (got NULL, expected 'testpdfio')");
-    return (1);
-  }
+    printf("pdfioFileCreateImageObjFromMemory(\"%s\"): ", files[i]);
+    if ((images[1] = pdfioFileCreateImageObjFromMemory(pdf, io.data, io.datalen, false)) != NULL)
+      puts("PASS");
+    else
+      goto free_data;
+
+    printf("pdfioFileCreateImageObjFromMemory(\"%s\", cached): ", files[i]);
+    if (pdfioFileCreateImageObjFromMemory(pdf, io.data, io.datalen, false) == images[1])
+    {
+      puts("PASS");
+    }
+    else
+    {
+      puts("FAIL (different object)");
+      goto free_data;
+    }
+
+    printf("pdfioFileCreateImageObjFromIO(\"%s\"): ", files[i]);
+    if ((images[2] = pdfioFileCreateImageObjFromIO(pdf, (pdfio_input_cb_t)input_cb, &io, false)) != NULL)
+      puts("PASS");
+    else
+      goto free_data;
+
+    free(io.data);
 
-  fputs("pdfioFileGetKeywords: ", stdout);
-  if ((s = pdfioFileGetKeywords(pdf)) != NULL && !strcmp(s, "one fish,two fish,red fish,blue fish"))
-  {
-    puts("PASS");
+    for (j = 0; j < 3; j ++)
+    {
+      numbers[i][j] = pdfioObjGetNumber(images[j]);
+
+      snprintf(name, sizeof(name), "IM%u", (unsigned)(i * 3 + j + 1));
+      if (!pdfioPageDictAddImage(dict, pdfioStringCreate(pdf, name), images[j]))
+        goto close_pdf;
+    }
   }
-  else if (s)
+
+  memset(bad, 0, sizeof(bad));
+
+  fputs("pdfioFileCreateImageObjFromMemory(unsupported): ", stdout);
+  if (pdfioFileCreateImageObjFromMemory(pdf, bad, sizeof(bad), false))
   {
-    printf("FAIL (got '%s', expected 'one fish,two fish,red fish,blue fish')\n", s);
-    return (1);
+    puts("FAIL (unexpected object)");
+    goto close_pdf;
   }
   else
+    puts("PASS");
+
+  // Draw the images on a page...
+  if ((st = pdfioFileCreatePage(pdf, dict)) == NULL)
+    goto close_pdf;
+
+  for (i = 0; i < 12; i ++)
   {
-    puts("FAIL (got NULL, expected 'one fish,two fish,red fish,blue fish')");
-    return (1);
+    snprintf(name, sizeof(name), "IM%u", (unsigned)i + 1);
+    if (!pdfioContentDrawImage(st, name, 36.0 + 180.0 * (i % 3), 36.0 + 180.0 * (i / 3), 144.0, 144.0))
+    {
+      pdfioStreamClose(st);
+      goto close_pdf;
+    }
   }
 
-  fputs("pdfioFileGetSubject: ", stdout);
-  if ((s = pdfioFileGetSubject(pdf)) != NULL && !strcmp(s, "Unit test document"))
-  {
+  if (!pdfioStreamClose(st))
+    goto close_pdf;
+
+  fputs("pdfioFileClose: ", stdout);
+  if (pdfioFileClose(pdf))
     puts("PASS");
-  }
-  else if (s)
-  {
-    printf("FAIL (got '%s', expected 'Unit test document')\n", s);
-    return (1);
-  }
   else
-  {
-    puts("FAIL (got NULL, expected 'Unit test document')");
     return (1);
-  }
 
-  fputs("pdfioFileGetTitle: ", stdout);
-  if ((s = pdfioFileGetTitle(pdf)) != NULL && !strcmp(s, "Test Document"))
-  {
+  // Read the images back and compare them...
+  printf("pdfioFileOpen(\"%s\", ...): ", filename);
+  if ((pdf = pdfioFileOpen(filename, NULL, NULL, (pdfio_error_cb_t)error_cb, &error)) != NULL)
     puts("PASS");
-  }
-  else if (s)
-  {
-    printf("FAIL (got '%s', expected 'Test Document')\n", s);
-    return (1);
-  }
   else
-  {
-    puts("FAIL (got NULL, expected 'Test Document')");
     return (1);
-  }
 
-  // Verify the number of pages is the same...
-  fputs("pdfioFileGetNumPages: ", stdout);
-  if (num_pages == pdfioFileGetNumPages(pdf))
-  {
-    puts("PASS");
-  }
-  else
+  for (j = 0; j < 3; j ++)
   {
-    printf("FAIL (%lu != %lu)\n", (unsigned long)num_pages, (unsigned long)pdfioFileGetNumPages(pdf));
-    return (1);
+    if ((data[j] = (unsigned char *)malloc(262144)) == NULL)
+      goto close_pdf;
   }
 
-  // Verify the images
-  for (i = 0; i < 7; i ++)
+  for (i = 0; i < 4; i ++)
   {
-    if (is_output)
+    printf("pdfioStreamRead(\"%s\" images): ", files[i]);
+
+    for (j = 0; j < 3; j ++)
     {
-      if (verify_image(pdf, first_image + (size_t)i * 2))
-        return (1);
+      if ((st = pdfioObjOpenStream(pdfioFileFindObj(pdf, numbers[i][j]), false)) == NULL)
+        break;
+
+      for (lengths[j] = 0; lengths[j] < 262144 && (bytes = pdfioStreamRead(st, data[j] + lengths[j], 262144 - lengths[j])) > 0; lengths[j] += (size_t)bytes);
+
+      pdfioStreamClose(st);
+
+      if (j > 0 && (lengths[j] != lengths[0] || memcmp(data[j], data[0], lengths[0])))
+        break;
     }
-    else if (verify_image(pdf, first_image + (size_t)i))
-      return (1);
+
+    if (j < 3)
+    {
+      printf("FAIL (image %u differs)\n", (unsigned)numbers[i][j]);
+      goto close_pdf;
+    }
+
+    printf("PASS (%u bytes)\n", (unsigned)lengths[0]);
   }
 
-  // Close the new PDF file...
-  fputs("pdfioFileClose(\"testpdfio-out.pdf\"): ", stdout);
-  if (pdfioFileClose(pdf))
-    puts("PASS");
-  else
-    return (1);
+  ret = 0;
+  goto close_pdf;
 
-  return (0);
+  free_data:
+
+  free(io.data);
+
+  close_pdf:
+
+  for (j = 0; j < 3; j ++)
+    free(data[j]);
+
+  pdfioFileClose(pdf);
+
+  return (ret);
 }
 
 
 //
-// 'token_consume_cb()' - Consume bytes from a test string.
+// 'write_image_object()' - Write an image object using the specified predictor.
 //
 
-static ssize_t				// O  - Number of bytes consumed
-token_consume_cb(const char **s,	// IO - Test string
-                 size_t     bytes)	// I  - Bytes to consume
+static pdfio_obj_t *			// O - Image object
+write_image_object(
+    pdfio_file_t       *pdf,		// I - PDF file
+    _pdfio_predictor_t predictor)	// I - Predictor to use
 {
-  size_t	len = strlen(*s);	// Number of bytes remaining
+  pdfio_dict_t	*dict,			// Image dictionary
+		*decode;		// Decode dictionary
+  pdfio_obj_t	*obj;			// Image object
+  pdfio_stream_t *st;			// Image stream
+  int		x, y;			// Coordinates in image
+  unsigned char	buffer[768],		// Buffer for image
+		*bufptr;		// Pointer into buffer
 
 
-  // "Consume" bytes by incrementing the string pointer, limiting to the
-  // remaining length...
-  if (bytes > len)
-    bytes = len;
+  // Create the image dictionary...
+  if ((dict = pdfioDictCreate(pdf)) == NULL)
+    return (NULL);
 
-  *s += bytes;
+  pdfioDictSetName(dict, "Type", "XObject");
+  pdfioDictSetName(dict, "Subtype", "Image");
+  pdfioDictSetNumber(dict, "Width", 256);
+  pdfioDictSetNumber(dict, "Height", 256);
+  pdfioDictSetNumber(dict, "BitsPerComponent", 8);
+  pdfioDictSetName(dict, "ColorSpace", "DeviceRGB");
+  pdfioDictSetName(dict, "Filter", "FlateDecode");
 
-  return ((ssize_t)bytes);
+  // DecodeParms dictionary...
+  if ((decode = pdfioDictCreate(pdf)) == NULL)
+    return (NULL);
+
+  pdfioDictSetNumber(decode, "BitsPerComponent", 8);
+  pdfioDictSetNumber(decode, "Colors", 3);
+  pdfioDictSetNumber(decode, "Columns", 256);
+  pdfioDictSetNumber(decode, "Predictor", predictor);
+  pdfioDictSetDict(dict, "DecodeParms", decode);
+
+  // Create the image object...
+  if ((obj = pdfioFileCreateObj(pdf, dict)) == NULL)
+    return (NULL);
+
+  // Create the image stream and write the image...
+  if ((st = pdfioObjCreateStream(obj, PDFIO_FILTER_FLATE)) == NULL)
+    return (NULL);
+
+  // This creates a useful criss-cross image that highlights predictor errors...
+  for (y = 0; y < 256; y ++)
+  {
+    for (x = 0, bufptr = buffer; x < 256; x ++, bufptr += 3)
+    {
+      bufptr[0] = (unsigned char)y;
+      bufptr[1] = (unsigned char)(y + x);
+      bufptr[2] = (unsigned char)(y - x);
+    }
+
+    if (!pdfioStreamWrite(st, buffer, sizeof(buffer)))
+    {
+      pdfioStreamClose(st);
+      return (NULL);
+    }
+  }
+
+  // Close the object and stream...
+  pdfioStreamClose(st);
+
+  return (obj);
 }
 
 
 //
-// 'token_peek_cb()' - Peek bytes from a test string.
+// 'write_images_test()' - Write a series of test images.
 //
 
-static ssize_t				// O  - Number of bytes peeked
-token_peek_cb(const char **s,		// IO - Test string
-              char       *buffer,	// I  - Buffer
-              size_t     bytes)		// I  - Bytes to peek
+static int				// O - 1 on failure, 0 on success
+write_images_test(
+    pdfio_file_t *pdf,			// I - PDF file
+    int          number,		// I - Page number
+    pdfio_obj_t  *font)			// I - Text font
 {
-  size_t	len = strlen(*s);	// Number of bytes remaining
+  pdfio_dict_t	*dict;			// Page dictionary
+  pdfio_stream_t *st;			// Page stream
+  _pdfio_predictor_t p;			// Current predictor
+  pdfio_obj_t	*noimage,		// No predictor
+		*pimages[6];		// Images using PNG predictors
+  char		pname[32],		// Image name
+		plabel[32];		// Image label
 
 
-  // Copy bytes from the test string as possible...
-  if (bytes > len)
-    bytes = len;
+  // Create the images...
+  fputs("Create Image (Predictor 1): ", stdout);
+  if ((noimage = write_image_object(pdf, _PDFIO_PREDICTOR_NONE)) != NULL)
+    puts("PASS");
+  else
+    return (1);
 
-  if (bytes > 0)
-    memcpy(buffer, *s, bytes);
+  for (p = _PDFIO_PREDICTOR_PNG_NONE; p <= _PDFIO_PREDICTOR_PNG_AUTO; p ++)
+  {
+    printf("Create Image (Predictor %d): ", p);
+    if ((pimages[p - _PDFIO_PREDICTOR_PNG_NONE] = write_image_object(pdf, p)) != NULL)
+      puts("PASS");
+    else
+      return (1);
+  }
 
-  return ((ssize_t)bytes);
-}
+  // Create the page dictionary, object, and stream...
+  fputs("pdfioDictCreate: ", stdout);
+  if ((dict = pdfioDictCreate(pdf)) != NULL)
+    puts("PASS");
+  else
+    return (1);
+
+  fputs("pdfioPageDictAddImage(1): ", stdout);
+  if (pdfioPageDictAddImage(dict, "IM1", noimage))
+    puts("PASS");
+  else
+    return (1);
+
+  for (p = _PDFIO_PREDICTOR_PNG_NONE; p <= _PDFIO_PREDICTOR_PNG_AUTO; p ++)
+  {
+    printf("pdfioPageDictAddImage(%d): ", p);
+    snprintf(pname, sizeof(pname), "IM%d", p);
+    if (pdfioPageDictAddImage(dict, pdfioStringCreate(pdf, pname), pimages[p - _PDFIO_PREDICTOR_PNG_NONE]))
+      puts("PASS");
+    else
+      return (1);
+  }
+
+  fputs("pdfioPageDictAddFont(F1): ", stdout);
+  if (pdfioPageDictAddFont(dict, "F1", font))
+    puts("PASS");
+  else
+    return (1);
+
+  printf("pdfioFileCreatePage(%d): ", number);
+
+  if ((st = pdfioFileCreatePage(pdf, dict)) != NULL)
+    puts("PASS");
+  else
+    return (1);
+
+  if (write_header_footer(st, "Image Predictor Test", number))
+    goto error;
+
+  // Draw images
+  if (draw_image(st, "IM1", 36, 522, 144, 144, "No Predictor"))
+    goto error;
+
+  for (p = _PDFIO_PREDICTOR_PNG_NONE; p <= _PDFIO_PREDICTOR_PNG_AUTO; p ++)
+  {
+    int i = (int)p - _PDFIO_PREDICTOR_PNG_NONE;
+
+    snprintf(pname, sizeof(pname), "IM%d", p);
+    snprintf(plabel, sizeof(plabel), "PNG Predictor %d", p);
 
+    if (draw_image(st, pname, 36 + 180 * (i % 3), 306 - 216 * (i / 3), 144, 144, plabel))
+      goto error;
+  }
+
+  // Wrap up...
+  fputs("pdfioStreamClose: ", stdout);
+  if (pdfioStreamClose(st))
+    puts("PASS");
+  else
+    return (1);
 
-//
-// 'usage()' - Show program usage.
-//
+  return (0);
 
-static int				// O - Exit status
-usage(FILE *fp)				// I - Output file
-{
-  fputs("Usage: ./testpdfio [OPTIONS] [FILENAME [OBJNUM]] ...\n", fp);
-  fputs("Options:\n", fp);
-  fputs("  --help               Show program help.\n", fp);
-  fputs("  --password PASSWORD  Set PDF password.\n", fp);
-  fputs("  --verbose            Be verbose.\n", fp);
+  error:
 
-  return (fp != stdout);
+  pdfioStreamClose(st);
+  return (1);
 }
 
 
 //
-// 'verify_image()' - Verify an image object.
+// 'write_jpeg_test()' - Write a page with a JPEG image to a PDF file.
 //
 
 static int				// O - 1 on failure, 0 on success
-verify_image(pdfio_file_t *pdf,		// I - PDF file
-             size_t       number)	// I - Object number
+write_jpeg_test(pdfio_file_t *pdf,	// I - PDF file
+                const char   *title,	// I - Page title
+		int          number,	// I - Page number
+		pdfio_obj_t  *font,	// I - Text font
+		pdfio_obj_t  *image)	// I - Image to draw
 {
-  pdfio_obj_t	*obj;			// Image object
-  const char	*type,			// Object type
-		*subtype;		// Object subtype
-  double	width,			// Width of object
-		height;			// Height of object
-  pdfio_stream_t *st;			// Stream
-  int		x, y;			// Coordinates in image
-  unsigned char	buffer[768],		// Expected data
-		*bufptr,		// Pointer into buffer
-		line[768];		// Line from file
-  ssize_t	bytes;			// Bytes read from stream
+  pdfio_dict_t		*dict;		// Page dictionary
+  pdfio_stream_t	*st;		// Page contents stream
+  double		width,		// Width of image
+			height;		// Height of image
+  double		swidth,		// Scaled width
+			sheight,	// Scaled height
+			tx,		// X offset
+			ty;		// Y offset
 
 
-  printf("pdfioFileFindObj(%lu): ", (unsigned long)number);
-  if ((obj = pdfioFileFindObj(pdf, number)) != NULL)
+  // Create the page dictionary, object, and stream...
+  fputs("pdfioDictCreate: ", stdout);
+  if ((dict = pdfioDictCreate(pdf)) != NULL)
     puts("PASS");
   else
     return (1);
 
-  fputs("pdfioObjGetType: ", stdout);
-  if ((type = pdfioObjGetType(obj)) != NULL && !strcmp(type, "XObject"))
-  {
+  fputs("pdfioPageDictAddImage: ", stdout);
+  if (pdfioPageDictAddImage(dict, "IM1", image))
     puts("PASS");
-  }
   else
-  {
-    printf("FAIL (got %s, expected XObject)\n", type);
     return (1);
-  }
 
-  fputs("pdfioObjGetSubtype: ", stdout);
-  if ((subtype = pdfioObjGetSubtype(obj)) != NULL && !strcmp(subtype, "Image"))
-  {
+  fputs("pdfioPageDictAddFont(F1): ", stdout);
+  if (pdfioPageDictAddFont(dict, "F1", font))
     puts("PASS");
-  }
   else
-  {
-    printf("FAIL (got %s, expected Image)\n", subtype);
     return (1);
-  }
 
-  fputs("pdfioImageGetWidth: ", stdout);
-  if ((width = pdfioImageGetWidth(obj)) == 256.0)
-  {
+  printf("pdfioFileCreatePage(%d): ", number);
+
+  if ((st = pdfioFileCreatePage(pdf, dict)) != NULL)
     puts("PASS");
-  }
   else
-  {
-    printf("FAIL (got %g, expected 256)\n", width);
     return (1);
-  }
 
-  fputs("pdfioImageGetHeight: ", stdout);
-  if ((height = pdfioImageGetHeight(obj)) == 256.0)
-  {
+  if (write_header_footer(st, title, number))
+    goto error;
+
+  // Calculate the scaled size of the image...
+  fputs("pdfioImageGetWidth(): ", stdout);
+  if ((width = pdfioImageGetWidth(image)) > 0.0)
     puts("PASS");
-  }
   else
-  {
-    printf("FAIL (got %g, expected 256)\n", height);
-    return (1);
-  }
+    goto error;
 
-  // Open the image stream, read the image, and verify it matches expectations...
-  fputs("pdfioObjOpenStream: ", stdout);
-  if ((st = pdfioObjOpenStream(obj, PDFIO_FILTER_FLATE)) != NULL)
+  fputs("pdfioImageGetHeight(): ", stdout);
+  if ((height = pdfioImageGetHeight(image)) > 0.0)
     puts("PASS");
   else
-    return (1);
+    goto error;
 
-  for (y = 0; y < 256; y ++)
+  swidth  = 400.0;
+  sheight = swidth * height / width;
+  if (sheight > 500.0)
   {
-    for (x = 0, bufptr = buffer; x < 256; x ++, bufptr += 3)
-    {
-      bufptr[0] = (unsigned char)y;
-      bufptr[1] = (unsigned char)(y + x);
-      bufptr[2] = (unsigned char)(y - x);
-    }
-
-    if ((bytes = pdfioStreamRead(st, line, sizeof(line))) != (ssize_t)sizeof(line))
-    {
-      printf("pdfioStreamRead: FAIL (got %d for line %d, expected 768)\n", y, (int)bytes);
-      pdfioStreamClose(st);
-      return (1);
-    }
-
-    if (memcmp(buffer, line, sizeof(buffer)))
-    {
-      printf("pdfioStreamRead: FAIL (line %d doesn't match expectations)\n", y);
-      pdfioStreamClose(st);
-      return (1);
-    }
+    sheight = 500.0;
+    swidth  = sheight * width / height;
   }
 
-  pdfioStreamClose(st);
-
-  return (0);
-}
-
-
-//
-// 'write_alpha_test()' - Write a series of test images with alpha channels.
-//
-
-static int				// O - 1 on failure, 0 on success
-write_alpha_test(
-    pdfio_file_t *pdf,			// I - PDF file
-    int          number,		// I - Page number
-    pdfio_obj_t  *font)			// I - Text font
-{
-  pdfio_dict_t	*dict;			// Page dictionary
-  pdfio_stream_t *st;			// Page stream
-  pdfio_obj_t	*images[6];		// Images using PNG predictors
-  char		iname[32];		// Image name
-  int		i,			// Image number
-		x, y;			// Coordinates in image
-  unsigned char	buffer[1280 * 256],	// Buffer for image
-		*bufptr;		// Pointer into buffer
-
-
-  // Create the images...
-  for (i = 0; i < 6; i ++)
-  {
-    size_t	num_colors = 0;		// Number of colors
-
-    // Generate test image data...
-    switch (i)
-    {
-      case 0 : // Grayscale
-      case 3 : // Grayscale + alpha
-          num_colors = 1;
-	  for (y = 0, bufptr = buffer; y < 256; y ++)
-	  {
-	    for (x = 0; x < 256; x ++)
-	    {
-	      unsigned char r = (unsigned char)y;
-	      unsigned char g = (unsigned char)(y + x);
-	      unsigned char b = (unsigned char)(y - x);
+  tx = 0.5 * (595.28 - swidth);
+  ty = 0.5 * (792 - sheight);
 
-              *bufptr++ = (unsigned char)((r * 30 + g * 59 + b * 11) / 100);
+  // Show "raw" content (a bordered box for the image...)
+  fputs("pdfioStreamPrintf(...): ", stdout);
+  if (pdfioStreamPrintf(st,
+                       "1 0 0 RG 0 g 5 w\n"
+                       "%g %g %g %g re %g %g %g %g re B*\n", tx - 36, ty - 36, swidth + 72, sheight + 72, tx - 1, ty - 1, swidth + 2, sheight + 2))
+    puts("PASS");
+  else
+    goto error;
 
-	      if (i > 2)
-	      {
-	        // Add alpha channel
-	        if (x < 112 || x >= 144 || y < 112 || y >= 144)
-		  *bufptr++ = (unsigned char)((x - 128) * (y - 128));
-		else
-		  *bufptr++ = 0;
-	      }
-	    }
-	  }
-          break;
+  // Draw the image inside the border box...
+  printf("pdfioContentDrawImage(\"IM1\", x=%g, y=%g, w=%g, h=%g): ", tx, ty, swidth, sheight);
+  if (pdfioContentDrawImage(st, "IM1", tx, ty, swidth, sheight))
+    puts("PASS");
+  else
+    goto error;
 
-      case 1 : // RGB
-      case 4 : // RGB + alpha
-          num_colors = 3;
-	  for (y = 0, bufptr = buffer; y < 256; y ++)
-	  {
-	    for (x = 0; x < 256; x ++)
-	    {
-	      *bufptr++ = (unsigned char)y;
-	      *bufptr++ = (unsigned char)(y + x);
-	      *bufptr++ = (unsigned char)(y - x);
+  // Close the page stream/object...
+  fputs("pdfioStreamClose: ", stdout);
+  if (pdfioStreamClose(st))
+    puts("PASS");
+  else
+    return (1);
 
-	      if (i > 2)
-	      {
-	        // Add alpha channel
-	        if (x < 112 || x >= 144 || y < 112 || y >= 144)
-		  *bufptr++ = (unsigned char)((x - 128) * (y - 128));
-		else
-		  *bufptr++ = 0;
-	      }
-	    }
-	  }
-          break;
-      case 2 : // CMYK
-      case 5 : // CMYK + alpha
-          num_colors = 4;
-	  for (y = 0, bufptr = buffer; y < 256; y ++)
-	  {
-	    for (x = 0; x < 256; x ++)
-	    {
-	      unsigned char cc = (unsigned char)y;
-	      unsigned char mm = (unsigned char)(y + x);
-	      unsigned char yy = (unsigned char)(y - x);
-	      unsigned char kk = cc < mm ? cc < yy ? cc : yy : mm < yy ? mm : yy;
+  return (0);
 
-              *bufptr++ = (unsigned char)(cc - kk);
-              *bufptr++ = (unsigned char)(mm - kk);
-              *bufptr++ = (unsigned char)(yy - kk);
-              *bufptr++ = (unsigned char)(kk);
+  error:
 
-	      if (i > 2)
-	      {
-	        // Add alpha channel
-	        if (x < 112 || x >= 144 || y < 112 || y >= 144)
-		  *bufptr++ = (unsigned char)((x - 128) * (y - 128));
-		else
-		  *bufptr++ = 0;
-	      }
-	    }
-	  }
-          break;
-    }
+  pdfioStreamClose(st);
+  return (1);
+}
 
-    // Write the image...
-    printf("pdfioFileCreateImageObjFromData(num_colors=%u, alpha=%s): ", (unsigned)num_colors, i > 2 ? "true" : "false");
-    if ((images[i] = pdfioFileCreateImageObjFromData(pdf, buffer, 256, 256, num_colors, NULL, i > 2, false)) != NULL)
-    {
-      printf("PASS (%u)\n", (unsigned)pdfioObjGetNumber(images[i]));
-    }
-    else
-    {
-      puts("FAIL");
-      return (1);
-    }
-  }
 
-  // Create the page dictionary, object, and stream...
-  fputs("pdfioDictCreate: ", stdout);
-  if ((dict = pdfioDictCreate(pdf)) != NULL)
+//
+// 'write_object_key_file()' - Write and read back a PDF file with encrypted objects.
+//
+// RC4 and AES-128 use a different key for every object.  The objects are read
+// twice to check the cached key and then from multiple threads at once.
+//
+
+static int				// O - Exit status
+write_object_key_file(
+    const char         *filename,	// I - PDF filename
+    pdfio_encryption_t encryption)	// I - Encryption to use
+{
+  int		ret = 1;		// Exit status
+  pdfio_file_t	*pdf;			// PDF file
+  pdfio_dict_t	*dict;			// Object dictionary
+  pdfio_obj_t	*obj;			// Object
+  pdfio_stream_t *st;			// Object stream
+  size_t	i,			// Looping var
+		numbers[8];		// Object numbers
+  object_key_data_t data[4];		// Callback data
+#ifdef _WIN32
+  HANDLE	threads[4];		// Threads
+#else
+  pthread_t	threads[4];		// Threads
+#endif // _WIN32
+  bool		error = false;		// Error callback data
+
+
+  printf("pdfioFileCreate(\"%s\", ...): ", filename);
+  if ((pdf = pdfioFileCreate(filename, NULL, NULL, NULL, (pdfio_error_cb_t)error_cb, &error)) != NULL)
     puts("PASS");
   else
     return (1);
 
-  for (i = 0; i < 6; i ++)
+  printf("pdfioFileSetPermissions(all, %s, no passwords): ", encryption == PDFIO_ENCRYPTION_RC4_128 ? "RC4-128" : "AES-128");
+  if (pdfioFileSetPermissions(pdf, PDFIO_PERMISSION_ALL, encryption, NULL, NULL))
+    puts("PASS");
+  else
+    goto done;
+
+  fputs("pdfioObjCreateStream(encrypted): ", stdout);
+  for (i = 0; i < (sizeof(numbers) / sizeof(numbers[0])); i ++)
   {
-    printf("pdfioPageDictAddImage(%d): ", i + 1);
-    snprintf(iname, sizeof(iname), "IM%d", i + 1);
-    if (pdfioPageDictAddImage(dict, pdfioStringCreate(pdf, iname), images[i]))
-      puts("PASS");
-    else
-      return (1);
+    if ((dict = pdfioDictCreate(pdf)) == NULL || (obj = pdfioFileCreateObj(pdf, dict)) == NULL)
+      break;
+
+    numbers[i] = pdfioObjGetNumber(obj);
+
+    if (!pdfioDictSetName(dict, "Filter", "FlateDecode") || !pdfioDictSetStringf(dict, "Title", "Encrypted object %u", (unsigned)numbers[i]))
+      break;
+
+    if ((st = pdfioObjCreateStream(obj, PDFIO_FILTER_FLATE)) == NULL)
+      break;
+
+    if (!pdfioStreamPrintf(st, "Object %u: Now is the time for all good men to come to the aid of their country.\n", (unsigned)numbers[i]) || !pdfioStreamClose(st))
+      break;
   }
 
-  fputs("pdfioPageDictAddFont(F1): ", stdout);
-  if (pdfioPageDictAddFont(dict, "F1", font))
+  if (i < (sizeof(numbers) / sizeof(numbers[0])))
+  {
+    printf("FAIL (object %u)\n", (unsigned)(i + 1));
+    goto done;
+  }
+
+  puts("PASS");
+
+  fputs("pdfioFileClose: ", stdout);
+  if (pdfioFileClose(pdf))
     puts("PASS");
   else
     return (1);
 
-  printf("pdfioFileCreatePage(%d): ", number);
-
-  if ((st = pdfioFileCreatePage(pdf, dict)) != NULL)
+  // Read the objects twice from a single thread...
+  printf("pdfioFileOpen(\"%s\", ...): ", filename);
+  if ((pdf = pdfioFileOpen(filename, NULL, NULL, (pdfio_error_cb_t)error_cb, &error)) != NULL)
     puts("PASS");
   else
     return (1);
 
-  if (write_header_footer(st, "Image Writing Test", number))
-    goto error;
+  fputs("object_key_cb(first read): ", stdout);
+  data[0].pdf         = pdf;
+  data[0].numbers     = numbers;
+  data[0].num_numbers = sizeof(numbers) / sizeof(numbers[0]);
+  data[0].first       = 0;
+  data[0].passes      = 1;
 
-  // Draw images
-  for (i = 0; i < 6; i ++)
+  object_key_cb(data);
+
+  if (data[0].passed)
   {
-    static const char *labels[] = {
-      "DeviceGray",
-      "DeviceRGB",
-      "DeviceCMYK",
-      "DevGray + Alpha",
-      "DevRGB + Alpha",
-      "DevCMYK + Alpha"
-    };
+    puts("PASS");
+  }
+  else
+  {
+    puts("FAIL");
+    goto done;
+  }
 
-    snprintf(iname, sizeof(iname), "IM%d", i + 1);
+  fputs("obj->have_key: ", stdout);
+  for (i = 0; i < (sizeof(numbers) / sizeof(numbers[0])); i ++)
+  {
+    if ((obj = pdfioFileFindObj(pdf, numbers[i])) == NULL || !obj->have_key)
+      break;
+  }
 
-    if (draw_image(st, iname, 36 + 180 * (i % 3), 306 - 216 * (i / 3), 144, 144, labels[i]))
-      goto error;
+  if (i < (sizeof(numbers) / sizeof(numbers[0])))
+  {
+    printf("FAIL (object %u)\n", (unsigned)numbers[i]);
+    goto done;
   }
 
-  // Wrap up...
-  fputs("pdfioStreamClose: ", stdout);
-  if (pdfioStreamClose(st))
+  puts("PASS");
+
+  fputs("object_key_cb(second read): ", stdout);
+  object_key_cb(data);
+
+  if (data[0].passed)
+  {
+    puts("PASS");
+  }
+  else
+  {
+    puts("FAIL");
+    goto done;
+  }
+
+  pdfioFileClose(pdf);
+
+  // Then re-open the file and read the objects from multiple threads, each
+  // starting with a different object...
+  printf("pdfioFileOpen(\"%s\", ...): ", filename);
+  if ((pdf = pdfioFileOpen(filename, NULL, NULL, (pdfio_error_cb_t)error_cb, &error)) != NULL)
     puts("PASS");
   else
     return (1);
 
-  return (0);
+  fputs("pdfioFileSetConcurrent(true): ", stdout);
+  if (pdfioFileSetConcurrent(pdf, true))
+    puts("PASS");
+  else
+    goto done;
 
-  error:
+  fputs("object_key_cb(threads): ", stdout);
+  for (i = 0; i < (sizeof(data) / sizeof(data[0])); i ++)
+  {
+    data[i].pdf         = pdf;
+    data[i].numbers     = numbers;
+    data[i].num_numbers = sizeof(numbers) / sizeof(numbers[0]);
+    data[i].first       = i;
+    data[i].passes      = 10;
+    data[i].passed      = false;
+
+#ifdef _WIN32
+    threads[i] = CreateThread(NULL, 0, (LPTHREAD_START_ROUTINE)object_key_cb, data + i, 0, NULL);
+#else
+    pthread_create(threads + i, NULL, (void *(*)(void *))object_key_cb, data + i);
+#endif // _WIN32
+  }
 
-  pdfioStreamClose(st);
-  return (1);
+  for (i = 0; i < (sizeof(data) / sizeof(data[0])); i ++)
+  {
+#ifdef _WIN32
+    WaitForSingleObject(threads[i], INFINITE);
+    CloseHandle(threads[i]);
+#else
+    pthread_join(threads[i], NULL);
+#endif // _WIN32
+  }
+
+  for (i = 0; i < (sizeof(data) / sizeof(data[0])); i ++)
+  {
+    if (!data[i].passed)
+      break;
+  }
+
+  if (i < (sizeof(data) / sizeof(data[0])))
+  {
+    printf("FAIL (thread %u)\n", (unsigned)(i + 1));
+    goto done;
+  }
+
+  printf("PASS (%u threads)\n", (unsigned)i);
+
+  ret = 0;
+
+  done:
+
+  pdfioFileClose(pdf);
+
+  return (ret);
 }
 
 
 //
-// 'write_color_patch()' - Write a color patch...
+// 'write_objstms_file()' - Write a PDF file with many compressed object streams.
 //
 
 static int				// O - 1 on failure, 0 on success
-write_color_patch(pdfio_stream_t *st,	// I - Content stream
-                  bool           device)// I - Use device color?
+write_objstms_file(
+    const char *filename,		// I - PDF filename
+    size_t     num_pages)		// I - Number of pages to write
 {
-  int		col,			// Current column
-		row;			// Current row
-  double	x, y,			// Relative position
-		r,			// Radius
-		hue,			// Hue angle
-		sat,			// Saturation
-		cc,			// Computed color
-		red,			// Red value
-		green,			// Green value
-		blue;			// Blue value
-
-
-  // Draw an 11x11 patch...
-  for (col = 0; col < 21; col ++)
-  {
-    for (row = 0; row < 21; row ++)
-    {
-      // Compute color in patch...
-      x = 0.1 * (col - 10);
-      y = 0.1 * (row - 10);
-      r = sqrt(x * x + y * y);
+  pdfio_file_t	*pdf;			// PDF file
+  pdfio_obj_t	*font;			// Font object
+  pdfio_dict_t	*dict;			// Page dictionary
+  pdfio_stream_t *st;			// Page contents stream
+  size_t	i;			// Looping var
+  char		text[256];		// Page text
+  bool		error = false;		// Error callback data
 
-      if (r == 0.0)
-      {
-        red = green = blue = 1.0;
-      }
-      else
-      {
-	sat = pow(r, 1.5);
 
-        x   /= r;
-        y   /= r;
-	hue = 3.0 * atan2(y, x) / M_PI;
-	if (hue < 0.0)
-	  hue += 6.0;
+  printf("pdfioFileCreate(\"%s\", ...): ", filename);
+  if ((pdf = pdfioFileCreate(filename, NULL, NULL, NULL, (pdfio_error_cb_t)error_cb, &error)) != NULL)
+    puts("PASS");
+  else
+    return (1);
 
-	cc = sat * (1.0 - fabs(fmod(hue, 2.0) - 1.0)) + 1.0 - sat;
+  if (!pdfioFileSetOptions(pdf, PDFIO_OPTION_OBJSTREAMS) || (font = pdfioFileCreateFontObjFromBase(pdf, "Courier")) == NULL)
+    goto fail;
 
-	if (hue < 1.0)
-	{
-	  red   = 1.0;
-	  green = cc;
-	  blue  = 1.0 - sat;
-	}
-	else if (hue < 2.0)
-	{
-	  red   = cc;
-	  green = 1.0;
-	  blue  = 1.0 - sat;
-	}
-	else if (hue < 3.0)
-	{
-	  red   = 1.0 - sat;
-	  green = 1.0;
-	  blue  = cc;
-	}
-	else if (hue < 4.0)
-	{
-	  red   = 1.0 - sat;
-	  green = cc;
-	  blue  = 1.0;
-	}
-	else if (hue < 5.0)
-	{
-	  red   = cc;
-	  green = 1.0 - sat;
-	  blue  = 1.0;
-	}
-	else
-	{
-	  red   = 1.0;
-	  green = 1.0 - sat;
-	  blue  = cc;
-	}
-      }
+  printf("pdfioFileCreatePage(%lu pages): ", (unsigned long)num_pages);
+  for (i = 0; i < num_pages; i ++)
+  {
+    if ((dict = pdfioDictCreate(pdf)) == NULL || !pdfioPageDictAddFont(dict, "F1", font) || (st = pdfioFileCreatePage(pdf, dict)) == NULL)
+      break;
 
-      // Draw it...
-      if (device)
-      {
-        // Use device CMYK color instead of a calibrated RGB space...
-        double cyan = 1.0 - red;	// Cyan color
-        double magenta = 1.0 - green;	// Magenta color
-        double yellow = 1.0 - blue;	// Yellow color
-        double black = cyan;		// Black color
+    snprintf(text, sizeof(text), "Page %lu of %lu", (unsigned long)(i + 1), (unsigned long)num_pages);
 
-        if (black > magenta)
-          black = magenta;
-        if (black > yellow)
-          black = yellow;
+    if (!pdfioContentTextBegin(st) || !pdfioContentSetTextFont(st, "F1", 12.0) || !pdfioContentTextMoveTo(st, 36.0, 36.0) || !pdfioContentTextShow(st, false, text) || !pdfioContentTextEnd(st))
+    {
+      pdfioStreamClose(st);
+      break;
+    }
 
-        cyan    -= black;
-        magenta -= black;
-        yellow  -= black;
+    if (!pdfioStreamClose(st))
+      break;
+  }
 
-	printf("pdfioContentSetFillColorDeviceCMYK(c=%g, m=%g, y=%g, k=%g): ", cyan, magenta, yellow, black);
-	if (pdfioContentSetFillColorDeviceCMYK(st, cyan, magenta, yellow, black))
-	  puts("PASS");
-	else
-	  return (1);
-      }
-      else
-      {
-        // Use calibrate RGB space...
-	printf("pdfioContentSetFillColorRGB(r=%g, g=%g, b=%g): ", red, green, blue);
-	if (pdfioContentSetFillColorRGB(st, red, green, blue))
-	  puts("PASS");
-	else
-	  return (1);
-      }
+  if (i < num_pages)
+  {
+    printf("FAIL (page %lu)\n", (unsigned long)(i + 1));
+    goto fail;
+  }
 
-      printf("pdfioContentPathRect(x=%g, y=%g, w=%g, h=%g): ", col * 6.0, row * 6.0, 6.0, 6.0);
-      if (pdfioContentPathRect(st, col * 6.0, row * 6.0, 6.0, 6.0))
-	puts("PASS");
-      else
-	return (1);
+  puts("PASS");
 
-      fputs("pdfioContentFill(even_odd=false): ", stdout);
-      if (pdfioContentFill(st, false))
-	puts("PASS");
-      else
-	return (1);
-    }
+  fputs("pdfioFileClose: ", stdout);
+  if (pdfioFileClose(pdf))
+  {
+    puts("PASS");
+    return (0);
   }
+  else
+    return (1);
 
-  return (0);
+  fail:
+
+  pdfioFileClose(pdf);
+
+  return (1);
 }
 
 
 //
-// 'write_color_test()' - Write a color test page...
+// 'write_page_tree_file()' - Write a PDF file with a balanced page tree.
 //
 
 static int				// O - 1 on failure, 0 on success
-write_color_test(pdfio_file_t *pdf,	// I - PDF file
-                 int          number,	// I - Page number
-                 pdfio_obj_t  *font)	// I - Text font
+write_page_tree_file(
+    const char     *filename,		// I - PDF filename
+    size_t         fanout,		// I - Page tree fan-out
+    pdfio_option_t options)		// I - Output options
 {
-  pdfio_dict_t		*dict;		// Page dictionary
-  pdfio_stream_t	*st;		// Page contents stream
-  pdfio_array_t		*cs;		// Color space array
-  pdfio_obj_t		*prophoto;	// ProPhotoRGB ICC profile object
+  pdfio_file_t	*pdf,			// PDF file
+		*srcpdf;		// Source PDF file
+  pdfio_obj_t	*font;			// Font object
+  pdfio_dict_t	*dict;			// Page dictionary
+  pdfio_stream_t *st;			// Page contents stream
+  size_t	i,			// Looping var
+		num_pages,		// Number of pages
+		leaf_depth = 0,		// Depth of nodes with pages
+		count = 0;		// Number of pages in page tree
+  char		text[256];		// Page text
+  bool		error = false;		// Error callback data
 
 
-  fputs("pdfioFileCreateICCObjFromFile(ProPhotoRGB): ", stdout);
-  if ((prophoto = pdfioFileCreateICCObjFromFile(pdf, "testfiles/iso22028-2-romm-rgb.icc", 3)) != NULL)
+  printf("pdfioFileCreate(\"%s\", ...): ", filename);
+  if ((pdf = pdfioFileCreate(filename, NULL, NULL, NULL, (pdfio_error_cb_t)error_cb, &error)) != NULL)
     puts("PASS");
   else
     return (1);
 
-  fputs("pdfioDictCreate: ", stdout);
-  if ((dict = pdfioDictCreate(pdf)) != NULL)
-    puts("PASS");
-  else
-    return (1);
+  if (!pdfioFileSetOptions(pdf, options))
+    goto fail;
 
-  fputs("pdfioArrayCreateColorFromStandard(AdobeRGB): ", stdout);
-  if ((cs = pdfioArrayCreateColorFromStandard(pdf, 3, PDFIO_CS_ADOBE)) != NULL)
+  fputs("pdfioFileSetPageFanout(1): ", stdout);
+  if (!pdfioFileSetPageFanout(pdf, 1))
     puts("PASS");
   else
-    return (1);
+    goto fail;
 
-  fputs("pdfioPageDictAddColorSpace(AdobeRGB): ", stdout);
-  if (pdfioPageDictAddColorSpace(dict, "AdobeRGB", cs))
+  printf("pdfioFileSetPageFanout(%u): ", (unsigned)fanout);
+  if (pdfioFileSetPageFanout(pdf, fanout))
     puts("PASS");
   else
-    return (1);
+    goto fail;
 
-  fputs("pdfioArrayCreateColorFromStandard(DisplayP3): ", stdout);
-  if ((cs = pdfioArrayCreateColorFromStandard(pdf, 3, PDFIO_CS_P3_D65)) != NULL)
-    puts("PASS");
-  else
-    return (1);
+  // Copy the pages from another file, then add some new pages...
+  fputs("pdfioPageCopy(testpdfio-out.pdf): ", stdout);
+  if ((srcpdf = pdfioFileOpen("testpdfio-out.pdf", /*password_cb*/NULL, /*password_data*/NULL, (pdfio_error_cb_t)error_cb, &error)) == NULL)
+    goto fail;
 
-  fputs("pdfioPageDictAddColorSpace(DisplayP3): ", stdout);
-  if (pdfioPageDictAddColorSpace(dict, "DisplayP3", cs))
-    puts("PASS");
-  else
-    return (1);
+  for (i = 0, num_pages = pdfioFileGetNumPages(srcpdf); i < num_pages; i ++)
+  {
+    if (!pdfioPageCopy(pdf, pdfioFileGetPage(srcpdf, i)))
+      break;
+  }
 
-  fputs("pdfioArrayCreateColorFromICCObj(ProPhotoRGB): ", stdout);
-  if ((cs = pdfioArrayCreateColorFromICCObj(pdf, prophoto)) != NULL)
-    puts("PASS");
-  else
-    return (1);
+  pdfioFileClose(srcpdf);
 
-  fputs("pdfioPageDictAddColorSpace(ProPhotoRGB): ", stdout);
-  if (pdfioPageDictAddColorSpace(dict, "ProPhotoRGB", cs))
-    puts("PASS");
-  else
-    return (1);
+  if (i < num_pages)
+  {
+    printf("FAIL (page %lu)\n", (unsigned long)(i + 1));
+    goto fail;
+  }
 
-  fputs("pdfioArrayCreateColorFromStandard(sRGB): ", stdout);
-  if ((cs = pdfioArrayCreateColorFromStandard(pdf, 3, PDFIO_CS_SRGB)) != NULL)
-    puts("PASS");
-  else
-    return (1);
+  puts("PASS");
 
-  fputs("pdfioPageDictAddColorSpace(sRGB): ", stdout);
-  if (pdfioPageDictAddColorSpace(dict, "sRGB", cs))
-    puts("PASS");
-  else
-    return (1);
+  if ((font = pdfioFileCreateFontObjFromBase(pdf, "Courier")) == NULL)
+    goto fail;
 
-  fputs("pdfioPageDictAddFont(F1): ", stdout);
-  if (pdfioPageDictAddFont(dict, "F1", font))
-    puts("PASS");
-  else
-    return (1);
+  fputs("pdfioFileCreatePage(40 pages): ", stdout);
+  for (i = 0; i < 40; i ++)
+  {
+    if ((dict = pdfioDictCreate(pdf)) == NULL || !pdfioPageDictAddFont(dict, "F1", font) || (st = pdfioFileCreatePage(pdf, dict)) == NULL)
+      break;
 
-  printf("pdfioFileCreatePage(%d): ", number);
+    snprintf(text, sizeof(text), "Page %lu of 40", (unsigned long)(i + 1));
 
-  if ((st = pdfioFileCreatePage(pdf, dict)) != NULL)
-    puts("PASS");
-  else
-    return (1);
+    if (!pdfioContentTextBegin(st) || !pdfioContentSetTextFont(st, "F1", 12.0) || !pdfioContentTextMoveTo(st, 36.0, 36.0) || !pdfioContentTextShow(st, false, text) || !pdfioContentTextEnd(st))
+    {
+      pdfioStreamClose(st);
+      break;
+    }
 
-  if (write_header_footer(st, "Color Space Test", number))
-    goto error;
+    if (!pdfioStreamClose(st))
+      break;
+  }
 
-  fputs("pdfioContentTextBegin(): ", stdout);
-  if (pdfioContentTextBegin(st))
-    puts("PASS");
-  else
-    goto error;
+  if (i < 40)
+  {
+    printf("FAIL (page %lu)\n", (unsigned long)(i + 1));
+    goto fail;
+  }
 
-  fputs("pdfioContentSetTextFont(\"F1\", 18.0): ", stdout);
-  if (pdfioContentSetTextFont(st, "F1", 18.0))
-    puts("PASS");
-  else
-    goto error;
+  puts("PASS");
 
-  fputs("pdfioContentTextMoveTo(82, 234): ", stdout);
-  if (pdfioContentTextMoveTo(st, 82, 234))
-    puts("PASS");
-  else
-    goto error;
+  num_pages += 40;
 
-  fputs("pdfioContentTextShow(\"AdobeRGB\"): ", stdout);
-  if (pdfioContentTextShow(st, false, "AdobeRGB"))
+  fputs("pdfioFileSetPageFanout(after pages): ", stdout);
+  if (!pdfioFileSetPageFanout(pdf, fanout))
     puts("PASS");
   else
-    goto error;
+    goto fail;
 
-  fputs("pdfioContentTextMoveTo(234, 0): ", stdout);
-  if (pdfioContentTextMoveTo(st, 234, 0))
+  printf("pdfioFileClose(\"%s\"): ", filename);
+  if (pdfioFileClose(pdf))
     puts("PASS");
   else
-    goto error;
+    return (1);
 
-  fputs("pdfioContentTextShow(\"DisplayP3\"): ", stdout);
-  if (pdfioContentTextShow(st, false, "DisplayP3"))
+  // Read the file back and check the page tree...
+  printf("pdfioFileOpen(\"%s\", ...): ", filename);
+  if ((pdf = pdfioFileOpen(filename, NULL, NULL, (pdfio_error_cb_t)error_cb, &error)) != NULL)
     puts("PASS");
   else
-    goto error;
+    return (1);
 
-  fputs("pdfioContentTextMoveTo(-234, 216): ", stdout);
-  if (pdfioContentTextMoveTo(st, -234, 216))
+  fputs("pdfioFileGetNumPages: ", stdout);
+  if ((i = pdfioFileGetNumPages(pdf)) == num_pages)
+  {
     puts("PASS");
+  }
   else
-    goto error;
+  {
+    printf("FAIL (got %lu, expected %lu)\n", (unsigned long)i, (unsigned long)num_pages);
+    goto fail;
+  }
 
-  fputs("pdfioContentTextShow(\"sRGB\"): ", stdout);
-  if (pdfioContentTextShow(st, false, "sRGB"))
-    puts("PASS");
-  else
-    goto error;
+  fputs("verify_page_tree: ", stdout);
+  if (!verify_page_tree(pdf, pdfioDictGetObj(pdfioFileGetCatalog(pdf), "Pages"), fanout, 1, &leaf_depth, &count))
+    goto fail;
+  else if (count != num_pages || leaf_depth < 3)
+  {
+    printf("FAIL (%lu pages at depth %lu)\n", (unsigned long)count, (unsigned long)leaf_depth);
+    goto fail;
+  }
 
-  fputs("pdfioContentTextMoveTo(234, 0): ", stdout);
-  if (pdfioContentTextMoveTo(st, 234, 0))
-    puts("PASS");
-  else
-    goto error;
+  printf("PASS (%lu pages at depth %lu)\n", (unsigned long)count, (unsigned long)leaf_depth);
 
-  fputs("pdfioContentTextShow(\"ProPhotoRGB\"): ", stdout);
-  if (pdfioContentTextShow(st, false, "ProPhotoRGB"))
-    puts("PASS");
-  else
-    goto error;
+  pdfioFileClose(pdf);
 
-  fputs("pdfioContentTextMoveTo(-234, 216): ", stdout);
-  if (pdfioContentTextMoveTo(st, -234, 216))
-    puts("PASS");
-  else
-    goto error;
+  return (0);
 
-  fputs("pdfioContentTextShow(\"DeviceCMYK\"): ", stdout);
-  if (pdfioContentTextShow(st, false, "DeviceCMYK"))
-    puts("PASS");
-  else
-    goto error;
+  fail:
 
-  fputs("pdfioContentTextEnd(): ", stdout);
-  if (pdfioContentTextEnd(st))
-    puts("PASS");
-  else
-    goto error;
+  pdfioFileClose(pdf);
 
-  fputs("pdfioContentSave(): ", stdout);
-  if (pdfioContentSave(st))
-    puts("PASS");
-  else
-    goto error;
+  return (1);
+}
 
-  fputs("pdfioContentSetFillColorSpace(AdobeRGB): ", stdout);
-  if (pdfioContentSetFillColorSpace(st, "AdobeRGB"))
-    puts("PASS");
-  else
-    goto error;
 
-  fputs("pdfioContentMatrixTranslate(82, 90): ", stdout);
-  if (pdfioContentMatrixTranslate(st, 82, 90))
-    puts("PASS");
-  else
-    goto error;
+//
+// 'write_paragraph_file()' - Write and check paragraphs of text.
+//
+// Courier characters are all 600/1000ths wide, so a 60 point wide paragraph
+// using a 10 point font holds 10 characters per line.
+//
 
-  if (write_color_patch(st, false))
-    goto error;
+static int				// O - Exit status
+write_paragraph_file(
+    const char *filename)		// I - PDF filename
+{
+  int		ret = 1;		// Exit status
+  pdfio_file_t	*pdf;			// PDF file
+  pdfio_obj_t	*courier,		// Courier font object
+		*opensans;		// OpenSans font object
+  pdfio_dict_t	*dict;			// Page dictionary
+  pdfio_stream_t *st;			// Page contents stream
+  size_t	num_lines,		// Number of lines
+		total;			// Total bytes read
+  ssize_t	bytes;			// Bytes read
+  char		buffer[8192];		// Page contents
+  bool		error = false;		// Error callback data
+  static const char *justified =	// Expected justified text
+		"[(The )-600(quick)]TJ\nT*\n[(brown )-600(fox)]TJ\nT*\n(jumps over)Tj\nT*\n[(the )-1200(lazy)]TJ\nT*\n(dog.)Tj\nT*\n(New)Tj\nT*\n(paragraph)Tj\n";
 
-  fputs("pdfioContentRestore(): ", stdout);
-  if (pdfioContentRestore(st))
-    puts("PASS");
-  else
-    goto error;
 
-  fputs("pdfioContentSave(): ", stdout);
-  if (pdfioContentSave(st))
+  printf("pdfioFileCreate(\"%s\", ...): ", filename);
+  if ((pdf = pdfioFileCreate(filename, NULL, NULL, NULL, (pdfio_error_cb_t)error_cb, &error)) != NULL)
     puts("PASS");
   else
-    goto error;
+    return (1);
 
-  fputs("pdfioContentSetFillColorSpace(DisplayP3): ", stdout);
-  if (pdfioContentSetFillColorSpace(st, "DisplayP3"))
+  fputs("pdfioFileCreateFontObjFromBase(\"Courier\"): ", stdout);
+  if ((courier = pdfioFileCreateFontObjFromBase(pdf, "Courier")) != NULL)
     puts("PASS");
   else
-    goto error;
+    goto close_pdf;
 
-  fputs("pdfioContentMatrixTranslate(316, 90): ", stdout);
-  if (pdfioContentMatrixTranslate(st, 316, 90))
+  fputs("pdfioFileCreateFontObjFromFile(OpenSans-Regular.ttf): ", stdout);
+  if ((opensans = pdfioFileCreateFontObjFromFile(pdf, "testfiles/OpenSans-Regular.ttf", true)) != NULL)
     puts("PASS");
   else
-    goto error;
-
-  if (write_color_patch(st, false))
-    goto error;
+    goto close_pdf;
 
-  fputs("pdfioContentRestore(): ", stdout);
-  if (pdfioContentRestore(st))
-    puts("PASS");
-  else
-    goto error;
+  if ((dict = pdfioDictCreate(pdf)) == NULL || !pdfioPageDictAddFont(dict, "F1", courier) || !pdfioPageDictAddFont(dict, "F2", opensans))
+    goto close_pdf;
 
-  fputs("pdfioContentSave(): ", stdout);
-  if (pdfioContentSave(st))
+  fputs("pdfioFileCreatePage: ", stdout);
+  if ((st = pdfioFileCreatePage(pdf, dict)) != NULL)
     puts("PASS");
   else
-    goto error;
+    goto close_pdf;
 
-  fputs("pdfioContentSetFillColorSpace(sRGB): ", stdout);
-  if (pdfioContentSetFillColorSpace(st, "sRGB"))
-    puts("PASS");
-  else
-    goto error;
+  if (!pdfioContentTextBegin(st) || !pdfioContentSetTextFont(st, "F1", 10.0) || !pdfioContentSetTextLeading(st, 12.0) || !pdfioContentTextMoveTo(st, 36.0, 720.0))
+    goto close_st;
 
-  fputs("pdfioContentMatrixTranslate(82, 306): ", stdout);
-  if (pdfioContentMatrixTranslate(st, 82, 306))
-    puts("PASS");
+  fputs("pdfioContentTextShowParagraph(JUSTIFY): ", stdout);
+  if (!pdfioContentTextShowParagraph(st, courier, false, 10.0, 60.0, PDFIO_TEXTALIGN_JUSTIFY, "The quick brown fox jumps over the lazy dog.\nNew paragraph", &num_lines))
+  {
+    puts("FAIL");
+    goto close_st;
+  }
+  else if (num_lines != 7)
+  {
+    printf("FAIL (got %u lines, expected 7)\n", (unsigned)num_lines);
+    goto close_st;
+  }
   else
-    goto error;
-
-  if (write_color_patch(st, false))
-    goto error;
-
-  fputs("pdfioContentRestore(): ", stdout);
-  if (pdfioContentRestore(st))
     puts("PASS");
-  else
-    goto error;
 
-  fputs("pdfioContentSave(): ", stdout);
-  if (pdfioContentSave(st))
+  fputs("pdfioContentTextShowParagraph(CENTER): ", stdout);
+  if (pdfioContentTextNextLine(st) && pdfioContentTextShowParagraph(st, courier, false, 10.0, 60.0, PDFIO_TEXTALIGN_CENTER, "Centered", &num_lines) && num_lines == 1)
     puts("PASS");
   else
-    goto error;
+    goto close_st;
 
-  fputs("pdfioContentSetFillColorSpace(ProPhotoRGB): ", stdout);
-  if (pdfioContentSetFillColorSpace(st, "ProPhotoRGB"))
-    puts("PASS");
-  else
-    goto error;
+  fputs("pdfioContentTextShowParagraph(OpenSans): ", stdout);
+  if (!pdfioContentSetTextFont(st, "F2", 10.0) || !pdfioContentTextMoveTo(st, 0.0, -120.0))
+    goto close_st;
 
-  fputs("pdfioContentMatrixTranslate(316, 306): ", stdout);
-  if (pdfioContentMatrixTranslate(st, 316, 306))
-    puts("PASS");
+  if (!pdfioContentTextShowParagraph(st, opensans, true, 10.0, 200.0, PDFIO_TEXTALIGN_LEFT, "PDFio is a simple C library for reading and writing PDF files. Text in any language, such as \xE3\x81\x93\xE3\x82\x93\xE3\x81\xAB\xE3\x81\xA1\xE3\x81\xAF or \xC3\x9C" "berpr\xC3\xBC" "fung, can be laid out into lines.", &num_lines))
+  {
+    puts("FAIL");
+    goto close_st;
+  }
+  else if (num_lines < 2)
+  {
+    printf("FAIL (got %u lines, expected 2 or more)\n", (unsigned)num_lines);
+    goto close_st;
+  }
   else
-    goto error;
+    printf("PASS (%u lines)\n", (unsigned)num_lines);
 
-  if (write_color_patch(st, false))
-    goto error;
+  if (!pdfioContentTextEnd(st))
+    goto close_st;
 
-  fputs("pdfioContentRestore(): ", stdout);
-  if (pdfioContentRestore(st))
+  fputs("pdfioStreamClose: ", stdout);
+  if (pdfioStreamClose(st))
     puts("PASS");
   else
-    goto error;
+    goto close_pdf;
 
-  fputs("pdfioContentSave(): ", stdout);
-  if (pdfioContentSave(st))
+  fputs("pdfioFileClose: ", stdout);
+  if (pdfioFileClose(pdf))
     puts("PASS");
   else
-    goto error;
+    return (1);
 
-  fputs("pdfioContentMatrixTranslate(82, 522): ", stdout);
-  if (pdfioContentMatrixTranslate(st, 82, 522))
+  // Read the page contents back and check the justified paragraph...
+  printf("pdfioFileOpen(\"%s\", ...): ", filename);
+  if ((pdf = pdfioFileOpen(filename, NULL, NULL, (pdfio_error_cb_t)error_cb, &error)) != NULL)
     puts("PASS");
   else
-    goto error;
-
-  if (write_color_patch(st, true))
-    goto error;
+    return (1);
 
-  fputs("pdfioContentRestore(): ", stdout);
-  if (pdfioContentRestore(st))
+  fputs("pdfioPageOpenStream: ", stdout);
+  if ((st = pdfioPageOpenStream(pdfioFileGetPage(pdf, 0), 0, true)) != NULL)
     puts("PASS");
   else
-    goto error;
+    goto close_pdf;
 
-  fputs("pdfioStreamClose: ", stdout);
-  if (pdfioStreamClose(st))
+  for (total = 0; total < (sizeof(buffer) - 1) && (bytes = pdfioStreamRead(st, buffer + total, sizeof(buffer) - 1 - total)) > 0; total += (size_t)bytes);
+
+  pdfioStreamClose(st);
+
+  buffer[total] = '\0';
+
+  fputs("pdfioStreamRead(justified text): ", stdout);
+
+  if (!strstr(buffer, justified))
+  {
+    printf("FAIL (got \"%s\")\n", buffer);
+    goto close_pdf;
+  }
+
+  puts("PASS");
+
+  fputs("pdfioStreamRead(centered text): ", stdout);
+  if (strstr(buffer, "T*\n[-600(Centered)]TJ\n"))
     puts("PASS");
   else
-    return (1);
+    goto close_pdf;
 
-  return (0);
+  ret = 0;
 
-  error:
+  close_pdf:
+
+  pdfioFileClose(pdf);
+
+  return (ret);
+
+  close_st:
 
   pdfioStreamClose(st);
+  pdfioFileClose(pdf);
+
   return (1);
 }
 
 
 //
-// 'write_font_test()' - Write a font test page.
+// 'write_path_file()' - Write a PDF file using the bulk path functions.
 //
 
 static int				// O - 1 on failure, 0 on success
-write_font_test(
-    pdfio_file_t *pdf,			// I - PDF file
-    int          number,		// I - Page number
-    pdfio_obj_t  *font,			// I - Page number font
-    const char   *textfontfile,		// I - Text font file
-    bool         unicode)		// I - Use Unicode font?
+write_path_file(
+    const char *filename)		// I - PDF filename
 {
-  pdfio_dict_t		*dict;		// Page dictionary
-  pdfio_stream_t	*st;		// Page contents stream
-  pdfio_obj_t		*textfont;	// Text font
-  char			title[256],	// Page title
-			textname[256],	// Name of text font
-			*ptr;		// Pointer into name
-  double		width;		// Text width
-  int			i;		// Looping var
-  static const char * const welcomes[] =// "Welcome" in many languages
+  int		ret = 1;		// Exit status
+  pdfio_file_t	*pdf;			// PDF file
+  pdfio_obj_t	*marker;		// Marker form object
+  pdfio_dict_t	*dict;			// Page dictionary
+  pdfio_stream_t *st;			// Page contents stream
+  size_t	i,			// Looping var
+		total;			// Total bytes read
+  ssize_t	bytes;			// Bytes read
+  char		buffer[8192];		// Page contents
+  bool		error = false;		// Error callback data
+  pdfio_point_t	*chart;			// Line chart points
+  pdfio_rect_t	bbox = { -3.0, -3.0, 3.0, 3.0 };
+					// Marker bounding box
+  static const pdfio_point_t line[3] =	// Polyline points
   {
-    "Welcome",
-    "Welkom",
-    "ḫaṣānu",
-    "Mayad-ayad nga pad-abot",
-    "Mir se vjên",
-    "Mirë se vjen",
-    "Wellkumma",
-    "Bienveniu",
-    "Ghini vinit!",
-    "Bienveníu",
-    "Miro peicak",
-    "Xoş gəlmişsiniz!",
-    "Salamat datang",
-    "Сәләм бирем!",
-    "Menjuah-juah!",
-    "Še das d' kemma bisd",
-    "Mwaiseni",
-    "Maogmáng Pag-abót",
-    "Welkam",
-    "Dobrodošli",
-    "Degemer mat",
-    "Benvingut",
-    "Maayong pag-abot",
-    "Kopisanangan do kinorikatan",
-    "Bienvenida",
-    "Bien binidu",
-    "Bienbenidu",
-    "Hóʔą",
-    "Boolkhent!",
-    "Kopivosian do kinoikatan",
-    "Malipayeng Pag-abot!",
-    "Vítej",
-    "Velkommen",
-    "Salâm",
-    "Welkom",
-    "Emedi",
-    "Welkumin",
-    "Tere tulemast",
-    "Woé zɔ",
-    "Bienveníu",
-    "Vælkomin",
-    "Bula",
-    "Tervetuloa",
-    "Bienvenue",
-    "Wäljkiimen",
-    "Wäilkuumen",
-    "Wäilkuumen",
-    "Wolkom",
-    "Benvignût",
-    "Benvido",
-    "Willkommen",
-    "Ἀσπάζομαι!",
-    "Καλώς Ήρθες",
-    "Tikilluarit",
-    "Byen venu",
-    "Sannu da zuwa",
-    "Aloha",
-    "Wayakurua",
-    "Dayón",
-    "Zoo siab txais tos!",
-    "Üdvözlet",
-    "Selamat datai",
-    "Velkomin",
-    "Nnọọ",
-    "Selamat datang",
-    "Qaimarutin",
-    "Fáilte",
-    "Benvenuto",
-    "Voschata",
-    "Murakaza neza",
-    "Mauri",
-    "Tu be xér hatî ye!",
-    "Taŋyáŋ yahí",
-    "Salve",
-    "Laipni lūdzam",
-    "Wilkóm",
-    "Sveiki atvykę",
-    "Willkamen",
-    "Mu amuhezwi",
-    "Tukusanyukidde",
-    "Wëllkomm",
-    "Swagatam",
-    "Tonga soa",
-    "Selamat datang",
-    "Merħba",
-    "B’a’ntulena",
-    "Failt ort",
-    "Haere mai",
-    "mai",
-    "Pjila’si",
-    "Benvegnüu",
-    "Ne y kena",
-    "Ximopanōltih",
-    "Yá'át'ééh",
-    "Siyalemukela",
-    "Siyalemukela",
-    "Bures boahtin",
-    "Re a go amogela",
-    "Velkommen",
-    "Benvengut!",
-    "Bon bini",
-    "Witam Cię",
-    "Bem-vindo",
-    "Haykuykuy!",
-    "T'aves baxtalo",
-    "Bainvegni",
-    "Afio mai",
-    "Ennidos",
-    "Walcome",
-    "Fàilte",
-    "Mauya",
-    "Bon vinutu",
-    "Vitaj",
-    "Dobrodošli",
-    "Soo dhowow",
-    "Witaj",
-    "Bienvenido",
-    "Wilujeng sumping",
-    "Karibu",
-    "Wamukelekile",
-    "Välkommen",
-    "Wilkomme",
-    "Maligayang pagdating",
-    "Maeva",
-    "Räxim itegez",
-    "Ksolok Bodik Mai",
-    "Ulu tons mai",
-    "Welkam",
-    "Talitali fiefia",
-    "Lek oy li la tale",
-    "amogetswe",
-    "Tempokani",
-    "Hoş geldin",
-    "Koş geldiniz",
-    "Ulufale mai!",
-    "Xush kelibsiz",
-    "Benvignùo",
-    "Tervhen tuldes",
-    "Hoan nghênh",
-    "Tere tulõmast",
-    "Benvnuwe",
-    "Croeso",
-    "Merhbe",
-    "Wamkelekile",
-    "Märr-ŋamathirri",
-    "Ẹ ku abọ",
-    "Kíimak 'oolal",
-    "Ngiyakwemukela",
-    "いらっしゃいませ"
+    { 0.0, 0.0 }, { 1.0, 2.0 }, { 2.0, 1.5 }
+  };
+  static const pdfio_point_t triangle[3] =
+  {					// Polygon points
+    { 0.0, 0.0 }, { 10.0, 0.0 }, { 5.0, 8.0 }
+  };
+  static const pdfio_rect_t bars[2] =	// Rectangles
+  {
+    { 0.0, 0.0, 10.0, 20.0 }, { 20.0, 0.0, 30.0, 5.0 }
+  };
+  static const pdfio_point_t markers[2] =
+  {					// Marker points
+    { 100.0, 100.0 }, { 150.5, 120.0 }
+  };
+  static pdfio_matrix_t scale = { { 2.0, 0.0 }, { 0.0, 2.0 }, { 10.0, 20.0 } };
+					// Scale and translate matrix
+  static pdfio_matrix_t rotate = { { 0.0, 1.0 }, { -1.0, 0.0 }, { 0.0, 0.0 } };
+					// Rotate matrix
+  static const char * const expected[] =// Expected page content
+  {
+    "10 20 m\n12 24 l\n14 23 l\n",
+    "0 0 m\n10 0 l\n5 8 l\nh\n",
+    "0 0 10 20 re\n20 0 10 5 re\n",
+    "10 20 20 40 re\n50 20 20 10 re\n",
+    "0 0 m\n0 10 l\n-20 10 l\n-20 0 l\nh\n",
+    "q 1 0 0 1 100 100 cm/M1 Do Q\nq 1 0 0 1 150.5 120 cm/M1 Do Q\n"
   };
 
 
-  printf("pdfioFileCreateFontObjFromFile(%s): ", textfontfile);
-  if ((textfont = pdfioFileCreateFontObjFromFile(pdf, textfontfile, unicode)) != NULL)
+  printf("pdfioFileCreate(\"%s\", ...): ", filename);
+  if ((pdf = pdfioFileCreate(filename, NULL, NULL, NULL, (pdfio_error_cb_t)error_cb, &error)) != NULL)
     puts("PASS");
   else
     return (1);
 
-  fputs("pdfioDictCreate: ", stdout);
-  if ((dict = pdfioDictCreate(pdf)) != NULL)
+  // Create a marker...
+  fputs("pdfioFileCreateFormObj: ", stdout);
+  if ((marker = pdfioFileCreateFormObj(pdf, &bbox, NULL)) != NULL)
     puts("PASS");
   else
-    return (1);
+    goto close_pdf;
 
-  fputs("pdfioPageDictAddFont(F1): ", stdout);
-  if (pdfioPageDictAddFont(dict, "F1", font))
+  if ((st = pdfioObjCreateStream(marker, PDFIO_FILTER_FLATE)) == NULL)
+    goto close_pdf;
+
+  if (!pdfioContentPathRect(st, -2.0, -2.0, 4.0, 4.0) || !pdfioContentFill(st, false))
+    goto close_st;
+
+  if (!pdfioStreamClose(st))
+    goto close_pdf;
+
+  // Create the page...
+  if ((dict = pdfioDictCreate(pdf)) == NULL || !pdfioPageDictAddImage(dict, "M1", marker))
+    goto close_pdf;
+
+  fputs("pdfioFileCreatePage: ", stdout);
+  if ((st = pdfioFileCreatePage(pdf, dict)) != NULL)
     puts("PASS");
   else
-    return (1);
+    goto close_pdf;
 
-  fputs("pdfioPageDictAddFont(F2): ", stdout);
-  if (pdfioPageDictAddFont(dict, "F2", textfont))
+  fputs("pdfioContentPathPolyline: ", stdout);
+  if (pdfioContentPathPolyline(st, 3, line, scale) && pdfioContentStroke(st))
     puts("PASS");
   else
-    return (1);
-
-  printf("pdfioFileCreatePage(%d): ", number);
+    goto close_st;
 
-  if ((st = pdfioFileCreatePage(pdf, dict)) != NULL)
+  fputs("pdfioContentPathPolygon: ", stdout);
+  if (pdfioContentPathPolygon(st, 3, triangle, NULL) && pdfioContentFill(st, false))
     puts("PASS");
   else
-    return (1);
+    goto close_st;
 
-  if ((ptr = strrchr(textfontfile, '/')) != NULL)
-    strncpy(textname, ptr + 1, sizeof(textname) - 1);
+  fputs("pdfioContentPathRects: ", stdout);
+  if (pdfioContentPathRects(st, 2, bars, NULL) && pdfioContentPathRects(st, 2, bars, scale) && pdfioContentPathRects(st, 1, bars, rotate) && pdfioContentFill(st, false))
+    puts("PASS");
   else
-    strncpy(textname, textfontfile, sizeof(textname) - 1);
-
-  textname[sizeof(textname) - 1] = '\0';
-  if ((ptr = strrchr(textname, '.')) != NULL)
-    *ptr = '\0';
+    goto close_st;
 
-  if (unicode)
-    snprintf(title, sizeof(title), "Unicode %s Font Test", textname);
+  fputs("pdfioContentDrawMarkers: ", stdout);
+  if (pdfioContentDrawMarkers(st, "M1", 2, markers, NULL))
+    puts("PASS");
   else
-    snprintf(title, sizeof(title), "CP1252 %s Font Test", textname);
+    goto close_st;
 
-  if (write_header_footer(st, title, number))
-    goto error;
+  // Draw a large line chart...
+  fputs("pdfioContentPathPolyline(100000 points): ", stdout);
+  if ((chart = (pdfio_point_t *)malloc(100000 * sizeof(pdfio_point_t))) == NULL)
+  {
+    puts("FAIL (out of memory)");
+    goto close_st;
+  }
+
+  for (i = 0; i < 100000; i ++)
+  {
+    chart[i].x = 36.0 + 540.0 * i / 99999.0;
+    chart[i].y = 396.0 + 300.0 * sin(i * 0.001);
+  }
 
-  fputs("pdfioContentTextBegin(): ", stdout);
-  if (pdfioContentTextBegin(st))
+  if (pdfioContentPathPolyline(st, 100000, chart, NULL) && pdfioContentStroke(st))
+  {
     puts("PASS");
+    free(chart);
+  }
   else
-    return (1);
+  {
+    free(chart);
+    goto close_st;
+  }
 
-  fputs("pdfioContentSetTextFont(\"F2\", 10.0): ", stdout);
-  if (pdfioContentSetTextFont(st, "F2", 10.0))
+  fputs("pdfioStreamClose: ", stdout);
+  if (pdfioStreamClose(st))
     puts("PASS");
   else
-    return (1);
+    goto close_pdf;
 
-  fputs("pdfioContentSetTextLeading(12.0): ", stdout);
-  if (pdfioContentSetTextLeading(st, 12.0))
+  fputs("pdfioFileClose: ", stdout);
+  if (pdfioFileClose(pdf))
     puts("PASS");
   else
-    goto error;
+    return (1);
 
-  fputs("pdfioContentTextMoveTo(198.0, 702.0): ", stdout);
-  if (pdfioContentTextMoveTo(st, 198.0, 702.0))
+  // Read the page contents back and check them...
+  printf("pdfioFileOpen(\"%s\", ...): ", filename);
+  if ((pdf = pdfioFileOpen(filename, NULL, NULL, (pdfio_error_cb_t)error_cb, &error)) != NULL)
     puts("PASS");
   else
     return (1);
 
-  for (i = 0; i < (int)(sizeof(welcomes) / sizeof(welcomes[0])); i ++)
-  {
-    if (i > 0 && (i % 50) == 0)
-    {
-      fputs("pdfioContentTextMoveTo(162.0, 600.0): ", stdout);
-      if (pdfioContentTextMoveTo(st, 162.0, 600.0))
-	puts("PASS");
-      else
-	return (1);
-    }
+  fputs("pdfioPageOpenStream: ", stdout);
+  if ((st = pdfioPageOpenStream(pdfioFileGetPage(pdf, 0), 0, true)) != NULL)
+    puts("PASS");
+  else
+    goto close_pdf;
 
-    printf("pdfioContentTextMeasure(\"%s\"): ", welcomes[i]);
-    if ((width = pdfioContentTextMeasure(textfont, welcomes[i], 10.0)) >= 0.0)
-      puts("PASS");
-    else
-      return (1);
+  for (total = 0; total < (sizeof(buffer) - 1) && (bytes = pdfioStreamRead(st, buffer + total, sizeof(buffer) - 1 - total)) > 0; total += (size_t)bytes);
 
-    printf("pdfioContextTextMoveTo(%g, 0.0): ", -width);
-    if (pdfioContentTextMoveTo(st, -width, 0.0))
-      puts("PASS");
-    else
-      return (1);
+  pdfioStreamClose(st);
 
-    printf("pdfioContentTextShowf(\"%s\"): ", welcomes[i]);
-    if (pdfioContentTextShowf(st, unicode, "%s\n", welcomes[i]))
-      puts("PASS");
-    else
-      return (1);
+  buffer[total] = '\0';
 
-    printf("pdfioContextTextMoveTo(%g, 0.0): ", width);
-    if (pdfioContentTextMoveTo(st, width, 0.0))
+  for (i = 0; i < (sizeof(expected) / sizeof(expected[0])); i ++)
+  {
+    printf("pdfioStreamRead(path %u): ", (unsigned)i);
+    if (strstr(buffer, expected[i]))
+    {
       puts("PASS");
+    }
     else
-      return (1);
+    {
+      printf("FAIL (expected \"%s\")\n", expected[i]);
+      goto close_pdf;
+    }
   }
 
-  fputs("pdfioContentTextEnd(): ", stdout);
-  if (pdfioContentTextEnd(st))
-    puts("PASS");
-  else
-    return (1);
+  ret = 0;
 
-  fputs("pdfioStreamClose: ", stdout);
-  if (pdfioStreamClose(st))
-    puts("PASS");
-  else
-    return (1);
+  close_pdf:
 
-  return (0);
+  pdfioFileClose(pdf);
 
-  error:
+  return (ret);
+
+  close_st:
 
   pdfioStreamClose(st);
+  pdfioFileClose(pdf);
+
   return (1);
 }
 
 
 //
-// 'write_header_footer()' - Write common header and footer text.
+// 'write_png_test()' - Write a page of PNG test images.
 //
 
-static int				// O - 1 on failure, 0 on success
-write_header_footer(
-    pdfio_stream_t *st,			// I - Page content stream
-    const char     *title,		// I - Title
-    int            number)		// I - Page number
+static int				// O - 0 on success, 1 on failure
+write_png_test(pdfio_file_t *pdf,		// I - PDF file
+          int          number,		// I - Page number
+          pdfio_obj_t  *font)		// I - Page number font
 {
-  fputs("pdfioContentSetFillColorDeviceGray(0.0): ", stdout);
-  if (pdfioContentSetFillColorDeviceGray(st, 0.0))
+  pdfio_dict_t		*dict;		// Page dictionary
+  pdfio_stream_t	*st;		// Page contents stream
+  pdfio_obj_t		*color,		// pdfio-color.png
+			*gray,		// pdfio-gray.png
+			*indexed;	// pdfio-indexed.png
+
+
+  // Import the PNG test images
+  fputs("pdfioFileCreateImageObjFromFile(\"testfiles/pdfio-color.png\"): ", stdout);
+  if ((color = pdfioFileCreateImageObjFromFile(pdf, "testfiles/pdfio-color.png", false)) != NULL)
     puts("PASS");
   else
     return (1);
 
-  fputs("pdfioContentTextBegin(): ", stdout);
-  if (pdfioContentTextBegin(st))
+  fputs("pdfioFileCreateImageObjFromFile(\"testfiles/pdfio-gray.png\"): ", stdout);
+  if ((gray = pdfioFileCreateImageObjFromFile(pdf, "testfiles/pdfio-gray.png", false)) != NULL)
     puts("PASS");
   else
     return (1);
 
-  fputs("pdfioContentSetTextFont(\"F1\", 18.0): ", stdout);
-  if (pdfioContentSetTextFont(st, "F1", 18.0))
+  fputs("pdfioFileCreateImageObjFromFile(\"testfiles/pdfio-indexed.png\"): ", stdout);
+  if ((indexed = pdfioFileCreateImageObjFromFile(pdf, "testfiles/pdfio-indexed.png", false)) != NULL)
     puts("PASS");
   else
     return (1);
 
-  fputs("pdfioContentTextMoveTo(36.0, 738.0): ", stdout);
-  if (pdfioContentTextMoveTo(st, 36.0, 738.0))
+  // Create the page dictionary, object, and stream...
+  fputs("pdfioDictCreate: ", stdout);
+  if ((dict = pdfioDictCreate(pdf)) != NULL)
     puts("PASS");
   else
     return (1);
 
-  printf("pdfioContentTextShow(\"%s\"): ", title);
-  if (pdfioContentTextShow(st, false, title))
+  fputs("pdfioPageDictAddImage(color): ", stdout);
+  if (pdfioPageDictAddImage(dict, "IM1", color))
     puts("PASS");
   else
     return (1);
 
-  fputs("pdfioContentSetTextFont(\"F1\", 12.0): ", stdout);
-  if (pdfioContentSetTextFont(st, "F1", 12.0))
+  fputs("pdfioPageDictAddImage(gray): ", stdout);
+  if (pdfioPageDictAddImage(dict, "IM2", gray))
     puts("PASS");
   else
     return (1);
 
-  fputs("pdfioContentTextMoveTo(514.0, -702.0): ", stdout);
-  if (pdfioContentTextMoveTo(st, 514.0, -702.0))
+  fputs("pdfioPageDictAddImage(indexed): ", stdout);
+  if (pdfioPageDictAddImage(dict, "IM3", indexed))
     puts("PASS");
   else
     return (1);
 
-  printf("pdfioContentTextShowf(\"%d\"): ", number);
-  if (pdfioContentTextShowf(st, false, "%d", number))
+  fputs("pdfioPageDictAddFont(F1): ", stdout);
+  if (pdfioPageDictAddFont(dict, "F1", font))
     puts("PASS");
   else
     return (1);
 
-  fputs("pdfioContentTextEnd(): ", stdout);
-  if (pdfioContentTextEnd(st))
+  printf("pdfioFileCreatePage(%d): ", number);
+
+  if ((st = pdfioFileCreatePage(pdf, dict)) != NULL)
     puts("PASS");
   else
     return (1);
 
-  return (0);
-}
-
-
-//
-// 'write_image_object()' - Write an image object using the specified predictor.
-//
-
-static pdfio_obj_t *			// O - Image object
-write_image_object(
-    pdfio_file_t       *pdf,		// I - PDF file
-    _pdfio_predictor_t predictor)	// I - Predictor to use
-{
-  pdfio_dict_t	*dict,			// Image dictionary
-		*decode;		// Decode dictionary
-  pdfio_obj_t	*obj;			// Image object
-  pdfio_stream_t *st;			// Image stream
-  int		x, y;			// Coordinates in image
-  unsigned char	buffer[768],		// Buffer for image
-		*bufptr;		// Pointer into buffer
-
-
-  // Create the image dictionary...
-  if ((dict = pdfioDictCreate(pdf)) == NULL)
-    return (NULL);
-
-  pdfioDictSetName(dict, "Type", "XObject");
-  pdfioDictSetName(dict, "Subtype", "Image");
-  pdfioDictSetNumber(dict, "Width", 256);
-  pdfioDictSetNumber(dict, "Height", 256);
-  pdfioDictSetNumber(dict, "BitsPerComponent", 8);
-  pdfioDictSetName(dict, "ColorSpace", "DeviceRGB");
-  pdfioDictSetName(dict, "Filter", "FlateDecode");
-
-  // DecodeParms dictionary...
-  if ((decode = pdfioDictCreate(pdf)) == NULL)
-    return (NULL);
-
-  pdfioDictSetNumber(decode, "BitsPerComponent", 8);
-  pdfioDictSetNumber(decode, "Colors", 3);
-  pdfioDictSetNumber(decode, "Columns", 256);
-  pdfioDictSetNumber(decode, "Predictor", predictor);
-  pdfioDictSetDict(dict, "DecodeParms", decode);
-
-  // Create the image object...
-  if ((obj = pdfioFileCreateObj(pdf, dict)) == NULL)
-    return (NULL);
-
-  // Create the image stream and write the image...
-  if ((st = pdfioObjCreateStream(obj, PDFIO_FILTER_FLATE)) == NULL)
-    return (NULL);
-
-  // This creates a useful criss-cross image that highlights predictor errors...
-  for (y = 0; y < 256; y ++)
-  {
-    for (x = 0, bufptr = buffer; x < 256; x ++, bufptr += 3)
-    {
-      bufptr[0] = (unsigned char)y;
-      bufptr[1] = (unsigned char)(y + x);
-      bufptr[2] = (unsigned char)(y - x);
-    }
-
-    if (!pdfioStreamWrite(st, buffer, sizeof(buffer)))
-    {
-      pdfioStreamClose(st);
-      return (NULL);
-    }
-  }
-
-  // Close the object and stream...
-  pdfioStreamClose(st);
-
-  return (obj);
-}
-
+  if (write_header_footer(st, "PNG Image Test Page", number))
+    goto error;
 
-//
-// 'write_images_test()' - Write a series of test images.
-//
+  // Show content...
+  fputs("pdfioContentTextBegin(): ", stdout);
+  if (pdfioContentTextBegin(st))
+    puts("PASS");
+  else
+    goto error;
 
-static int				// O - 1 on failure, 0 on success
-write_images_test(
-    pdfio_file_t *pdf,			// I - PDF file
-    int          number,		// I - Page number
-    pdfio_obj_t  *font)			// I - Text font
-{
-  pdfio_dict_t	*dict;			// Page dictionary
-  pdfio_stream_t *st;			// Page stream
-  _pdfio_predictor_t p;			// Current predictor
-  pdfio_obj_t	*noimage,		// No predictor
-		*pimages[6];		// Images using PNG predictors
-  char		pname[32],		// Image name
-		plabel[32];		// Image label
+  fputs("pdfioContentSetTextFont(\"F1\", 18.0): ", stdout);
+  if (pdfioContentSetTextFont(st, "F1", 18.0))
+    puts("PASS");
+  else
+    goto error;
 
+  fputs("pdfioContentTextMoveTo(36.0, 342.0): ", stdout);
+  if (pdfioContentTextMoveTo(st, 36.0, 342.0))
+    puts("PASS");
+  else
+    goto error;
 
-  // Create the images...
-  fputs("Create Image (Predictor 1): ", stdout);
-  if ((noimage = write_image_object(pdf, _PDFIO_PREDICTOR_NONE)) != NULL)
+  fputs("pdfioContentTextShow(\"PNG RGB Color\"): ", stdout);
+  if (pdfioContentTextShow(st, false, "PNG RGB Color"))
     puts("PASS");
   else
-    return (1);
+    goto error;
 
-  for (p = _PDFIO_PREDICTOR_PNG_NONE; p <= _PDFIO_PREDICTOR_PNG_AUTO; p ++)
-  {
-    printf("Create Image (Predictor %d): ", p);
-    if ((pimages[p - _PDFIO_PREDICTOR_PNG_NONE] = write_image_object(pdf, p)) != NULL)
-      puts("PASS");
-    else
-      return (1);
-  }
+  fputs("pdfioContentTextMoveTo(288.0, 0.0): ", stdout);
+  if (pdfioContentTextMoveTo(st, 288.0, 0.0))
+    puts("PASS");
+  else
+    goto error;
 
-  // Create the page dictionary, object, and stream...
-  fputs("pdfioDictCreate: ", stdout);
-  if ((dict = pdfioDictCreate(pdf)) != NULL)
+  fputs("pdfioContentTextShow(\"PNG Gray\"): ", stdout);
+  if (pdfioContentTextShow(st, false, "PNG Gray"))
     puts("PASS");
   else
-    return (1);
+    goto error;
 
-  fputs("pdfioPageDictAddImage(1): ", stdout);
-  if (pdfioPageDictAddImage(dict, "IM1", noimage))
+  fputs("pdfioContentTextMoveTo(-288.0, 288.0): ", stdout);
+  if (pdfioContentTextMoveTo(st, -288.0, 288.0))
     puts("PASS");
   else
-    return (1);
+    goto error;
 
-  for (p = _PDFIO_PREDICTOR_PNG_NONE; p <= _PDFIO_PREDICTOR_PNG_AUTO; p ++)
-  {
-    printf("pdfioPageDictAddImage(%d): ", p);
-    snprintf(pname, sizeof(pname), "IM%d", p);
-    if (pdfioPageDictAddImage(dict, pdfioStringCreate(pdf, pname), pimages[p - _PDFIO_PREDICTOR_PNG_NONE]))
-      puts("PASS");
-    else
-      return (1);
-  }
+  fputs("pdfioContentTextShow(\"PNG Indexed\"): ", stdout);
+  if (pdfioContentTextShow(st, false, "PNG Indexed"))
+    puts("PASS");
+  else
+    goto error;
 
-  fputs("pdfioPageDictAddFont(F1): ", stdout);
-  if (pdfioPageDictAddFont(dict, "F1", font))
+  fputs("pdfioContentTextEnd(): ", stdout);
+  if (pdfioContentTextEnd(st))
     puts("PASS");
   else
-    return (1);
+    goto error;
 
-  printf("pdfioFileCreatePage(%d): ", number);
+  fputs("pdfioContentDrawImage(\"IM1\"): ", stdout);
+  if (pdfioContentDrawImage(st, "IM1", 36, 108, 216, 216))
+    puts("PASS");
+  else
+    goto error;
 
-  if ((st = pdfioFileCreatePage(pdf, dict)) != NULL)
+  fputs("pdfioContentDrawImage(\"IM2\"): ", stdout);
+  if (pdfioContentDrawImage(st, "IM2", 324, 108, 216, 216))
     puts("PASS");
   else
-    return (1);
+    goto error;
 
-  if (write_header_footer(st, "Image Predictor Test", number))
+  fputs("pdfioContentDrawImage(\"IM3\"): ", stdout);
+  if (pdfioContentDrawImage(st, "IM3", 36, 396, 216, 216))
+    puts("PASS");
+  else
     goto error;
 
-  // Draw images
-  if (draw_image(st, "IM1", 36, 522, 144, 144, "No Predictor"))
+  fputs("pdfioContentSetFillColorDeviceRGB(0, 1, 1): ", stdout);
+  if (pdfioContentSetFillColorDeviceRGB(st, 0.0, 1.0, 1.0))
+    puts("PASS");
+  else
     goto error;
 
-  for (p = _PDFIO_PREDICTOR_PNG_NONE; p <= _PDFIO_PREDICTOR_PNG_AUTO; p ++)
-  {
-    int i = (int)p - _PDFIO_PREDICTOR_PNG_NONE;
+  fputs("pdfioContentPathRect(315, 387, 234, 234): ", stdout);
+  if (pdfioContentPathRect(st, 315, 387, 234, 234))
+    puts("PASS");
+  else
+    goto error;
 
-    snprintf(pname, sizeof(pname), "IM%d", p);
-    snprintf(plabel, sizeof(plabel), "PNG Predictor %d", p);
+  fputs("pdfioContentFill(false): ", stdout);
+  if (pdfioContentFill(st, false))
+    puts("PASS");
+  else
+    goto error;
 
-    if (draw_image(st, pname, 36 + 180 * (i % 3), 306 - 216 * (i / 3), 144, 144, plabel))
-      goto error;
-  }
+  fputs("pdfioContentDrawImage(\"IM3\"): ", stdout);
+  if (pdfioContentDrawImage(st, "IM3", 324, 396, 216, 216))
+    puts("PASS");
+  else
+    goto error;
 
-  // Wrap up...
+  // Close the object and stream...
   fputs("pdfioStreamClose: ", stdout);
   if (pdfioStreamClose(st))
     puts("PASS");
@@ -2883,296 +7272,491 @@ write_images_test(
 
 
 //
-// 'write_jpeg_test()' - Write a page with a JPEG image to a PDF file.
+// 'write_predictor_file()' - Write and read back streams using PNG predictors.
+//
+// Each PNG predictor is used with 1, 2, 3, 4, 6, and 8 bytes per pixel and
+// with rows that are not a multiple of 8 bytes.  The raw Flate data is also
+// checked to make sure the expected filter was used for each line, that the
+// filtered bytes match the PNG specification, and that the "auto" predictor
+// picks each of the five PNG filters.
 //
 
 static int				// O - 1 on failure, 0 on success
-write_jpeg_test(pdfio_file_t *pdf,	// I - PDF file
-                const char   *title,	// I - Page title
-		int          number,	// I - Page number
-		pdfio_obj_t  *font,	// I - Text font
-		pdfio_obj_t  *image)	// I - Image to draw
+write_predictor_file(
+    const char *filename)		// I - PDF filename
 {
-  pdfio_dict_t		*dict;		// Page dictionary
-  pdfio_stream_t	*st;		// Page contents stream
-  double		width,		// Width of image
-			height;		// Height of image
-  double		swidth,		// Scaled width
-			sheight,	// Scaled height
-			tx,		// X offset
-			ty;		// Y offset
+  int		ret = 1;		// Exit status
+  pdfio_file_t	*pdf;			// PDF file
+  pdfio_dict_t	*dict,			// Object dictionary
+		*decode;		// DecodeParms dictionary
+  pdfio_obj_t	*obj;			// Stream object
+  pdfio_stream_t *st;			// Stream
+  int		predictor;		// Current predictor
+  size_t	f, i, w,		// Looping vars
+		y,			// Current line
+		bpp,			// Bytes per pixel
+		len,			// Bytes per line
+		num_objs = 0,		// Number of objects
+		filters = 0;		// PNG filters used by the "auto" predictor
+  ssize_t	bytes;			// Bytes read
+  size_t	total;			// Total bytes read
+  uLongf	rawlen;			// Length of unfiltered data
+  unsigned	seed;			// Pseudo-random seed
+  unsigned char	expected[16384],	// Expected data
+		data[16384],		// Data read
+		compressed[32768],	// Raw Flate data
+		raw[16384];		// Filtered data
+  size_t	numbers[6 * 7 * 4];	// Object numbers
+  bool		error = false;		// Error callback data
+  static const int formats[7][2] =	// BitsPerComponent and Colors
+  {
+    { 1, 1 },				// 1 byte per pixel, sub-byte pixels
+    { 8, 1 },				// 1 byte per pixel
+    { 8, 2 },				// 2 bytes per pixel
+    { 8, 3 },				// 3 bytes per pixel
+    { 8, 4 },				// 4 bytes per pixel
+    { 16, 3 },				// 6 bytes per pixel
+    { 16, 4 }				// 8 bytes per pixel
+  };
+  static const size_t widths[4] =	// Columns
+  {
+    1, 7, 13, 67
+  };
+  static const size_t height = 24;	// Number of lines
 
 
-  // Create the page dictionary, object, and stream...
-  fputs("pdfioDictCreate: ", stdout);
-  if ((dict = pdfioDictCreate(pdf)) != NULL)
+  printf("pdfioFileCreate(\"%s\", ...): ", filename);
+  if ((pdf = pdfioFileCreate(filename, NULL, NULL, NULL, (pdfio_error_cb_t)error_cb, &error)) != NULL)
     puts("PASS");
   else
     return (1);
 
-  fputs("pdfioPageDictAddImage: ", stdout);
-  if (pdfioPageDictAddImage(dict, "IM1", image))
+  fputs("pdfioStreamWrite(PNG predictors): ", stdout);
+  for (predictor = _PDFIO_PREDICTOR_PNG_NONE; predictor <= _PDFIO_PREDICTOR_PNG_AUTO; predictor ++)
+  {
+    for (f = 0; f < 7; f ++)
+    {
+      for (w = 0; w < 4; w ++)
+      {
+        bpp = (size_t)(formats[f][0] * formats[f][1] + 7) / 8;
+        len = (size_t)formats[f][0] * (size_t)formats[f][1] * widths[w];
+        len = (len + 7) / 8;
+
+        if ((dict = pdfioDictCreate(pdf)) == NULL || (decode = pdfioDictCreate(pdf)) == NULL)
+        {
+          puts("FAIL");
+          goto fail;
+        }
+
+        pdfioDictSetName(dict, "Filter", "FlateDecode");
+        pdfioDictSetNumber(decode, "BitsPerComponent", formats[f][0]);
+        pdfioDictSetNumber(decode, "Colors", formats[f][1]);
+        pdfioDictSetNumber(decode, "Columns", widths[w]);
+        pdfioDictSetNumber(decode, "Predictor", predictor);
+        pdfioDictSetDict(dict, "DecodeParms", decode);
+
+        if ((obj = pdfioFileCreateObj(pdf, dict)) == NULL || (st = pdfioObjCreateStream(obj, PDFIO_FILTER_FLATE)) == NULL)
+        {
+          puts("FAIL");
+          goto fail;
+        }
+
+        for (y = 0, seed = (unsigned)num_objs; y < height; y ++)
+        {
+          write_predictor_row(expected + y * len, y ? expected + (y - 1) * len : NULL, y, len, bpp, &seed);
+
+          if (!pdfioStreamWrite(st, expected + y * len, len))
+          {
+            puts("FAIL");
+            pdfioStreamClose(st);
+            goto fail;
+          }
+        }
+
+        if (!pdfioStreamClose(st))
+        {
+          puts("FAIL");
+          goto fail;
+        }
+
+        numbers[num_objs ++] = pdfioObjGetNumber(obj);
+      }
+    }
+  }
+
+  puts("PASS");
+
+  printf("pdfioFileClose(\"%s\"): ", filename);
+  if (pdfioFileClose(pdf))
     puts("PASS");
   else
     return (1);
 
-  fputs("pdfioPageDictAddFont(F1): ", stdout);
-  if (pdfioPageDictAddFont(dict, "F1", font))
+  // Read the streams back...
+  printf("pdfioFileOpen(\"%s\", ...): ", filename);
+  if ((pdf = pdfioFileOpen(filename, NULL, NULL, (pdfio_error_cb_t)error_cb, &error)) != NULL)
     puts("PASS");
   else
     return (1);
 
-  printf("pdfioFileCreatePage(%d): ", number);
+  fputs("pdfioStreamRead(PNG predictors): ", stdout);
+  for (predictor = _PDFIO_PREDICTOR_PNG_NONE, num_objs = 0; predictor <= _PDFIO_PREDICTOR_PNG_AUTO; predictor ++)
+  {
+    for (f = 0; f < 7; f ++)
+    {
+      for (w = 0; w < 4; w ++, num_objs ++)
+      {
+        bpp = (size_t)(formats[f][0] * formats[f][1] + 7) / 8;
+        len = (size_t)formats[f][0] * (size_t)formats[f][1] * widths[w];
+        len = (len + 7) / 8;
 
-  if ((st = pdfioFileCreatePage(pdf, dict)) != NULL)
-    puts("PASS");
-  else
-    return (1);
+        for (y = 0, seed = (unsigned)num_objs; y < height; y ++)
+          write_predictor_row(expected + y * len, y ? expected + (y - 1) * len : NULL, y, len, bpp, &seed);
 
-  if (write_header_footer(st, title, number))
-    goto error;
+        // Compare the decoded data...
+        if ((obj = pdfioFileFindObj(pdf, numbers[num_objs])) == NULL || (st = pdfioObjOpenStream(obj, true)) == NULL)
+        {
+          printf("FAIL (unable to open object %u)\n", (unsigned)numbers[num_objs]);
+          goto fail;
+        }
 
-  // Calculate the scaled size of the image...
-  fputs("pdfioImageGetWidth(): ", stdout);
-  if ((width = pdfioImageGetWidth(image)) > 0.0)
-    puts("PASS");
-  else
-    goto error;
+        for (total = 0; total < sizeof(data) && (bytes = pdfioStreamRead(st, data + total, sizeof(data) - total)) > 0; total += (size_t)bytes);
 
-  fputs("pdfioImageGetHeight(): ", stdout);
-  if ((height = pdfioImageGetHeight(image)) > 0.0)
-    puts("PASS");
-  else
-    goto error;
+        pdfioStreamClose(st);
 
-  swidth  = 400.0;
-  sheight = swidth * height / width;
-  if (sheight > 500.0)
-  {
-    sheight = 500.0;
-    swidth  = sheight * width / height;
-  }
+        if (total != (height * len) || memcmp(data, expected, total))
+        {
+          printf("FAIL (Predictor %d, BitsPerComponent %d, Colors %d, Columns %u: data does not match)\n", predictor, formats[f][0], formats[f][1], (unsigned)widths[w]);
+          goto fail;
+        }
 
-  tx = 0.5 * (595.28 - swidth);
-  ty = 0.5 * (792 - sheight);
+        // Then check the filter used for each line...
+        if ((st = pdfioObjOpenStream(obj, false)) == NULL)
+        {
+          printf("FAIL (unable to open object %u)\n", (unsigned)numbers[num_objs]);
+          goto fail;
+        }
 
-  // Show "raw" content (a bordered box for the image...)
-  fputs("pdfioStreamPrintf(...): ", stdout);
-  if (pdfioStreamPrintf(st,
-                       "1 0 0 RG 0 g 5 w\n"
-                       "%g %g %g %g re %g %g %g %g re B*\n", tx - 36, ty - 36, swidth + 72, sheight + 72, tx - 1, ty - 1, swidth + 2, sheight + 2))
-    puts("PASS");
-  else
-    goto error;
+        for (total = 0; total < sizeof(compressed) && (bytes = pdfioStreamRead(st, compressed + total, sizeof(compressed) - total)) > 0; total += (size_t)bytes);
 
-  // Draw the image inside the border box...
-  printf("pdfioContentDrawImage(\"IM1\", x=%g, y=%g, w=%g, h=%g): ", tx, ty, swidth, sheight);
-  if (pdfioContentDrawImage(st, "IM1", tx, ty, swidth, sheight))
-    puts("PASS");
-  else
-    goto error;
+        pdfioStreamClose(st);
 
-  // Close the page stream/object...
-  fputs("pdfioStreamClose: ", stdout);
-  if (pdfioStreamClose(st))
-    puts("PASS");
-  else
-    return (1);
+        rawlen = (uLongf)sizeof(raw);
 
-  return (0);
+        if (uncompress(raw, &rawlen, compressed, (uLong)total) != Z_OK || rawlen != (height * (len + 1)))
+        {
+          printf("FAIL (Predictor %d, BitsPerComponent %d, Colors %d, Columns %u: bad Flate data)\n", predictor, formats[f][0], formats[f][1], (unsigned)widths[w]);
+          goto fail;
+        }
 
-  error:
+        for (y = 0; y < height; y ++)
+        {
+          unsigned char filter = raw[y * (len + 1)];
+					// PNG filter for line
+          const unsigned char *line = raw + y * (len + 1) + 1,
+					// Filtered line
+		*cur = expected + y * len,
+					// Expected line
+		*up = y ? cur - len : NULL;
+					// Previous expected line
+          int		a, b, c,	// Left, up, and upper-left bytes
+			p, pa, pb, pc;	// Paeth prediction and distances
+
+          if (filter > 4 || (predictor != _PDFIO_PREDICTOR_PNG_AUTO && filter != (predictor - _PDFIO_PREDICTOR_PNG_NONE)))
+          {
+            printf("FAIL (Predictor %d, BitsPerComponent %d, Colors %d, Columns %u: line %u uses filter %u)\n", predictor, formats[f][0], formats[f][1], (unsigned)widths[w], (unsigned)y, filter);
+            goto fail;
+          }
+
+          if (predictor == _PDFIO_PREDICTOR_PNG_AUTO)
+            filters |= 1U << filter;
+
+          // Undo the filter as described in the PNG specification and compare
+          // with the expected line...
+          for (i = 0; i < len; i ++)
+          {
+            a = i >= bpp ? cur[i - bpp] : 0;
+            b = up ? up[i] : 0;
+            c = (i >= bpp && up) ? up[i - bpp] : 0;
+
+            switch (filter)
+            {
+              default : // None
+                  p = 0;
+                  break;
+              case 1 : // Sub
+                  p = a;
+                  break;
+              case 2 : // Up
+                  p = b;
+                  break;
+              case 3 : // Average
+                  p = (a + b) / 2;
+                  break;
+              case 4 : // Paeth
+                  p  = a + b - c;
+                  pa = abs(p - a);
+                  pb = abs(p - b);
+                  pc = abs(p - c);
+                  p  = (pa <= pb && pa <= pc) ? a : pb <= pc ? b : c;
+                  break;
+            }
+
+            if (((line[i] + p) & 255) != cur[i])
+            {
+              printf("FAIL (Predictor %d, BitsPerComponent %d, Colors %d, Columns %u: line %u filter %u byte %u is %u, expected %u)\n", predictor, formats[f][0], formats[f][1], (unsigned)widths[w], (unsigned)y, filter, (unsigned)i, line[i], (unsigned)((cur[i] - p) & 255));
+              goto fail;
+            }
+          }
+        }
+      }
+    }
+  }
 
-  pdfioStreamClose(st);
-  return (1);
+  if (filters != 0x1f)
+  {
+    printf("FAIL (auto predictor used filters 0x%02x)\n", (unsigned)filters);
+    goto fail;
+  }
+
+  puts("PASS");
+
+  ret = 0;
+
+  fail:
+
+  pdfioFileClose(pdf);
+
+  return (ret);
 }
 
 
 //
-// 'write_png_test()' - Write a page of PNG test images.
+// 'write_predictor_row()' - Generate a line of data for the PNG predictor test.
+//
+// The lines cycle through random data, a line matching the Paeth prediction
+// after its first pixel, a copy of the previous line, a horizontal ramp, a
+// line matching the Average prediction, and a line of zeros, so that each PNG
+// filter is the best choice for some of the lines.
 //
 
-static int				// O - 0 on success, 1 on failure
-write_png_test(pdfio_file_t *pdf,		// I - PDF file
-          int          number,		// I - Page number
-          pdfio_obj_t  *font)		// I - Page number font
+static void
+write_predictor_row(
+    unsigned char       *row,		// I  - Line buffer
+    const unsigned char *prev,		// I  - Previous line or `NULL` for none
+    size_t              y,		// I  - Line number
+    size_t              len,		// I  - Bytes per line
+    size_t              bpp,		// I  - Bytes per pixel
+    unsigned            *seed)		// IO - Pseudo-random seed
 {
-  pdfio_dict_t		*dict;		// Page dictionary
-  pdfio_stream_t	*st;		// Page contents stream
-  pdfio_obj_t		*color,		// pdfio-color.png
-			*gray,		// pdfio-gray.png
-			*indexed;	// pdfio-indexed.png
+  size_t	i;			// Looping var
+  int		a, b, c,		// Left, up, and upper-left bytes
+		p, pa, pb, pc;		// Paeth prediction and distances
 
 
-  // Import the PNG test images
-  fputs("pdfioFileCreateImageObjFromFile(\"testfiles/pdfio-color.png\"): ", stdout);
-  if ((color = pdfioFileCreateImageObjFromFile(pdf, "testfiles/pdfio-color.png", false)) != NULL)
-    puts("PASS");
-  else
-    return (1);
+  if (!prev)
+    y = 0;
 
-  fputs("pdfioFileCreateImageObjFromFile(\"testfiles/pdfio-gray.png\"): ", stdout);
-  if ((gray = pdfioFileCreateImageObjFromFile(pdf, "testfiles/pdfio-gray.png", false)) != NULL)
-    puts("PASS");
-  else
-    return (1);
+  switch (y % 6)
+  {
+    case 0 : // Random data (None)
+        for (i = 0; i < len; i ++)
+        {
+          *seed  = *seed * 1103515245 + 12345;
+          row[i] = (unsigned char)(*seed >> 16);
+        }
+        break;
 
-  fputs("pdfioFileCreateImageObjFromFile(\"testfiles/pdfio-indexed.png\"): ", stdout);
-  if ((indexed = pdfioFileCreateImageObjFromFile(pdf, "testfiles/pdfio-indexed.png", false)) != NULL)
-    puts("PASS");
-  else
-    return (1);
+    case 2 : // Copy of previous line (Up)
+        memcpy(row, prev, len);
+        break;
 
-  // Create the page dictionary, object, and stream...
-  fputs("pdfioDictCreate: ", stdout);
-  if ((dict = pdfioDictCreate(pdf)) != NULL)
-    puts("PASS");
-  else
-    return (1);
+    case 3 : // Horizontal ramp (Sub)
+        for (i = 0; i < len; i ++)
+          row[i] = (unsigned char)(prev[0] + i);
+        break;
+
+    case 4 : // Average of left and up (Average)
+        for (i = 0; i < len; i ++)
+          row[i] = (unsigned char)(((i >= bpp ? row[i - bpp] : 0) + prev[i]) >> 1);
+        break;
+
+    case 1 : // Paeth prediction (Paeth)
+        for (i = 0; i < len && i < bpp; i ++)
+          row[i] = (unsigned char)(prev[i] + 64);
+
+        for (; i < len; i ++)
+        {
+          a  = row[i - bpp];
+          b  = prev[i];
+          c  = prev[i - bpp];
+          p  = a + b - c;
+          pa = abs(p - a);
+          pb = abs(p - b);
+          pc = abs(p - c);
+
+          row[i] = (unsigned char)((pa <= pb && pa <= pc) ? a : (pb <= pc) ? b : c);
+        }
+        break;
 
-  fputs("pdfioPageDictAddImage(color): ", stdout);
-  if (pdfioPageDictAddImage(dict, "IM1", color))
-    puts("PASS");
-  else
-    return (1);
+    default : // Zeros (None)
+        memset(row, 0, len);
+        break;
+  }
+}
 
-  fputs("pdfioPageDictAddImage(gray): ", stdout);
-  if (pdfioPageDictAddImage(dict, "IM2", gray))
-    puts("PASS");
-  else
-    return (1);
 
-  fputs("pdfioPageDictAddImage(indexed): ", stdout);
-  if (pdfioPageDictAddImage(dict, "IM3", indexed))
-    puts("PASS");
-  else
-    return (1);
+//
+// 'write_streaming_file()' - Write many pages with streaming output and check memory use.
+//
 
-  fputs("pdfioPageDictAddFont(F1): ", stdout);
-  if (pdfioPageDictAddFont(dict, "F1", font))
-    puts("PASS");
-  else
-    return (1);
+static int				// O - Exit status
+write_streaming_file(
+    const char *filename,		// I - PDF filename
+    size_t     num_pages)		// I - Number of pages to write
+{
+  pdfio_file_t	*pdf;			// PDF file
+  pdfio_obj_t	*font;			// Font object
+  pdfio_dict_t	*dict;			// Page dictionary
+  pdfio_stream_t *st;			// Page contents stream
+  size_t	i,			// Looping var
+		first_bytes = 0,	// Heap bytes after the first pages
+		last_bytes,		// Heap bytes after the last page
+		page_bytes;		// Heap bytes per page
+  char		text[256];		// Page text
+  bool		error = false;		// Error callback data
 
-  printf("pdfioFileCreatePage(%d): ", number);
 
-  if ((st = pdfioFileCreatePage(pdf, dict)) != NULL)
+  printf("pdfioFileCreate(\"%s\", ...): ", filename);
+  if ((pdf = pdfioFileCreate(filename, NULL, NULL, NULL, (pdfio_error_cb_t)error_cb, &error)) != NULL)
     puts("PASS");
   else
     return (1);
 
-  if (write_header_footer(st, "PNG Image Test Page", number))
-    goto error;
-
-  // Show content...
-  fputs("pdfioContentTextBegin(): ", stdout);
-  if (pdfioContentTextBegin(st))
+  fputs("pdfioFileSetOptions(PDFIO_OPTION_STREAMING): ", stdout);
+  if (pdfioFileSetOptions(pdf, PDFIO_OPTION_STREAMING))
     puts("PASS");
   else
-    goto error;
+    goto fail;
 
-  fputs("pdfioContentSetTextFont(\"F1\", 18.0): ", stdout);
-  if (pdfioContentSetTextFont(st, "F1", 18.0))
+  fputs("pdfioFileSetOptions(PDFIO_OPTION_LINEARIZE | PDFIO_OPTION_STREAMING): ", stdout);
+  if (!pdfioFileSetOptions(pdf, PDFIO_OPTION_LINEARIZE | PDFIO_OPTION_STREAMING))
     puts("PASS");
   else
-    goto error;
+    goto fail;
 
-  fputs("pdfioContentTextMoveTo(36.0, 342.0): ", stdout);
-  if (pdfioContentTextMoveTo(st, 36.0, 342.0))
+  fputs("pdfioFileSetCacheSize(65536): ", stdout);
+  if (!pdfioFileSetCacheSize(pdf, 65536))
     puts("PASS");
   else
-    goto error;
+    goto fail;
 
-  fputs("pdfioContentTextShow(\"PNG RGB Color\"): ", stdout);
-  if (pdfioContentTextShow(st, false, "PNG RGB Color"))
+  fputs("pdfioFileCreateFontObjFromBase(\"Courier\"): ", stdout);
+  if ((font = pdfioFileCreateFontObjFromBase(pdf, "Courier")) != NULL)
     puts("PASS");
   else
-    goto error;
+    goto fail;
 
-  fputs("pdfioContentTextMoveTo(288.0, 0.0): ", stdout);
-  if (pdfioContentTextMoveTo(st, 288.0, 0.0))
-    puts("PASS");
-  else
-    goto error;
+  // Reuse the same page dictionary for every page...
+  if ((dict = pdfioDictCreate(pdf)) == NULL || !pdfioPageDictAddFont(dict, "F1", font))
+    goto fail;
 
-  fputs("pdfioContentTextShow(\"PNG Gray\"): ", stdout);
-  if (pdfioContentTextShow(st, false, "PNG Gray"))
-    puts("PASS");
-  else
-    goto error;
+  printf("pdfioFileCreatePage(%lu pages): ", (unsigned long)num_pages);
+  for (i = 0; i < num_pages; i ++)
+  {
+    if ((st = pdfioFileCreatePage(pdf, dict)) == NULL)
+      break;
 
-  fputs("pdfioContentTextMoveTo(-288.0, 288.0): ", stdout);
-  if (pdfioContentTextMoveTo(st, -288.0, 288.0))
-    puts("PASS");
-  else
-    goto error;
+    snprintf(text, sizeof(text), "Statement page %lu of %lu", (unsigned long)(i + 1), (unsigned long)num_pages);
 
-  fputs("pdfioContentTextShow(\"PNG Indexed\"): ", stdout);
-  if (pdfioContentTextShow(st, false, "PNG Indexed"))
-    puts("PASS");
-  else
-    goto error;
+    if (!pdfioContentTextBegin(st) || !pdfioContentSetTextFont(st, "F1", 12.0) || !pdfioContentTextMoveTo(st, 36.0, 36.0) || !pdfioContentTextShow(st, false, text) || !pdfioContentTextEnd(st))
+      break;
 
-  fputs("pdfioContentTextEnd(): ", stdout);
-  if (pdfioContentTextEnd(st))
-    puts("PASS");
-  else
-    goto error;
+    if (!pdfioStreamClose(st))
+      break;
 
-  fputs("pdfioContentDrawImage(\"IM1\"): ", stdout);
-  if (pdfioContentDrawImage(st, "IM1", 36, 108, 216, 216))
+    // Measure the heap once things have settled down...
+    if (i == 99)
+      first_bytes = get_heap_bytes();
+  }
+
+  if (i >= num_pages)
     puts("PASS");
   else
-    goto error;
+    goto fail;
 
-  fputs("pdfioContentDrawImage(\"IM2\"): ", stdout);
-  if (pdfioContentDrawImage(st, "IM2", 324, 108, 216, 216))
-    puts("PASS");
+  // Only the cross-reference entries of the freed page, content stream, and
+  // page tree node objects should remain, which is 16 bytes per object with
+  // up to twice that allocated...
+  last_bytes = get_heap_bytes();
+
+  fputs("heap growth per page: ", stdout);
+  if (first_bytes == 0 || last_bytes == 0)
+  {
+    puts("PASS (heap statistics not available)");
+  }
+  else if ((page_bytes = last_bytes > first_bytes ? (last_bytes - first_bytes) / (num_pages - 100) : 0) <= 80)
+  {
+    printf("PASS (%lu bytes)\n", (unsigned long)page_bytes);
+  }
   else
-    goto error;
+  {
+    printf("FAIL (%lu bytes)\n", (unsigned long)page_bytes);
+    pdfioFileClose(pdf);
+    return (1);
+  }
 
-  fputs("pdfioContentDrawImage(\"IM3\"): ", stdout);
-  if (pdfioContentDrawImage(st, "IM3", 36, 396, 216, 216))
+  fputs("pdfioFileGetPage(0): ", stdout);
+  if (!pdfioFileGetPage(pdf, 0))
     puts("PASS");
   else
-    goto error;
+    goto fail;
 
-  fputs("pdfioContentSetFillColorDeviceRGB(0, 1, 1): ", stdout);
-  if (pdfioContentSetFillColorDeviceRGB(st, 0.0, 1.0, 1.0))
+  fputs("pdfioFileSetOptions(PDFIO_OPTION_NONE): ", stdout);
+  if (!pdfioFileSetOptions(pdf, PDFIO_OPTION_NONE))
     puts("PASS");
   else
-    goto error;
+    goto fail;
 
-  fputs("pdfioContentPathRect(315, 387, 234, 234): ", stdout);
-  if (pdfioContentPathRect(st, 315, 387, 234, 234))
+  printf("pdfioFileClose(\"%s\"): ", filename);
+  if (pdfioFileClose(pdf))
     puts("PASS");
   else
-    goto error;
+    return (1);
 
-  fputs("pdfioContentFill(false): ", stdout);
-  if (pdfioContentFill(st, false))
+  // Make sure the pages can be read back...
+  printf("pdfioFileOpen(\"%s\", ...): ", filename);
+  if ((pdf = pdfioFileOpen(filename, NULL, NULL, (pdfio_error_cb_t)error_cb, &error)) != NULL)
     puts("PASS");
   else
-    goto error;
+    return (1);
 
-  fputs("pdfioContentDrawImage(\"IM3\"): ", stdout);
-  if (pdfioContentDrawImage(st, "IM3", 324, 396, 216, 216))
+  fputs("pdfioFileGetNumPages: ", stdout);
+  if ((i = pdfioFileGetNumPages(pdf)) == num_pages)
+  {
     puts("PASS");
+  }
   else
-    goto error;
+  {
+    printf("FAIL (%lu, expected %lu)\n", (unsigned long)i, (unsigned long)num_pages);
+    goto fail;
+  }
 
-  // Close the object and stream...
-  fputs("pdfioStreamClose: ", stdout);
-  if (pdfioStreamClose(st))
+  fputs("pdfioPageGetNumStreams: ", stdout);
+  if (pdfioPageGetNumStreams(pdfioFileGetPage(pdf, num_pages - 1)) == 1)
     puts("PASS");
   else
-    return (1);
+    goto fail;
+
+  pdfioFileClose(pdf);
 
   return (0);
 
-  error:
+  fail:
+
+  puts("FAIL");
+  pdfioFileClose(pdf);
 
-  pdfioStreamClose(st);
   return (1);
 }
 
@@ -3486,6 +8070,12 @@ write_unit_file(
   else
     return (1);
 
+  fputs("pdfioFileCreateImageObjFromFile(\"testfiles/color.jpg\", cached): ", stdout);
+  if (pdfioFileCreateImageObjFromFile(outpdf, "testfiles/color.jpg", true) == color_jpg)
+    puts("PASS");
+  else
+    return (1);
+
   // Create fonts...
   fputs("pdfioFileCreateFontObjFromBase(\"Helvetica\"): ", stdout);
   if ((helvetica = pdfioFileCreateFontObjFromBase(outpdf, "Helvetica")) != NULL)
@@ -3578,3 +8168,194 @@ write_unit_file(
 
   return (0);
 }
+
+
+//
+// 'write_update_file()' - Append an incremental update to a copy of a unit test file.
+//
+
+static int				// O - Exit status
+write_update_file(
+    const char *srcname,		// I - Unit test file
+    const char *filename,		// I - File to update
+    size_t     num_pages,		// I - Number of pages in unit test file
+    size_t     first_image)		// I - First image object
+{
+  int		srcfd,			// Source file
+		dstfd;			// Destination file
+  char		buffer[65536],		// Copy buffer
+		original[65536];	// Original data
+  ssize_t	bytes;			// Bytes read
+  off_t		srcsize = 0,		// Size of unit test file
+		offset;			// Offset in file
+  pdfio_file_t	*pdf;			// PDF file
+  pdfio_obj_t	*obj,			// Object
+		*font;			// Font object
+  pdfio_dict_t	*dict,			// Page dictionary
+		*resources,		// Resource dictionary
+		*fonts;			// Font dictionary
+  pdfio_stream_t *st;			// Page contents stream
+  bool		error = false;		// Error callback data
+
+
+  // Copy the unit test file...
+  printf("Copy \"%s\" to \"%s\": ", srcname, filename);
+  if ((srcfd = open(srcname, O_RDONLY | O_BINARY)) < 0)
+  {
+    printf("FAIL (%s)\n", strerror(errno));
+    return (1);
+  }
+
+  if ((dstfd = open(filename, O_WRONLY | O_CREAT | O_TRUNC | O_BINARY, 0666)) < 0)
+  {
+    printf("FAIL (%s)\n", strerror(errno));
+    close(srcfd);
+    return (1);
+  }
+
+  while ((bytes = read(srcfd, buffer, sizeof(buffer))) > 0)
+  {
+    if (write(dstfd, buffer, (size_t)bytes) != bytes)
+      break;
+
+    srcsize += bytes;
+  }
+
+  close(dstfd);
+
+  if (bytes != 0)
+  {
+    printf("FAIL (%s)\n", strerror(errno));
+    close(srcfd);
+    return (1);
+  }
+
+  puts("PASS");
+
+  // Open the copy for updating...
+  printf("pdfioFileOpenUpdate(\"%s\", ...): ", filename);
+  if ((pdf = pdfioFileOpenUpdate(filename, password_cb, (void *)"user", (pdfio_error_cb_t)error_cb, &error)) != NULL)
+  {
+    puts("PASS");
+  }
+  else
+  {
+    close(srcfd);
+    return (1);
+  }
+
+  // Change an existing page dictionary...
+  fputs("pdfioObjClose(rotated page 1): ", stdout);
+  if ((obj = pdfioFileGetPage(pdf, 0)) != NULL && (dict = pdfioObjGetDict(obj)) != NULL && pdfioDictSetNumber(dict, "Rotate", 90.0) && pdfioObjClose(obj))
+    puts("PASS");
+  else
+    goto fail;
+
+  // Rewrite an existing stream object...
+  printf("pdfioObjClose(image %lu): ", (unsigned long)first_image);
+  if ((obj = pdfioFileFindObj(pdf, first_image)) != NULL && pdfioObjClose(obj))
+    puts("PASS");
+  else
+    goto fail;
+
+  // Add a new page...
+  fputs("pdfioFileCreateFontObjFromBase(\"Helvetica\"): ", stdout);
+  if ((font = pdfioFileCreateFontObjFromBase(pdf, "Helvetica")) != NULL)
+    puts("PASS");
+  else
+    goto fail;
+
+  if ((dict = pdfioDictCreate(pdf)) == NULL || (resources = pdfioDictCreate(pdf)) == NULL || (fonts = pdfioDictCreate(pdf)) == NULL)
+    goto fail;
+
+  pdfioDictSetObj(fonts, "F1", font);
+  pdfioDictSetDict(resources, "Font", fonts);
+  pdfioDictSetDict(dict, "Resources", resources);
+
+  fputs("pdfioFileCreatePage(update): ", stdout);
+  if ((st = pdfioFileCreatePage(pdf, dict)) != NULL)
+    puts("PASS");
+  else
+    goto fail;
+
+  if (write_header_footer(st, "Incremental Update", (int)num_pages + 1))
+    goto fail;
+
+  fputs("pdfioStreamClose: ", stdout);
+  if (pdfioStreamClose(st))
+    puts("PASS");
+  else
+    goto fail;
+
+  printf("pdfioFileClose(\"%s\"): ", filename);
+  if (pdfioFileClose(pdf))
+    puts("PASS");
+  else
+    goto fail_close;
+
+  // Verify that the original file data is unchanged...
+  fputs("Verify original data: ", stdout);
+  if ((dstfd = open(filename, O_RDONLY | O_BINARY)) < 0)
+  {
+    printf("FAIL (%s)\n", strerror(errno));
+    goto fail_close;
+  }
+
+  lseek(srcfd, 0, SEEK_SET);
+
+  for (offset = 0; offset < srcsize; offset += bytes)
+  {
+    if ((bytes = read(srcfd, buffer, sizeof(buffer))) <= 0 || read(dstfd, original, (size_t)bytes) != bytes || memcmp(buffer, original, (size_t)bytes))
+      break;
+  }
+
+  close(srcfd);
+
+  if (offset == srcsize && read(dstfd, original, sizeof(original)) > 0)
+  {
+    close(dstfd);
+    puts("PASS");
+  }
+  else
+  {
+    close(dstfd);
+    printf("FAIL (differs at or after offset %ld)\n", (long)offset);
+    return (1);
+  }
+
+  // Read the updated file...
+  if (read_unit_file(filename, num_pages + 1, first_image, false))
+    return (1);
+
+  printf("pdfioFileOpen(\"%s\", ...): ", filename);
+  if ((pdf = pdfioFileOpen(filename, password_cb, (void *)"user", (pdfio_error_cb_t)error_cb, &error)) != NULL)
+    puts("PASS");
+  else
+    return (1);
+
+  fputs("pdfioDictGetNumber(Rotate): ", stdout);
+  if (pdfioDictGetNumber(pdfioObjGetDict(pdfioFileGetPage(pdf, 0)), "Rotate") == 90.0)
+  {
+    puts("PASS");
+  }
+  else
+  {
+    puts("FAIL (expected 90)");
+    pdfioFileClose(pdf);
+    return (1);
+  }
+
+  pdfioFileClose(pdf);
+
+  return (0);
+
+  fail:
+
+  pdfioFileClose(pdf);
+
+  fail_close:
+
+  close(srcfd);
+
+  return (1);
+}
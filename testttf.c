@@ -14,6 +14,7 @@
 //
 
 #include <stdio.h>
+#include <stdlib.h>
 #include "ttf.h"
 
 
@@ -80,7 +81,10 @@ test_font(const char *filename)		// I - Font filename
 {
   int		i,			// Looping var
 		errors = 0;		// Number of errors
-  ttf_t		*font;			// Font
+  ttf_t		*font,			// Font
+		*subfont;		// Subset font
+  unsigned char	*subdata;		// Subset font data
+  size_t	subsize;		// Size of subset font data
   const char	*value;			// Font (string) value
   int		intvalue;		// Font (integer) value
   float		realvalue;		// Font (real) value
@@ -111,6 +115,11 @@ test_font(const char *filename)		// I - Font filename
     "Привет мир!",			// Russian
     "こんにちは世界！"			// Japanese
   };
+  static const int subchars[] =		// Subset characters
+  {
+    'H', 'e', 'l', 'o', ',', ' ', 'W', 'r', 'd', '!',
+    0x3053, 0x3093, 0x306b, 0x3061, 0x306f, 0x4e16, 0x754c, 0xff01
+  };
   static const char * const styles[] =	// Font style names
   {
     "TTF_STYLE_NORMAL",
@@ -299,6 +308,47 @@ test_font(const char *filename)		// I - Font filename
   else
     puts("PASS (false)");
 
+  fputs("ttfCopySubset: ", stdout);
+  if ((subdata = ttfCopySubset(font, sizeof(subchars) / sizeof(subchars[0]), subchars, &subsize)) != NULL)
+  {
+    printf("PASS (%u bytes)\n", (unsigned)subsize);
+
+    fputs("ttfCreateData(subset): ", stdout);
+    if ((subfont = ttfCreateData(subdata, subsize, 0, error_cb, NULL)) != NULL)
+      puts("PASS");
+    else
+      errors ++;
+
+    if (subfont)
+    {
+      fputs("ttfGetWidth(subset): ", stdout);
+      for (i = 0; i < (int)(sizeof(subchars) / sizeof(subchars[0])); i ++)
+      {
+        if (ttfGetWidth(subfont, subchars[i]) != ttfGetWidth(font, subchars[i]))
+          break;
+      }
+
+      if (i < (int)(sizeof(subchars) / sizeof(subchars[0])))
+      {
+        printf("FAIL (width of U+%04X is %d, expected %d)\n", subchars[i], ttfGetWidth(subfont, subchars[i]), ttfGetWidth(font, subchars[i]));
+        errors ++;
+      }
+      else
+      {
+        puts("PASS");
+      }
+
+      ttfDelete(subfont);
+    }
+
+    free(subdata);
+  }
+  else
+  {
+    puts("FAIL");
+    errors ++;
+  }
+
   ttfDelete(font);
 
   return (errors);
@@ -101,20 +101,30 @@ typedef __int64 ssize_t;		// POSIX type not present on Windows... @private@
 #define TTF_FONT_MAX_CHAR	262144	// Maximum number of character values
 #define TTF_FONT_MAX_GROUPS	65536	// Maximum number of sub-groups
 #define TTF_FONT_MAX_NAMES	16777216// Maximum size of names table we support
+#define TTF_SUBSET_MAX_TABLES	32	// Maximum number of tables in a subset
 
 
 //
 // TTF/OFF tag constants...
 //
 
+#define TTF_OFF_CFF	0x43464620	// Compact font format outlines
 #define TTF_OFF_cmap	0x636d6170	// Character to glyph mapping
+#define TTF_OFF_cvt	0x63767420	// Control value table
+#define TTF_OFF_fpgm	0x6670676d	// Font program
+#define TTF_OFF_glyf	0x676c7966	// Glyph outlines
 #define TTF_OFF_head	0x68656164	// Font header
 #define TTF_OFF_hhea	0x68686561	// Horizontal header
 #define TTF_OFF_hmtx	0x686d7478	// Horizontal metrics
+#define TTF_OFF_loca	0x6c6f6361	// Glyph locations
 #define TTF_OFF_maxp	0x6d617870	// Maximum profile
 #define TTF_OFF_name	0x6e616d65	// Naming table
 #define TTF_OFF_OS_2	0x4f532f32	// OS/2 and Windows specific metrics
 #define TTF_OFF_post	0x706f7374	// PostScript information
+#define TTF_OFF_prep	0x70726570	// Control value program
+#define TTF_OFF_vhea	0x76686561	// Vertical header
+#define TTF_OFF_vmtx	0x766d7478	// Vertical metrics
+#define TTF_OFF_VORG	0x564f5247	// Vertical origin
 
 #define TTF_OFF_Unicode	0	// Unicode platform ID
 
@@ -180,6 +190,9 @@ typedef struct _ttf_off_names_s		// OFF/TTF naming table
 struct _ttf_s
 {
   int		fd;			// File descriptor
+  const unsigned char *data;		// Font data in memory, if any
+  size_t	datasize,		// Size of font data in memory
+		datapos;		// Current position in font data
   size_t	idx;			// Font number in file
   ttf_err_cb_t	err_cb;			// Error callback, if any
   void		*err_data;		// Error callback data
@@ -193,6 +206,7 @@ struct _ttf_s
   bool		is_fixed;		// Is this a fixed-width font?
   int		max_char,		// Last character in font
 		min_char;		// First character in font
+  int		num_glyphs;		// Number of glyphs
   size_t	num_cmap;		// Number of entries in glyph map
   int		*cmap;			// Unicode character to glyph map
   _ttf_metric_t	*widths[TTF_FONT_MAX_CHAR / 256];
@@ -276,14 +290,64 @@ typedef struct _ttf_off_post_s		// PostScript information
   unsigned	isFixedPitch;		// Fixed-width font?
 } _ttf_off_post_t;
 
+typedef struct _ttf_table_data_s	// Table data for subsets
+{
+  unsigned	tag;			// Table identifier
+  unsigned char	*data;			// Table data
+  size_t	length;			// Length of table data
+} _ttf_table_data_t;
+
+typedef struct _ttf_cff_index_s		// CFF INDEX information
+{
+  size_t	count,			// Number of objects
+		offsize,		// Size of offsets
+		offsets,		// Position of offset array
+		data,			// Position of object data minus 1
+		end;			// Position of end of INDEX
+} _ttf_cff_index_t;
+
+typedef struct _ttf_cff_op_s		// CFF DICT operator replacement
+{
+  unsigned	op;			// Operator (12 x escapes are 1200 + x)
+  size_t	num_values;		// Number of values
+  long		values[2];		// Values
+} _ttf_cff_op_t;
+
+typedef struct _ttf_cff_private_s	// CFF Private DICT information
+{
+  const unsigned char *fd;		// Font DICT, if any
+  size_t	fdlen,			// Length of Font DICT
+		newfdlen;		// Length of new Font DICT
+  _ttf_cff_op_t	fdop;			// Font DICT Private replacement
+  const unsigned char *dict;		// Private DICT
+  size_t	dictlen,		// Length of Private DICT
+		newdictlen;		// Length of new Private DICT
+  _ttf_cff_op_t	op;			// Private DICT Subrs replacement
+  const unsigned char *subrs;		// Local Subr INDEX, if any
+  size_t	subrslen,		// Length of local Subr INDEX
+		newpos;			// Position of new Private DICT
+} _ttf_cff_private_t;
+
 
 //
 // Local functions...
 //
 
+static size_t	cff_copy_dict(unsigned char *dst, const unsigned char *src, size_t srclen, const _ttf_cff_op_t *ops, size_t num_ops);
+static int	cff_get_dict(const unsigned char *dict, size_t dictlen, unsigned op, long *values, int max_values);
+static bool	cff_get_index(const unsigned char *cff, size_t cfflen, size_t pos, _ttf_cff_index_t *idx);
+static size_t	cff_get_offset(const unsigned char *cff, const _ttf_cff_index_t *idx, size_t n);
+static void	cff_put_offset(unsigned char *ptr, size_t offsize, size_t offset);
+static void	cff_set_op(_ttf_cff_op_t *ops, size_t num_ops, unsigned op, long value0, long value1);
 static char	*copy_name(ttf_t *font, unsigned name_id);
+static unsigned char *copy_table(ttf_t *font, unsigned tag, size_t *length);
 static void	errorf(ttf_t *font, const char *message, ...) TTF_FORMAT_ARGS(2,3);
+static unsigned	get_checksum(const unsigned char *data, size_t length);
+static unsigned char *put_ulong(unsigned char *ptr, unsigned value);
+static unsigned char *put_ushort(unsigned char *ptr, unsigned value);
 static bool	read_cmap(ttf_t *font);
+static ssize_t	read_data(ttf_t *font, void *buffer, size_t bytes);
+static bool	read_font(ttf_t *font);
 static bool	read_head(ttf_t *font, _ttf_off_head_t *head);
 static bool	read_hhea(ttf_t *font, _ttf_off_hhea_t *hhea);
 static _ttf_metric_t *read_hmtx(ttf_t *font, _ttf_off_hhea_t *hhea);
@@ -295,7 +359,169 @@ static int	read_short(ttf_t *font);
 static bool	read_table(ttf_t *font);
 static unsigned	read_ulong(ttf_t *font);
 static int	read_ushort(ttf_t *font);
+static off_t	seek_data(ttf_t *font, off_t offset);
 static unsigned	seek_table(ttf_t *font, unsigned tag, unsigned offset, bool required);
+static bool	subset_cff(ttf_t *font, _ttf_table_data_t *cff, const unsigned char *used, size_t num_glyphs);
+static bool	subset_glyf(ttf_t *font, _ttf_table_data_t *head, _ttf_table_data_t *loca, _ttf_table_data_t *glyf, unsigned char *used, size_t num_glyphs);
+static unsigned char *write_sfnt(ttf_t *font, unsigned version, _ttf_table_data_t *tables, size_t num_tables, _ttf_table_data_t *head, size_t *datalen);
+
+
+//
+// 'ttfCopySubset()' - Copy a subset of a font.
+//
+// This function creates a copy of the font containing only the glyphs needed
+// for the specified Unicode characters, which is typically used when
+// embedding a font in a document.  The "num_chars" and "chars" arguments
+// specify the list of Unicode characters to keep.  The ".notdef" glyph and
+// any glyphs used by composite glyphs are always kept.
+//
+// Glyph numbers are preserved so that existing character to glyph mappings
+// remain valid - unused glyphs are replaced by empty glyphs.  Both TrueType
+// ("glyf") and CFF outlines are supported, and OpenType layout tables are
+// omitted from the copy.  If the outlines cannot be subset, the copy contains
+// all of the glyphs.
+//
+// The returned buffer must be freed using the `free` function.
+//
+
+unsigned char *				// O - Font data or `NULL` on error
+ttfCopySubset(ttf_t     *font,		// I - Font
+              size_t    num_chars,	// I - Number of characters
+              const int *chars,		// I - Unicode characters
+              size_t    *datalen)	// O - Length of font data
+{
+  unsigned char	*data = NULL;		// Font data
+  _ttf_table_data_t tables[TTF_SUBSET_MAX_TABLES];
+					// Tables to copy
+  size_t	num_tables = 0,		// Number of tables
+		i,			// Looping var
+		num_glyphs;		// Number of glyphs
+  unsigned char	*used = NULL;		// Glyphs to keep
+  _ttf_table_data_t *glyf = NULL,	// glyf table
+		*loca = NULL,		// loca table
+		*head = NULL,		// head table
+		*cff = NULL;		// CFF table
+  _ttf_off_dir_t *current;		// Current table entry
+  static const unsigned keep[] =	// Tables to keep
+  {
+    TTF_OFF_CFF,
+    TTF_OFF_OS_2,
+    TTF_OFF_VORG,
+    TTF_OFF_cmap,
+    TTF_OFF_cvt,
+    TTF_OFF_fpgm,
+    TTF_OFF_glyf,
+    TTF_OFF_head,
+    TTF_OFF_hhea,
+    TTF_OFF_hmtx,
+    TTF_OFF_loca,
+    TTF_OFF_maxp,
+    TTF_OFF_name,
+    TTF_OFF_post,
+    TTF_OFF_prep,
+    TTF_OFF_vhea,
+    TTF_OFF_vmtx
+  };
+
+
+  // Range check input...
+  if (datalen)
+    *datalen = 0;
+
+  if (!font || (num_chars > 0 && !chars) || !datalen)
+  {
+    errno = EINVAL;
+    return (NULL);
+  }
+
+  // Figure out which glyphs to keep...
+  if (font->num_glyphs <= 0)
+    return (NULL);
+
+  num_glyphs = (size_t)font->num_glyphs;
+
+  if ((used = (unsigned char *)calloc(num_glyphs, 1)) == NULL)
+  {
+    errorf(font, "Unable to allocate memory for glyphs.");
+    return (NULL);
+  }
+
+  used[0] = 1;
+
+  for (i = 0; i < num_chars; i ++)
+  {
+    if (chars[i] >= 0 && (size_t)chars[i] < font->num_cmap && font->cmap[chars[i]] >= 0 && (size_t)font->cmap[chars[i]] < num_glyphs)
+      used[font->cmap[chars[i]]] = 1;
+  }
+
+  // Copy the tables we need...
+  for (i = (size_t)font->table.num_entries, current = font->table.entries; i > 0; i --, current ++)
+  {
+    size_t	j;			// Looping var
+
+    for (j = 0; j < (sizeof(keep) / sizeof(keep[0])); j ++)
+    {
+      if (current->tag == keep[j])
+        break;
+    }
+
+    if (j >= (sizeof(keep) / sizeof(keep[0])) || current->length == 0 || num_tables >= TTF_SUBSET_MAX_TABLES)
+      continue;
+
+    tables[num_tables].tag = current->tag;
+
+    if ((tables[num_tables].data = copy_table(font, current->tag, &tables[num_tables].length)) == NULL)
+      goto done;
+
+    switch (current->tag)
+    {
+      case TTF_OFF_CFF :
+          cff = tables + num_tables;
+          break;
+      case TTF_OFF_glyf :
+          glyf = tables + num_tables;
+          break;
+      case TTF_OFF_head :
+          head = tables + num_tables;
+          break;
+      case TTF_OFF_loca :
+          loca = tables + num_tables;
+          break;
+    }
+
+    num_tables ++;
+  }
+
+  if (!head || head->length < 54)
+  {
+    errorf(font, "head table not found.");
+    goto done;
+  }
+
+  // Subset the glyph outlines...
+  if (glyf && loca)
+  {
+    if (!subset_glyf(font, head, loca, glyf, used, num_glyphs))
+      goto done;
+  }
+  else if (cff)
+  {
+    if (!subset_cff(font, cff, used, num_glyphs))
+      goto done;
+  }
+
+  // Write the new font...
+  data = write_sfnt(font, cff ? 0x4f54544f : 0x10000, tables, num_tables, head, datalen);
+
+  done:
+
+  for (i = 0; i < num_tables; i ++)
+    free(tables[i].data);
+
+  free(used);
+
+  return (data);
+}
 
 
 //
@@ -330,12 +556,6 @@ ttfCreate(const char   *filename,	// I - Filename
           void         *err_data)	// I - Error callback data
 {
   ttf_t			*font = NULL;	// New font object
-  size_t		i;		// Looping var
-  _ttf_metric_t		*widths = NULL;	// Glyph metrics
-  _ttf_off_head_t	head;		// head table
-  _ttf_off_hhea_t	hhea;		// hhea table
-  _ttf_off_os_2_t	os_2;		// OS/2 table
-  _ttf_off_post_t	post;		// PostScript table
 
 
   TTF_DEBUG("ttfCreate(filename=\"%s\", idx=%u, err_cb=%p, err_data=%p)\n", filename, (unsigned)idx, err_cb, err_data);
@@ -359,166 +579,75 @@ ttfCreate(const char   *filename,	// I - Filename
   if ((font->fd = open(filename, O_RDONLY | O_BINARY)) < 0)
   {
     errorf(font, "Unable to open '%s': %s", filename, strerror(errno));
-    goto error;
+    ttfDelete(font);
+    return (NULL);
   }
 
   TTF_DEBUG("ttfCreate: fd=%d\n", font->fd);
 
-  // Read the table of contents and the identifying names...
-  if (!read_table(font))
-    goto error;
-
-  TTF_DEBUG("ttfCreate: num_entries=%d\n", font->table.num_entries);
-
-  if (!read_names(font))
-    goto error;
-
-  TTF_DEBUG("ttfCreate: num_names=%d\n", font->names.num_names);
-
-  // Copy key font meta data strings...
-  font->copyright       = copy_name(font, TTF_OFF_Copyright);
-  font->family          = copy_name(font, TTF_OFF_FontFamily);
-  font->postscript_name = copy_name(font, TTF_OFF_PostScriptName);
-  font->version         = copy_name(font, TTF_OFF_FontVersion);
-
-  if (read_post(font, &post))
-  {
-    font->italic_angle = post.italicAngle;
-    font->is_fixed     = post.isFixedPitch != 0;
-  }
-
-  TTF_DEBUG("ttfCreate: copyright=\"%s\"\n", font->copyright);
-  TTF_DEBUG("ttfCreate: family=\"%s\"\n", font->family);
-  TTF_DEBUG("ttfCreate: postscript_name=\"%s\"\n", font->postscript_name);
-  TTF_DEBUG("ttfCreate: version=\"%s\"\n", font->version);
-  TTF_DEBUG("ttfCreate: italic_angle=%g\n", font->italic_angle);
-  TTF_DEBUG("ttfCreate: is_fixed=%s\n", font->is_fixed ? "true" : "false");
-
-  if (!read_cmap(font))
-    goto error;
-
-  if (!read_head(font, &head))
-    goto error;
-
-  font->units = (float)head.unitsPerEm;
-  font->x_max = head.xMax;
-  font->x_min = head.xMin;
-  font->y_max = head.yMax;
-  font->y_min = head.yMin;
-
-  if (head.macStyle & TTF_OFF_macStyle_Italic)
+  // Load the font...
+  if (!read_font(font))
   {
-    if (font->postscript_name && strstr(font->postscript_name, "Oblique"))
-      font->style = TTF_STYLE_OBLIQUE;
-    else
-      font->style = TTF_STYLE_ITALIC;
+    ttfDelete(font);
+    return (NULL);
   }
-  else
-    font->style = TTF_STYLE_NORMAL;
 
-  if (!read_hhea(font, &hhea))
-    goto error;
+  return (font);
+}
 
-  font->ascent  = hhea.ascender;
-  font->descent = hhea.descender;
 
-  if (read_maxp(font) < 0)
-    goto error;
+//
+// 'ttfCreateData()' - Create a new font object from font data in memory.
+//
+// This function creates a new font object from a TrueType or OpenType font
+// that has been loaded into memory.  The "data" buffer is not copied and must
+// remain valid until the font object is deleted with @link ttfDelete@.
+//
+// The "idx", "err_cb", and "err_data" arguments are the same as for
+// @link ttfCreate@.
+//
+// Font objects created from font data in memory do not change after they are
+// created, so they can be used by multiple threads at the same time.
+//
 
-  if (hhea.numberOfHMetrics > 0)
-  {
-    if ((widths = read_hmtx(font, &hhea)) == NULL)
-      goto error;
-  }
-  else
-  {
-    errorf(font, "Number of horizontal metrics is 0.");
-    goto error;
-  }
+ttf_t *					// O - New font object
+ttfCreateData(const void   *data,	// I - Font data
+              size_t       datasize,	// I - Size of font data
+              size_t       idx,		// I - Font number to create in collection (0-based)
+              ttf_err_cb_t err_cb,	// I - Error callback or `NULL` to log to stderr
+              void         *err_data)	// I - Error callback data
+{
+  ttf_t			*font = NULL;	// New font object
 
-  if (read_os_2(font, &os_2))
-  {
-    // Copy key values from OS/2 table...
-    static const ttf_stretch_t stretches[] =
-    {
-      TTF_STRETCH_ULTRA_CONDENSED,	// ultra-condensed
-      TTF_STRETCH_EXTRA_CONDENSED,	// extra-condensed
-      TTF_STRETCH_CONDENSED,		// condensed
-      TTF_STRETCH_SEMI_CONDENSED,	// semi-condensed
-      TTF_STRETCH_NORMAL,		// normal
-      TTF_STRETCH_SEMI_EXPANDED,	// semi-expanded
-      TTF_STRETCH_EXPANDED,		// expanded
-      TTF_STRETCH_EXTRA_EXPANDED,	// extra-expanded
-      TTF_STRETCH_ULTRA_EXPANDED	// ultra-expanded
-    };
 
-    if (os_2.usWidthClass >= 1 && os_2.usWidthClass <= (int)(sizeof(stretches) / sizeof(stretches[0])))
-      font->stretch = stretches[os_2.usWidthClass - 1];
+  TTF_DEBUG("ttfCreateData(data=%p, datasize=%u, idx=%u, err_cb=%p, err_data=%p)\n", data, (unsigned)datasize, (unsigned)idx, err_cb, err_data);
 
-    font->weight     = (short)os_2.usWeightClass;
-    font->cap_height = os_2.sCapHeight;
-    font->x_height   = os_2.sxHeight;
-  }
-  else
+  // Range check input..
+  if (!data || datasize == 0)
   {
-    // Default key values since there isn't an OS/2 table...
-    TTF_DEBUG("ttfCreate: Unable to read OS/2 table.\n");
-
-    font->weight = 400;
+    errno = EINVAL;
+    return (NULL);
   }
 
-  if (font->cap_height == 0)
-    font->cap_height = font->ascent;
-
-  if (font->x_height == 0)
-    font->x_height = 3 * font->ascent / 5;
+  // Allocate memory...
+  if ((font = (ttf_t *)calloc(1, sizeof(ttf_t))) == NULL)
+    return (NULL);
 
-  // Build a sparse glyph widths table...
-  font->min_char = -1;
+  font->fd       = -1;
+  font->data     = (const unsigned char *)data;
+  font->datasize = datasize;
+  font->idx      = idx;
+  font->err_cb   = err_cb;
+  font->err_data = err_data;
 
-  for (i = 0; i < font->num_cmap; i ++)
+  // Load the font...
+  if (!read_font(font))
   {
-    if (font->cmap[i] >= 0)
-    {
-      int	bin = (int)i / 256,	// Sub-array bin
-		glyph = font->cmap[i];	// Glyph index
-
-      // Update min/max...
-      if (font->min_char < 0)
-        font->min_char = (int)i;
-
-      font->max_char = (int)i;
-
-      // Allocate a sub-array as needed...
-      if (!font->widths[bin])
-        font->widths[bin] = (_ttf_metric_t *)calloc(256, sizeof(_ttf_metric_t));
-
-      // Copy the width of the specified glyph or the last one if we are past
-      // the end of the table...
-      if (glyph >= hhea.numberOfHMetrics)
-	font->widths[bin][i & 255] = widths[hhea.numberOfHMetrics - 1];
-      else
-	font->widths[bin][i & 255] = widths[glyph];
-    }
-
-#ifdef DEBUG
-    if (i >= ' ' && i < 127 && font->widths[0])
-      TTF_DEBUG("ttfCreate: width['%c']=%d(%d)\n", (char)i, font->widths[0][i].width, font->widths[0][i].left_bearing);
-#endif // DEBUG
+    ttfDelete(font);
+    return (NULL);
   }
 
-  // Cleanup and return the font...
-  free(widths);
-
   return (font);
-
-  // If we get here something bad happened...
-  error:
-
-  free(widths);
-  ttfDelete(font);
-
-  return (NULL);
 }
 
 
@@ -915,42 +1044,363 @@ ttfIsFixedPitch(ttf_t *font)		// I - Font
 
 
 //
-// 'copy_name()' - Copy a name string from a font.
+// 'cff_copy_dict()' - Copy a CFF DICT, replacing operator values.
+//
+// Replaced values are always encoded as 32-bit integers so that the size of the
+// copy does not depend on the values.  If "dst" is `NULL`, only the size of the
+// copy is computed.
 //
 
-static char *				// O - Name string or `NULL`
-copy_name(ttf_t    *font,		// I - Font
-          unsigned name_id)		// I - Name identifier
+static size_t				// O - Size of copy or 0 on error
+cff_copy_dict(unsigned char       *dst,	// I - Destination buffer or `NULL`
+              const unsigned char *src,	// I - Source DICT
+              size_t              srclen,// I - Length of source DICT
+              const _ttf_cff_op_t *ops,	// I - Replacement operators
+              size_t              num_ops)// I - Number of replacement operators
 {
-  int			i;		// Looping var
-  _ttf_off_name_t	*name;		// Current name
+  size_t	srcpos = 0,		// Position in source
+		start = 0,		// Start of operands
+		dstlen = 0,		// Length of copy
+		i, j;			// Looping vars
 
 
-  for (i = font->names.num_names, name = font->names.names; i > 0; i --, name ++)
+  while (srcpos < srclen)
   {
-    if (name->name_id == name_id &&
-        ((name->platform_id == TTF_OFF_Mac && name->language_id == TTF_OFF_Mac_USEnglish) ||
-         (name->platform_id == TTF_OFF_Windows && (name->language_id & 0xff) == TTF_OFF_Windows_English)))
+    if (src[srcpos] <= 21)
     {
-      char	temp[1024],	// Temporary string buffer
-		*tempptr,	// Pointer into temporary string
-		*storptr;	// Pointer into storage
-      int	chars,		// Length of string to copy in characters
-		bpc;		// Bytes per character
+      // Operator...
+      unsigned	op = src[srcpos];	// Operator
+      size_t	oplen = 1;		// Length of operator
 
-      if ((unsigned)(name->offset + name->length) > font->names.storage_size)
+      if (op == 12)
       {
-        TTF_DEBUG("copy_name: offset(%d)+length(%d) > storage_size(%d)\n", name->offset, name->length, font->names.storage_size);
-        continue;
+        if (srcpos + 1 >= srclen)
+          return (0);
+
+        op    = 1200 + src[srcpos + 1];
+        oplen = 2;
       }
 
-      if (name->platform_id == TTF_OFF_Windows && name->encoding_id == TTF_OFF_Windows_UCS2)
+      for (i = 0; i < num_ops; i ++)
       {
-        storptr = (char *)font->names.storage + name->offset;
-        chars   = name->length / 2;
-        bpc     = 2;
+        if (ops[i].op == op)
+          break;
       }
-      else if (name->platform_id == TTF_OFF_Windows && name->encoding_id == TTF_OFF_Windows_UCS4)
+
+      if (i < num_ops)
+      {
+        // Write replacement values...
+        for (j = 0; j < ops[i].num_values; j ++, dstlen += 5)
+        {
+          if (dst)
+          {
+            unsigned long v = (unsigned long)ops[i].values[j];
+					// Value
+
+	    dst[dstlen + 0] = 29;
+	    dst[dstlen + 1] = (unsigned char)(v >> 24);
+	    dst[dstlen + 2] = (unsigned char)(v >> 16);
+	    dst[dstlen + 3] = (unsigned char)(v >> 8);
+	    dst[dstlen + 4] = (unsigned char)v;
+          }
+        }
+
+        if (dst)
+          memcpy(dst + dstlen, src + srcpos, oplen);
+
+        dstlen += oplen;
+      }
+      else
+      {
+        // Copy the original operands and operator...
+        if (dst)
+          memcpy(dst + dstlen, src + start, srcpos + oplen - start);
+
+        dstlen += srcpos + oplen - start;
+      }
+
+      srcpos += oplen;
+      start  = srcpos;
+    }
+    else if (src[srcpos] == 28)
+    {
+      srcpos += 3;
+    }
+    else if (src[srcpos] == 29)
+    {
+      srcpos += 5;
+    }
+    else if (src[srcpos] == 30)
+    {
+      // Real number, skip nibbles up to the terminating 0xf...
+      for (srcpos ++; srcpos < srclen; srcpos ++)
+      {
+        if ((src[srcpos] & 0x0f) == 0x0f || (src[srcpos] & 0xf0) == 0xf0)
+          break;
+      }
+
+      srcpos ++;
+    }
+    else if (src[srcpos] >= 32 && src[srcpos] <= 246)
+    {
+      srcpos ++;
+    }
+    else if (src[srcpos] >= 247 && src[srcpos] <= 254)
+    {
+      srcpos += 2;
+    }
+    else
+    {
+      // Reserved...
+      return (0);
+    }
+  }
+
+  return (dstlen);
+}
+
+
+//
+// 'cff_get_dict()' - Get the integer values for an operator in a CFF DICT.
+//
+
+static int				// O - Number of values or -1 if not found
+cff_get_dict(const unsigned char *dict,	// I - DICT data
+             size_t              dictlen,// I - Length of DICT data
+             unsigned            op,	// I - Operator
+             long                *values,// O - Values
+             int                 max_values)
+					// I - Maximum number of values
+{
+  size_t	pos = 0;		// Position in DICT
+  int		num_values = 0;		// Number of values
+  long		value;			// Current value
+
+
+  while (pos < dictlen)
+  {
+    unsigned char b = dict[pos];	// Current byte
+
+    if (b <= 21)
+    {
+      // Operator...
+      unsigned	curop = b;		// Current operator
+
+      pos ++;
+
+      if (b == 12)
+      {
+        if (pos >= dictlen)
+          break;
+
+        curop = 1200 + dict[pos ++];
+      }
+
+      if (curop == op)
+        return (num_values);
+
+      num_values = 0;
+      continue;
+    }
+    else if (b == 28)
+    {
+      if (pos + 3 > dictlen)
+        break;
+
+      value = (short)((dict[pos + 1] << 8) | dict[pos + 2]);
+      pos  += 3;
+    }
+    else if (b == 29)
+    {
+      if (pos + 5 > dictlen)
+        break;
+
+      value = (long)(int)(((unsigned)dict[pos + 1] << 24) | ((unsigned)dict[pos + 2] << 16) | ((unsigned)dict[pos + 3] << 8) | dict[pos + 4]);
+      pos  += 5;
+    }
+    else if (b == 30)
+    {
+      // Real number, not used for offsets...
+      for (pos ++; pos < dictlen; pos ++)
+      {
+        if ((dict[pos] & 0x0f) == 0x0f || (dict[pos] & 0xf0) == 0xf0)
+          break;
+      }
+
+      pos ++;
+      value = 0;
+    }
+    else if (b >= 32 && b <= 246)
+    {
+      value = b - 139;
+      pos ++;
+    }
+    else if (b >= 247 && b <= 250)
+    {
+      if (pos + 2 > dictlen)
+        break;
+
+      value = (b - 247) * 256 + dict[pos + 1] + 108;
+      pos  += 2;
+    }
+    else if (b >= 251 && b <= 254)
+    {
+      if (pos + 2 > dictlen)
+        break;
+
+      value = -(b - 251) * 256 - dict[pos + 1] - 108;
+      pos  += 2;
+    }
+    else
+    {
+      // Reserved...
+      break;
+    }
+
+    if (num_values < max_values)
+      values[num_values] = value;
+
+    num_values ++;
+  }
+
+  return (-1);
+}
+
+
+//
+// 'cff_get_index()' - Get the location of a CFF INDEX.
+//
+
+static bool				// O - `true` on success, `false` on error
+cff_get_index(const unsigned char *cff,	// I - CFF data
+              size_t              cfflen,// I - Length of CFF data
+              size_t              pos,	// I - Offset of INDEX
+              _ttf_cff_index_t    *idx)	// O - INDEX information
+{
+  memset(idx, 0, sizeof(_ttf_cff_index_t));
+
+  if (pos + 2 > cfflen)
+    return (false);
+
+  if ((idx->count = (size_t)((cff[pos] << 8) | cff[pos + 1])) == 0)
+  {
+    // Empty INDEX...
+    idx->end = pos + 2;
+    return (true);
+  }
+
+  if (pos + 3 > cfflen || (idx->offsize = cff[pos + 2]) < 1 || idx->offsize > 4)
+    return (false);
+
+  idx->offsets = pos + 3;
+  idx->data    = idx->offsets + (idx->count + 1) * idx->offsize - 1;
+
+  if (idx->data >= cfflen)
+    return (false);
+
+  idx->end = idx->data + cff_get_offset(cff, idx, idx->count);
+
+  return (idx->end <= cfflen && idx->end > idx->data);
+}
+
+
+//
+// 'cff_get_offset()' - Get an offset from a CFF INDEX.
+//
+
+static size_t				// O - Offset
+cff_get_offset(
+    const unsigned char    *cff,	// I - CFF data
+    const _ttf_cff_index_t *idx,	// I - INDEX information
+    size_t                 n)		// I - Offset number (0 to count)
+{
+  const unsigned char	*ptr = cff + idx->offsets + n * idx->offsize;
+					// Pointer to offset
+  size_t		i,		// Looping var
+			offset = 0;	// Offset
+
+
+  for (i = idx->offsize; i > 0; i --)
+    offset = (offset << 8) | *ptr++;
+
+  return (offset);
+}
+
+
+//
+// 'cff_put_offset()' - Write an offset for a CFF INDEX.
+//
+
+static void
+cff_put_offset(unsigned char *ptr,	// I - Pointer to offset
+               size_t        offsize,	// I - Size of offset
+               size_t        offset)	// I - Offset
+{
+  for (ptr += offsize; offsize > 0; offsize --, offset >>= 8)
+    *(--ptr) = (unsigned char)offset;
+}
+
+
+//
+// 'cff_set_op()' - Set the replacement values for a CFF DICT operator.
+//
+
+static void
+cff_set_op(_ttf_cff_op_t *ops,		// I - Replacement operators
+           size_t        num_ops,	// I - Number of replacement operators
+           unsigned      op,		// I - Operator
+           long          value0,	// I - First value
+           long          value1)	// I - Second value
+{
+  for (; num_ops > 0; num_ops --, ops ++)
+  {
+    if (ops->op == op)
+    {
+      ops->values[0] = value0;
+      ops->values[1] = value1;
+      break;
+    }
+  }
+}
+
+
+//
+// 'copy_name()' - Copy a name string from a font.
+//
+
+static char *				// O - Name string or `NULL`
+copy_name(ttf_t    *font,		// I - Font
+          unsigned name_id)		// I - Name identifier
+{
+  int			i;		// Looping var
+  _ttf_off_name_t	*name;		// Current name
+
+
+  for (i = font->names.num_names, name = font->names.names; i > 0; i --, name ++)
+  {
+    if (name->name_id == name_id &&
+        ((name->platform_id == TTF_OFF_Mac && name->language_id == TTF_OFF_Mac_USEnglish) ||
+         (name->platform_id == TTF_OFF_Windows && (name->language_id & 0xff) == TTF_OFF_Windows_English)))
+    {
+      char	temp[1024],	// Temporary string buffer
+		*tempptr,	// Pointer into temporary string
+		*storptr;	// Pointer into storage
+      int	chars,		// Length of string to copy in characters
+		bpc;		// Bytes per character
+
+      if ((unsigned)(name->offset + name->length) > font->names.storage_size)
+      {
+        TTF_DEBUG("copy_name: offset(%d)+length(%d) > storage_size(%d)\n", name->offset, name->length, font->names.storage_size);
+        continue;
+      }
+
+      if (name->platform_id == TTF_OFF_Windows && name->encoding_id == TTF_OFF_Windows_UCS2)
+      {
+        storptr = (char *)font->names.storage + name->offset;
+        chars   = name->length / 2;
+        bpc     = 2;
+      }
+      else if (name->platform_id == TTF_OFF_Windows && name->encoding_id == TTF_OFF_Windows_UCS4)
       {
         storptr = (char *)font->names.storage + name->offset;
         chars   = name->length / 4;
@@ -1043,6 +1493,79 @@ copy_name(ttf_t    *font,		// I - Font
 }
 
 
+//
+// 'copy_table()' - Copy the contents of a table.
+//
+
+static unsigned char *			// O - Table data or `NULL` on error
+copy_table(ttf_t    *font,		// I - Font
+           unsigned tag,		// I - Table tag
+           size_t   *length)		// O - Length of table
+{
+  unsigned	len;			// Length of table
+  unsigned char	*data;			// Table data
+  size_t	total;			// Total bytes read
+  ssize_t	bytes;			// Bytes read
+
+
+  *length = 0;
+
+  if (font->data)
+  {
+    // Copy directly from memory without changing the current position so that
+    // fonts in memory can be subset by multiple threads...
+    int			i;		// Looping var
+    _ttf_off_dir_t	*current;	// Current table entry
+
+    for (i = font->table.num_entries, current = font->table.entries; i > 0; i --, current ++)
+    {
+      if (current->tag == tag)
+        break;
+    }
+
+    if (i <= 0 || current->offset > font->datasize || current->length > (font->datasize - current->offset))
+    {
+      errorf(font, "Unable to read %c%c%c%c table.", (tag >> 24) & 255, (tag >> 16) & 255, (tag >> 8) & 255, tag & 255);
+      return (NULL);
+    }
+
+    if ((data = (unsigned char *)malloc(current->length ? current->length : 1)) == NULL)
+    {
+      errorf(font, "Unable to allocate memory for %c%c%c%c table.", (tag >> 24) & 255, (tag >> 16) & 255, (tag >> 8) & 255, tag & 255);
+      return (NULL);
+    }
+
+    memcpy(data, font->data + current->offset, current->length);
+    *length = current->length;
+
+    return (data);
+  }
+
+  if ((len = seek_table(font, tag, 0, true)) == 0)
+    return (NULL);
+
+  if ((data = (unsigned char *)malloc(len)) == NULL)
+  {
+    errorf(font, "Unable to allocate memory for %c%c%c%c table.", (tag >> 24) & 255, (tag >> 16) & 255, (tag >> 8) & 255, tag & 255);
+    return (NULL);
+  }
+
+  for (total = 0; total < len; total += (size_t)bytes)
+  {
+    if ((bytes = read_data(font, data + total, len - total)) <= 0)
+    {
+      errorf(font, "Unable to read %c%c%c%c table.", (tag >> 24) & 255, (tag >> 16) & 255, (tag >> 8) & 255, tag & 255);
+      free(data);
+      return (NULL);
+    }
+  }
+
+  *length = len;
+
+  return (data);
+}
+
+
 //
 // 'errorf()' - Show an error message.
 //
@@ -1070,6 +1593,58 @@ errorf(ttf_t      *font,		// I - Font
 }
 
 
+//
+// 'get_checksum()' - Compute the checksum of a table.
+//
+
+static unsigned				// O - Checksum
+get_checksum(const unsigned char *data,	// I - Table data
+             size_t              length)// I - Length of table
+{
+  unsigned	checksum = 0;		// Checksum
+  size_t	i;			// Looping var
+
+
+  // Tables are padded with zeros to a multiple of 4 bytes...
+  for (i = 0; i < length; i ++)
+    checksum += (unsigned)data[i] << (24 - 8 * (i & 3));
+
+  return (checksum);
+}
+
+
+//
+// 'put_ulong()' - Write a 32-bit unsigned integer.
+//
+
+static unsigned char *			// O - Next byte
+put_ulong(unsigned char *ptr,		// I - Pointer to data
+          unsigned      value)		// I - Value
+{
+  *ptr++ = (unsigned char)(value >> 24);
+  *ptr++ = (unsigned char)(value >> 16);
+  *ptr++ = (unsigned char)(value >> 8);
+  *ptr++ = (unsigned char)value;
+
+  return (ptr);
+}
+
+
+//
+// 'put_ushort()' - Write a 16-bit unsigned integer.
+//
+
+static unsigned char *			// O - Next byte
+put_ushort(unsigned char *ptr,		// I - Pointer to data
+           unsigned      value)		// I - Value
+{
+  *ptr++ = (unsigned char)(value >> 8);
+  *ptr++ = (unsigned char)value;
+
+  return (ptr);
+}
+
+
 /*
  * 'read_cmap()' - Read the cmap table, getting the Unicode mapping table.
  */
@@ -1219,7 +1794,7 @@ read_cmap(ttf_t *font)			// I - Font
 	    return (false);
 	  }
 
-          if (read(font->fd, bmap, font->num_cmap) != (ssize_t)font->num_cmap)
+          if (read_data(font, bmap, font->num_cmap) != (ssize_t)font->num_cmap)
           {
 	    errorf(font, "Unable to read cmap table length at offset %u.", coffset);
 	    return (false);
@@ -1579,25 +2154,225 @@ read_cmap(ttf_t *font)			// I - Font
 
 
 //
-// 'read_head()' - Read the head table.
+// 'read_data()' - Read bytes from a font file or data.
 //
 
-static bool				// O - `true` on success, `false` on error
-read_head(ttf_t           *font,	// I - Font
-	  _ttf_off_head_t *head)	// O - head table data
+static ssize_t				// O - Number of bytes read or -1 on error
+read_data(ttf_t  *font,			// I - Font
+          void   *buffer,		// I - Buffer
+          size_t bytes)			// I - Number of bytes to read
 {
-  memset(head, 0, sizeof(_ttf_off_head_t));
+  if (font->data)
+  {
+    // Copy from memory...
+    if (bytes > (font->datasize - font->datapos))
+      bytes = font->datasize - font->datapos;
 
-  if (seek_table(font, TTF_OFF_head, 0, true) == 0)
-    return (false);
+    memcpy(buffer, font->data + font->datapos, bytes);
+    font->datapos += bytes;
 
-  /* majorVersion */       read_ushort(font);
-  /* minorVersion */       read_ushort(font);
-  /* fontRevision */       read_ulong(font);
-  /* checkSumAdjustment */ read_ulong(font);
-  /* magicNumber */        read_ulong(font);
-  /* flags */              read_ushort(font);
-  head->unitsPerEm       = (unsigned short)read_ushort(font);
+    return ((ssize_t)bytes);
+  }
+  else
+  {
+    // Read from the file...
+    return (read(font->fd, buffer, bytes));
+  }
+}
+
+
+//
+// 'read_font()' - Read the tables and metrics for a font.
+//
+
+static bool				// O - `true` on success, `false` on error
+read_font(ttf_t *font)			// I - Font
+{
+  size_t		i;		// Looping var
+  _ttf_metric_t		*widths = NULL;	// Glyph metrics
+  _ttf_off_head_t	head;		// head table
+  _ttf_off_hhea_t	hhea;		// hhea table
+  _ttf_off_os_2_t	os_2;		// OS/2 table
+  _ttf_off_post_t	post;		// PostScript table
+
+
+  // Read the table of contents and the identifying names...
+  if (!read_table(font))
+    goto error;
+
+  TTF_DEBUG("ttfCreate: num_entries=%d\n", font->table.num_entries);
+
+  if (!read_names(font))
+    goto error;
+
+  TTF_DEBUG("ttfCreate: num_names=%d\n", font->names.num_names);
+
+  // Copy key font meta data strings...
+  font->copyright       = copy_name(font, TTF_OFF_Copyright);
+  font->family          = copy_name(font, TTF_OFF_FontFamily);
+  font->postscript_name = copy_name(font, TTF_OFF_PostScriptName);
+  font->version         = copy_name(font, TTF_OFF_FontVersion);
+
+  if (read_post(font, &post))
+  {
+    font->italic_angle = post.italicAngle;
+    font->is_fixed     = post.isFixedPitch != 0;
+  }
+
+  TTF_DEBUG("ttfCreate: copyright=\"%s\"\n", font->copyright);
+  TTF_DEBUG("ttfCreate: family=\"%s\"\n", font->family);
+  TTF_DEBUG("ttfCreate: postscript_name=\"%s\"\n", font->postscript_name);
+  TTF_DEBUG("ttfCreate: version=\"%s\"\n", font->version);
+  TTF_DEBUG("ttfCreate: italic_angle=%g\n", font->italic_angle);
+  TTF_DEBUG("ttfCreate: is_fixed=%s\n", font->is_fixed ? "true" : "false");
+
+  if (!read_cmap(font))
+    goto error;
+
+  if (!read_head(font, &head))
+    goto error;
+
+  font->units = (float)head.unitsPerEm;
+  font->x_max = head.xMax;
+  font->x_min = head.xMin;
+  font->y_max = head.yMax;
+  font->y_min = head.yMin;
+
+  if (head.macStyle & TTF_OFF_macStyle_Italic)
+  {
+    if (font->postscript_name && strstr(font->postscript_name, "Oblique"))
+      font->style = TTF_STYLE_OBLIQUE;
+    else
+      font->style = TTF_STYLE_ITALIC;
+  }
+  else
+    font->style = TTF_STYLE_NORMAL;
+
+  if (!read_hhea(font, &hhea))
+    goto error;
+
+  font->ascent  = hhea.ascender;
+  font->descent = hhea.descender;
+
+  if ((font->num_glyphs = read_maxp(font)) < 0)
+    goto error;
+
+  if (hhea.numberOfHMetrics > 0)
+  {
+    if ((widths = read_hmtx(font, &hhea)) == NULL)
+      goto error;
+  }
+  else
+  {
+    errorf(font, "Number of horizontal metrics is 0.");
+    goto error;
+  }
+
+  if (read_os_2(font, &os_2))
+  {
+    // Copy key values from OS/2 table...
+    static const ttf_stretch_t stretches[] =
+    {
+      TTF_STRETCH_ULTRA_CONDENSED,	// ultra-condensed
+      TTF_STRETCH_EXTRA_CONDENSED,	// extra-condensed
+      TTF_STRETCH_CONDENSED,		// condensed
+      TTF_STRETCH_SEMI_CONDENSED,	// semi-condensed
+      TTF_STRETCH_NORMAL,		// normal
+      TTF_STRETCH_SEMI_EXPANDED,	// semi-expanded
+      TTF_STRETCH_EXPANDED,		// expanded
+      TTF_STRETCH_EXTRA_EXPANDED,	// extra-expanded
+      TTF_STRETCH_ULTRA_EXPANDED	// ultra-expanded
+    };
+
+    if (os_2.usWidthClass >= 1 && os_2.usWidthClass <= (int)(sizeof(stretches) / sizeof(stretches[0])))
+      font->stretch = stretches[os_2.usWidthClass - 1];
+
+    font->weight     = (short)os_2.usWeightClass;
+    font->cap_height = os_2.sCapHeight;
+    font->x_height   = os_2.sxHeight;
+  }
+  else
+  {
+    // Default key values since there isn't an OS/2 table...
+    TTF_DEBUG("ttfCreate: Unable to read OS/2 table.\n");
+
+    font->weight = 400;
+  }
+
+  if (font->cap_height == 0)
+    font->cap_height = font->ascent;
+
+  if (font->x_height == 0)
+    font->x_height = 3 * font->ascent / 5;
+
+  // Build a sparse glyph widths table...
+  font->min_char = -1;
+
+  for (i = 0; i < font->num_cmap; i ++)
+  {
+    if (font->cmap[i] >= 0)
+    {
+      int	bin = (int)i / 256,	// Sub-array bin
+		glyph = font->cmap[i];	// Glyph index
+
+      // Update min/max...
+      if (font->min_char < 0)
+        font->min_char = (int)i;
+
+      font->max_char = (int)i;
+
+      // Allocate a sub-array as needed...
+      if (!font->widths[bin])
+        font->widths[bin] = (_ttf_metric_t *)calloc(256, sizeof(_ttf_metric_t));
+
+      // Copy the width of the specified glyph or the last one if we are past
+      // the end of the table...
+      if (glyph >= hhea.numberOfHMetrics)
+	font->widths[bin][i & 255] = widths[hhea.numberOfHMetrics - 1];
+      else
+	font->widths[bin][i & 255] = widths[glyph];
+    }
+
+#ifdef DEBUG
+    if (i >= ' ' && i < 127 && font->widths[0])
+      TTF_DEBUG("ttfCreate: width['%c']=%d(%d)\n", (char)i, font->widths[0][i].width, font->widths[0][i].left_bearing);
+#endif // DEBUG
+  }
+
+  // Cleanup and return...
+  free(widths);
+
+  return (true);
+
+  // If we get here something bad happened...
+  error:
+
+  free(widths);
+
+  return (false);
+}
+
+
+//
+// 'read_head()' - Read the head table.
+//
+
+static bool				// O - `true` on success, `false` on error
+read_head(ttf_t           *font,	// I - Font
+	  _ttf_off_head_t *head)	// O - head table data
+{
+  memset(head, 0, sizeof(_ttf_off_head_t));
+
+  if (seek_table(font, TTF_OFF_head, 0, true) == 0)
+    return (false);
+
+  /* majorVersion */       read_ushort(font);
+  /* minorVersion */       read_ushort(font);
+  /* fontRevision */       read_ulong(font);
+  /* checkSumAdjustment */ read_ulong(font);
+  /* magicNumber */        read_ulong(font);
+  /* flags */              read_ushort(font);
+  head->unitsPerEm       = (unsigned short)read_ushort(font);
   /* created */            read_ulong(font); read_ulong(font);
   /* modified */           read_ulong(font); read_ulong(font);
   head->xMin             = (short)read_short(font);
@@ -1774,7 +2549,7 @@ read_names(ttf_t *font)			// I - Font
 
   length -= (unsigned)offset;
 
-  if (read(font->fd, font->names.storage, length) < 0)
+  if (read_data(font, font->names.storage, length) < 0)
   {
     errorf(font, "Unable to read name table: %s", strerror(errno));
     return (false);
@@ -1823,7 +2598,7 @@ read_os_2(ttf_t           *font,	// I - Font
   /* yStrikeoutOffset */    read_short(font);
   /* sFamilyClass */        read_short(font);
   /* panose[10] */
-  if (read(font->fd, panose, sizeof(panose)) != (ssize_t)sizeof(panose))
+  if (read_data(font, panose, sizeof(panose)) != (ssize_t)sizeof(panose))
     return (false);
   /* ulUnicodeRange1 */     read_ulong(font);
   /* ulUnicodeRange2 */     read_ulong(font);
@@ -1885,7 +2660,7 @@ read_short(ttf_t *font)			// I - Font
   unsigned char	buffer[2];		// Read buffer
 
 
-  if (read(font->fd, buffer, sizeof(buffer)) != sizeof(buffer))
+  if (read_data(font, buffer, sizeof(buffer)) != sizeof(buffer))
     return (EOF);
   else if (buffer[0] & 0x80)
     return (((buffer[0] << 8) | buffer[1]) - 65536);
@@ -1958,7 +2733,7 @@ read_table(ttf_t  *font)		// I - Font
 
     TTF_DEBUG("read_table: Offset for font %u is %u.\n", (unsigned)font->idx, temp);
 
-    if (lseek(font->fd, temp + 4, SEEK_SET) < 0)
+    if (seek_data(font, temp + 4) < 0)
     {
       errorf(font, "Unable to seek to font %u: %s", (unsigned)font->idx, strerror(errno));
       return (false);
@@ -2034,7 +2809,7 @@ read_ulong(ttf_t *font)			// I - Font
   unsigned char	buffer[4];		// Read buffer
 
 
-  if (read(font->fd, buffer, sizeof(buffer)) != sizeof(buffer))
+  if (read_data(font, buffer, sizeof(buffer)) != sizeof(buffer))
     return ((unsigned)EOF);
   else
     return ((unsigned)((buffer[0] << 24) | (buffer[1] << 16) | (buffer[2] << 8) | buffer[3]));
@@ -2051,13 +2826,42 @@ read_ushort(ttf_t *font)		// I - Font
   unsigned char	buffer[2];		// Read buffer
 
 
-  if (read(font->fd, buffer, sizeof(buffer)) != sizeof(buffer))
+  if (read_data(font, buffer, sizeof(buffer)) != sizeof(buffer))
     return (EOF);
   else
     return ((buffer[0] << 8) | buffer[1]);
 }
 
 
+//
+// 'seek_data()' - Seek to a position in a font file or data.
+//
+
+static off_t				// O - New position or -1 on error
+seek_data(ttf_t *font,			// I - Font
+          off_t offset)			// I - Position from start of font
+{
+  if (font->data)
+  {
+    // Set the position in memory...
+    if (offset < 0 || (size_t)offset > font->datasize)
+    {
+      errno = EINVAL;
+      return (-1);
+    }
+
+    font->datapos = (size_t)offset;
+
+    return (offset);
+  }
+  else
+  {
+    // Seek in the file...
+    return (lseek(font->fd, offset, SEEK_SET));
+  }
+}
+
+
 //
 // 'seek_table()' - Seek to a specific table in a font.
 //
@@ -2078,7 +2882,7 @@ seek_table(ttf_t    *font,		// I - Font
     if (current->tag == tag)
     {
       // Found it, seek and return...
-      if (lseek(font->fd, current->offset + offset, SEEK_SET) == (current->offset + offset))
+      if (seek_data(font, current->offset + offset) == (current->offset + offset))
       {
         // Successful seek...
         return (current->length - offset);
@@ -2098,3 +2902,712 @@ seek_table(ttf_t    *font,		// I - Font
 
   return (0);
 }
+
+
+//
+// 'subset_cff()' - Subset the glyphs in a CFF table.
+//
+// Unused glyphs are replaced by an "endchar" charstring.  The Top DICT, Font
+// DICTs, and Private DICTs are rewritten to point to the new locations of the
+// charset, encoding, FDSelect, CharStrings, FDArray, and Private data.  Fonts
+// that cannot be subset (CFF2, multiple fonts, etc.) are left unchanged.
+//
+
+static bool				// O - `true` on success, `false` on error
+subset_cff(ttf_t               *font,	// I - Font
+           _ttf_table_data_t   *cff,	// I - CFF table
+           const unsigned char *used,	// I - Glyphs to keep
+           size_t              num_glyphs)
+					// I - Number of glyphs
+{
+  const unsigned char *c = cff->data;	// CFF data
+  size_t	clen = cff->length;	// Length of CFF data
+  _ttf_cff_index_t names,		// Name INDEX
+		top,			// Top DICT INDEX
+		strings,		// String INDEX
+		gsubrs,			// Global Subr INDEX
+		charstrings,		// CharStrings INDEX
+		fdarray;		// FDArray INDEX
+  const unsigned char *topdict;		// Top DICT
+  size_t	toplen,			// Length of Top DICT
+		newtoplen,		// Length of new Top DICT
+		i,			// Looping var
+		pos,			// Position in new CFF data
+		charset_pos = 0,	// Offset of charset
+		charset_len = 0,	// Length of charset
+		encoding_pos = 0,	// Offset of encoding
+		encoding_len = 0,	// Length of encoding
+		fdselect_pos = 0,	// Offset of FDSelect
+		fdselect_len = 0,	// Length of FDSelect
+		cs_count,		// Number of charstrings
+		cs_datalen,		// Length of charstring data
+		cs_offsize,		// Size of charstring offsets
+		fd_datalen,		// Length of Font DICT data
+		num_privates = 0;	// Number of Private DICTs
+  long		values[2];		// DICT values
+  _ttf_cff_op_t	top_ops[6];		// Top DICT replacements
+  size_t	num_top_ops = 0;	// Number of Top DICT replacements
+  _ttf_cff_private_t *privates = NULL;	// Private DICTs
+  bool		is_cid;			// CID-keyed font?
+  unsigned char	*newcff = NULL,		// New CFF data
+		*ptr;			// Pointer into new CFF data
+
+
+  // Find the standard INDEXes and Top DICT...
+  if (clen < 4 || c[0] != 1)
+    return (true);
+
+  if (!cff_get_index(c, clen, c[2], &names) || !cff_get_index(c, clen, names.end, &top) || !cff_get_index(c, clen, top.end, &strings) || !cff_get_index(c, clen, strings.end, &gsubrs) || top.count != 1)
+    return (true);
+
+  topdict = c + top.data + cff_get_offset(c, &top, 0);
+  toplen  = cff_get_offset(c, &top, 1) - cff_get_offset(c, &top, 0);
+
+  if (topdict + toplen > c + clen)
+    return (true);
+
+  // CharStrings...
+  if (cff_get_dict(topdict, toplen, 17, values, 2) != 1 || values[0] <= 0 || !cff_get_index(c, clen, (size_t)values[0], &charstrings) || charstrings.count == 0)
+    return (true);
+
+  cs_count = charstrings.count;
+
+  top_ops[num_top_ops].op         = 17;
+  top_ops[num_top_ops].num_values = 1;
+  num_top_ops ++;
+
+  // charset...
+  if (cff_get_dict(topdict, toplen, 15, values, 2) == 1 && values[0] > 2)
+  {
+    size_t	p = (size_t)values[0],	// Position in charset
+		remaining = cs_count - 1;
+					// Remaining glyphs
+
+    if (p >= clen)
+      return (true);
+
+    charset_pos = p;
+
+    if (c[p] == 0)
+    {
+      p         += 1 + 2 * remaining;
+      remaining = 0;
+    }
+    else if (c[p] == 1 || c[p] == 2)
+    {
+      unsigned char format = c[p ++];	// charset format
+
+      while (remaining > 0 && p + (format == 1 ? 3 : 4) <= clen)
+      {
+        size_t nleft = format == 1 ? c[p + 2] : (size_t)((c[p + 2] << 8) | c[p + 3]);
+					// Glyphs left in range
+
+        p += format == 1 ? 3 : 4;
+
+        if (nleft + 1 >= remaining)
+          remaining = 0;
+        else
+          remaining -= nleft + 1;
+      }
+    }
+    else
+    {
+      return (true);
+    }
+
+    if (p > clen || remaining > 0)
+      return (true);
+
+    charset_len = p - charset_pos;
+
+    top_ops[num_top_ops].op         = 15;
+    top_ops[num_top_ops].num_values = 1;
+    num_top_ops ++;
+  }
+
+  // Encoding...
+  if (cff_get_dict(topdict, toplen, 16, values, 2) == 1 && values[0] > 1)
+  {
+    size_t	p = (size_t)values[0];	// Position in encoding
+
+    if (p + 2 > clen)
+      return (true);
+
+    encoding_pos = p;
+
+    if ((c[p] & 0x7f) == 0)
+      encoding_len = 2 + c[p + 1];
+    else if ((c[p] & 0x7f) == 1)
+      encoding_len = 2 + 2 * c[p + 1];
+    else
+      return (true);
+
+    if ((c[p] & 0x80) && p + encoding_len < clen)
+      encoding_len += 1 + 3 * c[p + encoding_len];
+
+    if (p + encoding_len > clen)
+      return (true);
+
+    top_ops[num_top_ops].op         = 16;
+    top_ops[num_top_ops].num_values = 1;
+    num_top_ops ++;
+  }
+
+  // Private DICT(s)...
+  memset(&fdarray, 0, sizeof(fdarray));
+
+  is_cid = cff_get_dict(topdict, toplen, 1230, values, 2) >= 0;
+
+  if (is_cid)
+  {
+    // CID-keyed font with FDArray and FDSelect...
+    if (cff_get_dict(topdict, toplen, 1236, values, 2) != 1 || values[0] <= 0 || !cff_get_index(c, clen, (size_t)values[0], &fdarray) || fdarray.count == 0)
+      return (true);
+
+    if (cff_get_dict(topdict, toplen, 1237, values, 2) != 1 || values[0] <= 0 || (size_t)values[0] + 3 > clen)
+      return (true);
+
+    fdselect_pos = (size_t)values[0];
+
+    if (c[fdselect_pos] == 0)
+      fdselect_len = 1 + cs_count;
+    else if (c[fdselect_pos] == 3)
+      fdselect_len = 5 + 3 * (size_t)((c[fdselect_pos + 1] << 8) | c[fdselect_pos + 2]);
+    else
+      return (true);
+
+    if (fdselect_pos + fdselect_len > clen)
+      return (true);
+
+    top_ops[num_top_ops].op         = 1236;
+    top_ops[num_top_ops].num_values = 1;
+    num_top_ops ++;
+
+    top_ops[num_top_ops].op         = 1237;
+    top_ops[num_top_ops].num_values = 1;
+    num_top_ops ++;
+
+    num_privates = fdarray.count;
+  }
+  else if (cff_get_dict(topdict, toplen, 18, values, 2) == 2)
+  {
+    top_ops[num_top_ops].op         = 18;
+    top_ops[num_top_ops].num_values = 2;
+    num_top_ops ++;
+
+    num_privates = 1;
+  }
+
+  if (num_privates > 0 && (privates = (_ttf_cff_private_t *)calloc(num_privates, sizeof(_ttf_cff_private_t))) == NULL)
+  {
+    errorf(font, "Unable to allocate memory for CFF subset.");
+    return (false);
+  }
+
+  for (i = 0; i < num_privates; i ++)
+  {
+    _ttf_cff_private_t	*priv = privates + i;
+					// Private DICT
+    _ttf_cff_index_t	subrs;		// Local Subr INDEX
+
+    if (is_cid)
+    {
+      priv->fd    = c + fdarray.data + cff_get_offset(c, &fdarray, i);
+      priv->fdlen = cff_get_offset(c, &fdarray, i + 1) - cff_get_offset(c, &fdarray, i);
+
+      if (priv->fd + priv->fdlen > c + clen || cff_get_dict(priv->fd, priv->fdlen, 18, values, 2) != 2)
+        goto unchanged;
+    }
+    else
+    {
+      cff_get_dict(topdict, toplen, 18, values, 2);
+    }
+
+    if (values[0] < 0 || values[1] <= 0 || (size_t)(values[0] + values[1]) > clen)
+      goto unchanged;
+
+    priv->dict    = c + values[1];
+    priv->dictlen = (size_t)values[0];
+
+    if (cff_get_dict(priv->dict, priv->dictlen, 19, values, 2) == 1 && values[0] > 0)
+    {
+      // Local subroutines follow the Private DICT...
+      if (!cff_get_index(c, clen, (size_t)(priv->dict - c) + (size_t)values[0], &subrs))
+        goto unchanged;
+
+      priv->subrs    = c + (size_t)(priv->dict - c) + (size_t)values[0];
+      priv->subrslen = subrs.end - (size_t)(priv->subrs - c);
+      priv->op.op         = 19;
+      priv->op.num_values = 1;
+      priv->op.values[0]  = 0;
+    }
+
+    if ((priv->newdictlen = cff_copy_dict(NULL, priv->dict, priv->dictlen, &priv->op, priv->subrs ? 1 : 0)) == 0 && priv->dictlen > 0)
+      goto unchanged;
+
+    priv->op.values[0] = (long)priv->newdictlen;
+  }
+
+  // Compute the layout of the new CFF data...
+  if ((newtoplen = cff_copy_dict(NULL, topdict, toplen, top_ops, num_top_ops)) == 0)
+    goto unchanged;
+
+  pos = names.end + 11 + newtoplen + (gsubrs.end - top.end);
+
+  if (charset_len)
+  {
+    cff_set_op(top_ops, num_top_ops, 15, (long)pos, 0);
+    pos += charset_len;
+  }
+
+  if (encoding_len)
+  {
+    cff_set_op(top_ops, num_top_ops, 16, (long)pos, 0);
+    pos += encoding_len;
+  }
+
+  for (i = 0, cs_datalen = 0; i < cs_count; i ++)
+  {
+    if (i < num_glyphs && used[i])
+      cs_datalen += cff_get_offset(c, &charstrings, i + 1) - cff_get_offset(c, &charstrings, i);
+    else
+      cs_datalen ++;
+  }
+
+  for (cs_offsize = 1; cs_offsize < 4 && (cs_datalen + 1) >> (8 * cs_offsize); cs_offsize ++);
+
+  if (is_cid)
+  {
+    // FDSelect, CharStrings, then FDArray...
+    cff_set_op(top_ops, num_top_ops, 1237, (long)pos, 0);
+    pos += fdselect_len;
+
+    cff_set_op(top_ops, num_top_ops, 17, (long)pos, 0);
+    pos += 3 + (cs_count + 1) * cs_offsize + cs_datalen;
+
+    for (i = 0, fd_datalen = 0; i < num_privates; i ++)
+    {
+      privates[i].fdop.op         = 18;
+      privates[i].fdop.num_values = 2;
+
+      if ((privates[i].newfdlen = cff_copy_dict(NULL, privates[i].fd, privates[i].fdlen, &privates[i].fdop, 1)) == 0)
+        goto unchanged;
+
+      fd_datalen += privates[i].newfdlen;
+    }
+
+    cff_set_op(top_ops, num_top_ops, 1236, (long)pos, 0);
+    pos += 3 + (num_privates + 1) * 4 + fd_datalen;
+  }
+  else
+  {
+    cff_set_op(top_ops, num_top_ops, 17, (long)pos, 0);
+    pos += 3 + (cs_count + 1) * cs_offsize + cs_datalen;
+  }
+
+  for (i = 0; i < num_privates; i ++)
+  {
+    privates[i].newpos = pos;
+    pos += privates[i].newdictlen + privates[i].subrslen;
+
+    if (is_cid)
+    {
+      privates[i].fdop.values[0] = (long)privates[i].newdictlen;
+      privates[i].fdop.values[1] = (long)privates[i].newpos;
+    }
+    else
+    {
+      cff_set_op(top_ops, num_top_ops, 18, (long)privates[i].newdictlen, (long)privates[i].newpos);
+    }
+  }
+
+  // Write the new CFF data...
+  if ((newcff = (unsigned char *)malloc(pos)) == NULL)
+  {
+    errorf(font, "Unable to allocate memory for CFF subset.");
+    free(privates);
+    return (false);
+  }
+
+  // Header and Name INDEX...
+  memcpy(newcff, c, names.end);
+  ptr = newcff + names.end;
+
+  // Top DICT INDEX...
+  *ptr++ = 0;
+  *ptr++ = 1;
+  *ptr++ = 4;
+  cff_put_offset(ptr, 4, 1);
+  cff_put_offset(ptr + 4, 4, 1 + newtoplen);
+  ptr += 8;
+  ptr += cff_copy_dict(ptr, topdict, toplen, top_ops, num_top_ops);
+
+  // String and Global Subr INDEXes...
+  memcpy(ptr, c + top.end, gsubrs.end - top.end);
+  ptr += gsubrs.end - top.end;
+
+  // charset, Encoding, and FDSelect...
+  if (charset_len)
+  {
+    memcpy(ptr, c + charset_pos, charset_len);
+    ptr += charset_len;
+  }
+
+  if (encoding_len)
+  {
+    memcpy(ptr, c + encoding_pos, encoding_len);
+    ptr += encoding_len;
+  }
+
+  if (fdselect_len)
+  {
+    memcpy(ptr, c + fdselect_pos, fdselect_len);
+    ptr += fdselect_len;
+  }
+
+  // CharStrings INDEX...
+  {
+    unsigned char *offptr;		// Pointer to offsets
+    size_t	offset = 1;		// Current offset
+
+    *ptr++ = (unsigned char)(cs_count >> 8);
+    *ptr++ = (unsigned char)cs_count;
+    *ptr++ = (unsigned char)cs_offsize;
+    offptr = ptr;
+    ptr   += (cs_count + 1) * cs_offsize;
+
+    for (i = 0; i < cs_count; i ++, offptr += cs_offsize)
+    {
+      cff_put_offset(offptr, cs_offsize, offset);
+
+      if (i < num_glyphs && used[i])
+      {
+        size_t	start = cff_get_offset(c, &charstrings, i),
+					// Start of charstring
+		len = cff_get_offset(c, &charstrings, i + 1) - start;
+					// Length of charstring
+
+        memcpy(ptr, c + charstrings.data + start, len);
+        ptr    += len;
+        offset += len;
+      }
+      else
+      {
+        *ptr++ = 14;			// endchar
+        offset ++;
+      }
+    }
+
+    cff_put_offset(offptr, cs_offsize, offset);
+  }
+
+  // FDArray INDEX...
+  if (is_cid)
+  {
+    unsigned char *offptr;		// Pointer to offsets
+    size_t	offset = 1;		// Current offset
+
+    *ptr++ = (unsigned char)(num_privates >> 8);
+    *ptr++ = (unsigned char)num_privates;
+    *ptr++ = 4;
+    offptr = ptr;
+    ptr   += (num_privates + 1) * 4;
+
+    for (i = 0; i < num_privates; i ++, offptr += 4)
+    {
+      cff_put_offset(offptr, 4, offset);
+      ptr    += cff_copy_dict(ptr, privates[i].fd, privates[i].fdlen, &privates[i].fdop, 1);
+      offset += privates[i].newfdlen;
+    }
+
+    cff_put_offset(offptr, 4, offset);
+  }
+
+  // Private DICTs and local subroutines...
+  for (i = 0; i < num_privates; i ++)
+  {
+    ptr += cff_copy_dict(ptr, privates[i].dict, privates[i].dictlen, &privates[i].op, privates[i].subrs ? 1 : 0);
+
+    if (privates[i].subrslen)
+    {
+      memcpy(ptr, privates[i].subrs, privates[i].subrslen);
+      ptr += privates[i].subrslen;
+    }
+  }
+
+  free(privates);
+
+  if ((size_t)(ptr - newcff) != pos)
+  {
+    // Layout doesn't match, keep the original data...
+    free(newcff);
+    return (true);
+  }
+
+  free(cff->data);
+
+  cff->data   = newcff;
+  cff->length = pos;
+
+  return (true);
+
+  // If we get here the font uses something we don't support, so leave it
+  // as is...
+  unchanged:
+
+  free(privates);
+
+  return (true);
+}
+
+
+
+
+//
+// 'subset_glyf()' - Subset the glyphs in the glyf and loca tables.
+//
+// Unused glyphs are removed from the glyf table and the loca table is
+// rewritten using long offsets.
+//
+
+static bool				// O - `true` on success, `false` on error
+subset_glyf(ttf_t             *font,	// I - Font
+            _ttf_table_data_t *head,	// I - head table
+            _ttf_table_data_t *loca,	// I - loca table
+            _ttf_table_data_t *glyf,	// I - glyf table
+            unsigned char     *used,	// I - Glyphs to keep
+            size_t            num_glyphs)
+					// I - Number of glyphs
+{
+  bool		long_loca;		// Long loca offsets?
+  size_t	*offsets = NULL,	// Glyph offsets
+		*stack = NULL,		// Glyphs to check for components
+		num_stack = 0,		// Number of glyphs to check
+		i,			// Looping var
+		glyflen;		// Length of new glyf table
+  unsigned char	*newglyf = NULL,	// New glyf table
+		*newloca = NULL,	// New loca table
+		*ptr;			// Pointer into tables
+
+
+  // Get the glyph offsets...
+  long_loca = head->data[51] != 0;
+
+  if (loca->length < (num_glyphs + 1) * (long_loca ? 4 : 2))
+  {
+    errorf(font, "loca table is too short.");
+    return (false);
+  }
+
+  if ((offsets = (size_t *)calloc(num_glyphs + 1, sizeof(size_t))) == NULL || (stack = (size_t *)calloc(num_glyphs, sizeof(size_t))) == NULL)
+    goto error;
+
+  for (i = 0, ptr = loca->data; i <= num_glyphs; i ++)
+  {
+    if (long_loca)
+    {
+      offsets[i] = ((size_t)ptr[0] << 24) | ((size_t)ptr[1] << 16) | ((size_t)ptr[2] << 8) | ptr[3];
+      ptr += 4;
+    }
+    else
+    {
+      offsets[i] = 2 * (((size_t)ptr[0] << 8) | ptr[1]);
+      ptr += 2;
+    }
+
+    if (offsets[i] > glyf->length || (i > 0 && offsets[i] < offsets[i - 1]))
+    {
+      errorf(font, "Bad glyph offset in loca table.");
+      goto error;
+    }
+  }
+
+  // Add any glyphs used by composite glyphs...
+  for (i = 0; i < num_glyphs; i ++)
+  {
+    if (used[i])
+      stack[num_stack ++] = i;
+  }
+
+  while (num_stack > 0)
+  {
+    size_t	glyph = stack[-- num_stack],
+					// Current glyph
+		start = offsets[glyph],	// Start of glyph data
+		end = offsets[glyph + 1];
+					// End of glyph data
+    unsigned	flags;			// Component flags
+
+    if ((end - start) < 10 || !(glyf->data[start] & 0x80))
+      continue;				// Not a composite glyph
+
+    for (ptr = glyf->data + start + 10; ptr + 4 <= glyf->data + end; )
+    {
+      size_t	component;		// Component glyph
+
+      flags     = (unsigned)((ptr[0] << 8) | ptr[1]);
+      component = (size_t)((ptr[2] << 8) | ptr[3]);
+      ptr       += 4;
+
+      if (component < num_glyphs && !used[component])
+      {
+        used[component]       = 1;
+        stack[num_stack ++] = component;
+      }
+
+      ptr += (flags & 0x0001) ? 4 : 2;	// ARG_1_AND_2_ARE_WORDS
+
+      if (flags & 0x0008)		// WE_HAVE_A_SCALE
+        ptr += 2;
+      else if (flags & 0x0040)		// WE_HAVE_AN_X_AND_Y_SCALE
+        ptr += 4;
+      else if (flags & 0x0080)		// WE_HAVE_A_TWO_BY_TWO
+        ptr += 8;
+
+      if (!(flags & 0x0020))		// MORE_COMPONENTS
+        break;
+    }
+  }
+
+  // Copy the glyphs we are keeping...
+  for (i = 0, glyflen = 0; i < num_glyphs; i ++)
+  {
+    if (used[i])
+      glyflen += (offsets[i + 1] - offsets[i] + 3) & (size_t)~3;
+  }
+
+  if ((newglyf = (unsigned char *)calloc(1, glyflen ? glyflen : 1)) == NULL || (newloca = (unsigned char *)malloc(4 * (num_glyphs + 1))) == NULL)
+    goto error;
+
+  for (i = 0, glyflen = 0, ptr = newloca; i <= num_glyphs; i ++, ptr += 4)
+  {
+    ptr[0] = (unsigned char)(glyflen >> 24);
+    ptr[1] = (unsigned char)(glyflen >> 16);
+    ptr[2] = (unsigned char)(glyflen >> 8);
+    ptr[3] = (unsigned char)glyflen;
+
+    if (i < num_glyphs && used[i])
+    {
+      memcpy(newglyf + glyflen, glyf->data + offsets[i], offsets[i + 1] - offsets[i]);
+      glyflen += (offsets[i + 1] - offsets[i] + 3) & (size_t)~3;
+    }
+  }
+
+  free(glyf->data);
+  glyf->data   = newglyf;
+  glyf->length = glyflen;
+
+  free(loca->data);
+  loca->data   = newloca;
+  loca->length = 4 * (num_glyphs + 1);
+
+  // indexToLocFormat = 1 for long offsets...
+  head->data[50] = 0;
+  head->data[51] = 1;
+
+  free(offsets);
+  free(stack);
+
+  return (true);
+
+  // If we get here something bad happened...
+  error:
+
+  if (!newloca)
+    errorf(font, "Unable to allocate memory for glyph subset.");
+
+  free(offsets);
+  free(stack);
+  free(newglyf);
+  free(newloca);
+
+  return (false);
+}
+
+
+//
+// 'write_sfnt()' - Write a font file from a list of tables.
+//
+
+static unsigned char *			// O - Font data or `NULL` on error
+write_sfnt(ttf_t             *font,	// I - Font
+           unsigned          version,	// I - sfnt version
+           _ttf_table_data_t *tables,	// I - Tables
+           size_t            num_tables,// I - Number of tables
+           _ttf_table_data_t *head,	// I - head table
+           size_t            *datalen)	// O - Length of font data
+{
+  unsigned char	*data,			// Font data
+		*ptr;			// Pointer into font data
+  size_t	order[TTF_SUBSET_MAX_TABLES],
+					// Table order
+		i, j,			// Looping vars
+		length,			// Length of font data
+		offset,			// Offset of current table
+		head_offset = 0;	// Offset of head table
+  unsigned	search_range,		// Search range
+		entry_selector,		// Entry selector
+		checksum;		// Checksum
+
+
+  // Tables need to be sorted by tag...
+  for (i = 0; i < num_tables; i ++)
+  {
+    for (j = i; j > 0 && tables[order[j - 1]].tag > tables[i].tag; j --)
+      order[j] = order[j - 1];
+
+    order[j] = i;
+  }
+
+  // Allocate memory for the font...
+  for (i = 0, length = 12 + 16 * num_tables; i < num_tables; i ++)
+    length += (tables[i].length + 3) & (size_t)~3;
+
+  if ((data = (unsigned char *)calloc(1, length)) == NULL)
+  {
+    errorf(font, "Unable to allocate memory for font.");
+    return (NULL);
+  }
+
+  // The checkSumAdjustment is computed over the whole font...
+  memset(head->data + 8, 0, 4);
+
+  for (search_range = 1, entry_selector = 0; 2 * search_range <= num_tables; search_range *= 2, entry_selector ++);
+
+  search_range *= 16;
+
+  // Write the offset table...
+  ptr    = data;
+  ptr    = put_ulong(ptr, version);
+  ptr    = put_ushort(ptr, (unsigned)num_tables);
+  ptr    = put_ushort(ptr, search_range);
+  ptr    = put_ushort(ptr, entry_selector);
+  ptr    = put_ushort(ptr, (unsigned)(16 * num_tables) - search_range);
+  offset = 12 + 16 * num_tables;
+
+  for (i = 0; i < num_tables; i ++)
+  {
+    _ttf_table_data_t *table = tables + order[i];
+					// Current table
+
+    memcpy(data + offset, table->data, table->length);
+
+    if (table == head)
+      head_offset = offset;
+
+    ptr    = put_ulong(ptr, table->tag);
+    ptr    = put_ulong(ptr, get_checksum(data + offset, table->length));
+    ptr    = put_ulong(ptr, (unsigned)offset);
+    ptr    = put_ulong(ptr, (unsigned)table->length);
+    offset += (table->length + 3) & (size_t)~3;
+  }
+
+  // Update the head table's checkSumAdjustment...
+  checksum = 0xb1b0afba - get_checksum(data, length);
+
+  put_ulong(data + head_offset + 8, checksum);
+
+  *datalen = length;
+
+  return (data);
+}
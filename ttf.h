@@ -80,7 +80,9 @@ typedef struct ttf_rect_s	// Bounding rectangle
 // Functions...
 //
 
+extern unsigned char	*ttfCopySubset(ttf_t *font, size_t num_chars, const int *chars, size_t *datalen);
 extern ttf_t		*ttfCreate(const char *filename, size_t idx, ttf_err_cb_t err_cb, void *err_data);
+extern ttf_t		*ttfCreateData(const void *data, size_t datasize, size_t idx, ttf_err_cb_t err_cb, void *err_data);
 extern void		ttfDelete(ttf_t *font);
 extern int		ttfGetAscent(ttf_t *font);
 extern ttf_rect_t	*ttfGetBounds(ttf_t *font, ttf_rect_t *bounds);